@@ -0,0 +1,169 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures a source end to end, through the full osmosdr::source graph:
+ *
+ *   bench_osmosdr [args] [seconds]
+ *
+ * streams from the device given by args, mock=rtl by default, for seconds
+ * (10) and reports the sustained rate, the samples dropped as counted by the
+ * backend and the latency from the rx_time tags to the end of the graph.
+ * Only backends tagging rx_time with host time, like mock=, give a latency.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <boost/thread/thread.hpp>
+
+#include <gnuradio/top_block.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/io_signature.h>
+#include <gnuradio/high_res_timer.h>
+
+#include <osmosdr/source.h>
+
+class latency_probe;
+
+typedef boost::shared_ptr< latency_probe > latency_probe_sptr;
+
+/* counts the samples received and how long ago each rx_time stamp was */
+class latency_probe : public gr::sync_block
+{
+public:
+  static latency_probe_sptr make( size_t item_size )
+  {
+    return gnuradio::get_initial_sptr( new latency_probe( item_size ) );
+  }
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items )
+  {
+    std::vector< gr::tag_t > tags;
+
+    get_tags_in_range( tags, 0, nitems_read( 0 ), nitems_read( 0 ) + noutput_items,
+                       pmt::intern( "rx_time" ) );
+
+    const double now = double( gr::high_res_timer_now() ) / gr::high_res_timer_tps();
+
+    for ( size_t i = 0; i < tags.size(); i++ ) {
+      double stamp = pmt::to_uint64( pmt::tuple_ref( tags[i].value, 0 ) ) +
+                     pmt::to_double( pmt::tuple_ref( tags[i].value, 1 ) );
+
+      _latency.push_back( now - stamp );
+    }
+
+    _items += noutput_items;
+
+    return noutput_items;
+  }
+
+  uint64_t items() const { return _items; }
+
+  /* the latencies seen, in seconds, sorted */
+  std::vector< double > latency()
+  {
+    std::vector< double > latency = _latency;
+
+    std::sort( latency.begin(), latency.end() );
+
+    return latency;
+  }
+
+private:
+  latency_probe( size_t item_size )
+    : gr::sync_block( "latency_probe",
+                      gr::io_signature::make( 1, 1, item_size ),
+                      gr::io_signature::make( 0, 0, 0 ) ),
+      _items( 0 )
+  {
+  }
+
+  uint64_t _items;
+  std::vector< double > _latency;
+};
+
+static double now()
+{
+  return double( gr::high_res_timer_now() ) / gr::high_res_timer_tps();
+}
+
+int main( int argc, char **argv )
+{
+  const std::string args = argc > 1 ? argv[1] : "mock=rtl";
+  const double seconds = argc > 2 ? atof( argv[2] ) : 10.0;
+
+  gr::top_block_sptr tb = gr::make_top_block( "bench_osmosdr" );
+
+  osmosdr::source::sptr src = osmosdr::source::make( args );
+  latency_probe_sptr probe =
+    latency_probe::make( src->output_signature()->sizeof_stream_item( 0 ) );
+
+  tb->connect( src, 0, probe, 0 );
+
+  const double rate = src->get_sample_rate();
+
+  tb->start();
+
+  /* the first second includes the buffers filling up */
+  boost::this_thread::sleep( boost::posix_time::seconds( 1 ) );
+
+  const uint64_t dropped0 = src->get_stream_stats().dropped_samples;
+  const uint64_t items0 = probe->items();
+  const double start = now();
+
+  boost::this_thread::sleep( boost::posix_time::milliseconds( long( seconds * 1000 ) ) );
+
+  const uint64_t dropped = src->get_stream_stats().dropped_samples - dropped0;
+  const uint64_t items = probe->items() - items0;
+  const double elapsed = now() - start;
+
+  tb->stop();
+  tb->wait();
+
+  const double total = double( items + dropped );
+
+  printf( "rate     %10.3f Msps requested\n", rate / 1e6 );
+  printf( "received %10.3f Msps sustained\n", items / elapsed / 1e6 );
+  printf( "dropped  %10.4f %% (%llu samples)\n",
+          total > 0 ? dropped * 100.0 / total : 0.0, (unsigned long long) dropped );
+
+  std::vector< double > latency = probe->latency();
+
+  if ( latency.empty() ) {
+    printf( "latency  n/a, no rx_time tags with host time\n" );
+  } else {
+    printf( "latency  %10.3f ms median %10.3f ms p99 %10.3f ms max\n",
+            latency[latency.size() / 2] * 1e3,
+            latency[std::min( latency.size() - 1, latency.size() * 99 / 100 )] * 1e3,
+            latency.back() * 1e3 );
+  }
+
+  return 0;
+}
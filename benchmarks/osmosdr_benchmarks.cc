@@ -0,0 +1,325 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Microbenchmarks of the sample converters and fifos used by the backends,
+ * run without any hardware attached:
+ *
+ *   osmosdr_benchmarks [filter]
+ *
+ * runs the benchmarks whose name contains filter, the converters with each
+ * kernel the cpu supports. Results are given per complex sample and as the
+ * bytes read plus written per second.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/circular_buffer.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/thread/thread.h>
+
+#include "sample_convert.h"
+#include "sample_fifo.h"
+#include "transfer_ring.h"
+
+#define NSAMPLES     (64 * 1024)        /* per converter call, stays in L2 */
+#define MIN_SECONDS  0.2                /* per measurement */
+#define REPEAT       5                  /* measurements, the best one counts */
+#define FIFO_SAMPLES (64 * 1024 * 1024) /* passed through each fifo */
+#define CHUNK        16384              /* samples per fifo write and read */
+
+static std::string filter;
+
+static bool selected( const std::string &name )
+{
+  return filter.empty() || name.find( filter ) != std::string::npos;
+}
+
+static void report( const std::string &name, const std::string &variant,
+                    double seconds, double samples, size_t bytes_per_sample )
+{
+  printf( "%-24s %-14s %8.3f ns/sample %8.2f GB/s\n", name.c_str(), variant.c_str(),
+          seconds * 1e9 / samples, samples * bytes_per_sample / seconds / 1e9 );
+}
+
+static double now()
+{
+  return double( gr::high_res_timer_now() ) / gr::high_res_timer_tps();
+}
+
+/* \return the best time of a call to \p run, repeated for MIN_SECONDS */
+template < typename run_t >
+static double measure( const run_t &run )
+{
+  double best = 0;
+
+  run(); /* warm up the caches */
+
+  for (int i = 0; i < REPEAT; i++) {
+    size_t calls = 0;
+    double start = now(), elapsed = 0;
+
+    while ( elapsed < MIN_SECONDS ) {
+      run();
+      calls++;
+      elapsed = now() - start;
+    }
+
+    if ( 0 == i || elapsed / calls < best )
+      best = elapsed / calls;
+  }
+
+  return best;
+}
+
+template < typename conv_t, typename in_t, typename out_t >
+struct run_convert
+{
+  run_convert( const conv_t &conv, const in_t *in, out_t *out ) :
+    conv(conv), in(in), out(out) {}
+
+  void operator()() const { conv( in, out, NSAMPLES ); }
+
+  const conv_t &conv;
+  const in_t *in;
+  out_t *out;
+};
+
+struct run_planar
+{
+  run_planar( const convert_16bit_planar &conv, const int16_t *in, gr_complex *out ) :
+    conv(conv), in(in), out(out) {}
+
+  void operator()() const { conv( in, in + NSAMPLES, out, NSAMPLES ); }
+
+  const convert_16bit_planar &conv;
+  const int16_t *in;
+  gr_complex *out;
+};
+
+/* kernels measured already, OSMOSDR_SIMD levels the cpu lacks repeat them */
+static std::set< std::string > measured;
+
+template < typename conv_t, typename run_t >
+static void time_convert( const std::string &name, const conv_t &conv,
+                          const run_t &run, size_t bytes_per_sample )
+{
+  if ( ! selected( name ) || ! measured.insert( name + "/" + conv.name() ).second )
+    return;
+
+  report( name, conv.name(), measure( run ), NSAMPLES, bytes_per_sample );
+}
+
+template < typename conv_t, typename in_t, typename out_t >
+static void time_convert( const std::string &name, const conv_t &conv,
+                          const in_t *in, out_t *out, size_t bytes_per_sample )
+{
+  time_convert( name, conv, run_convert< conv_t, in_t, out_t >( conv, in, out ),
+                bytes_per_sample );
+}
+
+static void bench_converters()
+{
+  static const char *levels[] = { "generic", "sse2", "ssse3", "avx2", "avx512" };
+
+  /* large enough for NSAMPLES of any format, random to defeat any shortcuts */
+  const size_t size = NSAMPLES * 2 * sizeof(float);
+
+  unsigned char *in = (unsigned char *) convert_malloc( size );
+  gr_complex *out = (gr_complex *) convert_malloc( size );
+  gr_complex *floats = (gr_complex *) convert_malloc( size );
+
+  for (size_t i = 0; i < size; i++)
+    in[i] = rand();
+
+  for (size_t i = 0; i < NSAMPLES; i++)
+    floats[i] = gr_complex( rand() / float(RAND_MAX) - 0.5f, rand() / float(RAND_MAX) - 0.5f );
+
+  const int16_t *in16 = (const int16_t *) in;
+
+  for (size_t level = 0; level < sizeof(levels) / sizeof(levels[0]); level++) {
+#ifdef _WIN32
+    _putenv_s( "OSMOSDR_SIMD", levels[level] );
+#else
+    setenv( "OSMOSDR_SIMD", levels[level], 1 );
+#endif
+
+    /* the converters as set up by the backends */
+    convert_8bit rtl( false, 127.4f, 1.0f/128.0f );
+    convert_8bit hackrf( true, 0.0f, 1.0f/128.0f );
+    convert_16bit bladerf( 1.0f/2048.0f );
+    convert_16bit rfspace_16( 1.0f/32768.0f );
+    convert_24bit rfspace_24( 1.0f/8388608.0f );
+    convert_16bit_planar sdrplay( 1.0f/2048.0f );
+    convert_to_8bit hackrf_sink( 127.0f );
+    convert_to_16bit bladerf_sink( 2000.0f, 2047.0f );
+    correct_iq iq_correct;
+
+    iq_correct.set( gr_complex( 0.01f, -0.02f ), 0.05f, 1.02f );
+
+    time_convert( "rtl u8", rtl, in, out, 2 + 8 );
+    time_convert( "hackrf s8", hackrf, in, out, 2 + 8 );
+    time_convert( "bladerf sc16 q11", bladerf, in16, out, 4 + 8 );
+    time_convert( "rfspace sc16", rfspace_16, in16, out, 4 + 8 );
+    time_convert( "rfspace sc24", rfspace_24, in, out, 6 + 8 );
+    time_convert( "sdrplay planar sc16", sdrplay, run_planar( sdrplay, in16, out ), 4 + 8 );
+    time_convert( "hackrf_sink s8", hackrf_sink, floats, (int8_t *) out, 8 + 2 );
+    time_convert( "bladerf_sink sc16 q11", bladerf_sink, floats, (int16_t *) out, 8 + 4 );
+    time_convert( "iq_correct", iq_correct, floats, out, 8 + 8 );
+  }
+
+  convert_free( in );
+  convert_free( out );
+  convert_free( floats );
+}
+
+/*
+ * The fifos are timed passing FIFO_SAMPLES from a producer thread to a
+ * consumer in CHUNK sized pieces, as between a usb callback and work().
+ */
+
+static void fifo_producer( sample_fifo< gr_complex > *fifo )
+{
+  std::vector< gr_complex > buf( CHUNK );
+
+  for (size_t done = 0; done < FIFO_SAMPLES; done += CHUNK)
+    if ( fifo->wait_free( CHUNK ) )
+      fifo->write( &buf[0], CHUNK );
+}
+
+static void ring_producer( transfer_ring *ring )
+{
+  std::vector< gr_complex > buf( CHUNK );
+
+  for (size_t done = 0; done < FIFO_SAMPLES; done += CHUNK)
+    if ( ring->wait_free( 1 ) )
+      ring->push( &buf[0], CHUNK * sizeof(gr_complex) );
+}
+
+/* the mutex protected boost::circular_buffer the backends used before */
+struct locked_buffer
+{
+  locked_buffer( size_t capacity ) : buf( capacity ) {}
+
+  boost::mutex mutex;
+  boost::condition_variable cond;
+  boost::circular_buffer< gr_complex > buf;
+};
+
+static void locked_producer( locked_buffer *lb )
+{
+  std::vector< gr_complex > buf( CHUNK );
+
+  for (size_t done = 0; done < FIFO_SAMPLES; done += CHUNK) {
+    boost::mutex::scoped_lock lock( lb->mutex );
+
+    while ( lb->buf.capacity() - lb->buf.size() < CHUNK )
+      lb->cond.wait( lock );
+
+    lb->buf.insert( lb->buf.end(), buf.begin(), buf.end() );
+    lb->cond.notify_all();
+  }
+}
+
+static void bench_fifos()
+{
+  std::vector< gr_complex > buf( CHUNK );
+  const size_t bytes_per_sample = 2 * sizeof(gr_complex); /* written and read */
+
+  if ( selected( "fifo" ) || selected( "sample_fifo" ) ) {
+    sample_fifo< gr_complex > fifo( 64 * CHUNK );
+
+    double start = now();
+    gr::thread::thread producer( boost::bind( &fifo_producer, &fifo ) );
+
+    for (size_t done = 0; done < FIFO_SAMPLES; done += CHUNK)
+      if ( fifo.wait( CHUNK ) )
+        fifo.read( &buf[0], CHUNK );
+
+    producer.join();
+    report( "fifo", "sample_fifo", now() - start, FIFO_SAMPLES, bytes_per_sample );
+  }
+
+  if ( selected( "fifo" ) || selected( "transfer_ring" ) ) {
+    transfer_ring ring;
+    ring.alloc( 64, CHUNK * sizeof(gr_complex) );
+
+    double start = now();
+    gr::thread::thread producer( boost::bind( &ring_producer, &ring ) );
+
+    for (size_t done = 0; done < FIFO_SAMPLES; done += CHUNK) {
+      size_t len = 0;
+      if ( ! ring.wait( 1 ) )
+        break;
+
+      memcpy( &buf[0], ring.front( &len ), len );
+      ring.pop();
+    }
+
+    producer.join();
+    report( "fifo", "transfer_ring", now() - start, FIFO_SAMPLES, bytes_per_sample );
+  }
+
+  if ( selected( "fifo" ) || selected( "circular_buffer" ) ) {
+    locked_buffer lb( 64 * CHUNK );
+
+    double start = now();
+    gr::thread::thread producer( boost::bind( &locked_producer, &lb ) );
+
+    for (size_t done = 0; done < FIFO_SAMPLES; done += CHUNK) {
+      boost::mutex::scoped_lock lock( lb.mutex );
+
+      while ( lb.buf.size() < CHUNK )
+        lb.cond.wait( lock );
+
+      std::copy( lb.buf.begin(), lb.buf.begin() + CHUNK, buf.begin() );
+      lb.buf.erase_begin( CHUNK );
+      lb.cond.notify_all();
+    }
+
+    producer.join();
+    report( "fifo", "circular_buffer", now() - start, FIFO_SAMPLES, bytes_per_sample );
+  }
+}
+
+int main( int argc, char **argv )
+{
+  if ( argc > 1 )
+    filter = argv[1];
+
+  bench_converters();
+  bench_fifos();
+
+  return 0;
+}
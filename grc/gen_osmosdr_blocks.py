@@ -27,7 +27,11 @@ MAIN_TMPL = """\
   <throttle>1</throttle>
   <import>import osmosdr</import>
   <import>import time</import>
+#if $sourk == 'source':
+  <make>osmosdr.$(sourk)( args="numchan=" + str(\$nchan) + " cpu_format=\$type " + \$args )
+#else
   <make>osmosdr.$(sourk)( args="numchan=" + str(\$nchan) + " " + \$args )
+#end if
 #for $m in range($max_mboards)
 ########################################################################
 \#if \$num_mboards() > $m and \$clock_source$(m)()
@@ -86,6 +90,18 @@ self.\$(id).set_bandwidth(\$bw$(n), $n)
       <key>fc32</key>
       <opt>type:fc32</opt>
     </option>
+#if $sourk == 'source':
+    <option>
+      <name>Complex int16</name>
+      <key>sc16</key>
+      <opt>type:sc16</opt>
+    </option>
+    <option>
+      <name>Complex int8</name>
+      <key>sc8</key>
+      <opt>type:sc8</opt>
+    </option>
+#end if
   </param>
   <param>
     <name>Device Arguments</name>
@@ -233,7 +249,12 @@ While primarily being developed for the OsmoSDR hardware, this block as well sup
 By using the osmocom $sourk block you can take advantage of a common software api in your application(s) independent of the underlying radio hardware.
 
 Output Type:
-This parameter controls the data type of the stream in gnuradio. Only complex float32 samples are supported at the moment.
+This parameter controls the data type of the stream in gnuradio.
+#if $sourk == 'source':
+Complex int16 and int8 samples are delivered natively by RTL-SDR (int8), HackRF (int8), bladeRF (int16), NetSDR/SDR-IP/CloudIQ (int16) and USRP devices, all other devices are converted from complex float32.
+#else
+Only complex float32 samples are supported at the moment.
+#end if
 
 Device Arguments:
 The device argument is a comma delimited string used to locate devices on your system. Device arguments for multiple devices may be given by separating them with a space.
@@ -245,28 +266,117 @@ Optional arguments are placed into [] brackets, remove the brackets before using
 Lines ending with ... mean it's possible to bind devices together by specifying multiple device arguments separated with a space.
 
 #if $sourk == 'source':
-  fcd=0[,device=hw:2][,type=2]
-  miri=0[,buffers=32] ...
+  fcd=0[,device=hw:2][,type=2][,mmap=true][,period=4096][,periods=8]
+  miri=0[,buffers=32][,prefill=3] ...
   rtl=serial_number ...
   rtl=0[,rtl_xtal=28.8e6][,tuner_xtal=28.8e6] ...
   rtl=1[,buffers=32][,buflen=N*512] ...
-  rtl=2[,direct_samp=0|1|2][,offset_tune=0|1] ...
-  rtl_tcp=127.0.0.1:1234[,psize=16384][,direct_samp=0|1|2][,offset_tune=0|1] ...
-  osmosdr=0[,buffers=32][,buflen=N*512] ...
-  file='/path/to/your file',rate=1e6[,freq=100e6][,repeat=true][,throttle=true] ...
-  netsdr=127.0.0.1[:50000][,nchan=2]
-  sdr-ip=127.0.0.1[:50000]
-  cloudiq=127.0.0.1[:50000]
-  sdr-iq=/dev/ttyUSB0
-  airspy=0[,bias=0|1][,linearity][,sensitivity]
+  rtl=0[,decim=10] ...
+  rtl=2[,direct_samp=0|1|2][,direct_real=true][,offset_tune=0|1] ...
+  rtl_tcp=127.0.0.1:1234[,psize=16384][,prebuffer=0][,bits=8][,direct_samp=0|1|2][,offset_tune=0|1][,reconnect=true] ...
+  osmosdr=0[,buffers=32][,buflen=N*512][,decim=N] ...
+  file='/path/to/your file',rate=1e6[,freq=100e6][,repeat=true][,throttle=true][,mmap=false][,format=fc32][,start_time=2026-10-14T08:30:00Z][,speed=4.0] ...
+  netsdr=127.0.0.1[:50000][,nchan=2][,bits=24][,buffers=1024][,rcvbuf=bytes]
+  sdr-ip=127.0.0.1[:50000][,bits=24][,buffers=1024][,rcvbuf=bytes]
+  cloudiq=127.0.0.1[:50000][,bits=24][,buffers=1024][,rcvbuf=bytes]
+  sdr-iq=/dev/ttyUSB0[,min_chunk=<samples>]
+  airspy=0[,bias=0|1][,linearity][,sensitivity][,sample_type=float32_iq|int16_iq|float32_real|int16_real][,min_chunk=<samples>]
+  soapy=0[,driver=...][,dma=true][,convert_threads=N]
+  mock=rtl|hackrf|bladerf[,buffers=15][,buflen=N*512]
+  shm=name
 #end if
 #if $sourk == 'sink':
-  file='/path/to/your file',rate=1e6[,freq=100e6][,append=true][,throttle=true] ...
+  file='/path/to/your file',rate=1e6[,freq=100e6][,append=true][,throttle=true][,format=fc32|sc16|sc8][,direct=false][,rotate=1GB|10min][,sigmf=true] ...
+  tcp_server=[0.0.0.0:]1234[,control=false][,tuner=r820t][,ring_size=16777216][,rate=2.4e6][,freq=100e6]
+  shm=name[,control=false][,ring_size=4194304][,rate=2.4e6][,freq=100e6]
+#end if
+  redpitaya=192.168.1.100[:1001][,rcvbuf=bytes][,sndbuf=bytes][,nodelay=0|1][,busy_poll=us]
+  hackrf=0[,buffers=32][,bias=0|1][,bias_tx=0|1][,decim=N]
+  bladerf=0[,tamer=internal|external|external_1pps][,smb=25e6][,reconnect=true][,buffers=auto][,buffer_ms=30]
+  uhd[,serial=...][,lo_offset=0][,mcr=52e6][,nchan=2][,subdev='\\\\'B:0 A:0\\\\''][,streamer=gr-uhd|native][,otw_format=sc16|sc8][,spp=N] ...
+
+A shm sink publishes its samples in shared memory, for any number of shm sources with the same name in other processes on the machine, so one radio can feed several flowgraphs. The samples are copied only once per subscriber. A subscriber too slow to keep up skips ahead and counts the skipped samples as overflows. The rate, frequency and timestamps of the publisher are tagged on the subscriber's stream. A second sink with the name of a running one fails to start, a segment left behind by a crashed publisher is replaced. With control=true on the sink, the settings made on the sources are published on the sink's command message port, ready to be connected to the command port of the receiver.
+#if $sourk == 'sink':
+
+tcp_server serves the samples in the rtl_tcp format to any number of clients, e.g. rtl_tcp=host:1234 sources. Clients too slow to keep up skip ahead instead of holding back the others. With control=true the tuning commands of the longest connected client are published on the command message port, ready to be connected to the command port of the receiver. Clients asking for fewer bits per value, like rtl_tcp sources with bits=4, are sent packed frames instead of 8 bit samples. Each frame is amplified by the largest power of two its peak allows before it is requantized, so weak signals keep their resolution, but the quieter samples of a frame with a strong peak are still reduced to the coarse steps.
+#end if
+#if $sourk == 'source':
+
+Multiple receivers sharing a PPS (and optionally a 10 MHz reference) may be aligned in time by adding sync=pps (or sync=external to lock to the reference as well). The device clocks are then reset on a common PPS edge and the samples of every channel preceding a common start time are dropped, so all channels start with the same timestamp. This requires devices tagging their samples with rx_time, e.g.:
+  sync=pps uhd,serial=A uhd,serial=B
+
+Narrowband channels may be extracted from the first device channel by adding channels=offset:bandwidth[;offset:bandwidth...], offsets being relative to the center frequency. Each channel is delivered on an additional output following the device channels, decimated to at least 1.25 times its bandwidth, e.g.:
+  channels=-250e3:25e3;400e3:200e3 rtl=0
+The wideband samples are read only once for all channels, which is considerably cheaper than a Frequency Xlating FIR Filter per channel. Requires the complex float32 output type.
+
+Adding fft_size=N publishes averaged power spectra of the first device channel on the spectrum message port, for monitoring without an FFT chain of its own. Only one frame every 1/fft_rate seconds (default 30) is transformed, so it costs a small fraction of a full rate FFT, and the bin powers are averaged with weight fft_alpha (default 0.1) for each new frame, e.g.:
+  fft_size=1024,fft_rate=15 rtl=0
+Each message is a pair of a dict with freq and rate and a vector of fft_size powers in dB, DC in the middle. Requires the complex float32 output type. With stitch=true the spectra of all channels, tuned to adjacent frequencies at the same rate, are merged into one spanning them all, each bin taken from the channel tuned closest to it.
+
+Receivers sharing one reference clock, like rtl dongles wired to a common crystal, are aligned in delay and phase with coherent=true, e.g. for direction finding:
+  coherent=true rtl=0 rtl=1 rtl=2 rtl=3
+All channels have to see a common signal while they are calibrated, a noise source or a strong reference, which is cross correlated with channel 0 over coherent_cal samples (default 65536). Integer delays are removed by dropping samples, fractional ones by interpolation. The calibration is repeated after each retune, as the tuner phases change, and every coherent_interval seconds if given. Requires the complex float32 output type.
+
+The rtl, hackrf, osmosdr and miri sources tag the first sample they receive after each retune with rx_freq, counted at the device, so samples still queued from the old frequency aren't marked. Add retune_settle=<seconds> to the device arguments to delay the tag further, past the settling of the tuner. Other devices are tagged downstream with retune_tags=true, which can't tell the samples buffered by the driver while retuning apart and copies the whole stream, retune_settle=<seconds> has to cover them. Calling set_center_freq_async() instead of set_center_freq() retunes from a control thread of the device without blocking the caller.
+
+With fine_tune=true small frequency changes are made by a software NCO alone, phase continuous and without retuning the hardware, e.g. for Doppler tracking or AFC. The hardware is only retuned for frequencies more than fine_tune_window Hz (default a tenth of the sample rate) off where it is tuned, the NCO then makes up for the resolution of the synthesizer. A change of the NCO is tagged with rx_freq. Requires the complex float32 output type.
+
+Channels idle most of the time are gated with gate_threshold=<dBFS>, passing only the bursts exceeding the threshold instead of the continuous stream, which saves the decoders downstream from processing noise, e.g.:
+  gate_threshold=-45,gate_hold=8192 channels=-250e3:25e3 rtl=0
+A burst begins with the gate_pre samples (default 1024) preceding the sample which opened the gate and ends after gate_hold samples (default 4096) below the threshold. Its first sample is tagged with burst_start and its last one with burst_end, both carrying the offset of the sample in the ungated stream, and rx_time is extrapolated onto the first sample. Every output is gated, including the channels= ones. Requires the complex float32 output type.
+
+set_streaming(False) pauses the rtl, airspy and bladeRF devices without stopping the flowgraph, e.g. to capture one second out of ten, saving USB bandwidth and CPU. Nothing is transferred or produced meanwhile. After set_streaming(True) the first sample is tagged with rx_time, rx_rate and rx_freq, marking the discontinuity.
+
+set_hop_plan(freqs, dwell) makes the device hop over freqs by itself, staying dwell seconds on each, with sample exact hop boundaries each tagged with rx_freq. Only the bladeRF supports it, with enable_metadata=true in its device arguments, other devices return False.
+
+A HackRF sweeps a band in firmware, at thousands of hops per second, with sweep=start:stop:step (in Hz, rounded outwards to whole MHz) in its device arguments. Each hop lasts sweep_dwell blocks of 8192 samples (default 1) and its first sample is tagged with rx_freq, the center of the hop, and sweep_hop, its index. Adding sweep_fft=N publishes the power spectrum of the last N samples of each block, averaged over the hop, on the spectrum message port, the dict holding freq, rate, hop and sweep, e.g.:
+  hackrf=0,sweep=2400e6:2500e6:10e6,sweep_fft=1024
+Keep the step below the sample rate, set_center_freq() has no effect while sweeping.
+#end if
+#if $sourk == 'sink':
+
+Bursts are delimited by tx_sob and tx_eob stream tags, as with the gr-uhd usrp_sink. The HackRF, bladeRF (with enable_metadata=true), UHD and SoapySDR sinks send the end of a burst right away, padded with zeros, instead of holding it back until more samples arrive. A tx_time tag on the first sample schedules the burst on the device time base, which the bladeRF, UHD and SoapySDR sinks support, the HackRF transmits those bursts immediately.
+
+When the flowgraph falls behind a continuous transmission, the HackRF, bladeRF (without enable_metadata) and SoapySDR sinks send zeros by default. Add underrun=repeat to the device arguments to send the last buffer again, or underrun=stall to let the device run dry. preroll=N queues N samples before transmitting starts, and again after each underrun or burst. Underruns are counted by get_stream_stats().
+#end if
+
+With buffers=auto the bladeRF sizes its sync buffers for the sample rate, each filling in about 5 ms, so that together they hold buffer_ms (default 30, implies buffers=auto) of samples. More than three overruns or timeouts within ten seconds double the buffered time, up to one second, and restart the stream with the new buffers. The configuration in use is published with the stream statistics, as num_buffers, samples_per_buffer and num_transfers, and its capacity is reported as fill_capacity.
+
+The file sink continues in a new numbered file once rotate=<size> (e.g. 500MB, 2GiB) or rotate=<duration> (e.g. 30s, 10min, 1h) is reached, capture.sigmf-data becomes capture_0000.sigmf-data, capture_0001.sigmf-data and so on. The next file is opened in advance, so rotating doesn't hold up the stream. Each file gets a SigMF .sigmf-meta file (sigmf=true, the default for rotated, integer and .sigmf-data recordings), whose captures list the rx_freq and rx_time tags of the stream. A file source given start_time= (UTC, or seconds since the epoch) looks up the sample taken at that time in those captures and starts there.
+#if $sourk == 'source':
+
+An rtl_tcp source or bladeRF source given reconnect=true survives the server restarting or the device dropping off the bus. The connection (or the device, by its serial number) is opened again within about 100 ms of coming back, the last tuning and gain settings are restored, and the first sample afterwards is tagged with rx_rate and rx_freq (rx_time too on a bladeRF with enable_metadata=true), while the flowgraph keeps running. The Red Pitaya always reconnects.
+
+With mmap=true the file source paces the samples itself instead of through a throttle block, speed=N replays at N times the sample rate (and implies mmap=true), e.g. speed=10 for a quick look at a long recording. The rx_time, rx_rate and rx_freq tags recorded in the captures are tagged again, at the start, after seeking and whenever a new segment begins. Gaps between the recorded times, left by overflows, are replayed as pauses, scaled by the speed.
+
+With mmap=true the FUNcube Dongle source captures from ALSA in mmap mode and converts the samples straight into the output buffer, instead of through the audio source of gr-fcd. period=N (frames, 4096 by default) and periods=N (8 by default) size the ALSA buffer and imply mmap=true. Overruns are counted in the stream statistics instead of being printed as aO.
+#end if
+
+#if $sourk == 'source':
+The decim argument of the RTL-SDR, HackRF and OsmoSDR sources low pass filters and decimates the samples right after their conversion, the sample rate then refers to the decimated rate (e.g. rtl=0,decim=10 at a 240e3 sample rate runs the device at 2.4e6).
+
+With direct_samp=1 or 2, direct_real=true converts only the ADC branch in use and turns its real samples into complex ones at half the rate, covering 0 Hz up to the device rate / 2. The device runs at twice the sample rate set and the center frequency is fixed at a quarter of the device rate (e.g. rtl=0,direct_samp=2,direct_real=true at a 1.2e6 sample rate receives 0 to 1.2 MHz centered at 600 kHz).
+
+With several devices, parallel_ctrl=true configures them concurrently from a thread per device, so their settling times overlap. set_params("rate=2e6,freq=100e6,gain1=20") applies several settings at once, freq, gain, if_gain, bb_gain, bandwidth and antenna to all channels or, followed by a channel index, to that channel only.
+
+With streamer=native the UHD devices are streamed from directly through the UHD rx_streamer and tx_streamer instead of the gr-uhd blocks, in the cpu_format and otw_format given. The transport is tuned by the usual UHD device arguments, e.g. recv_frame_size=8000,num_recv_frames=512 (send_frame_size and num_send_frames when transmitting). The samples are tagged with rx_time, rx_rate and rx_freq at start, after overflows and after retuning, and the sink honors the tx_sob, tx_eob and tx_time tags.
+
+The RTL-SDR, HackRF and Mirics sources accept latency=low|balanced|throughput, globally or per device. throughput (the default) keeps the large usb buffers. balanced and low deliver samples as soon as 2 or 1 buffers arrived, and the RTL-SDR additionally sizes its buffers to fill within about 5 or 1 ms at the sample rate set when the flowgraph starts. Explicit buffers or buflen arguments take precedence.
+
+#end if
+The usb buffers of the RTL-SDR, HackRF, OsmoSDR and Mirics devices are allocated from a single region backed by huge pages where possible, hugepages=false turns that off. Add mlock=true to lock them into memory and numa_node=N to place them on the NUMA node of the cores processing the samples, e.g. hackrf=0,numa_node=1.
+#if $sourk == 'source':
+
+The threads reading the RTL-SDR, HackRF, Airspy, OsmoSDR, Mirics and RFspace devices may be pinned to cpus with rx_thread_cpu=N[;M...] and run SCHED_FIFO with rx_thread_prio=1..99 (which requires CAP_SYS_NICE or an rtprio limit), e.g. rtl=0,rx_thread_cpu=3,rx_thread_prio=50.
+
+At rates a single core can't convert to complex float32, the bladeRF and SoapySDR (with dma=true) sources convert with convert_threads=N threads, the block's own included. The samples of each call are split into chunks small enough to stay in the cache and converted in parallel, straight into their place in the output, e.g. bladerf=0,convert_threads=3 at 61.44 Msps.
+#end if
+
+The getters return the values the device reported when they were last set or read, so polling them, e.g. from a GUI, doesn't cost a device call each time. The same goes for the sample rate, frequency, gain and bandwidth ranges. Add param_cache=false to the device arguments to read the hardware on every call. The gains aren't cached while the automatic gain mode is on.
+#if $sourk == 'source':
+
+With cache_dir=<path> the ranges and the software DC and IQ correction estimates of the rtl, hackrf and bladeRF devices are kept across runs, in a file per device named after its serial number and firmware, e.g. cache_dir=/var/cache/osmosdr rtl=0. Opening the device again then doesn't wait for the ranges to be read, and the corrections start from the last estimates instead of converging from scratch. Remove the file after changing the hardware in a way its id doesn't tell.
 #end if
-  redpitaya=192.168.1.100[:1001]
-  hackrf=0[,buffers=32][,bias=0|1][,bias_tx=0|1]
-  bladerf=0[,tamer=internal|external|external_1pps][,smb=25e6]
-  uhd[,serial=...][,lo_offset=0][,mcr=52e6][,nchan=2][,subdev='\\\\'B:0 A:0\\\\''] ...
 
 Num Channels:
 Selects the total number of channels in this multi-device configuration. Required when specifying multiple device arguments.
@@ -287,7 +397,7 @@ Controls the behavior of hardware DC offset corrrection.
   Manual: Keep last estimated correction when switched from Automatic to Manual.
   Automatic: Periodicallly find the best solution to compensate for DC offset.
 
-This functionality is available for USRP devices only.
+The correction is done by the USRP, bladeRF, SDRplay and SoapySDR hardware, for all other devices in software.
 
 IQ Balance Mode:
 Controls the behavior of software IQ imbalance corrrection.
@@ -295,7 +405,8 @@ Controls the behavior of software IQ imbalance corrrection.
   Manual: Keep last estimated correction when switched from Automatic to Manual.
   Automatic: Periodicallly find the best solution to compensate for image signals.
 
-This functionality depends on http://cgit.osmocom.org/cgit/gr-iqbal/
+The correction is done by the USRP and bladeRF hardware or, if available, by http://cgit.osmocom.org/cgit/gr-iqbal/ for these. All other devices are corrected by a built-in estimator.
+The gr-iqbal optimizer only sees bursts making up 10 % of the samples, add iq_estimator_duty=0.0..1.0 to the device arguments to change that.
 
 Gain Mode:
 Chooses between the manual (default) and automatic gain mode where appropriate.
@@ -0,0 +1,63 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OSMOSDR_CHANNEL_STATE_H
+#define INCLUDED_OSMOSDR_CHANNEL_STATE_H
+
+#include <osmosdr/api.h>
+#include <map>
+#include <string>
+
+namespace osmosdr{
+
+    /*!
+     * The settings of a single channel, as returned by get_channel_state()
+     * of source and sink, which saves a call (and from Python a crossing of
+     * the bindings) per setting.
+     */
+    struct channel_state_t{
+
+        double sample_rate;
+        double center_freq;
+        double freq_corr;
+
+        //! Automatic gain control enabled
+        bool gain_mode;
+
+        //! Overall gain in dB
+        double gain;
+
+        //! Gain in dB of each of the stages named by get_gain_names()
+        std::map<std::string, double> gains;
+
+        std::string antenna;
+        double bandwidth;
+
+        channel_state_t(void):
+            sample_rate(0), center_freq(0), freq_corr(0),
+            gain_mode(false), gain(0), bandwidth(0)
+        {
+            /* nothing */
+        }
+    };
+
+} //namespace osmosdr
+
+#endif /* INCLUDED_OSMOSDR_CHANNEL_STATE_H */
@@ -88,6 +88,15 @@ namespace osmosdr {
   //! A typedef for a vector of logical devices
   typedef std::vector<device_t> devices_t;
 
+  /*!
+   * Split the arguments of a source or sink into its logical devices,
+   * parsing each of them once. Arguments applying to the source or sink
+   * as a whole, like "numchan=2" or "cpu_format=sc16", are left out.
+   * \param args the arguments string, e.g. "numchan=2 rtl=0 rtl=1"
+   * \return a logical device per device argument
+   */
+  OSMOSDR_API devices_t parse_devices(const std::string &args);
+
   /*!
    * The device interface represents the underyling hardware.
    * The api allows for discovery, configuration, and streaming.
@@ -104,6 +113,10 @@ namespace osmosdr {
      * The device hint "nofake" switches off dummy devices created
      * by "file" (and other) implementations.
      *
+     * The device hints "hardware", "network" and "file" restrict the
+     * search to backends of that kind, "tx" searches for sink devices
+     * instead of source devices.
+     *
      * \param hint a partially (or fully) filled in logical device
      * \return a vector of logical devices for all radios on the system
      */
@@ -23,6 +23,8 @@
 #include <osmosdr/api.h>
 #include <osmosdr/ranges.h>
 #include <osmosdr/time_spec.h>
+#include <osmosdr/stream_stats.h>
+#include <osmosdr/channel_state.h>
 #include <gnuradio/hier_block2.h>
 
 namespace osmosdr {
@@ -94,6 +96,20 @@ public:
    */
   virtual double set_center_freq( double freq, size_t chan = 0 ) = 0;
 
+  /*!
+   * Hop over \p freqs in a loop, staying \p dwell seconds on each.
+   * The retunes are sequenced by the device against its sample counter, so
+   * the hop boundaries are sample exact. An empty plan stops hopping, so
+   * does the next set_center_freq(). Devices which can't hop by themselves
+   * return false and stay where they are.
+   * \param freqs the frequencies in Hz
+   * \param dwell seconds per hop
+   * \param chan the channel index 0 to N-1
+   * \return true if the device hops
+   */
+  virtual bool set_hop_plan( const std::vector< double > &freqs, double dwell,
+                             size_t chan = 0 ) = 0;
+
   /*!
    * Get the center frequency the underlying radio hardware is tuned to.
    * This is the actual frequency and may differ from the frequency set.
@@ -371,6 +387,25 @@ public:
    * \param time_spec the new time
    */
   virtual void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec) = 0;
+
+  /*!
+   * Get the streaming statistics (dropped samples, underflow events, buffer fill
+   * high-water mark and latency histogram) collected by the device driver.
+   * The same statistics are published on the "stats" message port whenever
+   * new underflows have been seen, at most once per second.
+   * \param chan the channel index 0 to N-1
+   * \return the statistics, all zero if not supported by the device
+   */
+  virtual ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 ) = 0;
+
+  /*!
+   * Get all settings of a channel at once: sample rate, center frequency,
+   * frequency correction, gain mode, overall and per stage gains, antenna
+   * and bandwidth.
+   * \param chan the channel index 0 to N-1
+   * \return the settings, as the individual getters would return them
+   */
+  virtual ::osmosdr::channel_state_t get_channel_state( size_t chan = 0 ) = 0;
 };
 
 } /* namespace osmosdr */
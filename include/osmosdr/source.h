@@ -23,6 +23,8 @@
 #include <osmosdr/api.h>
 #include <osmosdr/ranges.h>
 #include <osmosdr/time_spec.h>
+#include <osmosdr/stream_stats.h>
+#include <osmosdr/channel_state.h>
 #include <gnuradio/hier_block2.h>
 
 namespace osmosdr {
@@ -103,6 +105,35 @@ public:
    */
   virtual double set_center_freq( double freq, size_t chan = 0 ) = 0;
 
+  /*!
+   * Queue a retune of the underlying radio hardware and return immediately.
+   * The retune is done by a control thread of the device, requests queued
+   * for the same channel while the device is busy are coalesced into the
+   * latest one. The first sample received after the retune (and the
+   * settling time given with retune_settle=<seconds> in the device
+   * arguments) is tagged with rx_freq, carrying the actual frequency in Hz,
+   * by the rtl, hackrf, osmosdr and miri sources, and with retune_tags=true
+   * by any other.
+   * \param freq the desired frequency in Hz
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void set_center_freq_async( double freq, size_t chan = 0 ) = 0;
+
+  /*!
+   * Hop over \p freqs in a loop, staying \p dwell seconds on each.
+   * The retunes are sequenced by the device against its sample counter, so
+   * the hop boundaries are sample exact, and the first sample of each hop
+   * is tagged with rx_freq. An empty plan stops hopping, so does the next
+   * set_center_freq(). Devices which can't hop by themselves return false
+   * and stay where they are, set_center_freq_async() is the way to hop them.
+   * \param freqs the frequencies in Hz
+   * \param dwell seconds per hop
+   * \param chan the channel index 0 to N-1
+   * \return true if the device hops
+   */
+  virtual bool set_hop_plan( const std::vector< double > &freqs, double dwell,
+                             size_t chan = 0 ) = 0;
+
   /*!
    * Get the center frequency the underlying radio hardware is tuned to.
    * This is the actual frequency and may differ from the frequency set.
@@ -429,6 +460,49 @@ public:
    * \param chan the channel.
    */
   virtual void set_notch_AMFM_filter( bool enable, size_t chan = 0 ) = 0;
+
+  /*!
+   * Get the streaming statistics (dropped samples, overflow events, buffer fill
+   * high-water mark and latency histogram) collected by the device driver.
+   * The same statistics are published on the "stats" message port whenever
+   * new overflows have been seen, at most once per second.
+   * \param chan the channel index 0 to N-1
+   * \return the statistics, all zero if not supported by the device
+   */
+  virtual ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 ) = 0;
+
+  /*!
+   * Get all settings of a channel at once: sample rate, center frequency,
+   * frequency correction, gain mode, overall and per stage gains, antenna
+   * and bandwidth.
+   * \param chan the channel index 0 to N-1
+   * \return the settings, as the individual getters would return them
+   */
+  virtual ::osmosdr::channel_state_t get_channel_state( size_t chan = 0 ) = 0;
+
+  /*!
+   * Pause or resume streaming of all devices, e.g. for duty cycled
+   * captures, without stopping the flowgraph. A paused device doesn't
+   * transfer any samples, and the source produces none. The first sample
+   * after resuming is tagged with rx_time (on the time base of
+   * get_time_now()), rx_rate and rx_freq, so downstream blocks may reset
+   * their state. Supported by rtl, airspy and bladeRF sources, the latter
+   * tagging rx_time only with enable_metadata=true.
+   * \param streaming false to pause, true to resume
+   * \return false if any of the devices can't be paused
+   */
+  virtual bool set_streaming( bool streaming ) = 0;
+
+  /*!
+   * Apply several settings at once, e.g. "rate=2e6,freq=100e6,gain1=20".
+   * The keys rate, freq, gain, if_gain, bb_gain, bandwidth and antenna
+   * apply to all channels, followed by a channel index (as in freq1) to
+   * that channel only. The sample rate is set first. Each device gets all
+   * its settings in one go, with parallel_ctrl=true in the device arguments
+   * the devices are configured concurrently.
+   * \param params comma separated key=value pairs
+   */
+  virtual void set_params( const std::string &params ) = 0;
 };
 
 } /* namespace osmosdr */
@@ -0,0 +1,67 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OSMOSDR_STREAM_STATS_H
+#define INCLUDED_OSMOSDR_STREAM_STATS_H
+
+#include <osmosdr/api.h>
+#include <stdint.h>
+#include <vector>
+
+namespace osmosdr{
+
+    /*!
+     * Streaming statistics of a single channel as collected by the device
+     * driver since the block has been created.
+     *
+     * Devices which don't collect statistics report all counters as zero.
+     */
+    struct stream_stats_t{
+
+        //! Samples dropped by overflows (source) or missing due to underflows (sink)
+        uint64_t dropped_samples;
+
+        //! Number of overflow (source) or underflow (sink) events
+        uint64_t overflows;
+
+        //! Highest fill level of the driver buffer seen, in samples, 0 if the driver doesn't tell
+        uint64_t fill_high_water;
+
+        //! Capacity of the driver buffer, in samples
+        uint64_t fill_capacity;
+
+        /*!
+         * Histogram of the latency from the driver callback to work().
+         * Bin 0 counts latencies below 1 us, bin n counts latencies
+         * from 2^(n-1) us up to 2^n us, the last bin counts everything above.
+         */
+        std::vector<uint64_t> latency_histogram;
+
+        stream_stats_t(void):
+            dropped_samples(0), overflows(0),
+            fill_high_water(0), fill_capacity(0)
+        {
+            /* nothing */
+        }
+    };
+
+} //namespace osmosdr
+
+#endif /* INCLUDED_OSMOSDR_STREAM_STATS_H */
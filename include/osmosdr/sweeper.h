@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_SWEEPER_H
+#define INCLUDED_OSMOSDR_SWEEPER_H
+
+#include <vector>
+
+#include <osmosdr/api.h>
+#include <osmosdr/source.h>
+#include <gnuradio/block.h>
+
+namespace osmosdr {
+
+/*!
+ * \brief Sweeps a source over a frequency plan and measures the spectrum
+ * at each hop.
+ * \ingroup block
+ *
+ * Connected to output \p chan of the source it retunes, the sweeper posts
+ * the retune to the next hop through set_center_freq_async() and drops the
+ * samples until the rx_freq tag of that retune arrives, followed by \p settle
+ * seconds more. It then averages the power of \p averages Blackman-Harris
+ * windowed FFTs and moves on, so no samples of the previous frequency or of
+ * the tuner settling are measured and the graph never stalls on a device
+ * call.
+ *
+ * Each hop produces one spectrum frame, a vector of fft_size floats holding
+ * the power per bin in dB relative to full scale, DC in the middle. The frame
+ * is tagged with rx_freq (the actual center frequency) and sweep_hop (the
+ * index into the plan). The same is also published on the spectrum message
+ * port as a PDU, the metadata dict holding freq, hop and sweep (the number of
+ * completed sweeps).
+ */
+class OSMOSDR_API sweeper : virtual public gr::block
+{
+public:
+  typedef boost::shared_ptr< sweeper > sptr;
+
+  /*!
+   * \param src the source to retune, its output \p chan connected to ours
+   * \param freqs center frequencies of the hops in Hz
+   * \param fft_size bins per frame
+   * \param averages FFTs averaged per hop
+   * \param settle seconds to drop after the rx_freq tag, on top of the
+   *        retune_settle given to the source
+   * \param chan the channel of the source
+   */
+  static sptr make( source::sptr src,
+                    const std::vector< double > &freqs,
+                    size_t fft_size = 1024,
+                    size_t averages = 16,
+                    double settle = 0.0,
+                    size_t chan = 0 );
+
+  /*!
+   * Center frequencies from \p start to \p stop (inclusive) every \p step Hz,
+   * \p step typically a fraction of the sample rate so the band edges of
+   * each hop can be dropped.
+   */
+  static std::vector< double > linear_plan( double start, double stop, double step );
+
+  /*! Replace the plan, taking effect with the next hop. */
+  virtual void set_plan( const std::vector< double > &freqs ) = 0;
+  virtual std::vector< double > plan() = 0;
+
+  /*! \return hops completed per second, averaged over the last sweep */
+  virtual double hop_rate() = 0;
+
+  /*! \return the number of sweeps completed since start */
+  virtual uint64_t sweeps() = 0;
+};
+
+} /* namespace osmosdr */
+
+#endif /* INCLUDED_OSMOSDR_SWEEPER_H */
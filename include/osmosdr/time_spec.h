@@ -136,6 +136,103 @@ namespace osmosdr{
         return this->_frac_secs;
     }
 
+    /*!
+     * A tick_spec_t holds whole seconds and a tick count within the second,
+     * at an integer number of ticks per second, typically the sample rate.
+     *
+     * Unlike the fractional seconds of time_spec_t, adding or subtracting
+     * ticks is exact, so sample offsets derived from timestamps don't pick
+     * up rounding errors over long captures. Use it for arithmetic on
+     * hardware sample counters and convert to time_spec_t at the edges.
+     */
+    class OSMOSDR_API tick_spec_t : boost::totally_ordered<tick_spec_t>{
+    public:
+
+        /*!
+         * Create a tick_spec_t from whole seconds and ticks.
+         * The ticks may exceed a second or be negative, they are carried
+         * into the seconds.
+         * \param full_secs the whole/integer seconds count
+         * \param ticks the ticks on top of the seconds
+         * \param tick_rate the number of ticks per second, at least 1
+         */
+        tick_spec_t(time_t full_secs = 0, long long ticks = 0, long long tick_rate = 1);
+
+        /*!
+         * Create a tick_spec_t from a time_spec_t, rounding to the nearest tick.
+         * \param time the time to convert
+         * \param tick_rate the number of ticks per second, at least 1
+         */
+        tick_spec_t(const time_spec_t &time, long long tick_rate);
+
+        /*!
+         * Create a tick_spec_t from a 64-bit tick count, e.g. a hardware
+         * sample counter.
+         * \param ticks an integer count of ticks
+         * \param tick_rate the number of ticks per second, at least 1
+         */
+        static tick_spec_t from_ticks(long long ticks, long long tick_rate);
+
+        //! Get the whole/integer part of the time in seconds.
+        time_t get_full_secs(void) const;
+
+        //! Get the ticks within the second, 0 to tick rate - 1.
+        long long get_ticks(void) const;
+
+        //! Get the number of ticks per second.
+        long long get_tick_rate(void) const;
+
+        //! Convert into a 64-bit tick count.
+        long long to_ticks(void) const;
+
+        //! Get the fractional part of the time in seconds.
+        double get_frac_secs(void) const;
+
+        //! Convert into a time_spec_t, as rounded to the nearest double.
+        time_spec_t to_time_spec(void) const;
+
+        //! Advance by ticks, exactly.
+        tick_spec_t &operator+=(long long ticks);
+
+        //! Go back by ticks, exactly.
+        tick_spec_t &operator-=(long long ticks);
+
+        /*!
+         * The ticks from rhs to this time, rhs is converted to this tick
+         * rate first if it differs.
+         */
+        long long ticks_since(const tick_spec_t &rhs) const;
+
+    //private time storage details
+    private: time_t _full_secs; long long _ticks; long long _tick_rate;
+    };
+
+    inline tick_spec_t operator+(tick_spec_t lhs, long long ticks){
+        return lhs += ticks;
+    }
+
+    inline tick_spec_t operator-(tick_spec_t lhs, long long ticks){
+        return lhs -= ticks;
+    }
+
+    //! Implement equality_comparable interface, across tick rates
+    OSMOSDR_API bool operator==(const tick_spec_t &, const tick_spec_t &);
+
+    //! Implement less_than_comparable interface, across tick rates
+    OSMOSDR_API bool operator<(const tick_spec_t &, const tick_spec_t &);
+
+    inline time_t tick_spec_t::get_full_secs(void) const{
+        return this->_full_secs;
+    }
+
+    inline long long tick_spec_t::get_ticks(void) const{
+        return this->_ticks;
+    }
+
+    inline long long tick_spec_t::get_tick_rate(void) const{
+        return this->_tick_rate;
+    }
+
 } //namespace osmosdr
 
 #endif /* INCLUDED_OSMOSDR_TIME_SPEC_H */
@@ -35,13 +35,17 @@
 #include <boost/format.hpp>
 #include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
 #include <boost/thread/thread.hpp>
 
 #include <gnuradio/io_signature.h>
 
 #include "airspy_source_c.h"
+#include "backend_registry.h"
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
+#include "trace.h"
 
 using namespace boost::assign;
 
@@ -50,6 +54,8 @@ using namespace boost::assign;
   throw std::runtime_error( boost::str( boost::format(msg " (%d) %s") \
       % ret % airspy_error_name((enum airspy_error)ret) ) );
 
+#define WAIT_TIMEOUT 100 /* ms work() waits for samples at a time */
+
 #define AIRSPY_FUNC_STR(func, arg) \
   boost::str(boost::format(func "(%d)") % arg) + " has failed"
 
@@ -58,6 +64,12 @@ airspy_source_c_sptr make_airspy_source_c (const std::string & args)
   return gnuradio::get_initial_sptr(new airspy_source_c (args));
 }
 
+static source_registrar airspy_registrar(
+  "airspy",
+  &make_backend< source_iface, airspy_source_c_sptr, &make_airspy_source_c >,
+  &ignore_fake< &airspy_source_c::get_devices >,
+  BACKEND_HARDWARE, 100 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -72,14 +84,52 @@ static const int MAX_IN = 0;	// maximum number of input streams
 static const int MIN_OUT = 1;	// minimum number of output streams
 static const int MAX_OUT = 1;	// maximum number of output streams
 
+static airspy_sample_type parse_sample_type( const std::string &args )
+{
+  dict_t dict = params_to_dict( args );
+
+  if ( ! dict.count( "sample_type" ) || "float32_iq" == dict["sample_type"] )
+    return AIRSPY_SAMPLE_FLOAT32_IQ;
+  if ( "int16_iq" == dict["sample_type"] )
+    return AIRSPY_SAMPLE_INT16_IQ;
+  if ( "float32_real" == dict["sample_type"] )
+    return AIRSPY_SAMPLE_FLOAT32_REAL;
+  if ( "int16_real" == dict["sample_type"] )
+    return AIRSPY_SAMPLE_INT16_REAL;
+
+  throw std::runtime_error( "Unsupported AirSpy sample_type " + dict["sample_type"] +
+                            ", use one of float32_iq, int16_iq, float32_real or int16_real." );
+}
+
+/* the int16 samples may be delivered natively */
+static size_t airspy_item_size( const std::string &args )
+{
+  const airspy_sample_type type = parse_sample_type( args );
+
+  if ( AIRSPY_SAMPLE_INT16_IQ == type || AIRSPY_SAMPLE_INT16_REAL == type )
+    return args_to_item_size( args, "sc16" );
+
+  return sizeof(gr_complex);
+}
+
 /*
  * The private constructor
  */
 airspy_source_c::airspy_source_c (const std::string &args)
   : gr::sync_block ("airspy_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
-        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+        gr::io_signature::make(MIN_OUT, MAX_OUT, airspy_item_size(args))),
     _dev(NULL),
+    _sample_type(parse_sample_type(args)),
+    _real(AIRSPY_SAMPLE_FLOAT32_REAL == _sample_type ||
+          AIRSPY_SAMPLE_INT16_REAL == _sample_type),
+    _native(airspy_item_size(args) != sizeof (gr_complex)),
+    _item_bytes(((AIRSPY_SAMPLE_INT16_IQ == _sample_type ||
+                  AIRSPY_SAMPLE_INT16_REAL == _sample_type) ? sizeof(int16_t) : sizeof(float)) *
+                (_real ? 1 : 2)),
+    _convert_16(1.0f/32768.0f),
+    _fifo(NULL),
+    _min_chunk(0),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0),
@@ -94,6 +144,11 @@ airspy_source_c::airspy_source_c (const std::string &args)
 
   dict_t dict = params_to_dict(args);
 
+  _rx_thread = rx_thread_params( dict );
+
+  if ( dict.count( "min_chunk" ) )
+    _min_chunk = boost::lexical_cast< size_t >( dict["min_chunk"] );
+
   _dev = NULL;
   ret = airspy_open( &_dev );
   AIRSPY_THROW_ON_ERROR(ret, "Failed to open AirSpy device")
@@ -123,10 +178,13 @@ airspy_source_c::airspy_source_c (const std::string &args)
    * to play nice with the monotonic requirement of meta-range later on */
   std::sort(_sample_rates.begin(), _sample_rates.end());
 
+  ret = airspy_set_sample_type( _dev, _sample_type );
+  AIRSPY_THROW_ON_ERROR(ret, "Failed to set the sample type")
+
   std::cerr << "Using " << version << ", samplerates: ";
 
   for (size_t i = 0; i < _sample_rates.size(); i++)
-    std::cerr << boost::format("%gM ") % (_sample_rates[i].first / 1e6);
+    std::cerr << boost::format("%gM ") % (_sample_rates[i].first * (_real ? 2 : 1) / 1e6);
 
   std::cerr << std::endl;
 
@@ -163,11 +221,13 @@ airspy_source_c::airspy_source_c (const std::string &args)
     AIRSPY_THROW_ON_ERROR(ret, "Failed to set USB bit packing")
   }
 
-  _fifo = new boost::circular_buffer<gr_complex>(5000000);
+  _fifo = new sample_fifo<unsigned char>(5000000 * _item_bytes);
   if (!_fifo) {
     throw std::runtime_error( std::string(__FUNCTION__) + " " +
                               "Failed to allocate a sample FIFO!" );
   }
+
+  message_port_register_out( STREAM_STATS_PORT );
 }
 
 /*
@@ -200,39 +260,26 @@ int airspy_source_c::_airspy_rx_callback(airspy_transfer *transfer)
 {
   airspy_source_c *obj = (airspy_source_c *)transfer->ctx;
 
-  return obj->airspy_rx_callback((float *)transfer->samples, transfer->sample_count);
+  return obj->airspy_rx_callback(transfer->samples, transfer->sample_count);
 }
 
 int airspy_source_c::airspy_rx_callback(void *samples, int sample_count)
 {
-  size_t i, n_avail, to_copy, num_samples = sample_count;
-  float *sample = (float *)samples;
-
-  _fifo_lock.lock();
-
-  n_avail = _fifo->capacity() - _fifo->size();
-  to_copy = (n_avail < num_samples ? n_avail : num_samples);
+  /* sample_count counts IQ pairs or real values, one output item each */
+  const size_t num_bytes = size_t(sample_count) * _item_bytes;
 
-  for (i = 0; i < to_copy; i++ )
-  {
-    /* Push sample to the fifo */
-    _fifo->push_back( gr_complex( *sample, *(sample+1) ) );
-
-    /* offset to the next I+Q sample */
-    sample += 2;
-  }
+  _rx_thread.apply_once(); /* on the libairspy consumer thread */
 
-  _fifo_lock.unlock();
+  TRACE_ARRIVAL( "airspy", num_bytes );
 
-  /* We have made some new samples available to the consumer in work() */
-  if (to_copy) {
-    //std::cerr << "+" << std::flush;
-    _samp_avail.notify_one();
-  }
+  /* converted in work(), the usb thread is busy enough at high rates */
+  size_t written = _fifo->write( (const unsigned char *)samples, num_bytes );
 
   /* Indicate overrun, if neccesary */
-  if (to_copy < num_samples)
+  if (written < num_bytes) {
+    _stats.overflow( (num_bytes - written) / _item_bytes );
     std::cerr << "O" << std::flush;
+  }
 
   return 0; // TODO: return -1 on error/stop
 }
@@ -242,12 +289,16 @@ bool airspy_source_c::start()
   if ( ! _dev )
     return false;
 
+  _rx_thread.rearm(); /* libairspy starts new threads each time */
+
   int ret = airspy_start_rx( _dev, _airspy_rx_callback, (void *)this );
   if ( ret != AIRSPY_SUCCESS ) {
     std::cerr << "Failed to start RX streaming (" << ret << ")" << std::endl;
     return false;
   }
 
+  _pause.started();
+
   return true;
 }
 
@@ -269,7 +320,27 @@ int airspy_source_c::work( int noutput_items,
                         gr_vector_const_void_star &input_items,
                         gr_vector_void_star &output_items )
 {
-  gr_complex *out = (gr_complex *)output_items[0];
+  unsigned char *out = (unsigned char *)output_items[0];
+  const size_t out_size = output_signature()->sizeof_stream_item(0);
+
+  /* stopping and restarting the transfers here can't race with us */
+  switch ( _pause.poll() ) {
+  case stream_pause::PAUSE:
+    stop();
+    break;
+  case stream_pause::RESUME:
+    _fifo->clear(); /* from before pausing */
+    start();
+    _resume_time = osmosdr::time_spec_t::get_system_time();
+    break;
+  default:
+    break;
+  }
+
+  if ( _pause.paused() ) {
+    _pause.wait();
+    return 0;
+  }
 
   bool running = false;
 
@@ -279,24 +350,84 @@ int airspy_source_c::work( int noutput_items,
   if ( ! running )
     return WORK_DONE;
 
-  boost::unique_lock<boost::mutex> lock(_fifo_lock);
+  /* deliver what is there as soon as there is a chunk, rather than
+   * stalling the low rates until noutput_items arrived */
+  const size_t chunk = _min_chunk ? _min_chunk : size_t( _sample_rate / 1000 ) + 1;
+
+  if ( ! _fifo->wait( std::min( size_t(noutput_items), chunk ) * _item_bytes,
+                      boost::posix_time::milliseconds( WAIT_TIMEOUT ) ) )
+    return 0; /* see whether we're still streaming */
+
+  const size_t queued = _fifo->size() / _item_bytes;
+  _stats.fill( queued, _fifo->capacity() / _item_bytes );
+  _stats.latency( queued, _sample_rate );
 
-  /* Wait until we have the requested number of samples */
-  int n_samples_avail = _fifo->size();
+  /* the fifo keeps no stamps, the oldest sample arrived queued samples ago */
+  TRACE_OUTPUT( this, "airspy", nitems_written( 0 ),
+                gr::high_res_timer_now() - gr::high_res_timer_type( queued / _sample_rate * gr::high_res_timer_tps() ) );
 
-  while (n_samples_avail < noutput_items) {
-    _samp_avail.wait(lock);
-    n_samples_avail = _fifo->size();
+  noutput_items = std::min( size_t(noutput_items), queued );
+
+  size_t done = 0;
+
+  while ( done < size_t(noutput_items) ) {
+    size_t avail;
+    const unsigned char *in = _fifo->read_ptr( avail );
+
+    const size_t n = std::min( size_t(noutput_items) - done, avail / _item_bytes );
+    if ( ! n )
+      break; /* cancelled */
+
+    convert( in, out + done * out_size, n );
+    _fifo->read_commit( n * _item_bytes );
+    done += n;
   }
 
-  for(int i = 0; i < noutput_items; ++i) {
-    out[i] = _fifo->at(0);
-    _fifo->pop_front();
+  if ( done && _pause.resumed() ) {
+    BOOST_FOREACH( const gr::tag_t &tag,
+                   make_rx_tags( nitems_written(0), _resume_time,
+                                 get_sample_rate(), get_center_freq(), alias() ) )
+      add_item_tag( 0, tag );
   }
 
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
   //std::cerr << "-" << std::flush;
 
-  return noutput_items;
+  return done;
+}
+
+void airspy_source_c::convert( const unsigned char *in, void *out, size_t nitems )
+{
+  switch ( _sample_type ) {
+  case AIRSPY_SAMPLE_INT16_IQ:
+    if ( _native )
+      memcpy( out, in, nitems * _item_bytes );
+    else
+      _convert_16( (const int16_t *)in, (gr_complex *)out, nitems );
+    break;
+  case AIRSPY_SAMPLE_FLOAT32_REAL:
+    for (size_t i = 0; i < nitems; i++)
+      ((gr_complex *)out)[i] = gr_complex( ((const float *)in)[i], 0.0f );
+    break;
+  case AIRSPY_SAMPLE_INT16_REAL:
+    if ( _native ) {
+      int16_t *dst = (int16_t *)out;
+      for (size_t i = 0; i < nitems; i++) {
+        dst[2 * i] = ((const int16_t *)in)[i];
+        dst[2 * i + 1] = 0;
+      }
+    } else {
+      for (size_t i = 0; i < nitems; i++)
+        ((gr_complex *)out)[i] = gr_complex( ((const int16_t *)in)[i] * (1.0f/32768.0f), 0.0f );
+    }
+    break;
+  default:
+    /* interleaved float I+Q pairs share the memory layout of gr_complex */
+    memcpy( out, in, nitems * _item_bytes );
+    break;
+  }
 }
 
 std::vector<std::string> airspy_source_c::get_devices()
@@ -338,8 +469,11 @@ osmosdr::meta_range_t airspy_source_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
 
+  /* the ADC delivers real samples at twice the IQ rate */
+  const double factor = _real ? 2 : 1;
+
   for (size_t i = 0; i < _sample_rates.size(); i++)
-    range += osmosdr::range_t( _sample_rates[i].first );
+    range += osmosdr::range_t( _sample_rates[i].first * factor );
 
   return range;
 }
@@ -354,7 +488,7 @@ double airspy_source_c::set_sample_rate( double rate )
 
     for( unsigned int i = 0; i < _sample_rates.size(); i++ )
     {
-      if( _sample_rates[i].first == rate )
+      if( _sample_rates[i].first * (_real ? 2 : 1) == rate )
       {
         samp_rate_index = _sample_rates[i].second;
 
@@ -654,3 +788,15 @@ osmosdr::freq_range_t airspy_source_c::get_bandwidth_range( size_t chan )
 
   return bandwidths;
 }
+
+osmosdr::stream_stats_t airspy_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
+
+bool airspy_source_c::set_streaming( bool streaming )
+{
+  _pause.request( streaming ); /* carried out by work() */
+
+  return true;
+}
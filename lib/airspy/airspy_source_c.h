@@ -22,15 +22,16 @@
 #ifndef INCLUDED_AIRSPY_SOURCE_C_H
 #define INCLUDED_AIRSPY_SOURCE_C_H
 
-#include <boost/circular_buffer.hpp>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
-
 #include <gnuradio/sync_block.h>
 
 #include <libairspy/airspy.h>
 
 #include "source_iface.h"
+#include "sample_fifo.h"
+#include "sample_convert.h"
+#include "stream_stats.h"
+#include "rx_thread.h"
+#include "stream_pause.h"
 
 class airspy_source_c;
 
@@ -58,6 +59,14 @@ airspy_source_c_sptr make_airspy_source_c (const std::string & args = "");
 
 /*!
  * \brief Provides a stream of complex samples.
+ *
+ * sample_type=float32_iq|int16_iq|float32_real|int16_real selects what
+ * libairspy delivers. The usb thread only copies the transfers into the
+ * fifo, the samples are converted to the output format in work(). The
+ * int16_iq samples are delivered natively for cpu_format=sc16, the real
+ * modes skip the IQ conversion of libairspy and output the real samples
+ * of the ADC as complex samples with a zero imaginary part, at twice the
+ * IQ sample rate, the tuned frequency a quarter of the rate above DC.
  * \ingroup block
  */
 class airspy_source_c :
@@ -121,15 +130,29 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+  bool set_streaming( bool streaming );
+
 private:
   static int _airspy_rx_callback(airspy_transfer* transfer);
   int airspy_rx_callback(void *samples, int sample_count);
 
+  void convert( const unsigned char *in, void *out, size_t nitems );
+
   airspy_device *_dev;
 
-  boost::circular_buffer<gr_complex> *_fifo;
-  boost::mutex _fifo_lock;
-  boost::condition_variable _samp_avail;
+  airspy_sample_type _sample_type;
+  bool _real;          /* ADC samples, one value per item at twice the rate */
+  bool _native;        /* int16 samples delivered as sc16 */
+  size_t _item_bytes;  /* per output item in the fifo */
+  convert_16bit _convert_16;
+
+  sample_fifo<unsigned char> *_fifo; /* the transfers as delivered */
+  size_t _min_chunk; /* items work() waits for, 0 for a millisecond worth */
+  stream_stats _stats;
+  rx_thread_params _rx_thread;
+  stream_pause _pause;
+  osmosdr::time_spec_t _resume_time; /* of the first sample after resuming */
 
   std::vector< std::pair<double, uint32_t> > _sample_rates;
   double _sample_rate;
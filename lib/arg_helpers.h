@@ -24,11 +24,14 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
 
 #include <gnuradio/io_signature.h>
+#include <gnuradio/gr_complex.h>
 
 #include <boost/lexical_cast.hpp>
-#include <boost/tokenizer.hpp>
 #include <boost/foreach.hpp>
 #include <ciso646>
 
@@ -46,34 +49,64 @@ inline std::string dict_to_args_string( const dict_t &d )
     return out;
 }
 
-inline std::vector< std::string > args_to_vector( const std::string &args )
+/*
+ * Split \p str at \p sep in a single pass, the way a boost::tokenizer with
+ * boost::escaped_list_separator("\\", sep, "'") does: quoted separators
+ * are kept, the quotes dropped, and \\ escapes a quote, the separator,
+ * itself or n for a newline.
+ */
+inline std::vector< std::string > split_args( const std::string &str, char sep )
 {
   std::vector< std::string > result;
 
-  boost::escaped_list_separator<char> separator("\\", " ", "'");
-  typedef boost::tokenizer< boost::escaped_list_separator<char> > tokenizer_t;
-  tokenizer_t tokens(args, separator);
+  if ( str.empty() )
+    return result;
 
-  BOOST_FOREACH(std::string token, tokens)
-    result.push_back(token);
+  std::string token;
+  bool quoted = false;
 
-  return result;
-}
+  for ( size_t i = 0; i < str.size(); i++ )
+  {
+    const char c = str[i];
 
-inline std::vector< std::string > params_to_vector( const std::string &params )
-{
-  std::vector< std::string > result;
+    if ( '\\' == c )
+    {
+      if ( ++i == str.size() )
+        throw std::runtime_error("Arguments cannot end with an escape: " + str);
 
-  boost::escaped_list_separator<char> separator("\\", ",", "'");
-  typedef boost::tokenizer< boost::escaped_list_separator<char> > tokenizer_t;
-  tokenizer_t tokens(params, separator);
+      if ( 'n' == str[i] )
+        token += '\n';
+      else if ( '\'' == str[i] || '\\' == str[i] || sep == str[i] )
+        token += str[i];
+      else
+        throw std::runtime_error("Unknown escape sequence in arguments: " + str);
+    }
+    else if ( sep == c && ! quoted )
+    {
+      result.push_back( token );
+      token.clear();
+    }
+    else if ( '\'' == c )
+      quoted = ! quoted;
+    else
+      token += c;
+  }
 
-  BOOST_FOREACH(std::string token, tokens)
-    result.push_back(token);
+  result.push_back( token ); /* empty after a trailing separator */
 
   return result;
 }
 
+inline std::vector< std::string > args_to_vector( const std::string &args )
+{
+  return split_args( args, ' ' );
+}
+
+inline std::vector< std::string > params_to_vector( const std::string &params )
+{
+  return split_args( params, ',' );
+}
+
 inline pair_t param_to_pair( const std::string &param )
 {
   pair_t result;
@@ -98,7 +131,7 @@ inline dict_t params_to_dict( const std::string &params )
   dict_t result;
 
   std::vector< std::string > param_list = params_to_vector( params );
-  BOOST_FOREACH(std::string param, param_list)
+  BOOST_FOREACH(const std::string &param, param_list)
   {
     pair_t pair = param_to_pair( param );
     std::string value = pair.second;
@@ -118,7 +151,173 @@ struct is_nchan_argument
   }
 };
 
-inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
+/*
+ * Tokens not describing a device but the source as a whole, like
+ * "numchan=2 cpu_format=sc16 sync=pps channels=... rtl=0,buffers=32".
+ */
+struct is_global_argument
+{
+  bool operator ()(const std::string &str)
+  {
+    if ( is_nchan_argument()( str ) )
+      return true;
+
+    return (*this)( params_to_dict( str ) );
+  }
+
+  /* for arguments already parsed, without numchan= */
+  bool operator ()(const dict_t &dict)
+  {
+    BOOST_FOREACH( const dict_t::value_type &entry, dict )
+      if ( entry.first != "cpu_format" && entry.first != "sync" &&
+           entry.first != "channels" && entry.first != "iq_estimator_duty" &&
+           entry.first != "retune_settle" && entry.first != "latency" &&
+           entry.first != "parallel_ctrl" && entry.first != "param_cache" &&
+           entry.first != "fft_size" && entry.first != "fft_rate" &&
+           entry.first != "fft_alpha" && entry.first != "stitch" &&
+           entry.first != "coherent" && entry.first != "coherent_cal" &&
+           entry.first != "coherent_interval" && entry.first != "fine_tune" &&
+           entry.first != "fine_tune_window" && entry.first != "gate_threshold" &&
+           entry.first != "gate_hold" && entry.first != "gate_pre" &&
+           entry.first != "cache_dir" && entry.first != "retune_tags" )
+        return false;
+
+    return ! dict.empty();
+  }
+};
+
+/*
+ * One token of the arguments of a source or sink, parsed once: the key/value
+ * pairs and whether it describes a device or the source as a whole. The
+ * token itself is still what a backend gets to see.
+ */
+struct device_spec
+{
+  device_spec( const std::string &arg ) :
+    arg(arg),
+    dict(params_to_dict(arg)),
+    global(is_nchan_argument()( arg ) || is_global_argument()( dict )) {}
+
+  bool has( const std::string &key ) const { return dict.count( key ) > 0; }
+
+  std::string get( const std::string &key, const std::string &def = "" ) const
+  {
+    dict_t::const_iterator it = dict.find( key );
+
+    return it != dict.end() ? it->second : def;
+  }
+
+  /*! \throw std::runtime_error naming the argument if it isn't a valid T */
+  template < typename T >
+  T get( const std::string &key, const T &def ) const
+  {
+    dict_t::const_iterator it = dict.find( key );
+
+    if ( it == dict.end() )
+      return def;
+
+    try {
+      return boost::lexical_cast< T >( it->second );
+    } catch ( boost::bad_lexical_cast & ) {
+      throw std::runtime_error("Invalid value '" + it->second + "' for " + key + ".");
+    }
+  }
+
+  std::string arg;
+  dict_t dict;
+  bool global;
+};
+
+typedef std::vector< device_spec > device_specs_t;
+
+inline device_specs_t args_to_specs( const std::string &args )
+{
+  device_specs_t specs;
+
+  BOOST_FOREACH( const std::string &arg, args_to_vector( args ) )
+    specs.push_back( device_spec( arg ) );
+
+  return specs;
+}
+
+/*
+ * The channels= argument of a source, "offset1:bw1;offset2:bw2", each
+ * entry adding a decimated output after the device channels.
+ */
+inline std::string args_to_channels( const std::string &args )
+{
+  std::string channels;
+
+  BOOST_FOREACH( std::string arg, args_to_vector( args ) )
+  {
+    dict_t dict = params_to_dict( arg );
+    if ( dict.count( "channels" ) )
+      channels = dict["channels"];
+  }
+
+  return channels;
+}
+
+/*
+ * Sample formats a source may deliver to the host via the cpu_format argument:
+ * fc32 (gr_complex, the default), sc16 (interleaved int16_t, full scale
+ * +/- 32767) and sc8 (interleaved int8_t, full scale +/- 127).
+ */
+inline size_t cpu_format_item_size( const std::string &format )
+{
+  if ( format.empty() || "fc32" == format )
+    return sizeof(gr_complex);
+  else if ( "sc16" == format )
+    return 2 * sizeof(int16_t);
+  else if ( "sc8" == format )
+    return 2 * sizeof(int8_t);
+
+  throw std::runtime_error("Unsupported cpu_format '" + format + "', "
+                           "use one of fc32, sc16 or sc8.");
+}
+
+/*
+ * Parse the cpu_format given either globally or as part of the device
+ * arguments. All devices of a source have to agree on the same format.
+ */
+inline std::string args_to_cpu_format( const std::string &args )
+{
+  std::string format;
+
+  BOOST_FOREACH( std::string arg, args_to_vector( args ) )
+  {
+    dict_t dict = params_to_dict( arg );
+    if ( ! dict.count( "cpu_format" ) )
+      continue;
+
+    if ( format.size() && format != dict["cpu_format"] )
+      throw std::runtime_error("Conflicting cpu_format arguments specified.");
+
+    format = dict["cpu_format"];
+  }
+
+  cpu_format_item_size( format ); /* throws if unsupported */
+
+  return format.size() ? format : "fc32";
+}
+
+/*
+ * Output item size of a backend able to deliver \p native without any
+ * conversion: the item size of \p native format if requested, gr_complex
+ * otherwise. source_impl converts gr_complex output to the requested format.
+ */
+inline size_t args_to_item_size( const std::string &args, const std::string &native )
+{
+  dict_t dict = params_to_dict( args );
+
+  if ( dict.count( "cpu_format" ) && native == dict["cpu_format"] )
+    return cpu_format_item_size( native );
+
+  return sizeof(gr_complex);
+}
+
+inline gr::io_signature::sptr args_to_io_signature( const std::string &args,
+                                                    const std::string &cpu_format = "fc32" )
 {
   size_t max_nchan = 0;
   size_t dev_nchan = 0;
@@ -133,10 +332,10 @@ inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
     }
   }
 
-  arg_list.erase( std::remove_if( // remove any global nchan tokens
+  arg_list.erase( std::remove_if( // remove any global nchan, cpu_format... tokens
                     arg_list.begin(),
                     arg_list.end(),
-                    is_nchan_argument() ),
+                    is_global_argument() ),
                   arg_list.end() );
 
   // try to parse device specific nchan values, assume 1 channel if none given
@@ -158,8 +357,13 @@ inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
   if ( max_nchan && dev_nchan && max_nchan != dev_nchan )
     throw std::runtime_error("Wrong device arguments specified. Missing nchan?");
 
-  const size_t nchan = std::max<size_t>(dev_nchan, 1); // assume at least one
-  return gr::io_signature::make(nchan, nchan, sizeof(gr_complex));
+  size_t nchan = std::max<size_t>(dev_nchan, 1); // assume at least one
+
+  std::string channels = args_to_channels( args );
+  if ( channels.size() ) // one more output per extracted channel
+    nchan += std::count( channels.begin(), channels.end(), ';' ) + 1;
+
+  return gr::io_signature::make(nchan, nchan, cpu_format_item_size(cpu_format));
 }
 
 #endif // OSMOSDR_ARG_HELPERS_H
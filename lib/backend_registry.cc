@@ -0,0 +1,241 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <set>
+
+#include <boost/foreach.hpp>
+#include <boost/thread/once.hpp>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "backend_registry.h"
+
+template < typename iface_t >
+backend_registry< iface_t > &backend_registry< iface_t >::instance()
+{
+  /* never destroyed, plugins may still refer to it while unloading */
+  static backend_registry *registry = new backend_registry;
+
+  return *registry;
+}
+
+template < typename backend >
+static bool by_order( const backend &a, const backend &b )
+{
+  return a.order < b.order;
+}
+
+template < typename iface_t >
+void backend_registry< iface_t >::add( const backend &b )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( _index.count( b.name ) ) {
+    std::cerr << "Ignoring duplicate backend " << b.name << std::endl;
+    return;
+  }
+
+  _backends.insert( std::upper_bound( _backends.begin(), _backends.end(),
+                                      b, by_order< backend > ), b );
+
+  _index.clear();
+
+  for ( size_t i = 0; i < _backends.size(); i++ ) {
+    _index[_backends[i].name] = i;
+
+    BOOST_FOREACH( const std::string &alias, _backends[i].aliases )
+      _index[alias] = i;
+  }
+}
+
+template < typename iface_t >
+bool backend_registry< iface_t >::find( const dict_t &dict, backend &b )
+{
+  if ( lookup( dict, b ) )
+    return true;
+
+  /* the backend may be provided by a module not loaded yet */
+  bool loaded = false;
+
+  BOOST_FOREACH( const dict_t::value_type &entry, dict )
+    loaded |= load_backend_module( entry.first );
+
+  return loaded && lookup( dict, b );
+}
+
+template < typename iface_t >
+bool backend_registry< iface_t >::lookup( const dict_t &dict, backend &b )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  BOOST_FOREACH( const dict_t::value_type &entry, dict ) {
+    typename boost::unordered_map< std::string, size_t >::const_iterator it;
+
+    it = _index.find( entry.first );
+    if ( it != _index.end() ) {
+      b = _backends[it->second];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template < typename iface_t >
+std::vector< backend_t< iface_t > > backend_registry< iface_t >::backends( unsigned int caps )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  std::vector< backend > backends;
+
+  BOOST_FOREACH( const backend &b, _backends )
+    if ( (b.caps & caps) == caps )
+      backends.push_back( b );
+
+  return backends;
+}
+
+template class backend_registry< source_iface >;
+template class backend_registry< sink_iface >;
+
+#ifndef _WIN32
+static bool load_plugin( const std::string &path )
+{
+  /* the module registers its backends from its static initializers */
+  if ( dlopen( path.c_str(), RTLD_NOW | RTLD_LOCAL ) )
+    return true;
+
+  std::cerr << "Failed to load " << path << ": " << dlerror() << std::endl;
+  return false;
+}
+
+/* load all files in \p dir starting with \p prefix and ending with \p suffix */
+static void load_plugin_dir( const std::string &dir, const std::string &prefix,
+                             const std::string &suffix )
+{
+  DIR *d = opendir( dir.c_str() );
+  if ( ! d )
+    return;
+
+  struct dirent *entry;
+  while ( (entry = readdir( d )) != NULL ) {
+    std::string name = entry->d_name;
+
+    if ( boost::algorithm::starts_with( name, prefix ) &&
+         boost::algorithm::ends_with( name, suffix ) )
+      load_plugin( dir + "/" + name );
+  }
+
+  closedir( d );
+}
+
+static void load_plugin_path()
+{
+  const char *env = getenv( "OSMOSDR_PLUGIN_PATH" );
+  if ( ! env )
+    return;
+
+  std::vector< std::string > paths;
+  boost::algorithm::split( paths, env, boost::is_any_of( ":" ) );
+
+  BOOST_FOREACH( const std::string &path, paths ) {
+    struct stat st;
+
+    if ( path.empty() || stat( path.c_str(), &st ) < 0 )
+      continue;
+
+    if ( S_ISDIR( st.st_mode ) )
+      load_plugin_dir( path, "", ".so" );
+    else
+      load_plugin( path );
+  }
+}
+
+static boost::once_flag plugin_path_once = BOOST_ONCE_INIT;
+#endif
+
+#ifdef ENABLE_BACKEND_MODULES
+#define MODULE_PREFIX "gr-osmosdr-"
+
+static void load_all_modules()
+{
+  load_plugin_dir( OSMOSDR_MODULE_PATH, MODULE_PREFIX, OSMOSDR_MODULE_SUFFIX );
+}
+
+static boost::once_flag modules_once = BOOST_ONCE_INIT;
+#endif
+
+bool load_backend_module( const std::string &type )
+{
+#ifndef _WIN32
+  boost::call_once( &load_plugin_path, plugin_path_once );
+#endif
+#ifdef ENABLE_BACKEND_MODULES
+  static boost::mutex mutex;
+  static std::set< std::string > tried;
+
+  boost::mutex::scoped_lock lock( mutex );
+
+  std::string name = type;
+
+  /* device types which aren't named after their module */
+  if ( "sdr-iq" == name || "sdr-ip" == name || "netsdr" == name || "cloudiq" == name )
+    name = "rfspace";
+  else if ( "tcp_server" == name )
+    name = "rtl_tcp";
+
+  if ( tried.count( name ) )
+    return false;
+
+  tried.insert( name );
+
+  std::string path = std::string( OSMOSDR_MODULE_PATH ) + "/" +
+                     MODULE_PREFIX + name + OSMOSDR_MODULE_SUFFIX;
+
+  struct stat st;
+  if ( stat( path.c_str(), &st ) < 0 )
+    return false; /* most argument names aren't device types */
+
+  return load_plugin( path );
+#else
+  return false;
+#endif
+}
+
+void load_backend_plugins()
+{
+#ifndef _WIN32
+  boost::call_once( &load_plugin_path, plugin_path_once );
+#endif
+#ifdef ENABLE_BACKEND_MODULES
+  boost::call_once( &load_all_modules, modules_once );
+#endif
+}
@@ -0,0 +1,178 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_BACKEND_REGISTRY_H
+#define OSMOSDR_BACKEND_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <boost/unordered_map.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/basic_block.h>
+
+#include <osmosdr/api.h>
+
+#include "source_iface.h"
+#include "sink_iface.h"
+#include "arg_helpers.h"
+
+/*
+ * Backends register themselves with a static source_registrar or
+ * sink_registrar object in their translation unit, so source_impl and
+ * sink_impl don't need to know about them. The enumeration order is given
+ * explicitly, hardware backends use values below BACKEND_ORDER_SOFTWARE
+ * so they are offered first when no device is specified.
+ */
+
+enum backend_caps_t
+{
+  BACKEND_HARDWARE = 1 << 0, /* radio attached to this machine */
+  BACKEND_NETWORK  = 1 << 1, /* radio or server reached via the network */
+  BACKEND_FILE     = 1 << 2, /* recordings */
+
+  BACKEND_HW_DC_OFFSET  = 1 << 3, /* corrects the rx DC offset itself */
+  BACKEND_HW_IQ_BALANCE = 1 << 4, /* corrects the rx IQ imbalance itself */
+  BACKEND_HW_CORRECTION = BACKEND_HW_DC_OFFSET | BACKEND_HW_IQ_BALANCE,
+
+  BACKEND_RETUNE_TAGS   = 1 << 5  /* tags rx_freq itself, see tag_retune() */
+};
+
+#define BACKEND_ORDER_SOFTWARE 200
+
+template < typename iface_t >
+struct backend_t
+{
+  typedef std::pair< gr::basic_block_sptr, iface_t * > instance_t;
+  typedef instance_t (*factory_t)( const std::string &args );
+  typedef std::vector< std::string > (*enumerate_t)( bool fake );
+
+  std::string name;                  /* device type, as in "rtl=0" */
+  std::vector< std::string > aliases;
+  factory_t make;
+  enumerate_t enumerate;
+  unsigned int caps;                 /* backend_caps_t flags */
+  int order;
+};
+
+template < typename iface_t >
+class OSMOSDR_API backend_registry
+{
+public:
+  typedef backend_t< iface_t > backend;
+
+  static backend_registry &instance();
+
+  void add( const backend &b );
+
+  /*!
+   * Look up the backend named by one of the keys of \p dict, loading the
+   * module providing it if necessary.
+   * \return false if \p dict doesn't name any available backend
+   */
+  bool find( const dict_t &dict, backend &b );
+
+  /*!
+   * \return all backends providing all of \p caps, in enumeration order
+   */
+  std::vector< backend > backends( unsigned int caps = 0 );
+
+private:
+  bool lookup( const dict_t &dict, backend &b );
+
+  boost::mutex _mutex;
+  std::vector< backend > _backends;                      /* sorted by order */
+  boost::unordered_map< std::string, size_t > _index;    /* name or alias */
+};
+
+typedef backend_registry< source_iface > source_registry;
+typedef backend_registry< sink_iface > sink_registry;
+
+template < typename iface_t >
+struct backend_registrar
+{
+  /*!
+   * \param aliases comma separated alternative device types
+   */
+  backend_registrar( const std::string &name,
+                     typename backend_t< iface_t >::factory_t make,
+                     typename backend_t< iface_t >::enumerate_t enumerate,
+                     unsigned int caps,
+                     int order,
+                     const std::string &aliases = "" )
+  {
+    backend_t< iface_t > b;
+
+    b.name = name;
+    if ( aliases.length() )
+      boost::algorithm::split( b.aliases, aliases, boost::is_any_of( "," ) );
+    b.make = make;
+    b.enumerate = enumerate;
+    b.caps = caps;
+    b.order = order;
+
+    backend_registry< iface_t >::instance().add( b );
+  }
+};
+
+typedef backend_registrar< source_iface > source_registrar;
+typedef backend_registrar< sink_iface > sink_registrar;
+
+/*! Adapt a block factory like make_rtl_source_c() to backend_t::factory_t. */
+template < typename iface_t, typename sptr_t, sptr_t (*make)( const std::string & ) >
+typename backend_t< iface_t >::instance_t make_backend( const std::string &args )
+{
+  sptr_t block = make( args );
+
+  return typename backend_t< iface_t >::instance_t( block, block.get() );
+}
+
+/*! Adapt get_devices() of backends without fake devices to backend_t::enumerate_t. */
+template < std::vector< std::string > (*get_devices)() >
+std::vector< std::string > ignore_fake( bool fake )
+{
+  return get_devices();
+}
+
+/*!
+ * With ENABLE_BACKEND_MODULES each backend is built as a module, which
+ * is only loaded once its device type is used, so the vendor libraries of
+ * unused backends are never mapped. Modules register their backends from
+ * their static initializers.
+ *
+ * Additional modules are picked up from OSMOSDR_PLUGIN_PATH, a colon
+ * separated list of shared objects or directories containing them.
+ */
+
+/*!
+ * Load the module providing device type \p type.
+ * \return true if a module has been loaded
+ */
+OSMOSDR_API bool load_backend_module( const std::string &type );
+
+/*!
+ * Load all modules, needed before enumerating devices. Only the first call
+ * has any effect.
+ */
+OSMOSDR_API void load_backend_plugins();
+
+#endif // OSMOSDR_BACKEND_REGISTRY_H
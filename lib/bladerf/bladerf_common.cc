@@ -29,10 +29,13 @@
 #endif
 
 #include <string>
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/assign.hpp>
 #include <boost/foreach.hpp>
@@ -49,17 +52,44 @@ boost::mutex bladerf_common::_devs_mutex;
 std::list<boost::weak_ptr<struct bladerf> > bladerf_common::_devs;
 
 bladerf_common::bladerf_common() :
+  _auto_buffers(false),
+  _buffer_latency(AUTO_BUFFER_MS / 1000.0),
+  _reconfigure(false),
   _conv_buf(NULL),
   _conv_buf_size(4096),
   _xb_200_attached(false),
-  _consecutive_failures(0)
+  _consecutive_failures(0),
+  _reconnect(false),
+  _hop_module(BLADERF_MODULE_RX),
+  _hop_ticks(0),
+  _hop_lead(0),
+  _hop_next(0),
+  _hop_index(0),
+  _hopping(false),
+  _stream_errors(0),
+  _error_stamp(0),
+  _reopen_delay_ms(REOPEN_MIN_MS)
 {
 
 }
 
 bladerf_common::~bladerf_common()
 {
-    free(_conv_buf);
+    stop_hopping();
+    convert_free(_conv_buf);
+}
+
+void bladerf_common::alloc_conv_buf(size_t nsamples)
+{
+  convert_free(_conv_buf);
+
+  _conv_buf_size = nsamples;
+  _conv_buf = static_cast<int16_t*>(convert_malloc(_conv_buf_size * 2 * sizeof(int16_t)));
+
+  if (_conv_buf == NULL) {
+    throw std::runtime_error( std::string(__FUNCTION__) +
+                              "Failed to allocate _conv_buf" );
+  }
 }
 
 bladerf_sptr bladerf_common:: get_cached_device(struct bladerf_devinfo devinfo)
@@ -100,7 +130,9 @@ void bladerf_common::close(void* dev)
   bladerf_close((struct bladerf *)dev);
 }
 
-bladerf_sptr bladerf_common::open(const std::string &device_name)
+/* An uncached open skips handles of the device still held elsewhere, which
+ * are stale after the device dropped off the bus. */
+bladerf_sptr bladerf_common::open(const std::string &device_name, bool cached)
 {
   int rv;
   struct bladerf *raw_dev;
@@ -113,7 +145,7 @@ bladerf_sptr bladerf_common::open(const std::string &device_name)
     throw std::runtime_error(std::string(__FUNCTION__) + " " +
                              "Failed to get devinfo for '" + device_name + "'");
 
-  bladerf_sptr cached_dev = get_cached_device(devinfo);
+  bladerf_sptr cached_dev = cached ? get_cached_device(devinfo) : bladerf_sptr();
 
   if (cached_dev)
     return cached_dev;
@@ -125,7 +157,8 @@ bladerf_sptr bladerf_common::open(const std::string &device_name)
 
   bladerf_sptr dev = bladerf_sptr(raw_dev, bladerf_common::close);
 
-  _devs.push_back(boost::weak_ptr<struct bladerf>(dev));
+  /* newest first, so a reopened device is found before a stale handle */
+  _devs.push_front(boost::weak_ptr<struct bladerf>(dev));
 
   return dev;
 }
@@ -198,6 +231,20 @@ bool bladerf_common::start(bladerf_module module)
       format = BLADERF_FORMAT_SC16_Q11;
   }
 
+  if (_auto_buffers) {
+    derive_buffers(get_sample_rate(module));
+
+    std::cerr << _pfx << "Using " << _num_buffers << " buffers of "
+              << _samples_per_buffer << " samples, " << _num_transfers
+              << " transfers" << std::endl;
+  }
+
+  _reconfigure = false;
+
+  /* Size the conversion buffer up front, so work() won't have to */
+  if (_samples_per_buffer > size_t(_conv_buf_size))
+    alloc_conv_buf(_samples_per_buffer);
+
   ret = bladerf_sync_config(_dev.get(), module, format,
                             _num_buffers, _samples_per_buffer,
                             _num_transfers, _stream_timeout_ms);
@@ -252,10 +299,8 @@ static bool version_greater_or_equal(const struct bladerf_version *version,
 
 void bladerf_common::init(dict_t &dict, bladerf_module module)
 {
-  int ret;
   std::string device_name("");
   struct bladerf_version ver;
-  char serial[BLADERF_SERIAL_LENGTH];
   const char *type = (module == BLADERF_MODULE_TX ? "sink" : "source");
 
   _pfx = std::string("[bladeRF ") + std::string(type) + std::string("] ");
@@ -317,6 +362,45 @@ void bladerf_common::init(dict_t &dict, bladerf_module module)
                               device_name );
   }
 
+  _args = dict;
+  _reconnect = (dict.count("reconnect") && "true" == dict["reconnect"]);
+
+  setup(dict, module);
+}
+
+bool bladerf_common::reopen(bladerf_module module)
+{
+  boost::this_thread::sleep( boost::posix_time::milliseconds( _reopen_delay_ms ) );
+  _reopen_delay_ms = std::min( 2 * _reopen_delay_ms, REOPEN_MAX_MS );
+
+  if ( _serial.empty() )
+    return false;
+
+  stop_hopping();
+
+  try {
+    /* the instance number may have changed meanwhile */
+    _dev = open( std::string("*:serial=") + _serial, false );
+    setup( _args, module );
+  } catch ( std::exception & ) {
+    return false; /* not back yet */
+  }
+
+  std::cerr << _pfx << "Reopened the device" << std::endl;
+
+  _reopen_delay_ms = REOPEN_MIN_MS;
+  _consecutive_failures = 0;
+
+  return true;
+}
+
+/* Everything done by init() once the device is open */
+void bladerf_common::setup(dict_t &dict, bladerf_module module)
+{
+  int ret;
+  struct bladerf_version ver;
+  char serial[BLADERF_SERIAL_LENGTH];
+
   /* Load an FPGA */
   if ( dict.count("fpga") )
   {
@@ -400,20 +484,36 @@ void bladerf_common::init(dict_t &dict, bladerf_module module)
   {
     std::string strser(serial);
 
+    _serial = strser;
+
     if ( strser.length() == 32 )
       strser.replace( 4, 24, "..." );
 
     std::cerr << " Serial # " << strser << std::endl;
   }
 
-  if ( bladerf_fw_version( _dev.get(), &ver ) == 0 )
+  _device_id.clear();
+
+  if ( bladerf_fw_version( _dev.get(), &ver ) == 0 ) {
     std::cerr << " FW v" << ver.major << "." << ver.minor << "." << ver.patch;
 
-  if ( bladerf_fpga_version( _dev.get(), &ver ) == 0 )
+    if ( _serial.size() )
+      _device_id = "bladerf-" + _serial + "-" + ver.describe;
+  }
+
+  if ( bladerf_fpga_version( _dev.get(), &ver ) == 0 ) {
     std::cerr << " FPGA v" << ver.major << "." << ver.minor << "." << ver.patch;
 
+    if ( _device_id.size() )
+      _device_id += std::string("-") + ver.describe;
+  }
+
   std::cerr << std::endl;
 
+  /* the XB-200 extends the frequency range */
+  if ( _device_id.size() && _xb_200_attached )
+    _device_id += "-xb200";
+
   if (dict.count("tamer")) {
     set_clock_source( dict["tamer"] );
     std::cerr << _pfx << "Tamer mode set to '" << get_clock_source() << "'";
@@ -426,8 +526,18 @@ void bladerf_common::init(dict_t &dict, bladerf_module module)
 
   /* Initialize buffer and sample configuration */
   _num_buffers = 0;
+  _auto_buffers = false;
   if (dict.count("buffers")) {
-    _num_buffers = boost::lexical_cast< size_t >( dict["buffers"] );
+    if (dict["buffers"] == "auto")
+      _auto_buffers = true;
+    else
+      _num_buffers = boost::lexical_cast< size_t >( dict["buffers"] );
+  }
+
+  _buffer_latency = AUTO_BUFFER_MS / 1000.0;
+  if (dict.count("buffer_ms")) {
+    _buffer_latency = boost::lexical_cast< double >( dict["buffer_ms"] ) / 1000.0;
+    _auto_buffers = true;
   }
 
   _samples_per_buffer = 0;
@@ -483,12 +593,7 @@ void bladerf_common::init(dict_t &dict, bladerf_module module)
                 << std::endl;
   }
 
-  _conv_buf = static_cast<int16_t*>(malloc(_conv_buf_size * 2 * sizeof(int16_t)));
-
-  if (_conv_buf == NULL) {
-    throw std::runtime_error( std::string(__FUNCTION__) +
-                              "Failed to allocate _conv_buf" );
-  }
+  alloc_conv_buf(_conv_buf_size);
 }
 
 osmosdr::freq_range_t bladerf_common::freq_range()
@@ -578,9 +683,253 @@ double bladerf_common::set_sample_rate( bladerf_module module, double rate )
                               std::string(bladerf_strerror(status)));
   }
 
+  /* the buffers follow the rate, applied by the next work() */
+  if (_auto_buffers)
+    _reconfigure = true;
+
   return actual.integer + actual.num / (double)actual.den;
 }
 
+void bladerf_common::derive_buffers(double rate)
+{
+  if (!(rate > 0))
+    return;
+
+  size_t len = size_t(std::ceil(rate * AUTO_FILL_MS / 1000.0 / 1024)) * 1024;
+  len = std::max<size_t>(1024, std::min(len, size_t(AUTO_MAX_BUFLEN)));
+
+  size_t num = size_t(std::ceil(rate * _buffer_latency / len));
+  num = std::max(size_t(AUTO_MIN_BUFFERS), std::min(num, size_t(AUTO_MAX_BUFFERS)));
+
+  _samples_per_buffer = len;
+  _num_buffers = num;
+  _num_transfers = std::min<size_t>(32, num / 2);
+}
+
+void bladerf_common::stream_error()
+{
+  if (!_auto_buffers)
+    return;
+
+  const gr::high_res_timer_type now = gr::high_res_timer_now();
+
+  if (0 == _stream_errors ||
+      now - _error_stamp > AUTO_ERROR_WINDOW * gr::high_res_timer_tps()) {
+    _stream_errors = 0;
+    _error_stamp = now;
+  }
+
+  if (++_stream_errors <= AUTO_MAX_ERRORS)
+    return;
+
+  _stream_errors = 0;
+
+  if (_buffer_latency * 1000.0 >= AUTO_MAX_BUFFER_MS)
+    return; /* as large as it gets */
+
+  _buffer_latency = std::min(2 * _buffer_latency, AUTO_MAX_BUFFER_MS / 1000.0);
+  _reconfigure = true;
+
+  std::cerr << _pfx << "Frequent overruns or timeouts, buffering "
+            << _buffer_latency * 1000.0 << " ms" << std::endl;
+}
+
+pmt::pmt_t bladerf_common::buffer_stats(pmt::pmt_t msg)
+{
+  msg = pmt::dict_add(msg, pmt::mp("num_buffers"), pmt::from_uint64(_num_buffers));
+  msg = pmt::dict_add(msg, pmt::mp("samples_per_buffer"), pmt::from_uint64(_samples_per_buffer));
+  msg = pmt::dict_add(msg, pmt::mp("num_transfers"), pmt::from_uint64(_num_transfers));
+
+  return msg;
+}
+
+bool bladerf_common::set_hop_plan(bladerf_module module,
+                                  const std::vector<double> &freqs,
+                                  double dwell)
+{
+  stop_hopping();
+
+  if (freqs.empty())
+    return true;
+
+#ifndef BLADERF_RETUNE_NOW
+  std::cerr << _pfx << "Hopping requires libbladeRF 1.4.0 or later" << std::endl;
+  return false;
+#else
+  if (!_use_metadata) {
+    std::cerr << _pfx << "Hopping requires timestamps, set enable_metadata"
+              << std::endl;
+    return false;
+  }
+
+  const double rate = get_sample_rate(module);
+
+  if (dwell * rate < 1.0) {
+    std::cerr << _pfx << "Hop dwell of " << dwell << " s is shorter than a sample"
+              << std::endl;
+    return false;
+  }
+
+  std::vector<struct bladerf_quick_tune> tunes(freqs.size());
+  std::vector<double> actual(freqs.size());
+
+  /* Tune once to each frequency to learn its quick tune parameters, the
+   * scheduled retunes then skip the VCO search */
+  for (size_t i = 0; i < freqs.size(); i++) {
+    unsigned int freq;
+    int ret;
+
+    ret = bladerf_set_frequency(_dev.get(), module, (uint32_t)freqs[i]);
+    if (ret == 0)
+      ret = bladerf_get_quick_tune(_dev.get(), module, &tunes[i]);
+    if (ret == 0)
+      ret = bladerf_get_frequency(_dev.get(), module, &freq);
+
+    if (ret != 0) {
+      std::cerr << _pfx << "Failed to prepare the hop to " << freqs[i]
+                << " Hz: " << bladerf_strerror(ret) << std::endl;
+      return false;
+    }
+
+    actual[i] = freq;
+  }
+
+  boost::mutex::scoped_lock lock(_hop_mutex);
+
+  _hop_tunes = tunes;
+  _hop_freqs = actual;
+  _hop_module = module;
+  _hop_ticks = uint64_t(dwell * rate + 0.5);
+  _hop_lead = uint64_t(rate / 100); /* 10 ms, covers a USB round trip */
+  _hop_next = 0;
+  _hop_index = 0;
+  _hops.clear();
+
+  _hopping = true;
+  _hop_thread = gr::thread::thread(boost::bind(&bladerf_common::hop_task, this, rate));
+
+  return true;
+#endif
+}
+
+void bladerf_common::stop_hopping()
+{
+  {
+    boost::mutex::scoped_lock lock(_hop_mutex);
+
+    if (!_hopping)
+      return;
+
+    _hopping = false;
+    _hop_cond.notify_all();
+  }
+
+  _hop_thread.join();
+
+#ifdef BLADERF_RETUNE_NOW
+  int ret = bladerf_cancel_scheduled_retunes(_dev.get(), _hop_module);
+  if (ret != 0)
+    std::cerr << _pfx << "bladerf_cancel_scheduled_retunes failed: "
+              << bladerf_strerror(ret) << std::endl;
+#endif
+
+  boost::mutex::scoped_lock lock(_hop_mutex);
+  _hops.clear();
+}
+
+bool bladerf_common::next_hop(uint64_t end, uint64_t &timestamp, double &freq)
+{
+  boost::mutex::scoped_lock lock(_hop_mutex);
+
+  if (_hops.empty() || _hops.front().first >= end)
+    return false;
+
+  timestamp = _hops.front().first;
+  freq = _hops.front().second;
+  _hops.pop_front();
+
+  return true;
+}
+
+void bladerf_common::hop_task(double rate)
+{
+#ifdef BLADERF_RETUNE_NOW
+  /* The plan (_hop_tunes, _hop_next, ...) is only touched by this thread
+   * while it runs, _hop_mutex guards _hops and _hopping. It is released
+   * around the libbladeRF calls, which next_hop() in work() mustn't wait for. */
+  boost::mutex::scoped_lock lock(_hop_mutex);
+
+  while (_hopping) {
+    std::vector< std::pair<uint64_t, double> > scheduled;
+    bladerf_timestamp now;
+    bool resync = false;
+    int ret;
+
+    lock.unlock();
+
+    ret = bladerf_get_timestamp(_dev.get(), _hop_module, &now);
+    if (ret != 0) {
+      std::cerr << _pfx << "Stopped hopping, bladerf_get_timestamp failed: "
+                << bladerf_strerror(ret) << std::endl;
+      break;
+    }
+
+    /* Start a little ahead of the device, and start over when we fell
+     * behind or the counter was reset by a restart of the stream */
+    if (_hop_next < now + _hop_lead ||
+        _hop_next > now + _hop_lead + (HOP_QUEUE + 1) * _hop_ticks) {
+      if (_hop_next) {
+        std::cerr << _pfx << "Hop schedule lost, resynchronizing" << std::endl;
+
+        /* Drop the stale retunes so the new ones don't overflow the queue */
+        ret = bladerf_cancel_scheduled_retunes(_dev.get(), _hop_module);
+        if (ret != 0) {
+          std::cerr << _pfx << "Stopped hopping, bladerf_cancel_scheduled_retunes failed: "
+                    << bladerf_strerror(ret) << std::endl;
+          break;
+        }
+      }
+
+      _hop_next = now + _hop_lead;
+      resync = true;
+    }
+
+    while (_hop_next < now + _hop_lead + HOP_QUEUE * _hop_ticks) {
+      ret = bladerf_schedule_retune(_dev.get(), _hop_module, _hop_next, 0,
+                                    &_hop_tunes[_hop_index]);
+      if (ret != 0)
+        break;
+
+      if (_hop_module == BLADERF_MODULE_RX)
+        scheduled.push_back(std::make_pair(uint64_t(_hop_next), _hop_freqs[_hop_index]));
+
+      _hop_next += _hop_ticks;
+      _hop_index = (_hop_index + 1) % _hop_tunes.size();
+    }
+
+    lock.lock();
+
+    if (resync)
+      _hops.clear();
+
+    _hops.insert(_hops.end(), scheduled.begin(), scheduled.end());
+
+    if (ret != 0) {
+      std::cerr << _pfx << "Stopped hopping, bladerf_schedule_retune failed: "
+                << bladerf_strerror(ret) << std::endl;
+      break;
+    }
+
+    /* Top the queue up again once half of it has been used, unless
+     * stop_hopping() was called while the lock was released */
+    double wait = std::max(HOP_QUEUE / 2 * _hop_ticks / rate, 0.001);
+
+    if (_hopping)
+      _hop_cond.timed_wait(lock, boost::posix_time::microseconds(long(wait * 1e6)));
+  }
+#endif
+}
+
 double bladerf_common::get_sample_rate( bladerf_module module )
 {
   int status;
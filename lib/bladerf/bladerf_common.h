@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <string>
+#include <deque>
 
 #include <boost/circular_buffer.hpp>
 #include <boost/thread/mutex.hpp>
@@ -35,11 +36,14 @@
 
 #include <gnuradio/thread/thread.h>
 #include <gnuradio/gr_complex.h>
+#include <gnuradio/high_res_timer.h>
+#include <pmt/pmt.h>
 
 #include <libbladeRF.h>
 
 #include "osmosdr/ranges.h"
 #include "arg_helpers.h"
+#include "sample_convert.h"
 
 #ifdef _MSC_VER
 #include <cstddef>
@@ -58,6 +62,11 @@ protected:
   /* Handle initialized and parameters common to both source & sink */
   void init(dict_t &dict, bladerf_module module);
 
+  /* Open the device again by its serial number and set it up like init()
+   * did, after it dropped off the bus. Waits between failed attempts, the
+   * settings of the module have to be restored by the caller. */
+  bool reopen(bladerf_module module);
+
   bool start(bladerf_module module);
   bool stop(bladerf_module module);
 
@@ -80,6 +89,31 @@ protected:
 
   static std::vector< std::string > devices();
 
+  /* (Re)allocate the aligned conversion buffer to hold nsamples samples */
+  void alloc_conv_buf(size_t nsamples);
+
+  /* Hop over freqs by quick tunes scheduled against the timestamp counter,
+   * which requires enable_metadata. An empty plan stops hopping. */
+  bool set_hop_plan(bladerf_module module, const std::vector<double> &freqs,
+                    double dwell);
+  void stop_hopping();
+
+  /* Pop the next scheduled hop starting before timestamp end */
+  bool next_hop(uint64_t end, uint64_t &timestamp, double &freq);
+
+  /* With buffers=auto, size the sync buffers to hold _buffer_latency
+   * seconds at rate, each buffer filling in about AUTO_FILL_MS */
+  void derive_buffers(double rate);
+
+  /* Count an overrun or timeout. With buffers=auto, more than
+   * AUTO_MAX_ERRORS within AUTO_ERROR_WINDOW seconds double the buffered
+   * time and set _reconfigure, the caller then restarts the module with
+   * stop() and start() from its work(). */
+  void stream_error();
+
+  /* The sync buffer configuration added to msg, a published stats dict */
+  pmt::pmt_t buffer_stats(pmt::pmt_t msg);
+
   bladerf_sptr _dev;
 
   size_t _num_buffers;
@@ -87,6 +121,10 @@ protected:
   size_t _num_transfers;
   unsigned int _stream_timeout_ms;
 
+  bool _auto_buffers;           /* buffers=auto */
+  double _buffer_latency;       /* seconds buffered, buffer_ms= */
+  bool _reconfigure;            /* new buffers to apply by a restart */
+
   int16_t *_conv_buf;
   int _conv_buf_size; /* In units of samples */
 
@@ -96,10 +134,13 @@ protected:
   osmosdr::gain_range_t _vga2_range;
 
   std::string _pfx;
+  std::string _device_id; /* serial and versions, see get_device_id() */
 
   bool _xb_200_attached;
   unsigned int _consecutive_failures;
 
+  bool _reconnect; /* reopen the device instead of giving up, reconnect=true */
+
   /* BladeRF IQ correction parameters */
   static const int16_t DCOFF_SCALE  = 2048;
   static const int16_t GAIN_SCALE   = 4096;
@@ -107,14 +148,57 @@ protected:
 
   static const unsigned int MAX_CONSECUTIVE_FAILURES = 3;
 
+  /* Delay before reopening, doubled after each failed attempt */
+  static const unsigned int REOPEN_MIN_MS = 100;
+  static const unsigned int REOPEN_MAX_MS = 1000;
+
+  /* Scheduled retunes kept queued in the FPGA, which holds up to 16 */
+  static const unsigned int HOP_QUEUE = 8;
+
+  /* Limits of buffers=auto */
+  static const unsigned int AUTO_FILL_MS = 5;
+  static const unsigned int AUTO_BUFFER_MS = 30;     /* default */
+  static const unsigned int AUTO_MAX_BUFFER_MS = 1000;
+  static const size_t AUTO_MAX_BUFLEN = 64 * 1024;
+  static const size_t AUTO_MIN_BUFFERS = 4;
+  static const size_t AUTO_MAX_BUFFERS = 256;
+  static const unsigned int AUTO_MAX_ERRORS = 3;
+  static const unsigned int AUTO_ERROR_WINDOW = 10;
+
 private:
-  bladerf_sptr open(const std::string &device_name);
+  bladerf_sptr open(const std::string &device_name, bool cached = true);
+  void setup(dict_t &dict, bladerf_module module);
   static void close(void *dev); /* called by shared_ptr */
   static bladerf_sptr get_cached_device(struct bladerf_devinfo devinfo);
 
   void set_verbosity(const std::string &verbosity);
   void set_loopback_mode(const std::string &loopback);
 
+  void hop_task(double rate);
+
+#ifdef BLADERF_RETUNE_NOW
+  std::vector<struct bladerf_quick_tune> _hop_tunes;
+#endif
+  std::vector<double> _hop_freqs;   /* actual frequency of each hop */
+  bladerf_module _hop_module;
+  uint64_t _hop_ticks;              /* dwell in samples */
+  uint64_t _hop_lead;               /* minimum scheduling lead in samples */
+  uint64_t _hop_next;               /* timestamp of the next hop to schedule */
+  size_t _hop_index;
+  std::deque< std::pair<uint64_t, double> > _hops; /* scheduled, rx only */
+
+  boost::mutex _hop_mutex;
+  boost::condition_variable _hop_cond;
+  bool _hopping;
+  gr::thread::thread _hop_thread;
+
+  unsigned int _stream_errors;          /* within the window, buffers=auto */
+  gr::high_res_timer_type _error_stamp; /* of the first of them */
+
+  dict_t _args;            /* as given to init(), for reopen() */
+  std::string _serial;
+  unsigned int _reopen_delay_ms;
+
   static boost::mutex _devs_mutex;
   static std::list<boost::weak_ptr<struct bladerf> > _devs;
 };
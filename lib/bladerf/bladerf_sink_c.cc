@@ -31,6 +31,7 @@
 #include <iostream>
 
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -40,6 +41,8 @@
 
 #include "arg_helpers.h"
 #include "bladerf_sink_c.h"
+#include "backend_registry.h"
+#include "stream_tags.h"
 
 //#define DEBUG_BLADERF_SINK
 #ifdef DEBUG_BLADERF_SINK
@@ -59,6 +62,12 @@ bladerf_sink_c_sptr make_bladerf_sink_c (const std::string &args)
   return gnuradio::get_initial_sptr(new bladerf_sink_c (args));
 }
 
+static sink_registrar bladerf_registrar(
+  "bladerf",
+  &make_backend< sink_iface, bladerf_sink_c_sptr, &make_bladerf_sink_c >,
+  &ignore_fake< &bladerf_sink_c::get_devices >,
+  BACKEND_HARDWARE, 70 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -79,13 +88,19 @@ static const int MAX_OUT = 0;  // maximum number of output streams
 bladerf_sink_c::bladerf_sink_c (const std::string &args)
   : gr::sync_block ("bladerf_sink_c",
                     gr::io_signature::make (MIN_IN, MAX_IN, sizeof (gr_complex)),
-                    gr::io_signature::make (MIN_OUT, MAX_OUT, sizeof (gr_complex)))
+                    gr::io_signature::make (MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _keepalive(_stats),
+    _convert(2000.0f, 2047.0f)
 {
   dict_t dict = params_to_dict(args);
 
   /* Perform src/sink agnostic initializations */
   init(dict, BLADERF_MODULE_TX);
 
+  _underrun = tx_underrun_params(dict);
+
+  message_port_register_out( STREAM_STATS_PORT );
+
   /* Set the range of VGA1, VGA1GAINT[7:0] */
   _vga1_range = osmosdr::gain_range_t( -35, -4, 1 );
 
@@ -97,16 +112,48 @@ bladerf_sink_c::bladerf_sink_c (const std::string &args)
 bool bladerf_sink_c::start()
 {
   _in_burst = false;
-  return bladerf_common::start(BLADERF_MODULE_TX);
+
+  if (max_noutput_items() > _conv_buf_size)
+    alloc_conv_buf(max_noutput_items());
+
+  if (!bladerf_common::start(BLADERF_MODULE_TX))
+    return false;
+
+  // bursts end with zeros already, only continuous streams are filled in
+  if (!_use_metadata) {
+    const double rate = get_sample_rate();
+
+    _keepalive.start(_underrun, boost::bind(&bladerf_sink_c::sync_tx, this, _1, _2),
+                     1, 2 * sizeof(int16_t), _samples_per_buffer, rate,
+                     _num_buffers * _samples_per_buffer / rate);
+  }
+
+  return true;
 }
 
 bool bladerf_sink_c::stop()
 {
+  _keepalive.stop();
+
   return bladerf_common::stop(BLADERF_MODULE_TX);
 }
 
+int bladerf_sink_c::sync_tx(const void * const *buffs, size_t count)
+{
+  int ret = bladerf_sync_tx(_dev.get(), const_cast<void *>(buffs[0]),
+                            count, NULL, _stream_timeout_ms);
+
+  return ret == 0 ? int(count) : ret;
+}
+
 #define INVALID_IDX -1
 
+/* whether the burst being assembled starts at sample idx of this call */
+static bool started_at(const struct bladerf_metadata &meta, int start_idx, int idx)
+{
+  return (meta.flags & BLADERF_META_FLAG_TX_BURST_START) && start_idx == idx;
+}
+
 int bladerf_sink_c::transmit_with_tags(int noutput_items)
 {
   int count = 0;
@@ -151,11 +198,40 @@ int bladerf_sink_c::transmit_with_tags(int noutput_items)
 
   BOOST_FOREACH( gr::tag_t tag, tags) {
 
+    // A tx_time tag schedules the burst starting at its offset, with or
+    // without a tx_sob tag next to it.
+    if (pmt::eq(tag.key, TX_TIME_KEY)) {
+      const int idx = static_cast<int>(tag.offset - nitems_read(0));
+
+      if (_in_burst && !started_at(meta, start_idx, idx)) {
+        std::cerr << _pfx << "Got tx_time within a burst" << std::endl;
+        return BLADERF_ERR_INVAL;
+      }
+
+      const osmosdr::time_spec_t time(
+            pmt::to_uint64(pmt::tuple_ref(tag.value, 0)),
+            pmt::to_double(pmt::tuple_ref(tag.value, 1)));
+
+      // the timestamp counter runs at the sample rate
+      meta.timestamp = time.to_ticks(get_sample_rate());
+      meta.flags &= ~BLADERF_META_FLAG_TX_NOW;
+      meta.flags |= BLADERF_META_FLAG_TX_BURST_START;
+      DBG("Got tx_time " << idx << " samples into work payload, timestamp "
+          << meta.timestamp);
+
+      start_idx = idx;
+      _in_burst = true;
+      continue;
+    }
+
     // Upon seeing an SOB tag, update our offset. We'll TX the start of the
     // burst when we see an EOB or at the end of this function - whichever
     // occurs first.
     if (pmt::symbol_to_string(tag.key) == "tx_sob") {
-      if (_in_burst) {
+      if (_in_burst && started_at(meta, start_idx,
+                                  static_cast<int>(tag.offset - nitems_read(0)))) {
+        continue; // the tx_time tag of the same sample started it
+      } else if (_in_burst) {
         std::cerr << ("Got SOB while already within a burst");
         return BLADERF_ERR_INVAL;
       } else {
@@ -212,6 +288,7 @@ int bladerf_sink_c::transmit_with_tags(int noutput_items)
       start_idx = INVALID_IDX;
       end_idx = (noutput_items - 1);
       meta.flags = 0;
+      meta.timestamp = 0;
       _in_burst = false;
 
       if (status != 0) {
@@ -240,42 +317,38 @@ int bladerf_sink_c::work( int noutput_items,
                           gr_vector_void_star &output_items )
 {
   const gr_complex *in = (const gr_complex *) input_items[0];
-  const float scaling = 2000.0f;
   int ret;
 
-  if (noutput_items > _conv_buf_size) {
-    void *tmp;
-
-    _conv_buf_size = noutput_items;
-    tmp = realloc(_conv_buf, _conv_buf_size * 2 * sizeof(int16_t));
-    if (tmp == NULL) {
-      throw std::runtime_error( std::string(__FUNCTION__) +
-                                "Failed to realloc _conv_buf" );
-    } else {
-      DBG("Resized _conv_buf to " << _conv_buf_size << " samples");
-    }
+  /* apply the sync buffers derived anew with buffers=auto */
+  if (_reconfigure) {
+    stop();
+    start();
+  }
 
-    _conv_buf = static_cast<int16_t*>(tmp);
+  if (noutput_items > _conv_buf_size) {
+    alloc_conv_buf(noutput_items);
+    DBG("Resized _conv_buf to " << _conv_buf_size << " samples");
   }
 
   /* Convert floating point samples into fixed point */
-  for (int i = 0; i < 2 * noutput_items;) {
-    _conv_buf[i++] = (int16_t)(scaling * real(*in));
-    _conv_buf[i++] = (int16_t)(scaling * imag(*in++));
-  }
+  _convert(in, _conv_buf, noutput_items);
 
   if (_use_metadata) {
     ret = transmit_with_tags(noutput_items);
   } else {
-    ret = bladerf_sync_tx(_dev.get(), static_cast<void *>(_conv_buf),
-                          noutput_items, NULL, _stream_timeout_ms);
+    const void *buf = _conv_buf;
+    ret = _keepalive.write(&buf, noutput_items);
+    ret = ret < 0 ? ret : 0;
   }
 
   if ( ret != 0 ) {
     std::cerr << _pfx << "bladerf_sync_tx error: "
               << bladerf_strerror(ret) << std::endl;
 
+    _stats.overflow( noutput_items ); /* never transmitted */
+
     _consecutive_failures++;
+    stream_error();
 
     if ( _consecutive_failures >= MAX_CONSECUTIVE_FAILURES ) {
         noutput_items = WORK_DONE;
@@ -287,6 +360,12 @@ int bladerf_sink_c::work( int noutput_items,
     _consecutive_failures = 0;
   }
 
+  /* libbladeRF doesn't tell how many of its buffers are queued */
+  _stats.capacity( _num_buffers * _samples_per_buffer );
+
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, buffer_stats( _stats.to_pmt() ) );
+
   return noutput_items;
 }
 
@@ -331,6 +410,8 @@ double bladerf_sink_c::set_center_freq( double freq, size_t chan )
       freq > get_freq_range( chan ).stop() ) {
     std::cerr << "Failed to set out of bound frequency: " << freq << std::endl;
   } else {
+    stop_hopping();
+
     ret = bladerf_set_frequency( _dev.get(), BLADERF_MODULE_TX, (uint32_t)freq );
     if( ret ) {
       throw std::runtime_error( std::string(__FUNCTION__) + " " +
@@ -343,6 +424,12 @@ double bladerf_sink_c::set_center_freq( double freq, size_t chan )
   return get_center_freq( chan );
 }
 
+bool bladerf_sink_c::set_hop_plan( const std::vector< double > &freqs,
+                                 double dwell, size_t chan )
+{
+  return bladerf_common::set_hop_plan( BLADERF_MODULE_TX, freqs, dwell );
+}
+
 double bladerf_sink_c::get_center_freq( size_t chan )
 {
   uint32_t freq;
@@ -580,3 +667,8 @@ std::vector<std::string> bladerf_sink_c::get_clock_sources(const size_t mboard)
 {
   return bladerf_common::get_clock_sources(mboard);
 }
+
+osmosdr::stream_stats_t bladerf_sink_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
@@ -28,6 +28,8 @@
 #include "osmosdr/ranges.h"
 #include "sink_iface.h"
 #include "bladerf_common.h"
+#include "stream_stats.h"
+#include "tx_underrun.h"
 
 class bladerf_sink_c;
 
@@ -71,8 +73,18 @@ private:
   // Returns bladeRF error code
   int transmit_with_tags(int noutput_items);
 
+  // bladerf_sync_tx() without metadata, as a tx_keepalive::write_t
+  int sync_tx(const void * const *buffs, size_t count);
+
   bool _in_burst;
 
+  stream_stats _stats;
+  tx_underrun_params _underrun;
+  tx_keepalive _keepalive; /* continuous streams, without metadata */
+
+  /* Saturates to the SC16 Q11 range instead of wrapping around */
+  convert_to_16bit _convert;
+
 public:
   bool start();
   bool stop();
@@ -91,6 +103,7 @@ public:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  bool set_hop_plan( const std::vector< double > &freqs, double dwell, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -121,6 +134,8 @@ public:
   void set_clock_source(const std::string &source, const size_t mboard = 0);
   std::string get_clock_source(const size_t mboard);
   std::vector<std::string> get_clock_sources(const size_t mboard);
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
 };
 
 #endif /* INCLUDED_BLADERF_SINK_C_H */
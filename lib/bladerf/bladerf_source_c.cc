@@ -37,7 +37,9 @@
 #include <gnuradio/io_signature.h>
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
 #include "bladerf_source_c.h"
+#include "backend_registry.h"
 #include "osmosdr/source.h"
 
 using namespace boost::assign;
@@ -51,6 +53,12 @@ bladerf_source_c_sptr make_bladerf_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new bladerf_source_c (args));
 }
 
+static source_registrar bladerf_registrar(
+  "bladerf",
+  &make_backend< source_iface, bladerf_source_c_sptr, &make_bladerf_source_c >,
+  &ignore_fake< &bladerf_source_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_HW_CORRECTION, 70 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -71,7 +79,17 @@ static const int MAX_OUT = 1;	// maximum number of output streams
 bladerf_source_c::bladerf_source_c (const std::string &args)
   : gr::sync_block ("bladerf_source_c",
                     gr::io_signature::make (MIN_IN, MAX_IN, sizeof (gr_complex)),
-                    gr::io_signature::make (MIN_OUT, MAX_OUT, sizeof (gr_complex)))
+                    gr::io_signature::make (MIN_OUT, MAX_OUT, args_to_item_size(args, "sc16"))),
+    _sc16(args_to_item_size(args, "sc16") != sizeof (gr_complex)),
+    _convert(1.0f / 2048.0f),
+    _converters(params_to_dict(args)),
+    _tag_now(true),
+    _next_timestamp(0),
+    _rate(0),
+    _freq(0),
+    _bandwidth(0),
+    _bandwidth_set(false),
+    _resumed(false)
 {
   int ret;
   std::string device_name;
@@ -101,6 +119,8 @@ bladerf_source_c::bladerf_source_c (const std::string &args)
     }
   }
 
+  message_port_register_out( STREAM_STATS_PORT );
+
   /* Set the range of LNA, G_LNA_RXFE[1:0] */
   _lna_range = osmosdr::gain_range_t( 0, 6, 3 );
 
@@ -126,6 +146,12 @@ bladerf_source_c::bladerf_source_c (const std::string &args)
 
 bool bladerf_source_c::start()
 {
+  if (max_noutput_items() > _conv_buf_size)
+    alloc_conv_buf(max_noutput_items());
+
+  _tag_now = true;
+  _pause.started();
+
   return bladerf_common::start(BLADERF_MODULE_RX);
 }
 
@@ -140,40 +166,66 @@ int bladerf_source_c::work( int noutput_items,
 {
   int ret;
   int16_t *current;
-  const float scaling = 1.0f / 2048.0f;
   gr_complex *out = static_cast<gr_complex *>(output_items[0]);
   struct bladerf_metadata meta;
   struct bladerf_metadata *meta_ptr = NULL;
 
-  if (noutput_items > _conv_buf_size) {
-    void *tmp;
+  /* stopping and restarting the stream here can't race with us */
+  switch ( _pause.poll() ) {
+  case stream_pause::PAUSE:
+    bladerf_common::stop(BLADERF_MODULE_RX);
+    break;
+  case stream_pause::RESUME:
+    bladerf_common::start(BLADERF_MODULE_RX);
+    _tag_now = true;
+    _resumed = true;
+    break;
+  default:
+    break;
+  }
 
-    _conv_buf_size = noutput_items;
-    tmp = realloc(_conv_buf, _conv_buf_size * 2 * sizeof(int16_t));
-    if (tmp == NULL) {
-      throw std::runtime_error( std::string(__FUNCTION__) +
-                                "Failed to realloc _conv_buf" );
-    }
+  if ( _pause.paused() ) {
+    _pause.wait();
+    return 0;
+  }
 
-    _conv_buf = static_cast<int16_t*>(tmp);
+  /* apply the sync buffers derived anew with buffers=auto */
+  if (_reconfigure) {
+    bladerf_common::stop(BLADERF_MODULE_RX);
+    bladerf_common::start(BLADERF_MODULE_RX);
+    _tag_now = true;
   }
 
+  /* don't wait for the stream timeout of a device known to be gone */
+  if (_reconnect && _consecutive_failures >= MAX_CONSECUTIVE_FAILURES)
+    return recover();
+
+  if (!_sc16 && noutput_items > _conv_buf_size)
+    alloc_conv_buf(noutput_items);
+
   if (_use_metadata) {
     memset(&meta, 0, sizeof(meta));
     meta.flags = BLADERF_META_FLAG_RX_NOW;
     meta_ptr = &meta;
   }
 
-  /* Grab all the samples into the temporary buffer */
-  ret = bladerf_sync_rx(_dev.get(), static_cast<void *>(_conv_buf),
+  /* Grab all the samples into the temporary buffer, or straight into the
+   * output buffer when delivering native samples */
+  current = _sc16 ? static_cast<int16_t *>(output_items[0]) : _conv_buf;
+
+  ret = bladerf_sync_rx(_dev.get(), static_cast<void *>(current),
                         noutput_items, meta_ptr, _stream_timeout_ms);
   if ( ret != 0 ) {
     std::cerr << _pfx << "bladerf_sync_rx error: "
               << bladerf_strerror(ret) << std::endl;
 
     _consecutive_failures++;
+    stream_error();
 
     if ( _consecutive_failures >= MAX_CONSECUTIVE_FAILURES ) {
+        if ( _reconnect )
+          return recover();
+
         std::cerr << _pfx
                   << "Consecutive error limit hit. Shutting down."
                   << std::endl;
@@ -181,24 +233,125 @@ int bladerf_source_c::work( int noutput_items,
     }
   } else {
       _consecutive_failures = 0;
+
+      if (_resumed && !_use_metadata) {
+        /* without timestamps at least mark where the stream resumed */
+        add_item_tag(0, nitems_written(0), RX_RATE_KEY,
+                     pmt::from_double(get_sample_rate()),
+                     pmt::string_to_symbol(alias()));
+        add_item_tag(0, nitems_written(0), RX_FREQ_KEY,
+                     pmt::from_double(get_center_freq()),
+                     pmt::string_to_symbol(alias()));
+      }
+
+      _resumed = false;
+
+      if (_use_metadata) {
+        /* The timestamp counter runs at the sample rate, so any gap in it
+         * is a discontinuity of the sample stream */
+        if ((meta.status & BLADERF_META_STATUS_OVERRUN) ||
+            meta.timestamp != _next_timestamp) {
+          if (!_tag_now) { /* not just (re)started */
+            _stats.overflow(meta.timestamp > _next_timestamp ?
+                            meta.timestamp - _next_timestamp : 0);
+            stream_error();
+          }
+
+          _tag_now = true;
+        }
+
+        if (_tag_now) {
+          const double rate = get_sample_rate();
+
+          BOOST_FOREACH( const gr::tag_t &tag,
+                         make_rx_tags( nitems_written(0),
+                                       osmosdr::time_spec_t::from_ticks( meta.timestamp, rate ),
+                                       rate, get_center_freq(), alias() ) )
+            add_item_tag(0, tag);
+
+          _tag_now = false;
+        }
+
+        /* Tag the first sample of each hop done by the device */
+        uint64_t hop;
+        double hop_freq;
+
+        while (next_hop(meta.timestamp + noutput_items, hop, hop_freq)) {
+          if (hop < meta.timestamp)
+            continue; /* lost in an overrun */
+
+          add_item_tag(0, nitems_written(0) + (hop - meta.timestamp),
+                       RX_FREQ_KEY, pmt::from_double(hop_freq),
+                       pmt::string_to_symbol(alias()));
+        }
+
+        _next_timestamp = meta.timestamp + noutput_items;
+      }
   }
 
-  current = _conv_buf;
+  /* libbladeRF doesn't tell how many of its buffers are filled */
+  _stats.capacity(_num_buffers * _samples_per_buffer);
+
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, buffer_stats( _stats.to_pmt() ) );
+
+  if (_sc16) {
+    /* Scale SC16 Q11 up to the full 16 bit range */
+    for (int i = 0; i < 2 * noutput_items; ++i)
+      current[i] = (int16_t)(current[i] * 16);
+
+    return noutput_items;
+  }
 
   /* Convert them from fixed to floating point */
-  for (int i = 0; i < noutput_items; ++i) {
-    float x, y;
+  _converters.convert(_convert, current, out, noutput_items);
 
-    x = scaling * *current;
-    current++;
+  return noutput_items;
+}
 
-    y = scaling * *current;
-    current++;
+/*
+ * Reopen the device which dropped off the bus, one attempt per call so the
+ * scheduler may still stop the flowgraph meanwhile. Nothing is produced
+ * until the device is back, the samples afterwards are tagged like after
+ * an overrun.
+ */
+int bladerf_source_c::recover()
+{
+  if ( ! reopen(BLADERF_MODULE_RX) )
+    return 0;
 
-    out[i] = gr_complex(x, y) ;
+  try {
+    restore_settings();
+  } catch ( std::exception &ex ) {
+    std::cerr << _pfx << "Failed to restore the settings: " << ex.what()
+              << std::endl;
   }
 
-  return noutput_items;
+  if ( ! bladerf_common::start(BLADERF_MODULE_RX) ) {
+    _consecutive_failures = MAX_CONSECUTIVE_FAILURES; /* try again */
+    return 0;
+  }
+
+  _tag_now = true;
+  _resumed = true;
+
+  return 0;
+}
+
+void bladerf_source_c::restore_settings()
+{
+  if ( _rate > 0 )
+    set_sample_rate( _rate );
+
+  if ( _freq > 0 )
+    set_center_freq( _freq );
+
+  std::map< std::string, double >::const_iterator it;
+  for ( it = _gains.begin(); it != _gains.end(); ++it )
+    set_gain( it->second, it->first );
+
+  if ( _bandwidth_set )
+    set_bandwidth( _bandwidth );
 }
 
 std::vector<std::string> bladerf_source_c::get_devices()
@@ -212,6 +365,11 @@ size_t bladerf_source_c::get_num_channels()
   return 1;
 }
 
+std::string bladerf_source_c::get_device_id()
+{
+  return _device_id;
+}
+
 osmosdr::meta_range_t bladerf_source_c::get_sample_rates()
 {
   return sample_rates();
@@ -219,6 +377,8 @@ osmosdr::meta_range_t bladerf_source_c::get_sample_rates()
 
 double bladerf_source_c::set_sample_rate( double rate )
 {
+  _tag_now = true;
+  _rate = rate;
   return bladerf_common::set_sample_rate( BLADERF_MODULE_RX, rate);
 }
 
@@ -241,6 +401,8 @@ double bladerf_source_c::set_center_freq( double freq, size_t chan )
       freq > get_freq_range( chan ).stop() ) {
     std::cerr << "Failed to set out of bound frequency: " << freq << std::endl;
   } else {
+    stop_hopping();
+
     ret = bladerf_set_frequency( _dev.get(), BLADERF_MODULE_RX, (uint32_t)freq );
     if( ret ) {
       throw std::runtime_error( std::string(__FUNCTION__) + " " +
@@ -248,11 +410,20 @@ double bladerf_source_c::set_center_freq( double freq, size_t chan )
                                 boost::lexical_cast<std::string>(freq) + ": " +
                                 std::string(bladerf_strerror(ret)) );
     }
+
+    _freq = freq;
+    _tag_now = true;
   }
 
   return get_center_freq( chan );
 }
 
+bool bladerf_source_c::set_hop_plan( const std::vector< double > &freqs,
+                                   double dwell, size_t chan )
+{
+  return bladerf_common::set_hop_plan( BLADERF_MODULE_RX, freqs, dwell );
+}
+
 double bladerf_source_c::get_center_freq( size_t chan )
 {
   uint32_t freq;
@@ -364,6 +535,8 @@ double bladerf_source_c::set_gain( double gain, const std::string & name, size_t
                               std::string(bladerf_strerror(ret)) );
   }
 
+  _gains[name] = gain;
+
   return get_gain( name, chan );
 }
 
@@ -515,6 +688,9 @@ double bladerf_source_c::set_bandwidth( double bandwidth, size_t chan )
                               std::string(bladerf_strerror(ret)) );
   }
 
+  _bandwidth = bandwidth;
+  _bandwidth_set = true;
+
   return get_bandwidth();
 }
 
@@ -552,3 +728,31 @@ std::vector<std::string> bladerf_source_c::get_clock_sources(const size_t mboard
 {
   return bladerf_common::get_clock_sources(mboard);
 }
+
+osmosdr::time_spec_t bladerf_source_c::get_time_now(size_t mboard)
+{
+  int ret;
+  uint64_t timestamp;
+
+  ret = bladerf_get_timestamp( _dev.get(), BLADERF_MODULE_RX, &timestamp );
+  if ( ret != 0 ) {
+    throw std::runtime_error( std::string(__FUNCTION__) + " " +
+                              "failed to read the timestamp counter: " +
+                              std::string(bladerf_strerror(ret)) );
+  }
+
+  /* on the same time base as the rx_time tags */
+  return osmosdr::time_spec_t::from_ticks( timestamp, get_sample_rate() );
+}
+
+osmosdr::stream_stats_t bladerf_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
+
+bool bladerf_source_c::set_streaming( bool streaming )
+{
+  _pause.request( streaming ); /* carried out by work() */
+
+  return true;
+}
@@ -21,6 +21,8 @@
 #ifndef INCLUDED_BLADERF_SOURCE_C_H
 #define INCLUDED_BLADERF_SOURCE_C_H
 
+#include <map>
+
 #include <gnuradio/thread/thread.h>
 #include <gnuradio/block.h>
 #include <gnuradio/sync_block.h>
@@ -28,6 +30,9 @@
 #include "osmosdr/ranges.h"
 #include "source_iface.h"
 #include "bladerf_common.h"
+#include "convert_pool.h"
+#include "stream_pause.h"
+#include "stream_stats.h"
 
 class bladerf_source_c;
 
@@ -76,6 +81,7 @@ public:
   static std::vector< std::string > get_devices();
 
   size_t get_num_channels( void );
+  std::string get_device_id( void );
 
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
@@ -83,6 +89,7 @@ public:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  bool set_hop_plan( const std::vector< double > &freqs, double dwell, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -117,8 +124,34 @@ public:
   std::string get_clock_source(const size_t mboard);
   std::vector<std::string> get_clock_sources(const size_t mboard);
 
+  osmosdr::time_spec_t get_time_now(size_t mboard = 0);
+
+  bool set_streaming( bool streaming );
+
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
+  int recover();
+  void restore_settings();
+
   osmosdr::gain_range_t _lna_range;
+  bool _sc16; /* deliver native 16 bit samples, see cpu_format */
+  convert_16bit _convert;
+  convert_pool _converters; /* convert_threads= */
+
+  /* rx_time tagging state, requires enable_metadata */
+  bool _tag_now;
+  uint64_t _next_timestamp;
+
+  /* the settings restored after reopening the device, see reconnect */
+  double _rate, _freq, _bandwidth;
+  bool _bandwidth_set;
+  std::map< std::string, double > _gains;
+
+  stream_pause _pause;
+  bool _resumed; /* tag the first samples after reopening or resuming */
+
+  stream_stats _stats;
 };
 
 #endif /* INCLUDED_BLADERF_SOURCE_C_H */
@@ -0,0 +1,172 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "buffer_pool.h"
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define CACHE_LINE     64
+
+#define MPOL_BIND_ 2 /* <numaif.h>, not installed without libnuma */
+
+buffer_pool_params::buffer_pool_params( const dict_t &dict )
+  : hugepages(true), lock(false), numa_node(-1)
+{
+  dict_t::const_iterator it;
+
+  if ( (it = dict.find( "hugepages" )) != dict.end() )
+    hugepages = ( "true" == it->second ? true : false );
+
+  if ( (it = dict.find( "mlock" )) != dict.end() )
+    lock = ( "true" == it->second ? true : false );
+
+  if ( (it = dict.find( "numa_node" )) != dict.end() )
+    numa_node = boost::lexical_cast< int >( it->second );
+}
+
+static size_t round_up( size_t size, size_t align )
+{
+  return (size + align - 1) / align * align;
+}
+
+void *buffer_pool::alloc( size_t size, const buffer_pool_params &params )
+{
+  release();
+
+  if ( ! size )
+    return NULL;
+
+#ifdef __linux__
+  _size = params.hugepages ? round_up( size, HUGE_PAGE_SIZE ) : round_up( size, getpagesize() );
+
+#ifdef MAP_HUGETLB
+  /* reserved huge pages, only if the administrator set some aside */
+  if ( params.hugepages ) {
+    void *ptr = mmap( NULL, _size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+    if ( MAP_FAILED != ptr ) {
+      _base = ptr;
+      _mapped = true;
+    }
+  }
+#endif
+
+  if ( ! _base ) {
+    if ( posix_memalign( &_base, params.hugepages ? HUGE_PAGE_SIZE : getpagesize(), _size ) )
+      _base = NULL;
+#ifdef MADV_HUGEPAGE
+    else if ( params.hugepages )
+      madvise( _base, _size, MADV_HUGEPAGE );
+#endif
+  }
+
+  if ( ! _base ) {
+    _size = 0;
+    return NULL;
+  }
+
+  /* before the first touch, which decides where the pages go otherwise */
+  if ( params.numa_node >= 0 ) {
+#ifdef SYS_mbind
+    unsigned long mask[4] = { 0 };
+
+    if ( params.numa_node < int(sizeof(mask) * 8) ) {
+      mask[params.numa_node / (sizeof(long) * 8)] = 1UL << (params.numa_node % (sizeof(long) * 8));
+
+      if ( syscall( SYS_mbind, _base, _size, MPOL_BIND_, mask, sizeof(mask) * 8, 0 ) < 0 )
+        std::cerr << "Failed to bind the sample buffers to NUMA node "
+                  << params.numa_node << ": " << strerror( errno ) << std::endl;
+    }
+#else
+    std::cerr << "NUMA binding is not supported on this platform." << std::endl;
+#endif
+  }
+
+  if ( params.lock ) {
+    _locked = ( 0 == mlock( _base, _size ) );
+    if ( ! _locked )
+      std::cerr << "Failed to lock the sample buffers: " << strerror( errno )
+                << ", check RLIMIT_MEMLOCK." << std::endl;
+  }
+
+  memset( _base, 0, _size ); /* fault the pages in now */
+#else
+  _size = round_up( size, CACHE_LINE );
+
+#ifdef _WIN32
+  _base = _aligned_malloc( _size, CACHE_LINE );
+#else
+  if ( posix_memalign( &_base, CACHE_LINE, _size ) )
+    _base = NULL;
+#endif
+
+  if ( ! _base ) {
+    _size = 0;
+    return NULL;
+  }
+
+  if ( params.numa_node >= 0 || params.lock )
+    std::cerr << "numa_node and mlock are not supported on this platform." << std::endl;
+#endif
+
+  return _base;
+}
+
+void buffer_pool::release()
+{
+  if ( ! _base )
+    return;
+
+#ifdef __linux__
+  if ( _locked )
+    munlock( _base, _size );
+
+  if ( _mapped )
+    munmap( _base, _size );
+  else
+    free( _base );
+#elif defined(_WIN32)
+  _aligned_free( _base );
+#else
+  free( _base );
+#endif
+
+  _base = NULL;
+  _size = 0;
+  _mapped = _locked = false;
+}
@@ -0,0 +1,82 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_BUFFER_POOL_H
+#define OSMOSDR_BUFFER_POOL_H
+
+#include <cstddef>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * Placement of the transfer buffers of a driver, given by the device
+ * arguments:
+ *
+ *   hugepages=true|false  back the buffers with huge pages, from the
+ *                         hugetlbfs pool if reserved, else advising
+ *                         transparent huge pages (default true)
+ *   mlock=true|false      lock the buffers into memory (default false)
+ *   numa_node=N           bind the buffers to NUMA node N, the one of the
+ *                         cores running the consumer (default: first touch)
+ */
+struct OSMOSDR_API buffer_pool_params
+{
+  buffer_pool_params() : hugepages(true), lock(false), numa_node(-1) {}
+
+  explicit buffer_pool_params( const dict_t &dict );
+
+  bool hugepages;
+  bool lock;
+  int numa_node;
+};
+
+/*!
+ * \brief A single region all buffers of a driver are carved from.
+ *
+ * One mapping instead of a malloc() per buffer keeps the buffers on few
+ * (huge) pages, so streaming through them at high rates doesn't thrash the
+ * TLB. The pages are faulted in up front, the usb callback never takes a
+ * page fault.
+ */
+class OSMOSDR_API buffer_pool
+{
+public:
+  buffer_pool() : _base(NULL), _size(0), _mapped(false), _locked(false) {}
+  ~buffer_pool() { release(); }
+
+  /*!
+   * Allocate \p size bytes, aligned to a cache line at least.
+   * \return NULL if out of memory
+   */
+  void *alloc( size_t size, const buffer_pool_params &params );
+  void release();
+
+private:
+  buffer_pool( const buffer_pool & );
+  buffer_pool &operator=( const buffer_pool & );
+
+  void *_base;
+  size_t _size;
+  bool _mapped; /* by mmap(), else by posix_memalign() */
+  bool _locked;
+};
+
+#endif // OSMOSDR_BUFFER_POOL_H
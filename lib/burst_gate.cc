@@ -0,0 +1,86 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <gnuradio/io_signature.h>
+
+#include "burst_gate.h"
+
+burst_gate_sptr make_burst_gate( size_t itemsize, double duty, size_t burst_len )
+{
+  return gnuradio::get_initial_sptr( new burst_gate( itemsize, duty, burst_len ) );
+}
+
+burst_gate::burst_gate( size_t itemsize, double duty, size_t burst_len ) :
+  gr::block("burst_gate",
+            gr::io_signature::make(1, 1, itemsize),
+            gr::io_signature::make(1, 1, itemsize)),
+  _itemsize(itemsize),
+  _burst_len(burst_len),
+  _period(std::max( burst_len, size_t( ceil( burst_len / std::max( duty, 1e-6 ) ) ) )),
+  _position(0)
+{
+  set_relative_rate( double(_burst_len) / _period );
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+int burst_gate::general_work( int noutput_items,
+                              gr_vector_int &ninput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  const char *in = (const char *) input_items[0];
+  char *out = (char *) output_items[0];
+
+  const size_t ninput = ninput_items[0];
+  size_t consumed = 0;
+  size_t produced = 0;
+
+  while ( consumed < ninput ) {
+    size_t n;
+
+    if ( _position < _burst_len ) {
+      n = std::min( std::min( _burst_len - _position, ninput - consumed ),
+                    size_t( noutput_items ) - produced );
+      if ( ! n )
+        break; /* no room for the rest of the burst */
+
+      memcpy( out + produced * _itemsize, in + consumed * _itemsize, n * _itemsize );
+      produced += n;
+    } else { /* between the bursts */
+      n = std::min( _period - _position, ninput - consumed );
+    }
+
+    consumed += n;
+    _position = (_position + n) % _period;
+  }
+
+  consume_each( consumed );
+
+  return produced;
+}
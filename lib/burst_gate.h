@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_BURST_GATE_H
+#define OSMOSDR_BURST_GATE_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <gnuradio/block.h>
+
+class burst_gate;
+
+typedef boost::shared_ptr< burst_gate > burst_gate_sptr;
+
+burst_gate_sptr make_burst_gate( size_t itemsize, double duty,
+                                 size_t burst_len = 8192 );
+
+/*!
+ * \brief Passes contiguous bursts of \p burst_len items, \p duty of the time.
+ *
+ * Feeds statistical estimators which don't need to see every sample, like
+ * the gr-iqbalance optimizer, while keeping the bursts themselves intact
+ * for their FFTs. Everything between the bursts is consumed and dropped.
+ */
+class burst_gate : public gr::block
+{
+private:
+  friend burst_gate_sptr make_burst_gate( size_t itemsize, double duty,
+                                          size_t burst_len );
+
+  burst_gate( size_t itemsize, double duty, size_t burst_len );
+
+public:
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  size_t _itemsize;
+  size_t _burst_len;
+  size_t _period;   /* items from the start of one burst to the next */
+  size_t _position; /* within the current period */
+};
+
+#endif // OSMOSDR_BURST_GATE_H
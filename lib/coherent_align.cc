@@ -0,0 +1,354 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "coherent_align.h"
+#include "stream_tags.h"
+
+#define INTERP_TAPS   16
+#define INTERP_DELAY  (INTERP_TAPS / 2 - 1)
+#define CAL_SETTLE    0.01 /* seconds the tuners get to settle after a retune */
+#define MIN_COHERENCE 0.2  /* of a channel with the first, to be calibrated */
+
+coherent_align_sptr make_coherent_align( size_t cal_len, double interval,
+                                         double sample_rate )
+{
+  return gnuradio::get_initial_sptr(
+    new coherent_align( cal_len, interval, sample_rate ) );
+}
+
+coherent_align::coherent_align( size_t cal_len, double interval, double sample_rate ) :
+  gr::block( "coherent_align",
+             gr::io_signature::make( 1, -1, sizeof(gr_complex) ),
+             gr::io_signature::make( 1, -1, sizeof(gr_complex) ) ),
+  _nchan( 0 ),
+  _cal_len( std::max( cal_len, size_t(1024) ) ),
+  _interval( interval ),
+  _rate( sample_rate ),
+  _collected( 0 ),
+  _armed( true ),
+  _wait( 0 ),
+  _fwd( 2 * _cal_len, true ),
+  _inv( 2 * _cal_len, false ),
+  _ref( 2 * _cal_len )
+{
+  _wait = samples( CAL_SETTLE );
+
+  /* the tags are moved along with the dropped samples */
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+void coherent_align::set_sample_rate( double sample_rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _rate = sample_rate;
+}
+
+uint64_t coherent_align::samples( double seconds )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _rate > 0 ? uint64_t( seconds * _rate ) : 0;
+}
+
+bool coherent_align::check_topology( int ninputs, int noutputs )
+{
+  if ( ninputs != noutputs )
+    return false;
+
+  _nchan = ninputs;
+
+  _cal.assign( _nchan, std::vector< gr_complex >( _cal_len ) );
+  _frac.assign( _nchan, 0.0 );
+  _drop.assign( _nchan, 0 );
+  _taps.assign( _nchan, std::vector< float >( INTERP_TAPS ) );
+  _rot.assign( _nchan, gr_complex( 1.0f, 0.0f ) );
+  _warned.assign( _nchan, false );
+
+  for ( size_t i = 0; i < _nchan; i++ )
+    design( i );
+
+  return true;
+}
+
+/* Blackman windowed sinc, interpolating INTERP_DELAY + _frac[chan] samples
+ * ahead of the oldest tap. */
+void coherent_align::design( size_t chan )
+{
+  std::vector< float > &taps = _taps[chan];
+  const double half = INTERP_TAPS / 2;
+  double sum = 0;
+
+  for ( size_t j = 0; j < INTERP_TAPS; j++ ) {
+    const double t = double(j) - INTERP_DELAY - _frac[chan];
+
+    const double sinc = t == 0 ? 1.0 : sin( M_PI * t ) / (M_PI * t);
+    const double window = std::abs( t ) >= half ? 0.0 :
+      0.42 + 0.5 * cos( M_PI * t / half ) + 0.08 * cos( 2 * M_PI * t / half );
+
+    taps[j] = float( sinc * window );
+    sum += taps[j];
+  }
+
+  for ( size_t j = 0; j < INTERP_TAPS; j++ )
+    taps[j] /= float( sum );
+}
+
+static double energy( const std::vector< gr_complex > &samples )
+{
+  double sum = 0;
+
+  for ( size_t i = 0; i < samples.size(); i++ )
+    sum += std::norm( samples[i] );
+
+  return sum;
+}
+
+/* The cross correlation at the fractional \p lag, from its spectrum \p prod. */
+static std::complex< double > correlate( const gr_complex *prod, size_t len, double lag )
+{
+  const std::complex< double > step = std::polar( 1.0, 2 * M_PI * lag / len );
+  std::complex< double > rot( 1, 0 );
+  std::complex< double > pos( 0, 0 ), neg( 0, 0 );
+
+  for ( size_t k = 0; k < len / 2; k++, rot *= step )
+    pos += std::complex< double >( prod[k] ) * rot;
+
+  for ( size_t k = len / 2; k < len; k++, rot *= step )
+    neg += std::complex< double >( prod[k] ) * rot;
+
+  /* the upper half are the negative frequencies */
+  return pos + neg * std::polar( 1.0, -2 * M_PI * lag );
+}
+
+/* Cross correlate each channel with the first, refining its corrections
+ * by the residual delay and phase of the correlation peak. */
+void coherent_align::estimate()
+{
+  const size_t len = 2 * _cal_len; /* zero padded, for a linear correlation */
+
+  gr_complex *in = _fwd.get_inbuf();
+
+  std::copy( _cal[0].begin(), _cal[0].end(), in );
+  std::fill( in + _cal_len, in + len, gr_complex( 0.0f, 0.0f ) );
+
+  _fwd.execute();
+  std::copy( _fwd.get_outbuf(), _fwd.get_outbuf() + len, _ref.begin() );
+
+  const double ref_energy = energy( _cal[0] );
+
+  std::vector< long > shift( _nchan, 0 );
+
+  for ( size_t i = 1; i < _nchan; i++ ) {
+    std::copy( _cal[i].begin(), _cal[i].end(), in );
+    std::fill( in + _cal_len, in + len, gr_complex( 0.0f, 0.0f ) );
+
+    _fwd.execute();
+
+    const gr_complex *spec = _fwd.get_outbuf();
+    gr_complex *prod = _inv.get_inbuf();
+
+    for ( size_t k = 0; k < len; k++ )
+      prod[k] = spec[k] * std::conj( _ref[k] );
+
+    _inv.execute(); /* out of place, prod is kept */
+
+    /* corr[k] = sum x_i[n + k] * conj(x_0[n]), times len */
+    const gr_complex *corr = _inv.get_outbuf();
+
+    size_t peak = 0;
+    float best = 0;
+
+    for ( size_t k = 0; k < len; k++ ) {
+      const float power = std::norm( corr[k] );
+
+      if ( power > best ) {
+        best = power;
+        peak = k;
+      }
+    }
+
+    const double b = sqrt( best );
+    const double coherence = b / (len * sqrt( ref_energy * energy( _cal[i] ) ) + 1e-20);
+
+    if ( coherence < MIN_COHERENCE ) {
+      if ( ! _warned[i] )
+        std::cerr << "Channel " << i << " correlates too weakly with channel 0 ("
+                  << coherence << ") to be calibrated, is the reference signal on?"
+                  << std::endl;
+
+      _warned[i] = true;
+      continue;
+    }
+
+    _warned[i] = false;
+
+    const long lag = peak < len / 2 ? long(peak) : long(peak) - long(len);
+
+    /* the peak between the integer lags, from the band limited correlation */
+    double lo = lag - 1, hi = lag + 1;
+    const double golden = (sqrt( 5.0 ) - 1) / 2;
+
+    for ( int iter = 0; iter < 20; iter++ ) {
+      const double x1 = hi - golden * (hi - lo);
+      const double x2 = lo + golden * (hi - lo);
+
+      if ( std::abs( correlate( prod, len, x1 ) ) > std::abs( correlate( prod, len, x2 ) ) )
+        hi = x2;
+      else
+        lo = x1;
+    }
+
+    const double exact = (lo + hi) / 2;
+    const std::complex< double > phase = correlate( prod, len, exact );
+
+    /* channel i trails the first one by this many samples */
+    const double delay = _frac[i] + exact;
+
+    shift[i] = long( floor( delay + 0.5 ) );
+    _frac[i] = delay - shift[i];
+    design( i );
+
+    _rot[i] *= gr_complex( std::conj( phase ) / std::abs( phase ) );
+  }
+
+  /* channels can only be advanced, the leading ones have to wait */
+  const long lowest = *std::min_element( shift.begin(), shift.end() );
+
+  for ( size_t i = 0; i < _nchan; i++ ) {
+    if ( shift[i] == lowest )
+      continue;
+
+    _drop[i] += shift[i] - lowest;
+
+    std::cerr << "Aligning channel " << i << " by " << shift[i] - lowest
+              << " samples." << std::endl;
+  }
+}
+
+void coherent_align::forecast( int noutput_items, gr_vector_int &ninput_items_required )
+{
+  for ( size_t i = 0; i < ninput_items_required.size(); i++ )
+    ninput_items_required[i] = noutput_items + INTERP_TAPS - 1;
+}
+
+int coherent_align::general_work( int noutput_items,
+                                  gr_vector_int &ninput_items,
+                                  gr_vector_const_void_star &input_items,
+                                  gr_vector_void_star &output_items )
+{
+  bool dropped = false;
+
+  for ( size_t i = 0; i < _nchan; i++ ) {
+    if ( ! _drop[i] )
+      continue;
+
+    const uint64_t n = std::min( uint64_t(ninput_items[i]), _drop[i] );
+
+    consume( i, n );
+    _drop[i] -= n;
+    dropped = true;
+  }
+
+  if ( dropped )
+    return 0;
+
+  int n = noutput_items;
+
+  for ( size_t i = 0; i < _nchan; i++ )
+    n = std::min( n, ninput_items[i] - (INTERP_TAPS - 1) );
+
+  if ( n <= 0 )
+    return 0;
+
+  bool retuned = false;
+
+  for ( size_t i = 0; i < _nchan; i++ ) {
+    const gr_complex *in = (const gr_complex *) input_items[i];
+    gr_complex *out = (gr_complex *) output_items[i];
+    const float *taps = &_taps[i][0];
+    const gr_complex rot = _rot[i];
+
+    for ( int k = 0; k < n; k++ ) {
+      gr_complex acc( 0.0f, 0.0f );
+
+      for ( size_t j = 0; j < INTERP_TAPS; j++ )
+        acc += in[k + j] * taps[j];
+
+      out[k] = acc * rot;
+    }
+
+    std::vector< gr::tag_t > tags;
+    get_tags_in_range( tags, i, nitems_read( i ), nitems_read( i ) + n );
+
+    BOOST_FOREACH( gr::tag_t tag, tags ) {
+      retuned |= pmt::eq( tag.key, RX_FREQ_KEY );
+
+      tag.offset = tag.offset - nitems_read( i ) + nitems_written( i );
+      add_item_tag( i, tag );
+    }
+
+    consume( i, n );
+  }
+
+  if ( retuned ) {
+    /* the tuner phases changed, start over once they settled */
+    _armed = true;
+    _wait = samples( CAL_SETTLE );
+    _collected = 0;
+  } else if ( _armed ) {
+    const uint64_t skip = std::min( uint64_t(n), _wait );
+    _wait -= skip;
+
+    if ( ! _wait ) {
+      const size_t m = std::min( size_t(n - skip), _cal_len - _collected );
+
+      for ( size_t i = 0; i < _nchan; i++ ) {
+        const gr_complex *out = (const gr_complex *) output_items[i] + skip;
+        std::copy( out, out + m, _cal[i].begin() + _collected );
+      }
+
+      _collected += m;
+
+      if ( _collected == _cal_len ) {
+        estimate();
+
+        _collected = 0;
+        _armed = _interval > 0;
+        _wait = samples( _interval );
+      }
+    }
+  }
+
+  return n;
+}
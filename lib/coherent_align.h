@@ -0,0 +1,107 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_COHERENT_ALIGN_H
+#define OSMOSDR_COHERENT_ALIGN_H
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/block.h>
+#include <gnuradio/fft/fft.h>
+
+class coherent_align;
+
+typedef boost::shared_ptr< coherent_align > coherent_align_sptr;
+
+coherent_align_sptr make_coherent_align( size_t cal_len, double interval,
+                                         double sample_rate );
+
+/*!
+ * \brief Aligns the channels of receivers sharing a reference clock in
+ * delay and phase.
+ *
+ * Receivers running from one clock, like rtl dongles wired to a common
+ * crystal, keep a constant delay to each other given by when they started
+ * streaming, and the tuner of each adds a phase offset which changes with
+ * every retune. Both are measured by cross correlating \p cal_len samples
+ * of each channel with the first one, while all see the same signal, e.g.
+ * a noise source switched onto their inputs. The integer part of the delay
+ * is removed by dropping samples, the fractional part by interpolating,
+ * and the phase by rotating each channel.
+ *
+ * The calibration is taken at start, after each rx_freq tag on any channel
+ * and every \p interval seconds if positive. It is measured on the aligned
+ * output, so each one refines the previous. Channels too weakly
+ * correlated with the first one keep their previous corrections.
+ *
+ * Input i is aligned onto output i, the number of channels is given by
+ * the connections. Tags keep their item positions.
+ */
+class coherent_align : public gr::block
+{
+private:
+  friend coherent_align_sptr make_coherent_align( size_t cal_len, double interval,
+                                                  double sample_rate );
+
+  coherent_align( size_t cal_len, double interval, double sample_rate );
+
+public:
+  void set_sample_rate( double sample_rate );
+
+  bool check_topology( int ninputs, int noutputs );
+
+  void forecast( int noutput_items, gr_vector_int &ninput_items_required );
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  void estimate();
+  void design( size_t chan );
+  uint64_t samples( double seconds );
+
+  size_t _nchan;
+  size_t _cal_len;
+  double _interval;
+
+  boost::mutex _mutex; /* the sample rate, set from the control thread */
+  double _rate;
+
+  std::vector< std::vector< gr_complex > > _cal; /* aligned output collected */
+  size_t _collected;
+  bool _armed;         /* collect once _wait has passed */
+  uint64_t _wait;
+
+  std::vector< double > _frac;   /* fractional delay left to interpolate */
+  std::vector< uint64_t > _drop; /* samples still to drop */
+  std::vector< std::vector< float > > _taps;
+  std::vector< gr_complex > _rot;
+  std::vector< bool > _warned;
+
+  gr::fft::fft_complex _fwd;
+  gr::fft::fft_complex _inv;
+  std::vector< gr_complex > _ref; /* spectrum of the first channel */
+};
+
+#endif // OSMOSDR_COHERENT_ALIGN_H
@@ -0,0 +1,119 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+
+#include <boost/lexical_cast.hpp>
+
+#include "convert_pool.h"
+
+#define MAX_THREADS 16
+
+convert_pool::convert_pool( const dict_t &dict ) :
+  _nworkers(0),
+  _stopping(false),
+  _generation(0),
+  _total(0),
+  _chunk(CHUNK_SAMPLES),
+  _next(0),
+  _busy(0)
+{
+  dict_t::const_iterator it = dict.find( "convert_threads" );
+  if ( it == dict.end() )
+    return;
+
+  const size_t threads = boost::lexical_cast< size_t >( it->second );
+
+  _nworkers = std::min( std::max( threads, size_t(1) ), size_t(MAX_THREADS) ) - 1;
+
+  for ( size_t i = 0; i < _nworkers; i++ )
+    _workers.create_thread( boost::bind( &convert_pool::worker, this ) );
+}
+
+convert_pool::~convert_pool()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _stopping = true;
+  }
+
+  _work_cond.notify_all();
+  _workers.join_all();
+}
+
+void convert_pool::run( const job_t &job, size_t nsamples, size_t chunk )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _job = job;
+  _total = nsamples;
+  _chunk = std::max( chunk, size_t(1) );
+  _next = 0;
+  _generation++;
+
+  _work_cond.notify_all();
+
+  /* the calling thread takes its share */
+  work_chunks( lock );
+
+  while ( _busy )
+    _done_cond.wait( lock );
+}
+
+void convert_pool::worker()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  unsigned long seen = _generation;
+
+  while ( true ) {
+    while ( ! _stopping && seen == _generation )
+      _work_cond.wait( lock );
+
+    if ( _stopping )
+      return;
+
+    seen = _generation;
+    work_chunks( lock );
+  }
+}
+
+/* Convert chunks of the current job until none is left, with lock held. */
+void convert_pool::work_chunks( boost::mutex::scoped_lock &lock )
+{
+  while ( _next < _total ) {
+    const size_t begin = _next;
+    const size_t end = std::min( _total, begin + _chunk );
+
+    _next = end;
+    _busy++;
+
+    lock.unlock();
+    _job( begin, end ); /* not replaced before all chunks are done */
+    lock.lock();
+
+    if ( 0 == --_busy && _next >= _total )
+      _done_cond.notify_all();
+  }
+}
@@ -0,0 +1,111 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_CONVERT_POOL_H
+#define OSMOSDR_CONVERT_POOL_H
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <gnuradio/gr_complex.h>
+#include <gnuradio/thread/thread_group.h>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * \brief Threads converting the samples of one work() call in parallel,
+ * given by the device arguments:
+ *
+ *   convert_threads=N  convert with N threads, the one calling work()
+ *                      included, 1 (the default) converts inline
+ *
+ * At rates the conversion of a single core can't keep up with, like
+ * bladeRF or SoapySDR devices above 50 Msps, the samples are split into
+ * chunks of CHUNK_SAMPLES, small enough to stay in the cache, and handed
+ * out to the threads. Each chunk is converted into its own place in the
+ * output, which is complete, in order, when convert() returns.
+ */
+class OSMOSDR_API convert_pool : boost::noncopyable
+{
+public:
+  typedef boost::function< void ( size_t begin, size_t end ) > job_t;
+
+  enum { CHUNK_SAMPLES = 8192 };
+
+  explicit convert_pool( const dict_t &dict );
+  ~convert_pool();
+
+  size_t threads() const { return _nworkers + 1; }
+
+  /*!
+   * Convert \p nsamples interleaved I/Q pairs from \p in into \p out with
+   * \p conv, a convert_8bit or convert_16bit.
+   */
+  template < typename convert_t, typename value_t >
+  void convert( const convert_t &conv, const value_t *in, gr_complex *out,
+                size_t nsamples )
+  {
+    if ( ! _nworkers || nsamples < 2 * CHUNK_SAMPLES ) {
+      conv( in, out, nsamples );
+      return;
+    }
+
+    run( boost::bind( &convert_chunk< convert_t, value_t >,
+                      boost::cref( conv ), in, out, _1, _2 ), nsamples );
+  }
+
+  /*!
+   * Call \p job for consecutive ranges covering 0 to \p nsamples, from
+   * all threads, and return once all of them are done.
+   */
+  void run( const job_t &job, size_t nsamples, size_t chunk = CHUNK_SAMPLES );
+
+private:
+  template < typename convert_t, typename value_t >
+  static void convert_chunk( const convert_t &conv, const value_t *in,
+                             gr_complex *out, size_t begin, size_t end )
+  {
+    conv( in + 2 * begin, out + begin, end - begin );
+  }
+
+  void worker();
+  void work_chunks( boost::mutex::scoped_lock &lock );
+
+  size_t _nworkers;
+  gr::thread::thread_group _workers;
+
+  boost::mutex _mutex;
+  boost::condition_variable _work_cond; /* a new job or stopping */
+  boost::condition_variable _done_cond; /* the last chunk finished */
+  bool _stopping;
+  unsigned long _generation; /* of the current job */
+
+  job_t _job;
+  size_t _total; /* samples of the job */
+  size_t _chunk;
+  size_t _next;  /* the first sample not handed out yet */
+  size_t _busy;  /* chunks being converted */
+};
+
+#endif // OSMOSDR_CONVERT_POOL_H
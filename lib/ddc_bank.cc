@@ -0,0 +1,265 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "ddc_bank.h"
+
+#define BLOCK_ITEMS 4096 /* input samples run through all channels at once */
+
+std::vector< ddc_channel_t > parse_ddc_channels( const std::string &spec )
+{
+  std::vector< ddc_channel_t > channels;
+  std::vector< std::string > entries;
+
+  boost::algorithm::split( entries, spec, boost::is_any_of( ";" ) );
+
+  BOOST_FOREACH( const std::string &entry, entries ) {
+    std::vector< std::string > values;
+    boost::algorithm::split( values, entry, boost::is_any_of( ":" ) );
+
+    ddc_channel_t chan;
+
+    try {
+      if ( values.size() != 2 )
+        throw boost::bad_lexical_cast();
+
+      chan.offset = boost::lexical_cast< double >( values[0] );
+      chan.bandwidth = boost::lexical_cast< double >( values[1] );
+    } catch ( boost::bad_lexical_cast & ) {
+      throw std::runtime_error( "Invalid channel '" + entry + "', "
+                                "expected offset:bandwidth." );
+    }
+
+    if ( chan.bandwidth <= 0 )
+      throw std::runtime_error( "Invalid bandwidth of channel '" + entry + "'." );
+
+    channels.push_back( chan );
+  }
+
+  return channels;
+}
+
+ddc_bank_sptr make_ddc_bank( const std::vector< ddc_channel_t > &channels,
+                             double sample_rate )
+{
+  return gnuradio::get_initial_sptr( new ddc_bank( channels, sample_rate ) );
+}
+
+ddc_bank::ddc_bank( const std::vector< ddc_channel_t > &channels,
+                    double sample_rate ) :
+  gr::block("ddc_bank",
+            gr::io_signature::make(1, 1, sizeof(gr_complex)),
+            gr::io_signature::make(channels.size(), channels.size(),
+                                   sizeof(gr_complex))),
+  _channels(channels),
+  _sample_rate(sample_rate),
+  _min_decim(1),
+  _history(1),
+  _updated(false)
+{
+  /* the outputs run at different rates, tags can't be placed correctly */
+  set_tag_propagation_policy( TPP_DONT );
+
+  design();
+
+  set_history( _history );
+  _updated = false;
+}
+
+void ddc_bank::set_sample_rate( double sample_rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( sample_rate == _sample_rate )
+    return;
+
+  _sample_rate = sample_rate;
+
+  design();
+}
+
+double ddc_bank::get_channel_rate( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _sample_rate / _state.at( chan ).decim;
+}
+
+/* Design a Hamming windowed low pass per channel and move it to its offset. */
+void ddc_bank::design()
+{
+  const double rate = _sample_rate;
+
+  _state.resize( _channels.size() );
+  _min_decim = 0;
+  _history = 1;
+
+  for (size_t c = 0; c < _channels.size() && rate <= 0; c++) {
+    /* no rate known yet, output silence until there is one */
+    _state[c].taps.assign( 1, gr_complex( 0, 0 ) );
+    _state[c].decim = 1;
+    _state[c].next = 0;
+    _state[c].phase = _state[c].phase_inc = gr_complex( 1, 0 );
+  }
+
+  for (size_t c = 0; c < _channels.size() && rate > 0; c++) {
+    const double bw = _channels[c].bandwidth;
+    const double w = 2 * M_PI * _channels[c].offset / rate;
+    channel_state &s = _state[c];
+
+    if ( fabs( _channels[c].offset ) + bw / 2 > rate / 2 )
+      std::cerr << "Channel " << c << " exceeds the sample rate of "
+                << rate << " Hz." << std::endl;
+
+    const double transition = bw / 4;
+    const double cutoff = (bw / 2 + transition / 2) / rate;
+    const size_t ntaps = size_t( ceil( 3.3 * rate / transition ) ) | 1;
+
+    s.decim = std::max( 1u, (unsigned int) floor( rate / (1.25 * bw) ) );
+    s.taps.resize( ntaps );
+
+    std::vector< double > h( ntaps );
+    double sum = 0;
+
+    for (size_t k = 0; k < ntaps; k++) {
+      const double m = double(k) - (ntaps - 1) / 2.0;
+      const double window = 0.54 - 0.46 * cos( 2 * M_PI * k / (ntaps - 1) );
+
+      h[k] = (0 == m ? 2 * cutoff : sin( 2 * M_PI * cutoff * m ) / (M_PI * m)) * window;
+      sum += h[k];
+    }
+
+    for (size_t k = 0; k < ntaps; k++)
+      s.taps[ntaps - 1 - k] = gr_complex( h[k] / sum * cos( w * k ),
+                                          h[k] / sum * sin( w * k ) );
+
+    s.next = 0;
+    s.phase = gr_complex( 1, 0 );
+    s.phase_inc = gr_complex( cos( w * s.decim ), -sin( w * s.decim ) );
+
+    _history = std::max( _history, (unsigned int) ntaps );
+    _min_decim = _min_decim ? std::min( _min_decim, s.decim ) : s.decim;
+  }
+
+  if ( ! _min_decim )
+    _min_decim = 1;
+
+  set_relative_rate( 1.0 / _min_decim );
+
+  _updated = true;
+}
+
+static inline gr_complex dot_prod( const gr_complex *in, const gr_complex *taps,
+                                   size_t ntaps )
+{
+  const float *a = (const float *) in;
+  const float *b = (const float *) taps;
+
+  /* independent accumulators, so the loop isn't bound by the add latency */
+  float re0 = 0, im0 = 0, re1 = 0, im1 = 0;
+  size_t i = 0;
+
+  for (; i + 1 < ntaps; i += 2, a += 4, b += 4) {
+    re0 += a[0] * b[0] - a[1] * b[1];
+    im0 += a[0] * b[1] + a[1] * b[0];
+    re1 += a[2] * b[2] - a[3] * b[3];
+    im1 += a[2] * b[3] + a[3] * b[2];
+  }
+
+  if ( i < ntaps ) {
+    re0 += a[0] * b[0] - a[1] * b[1];
+    im0 += a[0] * b[1] + a[1] * b[0];
+  }
+
+  return gr_complex( re0 + re1, im0 + im1 );
+}
+
+void ddc_bank::forecast( int noutput_items, gr_vector_int &ninput_items_required )
+{
+  ninput_items_required[0] = noutput_items * _min_decim;
+}
+
+int ddc_bank::general_work( int noutput_items,
+                            gr_vector_int &ninput_items,
+                            gr_vector_const_void_star &input_items,
+                            gr_vector_void_star &output_items )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( _updated ) {
+    /* like the gr-filter blocks, pick up the change with the next call */
+    set_history( _history );
+    _updated = false;
+    return 0;
+  }
+
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  const size_t ninput = std::min( size_t( ninput_items[0] ),
+                                  size_t( noutput_items ) * _min_decim );
+
+  std::vector< int > produced( _state.size(), 0 );
+
+  for (size_t start = 0; start < ninput; start += BLOCK_ITEMS) {
+    const size_t end = std::min( start + BLOCK_ITEMS, ninput );
+
+    for (size_t c = 0; c < _state.size(); c++) {
+      channel_state &s = _state[c];
+      const size_t ntaps = s.taps.size();
+
+      /* the window of input item i starts at base[i] and ends with in[i] */
+      const gr_complex *base = in + _history - ntaps;
+      gr_complex *out = (gr_complex *) output_items[c] + produced[c];
+
+      for (; s.next < end; s.next += s.decim) {
+        *out++ = dot_prod( base + s.next, &s.taps[0], ntaps ) * s.phase;
+        s.phase *= s.phase_inc;
+        produced[c]++;
+      }
+    }
+  }
+
+  for (size_t c = 0; c < _state.size(); c++) {
+    channel_state &s = _state[c];
+
+    s.next -= ninput;
+    s.phase /= std::abs( s.phase ); /* keep rounding errors from piling up */
+
+    produce( c, produced[c] );
+  }
+
+  consume_each( ninput );
+
+  return WORK_CALLED_PRODUCE;
+}
@@ -0,0 +1,102 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DDC_BANK_H
+#define OSMOSDR_DDC_BANK_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/block.h>
+#include <gnuradio/gr_complex.h>
+
+struct ddc_channel_t
+{
+  double offset;    /* from the center frequency, in Hz */
+  double bandwidth; /* in Hz */
+};
+
+/*!
+ * Parse a channels= argument of the form "offset1:bw1;offset2:bw2".
+ */
+std::vector< ddc_channel_t > parse_ddc_channels( const std::string &spec );
+
+class ddc_bank;
+
+typedef boost::shared_ptr< ddc_bank > ddc_bank_sptr;
+
+ddc_bank_sptr make_ddc_bank( const std::vector< ddc_channel_t > &channels,
+                             double sample_rate );
+
+/*!
+ * \brief Extracts several narrowband channels from one wideband stream.
+ *
+ * Each output is the input shifted by -offset, low pass filtered to the
+ * channel bandwidth and decimated by the largest factor keeping its rate
+ * at least 1.25 times the bandwidth, as freq_xlating_fir_filter would do.
+ * The input is processed in cache sized blocks which are run through all
+ * channels in turn, so the wideband stream is read from memory only once.
+ */
+class ddc_bank : public gr::block
+{
+private:
+  friend ddc_bank_sptr make_ddc_bank( const std::vector< ddc_channel_t > &channels,
+                                      double sample_rate );
+
+  ddc_bank( const std::vector< ddc_channel_t > &channels, double sample_rate );
+
+public:
+  /*! Redesign all filters for a new input \p sample_rate. */
+  void set_sample_rate( double sample_rate );
+
+  /*! \return the output rate of channel \p chan */
+  double get_channel_rate( size_t chan );
+
+  void forecast( int noutput_items, gr_vector_int &ninput_items_required );
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  struct channel_state
+  {
+    std::vector< gr_complex > taps; /* band pass, in reverse order */
+    unsigned int decim;
+    size_t next;      /* input index of the next output sample */
+    gr_complex phase; /* undoes the band pass modulation */
+    gr_complex phase_inc;
+  };
+
+  void design();
+
+  boost::mutex _mutex;
+  std::vector< ddc_channel_t > _channels;
+  std::vector< channel_state > _state;
+  double _sample_rate;
+  unsigned int _min_decim;
+  unsigned int _history;
+  bool _updated; /* filters redesigned, history has to follow */
+};
+
+#endif // OSMOSDR_DDC_BANK_H
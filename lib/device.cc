@@ -22,7 +22,6 @@
 #include <stdexcept>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
-#include <boost/thread/mutex.hpp>
 #include <algorithm>
 #include <sstream>
 
@@ -30,63 +29,9 @@
 #include "config.h"
 #endif
 
-#ifdef ENABLE_OSMOSDR
-#include <osmosdr_src_c.h>
-#endif
-
-#ifdef ENABLE_FCD
-#include <fcd_source_c.h>
-#endif
-
-#ifdef ENABLE_FILE
-#include <file_source_c.h>
-#endif
-
-#ifdef ENABLE_RTL
-#include <rtl_source_c.h>
-#endif
-
-#ifdef ENABLE_RTL_TCP
-#include <rtl_tcp_source_c.h>
-#endif
-
-#ifdef ENABLE_UHD
-#include <uhd_source_c.h>
-#endif
-
-#ifdef ENABLE_MIRI
-#include <miri_source_c.h>
-#endif
-
-#ifdef ENABLE_SDRPLAY
-#include <sdrplay_source_c.h>
-#endif
-
-#ifdef ENABLE_HACKRF
-#include <hackrf_source_c.h>
-#endif
-
-#ifdef ENABLE_BLADERF
-#include <bladerf_source_c.h>
-#endif
-
-#ifdef ENABLE_RFSPACE
-#include <rfspace_source_c.h>
-#endif
-
-#ifdef ENABLE_AIRSPY
-#include <airspy_source_c.h>
-#endif
-
-#ifdef ENABLE_SOAPY
-#include <soapy_source_c.h>
-#endif
-
-#ifdef ENABLE_REDPITAYA
-#include <redpitaya_source_c.h>
-#endif
-
 #include "arg_helpers.h"
+#include "backend_registry.h"
+#include "device_probe.h"
 
 using namespace osmosdr;
 
@@ -94,8 +39,6 @@ static const std::string args_delim = " ";
 static const std::string pairs_delim = ",";
 static const std::string pair_delim = "=";
 
-static boost::mutex _device_mutex;
-
 device_t::device_t(const std::string &args)
 {
   dict_t dict = params_to_dict(args);
@@ -131,78 +74,48 @@ std::string device_t::to_string(void) const
   return ss.str();
 }
 
-devices_t device::find(const device_t &hint)
+devices_t osmosdr::parse_devices(const std::string &args)
 {
-  boost::mutex::scoped_lock lock(_device_mutex);
+  devices_t devices;
 
+  BOOST_FOREACH( const device_spec &spec, args_to_specs(args) ) {
+    if ( spec.global )
+      continue;
+
+    device_t dev;
+    dev.insert( spec.dict.begin(), spec.dict.end() );
+    devices.push_back( dev );
+  }
+
+  return devices;
+}
+
+devices_t device::find(const device_t &hint)
+{
   bool fake = true;
 
   if ( hint.count("nofake") )
     fake = false;
 
-  devices_t devices;
+  /* restrict the search to backends with the given capabilities */
+  unsigned int caps = 0;
 
-#ifdef ENABLE_OSMOSDR
-  BOOST_FOREACH( std::string dev, osmosdr_src_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_FCD
-  BOOST_FOREACH( std::string dev, fcd_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_RTL
-  BOOST_FOREACH( std::string dev, rtl_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_UHD
-  BOOST_FOREACH( std::string dev, uhd_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_MIRI
-  BOOST_FOREACH( std::string dev, miri_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_SDRPLAY
-  BOOST_FOREACH( std::string dev, sdrplay_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_BLADERF
-  BOOST_FOREACH( std::string dev, bladerf_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_HACKRF
-  BOOST_FOREACH( std::string dev, hackrf_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_RFSPACE
-  BOOST_FOREACH( std::string dev, rfspace_source_c::get_devices( fake ) )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_AIRSPY
-  BOOST_FOREACH( std::string dev, airspy_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_SOAPY
-  BOOST_FOREACH( std::string dev, soapy_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
-#endif
+  if ( hint.count("hardware") )
+    caps |= BACKEND_HARDWARE;
+  if ( hint.count("network") )
+    caps |= BACKEND_NETWORK;
+  if ( hint.count("file") )
+    caps |= BACKEND_FILE;
 
-  /* software-only sources should be appended at the very end,
-   * hopefully resulting in hardware sources to be shown first
-   * in a graphical interface etc... */
+  devices_t devices;
 
-#ifdef ENABLE_RTL_TCP
-  BOOST_FOREACH( std::string dev, rtl_tcp_source_c::get_devices( fake ) )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_REDPITAYA
-  BOOST_FOREACH( std::string dev, redpitaya_source_c::get_devices( fake ) )
-    devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_FILE
-  BOOST_FOREACH( std::string dev, file_source_c::get_devices( fake ) )
+  /* shares the cache with the device selection of source_impl and sink_impl */
+  std::vector< std::string > found = hint.count("tx") ?
+                                     find_sink_devices( fake, caps ) :
+                                     find_source_devices( fake, caps );
+
+  BOOST_FOREACH( std::string dev, found )
     devices.push_back( device_t(dev) );
-#endif
 
   return devices;
 }
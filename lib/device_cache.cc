@@ -0,0 +1,220 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "device_cache.h"
+
+/* the device ids are made of device strings, keep the file name safe */
+static std::string file_name( const std::string &id )
+{
+  std::string name = id;
+
+  BOOST_FOREACH( char &c, name )
+    if ( ! isalnum( (unsigned char)c ) && '.' != c && '-' != c )
+      c = '_';
+
+  return name + ".cache";
+}
+
+device_cache::device_cache( const std::string &dir, const std::string &id ) :
+  _dir(dir),
+  _path(dir + "/" + file_name( id ))
+{
+  load();
+}
+
+bool device_cache::get( size_t chan, const std::string &name, std::string &value )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  std::map< key_t, std::string >::const_iterator it;
+
+  it = _entries.find( key_t( chan, name ) );
+  if ( it == _entries.end() )
+    return false;
+
+  value = it->second;
+  return true;
+}
+
+void device_cache::put( size_t chan, const std::string &name, const std::string &value )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  std::string &entry = _entries[key_t( chan, name )];
+  if ( entry == value )
+    return;
+
+  entry = value;
+  save();
+}
+
+/* a range per start:stop:step, separated by ';' */
+bool device_cache::get( size_t chan, const std::string &name, osmosdr::meta_range_t &range )
+{
+  std::string value;
+  if ( ! get( chan, name, value ) )
+    return false;
+
+  std::vector< std::string > ranges, parts;
+  boost::algorithm::split( ranges, value, boost::is_any_of( ";" ) );
+
+  osmosdr::meta_range_t parsed;
+
+  try {
+    BOOST_FOREACH( const std::string &str, ranges ) {
+      boost::algorithm::split( parts, str, boost::is_any_of( ":" ) );
+      if ( parts.size() != 3 )
+        return false;
+
+      parsed.push_back( osmosdr::range_t( boost::lexical_cast< double >( parts[0] ),
+                                          boost::lexical_cast< double >( parts[1] ),
+                                          boost::lexical_cast< double >( parts[2] ) ) );
+    }
+  } catch ( boost::bad_lexical_cast & ) {
+    return false;
+  }
+
+  range = parsed;
+  return true;
+}
+
+void device_cache::put( size_t chan, const std::string &name, const osmosdr::meta_range_t &range )
+{
+  std::vector< std::string > ranges;
+
+  BOOST_FOREACH( const osmosdr::range_t &r, range )
+    ranges.push_back( boost::lexical_cast< std::string >( r.start() ) + ":" +
+                      boost::lexical_cast< std::string >( r.stop() ) + ":" +
+                      boost::lexical_cast< std::string >( r.step() ) );
+
+  if ( ranges.size() ) /* an empty range reads back as missing */
+    put( chan, name, boost::algorithm::join( ranges, ";" ) );
+}
+
+/* separated by ';' */
+bool device_cache::get( size_t chan, const std::string &name, std::vector< double > &values )
+{
+  std::string value;
+  if ( ! get( chan, name, value ) )
+    return false;
+
+  std::vector< std::string > parts;
+  boost::algorithm::split( parts, value, boost::is_any_of( ";" ) );
+
+  std::vector< double > parsed;
+
+  try {
+    BOOST_FOREACH( const std::string &str, parts )
+      parsed.push_back( boost::lexical_cast< double >( str ) );
+  } catch ( boost::bad_lexical_cast & ) {
+    return false;
+  }
+
+  values = parsed;
+  return true;
+}
+
+void device_cache::put( size_t chan, const std::string &name, const std::vector< double > &values )
+{
+  std::vector< std::string > parts;
+
+  BOOST_FOREACH( double v, values )
+    parts.push_back( boost::lexical_cast< std::string >( v ) );
+
+  if ( parts.size() )
+    put( chan, name, boost::algorithm::join( parts, ";" ) );
+}
+
+/* one entry per line: channel, name and value separated by tabs */
+void device_cache::load()
+{
+  std::ifstream file( _path.c_str() );
+  std::string line;
+
+  while ( std::getline( file, line ) ) {
+    if ( line.empty() || '#' == line[0] )
+      continue;
+
+    std::vector< std::string > fields;
+    boost::algorithm::split( fields, line, boost::is_any_of( "\t" ) );
+
+    if ( fields.size() != 3 )
+      continue;
+
+    try {
+      _entries[key_t( boost::lexical_cast< size_t >( fields[0] ), fields[1] )] = fields[2];
+    } catch ( boost::bad_lexical_cast & ) {
+    }
+  }
+}
+
+/* Called with _mutex held. The file is replaced at once, so a source coming
+ * up concurrently never reads half of it. */
+void device_cache::save()
+{
+#ifdef _WIN32
+  _mkdir( _dir.c_str() );
+#else
+  mkdir( _dir.c_str(), 0755 ); /* may exist already */
+#endif
+
+  const std::string tmp = _path + ".tmp";
+
+  {
+    std::ofstream file( tmp.c_str() );
+
+    file << "# gr-osmosdr device cache, safe to delete" << std::endl;
+
+    std::map< key_t, std::string >::const_iterator it;
+    for ( it = _entries.begin(); it != _entries.end(); ++it )
+      file << it->first.first << "\t" << it->first.second << "\t" << it->second << std::endl;
+
+    if ( ! file ) {
+      std::cerr << "Failed to write " << tmp << std::endl;
+      return;
+    }
+  }
+
+  if ( std::rename( tmp.c_str(), _path.c_str() ) != 0 ) {
+    std::remove( _path.c_str() ); /* windows doesn't replace */
+
+    if ( std::rename( tmp.c_str(), _path.c_str() ) != 0 )
+      std::cerr << "Failed to write " << _path << std::endl;
+  }
+}
@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DEVICE_CACHE_H
+#define OSMOSDR_DEVICE_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <osmosdr/ranges.h>
+
+/*!
+ * \brief What is slow to learn about a device, kept across runs in
+ * cache_dir=<path> given with the device arguments.
+ *
+ * The entries are kept by device channel and name, in a text file per
+ * device named after its source_iface::get_device_id(), so a device with
+ * another serial number or firmware starts from scratch. The file is read
+ * when the device is opened and rewritten on every change, which happens
+ * while the entries are learned during the first run only.
+ *
+ * source_impl keeps the capability ranges in it, answering the getters
+ * from the cache from the start, and the estimates of the software DC and
+ * IQ correction as the starting point of the next run.
+ */
+class device_cache : boost::noncopyable
+{
+public:
+  device_cache( const std::string &dir, const std::string &id );
+
+  bool get( size_t chan, const std::string &name, std::string &value );
+  void put( size_t chan, const std::string &name, const std::string &value );
+
+  bool get( size_t chan, const std::string &name, osmosdr::meta_range_t &range );
+  void put( size_t chan, const std::string &name, const osmosdr::meta_range_t &range );
+
+  bool get( size_t chan, const std::string &name, std::vector< double > &values );
+  void put( size_t chan, const std::string &name, const std::vector< double > &values );
+
+private:
+  void load();
+  void save();
+
+  typedef std::pair< size_t, std::string > key_t;
+
+  boost::mutex _mutex;
+  std::string _dir;
+  std::string _path;
+  std::map< key_t, std::string > _entries;
+};
+
+#endif // OSMOSDR_DEVICE_CACHE_H
@@ -0,0 +1,175 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <map>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/thread/thread.h>
+
+#include "backend_registry.h"
+#include "device_probe.h"
+
+#define PROBE_TIMEOUT 3  /* seconds a single backend may take */
+#define CACHE_TTL     10 /* seconds an enumeration result stays valid */
+
+namespace {
+
+struct cache_entry
+{
+  cache_entry() : busy(false), valid(false), stamp(0) {}
+
+  bool busy;  /* a probe thread is running */
+  bool valid;
+  gr::high_res_timer_type stamp;
+  std::vector< std::string > devices;
+};
+
+struct probe_cache
+{
+  boost::mutex mutex;
+  boost::condition_variable cond;
+  std::map< std::string, cache_entry > entries;
+};
+
+/* never destroyed, a timed out probe thread may outlive main() */
+probe_cache &cache()
+{
+  static probe_cache *cache = new probe_cache;
+
+  return *cache;
+}
+
+void run_probe( device_probe probe, bool fake, std::string key )
+{
+  std::vector< std::string > devices;
+
+  try {
+    devices = probe.func( fake );
+  } catch ( std::exception &ex ) {
+    std::cerr << "Failed to enumerate " << probe.name << " devices: "
+              << ex.what() << std::endl;
+  }
+
+  probe_cache &c = cache();
+  boost::mutex::scoped_lock lock( c.mutex );
+
+  cache_entry &entry = c.entries[key];
+  entry.devices = devices;
+  entry.stamp = gr::high_res_timer_now();
+  entry.valid = true;
+  entry.busy = false;
+
+  c.cond.notify_all();
+}
+
+}
+
+std::vector< std::string > probe_devices( const std::vector< device_probe > &probes,
+                                          bool fake )
+{
+  probe_cache &c = cache();
+  boost::mutex::scoped_lock lock( c.mutex );
+
+  const gr::high_res_timer_type now = gr::high_res_timer_now();
+  const gr::high_res_timer_type ttl = CACHE_TTL * gr::high_res_timer_tps();
+
+  std::vector< std::string > keys;
+
+  BOOST_FOREACH( const device_probe &probe, probes ) {
+    std::string key = probe.name + (fake ? ",fake" : "");
+    keys.push_back( key );
+
+    cache_entry &entry = c.entries[key];
+    if ( entry.busy || (entry.valid && now - entry.stamp < ttl) )
+      continue;
+
+    entry.busy = true;
+
+    gr::thread::thread thread( boost::bind( &run_probe, probe, fake, key ) );
+    thread.detach();
+  }
+
+  boost::system_time deadline = boost::get_system_time() +
+                                boost::posix_time::seconds( PROBE_TIMEOUT );
+
+  while ( true ) {
+    bool busy = false;
+
+    BOOST_FOREACH( const std::string &key, keys )
+      busy |= c.entries[key].busy;
+
+    if ( ! busy || ! c.cond.timed_wait( lock, deadline ) )
+      break;
+  }
+
+  std::vector< std::string > devices;
+
+  for ( size_t i = 0; i < keys.size(); i++ ) {
+    cache_entry &entry = c.entries[keys[i]];
+
+    /* a previous result is still better than nothing */
+    if ( entry.busy )
+      std::cerr << "Enumerating " << probes[i].name << " devices timed out"
+                << (entry.valid ? ", using the last result." : ".")
+                << std::endl;
+
+    devices.insert( devices.end(), entry.devices.begin(), entry.devices.end() );
+  }
+
+  return devices;
+}
+
+std::vector< std::string > find_source_devices( bool fake, unsigned int caps )
+{
+  load_backend_plugins();
+
+  std::vector< device_probe > probes;
+
+  BOOST_FOREACH( const source_registry::backend &b,
+                 source_registry::instance().backends( caps ) )
+    probes.push_back( device_probe( b.name, b.enumerate ) );
+
+  return probe_devices( probes, fake );
+}
+
+std::vector< std::string > find_sink_devices( bool fake, unsigned int caps )
+{
+  load_backend_plugins();
+
+  std::vector< device_probe > probes;
+
+  /* the cache is shared with the sources, keep the keys apart */
+  BOOST_FOREACH( const sink_registry::backend &b,
+                 sink_registry::instance().backends( caps ) )
+    probes.push_back( device_probe( b.name + "_sink", b.enumerate ) );
+
+  return probe_devices( probes, fake );
+}
@@ -0,0 +1,65 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DEVICE_PROBE_H
+#define OSMOSDR_DEVICE_PROBE_H
+
+#include <string>
+#include <vector>
+
+/*!
+ * A named enumeration function of a backend, get_devices() in most cases.
+ */
+struct device_probe
+{
+  typedef std::vector< std::string > (*func_t)( bool fake );
+
+  device_probe( const std::string &name, func_t func ) :
+    name(name), func(func) {}
+
+  std::string name;
+  func_t func;
+};
+
+/*!
+ * Enumerate devices of all \p probes in parallel.
+ *
+ * Every probe runs in its own thread and gets PROBE_TIMEOUT seconds to
+ * finish. Results are cached process-wide for CACHE_TTL seconds, a probe
+ * which times out is left running in the background and its result picked
+ * up by the next call. Devices are returned in the order of \p probes.
+ */
+std::vector< std::string > probe_devices( const std::vector< device_probe > &probes,
+                                          bool fake = false );
+
+/*!
+ * Enumerate all registered source backends providing all of \p caps
+ * (backend_caps_t flags), hardware first.
+ */
+std::vector< std::string > find_source_devices( bool fake = false,
+                                                unsigned int caps = 0 );
+
+/*!
+ * Enumerate all registered sink backends providing all of \p caps
+ * (backend_caps_t flags), hardware first.
+ */
+std::vector< std::string > find_sink_devices( bool fake = false,
+                                              unsigned int caps = 0 );
+
+#endif // OSMOSDR_DEVICE_PROBE_H
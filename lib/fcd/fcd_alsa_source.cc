@@ -0,0 +1,223 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include "fcd_alsa_source.h"
+
+#define WAIT_TIMEOUT_MS 100 /* returns to the scheduler in between */
+
+fcd_alsa_source_sptr make_fcd_alsa_source( const std::string &device,
+                                           unsigned int rate,
+                                           unsigned int period,
+                                           unsigned int periods )
+{
+  return gnuradio::get_initial_sptr(new fcd_alsa_source( device, rate, period, periods ));
+}
+
+static void check( int err, const std::string &what )
+{
+  if ( err < 0 )
+    throw std::runtime_error( "fcd_alsa_source: " + what + ": " + snd_strerror( err ) );
+}
+
+fcd_alsa_source::fcd_alsa_source( const std::string &device, unsigned int rate,
+                                  unsigned int period, unsigned int periods ) :
+  gr::sync_block( "fcd_alsa_source",
+                  gr::io_signature::make( 0, 0, 0 ),
+                  gr::io_signature::make( 1, 1, sizeof(gr_complex) ) ),
+  _pcm(NULL),
+  _device(device),
+  _rate(rate),
+  _period(period),
+  _buffer(0),
+  _last_read(0),
+  _convert(1.0f/32768.0f)
+{
+  check( snd_pcm_open( &_pcm, device.c_str(), SND_PCM_STREAM_CAPTURE, 0 ),
+         "Failed to open " + device );
+
+  snd_pcm_hw_params_t *hw;
+  snd_pcm_hw_params_alloca( &hw );
+
+  int dir = 0;
+
+  try {
+    check( snd_pcm_hw_params_any( _pcm, hw ), "no configuration" );
+    check( snd_pcm_hw_params_set_access( _pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED ),
+           "mmap access not supported" );
+    check( snd_pcm_hw_params_set_format( _pcm, hw, SND_PCM_FORMAT_S16_LE ),
+           "S16_LE not supported" );
+    check( snd_pcm_hw_params_set_channels( _pcm, hw, 2 ), "stereo not supported" );
+    check( snd_pcm_hw_params_set_rate_near( _pcm, hw, &_rate, &dir ),
+           "Failed to set the rate" );
+    check( snd_pcm_hw_params_set_period_size_near( _pcm, hw, &_period, &dir ),
+           "Failed to set the period size" );
+    check( snd_pcm_hw_params_set_periods_near( _pcm, hw, &periods, &dir ),
+           "Failed to set the number of periods" );
+    check( snd_pcm_hw_params( _pcm, hw ), "Failed to apply the hw params" );
+
+    check( snd_pcm_hw_params_get_buffer_size( hw, &_buffer ),
+           "Failed to get the buffer size" );
+
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_sw_params_alloca( &sw );
+
+    check( snd_pcm_sw_params_current( _pcm, sw ), "Failed to get the sw params" );
+    check( snd_pcm_sw_params_set_avail_min( _pcm, sw, _period ),
+           "Failed to set avail_min" );
+    check( snd_pcm_sw_params( _pcm, sw ), "Failed to apply the sw params" );
+  } catch ( std::exception & ) {
+    snd_pcm_close( _pcm );
+    throw;
+  }
+
+  if ( _rate != rate )
+    std::cerr << "fcd_alsa_source: " << device << " runs at " << _rate
+              << " Hz instead of " << rate << " Hz" << std::endl;
+
+  std::cerr << "Using ALSA mmap capture with " << _period << " frame periods, "
+            << _buffer << " frames buffered" << std::endl;
+
+  message_port_register_out( STREAM_STATS_PORT );
+}
+
+fcd_alsa_source::~fcd_alsa_source()
+{
+  if ( _pcm )
+    snd_pcm_close( _pcm );
+}
+
+bool fcd_alsa_source::start()
+{
+  check( snd_pcm_prepare( _pcm ), "Failed to prepare " + _device );
+  check( snd_pcm_start( _pcm ), "Failed to start " + _device );
+
+  _last_read = gr::high_res_timer_now();
+
+  return true;
+}
+
+bool fcd_alsa_source::stop()
+{
+  snd_pcm_drop( _pcm );
+
+  return true;
+}
+
+/* Restart capturing after an overrun, counting the frames lost. */
+bool fcd_alsa_source::recover( int err )
+{
+  if ( -EPIPE == err ) {
+    /* the buffer was full when the overrun happened, estimate the rest */
+    gr::high_res_timer_type elapsed = gr::high_res_timer_now() - _last_read;
+    double frames = double(elapsed) / gr::high_res_timer_tps() * _rate;
+
+    _stats.overflow( uint64_t(std::max( 0.0, frames - _buffer )) );
+  }
+
+  if ( snd_pcm_recover( _pcm, err, 1 ) < 0 ) {
+    std::cerr << "fcd_alsa_source: " << snd_strerror( err ) << std::endl;
+    return false;
+  }
+
+  if ( snd_pcm_state( _pcm ) != SND_PCM_STATE_RUNNING )
+    snd_pcm_start( _pcm );
+
+  _last_read = gr::high_res_timer_now();
+
+  return true;
+}
+
+int fcd_alsa_source::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+
+  snd_pcm_sframes_t avail = snd_pcm_avail_update( _pcm );
+
+  if ( avail >= 0 && avail < snd_pcm_sframes_t(_period) &&
+       avail < noutput_items ) {
+    int ret = snd_pcm_wait( _pcm, WAIT_TIMEOUT_MS );
+    if ( ret < 0 )
+      avail = ret;
+    else if ( ret > 0 )
+      avail = snd_pcm_avail_update( _pcm );
+  }
+
+  if ( avail < 0 ) {
+    if ( ! recover( avail ) )
+      return -1;
+
+    return 0;
+  }
+
+  _stats.fill( avail, _buffer );
+  _stats.latency( avail, _rate );
+
+  snd_pcm_uframes_t todo = std::min< snd_pcm_uframes_t >( avail, noutput_items );
+  int produced = 0;
+
+  /* the area may wrap around the end of the buffer, taking two rounds */
+  while ( todo > 0 ) {
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset, frames = todo;
+
+    int err = snd_pcm_mmap_begin( _pcm, &areas, &offset, &frames );
+    if ( err < 0 ) {
+      if ( ! recover( err ) )
+        return -1;
+      break;
+    }
+
+    /* interleaved, the area of the first channel addresses the frames */
+    const int16_t *in = (const int16_t *)((const char *)areas[0].addr +
+                                          (areas[0].first + offset * areas[0].step) / 8);
+
+    _convert( in, out + produced, frames );
+
+    snd_pcm_sframes_t committed = snd_pcm_mmap_commit( _pcm, offset, frames );
+    if ( committed < 0 || snd_pcm_uframes_t(committed) != frames ) {
+      if ( ! recover( committed < 0 ? committed : -EPIPE ) )
+        return -1;
+      break;
+    }
+
+    produced += frames;
+    todo -= frames;
+  }
+
+  if ( produced )
+    _last_read = gr::high_res_timer_now();
+
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
+  return produced;
+}
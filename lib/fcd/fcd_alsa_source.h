@@ -0,0 +1,88 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FCD_ALSA_SOURCE_H
+#define FCD_ALSA_SOURCE_H
+
+#include <string>
+
+#include <alsa/asoundlib.h>
+
+#include <gnuradio/sync_block.h>
+
+#include "sample_convert.h"
+#include "stream_stats.h"
+
+class fcd_alsa_source;
+
+typedef boost::shared_ptr< fcd_alsa_source > fcd_alsa_source_sptr;
+
+fcd_alsa_source_sptr make_fcd_alsa_source( const std::string &device,
+                                           unsigned int rate,
+                                           unsigned int period,
+                                           unsigned int periods );
+
+/*!
+ * Captures the I/Q samples of a FUNcube Dongle from its ALSA device in
+ * mmap mode, used with mmap=true instead of the audio source of gr-fcd.
+ * The interleaved S16 stereo frames are converted from the mmap area
+ * straight into the output buffer, \p period and \p periods (in frames)
+ * size the ALSA buffer. Overruns are recovered from and counted in the
+ * stream statistics instead of printing "aO".
+ */
+class fcd_alsa_source : public gr::sync_block
+{
+private:
+  friend fcd_alsa_source_sptr make_fcd_alsa_source( const std::string &device,
+                                                    unsigned int rate,
+                                                    unsigned int period,
+                                                    unsigned int periods );
+
+  fcd_alsa_source( const std::string &device, unsigned int rate,
+                   unsigned int period, unsigned int periods );
+
+public:
+  ~fcd_alsa_source();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  osmosdr::stream_stats_t get_stream_stats() const { return _stats.get(); }
+
+private:
+  bool recover( int err );
+
+  snd_pcm_t *_pcm;
+  std::string _device;
+  unsigned int _rate;
+  snd_pcm_uframes_t _period;
+  snd_pcm_uframes_t _buffer;  /* frames, period times periods */
+
+  gr::high_res_timer_type _last_read;
+
+  convert_16bit _convert;
+
+  stream_stats _stats;
+};
+
+#endif // FCD_ALSA_SOURCE_H
@@ -28,16 +28,26 @@
 #include <gnuradio/io_signature.h>
 
 #include "fcd_source_c.h"
+#include "backend_registry.h"
 
 #include "arg_helpers.h"
 
 using namespace boost::assign;
 
+#define MMAP_PERIOD  4096 /* frames */
+#define MMAP_PERIODS 8
+
 fcd_source_c_sptr make_fcd_source_c(const std::string &args)
 {
   return gnuradio::get_initial_sptr(new fcd_source_c(args));
 }
 
+static source_registrar fcd_registrar(
+  "fcd",
+  &make_backend< source_iface, fcd_source_c_sptr, &make_fcd_source_c >,
+  &ignore_fake< &fcd_source_c::get_devices >,
+  BACKEND_HARDWARE, 20 );
+
 /*
  2 [V10            ]: USB-Audio - FUNcube Dongle V1.0
                       Hanlincrest Ltd. FUNcube Dongle V1.0 at usb-0000:00:1d.0-2, full speed
@@ -142,11 +152,46 @@ fcd_source_c::fcd_source_c(const std::string &args) :
 
   std::cerr << "Using " << name() << " (" << dev_name << ")" << std::endl;
 
+  bool mmap = dict.count("period") || dict.count("periods");
+
+  if (dict.count("mmap"))
+    mmap = ("true" == dict["mmap"] ? true : false);
+
+  /* the control blocks still open an audio device, keep the dongle free */
+  std::string audio_dev = dev_name;
+
+  if ( mmap )
+  {
+#ifdef HAVE_ALSA
+    unsigned int period = MMAP_PERIOD;
+    unsigned int periods = MMAP_PERIODS;
+
+    if (dict.count("period"))
+      period = boost::lexical_cast< unsigned int >( dict["period"] );
+
+    if (dict.count("periods"))
+      periods = boost::lexical_cast< unsigned int >( dict["periods"] );
+
+    _alsa = make_fcd_alsa_source( dev_name, (unsigned int)get_sample_rate(),
+                                  period, periods );
+    connect( _alsa, 0, self(), 0 );
+
+    message_port_register_hier_out( STREAM_STATS_PORT );
+    msg_connect( _alsa, STREAM_STATS_PORT, self(), STREAM_STATS_PORT );
+
+    audio_dev = "null";
+#else
+    std::cerr << "ALSA mmap capture not supported in this build." << std::endl;
+    mmap = false;
+#endif
+  }
+
 #ifdef HAVE_FCD
   if ( FUNCUBE_V1 == _type )
   {
-    _src_v1 = gr::fcd::source_c::make( dev_name );
-    connect( _src_v1, 0, self(), 0 );
+    _src_v1 = gr::fcd::source_c::make( audio_dev );
+    if ( ! mmap )
+      connect( _src_v1, 0, self(), 0 );
 
     set_gain( 20, "LNA" );
     set_gain( 12, "MIX" );
@@ -156,8 +201,9 @@ fcd_source_c::fcd_source_c(const std::string &args) :
 #ifdef HAVE_FCDPP
   if ( FUNCUBE_V2 == _type )
   {
-    _src_v2 = gr::fcdproplus::fcdproplus::make( dev_name );
-    connect( _src_v2, 0, self(), 0 );
+    _src_v2 = gr::fcdproplus::fcdproplus::make( audio_dev );
+    if ( ! mmap )
+      connect( _src_v2, 0, self(), 0 );
 
     set_gain( 1, "LNA" );
     set_gain( 1, "MIX" );
@@ -433,3 +479,13 @@ std::string fcd_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t fcd_source_c::get_stream_stats( size_t chan )
+{
+#ifdef HAVE_ALSA
+  if ( _alsa )
+    return _alsa->get_stream_stats();
+#endif
+
+  return osmosdr::stream_stats_t();
+}
@@ -30,6 +30,10 @@
 #include <fcdproplus/fcdproplus.h>
 #endif
 
+#ifdef HAVE_ALSA
+#include "fcd_alsa_source.h"
+#endif
+
 #include "source_iface.h"
 
 class fcd_source_c;
@@ -38,6 +42,11 @@ typedef boost::shared_ptr< fcd_source_c > fcd_source_c_sptr;
 
 fcd_source_c_sptr make_fcd_source_c( const std::string & args = "" );
 
+/*!
+ * With mmap=true (implied by period= and periods=) the samples are
+ * captured by fcd_alsa_source instead of the audio source of gr-fcd,
+ * which is then only used for tuning the dongle over HID.
+ */
 class fcd_source_c :
     public gr::hier_block2,
     public source_iface
@@ -84,6 +93,8 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   dongle_type _type;
 #ifdef HAVE_FCD
@@ -91,6 +102,9 @@ private:
 #endif
 #ifdef HAVE_FCDPP
   gr::fcdproplus::fcdproplus::sptr _src_v2;
+#endif
+#ifdef HAVE_ALSA
+  fcd_alsa_source_sptr _alsa;
 #endif
   double _lna_gain, _mix_gain, _bb_gain, _freq;
   int _correct;
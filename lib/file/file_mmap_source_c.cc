@@ -0,0 +1,305 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <boost/foreach.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "file_mmap_source_c.h"
+
+#include "arg_helpers.h"
+#include "stream_tags.h"
+
+#define PACE_BURST 0.01 /* seconds of samples the token bucket holds */
+
+file_mmap_source_c_sptr make_file_mmap_source_c( const std::string &filename,
+                                                 const std::string &format,
+                                                 bool repeat )
+{
+  return gnuradio::get_initial_sptr(new file_mmap_source_c( filename, format, repeat ));
+}
+
+file_mmap_source_c::file_mmap_source_c( const std::string &filename,
+                                        const std::string &format,
+                                        bool repeat ) :
+  gr::sync_block("file_mmap_source_c",
+                 gr::io_signature::make(0, 0, 0),
+                 gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _format(format),
+  _itemsize(cpu_format_item_size(format)),
+  _repeat(repeat),
+  _convert_sc16(1.0f/32768.0f),
+  _convert_sc8(true, 0.0f, 1.0f/128.0f),
+  _data(NULL),
+  _size(0),
+  _nitems(0),
+  _pos(0),
+  _file_rate(0),
+  _retag(true),
+  _rate(0),
+  _speed(0),
+  _tokens(0),
+  _refilled(0)
+{
+#ifndef _WIN32
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    throw std::runtime_error( "Failed to open " + filename + ": " + strerror(errno) );
+
+  struct stat st;
+  if ( fstat( fd, &st ) < 0 ) {
+    close( fd );
+    throw std::runtime_error( "Failed to stat " + filename + ": " + strerror(errno) );
+  }
+
+  _size = st.st_size;
+  _nitems = _size / _itemsize;
+
+  if ( _nitems == 0 ) {
+    close( fd );
+    throw std::runtime_error( "File " + filename + " contains no samples." );
+  }
+
+  void *data = mmap( NULL, _size, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd ); /* the mapping keeps its own reference */
+
+  if ( data == MAP_FAILED )
+    throw std::runtime_error( "Failed to map " + filename + ": " + strerror(errno) );
+
+  /* let the kernel read ahead aggressively and drop pages already played */
+  madvise( data, _size, MADV_SEQUENTIAL );
+
+  _data = (const unsigned char *)data;
+#else
+  throw std::runtime_error( "Memory mapped file access is not supported on this platform." );
+#endif
+}
+
+file_mmap_source_c::~file_mmap_source_c()
+{
+#ifndef _WIN32
+  if ( _data )
+    munmap( (void *)_data, _size );
+#endif
+}
+
+bool file_mmap_source_c::seek( long seek_point, int whence )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  long pos;
+
+  if ( SEEK_SET == whence )
+    pos = seek_point;
+  else if ( SEEK_CUR == whence )
+    pos = long(_pos) + seek_point;
+  else if ( SEEK_END == whence )
+    pos = long(_nitems) + seek_point;
+  else
+    return false;
+
+  if ( pos < 0 || size_t(pos) > _nitems )
+    return false;
+
+  _pos = pos;
+  _retag = true;
+
+  return true;
+}
+
+void file_mmap_source_c::set_captures( const std::vector< sigmf_capture > &captures,
+                                       double rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _captures = captures;
+  _file_rate = rate;
+  _retag = true;
+}
+
+void file_mmap_source_c::set_pacing( double rate, double speed )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _speed = speed;
+  _rate = rate * speed;
+}
+
+void file_mmap_source_c::set_sample_rate( double rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _rate = rate * _speed;
+}
+
+bool file_mmap_source_c::start()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _tokens = 0;
+  _refilled = gr::high_res_timer_now();
+  _retag = true;
+
+  return true;
+}
+
+/*
+ * Wait until the bucket holds a burst of tokens or enough for the whole
+ * request, with the lock released so seek() isn't held up.
+ * \return the number of samples which may be delivered now
+ */
+size_t file_mmap_source_c::pace( size_t noutput_items, boost::mutex::scoped_lock &lock )
+{
+  const double tps = gr::high_res_timer_tps();
+
+  while ( _rate > 0 ) {
+    const double burst = std::max( _rate * PACE_BURST, 1.0 );
+    const gr::high_res_timer_type now = gr::high_res_timer_now();
+
+    _tokens = std::min( _tokens + (now - _refilled) / tps * _rate, burst );
+    _refilled = now;
+
+    const double want = std::min( double(noutput_items), burst );
+    if ( _tokens >= want )
+      return std::min( noutput_items, size_t(_tokens) );
+
+    const double wait = (want - _tokens) / _rate;
+
+    lock.unlock();
+    boost::this_thread::sleep( boost::posix_time::microseconds( long( wait * 1e6 ) + 1 ) );
+    lock.lock();
+  }
+
+  return noutput_items;
+}
+
+/* Tag the rate, frequency and time of the sample at _pos in \p segment. */
+void file_mmap_source_c::tag_position( uint64_t offset, size_t segment )
+{
+  const sigmf_capture &capture = _captures[segment];
+  const double elapsed = _file_rate > 0 ?
+      (double(_pos) - double(capture.sample_start)) / _file_rate : 0;
+
+  std::vector< gr::tag_t > tags;
+
+  if ( capture.has_time ) {
+    tags = make_rx_tags( offset, capture.time + osmosdr::time_spec_t( elapsed ),
+                         _file_rate, capture.freq, alias() );
+  } else { /* recorded before the first rx_time tag */
+    tags = make_rx_tags( offset, osmosdr::time_spec_t(), _file_rate, capture.freq, alias() );
+    tags.erase( tags.begin() );
+  }
+
+  BOOST_FOREACH( const gr::tag_t &tag, tags )
+    add_item_tag( 0, tag );
+}
+
+int file_mmap_source_c::work( int noutput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+  int produced = 0;
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  const size_t allowed = pace( noutput_items, lock );
+
+  while ( size_t(produced) < allowed ) {
+    if ( _pos >= _nitems ) {
+      if ( ! _repeat )
+        break;
+
+      _pos = 0;
+      _retag = true;
+    }
+
+    size_t n = std::min( allowed - produced, _nitems - _pos );
+    size_t next = _captures.size(); /* index of the following segment */
+
+    if ( ! _captures.empty() ) {
+      sigmf_capture at;
+      at.sample_start = _pos;
+
+      /* the segment holding _pos and where the next one starts */
+      next = std::upper_bound( _captures.begin(), _captures.end(), at, sigmf_start_less ) -
+             _captures.begin();
+      size_t segment = std::max( next, size_t(1) ) - 1;
+
+      if ( _retag || _captures[segment].sample_start == _pos )
+        tag_position( nitems_written( 0 ) + produced, segment );
+
+      _retag = false;
+
+      if ( next < _captures.size() && _captures[next].sample_start < _nitems )
+        n = std::min( n, size_t(_captures[next].sample_start) - _pos );
+    }
+
+    const unsigned char *in = _data + _pos * _itemsize;
+
+    if ( "sc16" == _format )
+      _convert_sc16( (const int16_t *)in, out + produced, n );
+    else if ( "sc8" == _format )
+      _convert_sc8( in, out + produced, n );
+    else
+      memcpy( out + produced, in, n * _itemsize );
+
+    _pos += n;
+    produced += n;
+
+    /* wait out gaps between the recorded segments, e.g. after overflows */
+    if ( _rate > 0 && _file_rate > 0 && next > 0 && next < _captures.size() &&
+         _captures[next].sample_start == _pos ) {
+      const sigmf_capture &prev = _captures[next - 1];
+      const sigmf_capture &cur = _captures[next];
+
+      if ( prev.has_time && cur.has_time ) {
+        double gap = (cur.time - prev.time).get_real_secs() -
+                     (cur.sample_start - prev.sample_start) / _file_rate;
+
+        if ( gap > 0 ) {
+          _tokens -= gap * _rate / _speed;
+          break;
+        }
+      }
+    }
+  }
+
+  _tokens -= produced;
+
+  if ( produced == 0 )
+    return WORK_DONE;
+
+  return produced;
+}
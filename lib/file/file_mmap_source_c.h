@@ -0,0 +1,121 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FILE_MMAP_SOURCE_C_H
+#define FILE_MMAP_SOURCE_C_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/high_res_timer.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include "sample_convert.h"
+#include "sigmf.h"
+
+class file_mmap_source_c;
+
+typedef boost::shared_ptr< file_mmap_source_c > file_mmap_source_c_sptr;
+
+file_mmap_source_c_sptr make_file_mmap_source_c( const std::string &filename,
+                                                 const std::string &format = "fc32",
+                                                 bool repeat = false );
+
+/*!
+ * Drop-in replacement for gr::blocks::file_source reading from a memory
+ * mapping of the whole file. Items are copied straight from the page cache
+ * into the output buffer, without the stdio buffering in between, and
+ * seek() only moves the read position. sc16 and sc8 recordings are
+ * converted to gr_complex on the fly.
+ *
+ * Knowing the read position exactly, it also replays the tags of SigMF
+ * recordings and paces the output itself, see set_captures() and
+ * set_pacing().
+ */
+class file_mmap_source_c : public gr::sync_block
+{
+private:
+  friend file_mmap_source_c_sptr make_file_mmap_source_c( const std::string &filename,
+                                                          const std::string &format,
+                                                          bool repeat );
+
+  file_mmap_source_c( const std::string &filename, const std::string &format,
+                      bool repeat );
+
+public:
+  ~file_mmap_source_c();
+
+  /*!
+   * Move the read position, same semantics as gr::blocks::file_source.
+   * \param seek_point the position in items
+   * \param whence one of SEEK_SET, SEEK_CUR or SEEK_END
+   */
+  bool seek( long seek_point, int whence );
+
+  /*!
+   * Tag rx_time, rx_rate and rx_freq at the start of each of \p captures,
+   * at the start of the stream and after each seek or repetition, like
+   * the device did while recording at \p rate.
+   */
+  void set_captures( const std::vector< sigmf_capture > &captures, double rate );
+
+  /*!
+   * Deliver \p speed times \p rate samples per second, through a token
+   * bucket refilled from the high resolution timer. Gaps between the
+   * recorded rx_time of the captures are waited out, scaled by \p speed.
+   * A \p speed of 0 delivers the samples as fast as possible.
+   */
+  void set_pacing( double rate, double speed );
+
+  /*! Change the rate paced at, keeping the speed. */
+  void set_sample_rate( double rate );
+
+  bool start();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  size_t pace( size_t noutput_items, boost::mutex::scoped_lock &lock );
+  void tag_position( uint64_t offset, size_t segment );
+
+  std::string _format;
+  size_t _itemsize; /* bytes per sample in the file */
+  bool _repeat;
+  convert_16bit _convert_sc16;
+  convert_8bit _convert_sc8;
+
+  const unsigned char *_data;
+  size_t _size;     /* bytes mapped */
+  size_t _nitems;   /* whole items in the file */
+  size_t _pos;      /* read position in items */
+
+  std::vector< sigmf_capture > _captures;
+  double _file_rate; /* of the recording, as tagged */
+  bool _retag;      /* the next sample doesn't follow the last one */
+
+  double _rate;     /* paced at, 0 if not paced */
+  double _speed;
+  double _tokens;   /* samples which may be delivered right away */
+  gr::high_res_timer_type _refilled;
+
+  boost::mutex _mutex; /* seek() is called from outside the scheduler */
+};
+
+#endif // FILE_MMAP_SOURCE_C_H
@@ -24,20 +24,68 @@
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
+#include <boost/algorithm/string.hpp>
 
 #include <gnuradio/io_signature.h>
 
 #include "file_sink_c.h"
+#include "backend_registry.h"
 
 #include "arg_helpers.h"
+#include "sigmf.h"
 
 using namespace boost::assign;
 
+/* parse a rotate= value, a size like 1GB or a duration like 10min */
+static void parse_rotate( const std::string &value, uint64_t &bytes, double &secs )
+{
+  size_t pos = value.find_first_not_of( "0123456789." );
+  std::string unit = boost::algorithm::to_lower_copy( value.substr( std::min( pos, value.size() ) ) );
+  double number = 0;
+
+  try {
+    number = boost::lexical_cast< double >( value.substr( 0, pos ) );
+  } catch ( boost::bad_lexical_cast & ) {
+    unit = "?";
+  }
+
+  double scale = 0;
+  bool is_time = false;
+
+  if ( "" == unit || "b" == unit ) scale = 1;
+  else if ( "kb" == unit ) scale = 1e3;
+  else if ( "mb" == unit ) scale = 1e6;
+  else if ( "gb" == unit ) scale = 1e9;
+  else if ( "tb" == unit ) scale = 1e12;
+  else if ( "kib" == unit ) scale = 1024.0;
+  else if ( "mib" == unit ) scale = 1024.0 * 1024;
+  else if ( "gib" == unit ) scale = 1024.0 * 1024 * 1024;
+  else if ( "tib" == unit ) scale = 1024.0 * 1024 * 1024 * 1024;
+  else if ( "s" == unit ) { scale = 1; is_time = true; }
+  else if ( "min" == unit ) { scale = 60; is_time = true; }
+  else if ( "h" == unit ) { scale = 3600; is_time = true; }
+
+  if ( 0 == scale || number <= 0 )
+    throw std::runtime_error( "Unsupported rotate value '" + value +
+                              "', use a size or a duration like 1GB or 10min." );
+
+  if ( is_time )
+    secs = number * scale;
+  else
+    bytes = uint64_t( number * scale );
+}
+
 file_sink_c_sptr make_file_sink_c(const std::string &args)
 {
   return gnuradio::get_initial_sptr(new file_sink_c(args));
 }
 
+static sink_registrar file_registrar(
+  "file",
+  &make_backend< sink_iface, file_sink_c_sptr, &make_file_sink_c >,
+  &file_sink_c::get_devices,
+  BACKEND_FILE, BACKEND_ORDER_SOFTWARE + 20 );
+
 file_sink_c::file_sink_c(const std::string &args) :
   gr::hier_block2("file_sink_c",
                  gr::io_signature::make(1, 1, sizeof (gr_complex)),
@@ -46,6 +94,11 @@ file_sink_c::file_sink_c(const std::string &args) :
   std::string filename;
   bool append = false;
   bool throttle = false;
+  bool direct = false;
+  bool sigmf = false;
+  uint64_t rotate_bytes = 0;
+  double rotate_secs = 0;
+  std::string format = "fc32";
   _freq = 0;
   _rate = 0;
 
@@ -66,6 +119,25 @@ file_sink_c::file_sink_c(const std::string &args) :
   if (dict.count("append"))
     append = ("true" == dict["append"] ? true : false);
 
+  if (dict.count("direct"))
+    direct = ("true" == dict["direct"] ? true : false);
+
+  if (dict.count("format"))
+    format = dict["format"];
+
+  if (dict.count("rotate"))
+    parse_rotate( dict["rotate"], rotate_bytes, rotate_secs );
+
+  cpu_format_item_size( format ); /* throws if unsupported */
+
+  /* file_source_c needs the metadata to read the integer formats back,
+   * rotated files need it to be found by time */
+  sigmf = ("fc32" != format || boost::algorithm::ends_with( filename, ".sigmf-data" ) ||
+           rotate_bytes || rotate_secs > 0);
+
+  if (dict.count("sigmf"))
+    sigmf = ("true" == dict["sigmf"] ? true : false);
+
   if (!filename.length())
     throw std::runtime_error("No file name specified.");
 
@@ -77,9 +149,11 @@ file_sink_c::file_sink_c(const std::string &args) :
 
   _file_rate = _rate;
 
-  _sink = gr::blocks::file_sink::make( sizeof(gr_complex),
-                                           filename.c_str(),
-                                           append);
+  _sink = make_file_writer_c( filename, format, append, direct,
+                              rotate_bytes, rotate_secs );
+
+  if (sigmf)
+    _sink->set_sigmf( _rate, _freq );
 
   _throttle = gr::blocks::throttle::make( sizeof(gr_complex), _file_rate );
 
@@ -107,7 +181,7 @@ std::vector<std::string> file_sink_c::get_devices( bool fake )
   if ( fake )
   {
     std::string args = "file='/path/to/your/file'";
-    args += ",rate=1e6,freq=100e6,throttle=true";
+    args += ",rate=1e6,freq=100e6,throttle=true,format=fc32,direct=false";
     args += ",label='Complex Sampled (IQ) File'";
     devices.push_back( args );
   }
@@ -139,6 +213,7 @@ double file_sink_c::set_sample_rate( double rate )
   }
 
   _throttle->set_sample_rate( rate );
+  _sink->set_sample_rate( rate );
 
   _rate = rate;
 
@@ -21,10 +21,10 @@
 #define FILE_SINK_C_H
 
 #include <gnuradio/hier_block2.h>
-#include <gnuradio/blocks/file_sink.h>
 #include <gnuradio/blocks/throttle.h>
 
 #include "sink_iface.h"
+#include "file_writer_c.h"
 
 class file_sink_c;
 
@@ -73,7 +73,7 @@ public:
   std::string get_antenna( size_t chan = 0 );
 
 private:
-  gr::blocks::file_sink::sptr _sink;
+  file_writer_c_sptr _sink;
   gr::blocks::throttle::sptr _throttle;
   double _file_rate;
   double _freq, _rate;
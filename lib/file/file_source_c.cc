@@ -26,10 +26,15 @@
 #include <boost/format.hpp>
 
 #include <gnuradio/io_signature.h>
+#include <gnuradio/blocks/interleaved_short_to_complex.h>
+#include <gnuradio/blocks/interleaved_char_to_complex.h>
+#include <gnuradio/blocks/multiply_const_cc.h>
 
 #include "file_source_c.h"
+#include "backend_registry.h"
 
 #include "arg_helpers.h"
+#include "sigmf.h"
 
 using namespace boost::assign;
 
@@ -38,6 +43,12 @@ file_source_c_sptr make_file_source_c(const std::string &args)
   return gnuradio::get_initial_sptr(new file_source_c(args));
 }
 
+static source_registrar file_registrar(
+  "file",
+  &make_backend< source_iface, file_source_c_sptr, &make_file_source_c >,
+  &file_source_c::get_devices,
+  BACKEND_FILE, BACKEND_ORDER_SOFTWARE + 20 );
+
 file_source_c::file_source_c(const std::string &args) :
   gr::hier_block2("file_source_c",
                  gr::io_signature::make(0, 0, 0),
@@ -46,6 +57,9 @@ file_source_c::file_source_c(const std::string &args) :
   std::string filename;
   bool repeat = true;
   bool throttle = true;
+  bool use_mmap = false;
+  double speed = 1.0;
+  std::string format = "fc32";
   _freq = 0;
   _rate = 0;
 
@@ -54,6 +68,11 @@ file_source_c::file_source_c(const std::string &args) :
   if (dict.count("file"))
     filename = dict["file"];
 
+  if (filename.length()) {
+    read_sigmf_meta( filename, _rate, _freq, format ); /* arguments take precedence */
+    read_sigmf_captures( filename, _captures );
+  }
+
   if (dict.count("freq"))
     _freq = boost::lexical_cast< double >( dict["freq"] );
 
@@ -66,6 +85,23 @@ file_source_c::file_source_c(const std::string &args) :
   if (dict.count("throttle"))
     throttle = ("true" == dict["throttle"] ? true : false);
 
+  if (dict.count("mmap"))
+    use_mmap = ("true" == dict["mmap"] ? true : false);
+
+  if (dict.count("format"))
+    format = dict["format"];
+
+  /* pacing and replaying the tags need the exact read position */
+  if (dict.count("speed")) {
+    speed = boost::lexical_cast< double >( dict["speed"] );
+    use_mmap = throttle = true;
+
+    if (speed <= 0)
+      throw std::runtime_error("Parameter 'speed' must be positive.");
+  }
+
+  cpu_format_item_size( format ); /* throws if unsupported */
+
   if (!filename.length())
     throw std::runtime_error("No file name specified.");
 
@@ -77,17 +113,55 @@ file_source_c::file_source_c(const std::string &args) :
 
   _file_rate = _rate;
 
-  _source = gr::blocks::file_source::make( sizeof(gr_complex),
-                                           filename.c_str(),
-                                           repeat );
+  gr::basic_block_sptr source;
+
+  if (use_mmap) {
+    _mmap_source = make_file_mmap_source_c( filename, format, repeat );
+    _mmap_source->set_captures( _captures, _file_rate );
+    if (throttle)
+      _mmap_source->set_pacing( _file_rate, speed );
+    source = _mmap_source;
+  } else {
+    _source = gr::blocks::file_source::make( cpu_format_item_size( format ),
+                                             filename.c_str(),
+                                             repeat );
+    source = _source;
+
+    /* scale the integer formats back to +/- 1.0 as written by file_sink_c */
+    if ("sc16" == format) {
+      gr::basic_block_sptr convert = gr::blocks::interleaved_short_to_complex::make();
+      gr::basic_block_sptr scale = gr::blocks::multiply_const_cc::make( 1.0f/32768.0f );
+      connect( source, 0, convert, 0 );
+      connect( convert, 0, scale, 0 );
+      source = scale;
+    } else if ("sc8" == format) {
+      gr::basic_block_sptr convert = gr::blocks::interleaved_char_to_complex::make();
+      gr::basic_block_sptr scale = gr::blocks::multiply_const_cc::make( 1.0f/128.0f );
+      connect( source, 0, convert, 0 );
+      connect( convert, 0, scale, 0 );
+      source = scale;
+    }
+  }
+
+  if (dict.count("start_time")) {
+    const std::string value = dict["start_time"];
+    osmosdr::time_spec_t time;
+
+    /* an ISO 8601 UTC time or seconds since the epoch */
+    if ( ! sigmf_parse_datetime( value, time ) )
+      time = osmosdr::time_spec_t( boost::lexical_cast< double >( value ) );
+
+    if ( ! seek_time( time ) )
+      throw std::runtime_error("No samples taken at " + value + " in " + filename);
+  }
 
   _throttle = gr::blocks::throttle::make( sizeof(gr_complex), _file_rate );
 
-  if (throttle) {
-    connect( _source, 0, _throttle, 0 );
+  if (throttle && ! _mmap_source) {
+    connect( source, 0, _throttle, 0 );
     connect( _throttle, 0, self(), 0 );
   } else {
-    connect( _source, 0, self(), 0 );
+    connect( source, 0, self(), 0 );
   }
 }
 
@@ -107,7 +181,7 @@ std::vector<std::string> file_source_c::get_devices( bool fake )
   if ( fake )
   {
     std::string args = "file='/path/to/your/file'";
-    args += ",rate=1e6,freq=100e6,repeat=true,throttle=true";
+    args += ",rate=1e6,freq=100e6,repeat=true,throttle=true,mmap=false,format=fc32";
     args += ",label='Complex Sampled (IQ) File'";
     devices.push_back( args );
   }
@@ -122,9 +196,22 @@ size_t file_source_c::get_num_channels( void )
 
 bool file_source_c::seek( long seek_point, int whence , size_t chan )
 {
+    if ( _mmap_source )
+      return _mmap_source->seek( seek_point, whence );
+
     return _source->seek( seek_point, whence );
 }
 
+bool file_source_c::seek_time( const osmosdr::time_spec_t &time )
+{
+  uint64_t sample;
+
+  if ( ! sigmf_find_time( _captures, _file_rate, time, sample ) )
+    return false;
+
+  return seek( long(sample), SEEK_SET, 0 );
+}
+
 osmosdr::meta_range_t file_source_c::get_sample_rates( void )
 {
   osmosdr::meta_range_t range;
@@ -143,7 +230,10 @@ double file_source_c::set_sample_rate( double rate )
               << std::endl;
   }
 
-  _throttle->set_sample_rate( rate );
+  if ( _mmap_source )
+    _mmap_source->set_sample_rate( rate );
+  else
+    _throttle->set_sample_rate( rate );
 
   _rate = rate;
 
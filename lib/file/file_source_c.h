@@ -25,6 +25,8 @@
 #include <gnuradio/blocks/throttle.h>
 
 #include "source_iface.h"
+#include "file_mmap_source_c.h"
+#include "sigmf.h"
 
 class file_source_c;
 
@@ -52,6 +54,13 @@ public:
 
   bool seek( long seek_point, int whence, size_t chan );
 
+  /*!
+   * Continue with the sample taken at \p time, found by a binary search of
+   * the captures of the SigMF metadata.
+   * \return false if no segment of a known time starts before \p time
+   */
+  bool seek_time( const osmosdr::time_spec_t &time );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -76,9 +85,11 @@ public:
 
 private:
   gr::blocks::file_source::sptr _source;
+  file_mmap_source_c_sptr _mmap_source;
   gr::blocks::throttle::sptr _throttle;
   double _file_rate;
   double _freq, _rate;
+  std::vector< sigmf_capture > _captures;
 };
 
 #endif // FILE_SOURCE_C_H
@@ -0,0 +1,543 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "file_writer_c.h"
+
+#include "arg_helpers.h"
+#include "stream_tags.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define BUF_SIZE  (16 * 1024 * 1024) /* 100 ms of sc16 at 40 Msps */
+#define BUF_ALIGN 4096               /* satisfies O_DIRECT on common devices */
+
+static unsigned char *alloc_buffer()
+{
+#ifdef _WIN32
+  return (unsigned char *) _aligned_malloc( BUF_SIZE, BUF_ALIGN );
+#else
+  void *ptr = NULL;
+
+  if ( posix_memalign( &ptr, BUF_ALIGN, BUF_SIZE ) != 0 )
+    return NULL;
+
+  return (unsigned char *) ptr;
+#endif
+}
+
+static void free_buffer( unsigned char *ptr )
+{
+#ifdef _WIN32
+  _aligned_free( ptr );
+#else
+  free( ptr );
+#endif
+}
+
+file_writer_c_sptr make_file_writer_c( const std::string &filename,
+                                       const std::string &format,
+                                       bool append,
+                                       bool direct,
+                                       uint64_t rotate_bytes,
+                                       double rotate_secs )
+{
+  return gnuradio::get_initial_sptr(new file_writer_c( filename, format, append, direct,
+                                                       rotate_bytes, rotate_secs ));
+}
+
+file_writer_c::file_writer_c( const std::string &filename,
+                              const std::string &format,
+                              bool append,
+                              bool direct,
+                              uint64_t rotate_bytes,
+                              double rotate_secs ) :
+  gr::sync_block("file_writer_c",
+                 gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                 gr::io_signature::make(0, 0, 0)),
+  _filename(filename),
+  _format(format),
+  _sample_size(cpu_format_item_size(format)),
+  _convert_sc16(32767.0f),
+  _convert_sc8(127.0f),
+  _append(append),
+  _want_direct(direct),
+  _fd(-1),
+  _direct(false),
+  _rotate_bytes(rotate_bytes),
+  _rotate_secs(rotate_secs),
+  _rotate_items(0),
+  _index(0),
+  _writer_index(0),
+  _file_items(0),
+  _next_fd(-1),
+  _next_direct(false),
+  _sigmf(false),
+  _rate(0),
+  _fill(0),
+  _used(0),
+  _pending(0),
+  _rotate(false),
+  _running(false),
+  _failed(false)
+{
+  const bool rotating = (rotate_bytes || rotate_secs > 0);
+
+  if ( append && rotating )
+    throw std::runtime_error( "Appending can't be combined with rotating files." );
+
+#ifndef O_DIRECT
+  if ( direct )
+    std::cerr << "O_DIRECT is not supported on this platform, using buffered I/O."
+              << std::endl;
+#endif
+
+  _fd = open_file( 0, _direct );
+  if ( _fd < 0 )
+    throw std::runtime_error( "Failed to open " + file_path( 0 ) + ": " + strerror(errno) );
+
+  if ( append ) { /* the metadata counts the samples from the start of the file */
+    struct stat st;
+    if ( fstat( _fd, &st ) == 0 )
+      _file_items = uint64_t( st.st_size ) / _sample_size;
+  }
+
+  if ( rotating ) {
+    _next_fd = open_file( 1, _next_direct );
+
+    if ( _next_fd < 0 ) {
+      std::string error = strerror(errno);
+      close( _fd );
+      throw std::runtime_error( "Failed to open " + file_path( 1 ) + ": " + error );
+    }
+  }
+
+  _buf[0] = alloc_buffer();
+  _buf[1] = alloc_buffer();
+
+  if ( ! _buf[0] || ! _buf[1] ) {
+    free_buffer( _buf[0] );
+    free_buffer( _buf[1] );
+    close( _fd );
+    if ( _next_fd >= 0 )
+      close( _next_fd );
+    throw std::runtime_error( "Failed to allocate the file write buffers." );
+  }
+}
+
+file_writer_c::~file_writer_c()
+{
+  stop();
+
+  close( _fd );
+
+  free_buffer( _buf[0] );
+  free_buffer( _buf[1] );
+}
+
+/* \return the name of the \p index th file, numbered in front of the extension */
+std::string file_writer_c::file_path( unsigned int index ) const
+{
+  if ( ! _rotate_bytes && ! (_rotate_secs > 0) )
+    return _filename;
+
+  std::string base = _filename, ext;
+
+  if ( boost::algorithm::ends_with( base, ".sigmf-data" ) ) {
+    ext = ".sigmf-data";
+  } else {
+    size_t dot = base.find_last_of( '.' );
+    size_t sep = base.find_last_of( "/\\" );
+
+    if ( dot != std::string::npos && (sep == std::string::npos || dot > sep + 1) )
+      ext = base.substr( dot );
+  }
+
+  base.erase( base.size() - ext.size() );
+
+  return str( boost::format( "%s_%04u%s" ) % base % index % ext );
+}
+
+int file_writer_c::open_file( unsigned int index, bool &direct )
+{
+  const std::string path = file_path( index );
+  int flags = O_WRONLY | O_CREAT | O_BINARY | (_append ? O_APPEND : O_TRUNC);
+  int fd = -1;
+
+  direct = false;
+
+#ifdef O_DIRECT
+  if ( _want_direct ) {
+    fd = open( path.c_str(), flags | O_DIRECT, 0664 );
+    direct = (fd >= 0);
+  }
+#endif
+
+  if ( fd < 0 ) /* not requested or not supported by the file system */
+    fd = open( path.c_str(), flags, 0664 );
+
+  return fd;
+}
+
+void file_writer_c::set_sigmf( double rate, double freq )
+{
+  _sigmf = true;
+  _rate = rate;
+
+  _captures.clear();
+
+  /* keep the segments recorded before when appending */
+  if ( _file_items )
+    read_sigmf_captures( _filename, _captures );
+
+  sigmf_capture &capture = capture_at( _captures.empty() ? 0 : _file_items );
+  capture.freq = freq;
+  capture.has_time = false; /* unknown until tagged, unrelated to earlier ones */
+
+  /* so the recording is usable even if the application is killed */
+  write_sigmf_meta( file_path( _index ), _format, _rate, _captures );
+}
+
+void file_writer_c::set_sample_rate( double rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _rate = rate;
+}
+
+bool file_writer_c::start()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _rotate_items = _rotate_bytes / _sample_size;
+
+  if ( _rotate_secs > 0 ) {
+    if ( _rate <= 0 )
+      throw std::runtime_error( "Rotating files by time requires the sample rate." );
+
+    uint64_t items = uint64_t( _rotate_secs * _rate + 0.5 );
+
+    if ( ! _rotate_items || items < _rotate_items )
+      _rotate_items = items;
+  }
+
+  if ( _rotate_bytes || _rotate_secs > 0 )
+    _rotate_items = std::max( _rotate_items, uint64_t(1) );
+
+  _running = true;
+  _thread = gr::thread::thread( boost::bind(&file_writer_c::writer_task, this) );
+
+  return true;
+}
+
+bool file_writer_c::stop()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( ! _running )
+      return true;
+  }
+
+  if ( _used )
+    submit(); /* flush the partially filled buffer */
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _running = false;
+    _cond.notify_all();
+  }
+
+  _thread.join();
+
+  if ( _sigmf ) {
+    boost::mutex::scoped_lock lock( _mutex );
+    write_sigmf_meta( file_path( _index ), _format, _rate, _captures );
+  }
+
+  /* the file opened in advance is never going to be used */
+  if ( _next_fd >= 0 ) {
+    close( _next_fd );
+    _next_fd = -1;
+    unlink( file_path( _index + 1 ).c_str() );
+  }
+
+  return true;
+}
+
+/*
+ * Hand the filled buffer to the writer thread, waiting while it is busy.
+ * With \p rotate the buffer completes the current file, work() continues
+ * with the next one.
+ */
+void file_writer_c::submit( bool rotate )
+{
+  sigmf_capture first;
+
+  if ( rotate ) { /* the state at the end of the file carries over */
+    first = capture_state( _file_items );
+    first.sample_start = 0;
+  }
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  while ( (_pending || _rotate) && ! _failed )
+    _cond.wait( lock );
+
+  _pending = _used;
+  _rotate = rotate;
+
+  if ( rotate ) {
+    _done_captures.swap( _captures );
+    _captures.assign( 1, first );
+    _next_captures = _captures;
+    _file_items = 0;
+    _index++;
+  }
+
+  _cond.notify_all();
+
+  _fill ^= 1;
+  _used = 0;
+}
+
+void file_writer_c::writer_task()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  while ( true ) {
+    while ( ! _pending && ! _rotate && _running )
+      _cond.wait( lock );
+
+    if ( ! _pending && ! _rotate )
+      break;
+
+    /* the buffer not being filled is ours until _pending is cleared */
+    const unsigned char *buf = _buf[_fill ^ 1];
+    const size_t len = _pending;
+    const bool rotate = _rotate;
+    const double rate = _rate;
+
+    lock.unlock();
+    bool ok = write_all( buf, len );
+    if ( ok && rotate )
+      ok = rotate_file( rate );
+    lock.lock();
+
+    if ( ! ok )
+      _failed = true;
+
+    _pending = 0;
+    _rotate = false;
+    _cond.notify_all();
+  }
+}
+
+/* Continue with the file opened in advance and open the one after it. */
+bool file_writer_c::rotate_file( double rate )
+{
+  if ( _next_fd < 0 ) /* opening it in advance failed, try once more */
+    _next_fd = open_file( _writer_index + 1, _next_direct );
+
+  if ( _next_fd < 0 ) {
+    std::cerr << "Failed to open " << file_path( _writer_index + 1 ) << ": "
+              << strerror(errno) << std::endl;
+    return false;
+  }
+
+  close( _fd );
+
+  if ( _sigmf ) {
+    write_sigmf_meta( file_path( _writer_index ), _format, rate, _done_captures );
+    write_sigmf_meta( file_path( _writer_index + 1 ), _format, rate, _next_captures );
+  }
+
+  _fd = _next_fd;
+  _direct = _next_direct;
+  _writer_index++;
+
+  /* while the buffers fill, so the next rotation doesn't wait for open() */
+  _next_fd = open_file( _writer_index + 1, _next_direct );
+  if ( _next_fd < 0 )
+    std::cerr << "Failed to open " << file_path( _writer_index + 1 )
+              << " in advance: " << strerror(errno) << std::endl;
+
+  return true;
+}
+
+/*
+ * The captures are kept in samples relative to the start of the file,
+ * \p sample is the position of the tagged sample within it.
+ */
+void file_writer_c::add_tag( const gr::tag_t &tag, uint64_t sample )
+{
+  if ( pmt::eq( tag.key, RX_RATE_KEY ) ) {
+    boost::mutex::scoped_lock lock( _mutex );
+    _rate = pmt::to_double( tag.value );
+  } else if ( pmt::eq( tag.key, RX_FREQ_KEY ) ) {
+    capture_at( sample ).freq = pmt::to_double( tag.value );
+  } else if ( pmt::eq( tag.key, RX_TIME_KEY ) ) {
+    sigmf_capture &capture = capture_at( sample );
+    capture.time = tag_to_time( tag.value );
+    capture.has_time = true;
+  }
+}
+
+/* \return the segment starting at \p sample, beginning a new one if necessary */
+sigmf_capture &file_writer_c::capture_at( uint64_t sample )
+{
+  if ( _captures.empty() || _captures.back().sample_start != sample )
+    _captures.push_back( capture_state( sample ) );
+
+  return _captures.back();
+}
+
+/* \return the frequency and time of \p sample, as of the last segment */
+sigmf_capture file_writer_c::capture_state( uint64_t sample ) const
+{
+  sigmf_capture state;
+
+  if ( ! _captures.empty() )
+    state = _captures.back();
+
+  double rate;
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    rate = _rate;
+  }
+
+  if ( state.has_time && rate > 0 )
+    state.time += osmosdr::time_spec_t( double(sample - state.sample_start) / rate );
+  else
+    state.has_time = false;
+
+  state.sample_start = sample;
+
+  return state;
+}
+
+bool file_writer_c::write_all( const unsigned char *buf, size_t len )
+{
+#ifdef O_DIRECT
+  /* O_DIRECT requires aligned sizes, the last buffer goes through the cache */
+  if ( _direct && (len % BUF_ALIGN) ) {
+    fcntl( _fd, F_SETFL, fcntl( _fd, F_GETFL ) & ~O_DIRECT );
+    _direct = false;
+  }
+#endif
+
+  while ( len ) {
+    ssize_t ret = write( _fd, buf, len );
+
+    if ( ret < 0 ) {
+      if ( EINTR == errno )
+        continue;
+#ifdef O_DIRECT
+      if ( EINVAL == errno && _direct ) {
+        /* e.g. appending at an unaligned offset, fall back to buffered I/O */
+        fcntl( _fd, F_SETFL, fcntl( _fd, F_GETFL ) & ~O_DIRECT );
+        _direct = false;
+        continue;
+      }
+#endif
+      perror( "file_writer_c: write" );
+      return false;
+    }
+
+    buf += ret;
+    len -= ret;
+  }
+
+  return true;
+}
+
+int file_writer_c::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  const uint64_t offset = nitems_read(0);
+  int consumed = 0;
+  size_t tag = 0;
+
+  _tags.clear();
+  if ( _sigmf ) {
+    get_tags_in_range( _tags, 0, offset, offset + noutput_items );
+    std::sort( _tags.begin(), _tags.end(), gr::tag_t::offset_compare );
+  }
+
+  while ( consumed < noutput_items ) {
+    if ( _failed )
+      return WORK_DONE;
+
+    unsigned char *dst = _buf[_fill] + _used;
+    size_t n = std::min( size_t(noutput_items - consumed),
+                         (BUF_SIZE - _used) / _sample_size );
+
+    if ( _rotate_items && _rotate_items - _file_items < n )
+      n = size_t( _rotate_items - _file_items );
+
+    /* the tags are recorded in the file holding their sample */
+    const uint64_t start = offset + consumed;
+    for ( ; tag < _tags.size() && _tags[tag].offset < start + n; tag++ )
+      add_tag( _tags[tag], _file_items + (_tags[tag].offset - start) );
+
+    if ( "sc16" == _format )
+      _convert_sc16( in + consumed, (int16_t *) dst, n );
+    else if ( "sc8" == _format )
+      _convert_sc8( in + consumed, (int8_t *) dst, n );
+    else
+      memcpy( dst, in + consumed, n * sizeof(gr_complex) );
+
+    consumed += n;
+    _used += n * _sample_size;
+    _file_items += n;
+
+    if ( _rotate_items && _file_items >= _rotate_items )
+      submit( true );
+    else if ( BUF_SIZE - _used < _sample_size )
+      submit();
+  }
+
+  return noutput_items;
+}
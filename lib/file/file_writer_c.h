@@ -0,0 +1,141 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FILE_WRITER_C_H
+#define FILE_WRITER_C_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "sample_convert.h"
+#include "sigmf.h"
+
+class file_writer_c;
+
+typedef boost::shared_ptr< file_writer_c > file_writer_c_sptr;
+
+file_writer_c_sptr make_file_writer_c( const std::string &filename,
+                                       const std::string &format = "fc32",
+                                       bool append = false,
+                                       bool direct = false,
+                                       uint64_t rotate_bytes = 0,
+                                       double rotate_secs = 0 );
+
+/*!
+ * Writes complex samples to a file as fc32, sc16 or sc8.
+ *
+ * work() only quantizes into one of two large buffers, a writer thread
+ * writes the other one to disk. With \p direct the file is opened with
+ * O_DIRECT where supported, so long recordings don't fill the page cache.
+ *
+ * With \p rotate_bytes or \p rotate_secs the recording continues in a new,
+ * numbered file once either limit is reached, capture.sigmf-data becomes
+ * capture_0000.sigmf-data, capture_0001.sigmf-data and so on. The next file
+ * is always opened in advance by the writer thread.
+ */
+class file_writer_c : public gr::sync_block
+{
+private:
+  friend file_writer_c_sptr make_file_writer_c( const std::string &filename,
+                                                const std::string &format,
+                                                bool append,
+                                                bool direct,
+                                                uint64_t rotate_bytes,
+                                                double rotate_secs );
+
+  file_writer_c( const std::string &filename, const std::string &format,
+                 bool append, bool direct,
+                 uint64_t rotate_bytes, double rotate_secs );
+
+public:
+  ~file_writer_c();
+
+  /*!
+   * Write a SigMF metadata file along with each data file, their captures
+   * arrays index the rx_freq and rx_time tags of the stream. \p rate and
+   * \p freq describe the samples until the first tags. Call before start().
+   */
+  void set_sigmf( double rate, double freq );
+
+  /*! Update the sample rate recorded in the metadata. */
+  void set_sample_rate( double rate );
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  std::string file_path( unsigned int index ) const;
+  int open_file( unsigned int index, bool &direct );
+  void submit( bool rotate = false );
+  void writer_task();
+  bool rotate_file( double rate );
+  bool write_all( const unsigned char *buf, size_t len );
+
+  void add_tag( const gr::tag_t &tag, uint64_t sample );
+  sigmf_capture &capture_at( uint64_t sample );
+  sigmf_capture capture_state( uint64_t sample ) const;
+
+  std::string _filename;
+  std::string _format;
+  size_t _sample_size;   /* bytes per sample on disk */
+  convert_to_16bit _convert_sc16;
+  convert_to_8bit _convert_sc8;
+  bool _append;
+  bool _want_direct;     /* direct has been requested */
+
+  int _fd;
+  bool _direct;          /* the file is currently opened with O_DIRECT */
+
+  uint64_t _rotate_bytes;
+  double _rotate_secs;
+  uint64_t _rotate_items; /* samples per file, 0 without rotation */
+  unsigned int _index;   /* number of the file being filled by work() */
+  unsigned int _writer_index; /* number of the file being written to */
+  uint64_t _file_items;  /* samples in that file, including appended ones */
+  int _next_fd;          /* opened in advance, -1 without rotation */
+  bool _next_direct;
+
+  bool _sigmf;
+  double _rate;
+  std::vector< sigmf_capture > _captures; /* of the file being filled */
+  std::vector< sigmf_capture > _done_captures; /* of the file being closed */
+  std::vector< sigmf_capture > _next_captures; /* its successor, at first */
+  std::vector< gr::tag_t > _tags;
+
+  unsigned char *_buf[2];
+  int _fill;             /* buffer being filled by work() */
+  size_t _used;          /* bytes in the buffer being filled */
+  size_t _pending;       /* bytes queued in the other buffer, 0 if idle */
+  bool _rotate;          /* the queued buffer completes its file */
+  bool _running;
+  bool _failed;
+
+  mutable boost::mutex _mutex;
+  boost::condition_variable _cond;
+  gr::thread::thread _thread;
+};
+
+#endif // FILE_WRITER_C_H
@@ -0,0 +1,368 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_SIGMF_H
+#define OSMOSDR_SIGMF_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "osmosdr/time_spec.h"
+
+/*
+ * Minimal support for the SigMF metadata sidecar of IQ recordings, just
+ * enough to replay captures with the right rate, frequency and sample format
+ * and to find the samples taken at a given time.
+ */
+
+/*!
+ * A segment of the captures array, starting whenever the frequency changed
+ * or the stream was interrupted.
+ */
+struct sigmf_capture
+{
+  sigmf_capture() : sample_start(0), freq(0), has_time(false) {}
+
+  uint64_t sample_start;      /* first sample of the segment in the file */
+  double freq;
+  bool has_time;              /* time is known, from an rx_time tag */
+  osmosdr::time_spec_t time;  /* UTC of the first sample */
+};
+
+/*! \return the .sigmf-meta file belonging to the data file \p filename */
+inline std::string sigmf_meta_path( const std::string &filename )
+{
+  std::string meta = filename;
+
+  if ( boost::algorithm::ends_with( meta, ".sigmf-data" ) )
+    meta.erase( meta.size() - strlen(".sigmf-data") );
+
+  return meta + ".sigmf-meta";
+}
+
+/*! Map a file format (fc32, sc16, sc8) to the SigMF datatype. */
+inline std::string sigmf_datatype( const std::string &format )
+{
+  if ( "sc16" == format )
+    return "ci16_le";
+  else if ( "sc8" == format )
+    return "ci8";
+
+  return "cf32_le";
+}
+
+/*! Map a SigMF datatype to a file format, empty if not supported. */
+inline std::string sigmf_format( const std::string &datatype )
+{
+  if ( "cf32_le" == datatype || "cf32" == datatype )
+    return "fc32";
+  else if ( "ci16_le" == datatype || "ci16" == datatype )
+    return "sc16";
+  else if ( "ci8" == datatype )
+    return "sc8";
+
+  return "";
+}
+
+/*
+ * SigMF times are ISO 8601 UTC strings, converted with the civil calendar
+ * algorithms of H. Hinnant instead of timegm(), which Windows lacks.
+ */
+
+/*! \return \p time as e.g. 2026-10-14T08:30:00.000000000Z */
+inline std::string sigmf_datetime( const osmosdr::time_spec_t &time )
+{
+  long long secs = time.get_full_secs();
+  long long nsecs = (long long)(time.get_frac_secs() * 1e9 + 0.5);
+  if ( nsecs >= 1000000000LL ) {
+    secs += 1;
+    nsecs -= 1000000000LL;
+  }
+
+  long long days = secs / 86400;
+  long long rem = secs % 86400;
+  if ( rem < 0 ) {
+    days -= 1;
+    rem += 86400;
+  }
+
+  days += 719468; /* days from 0000-03-01 to the epoch */
+  const long long era = (days >= 0 ? days : days - 146096) / 146097;
+  const long long doe = days - era * 146097;
+  const long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const long long mp = (5 * doy + 2) / 153;
+  const long long day = doy - (153 * mp + 2) / 5 + 1;
+  const long long month = mp < 10 ? mp + 3 : mp - 9;
+  const long long year = yoe + era * 400 + (month <= 2);
+
+  return str( boost::format( "%04d-%02d-%02dT%02d:%02d:%02d.%09dZ" )
+              % year % month % day
+              % (rem / 3600) % (rem / 60 % 60) % (rem % 60) % nsecs );
+}
+
+/*!
+ * Parse an ISO 8601 UTC time as written by sigmf_datetime().
+ * \return false if \p str isn't one
+ */
+inline bool sigmf_parse_datetime( const std::string &str, osmosdr::time_spec_t &time )
+{
+  int year, month, day, hour, minute, second, len = 0;
+
+  if ( sscanf( str.c_str(), "%d-%d-%dT%d:%d:%d%n",
+               &year, &month, &day, &hour, &minute, &second, &len ) != 6 )
+    return false;
+
+  if ( month < 1 || month > 12 || day < 1 || day > 31 )
+    return false;
+
+  double frac = 0;
+  if ( '.' == str.c_str()[len] )
+    frac = strtod( str.c_str() + len, NULL );
+
+  const long long y = year - (month <= 2);
+  const long long era = (y >= 0 ? y : y - 399) / 400;
+  const long long yoe = y - era * 400;
+  const long long doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  const long long days = era * 146097 + doe - 719468;
+
+  time = osmosdr::time_spec_t( time_t( days * 86400 + hour * 3600 + minute * 60 + second ),
+                               frac );
+  return true;
+}
+
+/*! Parse the metadata file belonging to \p filename into \p tree. */
+inline bool read_sigmf_tree( const std::string &filename,
+                             boost::property_tree::ptree &tree )
+{
+  const std::string meta = sigmf_meta_path( filename );
+
+  std::ifstream file( meta.c_str() );
+  if ( ! file.good() )
+    return false;
+
+  namespace pt = boost::property_tree;
+
+  try {
+    pt::read_json( file, tree );
+  } catch ( pt::json_parser_error &ex ) {
+    std::cerr << "Ignoring " << meta << ": " << ex.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/*!
+ * Pick up sample rate, center frequency and sample format of a SigMF
+ * recording. Values missing from the metadata are left untouched.
+ * \return false if there is no (valid) metadata file
+ */
+inline bool read_sigmf_meta( const std::string &filename,
+                             double &rate, double &freq, std::string &format )
+{
+  const std::string meta = sigmf_meta_path( filename );
+
+  namespace pt = boost::property_tree;
+  pt::ptree tree;
+
+  if ( ! read_sigmf_tree( filename, tree ) )
+    return false;
+
+  /* keys contain ':', so use '/' as the path separator */
+  typedef pt::ptree::path_type path;
+
+  std::string datatype = tree.get( path("global/core:datatype", '/'), "" );
+  if ( datatype.length() ) {
+    if ( sigmf_format( datatype ).length() )
+      format = sigmf_format( datatype );
+    else
+      std::cerr << "WARNING: " << meta << " specifies unsupported datatype "
+                << datatype << ", the samples are read as "
+                << sigmf_datatype( format ) << std::endl;
+  }
+
+  rate = tree.get( path("global/core:sample_rate", '/'), rate );
+
+  boost::optional< pt::ptree & > captures = tree.get_child_optional( "captures" );
+  if ( captures ) {
+    BOOST_FOREACH( pt::ptree::value_type &capture, *captures ) {
+      freq = capture.second.get( path("core:frequency", '/'), freq );
+      break; /* the first segment describes the start of the file */
+    }
+  }
+
+  return true;
+}
+
+inline bool sigmf_start_less( const sigmf_capture &a, const sigmf_capture &b )
+{
+  return a.sample_start < b.sample_start;
+}
+
+/*!
+ * Read the captures array of a SigMF recording, sorted by sample_start.
+ * \return false if there is no (valid) metadata file
+ */
+inline bool read_sigmf_captures( const std::string &filename,
+                                 std::vector< sigmf_capture > &captures )
+{
+  namespace pt = boost::property_tree;
+  pt::ptree tree;
+
+  if ( ! read_sigmf_tree( filename, tree ) )
+    return false;
+
+  typedef pt::ptree::path_type path;
+
+  captures.clear();
+
+  boost::optional< pt::ptree & > list = tree.get_child_optional( "captures" );
+  if ( list ) {
+    BOOST_FOREACH( pt::ptree::value_type &entry, *list ) {
+      sigmf_capture capture;
+
+      capture.sample_start = entry.second.get< uint64_t >( path("core:sample_start", '/'), 0 );
+      capture.freq = entry.second.get( path("core:frequency", '/'), 0.0 );
+      capture.has_time = sigmf_parse_datetime(
+            entry.second.get( path("core:datetime", '/'), "" ), capture.time );
+
+      captures.push_back( capture );
+    }
+  }
+
+  std::stable_sort( captures.begin(), captures.end(), sigmf_start_less );
+
+  return true;
+}
+
+inline bool sigmf_time_less( const osmosdr::time_spec_t &time, const sigmf_capture &capture )
+{
+  return time < capture.time;
+}
+
+/*!
+ * Find the sample taken at \p time in a recording at \p rate, by a binary
+ * search of \p captures as returned by read_sigmf_captures().
+ * \return false if no segment of a known time starts before \p time
+ */
+inline bool sigmf_find_time( const std::vector< sigmf_capture > &captures, double rate,
+                             const osmosdr::time_spec_t &time, uint64_t &sample )
+{
+  /* segments before the first rx_time tag have no time, all others have */
+  std::vector< sigmf_capture >::const_iterator first = captures.begin();
+  while ( first != captures.end() && ! first->has_time )
+    ++first;
+
+  std::vector< sigmf_capture >::const_iterator it =
+      std::upper_bound( first, captures.end(), time, sigmf_time_less );
+
+  if ( it == first )
+    return false;
+
+  --it; /* the last segment starting before time */
+
+  double offset = (time - it->time).get_real_secs() * rate;
+  sample = it->sample_start + uint64_t( offset + 0.5 );
+
+  /* a gap in time (overflow) between segments, start with the next one */
+  if ( it + 1 != captures.end() && sample > (it + 1)->sample_start )
+    sample = (it + 1)->sample_start;
+
+  return true;
+}
+
+/*!
+ * Write the metadata file for a recording into \p filename, with one entry
+ * of the captures array for each of \p captures.
+ * \return false if the file could not be written
+ */
+inline bool write_sigmf_meta( const std::string &filename, const std::string &format,
+                              double rate, const std::vector< sigmf_capture > &captures )
+{
+  const std::string meta = sigmf_meta_path( filename );
+
+  FILE *fp = fopen( meta.c_str(), "w" );
+  if ( ! fp ) {
+    std::cerr << "Failed to write " << meta << std::endl;
+    return false;
+  }
+
+  /* property_tree would quote the numbers, so the json is written by hand */
+  fprintf( fp,
+           "{\n"
+           "    \"global\": {\n"
+           "        \"core:datatype\": \"%s\",\n"
+           "        \"core:sample_rate\": %.17g,\n"
+           "        \"core:version\": \"1.0.0\",\n"
+           "        \"core:recorder\": \"gr-osmosdr\"\n"
+           "    },\n"
+           "    \"captures\": [",
+           sigmf_datatype( format ).c_str(), rate );
+
+  for ( size_t i = 0; i < captures.size(); i++ ) {
+    fprintf( fp,
+             "%s\n"
+             "        {\n"
+             "            \"core:sample_start\": %llu,\n"
+             "            \"core:frequency\": %.17g",
+             i ? "," : "",
+             (unsigned long long) captures[i].sample_start, captures[i].freq );
+
+    if ( captures[i].has_time )
+      fprintf( fp, ",\n            \"core:datetime\": \"%s\"",
+               sigmf_datetime( captures[i].time ).c_str() );
+
+    fprintf( fp, "\n        }" );
+  }
+
+  fprintf( fp,
+           "\n"
+           "    ],\n"
+           "    \"annotations\": []\n"
+           "}\n" );
+
+  return 0 == fclose( fp );
+}
+
+/*! As above, for a recording of a single segment at \p freq. */
+inline bool write_sigmf_meta( const std::string &filename, const std::string &format,
+                              double rate, double freq )
+{
+  std::vector< sigmf_capture > captures( 1 );
+  captures[0].freq = freq;
+
+  return write_sigmf_meta( filename, format, rate, captures );
+}
+
+#endif // OSMOSDR_SIGMF_H
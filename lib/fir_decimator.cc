@@ -0,0 +1,111 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "fir_decimator.h"
+
+#define BLOCK_SAMPLES 4096 /* new input samples buffered at most */
+
+fir_decimator::fir_decimator( unsigned int decim ) :
+  _decim(decim ? decim : 1)
+{
+  if ( _decim > 1 ) {
+    const double transition = 0.2 / _decim; /* normalized to the input rate */
+    const double cutoff = 0.5 / _decim;
+    const size_t ntaps = size_t( ceil( 3.3 / transition ) ) | 1;
+
+    _taps.resize( ntaps );
+
+    double sum = 0;
+    for (size_t k = 0; k < ntaps; k++) {
+      const double m = double(k) - (ntaps - 1) / 2.0;
+      const double window = 0.54 - 0.46 * cos( 2 * M_PI * k / (ntaps - 1) );
+
+      _taps[k] = (0 == m ? 2 * cutoff : sin( 2 * M_PI * cutoff * m ) / (M_PI * m)) * window;
+      sum += _taps[k];
+    }
+
+    for (size_t k = 0; k < ntaps; k++)
+      _taps[k] /= sum;
+  } else {
+    _taps.assign( 1, 1.0f );
+  }
+
+  _buf.resize( _taps.size() - 1 + BLOCK_SAMPLES );
+
+  reset();
+}
+
+void fir_decimator::reset()
+{
+  std::fill( _buf.begin(), _buf.end(), gr_complex( 0, 0 ) );
+
+  _fill = _taps.size() - 1;
+  _skip = 0;
+}
+
+size_t fir_decimator::filter( size_t nsamples, gr_complex *out )
+{
+  const size_t ntaps = _taps.size();
+  const float *taps = &_taps[0];
+  const size_t end = _fill + nsamples;
+  size_t produced = 0;
+  size_t i;
+
+  for (i = _fill + _skip; i < end; i += _decim) {
+    /* real taps, so I and Q are filtered independently */
+    const float *in = (const float *) &_buf[i + 1 - ntaps];
+    float re0 = 0, im0 = 0, re1 = 0, im1 = 0;
+    size_t k = 0;
+
+    for (; k + 1 < ntaps; k += 2) {
+      re0 += in[2 * k + 0] * taps[k];
+      im0 += in[2 * k + 1] * taps[k];
+      re1 += in[2 * k + 2] * taps[k + 1];
+      im1 += in[2 * k + 3] * taps[k + 1];
+    }
+
+    if ( k < ntaps ) {
+      re0 += in[2 * k + 0] * taps[k];
+      im0 += in[2 * k + 1] * taps[k];
+    }
+
+    out[produced++] = gr_complex( re0 + re1, im0 + im1 );
+  }
+
+  _skip = i - end;
+  _fill = end;
+
+  if ( _fill == _buf.size() ) {
+    /* keep the history for the next block */
+    memmove( &_buf[0], &_buf[_fill - (ntaps - 1)], (ntaps - 1) * sizeof(gr_complex) );
+    _fill = ntaps - 1;
+  }
+
+  return produced;
+}
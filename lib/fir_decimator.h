@@ -0,0 +1,100 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_FIR_DECIMATOR_H
+#define OSMOSDR_FIR_DECIMATOR_H
+
+#include <cstddef>
+#include <vector>
+
+#include <gnuradio/gr_complex.h>
+
+#include <osmosdr/api.h>
+#include <osmosdr/ranges.h>
+
+/*!
+ * \brief Decimating low pass for use inside a source's work().
+ *
+ * The driver converts its raw samples straight into input() and calls
+ * filter() on them, so the full rate float stream only ever lives in a
+ * small, cache resident buffer and never in a gnuradio buffer:
+ *
+ *   size_t space;
+ *   gr_complex *in = decim.input( space );
+ *   n = min( n, space, decim.max_input( noutput_items ) );
+ *   convert( raw, in, n );
+ *   produced += decim.filter( n, out + produced );
+ *
+ * The filter is a Hamming windowed sinc with its transition band over the
+ * outer 20 % of the decimated band, and a gain of 1.
+ */
+class OSMOSDR_API fir_decimator
+{
+public:
+  explicit fir_decimator( unsigned int decim = 1 );
+
+  /*! \return true if decimating at all */
+  bool enabled() const { return _decim > 1; }
+
+  unsigned int decimation() const { return _decim; }
+
+  /*! \return the sample rates \p device supports, after decimation */
+  osmosdr::meta_range_t rates( const osmosdr::meta_range_t &device ) const
+  {
+    osmosdr::meta_range_t range;
+
+    for (size_t i = 0; i < device.size(); i++)
+      range.push_back( osmosdr::range_t( device[i].start() / _decim,
+                                         device[i].stop() / _decim,
+                                         device[i].step() / _decim ) );
+
+    return range;
+  }
+
+  /*! \return where up to \p space new input samples are to be written */
+  gr_complex *input( size_t &space )
+  {
+    space = _buf.size() - _fill;
+    return &_buf[_fill];
+  }
+
+  /*! \return the most input samples producing no more than \p noutput */
+  size_t max_input( size_t noutput ) const
+  {
+    return _skip + noutput * _decim;
+  }
+
+  /*!
+   * Filter the \p nsamples samples written to input().
+   * \return the number of samples written to \p out
+   */
+  size_t filter( size_t nsamples, gr_complex *out );
+
+  /*! Forget the history, after a discontinuity for example. */
+  void reset();
+
+private:
+  unsigned int _decim;
+  std::vector< float > _taps;  /* symmetric, so no need to reverse them */
+  std::vector< gr_complex > _buf; /* history followed by the new input */
+  size_t _fill;
+  size_t _skip; /* input samples to skip before the next output */
+};
+
+#endif // OSMOSDR_FIR_DECIMATOR_H
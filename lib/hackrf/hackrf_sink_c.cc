@@ -31,21 +31,19 @@
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
-#ifdef USE_AVX
-#include <immintrin.h>
-#elif USE_SSE2
-#include <emmintrin.h>
-#endif
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
 #include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/foreach.hpp>
 
 #include <gnuradio/io_signature.h>
 
 #include "hackrf_sink_c.h"
+#include "backend_registry.h"
+#include "stream_tags.h"
 
 #include "arg_helpers.h"
 
@@ -68,64 +66,6 @@ using namespace boost::assign;
 #define HACKRF_FUNC_STR(func, arg) \
   boost::str(boost::format(func "(%d)") % arg) + " has failed"
 
-static inline bool cb_init(circular_buffer_t *cb, size_t capacity, size_t sz)
-{
-  cb->buffer = malloc(capacity * sz);
-  if(cb->buffer == NULL)
-    return false; // handle error
-  cb->buffer_end = (int8_t *)cb->buffer + capacity * sz;
-  cb->capacity = capacity;
-  cb->count = 0;
-  cb->sz = sz;
-  cb->head = cb->buffer;
-  cb->tail = cb->buffer;
-  return true;
-}
-
-static inline void cb_free(circular_buffer_t *cb)
-{
-  free(cb->buffer);
-  cb->buffer = NULL;
-  // clear out other fields too, just to be safe
-  cb->buffer_end = 0;
-  cb->capacity = 0;
-  cb->count = 0;
-  cb->sz = 0;
-  cb->head = 0;
-  cb->tail = 0;
-}
-
-static inline bool cb_has_room(circular_buffer_t *cb)
-{
-  if(cb->count == cb->capacity)
-    return false;
-  return true;
-}
-
-static inline bool cb_push_back(circular_buffer_t *cb, const void *item)
-{
-  if(cb->count == cb->capacity)
-    return false; // handle error
-  memcpy(cb->head, item, cb->sz);
-  cb->head = (int8_t *)cb->head + cb->sz;
-  if(cb->head == cb->buffer_end)
-    cb->head = cb->buffer;
-  cb->count++;
-  return true;
-}
-
-static inline bool cb_pop_front(circular_buffer_t *cb, void *item)
-{
-  if(cb->count == 0)
-    return false; // handle error
-  memcpy(item, cb->tail, cb->sz);
-  cb->tail = (int8_t *)cb->tail + cb->sz;
-  if(cb->tail == cb->buffer_end)
-    cb->tail = cb->buffer;
-  cb->count--;
-  return true;
-}
-
 int hackrf_sink_c::_usage = 0;
 boost::mutex hackrf_sink_c::_usage_mutex;
 
@@ -134,6 +74,12 @@ hackrf_sink_c_sptr make_hackrf_sink_c (const std::string & args)
   return gnuradio::get_initial_sptr(new hackrf_sink_c (args));
 }
 
+static sink_registrar hackrf_registrar(
+  "hackrf",
+  &make_backend< sink_iface, hackrf_sink_c_sptr, &make_hackrf_sink_c >,
+  &ignore_fake< &hackrf_sink_c::get_devices >,
+  BACKEND_HARDWARE, 80 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -157,6 +103,11 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     _dev(NULL),
     _buf(NULL),
+    _idle(true),
+    _time_warned(false),
+    _preroll_bufs(0),
+    _priming(false),
+    _convert(127.0f),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0),
@@ -243,9 +194,14 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
     }
   }
 
-  _buf = (int8_t *) malloc( BUF_LEN );
+  _ring.alloc( _buf_num, BUF_LEN, buffer_pool_params( dict ) );
 
-  cb_init( &_cbuf, _buf_num, BUF_LEN );
+  _underrun = tx_underrun_params( dict );
+  _preroll_bufs = std::min( size_t(_buf_num),
+                            (_underrun.preroll * BYTES_PER_SAMPLE + BUF_LEN - 1) / BUF_LEN );
+  _priming = (_preroll_bufs > 0);
+
+  message_port_register_out( STREAM_STATS_PORT );
 
 //  _thread = gr::thread::thread(_hackrf_wait, this);
 
@@ -260,6 +216,7 @@ hackrf_sink_c::~hackrf_sink_c ()
 {
   if (_dev) {
 //    _thread.join();
+    _ring.cancel(); /* a stalled tx callback returns */
     int ret = hackrf_stop_tx( _dev );
     HACKRF_THROW_ON_ERROR(ret, "Failed to stop TX streaming")
     ret = hackrf_close( _dev );
@@ -275,11 +232,6 @@ hackrf_sink_c::~hackrf_sink_c ()
         hackrf_exit(); /* call only once after last close */
     }
   }
-
-  free(_buf);
-  _buf = NULL;
-
-  cb_free( &_cbuf );
 }
 
 int hackrf_sink_c::_hackrf_tx_callback(hackrf_transfer *transfer)
@@ -294,16 +246,42 @@ int hackrf_sink_c::hackrf_tx_callback(unsigned char *buffer, uint32_t length)
   for (unsigned int i = 0; i < length; ++i) /* simulate noise */
     *buffer++ = rand() % 255;
 #else
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
+  /* hold back until enough buffers are queued, or the whole burst is */
+  if ( _priming ) {
+    const size_t used = _ring.used();
+    _priming = ! ( used >= _preroll_bufs || (used && _idle.load()) );
+  }
 
-    if ( ! cb_pop_front( &_cbuf, buffer ) ) {
+  /* libhackrf owns the transfer buffers, so this is the only copy left */
+  size_t len = 0;
+  const unsigned char *buf = _priming ? NULL : _ring.front( &len );
+
+  /* stalling blocks the usb thread until work() catches up */
+  if ( ! buf && ! _priming && ! _idle.load() &&
+       tx_underrun_params::STALL == _underrun.policy && _ring.wait( 1 ) )
+    buf = _ring.front( &len );
+
+  if ( buf ) {
+    len = std::min( len, size_t(length) );
+    memcpy(buffer, buf, len);
+    memset(buffer + len, 0, length - len); /* the end of a burst */
+    _ring.pop();
+
+    if ( tx_underrun_params::REPEAT == _underrun.policy )
+      _last.assign( buffer, buffer + length );
+  } else if ( _priming || _idle.load() ) {
+    memset(buffer, 0, length);
+    _priming = (_preroll_bufs > 0); /* the next burst is pre-rolled again */
+  } else {
+    if ( _last.size() == length )
+      memcpy(buffer, &_last[0], length);
+    else
       memset(buffer, 0, length);
-      std::cerr << "U" << std::flush;
-    } else {
-//      std::cerr << "-" << std::flush;
-      _buf_cond.notify_one();
-    }
+
+    _stats.overflow( length / BYTES_PER_SAMPLE );
+    std::cerr << "U" << std::flush;
+
+    _priming = (_preroll_bufs > 0);
   }
 #endif
   return 0; // TODO: return -1 on error/stop
@@ -324,6 +302,7 @@ bool hackrf_sink_c::start()
     return false;
 
   _buf_used = 0;
+  _idle.store( true );
 #if 0
   int ret = hackrf_start_tx( _dev, _hackrf_tx_callback, (void *)this );
   if ( ret != HACKRF_SUCCESS ) {
@@ -348,66 +327,18 @@ bool hackrf_sink_c::stop()
   return true;
 }
 
-#ifdef USE_AVX
-void convert_avx(const float* inbuf, int8_t* outbuf,const unsigned int count)
+/* Queue the partially filled buffer, the tx callback pads it with zeros. */
+void hackrf_sink_c::flush_buffer(bool end)
 {
-  __m256 mulme = _mm256_set_ps(127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f);
-  for(unsigned int i=0; i<count;i++){
-
-  __m256i itmp3 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&inbuf[i*16+0]), mulme));
-  __m256i itmp4 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&inbuf[i*16+8]), mulme));
-
-  __m128i a1 = _mm256_extractf128_si256(itmp3, 1);
-  __m128i a0 = _mm256_castsi256_si128(itmp3);
-  __m128i a3 = _mm256_extractf128_si256(itmp4, 1);
-  __m128i a2 = _mm256_castsi256_si128(itmp4);
-
-  __m128i outshorts1 = _mm_packs_epi32(a0, a1);
-  __m128i outshorts2 = _mm_packs_epi32(a2, a3);
-
-  __m128i outbytes = _mm_packs_epi16(outshorts1, outshorts2);
+  /* an underrun right after the last buffer of a burst is expected */
+  if ( end )
+    _idle.store( true );
 
-  _mm_storeu_si128 ((__m128i*)&outbuf[i*16], outbytes);
-  }
-}
-
-#elif USE_SSE2
-void convert_sse2(const float* inbuf, int8_t* outbuf,const unsigned int count)
-{
-  const register __m128 mulme = _mm_set_ps( 127.0f, 127.0f, 127.0f, 127.0f );
-  __m128 itmp1,itmp2,itmp3,itmp4;
-  __m128i otmp1,otmp2,otmp3,otmp4;
-
-  __m128i outshorts1,outshorts2;
-  __m128i outbytes;
-
-  for(unsigned int i=0; i<count;i++){
-
-  itmp1 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+0]), mulme);
-  itmp2 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+4]), mulme);
-  itmp3 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+8]), mulme);
-  itmp4 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+12]), mulme);
-
-  otmp1 = _mm_cvtps_epi32(itmp1);
-  otmp2 = _mm_cvtps_epi32(itmp2);
-  otmp3 = _mm_cvtps_epi32(itmp3);
-  otmp4 = _mm_cvtps_epi32(itmp4);
-
-  outshorts1 = _mm_packs_epi32(otmp1, otmp2);
-  outshorts2 = _mm_packs_epi32(otmp3, otmp4);
-
-  outbytes = _mm_packs_epi16(outshorts1, outshorts2);
-
-  _mm_storeu_si128 ((__m128i*)&outbuf[i*16], outbytes);
-  }
-}
-#endif
+  _ring.commit( _buf_used );
+  _buf = NULL;
 
-void convert_default(float* inbuf, int8_t* outbuf,const unsigned int count)
-{
-  for(unsigned int i=0; i<count;i++){
-    outbuf[i]= inbuf[i]*127;
-  }
+  if ( ! end )
+    _idle.store( false );
 }
 
 int hackrf_sink_c::work( int noutput_items,
@@ -415,55 +346,77 @@ int hackrf_sink_c::work( int noutput_items,
                          gr_vector_void_star &output_items )
 {
   const gr_complex *in = (const gr_complex *) input_items[0];
+  int nitems = noutput_items;
+  bool eob = false;
+
+  /* a burst starts in a buffer of its own and its end is queued right
+   * away, instead of waiting for the samples of the next one */
+  std::vector< gr::tag_t > tags;
+  get_tags_in_range( tags, 0, nitems_read(0), nitems_read(0) + noutput_items );
+  std::sort( tags.begin(), tags.end(), gr::tag_t::offset_compare );
+
+  BOOST_FOREACH( const gr::tag_t &tag, tags ) {
+    const int rel = int( tag.offset - nitems_read(0) );
+    if ( rel >= nitems )
+      break;
+
+    if ( pmt::eq( tag.key, TX_TIME_KEY ) || pmt::eq( tag.key, TX_SOB_KEY ) ) {
+      if ( rel > 0 ) {
+        nitems = rel;
+        break;
+      }
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
+      if ( pmt::eq( tag.key, TX_TIME_KEY ) && ! _time_warned ) {
+        std::cerr << "HackRF can't transmit at a given time, "
+                  << "ignoring tx_time tags." << std::endl;
+        _time_warned = true;
+      }
 
-    while ( ! cb_has_room(&_cbuf) )
-      _buf_cond.wait( lock );
+      if ( _buf && _buf_used )
+        flush_buffer( true );
+    } else if ( pmt::eq( tag.key, TX_EOB_KEY ) ) {
+      nitems = rel + 1;
+      eob = true;
+      break;
+    }
   }
 
+  if ( ! _buf ) {
+    /* wait for the tx callback to hand a buffer back */
+    if ( ! _ring.wait_free( 1 ) )
+      return WORK_DONE;
+
+    _buf = (int8_t *) _ring.acquire();
+    _buf_used = 0;
+
+    _stats.fill( _ring.used() * BUF_LEN / BYTES_PER_SAMPLE,
+                 _ring.num() * BUF_LEN / BYTES_PER_SAMPLE );
+  }
+
+  /* convert straight into the ring buffer */
   int8_t *buf = _buf + _buf_used;
-  unsigned int prev_buf_used = _buf_used;
 
   unsigned int remaining = (BUF_LEN-_buf_used)/2; //complex
 
-  unsigned int count = std::min((unsigned int)noutput_items,remaining);
-  unsigned int sse_rem = count/8; // 8 complex = 16f==512bit for avx
-  unsigned int nosse_rem = count%8; // remainder
+  unsigned int count = std::min((unsigned int)nitems,remaining);
 
-#ifdef USE_AVX
-  convert_avx((float*)in, buf, sse_rem);
-  convert_default((float*)(in+sse_rem*8), buf+(sse_rem*8*2), nosse_rem*2);
-#elif USE_SSE2
-  convert_sse2((float*)in, buf, sse_rem);
-  convert_default((float*)(in+sse_rem*8), buf+(sse_rem*8*2), nosse_rem*2);
-#else
-  convert_default((float*)in, buf, count*2);
-#endif
+  _convert( in, buf, count );
 
-  _buf_used += (sse_rem*8+nosse_rem)*2;
-  int items_consumed = sse_rem*8+nosse_rem;
+  _buf_used += count*2;
+  int items_consumed = count;
 
-  if((unsigned int)noutput_items >= remaining) {
-    {
-      boost::mutex::scoped_lock lock( _buf_mutex );
-
-      if ( ! cb_push_back( &_cbuf, _buf ) ) {
-        _buf_used = prev_buf_used;
-        items_consumed = 0;
-        std::cerr << "O" << std::flush;
-      } else {
-//        std::cerr << "+" << std::flush;
-        _buf_used = 0;
-      }
-    }
-  }
+  if ( eob && count == (unsigned int)nitems )
+    flush_buffer( true );
+  else if ( _buf_used == BUF_LEN )
+    flush_buffer( false );
 
   // Tell runtime system how many input items we consumed on
   // each input stream.
   consume_each(items_consumed);
 
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
   // Tell runtime system how many output items we produced.
   return 0;
 }
@@ -821,3 +774,8 @@ osmosdr::freq_range_t hackrf_sink_c::get_bandwidth_range( size_t chan )
 
   return bandwidths;
 }
+
+osmosdr::stream_stats_t hackrf_sink_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
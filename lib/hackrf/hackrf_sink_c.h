@@ -23,26 +23,19 @@
 #include <gnuradio/thread/thread.h>
 #include <gnuradio/sync_block.h>
 
+#include <boost/atomic.hpp>
 #include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
 
 #include <libhackrf/hackrf.h>
 
 #include "sink_iface.h"
+#include "stream_stats.h"
+#include "transfer_ring.h"
+#include "sample_convert.h"
+#include "tx_underrun.h"
 
 class hackrf_sink_c;
 
-typedef struct circular_buffer
-{
-  void *buffer;     // data buffer
-  void *buffer_end; // end of data buffer
-  size_t capacity;  // maximum number of items in the buffer
-  size_t count;     // number of items in the buffer
-  size_t sz;        // size of each item in the buffer
-  void *head;       // pointer to head
-  void *tail;       // pointer to tail
-} circular_buffer_t;
-
 /*
  * We use boost::shared_ptr's instead of raw pointers for all access
  * to gr::blocks (and many other data structures).  The shared_ptr gets
@@ -121,11 +114,14 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   static int _hackrf_tx_callback(hackrf_transfer* transfer);
   int hackrf_tx_callback(unsigned char *buffer, uint32_t length);
   static void _hackrf_wait(hackrf_sink_c *obj);
   void hackrf_wait();
+  void flush_buffer(bool end);
 
   static int _usage;
   static boost::mutex _usage_mutex;
@@ -133,12 +129,18 @@ private:
   hackrf_device *_dev;
 //  gr::thread::thread _thread;
 
-  circular_buffer_t _cbuf;
-  int8_t *_buf;
+  transfer_ring _ring;
+  int8_t *_buf; /* ring buffer being filled by work(), if any */
   unsigned int _buf_num;
   unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
+  boost::atomic<bool> _idle; /* between bursts, zeros are sent on purpose */
+  bool _time_warned;
+  tx_underrun_params _underrun;
+  size_t _preroll_bufs;
+  bool _priming;             /* of the tx callback only, like _last */
+  std::vector<unsigned char> _last; /* the transfer to repeat */
+  convert_to_8bit _convert;
+  stream_stats _stats;
 
   double _sample_rate;
   double _center_freq;
@@ -27,28 +27,38 @@
 #include "config.h"
 #endif
 
+#include <cmath>
 #include <stdexcept>
 #include <iostream>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
-#include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/thread/thread.hpp>
 
 #include <gnuradio/io_signature.h>
+#include <gnuradio/fft/window.h>
 
 #include "hackrf_source_c.h"
+#include "backend_registry.h"
 
-#include "arg_helpers.h"
+#include "stream_tags.h"
+#include "spectrum_probe.h"
+#include "trace.h"
 
 using namespace boost::assign;
 
 #define BUF_LEN  (16 * 32 * 512) /* must be multiple of 512 */
 #define BUF_NUM   15
+#define PREFILL   3 /* buffers queued before work() produces */
 
 #define BYTES_PER_SAMPLE  2 /* HackRF device produces 8 bit unsigned IQ data */
 
+/* in sweep mode each transfer holds blocks of one hop each, starting with
+ * 0x7f 0x7f and the frequency of the hop as little endian uint64 */
+#define SWEEP_BLOCK_SAMPLES  (16384 / BYTES_PER_SAMPLE)
+#define SWEEP_HEADER_SAMPLES (10 / BYTES_PER_SAMPLE)
+
 #define HACKRF_FORMAT_ERROR(ret) \
   boost::str( boost::format("(%d) %s") \
     % ret % hackrf_error_name((enum hackrf_error)ret) ) \
@@ -69,6 +79,12 @@ hackrf_source_c_sptr make_hackrf_source_c (const std::string & args)
   return gnuradio::get_initial_sptr(new hackrf_source_c (args));
 }
 
+static source_registrar hackrf_registrar(
+  "hackrf",
+  &make_backend< source_iface, hackrf_source_c_sptr, &make_hackrf_source_c >,
+  &ignore_fake< &hackrf_source_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_RETUNE_TAGS, 80 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -89,9 +105,10 @@ static const int MAX_OUT = 1;	// maximum number of output streams
 hackrf_source_c::hackrf_source_c (const std::string &args)
   : gr::sync_block ("hackrf_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
-        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+        gr::io_signature::make(MIN_OUT, MAX_OUT, args_to_item_size(args, "sc8"))),
+    _sc8(args_to_item_size(args, "sc8") != sizeof (gr_complex)),
     _dev(NULL),
-    _buf(NULL),
+    _prefill(latency_profile(params_to_dict(args)).prefill(PREFILL)),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0),
@@ -99,14 +116,26 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
     _amp_gain(0),
     _lna_gain(0),
     _vga_gain(0),
-    _bandwidth(0)
+    _bandwidth(0),
+    _sweep(false),
+    _sweep_step(0),
+    _sweep_blocks(1),
+    _hop_freq(0),
+    _hop(0),
+    _sweeps(0),
+    _fft_size(0),
+    _norm(1),
+    _count(0),
+    _stream(_stats, "hackrf", 0.0f, 1.0f/128.0f)
 {
   int ret;
   std::string hackrf_serial;
 
   dict_t dict = params_to_dict(args);
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  _rx_thread = rx_thread_params( dict );
+
+  _buf_num = _buf_len = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -120,17 +149,23 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
   if (0 == _buf_len || _buf_len % 512 != 0) /* len must be multiple of 512 */
     _buf_len = BUF_LEN;
 
-  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+  if (dict.count("decim")) {
+    unsigned int decim = boost::lexical_cast< unsigned int >( dict["decim"] );
 
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i <= 0xffff; i++) {
-#ifdef BOOST_LITTLE_ENDIAN
-    _lut.push_back( gr_complex( (float(int8_t(i & 0xff))) * (1.0f/128.0f),
-                                (float(int8_t(i >> 8))) * (1.0f/128.0f) ) );
-#else // BOOST_BIG_ENDIAN
-    _lut.push_back( gr_complex( (float(int8_t(i >> 8))) * (1.0f/128.0f),
-                                (float(int8_t(i & 0xff))) * (1.0f/128.0f) ) );
-#endif
+    if ( decim > 1 && _sc8 )
+      throw std::runtime_error("Decimation requires cpu_format=fc32.");
+
+    if ( decim > 1 )
+      std::cerr << "Decimating by " << decim << "." << std::endl;
+
+    _decim = fir_decimator( decim );
+  }
+
+  if (dict.count("sweep")) {
+    if ( _decim.enabled() )
+      throw std::runtime_error("Decimation is not supported in sweep mode.");
+
+    parse_sweep( dict );
   }
 
   {
@@ -184,15 +219,25 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
   ret = hackrf_version_string_read( _dev, version, sizeof(version));
   HACKRF_THROW_ON_ERROR(ret, "Failed to read version string")
 
-#if 0
+  /* if the firmware can't tell, go by the serial opened, not an index */
+  std::string serial = hackrf_serial.length() > 1 ? hackrf_serial : "";
+
   read_partid_serialno_t serial_number;
   ret = hackrf_board_partid_serialno_read( _dev, &serial_number );
-  HACKRF_THROW_ON_ERROR(ret, "Failed to read serial number")
-#endif
+  if ( HACKRF_SUCCESS == ret )
+    serial = str( boost::format( "%08x%08x%08x%08x" )
+                  % serial_number.serial_no[0] % serial_number.serial_no[1]
+                  % serial_number.serial_no[2] % serial_number.serial_no[3] );
+
   std::cerr << "Using " << hackrf_board_id_name(hackrf_board_id(board_id)) << " "
             << "with firmware " << version << " "
             << std::endl;
 
+  /* the DC/IQ estimates differ from board to board */
+  if ( serial.length() )
+    _device_id = "hackrf-" + serial + "-" +
+                 hackrf_board_id_name(hackrf_board_id(board_id)) + "-" + version;
+
   if ( BUF_NUM != _buf_num || BUF_LEN != _buf_len ) {
     std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
               << std::endl;
@@ -222,19 +267,88 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
     }
   }
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
+  _stream.alloc( _buf_num, _buf_len, buffer_pool_params( dict ) );
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(_buf_len);
-  }
+  message_port_register_out( STREAM_STATS_PORT );
 
 //  _thread = gr::thread::thread(_hackrf_wait, this);
 
+#ifdef LIBHACKRF_HAVE_SWEEP
+  if ( _sweep ) {
+    /* each hop tuned half a step above its lower edge, centering it */
+    ret = hackrf_init_sweep( _dev, &_sweep_range[0], _sweep_range.size() / 2,
+                             _sweep_blocks * SWEEP_BLOCK_SAMPLES * BYTES_PER_SAMPLE,
+                             uint32_t(_sweep_step), uint32_t(_sweep_step / 2), LINEAR );
+    HACKRF_THROW_ON_ERROR(ret, "Failed to initialize the sweep")
+
+    ret = hackrf_start_rx_sweep( _dev, _hackrf_rx_callback, (void *)this );
+    HACKRF_THROW_ON_ERROR(ret, "Failed to start the sweep")
+
+    return;
+  }
+#endif
+
   ret = hackrf_start_rx( _dev, _hackrf_rx_callback, (void *)this );
   HACKRF_THROW_ON_ERROR(ret, "Failed to start RX streaming")
 }
 
+/*
+ * sweep=start:stop:step in Hz, rounded outwards to whole MHz as the
+ * firmware takes them, [sweep_dwell=blocks] of 8192 samples per hop and
+ * [sweep_fft=bins] to publish a power spectrum per hop.
+ */
+void hackrf_source_c::parse_sweep( const dict_t &dict )
+{
+#ifndef LIBHACKRF_HAVE_SWEEP
+  throw std::runtime_error("This libhackrf doesn't support the sweep mode.");
+#endif
+  const std::string plan = dict.find("sweep")->second;
+
+  std::vector< std::string > parts;
+  boost::algorithm::split( parts, plan, boost::is_any_of( ":" ) );
+
+  if ( parts.size() != 3 )
+    throw std::runtime_error("Expected sweep=start:stop:step, got '" + plan + "'.");
+
+  const double start = boost::lexical_cast< double >( parts[0] );
+  const double stop = boost::lexical_cast< double >( parts[1] );
+  _sweep_step = boost::lexical_cast< double >( parts[2] );
+
+  if ( start < 0 || stop <= start || stop > 7250e6 || _sweep_step < 1 )
+    throw std::runtime_error("Invalid sweep plan '" + plan + "'.");
+
+  _sweep_range.push_back( uint16_t( floor( start / 1e6 ) ) );
+  _sweep_range.push_back( uint16_t( ceil( stop / 1e6 ) ) );
+
+  if ( dict.count("sweep_dwell") )
+    _sweep_blocks = std::max( 1u, boost::lexical_cast< unsigned int >( dict.find("sweep_dwell")->second ) );
+
+  if ( dict.count("sweep_fft") ) {
+    _fft_size = boost::lexical_cast< size_t >( dict.find("sweep_fft")->second );
+
+    if ( _fft_size < 2 || _fft_size > SWEEP_BLOCK_SAMPLES - SWEEP_HEADER_SAMPLES )
+      throw std::runtime_error("sweep_fft has to be between 2 and the samples of a block.");
+
+    _fft.reset( new gr::fft::fft_complex( _fft_size, true ) );
+    _window = gr::fft::window::blackman_harris( _fft_size );
+    _acc.assign( _fft_size, 0.0f );
+    _db.assign( _fft_size, 0.0f );
+
+    double sum = 0;
+    for ( size_t i = 0; i < _window.size(); i++ )
+      sum += _window[i];
+
+    _norm = float( sum * sum );
+
+    message_port_register_out( SPECTRUM_PROBE_PORT );
+  }
+
+  _sweep = true;
+
+  std::cerr << "Sweeping " << _sweep_range[0] << " to " << _sweep_range[1]
+            << " MHz in steps of " << _sweep_step / 1e6 << " MHz." << std::endl;
+}
+
 /*
  * Our virtual destructor.
  */
@@ -243,6 +357,7 @@ hackrf_source_c::~hackrf_source_c ()
   if (_dev) {
 //    _thread.join();
     int ret = hackrf_stop_rx( _dev );
+    _stream.cancel();
     HACKRF_THROW_ON_ERROR(ret, "Failed to stop RX streaming")
     ret = hackrf_close( _dev );
     HACKRF_THROW_ON_ERROR(ret, "Failed to close HackRF")
@@ -257,15 +372,6 @@ hackrf_source_c::~hackrf_source_c ()
         hackrf_exit(); /* call only once after last close */
     }
   }
-
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-  }
 }
 
 int hackrf_source_c::_hackrf_rx_callback(hackrf_transfer *transfer)
@@ -276,21 +382,9 @@ int hackrf_source_c::_hackrf_rx_callback(hackrf_transfer *transfer)
 
 int hackrf_source_c::hackrf_rx_callback(unsigned char *buf, uint32_t len)
 {
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
-
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
-  }
+  _rx_thread.apply_once(); /* on the libhackrf transfer thread */
 
-  _buf_cond.notify_one();
+  _stream.push( buf, len );
 
   return 0; // TODO: return -1 on error/stop
 }
@@ -332,58 +426,175 @@ bool hackrf_source_c::stop()
   return true;
 }
 
+void hackrf_source_c::convert( const unsigned char *buf, unsigned char *out, int nsamples )
+{
+  if ( _sc8 ) /* the device delivers signed 8 bit IQ already */
+    memcpy( out, buf, nsamples * BYTES_PER_SAMPLE );
+  else
+    _stream.convert()( buf, (gr_complex *)out, nsamples );
+}
+
+/* A new hop begins with this block if it has another frequency. */
+void hackrf_source_c::sweep_block( const unsigned char *block, size_t nsamples,
+                                   uint64_t offset )
+{
+  const unsigned char *header = block;
+
+  uint64_t freq = 0;
+  for ( int i = 7; i >= 0; i-- )
+    freq = (freq << 8) | header[2 + i];
+
+  if ( freq != _hop_freq ) {
+    if ( _count )
+      publish_spectrum();
+
+    if ( freq < _hop_freq ) /* the firmware wrapped around */
+      _sweeps++;
+
+    const double base = _sweep_range[0] * 1e6;
+
+    _hop_freq = freq;
+    _hop = size_t( (freq - base) / _sweep_step + 0.5 );
+
+    add_item_tag( 0, offset, RX_FREQ_KEY,
+                  pmt::from_double( freq + _sweep_step / 2 ), alias_pmt() );
+    add_item_tag( 0, offset, SWEEP_HOP_KEY, pmt::from_uint64( _hop ), alias_pmt() );
+  }
+
+  if ( ! _fft_size || nsamples < SWEEP_HEADER_SAMPLES + _fft_size )
+    return;
+
+  /* the end of the block, when the tuner had the most time to settle */
+  gr_complex *buf = _fft->get_inbuf();
+
+  _stream.convert()( block + (nsamples - _fft_size) * BYTES_PER_SAMPLE, buf, _fft_size );
+
+  for ( size_t i = 0; i < _fft_size; i++ )
+    buf[i] *= _window[i];
+
+  _fft->execute();
+
+  const gr_complex *bins = _fft->get_outbuf();
+  const size_t half = _fft_size / 2;
+
+  /* DC in the middle */
+  for ( size_t i = 0; i < _fft_size; i++ )
+    _acc[(i + half) % _fft_size] += std::norm( bins[i] );
+
+  _count++;
+}
+
+/* The power spectrum of the last hop, as published by the sweeper. */
+void hackrf_source_c::publish_spectrum()
+{
+  const float scale = 1.0f / (_count * _norm);
+
+  for ( size_t i = 0; i < _fft_size; i++ )
+    _db[i] = 10.0f * log10f( _acc[i] * scale + 1e-20f );
+
+  pmt::pmt_t meta = pmt::make_dict();
+  meta = pmt::dict_add( meta, pmt::mp( "freq" ), pmt::from_double( _hop_freq + _sweep_step / 2 ) );
+  meta = pmt::dict_add( meta, pmt::mp( "rate" ), pmt::from_double( _sample_rate ) );
+  meta = pmt::dict_add( meta, pmt::mp( "hop" ), pmt::from_uint64( _hop ) );
+  meta = pmt::dict_add( meta, pmt::mp( "sweep" ), pmt::from_uint64( _sweeps ) );
+
+  message_port_pub( SPECTRUM_PROBE_PORT,
+                    pmt::cons( meta, pmt::init_f32vector( _fft_size, &_db[0] ) ) );
+
+  std::fill( _acc.begin(), _acc.end(), 0.0f );
+  _count = 0;
+}
+
+/* Strip the block headers, tagging the first sample of each hop. */
+int hackrf_source_c::sweep( unsigned char *out, int noutput_items )
+{
+  const size_t item_size = output_signature()->sizeof_stream_item(0);
+  int produced = 0;
+
+  const unsigned char *buf;
+  size_t avail;
+
+  while ( produced < noutput_items &&
+          (avail = _stream.front( buf, this, nitems_written( 0 ) + produced )) ) {
+    const size_t pos = _stream.offset() % SWEEP_BLOCK_SAMPLES;
+
+    if ( 0 == pos ) {
+      const size_t left = std::min( size_t(SWEEP_BLOCK_SAMPLES), avail );
+
+      if ( left > SWEEP_HEADER_SAMPLES && 0x7f == buf[0] && 0x7f == buf[1] ) {
+        sweep_block( buf, left, nitems_written( 0 ) + produced );
+        _stream.consume( SWEEP_HEADER_SAMPLES );
+      } else {
+        _stream.consume( SWEEP_BLOCK_SAMPLES ); /* not from the sweep, drop it */
+      }
+
+      continue;
+    }
+
+    const int n = std::min( int( std::min( avail, SWEEP_BLOCK_SAMPLES - pos ) ),
+                            noutput_items - produced );
+
+    convert( buf, out + produced * item_size, n );
+
+    _stream.consume( n );
+    produced += n;
+  }
+
+  return produced;
+}
+
 int hackrf_source_c::work( int noutput_items,
                         gr_vector_const_void_star &input_items,
                         gr_vector_void_star &output_items )
 {
-  gr_complex *out = (gr_complex *)output_items[0];
+  unsigned char *out = (unsigned char *)output_items[0];
+  const size_t item_size = output_signature()->sizeof_stream_item(0);
 
   bool running = false;
 
   if ( _dev )
     running = (hackrf_is_streaming( _dev ) == HACKRF_TRUE);
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    while (_buf_used < 3 && running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
-
-  if ( ! running )
+  if ( ! running || ! _stream.wait( _prefill ) )
     return WORK_DONE;
 
-  unsigned short *buf = _buf[_buf_head] + _buf_offset;
-
-  if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; ++i)
-      *out++ = _lut[ *(buf + i) ];
-
-    _buf_offset += noutput_items;
-    _samp_avail -= noutput_items;
+  int produced = 0;
+
+  if ( _decim.enabled() ) {
+    /* the full rate never hits our output */
+    produced = _stream.read( _decim, (gr_complex *)out, noutput_items,
+                             this, nitems_written( 0 ) );
+  } else if ( _sweep ) {
+    produced = sweep( out, noutput_items );
+  } else if ( ! _sc8 ) {
+    produced = _stream.read( (gr_complex *)out, noutput_items,
+                             this, nitems_written( 0 ) );
   } else {
-    for (int i = 0; i < _samp_avail; ++i)
-      *out++ = _lut[ *(buf + i) ];
+    const unsigned char *buf;
+    size_t avail;
 
-    {
-      boost::mutex::scoped_lock lock( _buf_mutex );
+    /* as many buffers as queued, the last one may be consumed partially */
+    while ( produced < noutput_items &&
+            (avail = _stream.front( buf, this, nitems_written( 0 ) + produced )) ) {
+      const int n = std::min( int(avail), noutput_items - produced );
 
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
+      convert( buf, out + produced * item_size, n );
 
-    buf = _buf[_buf_head];
+      _stream.consume( n );
+      produced += n;
+    }
+  }
 
-    int remaining = noutput_items - _samp_avail;
+  uint64_t tag_offset;
+  double tag_freq;
 
-    for (int i = 0; i < remaining; ++i)
-      *out++ = _lut[ *(buf + i) ];
+  if ( _stream.retune_tag( nitems_written( 0 ) + produced, tag_offset, tag_freq ) )
+    add_item_tag( 0, tag_offset, RX_FREQ_KEY, pmt::from_double( tag_freq ), alias_pmt() );
 
-    _buf_offset = remaining;
-    _samp_avail = (_buf_len / BYTES_PER_SAMPLE) - remaining;
-  }
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
 
-  return noutput_items;
+  return produced;
 }
 
 std::vector<std::string> hackrf_source_c::get_devices()
@@ -467,6 +678,11 @@ size_t hackrf_source_c::get_num_channels()
   return 1;
 }
 
+std::string hackrf_source_c::get_device_id()
+{
+  return _device_id;
+}
+
 osmosdr::meta_range_t hackrf_source_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
@@ -481,7 +697,7 @@ osmosdr::meta_range_t hackrf_source_c::get_sample_rates()
   range += osmosdr::range_t( 16e6 );
   range += osmosdr::range_t( 20e6 ); /* confirmed to work on fast machines */
 
-  return range;
+  return _decim.rates( range );
 }
 
 double hackrf_source_c::set_sample_rate( double rate )
@@ -489,6 +705,9 @@ double hackrf_source_c::set_sample_rate( double rate )
   int ret;
 
   if (_dev) {
+    /* _sample_rate is the rate of the device, before decimation */
+    rate *= _decim.decimation();
+
     ret = hackrf_set_sample_rate( _dev, rate );
     if ( HACKRF_SUCCESS == ret ) {
       _sample_rate = rate;
@@ -503,7 +722,7 @@ double hackrf_source_c::set_sample_rate( double rate )
 
 double hackrf_source_c::get_sample_rate()
 {
-  return _sample_rate;
+  return _sample_rate / _decim.decimation();
 }
 
 osmosdr::freq_range_t hackrf_source_c::get_freq_range( size_t chan )
@@ -521,7 +740,8 @@ double hackrf_source_c::set_center_freq( double freq, size_t chan )
 
   #define APPLY_PPM_CORR(val, ppm) ((val) * (1.0 + (ppm) * 0.000001))
 
-  if (_dev) {
+  /* the firmware retunes by itself while sweeping */
+  if (_dev && ! _sweep) {
     double corr_freq = APPLY_PPM_CORR( freq, _freq_corr );
     ret = hackrf_set_freq( _dev, uint64_t(corr_freq) );
     if ( HACKRF_SUCCESS == ret ) {
@@ -534,6 +754,12 @@ double hackrf_source_c::set_center_freq( double freq, size_t chan )
   return get_center_freq( chan );
 }
 
+void hackrf_source_c::tag_retune( double freq, uint64_t settle, size_t chan )
+{
+  /* counted at the full rate the transfers arrive with */
+  _stream.retuned( freq, settle * _decim.decimation() );
+}
+
 double hackrf_source_c::get_center_freq( size_t chan )
 {
   return _center_freq;
@@ -766,3 +992,8 @@ osmosdr::freq_range_t hackrf_source_c::get_bandwidth_range( size_t chan )
 
   return bandwidths;
 }
+
+osmosdr::stream_stats_t hackrf_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
@@ -26,11 +26,20 @@
 #include <gnuradio/sync_block.h>
 
 #include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <gnuradio/fft/fft.h>
 
 #include <libhackrf/hackrf.h>
 
 #include "source_iface.h"
+#include "arg_helpers.h"
+#include "rx_stream.h"
+#include "stream_stats.h"
+#include "sample_convert.h"
+#include "fir_decimator.h"
+#include "latency_profile.h"
+#include "rx_thread.h"
 
 class hackrf_source_c;
 
@@ -88,6 +97,7 @@ public:
   static std::vector< std::string > get_devices();
 
   size_t get_num_channels( void );
+  std::string get_device_id( void );
 
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
@@ -95,6 +105,7 @@ public:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  void tag_retune( double freq, uint64_t settle, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -120,29 +131,33 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   static int _hackrf_rx_callback(hackrf_transfer* transfer);
   int hackrf_rx_callback(unsigned char *buf, uint32_t len);
   static void _hackrf_wait(hackrf_source_c *obj);
   void hackrf_wait();
+  void convert( const unsigned char *buf, unsigned char *out, int nsamples );
+  void parse_sweep( const dict_t &dict );
+  int sweep( unsigned char *out, int noutput_items );
+  void sweep_block( const unsigned char *block, size_t nsamples, uint64_t offset );
+  void publish_spectrum();
 
   static int _usage;
   static boost::mutex _usage_mutex;
 
-  std::vector<gr_complex> _lut;
+  bool _sc8; /* deliver native 8 bit samples, see cpu_format */
+  fir_decimator _decim;
 
   hackrf_device *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
+  rx_thread_params _rx_thread;
+  stream_stats _stats;
   unsigned int _buf_num;
   unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
-
-  unsigned int _buf_offset;
-  int _samp_avail;
+  unsigned int _prefill; /* buffers queued before work() produces */
+  std::string _device_id; /* board and firmware version */
 
   double _sample_rate;
   double _center_freq;
@@ -152,6 +167,26 @@ private:
   double _lna_gain;
   double _vga_gain;
   double _bandwidth;
+
+  /* sweep= mode, the firmware retunes after every _sweep_blocks blocks */
+  bool _sweep;
+  std::vector< uint16_t > _sweep_range; /* MHz, as taken by the firmware */
+  double _sweep_step;
+  unsigned int _sweep_blocks;
+  uint64_t _hop_freq;  /* of the current hop, as given in the block headers */
+  size_t _hop;
+  uint64_t _sweeps;
+
+  /* power spectra of the hops, if sweep_fft= is given */
+  size_t _fft_size;
+  boost::scoped_ptr< gr::fft::fft_complex > _fft;
+  std::vector< float > _window;
+  float _norm;         /* the power gain of the window */
+  std::vector< float > _acc;
+  std::vector< float > _db;
+  size_t _count;       /* FFTs accumulated for the current hop */
+
+  rx_stream< format_s8 > _stream;
 };
 
 #endif /* INCLUDED_HACKRF_SOURCE_C_H */
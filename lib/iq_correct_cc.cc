@@ -0,0 +1,316 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include <osmosdr/source.h>
+
+#include "iq_correct_cc.h"
+#include "stream_tags.h"
+
+#define ESTIMATE_STRIDE  16    /* samples per estimator sample */
+#define ESTIMATE_AVERAGE 65536 /* estimator samples averaged over */
+#define NCO_CHUNK        1024  /* samples mixed before the phasor is renewed */
+
+iq_correct_cc_sptr make_iq_correct_cc()
+{
+  return gnuradio::get_initial_sptr( new iq_correct_cc() );
+}
+
+iq_correct_cc::iq_correct_cc() :
+  gr::sync_block("iq_correct_cc",
+                 gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                 gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _dc_mode(osmosdr::source::DCOffsetOff),
+  _iq_mode(osmosdr::source::IQBalanceOff),
+  _phase(0),
+  _shift(0),
+  _rate(0),
+  _nco_phase(0),
+  _freq(0),
+  _tag_freq(false)
+{
+  reset_estimate();
+
+  /* the rx_freq tags are moved by the shift in work() */
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+void iq_correct_cc::reset_estimate()
+{
+  _m_re = _m_im = 0;
+  _m_rr = _m_ii = 0;
+  _m_ri = 0;
+  _estimated = false;
+}
+
+void iq_correct_cc::set_dc_offset_mode( int mode )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* manual mode holds the last estimate */
+  if ( osmosdr::source::DCOffsetManual == mode &&
+       osmosdr::source::DCOffsetAutomatic == _dc_mode )
+    _dc_offset = std::complex<double>( _m_re, _m_im );
+
+  if ( osmosdr::source::DCOffsetOff == mode &&
+       osmosdr::source::IQBalanceAutomatic != _iq_mode )
+    reset_estimate();
+
+  _dc_mode = mode;
+}
+
+void iq_correct_cc::set_dc_offset( const std::complex<double> &offset )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _dc_offset = offset;
+}
+
+void iq_correct_cc::set_iq_balance_mode( int mode )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( osmosdr::source::IQBalanceManual == mode &&
+       osmosdr::source::IQBalanceAutomatic == _iq_mode )
+    _iq_balance = estimated_balance();
+
+  if ( osmosdr::source::IQBalanceOff == mode &&
+       osmosdr::source::DCOffsetAutomatic != _dc_mode )
+    reset_estimate();
+
+  _iq_mode = mode;
+}
+
+void iq_correct_cc::set_iq_balance( const std::complex<double> &balance )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _iq_balance = balance;
+}
+
+std::vector< double > iq_correct_cc::get_estimate()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  std::vector< double > estimate;
+
+  if ( _estimated ) {
+    estimate.push_back( _m_re );
+    estimate.push_back( _m_im );
+    estimate.push_back( _m_rr );
+    estimate.push_back( _m_ii );
+    estimate.push_back( _m_ri );
+  }
+
+  return estimate;
+}
+
+void iq_correct_cc::set_estimate( const std::vector< double > &estimate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( estimate.size() != 5 )
+    return;
+
+  _m_re = estimate[0];
+  _m_im = estimate[1];
+  _m_rr = estimate[2];
+  _m_ii = estimate[3];
+  _m_ri = estimate[4];
+  _estimated = true;
+}
+
+bool iq_correct_cc::active()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return osmosdr::source::DCOffsetOff != _dc_mode ||
+         osmosdr::source::IQBalanceOff != _iq_mode || _shift != 0;
+}
+
+void iq_correct_cc::set_freq_shift( double shift, double freq )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* a retune without a change of the shift is tagged by the retune_tagger */
+  if ( shift != _shift )
+    _tag_freq = true;
+
+  _shift = shift;
+  _freq = freq;
+}
+
+void iq_correct_cc::set_sample_rate( double rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _rate = rate;
+}
+
+/* Correct and mix with the NCO in one pass, renewing the float phasor from
+ * the double phase often enough to keep its rounding errors from accumulating. */
+void iq_correct_cc::correct_and_mix( const gr_complex *in, gr_complex *out, int nsamples )
+{
+  const double inc = -2 * M_PI * _shift / _rate;
+  const gr_complex step( cos( inc ), sin( inc ) );
+
+  for (int i = 0; i < nsamples; i += NCO_CHUNK) {
+    const int n = std::min( NCO_CHUNK, nsamples - i );
+    const gr_complex phasor( cos( _nco_phase ), sin( _nco_phase ) );
+
+    _correct( in + i, out + i, n, phasor, step );
+
+    _nco_phase = fmod( _nco_phase + inc * n, 2 * M_PI );
+  }
+}
+
+void iq_correct_cc::forward_tags( int nsamples )
+{
+  std::vector< gr::tag_t > tags;
+  get_tags_in_range( tags, 0, nitems_read(0), nitems_read(0) + nsamples );
+
+  BOOST_FOREACH( gr::tag_t &tag, tags ) {
+    if ( pmt::eqv( tag.key, RX_FREQ_KEY ) && pmt::is_real( tag.value ) )
+      tag.value = pmt::from_double( pmt::to_double( tag.value ) + _shift );
+
+    add_item_tag( 0, tag );
+  }
+
+  if ( _tag_freq ) {
+    add_item_tag( 0, nitems_written(0), RX_FREQ_KEY, pmt::from_double( _freq ),
+                  pmt::string_to_symbol( alias() ) );
+    _tag_freq = false;
+  }
+}
+
+void iq_correct_cc::estimate( const gr_complex *in, int nsamples )
+{
+  double s_re = 0, s_im = 0, s_rr = 0, s_ii = 0, s_ri = 0;
+  int count = 0;
+  int i;
+
+  for (i = _phase; i < nsamples; i += ESTIMATE_STRIDE, count++) {
+    const double re = in[i].real();
+    const double im = in[i].imag();
+
+    s_re += re;
+    s_im += im;
+    s_rr += re * re;
+    s_ii += im * im;
+    s_ri += re * im;
+  }
+
+  _phase = i - nsamples;
+
+  if ( ! count )
+    return;
+
+  /* the first block initializes the averages, later ones decay them */
+  const double w = _estimated ? double(count) / (count + ESTIMATE_AVERAGE) : 1.0;
+
+  _m_re += w * (s_re / count - _m_re);
+  _m_im += w * (s_im / count - _m_im);
+  _m_rr += w * (s_rr / count - _m_rr);
+  _m_ii += w * (s_ii / count - _m_ii);
+  _m_ri += w * (s_ri / count - _m_ri);
+
+  _estimated = true;
+}
+
+/* gain and phase error of Q relative to I, from the running averages */
+std::complex<double> iq_correct_cc::estimated_balance() const
+{
+  const double var_re = _m_rr - _m_re * _m_re;
+  const double var_im = _m_ii - _m_im * _m_im;
+  const double cov = _m_ri - _m_re * _m_im;
+
+  if ( var_re <= 0 || var_im <= 0 )
+    return std::complex<double>( 0, 0 );
+
+  const double gain = sqrt( var_im / var_re );
+  const double sin_phi = std::max( -0.9, std::min( 0.9, cov / sqrt( var_re * var_im ) ) );
+
+  return std::complex<double>( gain - 1, asin( sin_phi ) );
+}
+
+int iq_correct_cc::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  gr_complex *out = (gr_complex *) output_items[0];
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  forward_tags( noutput_items );
+
+  const bool dc_auto = (osmosdr::source::DCOffsetAutomatic == _dc_mode);
+  const bool iq_auto = (osmosdr::source::IQBalanceAutomatic == _iq_mode);
+
+  if ( dc_auto || iq_auto )
+    estimate( in, noutput_items );
+
+  std::complex<double> dc( 0, 0 ), balance( 0, 0 );
+
+  if ( dc_auto )
+    dc = std::complex<double>( _m_re, _m_im );
+  else if ( osmosdr::source::DCOffsetManual == _dc_mode )
+    dc = _dc_offset;
+
+  if ( iq_auto )
+    balance = estimated_balance();
+  else if ( osmosdr::source::IQBalanceManual == _iq_mode )
+    balance = _iq_balance;
+
+  const bool mix = (_shift != 0 && _rate > 0);
+
+  if ( !mix && dc == std::complex<double>( 0, 0 ) && balance == std::complex<double>( 0, 0 ) ) {
+    memcpy( out, in, noutput_items * sizeof(gr_complex) );
+    return noutput_items;
+  }
+
+  /* y.im = (Q / gain - I sin(phi)) / cos(phi) makes Q orthogonal to I,
+   * and is the identity if there is no imbalance */
+  const double gain = 1 + balance.real();
+  const double phi = balance.imag();
+  const double a = -tan( phi );
+  const double b = gain > 0 ? 1 / (gain * cos( phi )) : 1;
+
+  _correct.set( gr_complex( dc.real(), dc.imag() ), float(a), float(b) );
+
+  if ( mix )
+    correct_and_mix( in, out, noutput_items );
+  else
+    _correct( in, out, noutput_items );
+
+  return noutput_items;
+}
@@ -0,0 +1,113 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_IQ_CORRECT_CC_H
+#define OSMOSDR_IQ_CORRECT_CC_H
+
+#include <complex>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/sync_block.h>
+
+#include "sample_convert.h"
+
+class iq_correct_cc;
+
+typedef boost::shared_ptr< iq_correct_cc > iq_correct_cc_sptr;
+
+iq_correct_cc_sptr make_iq_correct_cc();
+
+/*!
+ * \brief DC offset removal and IQ imbalance correction in a single pass.
+ *
+ * Used by source_impl for backends without hardware correction, taking
+ * the same modes as osmosdr::source::set_dc_offset_mode() and
+ * set_iq_balance_mode(). It is only connected while one of them is on,
+ * see active(), or with fine_tune=true. The automatic modes estimate the mean, the power
+ * of I and Q and their correlation from every ESTIMATE_STRIDE-th sample
+ * only, averaged over about ESTIMATE_AVERAGE of those.
+ *
+ * A manual IQ balance is given as the gain error of Q relative to I in its
+ * real part and the phase error in radians in its imaginary part.
+ *
+ * The corrected samples are then shifted by the NCO set by fine_tune=true,
+ * whose phase carries on across frequency changes. The rx_freq tags passing
+ * through are moved by the shift, a change of it is tagged with rx_freq at
+ * the first sample shifted by the new amount.
+ */
+class iq_correct_cc : public gr::sync_block
+{
+private:
+  friend iq_correct_cc_sptr make_iq_correct_cc();
+
+  iq_correct_cc();
+
+public:
+  void set_dc_offset_mode( int mode );
+  void set_dc_offset( const std::complex<double> &offset );
+  void set_iq_balance_mode( int mode );
+  void set_iq_balance( const std::complex<double> &balance );
+
+  /*! The running averages of the automatic modes, empty before the first. */
+  std::vector< double > get_estimate();
+  /*! Start the automatic modes from averages taken by get_estimate(). */
+  void set_estimate( const std::vector< double > &estimate );
+
+  /*! \return true unless both corrections are off and nothing is shifted */
+  bool active();
+
+  /*! Shift the spectrum down by \p shift Hz, now tuned to \p freq. */
+  void set_freq_shift( double shift, double freq );
+  void set_sample_rate( double rate );
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  void estimate( const gr_complex *in, int nsamples );
+  void reset_estimate();
+  std::complex<double> estimated_balance() const;
+  void correct_and_mix( const gr_complex *in, gr_complex *out, int nsamples );
+  void forward_tags( int nsamples );
+
+  boost::mutex _mutex;
+  correct_iq _correct;
+
+  int _dc_mode;
+  int _iq_mode;
+  std::complex<double> _dc_offset;
+  std::complex<double> _iq_balance;
+
+  /* running averages of re, im, re^2, im^2 and re*im */
+  double _m_re, _m_im, _m_rr, _m_ii, _m_ri;
+  bool _estimated;
+  int _phase; /* index of the next estimator sample in the next call */
+
+  double _shift;     /* Hz */
+  double _rate;
+  double _nco_phase; /* radians at the next sample */
+  double _freq;      /* tagged with the next samples if _tag_freq */
+  bool _tag_freq;
+};
+
+#endif // OSMOSDR_IQ_CORRECT_CC_H
@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_LATENCY_PROFILE_H
+#define OSMOSDR_LATENCY_PROFILE_H
+
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "arg_helpers.h"
+
+/*!
+ * \brief The latency=low|balanced|throughput argument of the usb sources.
+ *
+ * Picks the length and number of the transfer buffers and how many of them
+ * are queued before work() produces. throughput keeps the defaults of each
+ * driver, the other modes size the transfers by the time they take to fill
+ * at the current sample rate, so they stay short at low rates too.
+ */
+class latency_profile
+{
+public:
+  enum mode_t { LOW, BALANCED, THROUGHPUT };
+
+  explicit latency_profile( const dict_t &dict ) : _mode( THROUGHPUT )
+  {
+    dict_t::const_iterator it = dict.find( "latency" );
+    if ( it == dict.end() || "throughput" == it->second )
+      return;
+
+    if ( "low" == it->second )
+      _mode = LOW;
+    else if ( "balanced" == it->second )
+      _mode = BALANCED;
+    else
+      throw std::runtime_error("Unsupported latency '" + it->second + "', "
+                               "use one of low, balanced or throughput.");
+  }
+
+  mode_t mode() const { return _mode; }
+
+  /*! Buffers to collect before producing, \p def for throughput. */
+  unsigned int prefill( unsigned int def ) const
+  {
+    switch ( _mode ) {
+    case LOW:      return 1;
+    case BALANCED: return std::min( 2u, def );
+    default:       return def;
+    }
+  }
+
+  /*!
+   * Transfer length in bytes for \p rate, a multiple of \p granularity
+   * not exceeding \p def, which is returned for throughput.
+   */
+  size_t buf_len( double rate, size_t bytes_per_sample,
+                  size_t granularity, size_t def ) const
+  {
+    if ( THROUGHPUT == _mode || ! (rate > 0) )
+      return def;
+
+    const double bytes = fill_time() * rate * bytes_per_sample;
+    const size_t len = size_t( std::ceil( bytes / granularity ) ) * granularity;
+
+    return std::max( granularity, std::min( len, def ) );
+  }
+
+  /*!
+   * Number of transfers of \p len bytes needed to absorb a stall of the
+   * consumer, never less than \p def.
+   */
+  unsigned int buf_num( size_t len, double rate, size_t bytes_per_sample,
+                        unsigned int def ) const
+  {
+    if ( THROUGHPUT == _mode || ! (rate > 0) || ! len )
+      return def;
+
+    const double stall = 0.1; /* seconds the ring holds */
+    const unsigned int max_num = 256;
+
+    const double bytes = stall * rate * bytes_per_sample;
+    const unsigned int num = (unsigned int) std::ceil( bytes / len );
+
+    return std::max( def, std::min( num, max_num ) );
+  }
+
+private:
+  /* seconds a transfer takes to fill */
+  double fill_time() const { return LOW == _mode ? 0.001 : 0.005; }
+
+  mode_t _mode;
+};
+
+#endif // OSMOSDR_LATENCY_PROFILE_H
@@ -29,6 +29,7 @@
 #endif
 
 #include "miri_source_c.h"
+#include "backend_registry.h"
 #include <gnuradio/io_signature.h>
 
 #include <boost/assign.hpp>
@@ -36,19 +37,22 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 #include <stdio.h>
 
 #include <mirisdr.h>
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
+#include "trace.h"
 
 using namespace boost::assign;
 
 #define BUF_SIZE  2304 * 8 * 2
 #define BUF_NUM   15
 #define BUF_SKIP  1 // buffers to skip due to garbage
+#define PREFILL   3 // buffers queued before work() produces
 
-#define BYTES_PER_SAMPLE  4 // mirisdr device delivers 16 bit signed IQ data
                             // containing 12 bits of information
 
 /*
@@ -61,6 +65,12 @@ make_miri_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new miri_source_c (args));
 }
 
+static source_registrar miri_registrar(
+  "miri",
+  &make_backend< source_iface, miri_source_c_sptr, &make_miri_source_c >,
+  &ignore_fake< &miri_source_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_RETUNE_TAGS, 50 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -82,20 +92,22 @@ miri_source_c::miri_source_c (const std::string &args)
   : gr::sync_block ("miri_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _prefill(PREFILL),
     _running(true),
     _auto_gain(false),
-    _skipped(0)
+    _stream(_stats, "miri", 0.0f, 1.0f/4096.0f)
 {
   int ret;
   unsigned int dev_index = 0;
 
   dict_t dict = params_to_dict(args);
 
+  _rx_thread = rx_thread_params( dict );
+
   if (dict.count("miri"))
     dev_index = boost::lexical_cast< unsigned int >( dict["miri"] );
 
-  _buf_num = _buf_head = _buf_used = _buf_offset = 0;
-  _samp_avail = BUF_SIZE / BYTES_PER_SAMPLE;
+  _buf_num = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -103,6 +115,14 @@ miri_source_c::miri_source_c (const std::string &args)
   if (0 == _buf_num)
     _buf_num = BUF_NUM;
 
+  /* trades latency for fewer, larger work() calls */
+  _prefill = latency_profile( dict ).prefill( PREFILL );
+
+  if (dict.count("prefill"))
+    _prefill = boost::lexical_cast< unsigned int >( dict["prefill"] );
+
+  _prefill = std::max( 1u, std::min( _prefill, _buf_num ) );
+
   if ( BUF_NUM != _buf_num ) {
     std::cerr << "Using " << _buf_num << " buffers of size " << BUF_SIZE << "."
               << std::endl;
@@ -132,13 +152,10 @@ miri_source_c::miri_source_c (const std::string &args)
   if (ret < 0)
     throw std::runtime_error("Failed to reset usb buffers.");
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
-  _buf_lens = (unsigned int *) malloc(_buf_num * sizeof(unsigned int));
+  _stream.alloc( _buf_num, BUF_SIZE, buffer_pool_params( dict ) );
+  _stream.skip( BUF_SKIP );
 
-  if (_buf && _buf_lens) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(BUF_SIZE);
-  }
+  message_port_register_out( STREAM_STATS_PORT );
 
   _thread = gr::thread::thread(_mirisdr_wait, this);
 }
@@ -155,17 +172,6 @@ miri_source_c::~miri_source_c ()
     mirisdr_close( _dev );
     _dev = NULL;
   }
-
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-    free(_buf_lens);
-    _buf_lens = NULL;
-  }
 }
 
 void miri_source_c::_mirisdr_callback(unsigned char *buf, uint32_t len, void *ctx)
@@ -176,30 +182,10 @@ void miri_source_c::_mirisdr_callback(unsigned char *buf, uint32_t len, void *ct
 
 void miri_source_c::mirisdr_callback(unsigned char *buf, uint32_t len)
 {
-  if (_skipped < BUF_SKIP) {
-    _skipped++;
-    return;
-  }
-
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    if (len > BUF_SIZE)
-      throw std::runtime_error("Buffer too small.");
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
-    _buf_lens[buf_tail] = len;
-
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
-  }
+  if (len > BUF_SIZE)
+    throw std::runtime_error("Buffer too small.");
 
-  _buf_cond.notify_one();
+  _stream.push( buf, len );
 }
 
 void miri_source_c::_mirisdr_wait(miri_source_c *obj)
@@ -209,6 +195,8 @@ void miri_source_c::_mirisdr_wait(miri_source_c *obj)
 
 void miri_source_c::mirisdr_wait()
 {
+  _rx_thread.apply(); /* the callbacks run on this thread */
+
   int ret = mirisdr_read_async( _dev, _mirisdr_callback, (void *)this, _buf_num, BUF_SIZE );
 
   _running = false;
@@ -216,7 +204,7 @@ void miri_source_c::mirisdr_wait()
   if ( ret != 0 )
     std::cerr << "mirisdr_read_async returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  _stream.cancel();
 }
 
 int miri_source_c::work( int noutput_items,
@@ -225,50 +213,22 @@ int miri_source_c::work( int noutput_items,
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
-
-  if (!_running)
+  if ( ! _stream.wait( _prefill ) )
     return WORK_DONE;
 
-  short *buf = (short *)_buf[_buf_head] + _buf_offset;
-
-  if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
-
-    _buf_offset += noutput_items * 2;
-    _samp_avail -= noutput_items;
-  } else {
-    for (int i = 0; i < _samp_avail; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
-
-    {
-      boost::mutex::scoped_lock lock( _buf_mutex );
-
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
+  /* convert as many transfers as fit, the last one may be consumed partially */
+  int produced = _stream.read( out, noutput_items, this, nitems_written( 0 ) );
 
-    buf = (short *)_buf[_buf_head];
+  uint64_t tag_offset;
+  double tag_freq;
 
-    int remaining = noutput_items - _samp_avail;
+  if ( _stream.retune_tag( nitems_written( 0 ) + produced, tag_offset, tag_freq ) )
+    add_item_tag( 0, tag_offset, RX_FREQ_KEY, pmt::from_double( tag_freq ), alias_pmt() );
 
-    for (int i = 0; i < remaining; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
 
-    _buf_offset = remaining * 2;
-    _samp_avail = (_buf_lens[_buf_head] / BYTES_PER_SAMPLE) - remaining;
-  }
-
-  return noutput_items;
+  return produced;
 }
 
 std::vector<std::string> miri_source_c::get_devices()
@@ -336,6 +296,11 @@ double miri_source_c::set_center_freq( double freq, size_t chan )
   return get_center_freq( chan );
 }
 
+void miri_source_c::tag_retune( double freq, uint64_t settle, size_t chan )
+{
+  _stream.retuned( freq, settle );
+}
+
 double miri_source_c::get_center_freq( size_t chan )
 {
   if (_dev)
@@ -449,3 +414,8 @@ std::string miri_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t miri_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
@@ -23,10 +23,13 @@
 #include <gnuradio/sync_block.h>
 
 #include <gnuradio/thread/thread.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
 
 #include "source_iface.h"
+#include "rx_stream.h"
+#include "stream_stats.h"
+#include "sample_convert.h"
+#include "latency_profile.h"
+#include "rx_thread.h"
 
 class miri_source_c;
 typedef struct mirisdr_dev mirisdr_dev_t;
@@ -89,6 +92,7 @@ private:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  void tag_retune( double freq, uint64_t settle, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -107,6 +111,8 @@ private:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   static void _mirisdr_callback(unsigned char *buf, uint32_t len, void *ctx);
   void mirisdr_callback(unsigned char *buf, uint32_t len);
@@ -115,20 +121,15 @@ private:
 
   mirisdr_dev_t *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
-  unsigned int *_buf_lens;
+  rx_thread_params _rx_thread;
+  stream_stats _stats;
   unsigned int _buf_num;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
+  unsigned int _prefill; /* buffers queued before work() produces */
   bool _running;
 
-  unsigned int _buf_offset;
-  int _samp_avail;
-
   bool _auto_gain;
-  unsigned int _skipped;
+
+  rx_stream< format_s16le > _stream;
 };
 
 #endif /* INCLUDED_MIRI_SOURCE_C_H */
@@ -0,0 +1,100 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_MOCK_PROFILE_H
+#define INCLUDED_MOCK_PROFILE_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+
+/*!
+ * The sample format, transfer size and way of delivery of the backend a
+ * mock device emulates, with the defaults of that backend.
+ */
+struct mock_profile
+{
+  enum format_t { U8, S8, SC16_Q11 };
+
+  std::string name;
+  format_t format;
+  bool callback;          /* usb callbacks, otherwise synchronous reads */
+  size_t buf_len;         /* bytes per transfer */
+  unsigned int buf_num;   /* transfers the driver or hardware buffers */
+  double rate;
+
+  size_t bytes_per_sample() const { return SC16_Q11 == format ? 4 : 2; }
+
+  /*! \throw std::runtime_error for an unknown \p name */
+  static mock_profile find( const std::string &name )
+  {
+    mock_profile p;
+
+    p.name = name.empty() ? "rtl" : name;
+
+    if ( "rtl" == p.name || "hackrf" == p.name ) {
+      p.format = "rtl" == p.name ? U8 : S8;
+      p.callback = true;
+      p.buf_len = 16 * 32 * 512;
+      p.buf_num = 15;
+      p.rate = "rtl" == p.name ? 2.4e6 : 10e6;
+    } else if ( "bladerf" == p.name ) {
+      p.format = SC16_Q11;
+      p.callback = false;
+      p.buf_len = 4 * 1024 * 4;
+      p.buf_num = 32;
+      p.rate = 10e6;
+    } else {
+      throw std::runtime_error("Unsupported mock device '" + name + "', "
+                               "use one of rtl, hackrf or bladerf.");
+    }
+
+    return p;
+  }
+
+  /*! \return \p len bytes of a tone at a 64th of the rate, in the native format */
+  std::vector< unsigned char > make_pattern( size_t len ) const
+  {
+    std::vector< unsigned char > pattern( len );
+    const size_t nsamples = len / bytes_per_sample();
+
+    for (size_t i = 0; i < nsamples; i++) {
+      const double phase = 2 * M_PI * (i % 64) / 64;
+      const double re = 0.5 * std::cos( phase ), im = 0.5 * std::sin( phase );
+
+      if ( SC16_Q11 == format ) {
+        int16_t *s = (int16_t *) &pattern[i * 4];
+        s[0] = int16_t( re * 2047 );
+        s[1] = int16_t( im * 2047 );
+      } else if ( S8 == format ) {
+        pattern[i * 2] = (unsigned char) int8_t( re * 127 );
+        pattern[i * 2 + 1] = (unsigned char) int8_t( im * 127 );
+      } else {
+        pattern[i * 2] = (unsigned char) ( 127.4 + re * 127 );
+        pattern[i * 2 + 1] = (unsigned char) ( 127.4 + im * 127 );
+      }
+    }
+
+    return pattern;
+  }
+};
+
+#endif /* INCLUDED_MOCK_PROFILE_H */
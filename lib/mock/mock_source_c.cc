@@ -0,0 +1,443 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "mock_source_c.h"
+#include "backend_registry.h"
+#include "stream_tags.h"
+#include "arg_helpers.h"
+#include "trace.h"
+
+#define PREFILL 1 /* transfers queued before work() produces */
+
+mock_source_c_sptr make_mock_source_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr( new mock_source_c( args ) );
+}
+
+static source_registrar mock_registrar(
+  "mock",
+  &make_backend< source_iface, mock_source_c_sptr, &make_mock_source_c >,
+  &mock_source_c::get_devices,
+  0, BACKEND_ORDER_SOFTWARE + 40 );
+
+/* the 8 bit profiles deliver sc8 natively */
+static size_t mock_item_size( const std::string &args )
+{
+  dict_t dict = params_to_dict( args );
+
+  if ( mock_profile::SC16_Q11 == mock_profile::find( dict["mock"] ).format )
+    return sizeof(gr_complex);
+
+  return args_to_item_size( args, "sc8" );
+}
+
+mock_source_c::mock_source_c( const std::string &args )
+  : gr::sync_block( "mock_source_c",
+        gr::io_signature::make( 0, 0, 0 ),
+        gr::io_signature::make( 1, 1, mock_item_size( args ) ) ),
+    _profile( mock_profile::find( params_to_dict( args )["mock"] ) ),
+    _native( mock_item_size( args ) != sizeof(gr_complex) ),
+    _convert_8( mock_profile::U8 != _profile.format,
+                mock_profile::U8 == _profile.format ? 127.4f : 0.0f, 1.0f/128.0f ),
+    _convert_16( 1.0f/2048.0f ),
+    _rate( _profile.rate ),
+    _freq( 100e6 ),
+    _gain( 0 ),
+    _latency( params_to_dict( args ) ),
+    _buf_fixed( false ),
+    _buf_len( _profile.buf_len ),
+    _buf_num( _profile.buf_num ),
+    _buf_offset( 0 ),
+    _running( false ),
+    _rebase( false ),
+    _start( 0 ),
+    _read( 0 ),
+    _retag( true )
+{
+  dict_t dict = params_to_dict( args );
+
+  if ( dict.count( "buffers" ) )
+    _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
+
+  if ( dict.count( "buflen" ) )
+    _buf_len = boost::lexical_cast< size_t >( dict["buflen"] );
+
+  _buf_fixed = dict.count( "buffers" ) || dict.count( "buflen" );
+
+  /* whole samples, multiples of 512 bytes like the usb transfers */
+  if ( _buf_len < 512 || _buf_len % 512 )
+    throw std::runtime_error("The mock buflen has to be a multiple of 512.");
+
+  if ( _buf_num < 1 )
+    throw std::runtime_error("The mock device needs at least one buffer.");
+
+  std::cerr << "Using mock " << _profile.name << " device with " << _buf_num
+            << " buffers of size " << _buf_len << "." << std::endl;
+
+  _pattern = _profile.make_pattern( _buf_len );
+
+  if ( _profile.callback )
+    _ring.alloc( _buf_num, _buf_len );
+
+  message_port_register_out( STREAM_STATS_PORT );
+}
+
+mock_source_c::~mock_source_c()
+{
+  stop();
+}
+
+bool mock_source_c::start()
+{
+  const size_t bps = _profile.bytes_per_sample();
+
+  _retag = true;
+
+  if ( ! _profile.callback ) {
+    _start = gr::high_res_timer_now();
+    _read = 0;
+    _rebase = false;
+    return true;
+  }
+
+  if ( ! _buf_fixed && latency_profile::THROUGHPUT != _latency.mode() ) {
+    const size_t len = _latency.buf_len( _rate, bps, 512, _profile.buf_len );
+    const unsigned int num = _latency.buf_num( len, _rate, bps, _profile.buf_num );
+
+    if ( len != _buf_len || num != _buf_num ) {
+      _buf_len = len;
+      _buf_num = num;
+      _ring.alloc( _buf_num, _buf_len );
+      _pattern = _profile.make_pattern( _buf_len );
+
+      std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
+                << std::endl;
+    }
+  }
+
+  _buf_offset = 0;
+  _ring.reset();
+
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &mock_source_c::callback_task, this ) );
+
+  return true;
+}
+
+bool mock_source_c::stop()
+{
+  if ( _running.exchange( false ) )
+    _thread.join();
+
+  return true;
+}
+
+/* Deliver a transfer each time the hardware would have filled one. */
+void mock_source_c::callback_task()
+{
+  const size_t bps = _profile.bytes_per_sample();
+  const gr::high_res_timer_type tps = gr::high_res_timer_tps();
+
+  gr::high_res_timer_type due = gr::high_res_timer_now();
+
+  while ( _running ) {
+    due += gr::high_res_timer_type( double(_buf_len / bps) / _rate * tps );
+
+    gr::high_res_timer_type now = gr::high_res_timer_now();
+    if ( due > now )
+      boost::this_thread::sleep( boost::posix_time::microseconds( (due - now) * 1000000 / tps ) );
+
+    TRACE_ARRIVAL( "mock", _buf_len );
+
+    if ( ! _ring.push( &_pattern[0], _buf_len ) )
+      _stats.overflow( _buf_len / bps );
+  }
+
+  _ring.cancel();
+}
+
+void mock_source_c::convert( const unsigned char *src, void *out, size_t offset,
+                             size_t nsamples )
+{
+  if ( mock_profile::SC16_Q11 == _profile.format )
+    _convert_16( (const int16_t *) src, (gr_complex *) out + offset, nsamples );
+  else if ( _native && mock_profile::U8 == _profile.format )
+    offset_binary_to_sc8( src, (int8_t *) out + offset * 2, nsamples * 2 );
+  else if ( _native )
+    memcpy( (int8_t *) out + offset * 2, src, nsamples * 2 );
+  else
+    _convert_8( src, (gr_complex *) out + offset, nsamples );
+}
+
+void mock_source_c::tag_time( uint64_t offset, gr::high_res_timer_type stamp )
+{
+  const gr::high_res_timer_type tps = gr::high_res_timer_tps();
+  const ::osmosdr::tick_spec_t time = ::osmosdr::tick_spec_t::from_ticks( stamp, tps );
+
+  std::vector< gr::tag_t > tags = make_rx_tags( offset, time, _rate, _freq, alias() );
+
+  /* rx_rate and rx_freq at start and after overflows, rx_time always */
+  for (size_t i = 0; i < (_retag ? tags.size() : 1); i++)
+    add_item_tag( 0, tags[i] );
+
+  _retag = false;
+}
+
+/*
+ * Like bladerf_sync_rx(), block until a buffer worth of samples arrived.
+ * Samples not read within buf_num buffers are lost.
+ */
+size_t mock_source_c::read_sync( void *out, size_t nsamples )
+{
+  const size_t bps = _profile.bytes_per_sample();
+  const size_t spb = _buf_len / bps;
+  const double tps = gr::high_res_timer_tps();
+  const double rate = _rate;
+
+  if ( _rebase.exchange( false ) ) /* the rate changed, keep the position */
+    _start = gr::high_res_timer_now() - gr::high_res_timer_type( _read / rate * tps );
+
+  const uint64_t arrived = uint64_t( (gr::high_res_timer_now() - _start) / tps * rate );
+  const uint64_t depth = uint64_t( _buf_num ) * spb;
+
+  if ( arrived > _read + depth ) {
+    _stats.overflow( arrived - depth - _read );
+    _read = arrived - depth;
+    _retag = true;
+  }
+
+  _stats.fill( arrived > _read ? arrived - _read : 0, depth );
+
+  nsamples = std::min( nsamples, spb );
+
+  const gr::high_res_timer_type due = _start +
+    gr::high_res_timer_type( (_read + nsamples) / rate * tps );
+  const gr::high_res_timer_type now = gr::high_res_timer_now();
+
+  if ( due > now )
+    boost::this_thread::sleep( boost::posix_time::microseconds( long( (due - now) * 1e6 / tps ) ) );
+
+  _stats.latency( due );
+  tag_time( nitems_written( 0 ), due );
+
+  for (size_t done = 0; done < nsamples; ) {
+    const size_t pos = (_read + done) % spb;
+    const size_t n = std::min( nsamples - done, spb - pos );
+
+    convert( &_pattern[pos * bps], out, done, n );
+    done += n;
+  }
+
+  _read += nsamples;
+
+  return nsamples;
+}
+
+int mock_source_c::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
+{
+  const size_t bps = _profile.bytes_per_sample();
+  size_t produced = 0;
+
+  if ( ! _profile.callback ) {
+    produced = read_sync( output_items[0], noutput_items );
+  } else {
+    if ( ! _ring.wait( PREFILL ) )
+      return WORK_DONE;
+
+    _stats.fill( _ring.used() * _buf_len / bps, _ring.num() * _buf_len / bps );
+
+    while ( produced < size_t(noutput_items) && _ring.used() ) {
+      if ( 0 == _buf_offset ) {
+        _stats.latency( _ring.front_stamp() );
+        tag_time( nitems_written( 0 ) + produced, _ring.front_stamp() );
+        TRACE_OUTPUT( this, "mock", nitems_written( 0 ) + produced, _ring.front_stamp() );
+      }
+
+      const size_t n = std::min( noutput_items - produced, (_buf_len - _buf_offset) / bps );
+
+      convert( _ring.front() + _buf_offset, output_items[0], produced, n );
+
+      produced += n;
+      _buf_offset += n * bps;
+
+      if ( _buf_offset >= _buf_len ) {
+        _ring.pop();
+        _buf_offset = 0;
+      }
+    }
+  }
+
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
+  return produced;
+}
+
+std::vector< std::string > mock_source_c::get_devices( bool fake )
+{
+  std::vector< std::string > devices;
+
+  /* offered along with the fake file devices only */
+  if ( fake ) {
+    devices.push_back( "mock=rtl,label='Mock RTL-SDR'" );
+    devices.push_back( "mock=hackrf,label='Mock HackRF'" );
+    devices.push_back( "mock=bladerf,label='Mock bladeRF'" );
+  }
+
+  return devices;
+}
+
+size_t mock_source_c::get_num_channels()
+{
+  return 1;
+}
+
+osmosdr::meta_range_t mock_source_c::get_sample_rates()
+{
+  osmosdr::meta_range_t range;
+
+  range.push_back( osmosdr::range_t( 250e3, 61.44e6 ) );
+
+  return range;
+}
+
+double mock_source_c::set_sample_rate( double rate )
+{
+  if ( rate > 0 ) {
+    _rate = rate;
+    _rebase = true;
+  }
+
+  return get_sample_rate();
+}
+
+double mock_source_c::get_sample_rate()
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t mock_source_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( 0, 6e9 );
+}
+
+double mock_source_c::set_center_freq( double freq, size_t chan )
+{
+  _freq = freq;
+
+  return get_center_freq( chan );
+}
+
+double mock_source_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double mock_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double mock_source_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector< std::string > mock_source_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >( 1, "LNA" );
+}
+
+osmosdr::gain_range_t mock_source_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t( 0, 50, 1 );
+}
+
+osmosdr::gain_range_t mock_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double mock_source_c::set_gain( double gain, size_t chan )
+{
+  _gain = get_gain_range( chan ).clip( gain, true );
+
+  return get_gain( chan );
+}
+
+double mock_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double mock_source_c::get_gain( size_t chan )
+{
+  return _gain;
+}
+
+double mock_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > mock_source_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, "RX" );
+}
+
+std::string mock_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string mock_source_c::get_antenna( size_t chan )
+{
+  return "RX";
+}
+
+::osmosdr::time_spec_t mock_source_c::get_time_now( size_t mboard )
+{
+  const gr::high_res_timer_type now = gr::high_res_timer_now();
+  const gr::high_res_timer_type tps = gr::high_res_timer_tps();
+
+  return ::osmosdr::time_spec_t( time_t( now / tps ), double( now % tps ) / tps );
+}
+
+osmosdr::stream_stats_t mock_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
@@ -0,0 +1,138 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_MOCK_SOURCE_C_H
+#define INCLUDED_MOCK_SOURCE_C_H
+
+#include <gnuradio/sync_block.h>
+
+#include <gnuradio/thread/thread.h>
+
+#include "source_iface.h"
+#include "transfer_ring.h"
+#include "stream_stats.h"
+#include "sample_convert.h"
+#include "latency_profile.h"
+
+#include "mock_profile.h"
+
+class mock_source_c;
+
+typedef boost::shared_ptr< mock_source_c > mock_source_c_sptr;
+
+mock_source_c_sptr make_mock_source_c( const std::string & args = "" );
+
+/*!
+ * \brief A source without hardware, for benchmarking the source graph.
+ *
+ * mock=rtl|hackrf|bladerf emulates the sample format and timing of that
+ * backend: the usb callbacks of the rtl and hackrf deliver full transfers
+ * into a transfer_ring from a thread paced by the sample rate, the bladerf
+ * is read synchronously from work(), blocking until the samples are due.
+ * The hardware fifo overflows, and the drops are counted in the stream
+ * statistics, when the graph doesn't keep up.
+ *
+ * Each transfer is tagged with rx_time, the host time it arrived at as
+ * given by gr::high_res_timer_now(), so the latency through the graph can
+ * be measured at its end. get_time_now() is on the same time base.
+ */
+class mock_source_c :
+    public gr::sync_block,
+    public source_iface
+{
+private:
+  friend mock_source_c_sptr make_mock_source_c( const std::string & args );
+
+  mock_source_c( const std::string & args );
+
+public:
+  ~mock_source_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+  ::osmosdr::time_spec_t get_time_now( size_t mboard = 0 );
+  ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+private:
+  void callback_task();
+  size_t read_sync( void *out, size_t nsamples );
+  void convert( const unsigned char *src, void *out, size_t offset, size_t nsamples );
+  void tag_time( uint64_t offset, gr::high_res_timer_type stamp );
+
+  mock_profile _profile;
+  bool _native; /* deliver the sc8 samples unconverted, see cpu_format */
+  convert_8bit _convert_8;
+  convert_16bit _convert_16;
+
+  std::vector< unsigned char > _pattern; /* a tone, one transfer long */
+  double _rate;
+  double _freq;
+  double _gain;
+
+  /* usb callback emulation */
+  gr::thread::thread _thread;
+  transfer_ring _ring;
+  latency_profile _latency;
+  bool _buf_fixed; /* buffers or buflen given, don't size them by rate */
+  size_t _buf_len;
+  unsigned int _buf_num;
+  size_t _buf_offset; /* bytes of the front transfer consumed */
+  boost::atomic<bool> _running;
+
+  /* synchronous read emulation */
+  boost::atomic<bool> _rebase; /* the rate changed while streaming */
+  gr::high_res_timer_type _start;
+  uint64_t _read; /* samples read since start() */
+  bool _retag;    /* add rx_rate and rx_freq to the next rx_time tag */
+
+  stream_stats _stats;
+};
+
+#endif /* INCLUDED_MOCK_SOURCE_C_H */
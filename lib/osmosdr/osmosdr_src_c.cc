@@ -28,6 +28,7 @@
 #endif
 
 #include "osmosdr_src_c.h"
+#include "backend_registry.h"
 #include <gnuradio/io_signature.h>
 
 #include <boost/assign.hpp>
@@ -40,6 +41,8 @@
 #include <osmosdr.h>
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
+#include "trace.h"
 
 using namespace boost::assign;
 
@@ -47,7 +50,6 @@ using namespace boost::assign;
 #define BUF_NUM   15
 #define BUF_SKIP  1 // buffers to skip due to garbage
 
-#define BYTES_PER_SAMPLE  4 // osmosdr device delivers 16 bit signed IQ data
 
 /*
  * Create a new instance of osmosdr_src_c and return
@@ -59,6 +61,12 @@ osmosdr_make_src_c (const std::string &args)
   return gnuradio::get_initial_sptr(new osmosdr_src_c (args));
 }
 
+static source_registrar osmosdr_registrar(
+  "osmosdr",
+  &make_backend< source_iface, osmosdr_src_c_sptr, &osmosdr_make_src_c >,
+  &ignore_fake< &osmosdr_src_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_RETUNE_TAGS, 10 );
+
 /*
  * The private constructor
  */
@@ -67,21 +75,22 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
         gr::io_signature::make(0, 0, sizeof (gr_complex)),
         gr::io_signature::make(1, 1, sizeof (gr_complex)) ),
     _dev(NULL),
-    _buf(NULL),
     _running(true),
     _auto_gain(false),
     _if_gain(0),
-    _skipped(0)
+    _stream(_stats, "osmosdr", 0.0f, 1.0f/32767.5f)
 {
   int ret;
   unsigned int dev_index = 0;
 
   dict_t dict = params_to_dict(args);
 
+  _rx_thread = rx_thread_params( dict );
+
   if (dict.count("osmosdr"))
     dev_index = boost::lexical_cast< unsigned int >( dict["osmosdr"] );
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  _buf_num = _buf_len = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -100,7 +109,14 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
               << std::endl;
   }
 
-  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+  if (dict.count("decim")) {
+    unsigned int decim = boost::lexical_cast< unsigned int >( dict["decim"] );
+
+    if ( decim > 1 )
+      std::cerr << "Decimating by " << decim << "." << std::endl;
+
+    _decim = fir_decimator( decim );
+  }
 
   if ( dev_index >= osmosdr_get_device_count() )
     throw std::runtime_error("Wrong osmosdr device index given.");
@@ -132,12 +148,10 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
 
   set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
+  _stream.alloc( _buf_num, _buf_len, buffer_pool_params( dict ) );
+  _stream.skip( BUF_SKIP );
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(_buf_len);
-  }
+  message_port_register_out( STREAM_STATS_PORT );
 
   _thread = gr::thread::thread(_osmosdr_wait, this);
 }
@@ -154,15 +168,6 @@ osmosdr_src_c::~osmosdr_src_c ()
     osmosdr_close( _dev );
     _dev = NULL;
   }
-
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-  }
 }
 
 void osmosdr_src_c::_osmosdr_callback(unsigned char *buf, uint32_t len, void *ctx)
@@ -173,26 +178,7 @@ void osmosdr_src_c::_osmosdr_callback(unsigned char *buf, uint32_t len, void *ct
 
 void osmosdr_src_c::osmosdr_callback(unsigned char *buf, uint32_t len)
 {
-  if (_skipped < BUF_SKIP) {
-    _skipped++;
-    return;
-  }
-
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
-
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
-  }
-
-  _buf_cond.notify_one();
+  _stream.push( buf, len );
 }
 
 void osmosdr_src_c::_osmosdr_wait(osmosdr_src_c *obj)
@@ -202,6 +188,8 @@ void osmosdr_src_c::_osmosdr_wait(osmosdr_src_c *obj)
 
 void osmosdr_src_c::osmosdr_wait()
 {
+  _rx_thread.apply(); /* the callbacks run on this thread */
+
   int ret = osmosdr_read_async( _dev, _osmosdr_callback, (void *)this, _buf_num, _buf_len );
 
   _running = false;
@@ -209,7 +197,7 @@ void osmosdr_src_c::osmosdr_wait()
   if ( ret != 0 )
     std::cerr << "osmosdr_read_async returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  _stream.cancel();
 }
 
 int osmosdr_src_c::work( int noutput_items,
@@ -218,50 +206,26 @@ int osmosdr_src_c::work( int noutput_items,
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
-
-  if (!_running)
+  if ( ! _stream.wait( 3 ) ) // collect at least 3 buffers
     return WORK_DONE;
 
-  short *buf = (short *)_buf[_buf_head] + _buf_offset;
+  int produced;
 
-  if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; i++)
-       *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/32767.5f),
-                            float(*(buf + i * 2 + 1)) * (1.0f/32767.5f) );
+  if ( _decim.enabled() ) /* the full rate never hits our output */
+    produced = _stream.read( _decim, out, noutput_items, this, nitems_written( 0 ) );
+  else
+    produced = _stream.read( out, noutput_items, this, nitems_written( 0 ) );
 
-    _buf_offset += noutput_items * 2;
-    _samp_avail -= noutput_items;
-  } else {
-    for (int i = 0; i < _samp_avail; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/32767.5f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/32767.5f) );
+  uint64_t tag_offset;
+  double tag_freq;
 
-    {
-      boost::mutex::scoped_lock lock( _buf_mutex );
+  if ( _stream.retune_tag( nitems_written( 0 ) + produced, tag_offset, tag_freq ) )
+    add_item_tag( 0, tag_offset, RX_FREQ_KEY, pmt::from_double( tag_freq ), alias_pmt() );
 
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
 
-    buf = (short *)_buf[_buf_head];
-
-    int remaining = noutput_items - _samp_avail;
-
-    for (int i = 0; i < remaining; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/32767.5f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/32767.5f) );
-
-    _buf_offset = remaining * 2;
-    _samp_avail = (_buf_len / BYTES_PER_SAMPLE) - remaining;
-  }
-
-  return noutput_items;
+  return produced;
 }
 
 std::vector<std::string> osmosdr_src_c::get_devices()
@@ -309,13 +273,13 @@ osmosdr::meta_range_t osmosdr_src_c::get_sample_rates()
     }
   }
 
-  return range;
+  return _decim.rates( range );
 }
 
 double osmosdr_src_c::set_sample_rate(double rate)
 {
   if (_dev) {
-    osmosdr_set_sample_rate( _dev, (uint32_t)rate );
+    osmosdr_set_sample_rate( _dev, (uint32_t)(rate * _decim.decimation()) );
   }
 
   return get_sample_rate();
@@ -324,7 +288,7 @@ double osmosdr_src_c::set_sample_rate(double rate)
 double osmosdr_src_c::get_sample_rate()
 {
   if (_dev)
-    return (double)osmosdr_get_sample_rate( _dev );
+    return (double)osmosdr_get_sample_rate( _dev ) / _decim.decimation();
 
   return 0;
 }
@@ -347,6 +311,12 @@ double osmosdr_src_c::set_center_freq( double freq, size_t chan )
   return get_center_freq( chan );
 }
 
+void osmosdr_src_c::tag_retune( double freq, uint64_t settle, size_t chan )
+{
+  /* counted at the full rate the transfers arrive with */
+  _stream.retuned( freq, settle * _decim.decimation() );
+}
+
 double osmosdr_src_c::get_center_freq( size_t chan )
 {
   if (_dev)
@@ -531,3 +501,8 @@ std::string osmosdr_src_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t osmosdr_src_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
@@ -23,10 +23,13 @@
 #include <gnuradio/sync_block.h>
 
 #include <gnuradio/thread/thread.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
 
 #include "source_iface.h"
+#include "rx_stream.h"
+#include "stream_stats.h"
+#include "sample_convert.h"
+#include "fir_decimator.h"
+#include "rx_thread.h"
 
 class osmosdr_src_c;
 typedef struct osmosdr_dev osmosdr_dev_t;
@@ -91,6 +94,7 @@ private:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  void tag_retune( double freq, uint64_t settle, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -111,29 +115,28 @@ private:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   static void _osmosdr_callback(unsigned char *buf, uint32_t len, void *ctx);
   void osmosdr_callback(unsigned char *buf, uint32_t len);
   static void _osmosdr_wait(osmosdr_src_c *obj);
   void osmosdr_wait();
 
+  fir_decimator _decim;
+
   osmosdr_dev_t *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
+  rx_thread_params _rx_thread;
+  stream_stats _stats;
   unsigned int _buf_num;
   unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
   bool _running;
 
-  unsigned int _buf_offset;
-  int _samp_avail;
-
   bool _auto_gain;
   double _if_gain;
-  unsigned int _skipped;
+
+  rx_stream< format_s16le > _stream;
 };
 
 #endif /* INCLUDED_OSMOSDR_SRC_C_H */
@@ -0,0 +1,146 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_PARAM_CACHE_H
+#define OSMOSDR_PARAM_CACHE_H
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/thread/mutex.hpp>
+
+/*!
+ * \brief Remembers the settings of the devices, so the getters polled by
+ * GUIs don't cost a control transfer or network round trip each time.
+ *
+ * The values are kept by channel and name, e.g. "freq" or "gain/LNA" for a
+ * gain stage. Values read from a device are entered with lookup() and
+ * fill(), values written to it with store(). A value read while a write
+ * was in progress isn't cached, as each lookup() hands out a stamp which
+ * a write to the same key invalidates. Retunes may complete on a control
+ * thread, so all calls are serialized.
+ */
+template < typename T >
+class param_cache
+{
+public:
+  param_cache() : _enabled(true), _gen(0) {}
+
+  /*! A disabled cache always reads the hardware. */
+  void set_enabled( bool enabled ) { _enabled = enabled; }
+
+  /*!
+   * \return true and \p value if cached, otherwise a \p stamp to be passed
+   *         to fill() with the value read from the device
+   */
+  bool lookup( size_t chan, const std::string &name, T &value,
+               unsigned long long &stamp )
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    entry &e = _entries[key_t( chan, name )];
+
+    if ( e.valid && _enabled && ! e.uncached ) {
+      value = e.value;
+      return true;
+    }
+
+    stamp = e.gen;
+    return false;
+  }
+
+  /*! Cache a value read, unless it has been written since lookup(). */
+  void fill( size_t chan, const std::string &name, const T &value,
+             unsigned long long stamp )
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    entry &e = _entries[key_t( chan, name )];
+
+    if ( e.gen == stamp && ! e.uncached ) {
+      e.value = value;
+      e.valid = true;
+    }
+  }
+
+  /*! Cache a value written, as returned by the setter of the device. */
+  void store( size_t chan, const std::string &name, const T &value )
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    entry &e = _entries[key_t( chan, name )];
+
+    e.value = value;
+    e.valid = ! e.uncached;
+    e.gen = ++_gen;
+  }
+
+  /*!
+   * Read value \p name of channel \p chan from the hardware every time while
+   * \p uncached, e.g. as long as the device changes it by itself.
+   */
+  void set_uncached( size_t chan, const std::string &name, bool uncached )
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    entry &e = _entries[key_t( chan, name )];
+
+    e.uncached = uncached;
+    e.valid = false;
+    e.gen = ++_gen;
+  }
+
+  /*! Forget the values of channel \p chan with names starting with \p prefix. */
+  void invalidate( size_t chan, const std::string &prefix = "" )
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    typename std::map< key_t, entry >::iterator it;
+    for ( it = _entries.lower_bound( key_t( chan, prefix ) ); it != _entries.end(); ++it ) {
+      if ( it->first.first != chan ||
+           ! boost::algorithm::starts_with( it->first.second, prefix ) )
+        break;
+
+      it->second.valid = false;
+      it->second.gen = ++_gen;
+    }
+  }
+
+private:
+  typedef std::pair< size_t, std::string > key_t;
+
+  struct entry
+  {
+    entry() : valid(false), uncached(false), gen(0) {}
+
+    bool valid;
+    bool uncached;
+    T value;
+    unsigned long long gen; /* of the last write */
+  };
+
+  boost::mutex _mutex;
+  bool _enabled;
+  std::map< key_t, entry > _entries;
+  unsigned long long _gen;
+};
+
+#endif // OSMOSDR_PARAM_CACHE_H
@@ -0,0 +1,272 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "power_gate.h"
+#include "stream_tags.h"
+
+#define POWER_AVERAGE 32 /* samples, the time constant of the power estimate */
+
+static const float POWER_ALPHA = 1.0f / POWER_AVERAGE;
+
+power_gate_sptr make_power_gate( double threshold_db, size_t hold, size_t pre,
+                                 double rate )
+{
+  return gnuradio::get_initial_sptr( new power_gate( threshold_db, hold, pre, rate ) );
+}
+
+power_gate::power_gate( double threshold_db, size_t hold, size_t pre, double rate ) :
+  gr::block("power_gate",
+            gr::io_signature::make(1, 1, sizeof(gr_complex)),
+            gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _threshold(powf( 10.0f, float(threshold_db) / 10.0f )),
+  _hold(std::max( hold, size_t(1) )),
+  _pre(pre),
+  _rate(rate),
+  _power(0),
+  _open(false),
+  _below(0),
+  _delta(0),
+  _pending_pos(0)
+{
+  _history.reserve( _pre );
+  _pending.reserve( _pre + 1 );
+
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+void power_gate::set_sample_rate( double rate )
+{
+  _rate = rate;
+}
+
+/* \return the index of the sample opening the gate, nsamples if none does */
+size_t power_gate::detect( const gr_complex *in, size_t nsamples )
+{
+  for ( size_t i = 0; i < nsamples; i++ ) {
+    _power += POWER_ALPHA * (std::norm( in[i] ) - _power);
+
+    if ( _power > _threshold )
+      return i;
+  }
+
+  return nsamples;
+}
+
+void power_gate::keep_history( const gr_complex *in, size_t nsamples )
+{
+  if ( nsamples >= _pre ) {
+    _history.assign( in + nsamples - _pre, in + nsamples );
+    return;
+  }
+
+  _history.insert( _history.end(), in, in + nsamples );
+
+  if ( _history.size() > _pre )
+    _history.erase( _history.begin(), _history.end() - _pre );
+}
+
+/* remember the last tag of each key in the input range dropped */
+void power_gate::hold_tags( uint64_t start, uint64_t end )
+{
+  std::vector< gr::tag_t > tags;
+  get_tags_in_range( tags, 0, start, end );
+
+  BOOST_FOREACH( const gr::tag_t &tag, tags ) {
+    if ( pmt::eqv( tag.key, RX_RATE_KEY ) && pmt::is_real( tag.value ) )
+      _rate = pmt::to_double( tag.value );
+
+    size_t i;
+    for ( i = 0; i < _held.size() && ! pmt::eqv( _held[i].key, tag.key ); i++ )
+      ;
+
+    if ( i < _held.size() )
+      _held[i] = tag;
+    else
+      _held.push_back( tag );
+  }
+}
+
+/*
+ * Open the gate on the sample at input \p offset, the burst beginning with
+ * the history before it at output \p out_offset.
+ */
+void power_gate::open_burst( const gr_complex *trigger, uint64_t offset,
+                             uint64_t out_offset )
+{
+  const uint64_t first = offset - _history.size();
+
+  _pending.assign( _history.begin(), _history.end() );
+  _pending.push_back( *trigger );
+  _pending_pos = 0;
+  _history.clear();
+
+  _open = true;
+  _below = 0;
+  _delta = int64_t(first - out_offset);
+
+  add_item_tag( 0, out_offset, BURST_START_KEY, pmt::from_uint64( first ),
+                pmt::string_to_symbol( alias() ) );
+
+  BOOST_FOREACH( gr::tag_t &tag, _held ) {
+    if ( tag.offset >= first ) { /* within the history */
+      tag.offset -= _delta;
+    } else {
+      if ( pmt::eqv( tag.key, RX_TIME_KEY ) ) {
+        if ( _rate <= 0 )
+          continue; /* can't tell the time of the burst */
+
+        osmosdr::time_spec_t time = tag_to_time( tag.value );
+        time += osmosdr::time_spec_t( double(first - tag.offset) / _rate );
+
+        tag.value = pmt::make_tuple( pmt::from_uint64( time.get_full_secs() ),
+                                     pmt::from_double( time.get_frac_secs() ) );
+      }
+
+      tag.offset = out_offset;
+    }
+
+    add_item_tag( 0, tag );
+  }
+
+  _held.clear();
+}
+
+size_t power_gate::flush_pending( gr_complex *out, size_t space )
+{
+  const size_t n = std::min( _pending.size() - _pending_pos, space );
+  if ( ! n )
+    return 0;
+
+  memcpy( out, &_pending[0] + _pending_pos, n * sizeof(gr_complex) );
+  _pending_pos += n;
+
+  if ( _pending_pos == _pending.size() ) {
+    _pending.clear();
+    _pending_pos = 0;
+  }
+
+  return n;
+}
+
+/* copy the burst starting at input \p offset until the gate closes */
+size_t power_gate::pass( const gr_complex *in, gr_complex *out, size_t nsamples,
+                         uint64_t offset )
+{
+  bool closed = false;
+  size_t n = 0;
+
+  /* the estimate is updated in the same pass as the samples are copied */
+  while ( n < nsamples ) {
+    const gr_complex x = in[n++];
+
+    out[n - 1] = x;
+    _power += POWER_ALPHA * (std::norm( x ) - _power);
+
+    if ( _power > _threshold ) {
+      _below = 0;
+    } else if ( ++_below >= _hold ) {
+      closed = true;
+      break;
+    }
+  }
+
+  std::vector< gr::tag_t > tags;
+  get_tags_in_range( tags, 0, offset, offset + n );
+
+  BOOST_FOREACH( gr::tag_t &tag, tags ) {
+    if ( pmt::eqv( tag.key, RX_RATE_KEY ) && pmt::is_real( tag.value ) )
+      _rate = pmt::to_double( tag.value );
+
+    tag.offset -= _delta;
+    add_item_tag( 0, tag );
+  }
+
+  if ( closed ) {
+    const uint64_t last = offset + n - 1;
+
+    add_item_tag( 0, last - _delta, BURST_END_KEY, pmt::from_uint64( last ),
+                  pmt::string_to_symbol( alias() ) );
+    _open = false;
+  }
+
+  return n;
+}
+
+int power_gate::general_work( int noutput_items,
+                              gr_vector_int &ninput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  gr_complex *out = (gr_complex *) output_items[0];
+
+  const size_t ninput = ninput_items[0];
+  const size_t space = noutput_items;
+  size_t consumed = 0;
+  size_t produced = 0;
+
+  while ( true ) {
+    produced += flush_pending( out + produced, space - produced );
+
+    /* the rest of the burst start has to go out first */
+    if ( _pending.size() || consumed == ninput )
+      break;
+
+    const uint64_t offset = nitems_read(0) + consumed;
+
+    if ( _open ) {
+      if ( produced == space )
+        break;
+
+      const size_t n = pass( in + consumed, out + produced,
+                             std::min( ninput - consumed, space - produced ), offset );
+      consumed += n;
+      produced += n;
+    } else {
+      const size_t n = detect( in + consumed, ninput - consumed );
+      const bool opened = (n < ninput - consumed);
+
+      hold_tags( offset, offset + n + (opened ? 1 : 0) );
+      keep_history( in + consumed, n );
+      consumed += n;
+
+      if ( opened ) {
+        open_burst( in + consumed, offset + n, nitems_written(0) + produced );
+        consumed++;
+      }
+    }
+  }
+
+  consume_each( consumed );
+
+  return produced;
+}
@@ -0,0 +1,97 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_POWER_GATE_H
+#define OSMOSDR_POWER_GATE_H
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <gnuradio/block.h>
+
+class power_gate;
+
+typedef boost::shared_ptr< power_gate > power_gate_sptr;
+
+/*!
+ * \param threshold_db power opening the gate, in dB relative to full scale
+ * \param hold samples below the threshold closing it again
+ * \param pre samples preceding the opening passed along with the burst
+ * \param rate sample rate, to extrapolate rx_time onto the bursts
+ */
+power_gate_sptr make_power_gate( double threshold_db, size_t hold, size_t pre,
+                                 double rate = 0 );
+
+/*!
+ * \brief Passes only the bursts of a channel, dropping the noise between.
+ *
+ * The power is averaged over the last POWER_AVERAGE samples while they are
+ * copied, the gate opens on the sample it exceeds the threshold and closes
+ * after \p hold samples below it in a row. Each burst begins with up to
+ * \p pre samples dropped before it opened, its first sample is tagged with
+ * burst_start and its last one with burst_end, both carrying the offset of
+ * the sample in the ungated stream.
+ *
+ * Tags within a burst keep their place in it. The last tag of each key
+ * seen while closed is moved onto the first sample of the next burst,
+ * rx_time extrapolated to it when the sample rate is known.
+ */
+class power_gate : public gr::block
+{
+private:
+  friend power_gate_sptr make_power_gate( double threshold_db, size_t hold,
+                                          size_t pre, double rate );
+
+  power_gate( double threshold_db, size_t hold, size_t pre, double rate );
+
+public:
+  void set_sample_rate( double rate );
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  size_t detect( const gr_complex *in, size_t nsamples );
+  void keep_history( const gr_complex *in, size_t nsamples );
+  void hold_tags( uint64_t start, uint64_t end );
+  void open_burst( const gr_complex *trigger, uint64_t offset, uint64_t out_offset );
+  size_t flush_pending( gr_complex *out, size_t space );
+  size_t pass( const gr_complex *in, gr_complex *out, size_t nsamples,
+               uint64_t offset );
+
+  float _threshold; /* linear power */
+  size_t _hold;
+  size_t _pre;
+  double _rate;
+
+  float _power;     /* running average */
+  bool _open;
+  size_t _below;    /* samples below the threshold since the last above */
+  int64_t _delta;   /* input minus output offset within the current burst */
+
+  std::vector< gr_complex > _history; /* the last samples dropped, up to _pre */
+  std::vector< gr_complex > _pending; /* start of the burst, not output yet */
+  size_t _pending_pos;
+  std::vector< gr::tag_t > _held;     /* the last tag of each key dropped */
+};
+
+#endif // OSMOSDR_POWER_GATE_H
@@ -134,37 +134,55 @@ double meta_range_t::step(void) const{
     return *std::min_element(non_zero_steps.begin(), non_zero_steps.end());
 }
 
+static bool stops_before(const range_t &r, double value){
+    return r.stop() < value;
+}
+
 double meta_range_t::clip(double value, bool clip_step) const{
-    check_meta_range_monotonic(*this);
-    double last_stop = this->front().stop();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        //in-between ranges, clip to nearest
-        if (value < r.start()){
-            return (std::abs(value - r.start()) < std::abs(value - last_stop))?
-                r.start() : last_stop;
-        }
-        //in this range, clip here
-        if (value <= r.stop()){
-            if (! clip_step || r.step() == 0) return value;
-            return boost::math::round((value - r.start())/r.step())*r.step() + r.start();
-        }
-        //continue on to the next range
-        last_stop = r.stop();
+    if (this->empty()){
+        throw std::runtime_error("meta-range cannot be empty");
+    }
+    //the first range not entirely below the value, by binary search
+    const_iterator it = std::lower_bound(this->begin(), this->end(), value, stops_before);
+    if (it == this->end()) return this->back().stop();
+    //in this range, clip here
+    if (value >= it->start()){
+        if (! clip_step || it->step() == 0) return value;
+        return boost::math::round((value - it->start())/it->step())*it->step() + it->start();
+    }
+    if (it == this->begin()) return it->start();
+    //in-between ranges, clip to nearest
+    double last_stop = (it - 1)->stop();
+    if (it->start() < last_stop){
+        throw std::runtime_error("meta-range is not monotonic");
     }
-    return last_stop;
+    return (std::abs(value - it->start()) < std::abs(value - last_stop))?
+        it->start() : last_stop;
 }
 
 std::vector<double> meta_range_t::values() const {
     std::vector<double> values;
 
+    //count first, gain tables may have hundreds of steps
+    size_t count = 0;
+    BOOST_FOREACH(const range_t &r, (*this)) {
+        if (r.start() != r.stop() && r.step() != 0)
+            count += size_t((r.stop() - r.start()) / r.step() + 1e-9) + 1;
+        else
+            count += (r.start() != r.stop()) ? 2 : 1;
+    }
+    values.reserve(count);
+
     BOOST_FOREACH(const range_t &r, (*this)) {
         if (r.start() != r.stop()) {
             if ( r.step() == 0 ) {
                 values.push_back( r.start() );
                 values.push_back( r.stop() );
             } else {
-                for ( double val = r.start(); val <= r.stop(); val += r.step() ) {
-                    values.push_back( val );
+                //multiply instead of accumulating the rounding errors
+                size_t n = size_t((r.stop() - r.start()) / r.step() + 1e-9) + 1;
+                for ( size_t i = 0; i < n; i++ ) {
+                    values.push_back( r.start() + i * r.step() );
                 }
             }
         } else {
@@ -20,12 +20,147 @@
  */
 
 #include <fstream>
+#include <iostream>
+#include <cstring>
 #include <string>
 #include <sstream>
 #include <stdexcept>
 
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
 #include "redpitaya_common.h"
 
+redpitaya_options::redpitaya_options( dict_t dict ) :
+  host( "192.168.1.100" ),
+  port( 1001 ),
+  rcvbuf( 0 ),
+  sndbuf( 0 ),
+  nodelay( true ),
+  busy_poll( 0 )
+{
+  if ( dict.count( "redpitaya" ) )
+  {
+    std::vector< std::string > tokens;
+    boost::algorithm::split( tokens, dict["redpitaya"], boost::is_any_of( ":" ) );
+
+    if ( tokens[0].length() && ( tokens.size() == 1 || tokens.size() == 2 ) )
+      host = tokens[0];
+
+    if ( tokens.size() == 2 )
+      port = boost::lexical_cast< unsigned short >( tokens[1] );
+  }
+
+  if ( !host.length() )
+    host = "192.168.1.100";
+
+  if ( 0 == port )
+    port = 1001;
+
+  if ( dict.count( "rcvbuf" ) )
+    rcvbuf = boost::lexical_cast< int >( dict["rcvbuf"] );
+
+  if ( dict.count( "sndbuf" ) )
+    sndbuf = boost::lexical_cast< int >( dict["sndbuf"] );
+
+  if ( dict.count( "nodelay" ) )
+    nodelay = boost::lexical_cast< bool >( dict["nodelay"] );
+
+  if ( dict.count( "busy_poll" ) )
+    busy_poll = boost::lexical_cast< int >( dict["busy_poll"] );
+}
+
+static void set_option( SOCKET socket, int level, int name, int value )
+{
+  if ( setsockopt( socket, level, name, (const char *)&value, sizeof(value) ) < 0 )
+    std::cerr << "Setting socket option " << name << " to " << value
+              << " failed." << std::endl;
+}
+
+void redpitaya_connect( const redpitaya_options &opts, uint32_t base,
+                        SOCKET sockets[2] )
+{
+  std::stringstream message;
+  struct sockaddr_in addr;
+
+  sockets[0] = sockets[1] = INVSOC;
+
+  for ( size_t i = 0; i < 2; ++i )
+  {
+    if ( ( sockets[i] = socket( AF_INET, SOCK_STREAM, 0 ) ) == INVSOC )
+    {
+      redpitaya_close( sockets );
+      throw std::runtime_error( "Could not create TCP socket." );
+    }
+
+    /* buffer sizes have to be set before connecting to affect the window */
+    if ( 1 == i && opts.rcvbuf > 0 )
+      set_option( sockets[i], SOL_SOCKET, SO_RCVBUF, opts.rcvbuf );
+
+    if ( 1 == i && opts.sndbuf > 0 )
+      set_option( sockets[i], SOL_SOCKET, SO_SNDBUF, opts.sndbuf );
+
+#ifdef SO_BUSY_POLL
+    if ( 1 == i && opts.busy_poll > 0 )
+      set_option( sockets[i], SOL_SOCKET, SO_BUSY_POLL, opts.busy_poll );
+#endif
+
+    /* commands are tiny, don't let nagle hold them back */
+    if ( 0 == i && opts.nodelay )
+      set_option( sockets[i], IPPROTO_TCP, TCP_NODELAY, 1 );
+
+    memset( &addr, 0, sizeof(addr) );
+    addr.sin_family = AF_INET;
+    inet_pton( AF_INET, opts.host.c_str(), &addr.sin_addr );
+    addr.sin_port = htons( opts.port );
+
+    if ( ::connect( sockets[i], (struct sockaddr *)&addr, sizeof(addr) ) < 0 )
+    {
+      redpitaya_close( sockets );
+      message << "Could not connect to " << opts.host << ":" << opts.port << ".";
+      throw std::runtime_error( message.str() );
+    }
+
+    try {
+      redpitaya_send_command( sockets[i], base + i );
+    } catch ( std::runtime_error & ) {
+      redpitaya_close( sockets );
+      throw;
+    }
+  }
+}
+
+void redpitaya_close( SOCKET sockets[2] )
+{
+  for ( int i = 1; i >= 0; --i )
+  {
+    if ( sockets[i] == INVSOC )
+      continue;
+
+#if defined(_WIN32)
+    ::closesocket( sockets[i] );
+#else
+    ::close( sockets[i] );
+#endif
+    sockets[i] = INVSOC;
+  }
+}
+
+bool redpitaya_wait( SOCKET socket, bool write )
+{
+  fd_set fds;
+  timeval timeout;
+
+  timeout.tv_sec = 0;
+  timeout.tv_usec = 100000;
+
+  FD_ZERO( &fds );
+  FD_SET( socket, &fds );
+
+  return select( socket + 1, write ? NULL : &fds, write ? &fds : NULL,
+                 NULL, &timeout ) != 0;
+}
+
 void redpitaya_send_command( SOCKET socket, uint32_t command )
 {
   std::stringstream message;
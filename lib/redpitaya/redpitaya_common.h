@@ -21,6 +21,7 @@
 #ifndef REDPITAYA_COMMON_H
 #define REDPITAYA_COMMON_H
 
+#include <string>
 #include <stdint.h>
 
 #if defined(_WIN32)
@@ -37,6 +38,7 @@
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #ifndef SOCKET
 #define SOCKET int
@@ -50,6 +52,43 @@
 #endif
 #endif
 
+#include "arg_helpers.h"
+
 void redpitaya_send_command( SOCKET socket, uint32_t command );
 
+/*!
+ * Socket options given in the device arguments:
+ *   rcvbuf=<bytes> / sndbuf=<bytes> for the sample socket,
+ *   nodelay=0|1 (default 1) for the control socket,
+ *   busy_poll=<us> for the sample socket (SO_BUSY_POLL, Linux only).
+ */
+struct redpitaya_options
+{
+  redpitaya_options( dict_t dict );
+
+  std::string host;
+  unsigned short port;
+  int rcvbuf;
+  int sndbuf;
+  bool nodelay;
+  int busy_poll;
+};
+
+/*!
+ * Open the control (sockets[0]) and sample (sockets[1]) connections,
+ * announcing them with the commands \p base and \p base + 1.
+ * Throws std::runtime_error if the server can't be reached.
+ */
+void redpitaya_connect( const redpitaya_options &opts, uint32_t base,
+                        SOCKET sockets[2] );
+
+void redpitaya_close( SOCKET sockets[2] );
+
+/*!
+ * Wait up to 100 ms for \p socket to become readable or writable, so the
+ * streaming threads stay interruptible.
+ * \return false on timeout, true if ready or failed
+ */
+bool redpitaya_wait( SOCKET socket, bool write );
+
 #endif // REDPITAYA_COMMON_H
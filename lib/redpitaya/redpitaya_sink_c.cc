@@ -23,8 +23,12 @@
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
 
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -33,6 +37,7 @@
 #include "arg_helpers.h"
 
 #include "redpitaya_sink_c.h"
+#include "backend_registry.h"
 
 using namespace boost::assign;
 
@@ -41,17 +46,28 @@ redpitaya_sink_c_sptr make_redpitaya_sink_c(const std::string &args)
   return gnuradio::get_initial_sptr(new redpitaya_sink_c(args));
 }
 
+static sink_registrar redpitaya_registrar(
+  "redpitaya",
+  &make_backend< sink_iface, redpitaya_sink_c_sptr, &make_redpitaya_sink_c >,
+  &redpitaya_sink_c::get_devices,
+  BACKEND_NETWORK, BACKEND_ORDER_SOFTWARE + 10 );
+
+/* about 1.6 s at the highest rate, work() blocks while it's full */
+#define FIFO_SIZE  (1 << 24)
+#define WRITE_SIZE (1 << 16)
+
+/* the first attempt is made quickly, a restarting server is back soon */
+#define RECONNECT_MIN_MS 100  /* doubled after each attempt */
+#define RECONNECT_MAX_MS 1000
+
 redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
   gr::sync_block("redpitaya_sink_c",
                  gr::io_signature::make(1, 1, sizeof(gr_complex)),
-                 gr::io_signature::make(0, 0, 0))
+                 gr::io_signature::make(0, 0, 0)),
+  _ptt( false ),
+  _opts( params_to_dict( args ) ),
+  _fifo( FIFO_SIZE )
 {
-  std::string host = "192.168.1.100";
-  std::stringstream message;
-  unsigned short ptt = 0, port = 1001;
-  struct sockaddr_in addr;
-  uint32_t command;
-
 #if defined(_WIN32)
   WSADATA wsaData;
   WSAStartup( MAKEWORD(2, 2), &wsaData );
@@ -63,87 +79,135 @@ redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
 
   dict_t dict = params_to_dict( args );
 
-  if ( dict.count( "redpitaya" ) )
-  {
-    std::vector< std::string > tokens;
-    boost::algorithm::split( tokens, dict["redpitaya"], boost::is_any_of( ":" ) );
+  if ( dict.count("ptt") )
+    _ptt = boost::lexical_cast< unsigned short >( dict["ptt"] );
+
+  redpitaya_connect( _opts, 2, _sockets );
+
+  send_command( _ptt ? 2<<28 : 3<<28 );
+}
+
+redpitaya_sink_c::~redpitaya_sink_c()
+{
+  redpitaya_close( _sockets );
+#if defined(_WIN32)
+  WSACleanup();
+#endif
+}
+
+bool redpitaya_sink_c::start()
+{
+  _fifo.resume();
+
+  _thread = gr::thread::thread( boost::bind(&redpitaya_sink_c::writer_task, this) );
+
+  return true;
+}
+
+bool redpitaya_sink_c::stop()
+{
+  _fifo.cancel();
+
+  _thread.interrupt();
+  _thread.join();
+
+  _fifo.clear();
+
+  return true;
+}
 
-    if ( tokens[0].length() && ( tokens.size() == 1 || tokens.size() == 2 ) )
-      host = tokens[0];
+void redpitaya_sink_c::send_command( uint32_t command )
+{
+  boost::mutex::scoped_lock lock( _control_mutex );
 
-    if ( tokens.size() == 2 )
-      port = boost::lexical_cast< unsigned short >( tokens[1] );
+  try {
+    redpitaya_send_command( _sockets[0], command );
+  } catch ( std::runtime_error &ex ) {
+    /* reconnect() applies the current settings again */
+    std::cerr << ex.what() << std::endl;
   }
+}
 
-  if ( dict.count("ptt") )
-    ptt = boost::lexical_cast< unsigned short >( dict["ptt"] );
+/*
+ * Reconnect until the server is back, tuning it like before. The samples
+ * queued meanwhile are outdated and dropped.
+ */
+void redpitaya_sink_c::reconnect()
+{
+  std::cerr << "Connection to the Red Pitaya lost, reconnecting." << std::endl;
 
-  if ( !host.length() )
-    host = "192.168.1.100";
+  int delay = RECONNECT_MIN_MS;
 
-  if ( 0 == port )
-    port = 1001;
+  while ( true ) {
+    boost::this_thread::sleep( boost::posix_time::milliseconds( delay ) );
+    delay = std::min( 2 * delay, RECONNECT_MAX_MS );
 
-  for ( size_t i = 0; i < 2; ++i )
-  {
-    if ( ( _sockets[i] = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 )
-    {
-      throw std::runtime_error( "Could not create TCP socket." );
-    }
+    boost::mutex::scoped_lock lock( _control_mutex );
 
-    memset( &addr, 0, sizeof(addr) );
-    addr.sin_family = AF_INET;
-    inet_pton( AF_INET, host.c_str(), &addr.sin_addr );
-    addr.sin_port = htons( port );
+    redpitaya_close( _sockets );
 
-    if ( ::connect( _sockets[i], (struct sockaddr *)&addr, sizeof(addr) ) < 0 )
-    {
-      message << "Could not connect to " << host << ":" << port << ".";
-      throw std::runtime_error( message.str() );
+    try {
+      redpitaya_connect( _opts, 2, _sockets );
+      break;
+    } catch ( std::runtime_error & ) {
+      continue;
     }
-
-    command = i + 2;
-    redpitaya_send_command( _sockets[i], command );
   }
 
-  command = ptt ? 2<<28 : 3<<28;
-  redpitaya_send_command( _sockets[0], command );
+  send_command( _ptt ? 2<<28 : 3<<28 );
+  set_sample_rate( _rate );
+  set_center_freq( _freq );
+
+  _fifo.clear();
 }
 
-redpitaya_sink_c::~redpitaya_sink_c()
+/* Send from the fifo, so a stalling connection doesn't block work(). */
+void redpitaya_sink_c::writer_task()
 {
+  while ( _fifo.wait( 1 ) ) {
+    boost::this_thread::interruption_point();
+
+    if ( ! redpitaya_wait( _sockets[1], true ) )
+      continue;
+
+    size_t avail;
+    const unsigned char *src = _fifo.read_ptr( avail );
+
 #if defined(_WIN32)
-  ::closesocket( _sockets[1] );
-  ::closesocket( _sockets[0] );
-  WSACleanup();
+    int size = ::send( _sockets[1], (const char *)src,
+                       std::min( avail, size_t(WRITE_SIZE) ), 0 );
 #else
-  ::close( _sockets[1] );
-  ::close( _sockets[0] );
+    ssize_t size = ::send( _sockets[1], src,
+                           std::min( avail, size_t(WRITE_SIZE) ), MSG_NOSIGNAL );
 #endif
+
+    if ( size <= 0 ) {
+#if !defined(_WIN32)
+      if ( size < 0 && (EINTR == errno || EAGAIN == errno) )
+        continue;
+#endif
+      reconnect();
+      continue;
+    }
+
+    _fifo.read_commit( size );
+  }
 }
 
 int redpitaya_sink_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
-  const gr_complex *in = (const gr_complex *)input_items[0];
-
-#if defined(_WIN32)
-  int size;
-  int total = sizeof(gr_complex) * noutput_items;
-  size = ::send( _sockets[1], (char *)in, total, 0 );
-#else
-  ssize_t size;
-  ssize_t total = sizeof(gr_complex) * noutput_items;
-  size = ::send( _sockets[1], in, total, MSG_NOSIGNAL );
-#endif
+  const unsigned char *in = (const unsigned char *)input_items[0];
+  const size_t nbytes = noutput_items * sizeof(gr_complex);
 
-  if ( size != total )
-    throw std::runtime_error( "Sending samples failed." );
+  if ( ! _fifo.wait_free( std::min( nbytes, size_t(WRITE_SIZE) ) ) )
+    return WORK_DONE;
 
-  consume(0, noutput_items);
+  size_t n = std::min( nbytes, _fifo.capacity() - _fifo.size() );
+  n -= n % sizeof(gr_complex); /* whole samples only */
 
-  return 0;
+  return _fifo.write( in, n ) / sizeof(gr_complex);
 }
 
 std::string redpitaya_sink_c::name()
@@ -197,7 +261,7 @@ double redpitaya_sink_c::set_sample_rate( double rate )
   else return get_sample_rate();
 
   command |= 1<<28;
-  redpitaya_send_command( _sockets[0], command );
+  send_command( command );
 
   _rate = rate;
 
@@ -222,7 +286,7 @@ double redpitaya_sink_c::set_center_freq( double freq, size_t chan )
 
   command = (uint32_t)floor( freq * (1.0 + _corr * 1.0e-6 ) + 0.5 );
 
-  redpitaya_send_command( _sockets[0], command );
+  send_command( command );
 
   _freq = freq;
 
@@ -21,9 +21,13 @@
 #ifndef REDPITAYA_SINK_C_H
 #define REDPITAYA_SINK_C_H
 
+#include <boost/thread/mutex.hpp>
+
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "sink_iface.h"
+#include "sample_fifo.h"
 
 #include "redpitaya_common.h"
 
@@ -45,6 +49,9 @@ private:
 public:
   ~redpitaya_sink_c();
 
+  bool start();
+  bool stop();
+
   int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -78,8 +85,19 @@ public:
   std::string get_antenna( size_t chan = 0 );
 
 private:
+  void writer_task();
+  void reconnect();
+  void send_command( uint32_t command );
+
   double _freq, _rate, _corr;
+  bool _ptt;
+  redpitaya_options _opts;
+
+  boost::mutex _control_mutex; /* guards _sockets and the control commands */
   SOCKET _sockets[2];
+
+  sample_fifo< unsigned char > _fifo;
+  gr::thread::thread _thread;
 };
 
 #endif // REDPITAYA_SINK_C_H
@@ -23,16 +23,23 @@
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <gnuradio/io_signature.h>
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
 
 #include "redpitaya_source_c.h"
+#include "backend_registry.h"
 
 using namespace boost::assign;
 
@@ -41,17 +48,29 @@ redpitaya_source_c_sptr make_redpitaya_source_c(const std::string &args)
   return gnuradio::get_initial_sptr(new redpitaya_source_c(args));
 }
 
+static source_registrar redpitaya_registrar(
+  "redpitaya",
+  &make_backend< source_iface, redpitaya_source_c_sptr, &make_redpitaya_source_c >,
+  &redpitaya_source_c::get_devices,
+  BACKEND_NETWORK, BACKEND_ORDER_SOFTWARE + 10 );
+
+/* about 1.6 s at the highest rate, the reader only stops when it's full */
+#define FIFO_SIZE  (1 << 24)
+#define READ_SIZE  (1 << 16)
+
+/* the first attempt is made quickly, a restarting server is back soon */
+#define RECONNECT_MIN_MS 100  /* doubled after each attempt */
+#define RECONNECT_MAX_MS 1000
+
 redpitaya_source_c::redpitaya_source_c(const std::string &args) :
   gr::sync_block("redpitaya_source_c",
                  gr::io_signature::make(0, 0, 0),
-                 gr::io_signature::make(1, 1, sizeof(gr_complex)))
+                 gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _opts( params_to_dict( args ) ),
+  _fifo( FIFO_SIZE ),
+  _written( 0 ),
+  _read( 0 )
 {
-  std::string host = "192.168.1.100";
-  std::stringstream message;
-  unsigned short port = 1001;
-  struct sockaddr_in addr;
-  uint32_t command;
-
 #if defined(_WIN32)
   WSADATA wsaData;
   WSAStartup( MAKEWORD(2, 2), &wsaData );
@@ -61,79 +80,179 @@ redpitaya_source_c::redpitaya_source_c(const std::string &args) :
   _rate = 1.0e5;
   _corr = 0.0;
 
-  dict_t dict = params_to_dict( args );
+  redpitaya_connect( _opts, 0, _sockets );
+}
 
-  if ( dict.count( "redpitaya" ) )
-  {
-    std::vector< std::string > tokens;
-    boost::algorithm::split( tokens, dict["redpitaya"], boost::is_any_of( ":" ) );
+redpitaya_source_c::~redpitaya_source_c()
+{
+  redpitaya_close( _sockets );
+#if defined(_WIN32)
+  WSACleanup();
+#endif
+}
+
+bool redpitaya_source_c::start()
+{
+  _fifo.clear();
+  _fifo.resume();
+
+  _written = _read = 0;
+  _gaps.clear();
+
+  _thread = gr::thread::thread( boost::bind(&redpitaya_source_c::reader_task, this) );
+
+  return true;
+}
+
+bool redpitaya_source_c::stop()
+{
+  _fifo.cancel();
 
-    if ( tokens[0].length() && ( tokens.size() == 1 || tokens.size() == 2 ) )
-      host = tokens[0];
+  _thread.interrupt();
+  _thread.join();
+
+  return true;
+}
 
-    if ( tokens.size() == 2 )
-      port = boost::lexical_cast< unsigned short >( tokens[1] );
+void redpitaya_source_c::send_command( uint32_t command )
+{
+  boost::mutex::scoped_lock lock( _control_mutex );
+
+  try {
+    redpitaya_send_command( _sockets[0], command );
+  } catch ( std::runtime_error &ex ) {
+    /* reconnect() applies the current settings again */
+    std::cerr << ex.what() << std::endl;
   }
+}
 
-  if ( !host.length() )
-    host = "192.168.1.100";
+/*
+ * Reconnect until the server is back, tuning it like before. Whatever was
+ * sent in the meantime is lost, the first sample afterwards is tagged.
+ */
+void redpitaya_source_c::reconnect()
+{
+  std::cerr << "Connection to the Red Pitaya lost, reconnecting." << std::endl;
 
-  if ( 0 == port )
-    port = 1001;
+  int delay = RECONNECT_MIN_MS;
 
-  for ( size_t i = 0; i < 2; ++i )
-  {
-    if ( ( _sockets[i] = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 )
-      throw std::runtime_error( "Could not create TCP socket." );
-
-    memset( &addr, 0, sizeof(addr) );
-    addr.sin_family = AF_INET;
-    inet_pton( AF_INET, host.c_str(), &addr.sin_addr );
-    addr.sin_port = htons( port );
-
-    if ( ::connect( _sockets[i], (struct sockaddr *)&addr, sizeof(addr) ) < 0 )
-    {
-      message << "Could not connect to " << host << ":" << port << ".";
-      throw std::runtime_error( message.str() );
-    }
+  while ( true ) {
+    boost::this_thread::sleep( boost::posix_time::milliseconds( delay ) );
+    delay = std::min( 2 * delay, RECONNECT_MAX_MS );
 
-    command = i;
-    redpitaya_send_command( _sockets[i], command );
+    boost::mutex::scoped_lock lock( _control_mutex );
+
+    redpitaya_close( _sockets );
+
+    try {
+      redpitaya_connect( _opts, 0, _sockets );
+      break;
+    } catch ( std::runtime_error & ) {
+      continue;
+    }
   }
+
+  set_sample_rate( _rate );
+  set_center_freq( _freq );
+
+  boost::mutex::scoped_lock lock( _gap_mutex );
+  _gaps.push_back( _written );
 }
 
-redpitaya_source_c::~redpitaya_source_c()
+/*
+ * Receive into the fifo in large chunks, so a stalling connection is
+ * absorbed by the fifo instead of blocking the scheduler. Only whole
+ * samples are published, a partial one is completed by the next recv().
+ */
+void redpitaya_source_c::reader_task()
 {
+  size_t partial = 0;
+
+  while ( _fifo.wait_free( READ_SIZE ) ) {
+    boost::this_thread::interruption_point();
+
+    if ( ! redpitaya_wait( _sockets[1], false ) )
+      continue;
+
+    size_t avail;
+    unsigned char *dst = _fifo.write_ptr( avail );
+
 #if defined(_WIN32)
-  ::closesocket( _sockets[1] );
-  ::closesocket( _sockets[0] );
-  WSACleanup();
+    int size = ::recv( _sockets[1], (char *)dst + partial,
+                       std::min( avail, size_t(READ_SIZE) ) - partial, 0 );
 #else
-  ::close( _sockets[1] );
-  ::close( _sockets[0] );
+    ssize_t size = ::recv( _sockets[1], dst + partial,
+                           std::min( avail, size_t(READ_SIZE) ) - partial, 0 );
 #endif
+
+    if ( size <= 0 ) {
+#if !defined(_WIN32)
+      if ( size < 0 && (EINTR == errno || EAGAIN == errno) )
+        continue;
+#endif
+      partial = 0;
+      reconnect();
+      continue;
+    }
+
+    partial += size;
+
+    size_t whole = partial - partial % sizeof(gr_complex);
+    _fifo.write_commit( whole );
+    _written += whole / sizeof(gr_complex);
+
+    /* the rest stays in place, right at the next write position */
+    partial -= whole;
+  }
 }
 
 int redpitaya_source_c::work( int noutput_items,
                               gr_vector_const_void_star &input_items,
                               gr_vector_void_star &output_items )
 {
-  gr_complex *out = (gr_complex *)output_items[0];
+  unsigned char *out = (unsigned char *)output_items[0];
+  const size_t nbytes = noutput_items * sizeof(gr_complex);
 
-#if defined(_WIN32)
-  int size;
-  int total = sizeof(gr_complex) * noutput_items;
-  size = ::recv( _sockets[1], (char *)out, total, MSG_WAITALL );
-#else
-  ssize_t size;
-  ssize_t total = sizeof(gr_complex) * noutput_items;
-  size = ::recv( _sockets[1], out, total, MSG_WAITALL );
-#endif
+  _fifo.wait( std::min( nbytes, size_t(READ_SIZE) ) );
+
+  size_t done = 0;
+
+  for (int seg = 0; seg < 2 && done < nbytes; seg++) {
+    size_t avail;
+    const unsigned char *src = _fifo.read_ptr( avail );
+
+    size_t n = std::min( avail, nbytes - done );
+    n -= n % sizeof(gr_complex);
+    if ( n == 0 )
+      break;
+
+    memcpy( out + done, src, n );
+    _fifo.read_commit( n );
+
+    done += n;
+  }
+
+  const uint64_t produced = done / sizeof(gr_complex);
+
+  {
+    boost::mutex::scoped_lock lock( _gap_mutex );
+
+    while ( ! _gaps.empty() && _gaps.front() < _read + produced ) {
+      const uint64_t offset = nitems_written(0) + (_gaps.front() - _read);
+
+      add_item_tag( 0, offset, RX_RATE_KEY, pmt::from_double( _rate ), alias_pmt() );
+      add_item_tag( 0, offset, RX_FREQ_KEY, pmt::from_double( _freq ), alias_pmt() );
+
+      _gaps.pop_front();
+    }
+  }
+
+  _read += produced;
 
-  if ( size != total )
-    throw std::runtime_error( "Receiving samples failed." );
+  if ( done == 0 && _fifo.cancelled() )
+    return WORK_DONE;
 
-  return noutput_items;
+  return produced;
 }
 
 std::string redpitaya_source_c::name()
@@ -187,7 +306,7 @@ double redpitaya_source_c::set_sample_rate( double rate )
   else return get_sample_rate();
 
   command |= 1<<28;
-  redpitaya_send_command( _sockets[0], command );
+  send_command( command );
 
   _rate = rate;
 
@@ -212,7 +331,7 @@ double redpitaya_source_c::set_center_freq( double freq, size_t chan )
 
   command = (uint32_t)floor( freq * (1.0 + _corr * 1.0e-6 ) + 0.5 );
 
-  redpitaya_send_command( _sockets[0], command );
+  send_command( command );
 
   _freq = freq;
 
@@ -21,9 +21,15 @@
 #ifndef REDPITAYA_SOURCE_C_H
 #define REDPITAYA_SOURCE_C_H
 
+#include <deque>
+
+#include <boost/thread/mutex.hpp>
+
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "source_iface.h"
+#include "sample_fifo.h"
 
 #include "redpitaya_common.h"
 
@@ -45,6 +51,9 @@ private:
 public:
   ~redpitaya_source_c();
 
+  bool start();
+  bool stop();
+
   int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -78,8 +87,23 @@ public:
   std::string get_antenna( size_t chan = 0 );
 
 private:
+  void reader_task();
+  void reconnect();
+  void send_command( uint32_t command );
+
   double _freq, _rate, _corr;
+  redpitaya_options _opts;
+
+  boost::mutex _control_mutex; /* guards _sockets and the control commands */
   SOCKET _sockets[2];
+
+  sample_fifo< unsigned char > _fifo;
+  gr::thread::thread _thread;
+  uint64_t _written; /* samples queued by reader_task() */
+  uint64_t _read;    /* samples produced by work() */
+
+  boost::mutex _gap_mutex;
+  std::deque< uint64_t > _gaps; /* first sample after each reconnect */
 };
 
 #endif // REDPITAYA_SOURCE_C_H
@@ -0,0 +1,181 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "stream_tags.h"
+#include "retune_queue.h"
+
+retune_tagger_sptr make_retune_tagger( size_t itemsize )
+{
+  return gnuradio::get_initial_sptr( new retune_tagger( itemsize ) );
+}
+
+retune_tagger::retune_tagger( size_t itemsize ) :
+  gr::sync_block( "retune_tagger",
+                  gr::io_signature::make( 1, 1, itemsize ),
+                  gr::io_signature::make( 1, 1, itemsize ) ),
+  _itemsize( itemsize ),
+  _pending( false ),
+  _freq( 0 ),
+  _settle( 0 )
+{
+}
+
+void retune_tagger::retuned( double freq, uint64_t settle )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _pending = true;
+  _freq = freq;
+  _settle = settle;
+}
+
+int retune_tagger::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
+{
+  memcpy( output_items[0], input_items[0], noutput_items * _itemsize );
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( ! _pending )
+    return noutput_items;
+
+  if ( _settle >= uint64_t(noutput_items) ) {
+    _settle -= noutput_items;
+    return noutput_items;
+  }
+
+  add_item_tag( 0, nitems_written(0) + _settle,
+                RX_FREQ_KEY, pmt::from_double( _freq ), alias_pmt() );
+
+  _pending = false;
+
+  return noutput_items;
+}
+
+retune_queue::retune_queue( source_iface *dev, double settle ) :
+  _dev( dev ),
+  _settle( settle ),
+  _running( false )
+{
+}
+
+retune_queue::~retune_queue()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( ! _running )
+      return;
+
+    _running = false;
+    _cond.notify_all();
+  }
+
+  _thread.join();
+}
+
+void retune_queue::add_tagger( retune_tagger *tagger )
+{
+  boost::mutex::scoped_lock lock( _dev_mutex );
+
+  _taggers.push_back( tagger );
+}
+
+void retune_queue::post( size_t chan, double freq )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _pending[chan] = freq;
+
+  if ( ! _running ) {
+    _running = true;
+    _thread = gr::thread::thread( boost::bind(&retune_queue::control_task, this) );
+  }
+
+  _cond.notify_all();
+}
+
+void retune_queue::set_retuned_callback( const retuned_t &retuned )
+{
+  boost::mutex::scoped_lock lock( _dev_mutex );
+
+  _retuned = retuned;
+}
+
+double retune_queue::retune( size_t chan, double freq )
+{
+  boost::mutex::scoped_lock lock( _dev_mutex );
+
+  double actual = _dev->set_center_freq( freq, chan );
+  const uint64_t settle = uint64_t(_settle * _dev->get_sample_rate());
+
+  /* the tag is attached by the backend itself if it can, else downstream */
+  if ( chan < _taggers.size() && _taggers[chan] )
+    _taggers[chan]->retuned( actual, settle );
+  else
+    _dev->tag_retune( actual, settle, chan );
+
+  if ( _retuned )
+    _retuned( chan, actual );
+
+  return actual;
+}
+
+void retune_queue::control_task()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  while ( true ) {
+    while ( _pending.empty() && _running )
+      _cond.wait( lock );
+
+    /* pending requests are dropped on shutdown */
+    if ( ! _running )
+      break;
+
+    size_t chan = _pending.begin()->first;
+    double freq = _pending.begin()->second;
+    _pending.erase( _pending.begin() );
+
+    lock.unlock();
+
+    try {
+      retune( chan, freq );
+    } catch ( std::exception &ex ) {
+      std::cerr << "Retuning channel " << chan << " to " << freq
+                << " Hz failed: " << ex.what() << std::endl;
+    }
+
+    lock.lock();
+  }
+}
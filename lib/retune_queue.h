@@ -0,0 +1,126 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_RETUNE_QUEUE_H
+#define OSMOSDR_RETUNE_QUEUE_H
+
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include "source_iface.h"
+
+class retune_tagger;
+
+typedef boost::shared_ptr< retune_tagger > retune_tagger_sptr;
+
+retune_tagger_sptr make_retune_tagger( size_t itemsize );
+
+/*!
+ * \brief Tags the first sample produced after a retune with rx_freq.
+ *
+ * The tag lands on the first sample leaving the block once retuned() has
+ * been called, delayed by the settling time given. Samples still buffered
+ * in the driver or in flight towards this block may have been received at
+ * the old frequency, the settling time is meant to cover them.
+ *
+ * Only inserted with retune_tags=true, after devices whose backend can't
+ * tag at its own sample counter (BACKEND_RETUNE_TAGS), as it copies every
+ * sample.
+ */
+class retune_tagger : public gr::sync_block
+{
+private:
+  friend retune_tagger_sptr make_retune_tagger( size_t itemsize );
+
+  retune_tagger( size_t itemsize );
+
+public:
+  /*! \param settle samples to pass before tagging */
+  void retuned( double freq, uint64_t settle );
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  size_t _itemsize;
+
+  boost::mutex _mutex;
+  bool _pending;
+  double _freq;
+  uint64_t _settle;
+};
+
+/*!
+ * \brief Retunes the channels of one device from a control thread.
+ *
+ * post() returns immediately, the thread started on its first use then
+ * applies the requests in turn. Requests for a channel which is still
+ * waiting are replaced, so only the latest frequency is tuned once the
+ * device call in progress returns. Synchronous retunes go through retune()
+ * and are serialized with the queued ones.
+ */
+class retune_queue
+{
+public:
+  /*! \param settle seconds to wait before tagging a retune */
+  retune_queue( source_iface *dev, double settle );
+  ~retune_queue();
+
+  /*! Add the tagger of the next channel of the device, if it has one. */
+  void add_tagger( retune_tagger *tagger );
+
+  /*! Called with the device channel and actual frequency of each retune. */
+  typedef boost::function< void ( size_t chan, double freq ) > retuned_t;
+
+  void set_retuned_callback( const retuned_t &retuned );
+
+  void post( size_t chan, double freq );
+
+  /*! \return the actual frequency, as set_center_freq() of the device */
+  double retune( size_t chan, double freq );
+
+private:
+  void control_task();
+
+  source_iface *_dev;
+  std::vector< retune_tagger * > _taggers;
+  retuned_t _retuned;
+  double _settle;
+
+  boost::mutex _dev_mutex; /* serializes the device calls */
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  std::map< size_t, double > _pending; /* frequency by device channel */
+  bool _running;
+  gr::thread::thread _thread;
+};
+
+typedef boost::shared_ptr< retune_queue > retune_queue_sptr;
+
+#endif // OSMOSDR_RETUNE_QUEUE_H
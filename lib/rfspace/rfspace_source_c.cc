@@ -62,6 +62,9 @@
 
 #include "arg_helpers.h"
 #include "rfspace_source_c.h"
+#include "backend_registry.h"
+#include "stream_tags.h"
+#include "trace.h"
 
 using namespace boost::assign;
 #ifdef USE_ASIO
@@ -71,6 +74,18 @@ using boost::asio::deadline_timer;
 #define DEFAULT_HOST  "127.0.0.1" /* We assume a running "siqs" from CuteSDR project */
 #define DEFAULT_PORT  50000
 
+#define UDP_PACKET_SIZE     (1024*2)
+#define DEFAULT_UDP_BUFFERS 1024              /* datagrams queued for work() */
+#define DEFAULT_RCVBUF      (4 * 1024 * 1024) /* bytes, capped by net.core.rmem_max */
+#define WAIT_TIMEOUT        100               /* ms work() waits for samples at a time */
+#define UDP_BATCH_SIZE      32                /* datagrams per recvmmsg call */
+
+#define HEADER_SIZE 2
+#define SEQNUM_SIZE 2
+
+#define SCALE_16  (1.0f/32768.0f)
+#define SCALE_24  (1.0f/8388608.0f)
+
 /*
  * Create a new instance of rfspace_source_c and return
  * a boost shared_ptr.  This is effectively the public constructor.
@@ -80,6 +95,12 @@ rfspace_source_c_sptr make_rfspace_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new rfspace_source_c (args));
 }
 
+static source_registrar rfspace_registrar(
+  "rfspace",
+  &make_backend< source_iface, rfspace_source_c_sptr, &make_rfspace_source_c >,
+  &rfspace_source_c::get_devices,
+  BACKEND_HARDWARE | BACKEND_NETWORK, 90, "sdr-iq,sdr-ip,netsdr,cloudiq" );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -116,15 +137,30 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     _keep_running(false),
     _sequence(0),
     _nchan(1),
+    _sc16(false),
+    _24bit(false),
     _sample_rate(NAN),
     _bandwidth(0.0f),
-    _fifo(NULL)
+    _fifo(NULL),
+    _min_chunk(0),
+    _ring_offset(0),
+    _pkt_samples(0),
+    _run_udp_read_task(false),
+    _convert_16(SCALE_16),
+    _convert_24(SCALE_24)
 {
+  size_t num_buffers = DEFAULT_UDP_BUFFERS;
+  int rcvbuf = DEFAULT_RCVBUF;
+
+  _freq[0] = _freq[1] = 0;
+
   std::string host = "";
   unsigned short port = 0;
 
   dict_t dict = params_to_dict(args);
 
+  _rx_thread = rx_thread_params( dict );
+
   if ( dict.count("sdr-iq") )
     dict["rfspace"] = dict["sdr-iq"];
 
@@ -182,6 +218,18 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
   if ( _nchan < 1 || _nchan > 2 )
     throw std::runtime_error("Number of channels (nchan) must be 1 or 2");
 
+  if (dict.count("buffers"))
+    num_buffers = boost::lexical_cast< size_t >( dict["buffers"] );
+
+  if (dict.count("min_chunk"))
+    _min_chunk = boost::lexical_cast< size_t >( dict["min_chunk"] );
+
+  if ( num_buffers < UDP_BATCH_SIZE )
+    num_buffers = UDP_BATCH_SIZE;
+
+  if (dict.count("rcvbuf"))
+    rcvbuf = boost::lexical_cast< int >( dict["rcvbuf"] );
+
   if ( ! host.length() )
     host = DEFAULT_HOST;
 
@@ -225,7 +273,7 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
 
     _radio = RFSPACE_SDR_IQ; /* legitimate assumption */
 
-    _fifo = new boost::circular_buffer<gr_complex>( 200000 );
+    _fifo = new sample_fifo<gr_complex>( 200000 );
     if ( ! _fifo )
       throw std::runtime_error( "Failed to allocate sample FIFO" );
 
@@ -261,6 +309,14 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     _u.set_option(udp::socket::reuse_address(true));
     _t.set_option(udp::socket::reuse_address(true));
 
+    _u.set_option(udp::socket::receive_buffer_size(rcvbuf), ec);
+
+    udp::socket::receive_buffer_size actual;
+    _u.get_option(actual, ec);
+    if ( actual.value() < rcvbuf )
+      std::cerr << "UDP receive buffer is " << actual.value() << " bytes, "
+                << "raise net.core.rmem_max to get " << rcvbuf << std::endl;
+
 #else
 
     if ( (_tcp = socket(AF_INET, SOCK_STREAM, 0) ) < 0)
@@ -339,8 +395,20 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
       throw std::runtime_error("Bind of UDP socket failed: " + std::string(strerror(errno)));
     }
 
+    /* absorb bursts while work() is late, the kernel drops what doesn't fit */
+    setsockopt(_udp, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(int));
+
+    int actual = 0;
+    socklen_t optlen = sizeof(actual);
+    getsockopt(_udp, SOL_SOCKET, SO_RCVBUF, &actual, &optlen);
+    if ( actual < rcvbuf ) /* linux reports twice the value set */
+      std::cerr << "UDP receive buffer is " << actual << " bytes, "
+                << "raise net.core.rmem_max to get " << rcvbuf << std::endl;
+
 #endif
 
+    _ring.alloc( num_buffers, UDP_PACKET_SIZE );
+
   }
 
   /* request & print device information */
@@ -456,6 +524,27 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
       std::cerr << "NetSDR receiver required for dual channel support." << std::endl;
   }
 
+  /* the network radios are able to deliver their 16 bit samples natively,
+   * the SDR-IQ samples are passed through the fifo as gr_complex */
+  _sc16 = ( RFSPACE_SDR_IQ != _radio &&
+            args_to_item_size( args, "sc16" ) != sizeof (gr_complex) );
+
+  if ( _sc16 )
+    set_output_signature( gr::io_signature::make (output_signature()->min_streams(),
+                                                  output_signature()->max_streams(),
+                                                  2 * sizeof (int16_t)) );
+
+  /* SDR-IP 4.2.1, NETSDR 4.2.1 Receiver State: 24 bit contiguous mode */
+  if ( dict.count("bits") && "24" == dict["bits"] )
+  {
+    if ( RFSPACE_SDR_IQ == _radio )
+      std::cerr << "24 bit samples require a network receiver, using 16 bit." << std::endl;
+    else if ( _sc16 )
+      std::cerr << "24 bit samples can't be delivered as sc16, using 16 bit." << std::endl;
+    else
+      _24bit = true;
+  }
+
   /* preset reasonable defaults */
 
   if ( RFSPACE_SDR_IQ == _radio )
@@ -474,6 +563,8 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     set_sample_rate( 240000 );
     set_bandwidth( 0 );
   }
+
+  message_port_register_out( STREAM_STATS_PORT );
 #if 0
   std::cerr << "sample_rates: " << get_sample_rates().to_pp_string() << std::endl;
   std::cerr << "sample rate: " << (uint32_t)get_sample_rate() << std::endl;
@@ -504,6 +595,8 @@ rfspace_source_c::~rfspace_source_c ()
 
     _thread.join();
   }
+  else
+    stop_udp_read_task();
 
   close(_usb);
 
@@ -642,11 +735,13 @@ static size_t read_bytes( int fd, char *data, size_t size, bool &run )
 void rfspace_source_c::usb_read_task()
 {
   char data[1024*10];
-  size_t n_avail, to_copy;
+  size_t to_copy;
 
   if ( -1 == _usb )
     return;
 
+  _rx_thread.apply();
+
   while ( _run_usb_read_task )
   {
     size_t nbytes = read_bytes( _usb, data, 2, _run_usb_read_task );
@@ -676,41 +771,38 @@ void rfspace_source_c::usb_read_task()
 
     if ( 1024*8 == length )
     {
-      /* push samples into the fifo */
+      TRACE_ARRIVAL( "sdr-iq", length );
 
-      _fifo_lock.lock();
+      /* convert samples straight into the fifo, in up to two segments */
 
       size_t num_samples = length / 4;
-      n_avail = _fifo->capacity() - _fifo->size();
-      to_copy = (n_avail < num_samples ? n_avail : num_samples);
-
-      #define SCALE_16  (1.0f/32768.0f)
+      to_copy = 0;
 
       int16_t *sample = (int16_t *)(data + 2);
 
-      for ( size_t i = 0; i < to_copy; i++ )
+      for ( int seg = 0; seg < 2 && to_copy < num_samples; seg++ )
       {
-        /* Push sample to the fifo */
-        _fifo->push_back( gr_complex( *(sample+0) * SCALE_16,
-                                      *(sample+1) * SCALE_16 ) );
+        size_t n_avail;
+        float *dst = (float *)_fifo->write_ptr( n_avail );
 
-        /* offset to the next I+Q sample */
-        sample += 2;
-      }
+        size_t n = std::min( n_avail, num_samples - to_copy );
+        if ( 0 == n )
+          break;
 
-      #undef SCALE_16
+        for ( size_t i = 0; i < n * 2; i++ )
+          dst[i] = sample[i] * SCALE_16;
 
-      _fifo_lock.unlock();
+        sample += n * 2;
+        to_copy += n;
 
-      /* We have made some new samples available to the consumer in work() */
-      if (to_copy) {
-//        std::cerr << "+" << std::flush;
-        _samp_avail.notify_one();
+        _fifo->write_commit( n );
       }
 
       /* Indicate overrun, if neccesary */
-      if (to_copy < num_samples)
+      if (to_copy < num_samples) {
+        _stats.overflow( num_samples - to_copy );
         std::cerr << "O" << std::flush;
+      }
     }
     else
     {
@@ -729,12 +821,128 @@ void rfspace_source_c::usb_read_task()
   }
 }
 
+/* wait up to 100 ms for a datagram, so the receive thread can be stopped */
+static bool udp_wait( SOCKET fd )
+{
+  fd_set readfds;
+  FD_ZERO( &readfds );
+  FD_SET( fd, &readfds );
+
+  struct timeval tv = { 0, 100000 };
+
+  return select( fd + 1, &readfds, NULL, NULL, &tv ) > 0;
+}
+
+void rfspace_source_c::udp_read_task()
+{
+#ifdef USE_ASIO
+  const SOCKET fd = _u.native_handle();
+#else
+  const SOCKET fd = _udp;
+#endif
+
+  _rx_thread.apply();
+
+  while ( _run_udp_read_task )
+  {
+    /* datagrams arriving while the ring is full queue up in SO_RCVBUF and
+     * are dropped by the kernel once that is full as well, work() notices
+     * the gap in the sequence numbers */
+    if ( ! _ring.wait_free( 1 ) )
+      break;
+
+    if ( ! udp_wait( fd ) )
+      continue;
+
+#if defined(__linux__) && !defined(USE_ASIO)
+    struct mmsghdr msgs[UDP_BATCH_SIZE];
+    struct iovec iovecs[UDP_BATCH_SIZE];
+    size_t count = 0;
+
+    memset( msgs, 0, sizeof(msgs) );
+
+    for ( ; count < UDP_BATCH_SIZE; count++ )
+    {
+      unsigned char *buf = _ring.acquire( count );
+      if ( ! buf )
+        break;
+
+      iovecs[count].iov_base = buf;
+      iovecs[count].iov_len = _ring.len();
+      msgs[count].msg_hdr.msg_iov = &iovecs[count];
+      msgs[count].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* one syscall for everything queued in the socket buffer */
+    int ret = recvmmsg( fd, msgs, count, MSG_DONTWAIT, NULL );
+    if ( ret < 0 )
+    {
+      if ( EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno )
+        continue;
+
+      perror( "rfspace_source_c: recvmmsg" );
+      break;
+    }
+
+    for ( int i = 0; i < ret; i++ )
+      _ring.commit( msgs[i].msg_len );
+#else
+    unsigned char *buf;
+
+    /* drain the socket buffer into the free slots */
+    while ( (buf = _ring.acquire()) )
+    {
+#ifdef USE_ASIO
+      boost::system::error_code ec;
+
+      if ( ! _u.available( ec ) )
+        break;
+
+      udp::endpoint ep;
+      size_t rx_bytes = _u.receive_from( boost::asio::buffer(buf, _ring.len()), ep, 0, ec );
+      if ( ec )
+        break;
+#else
+      ssize_t rx_bytes = recvfrom( fd, buf, _ring.len(), MSG_DONTWAIT, NULL, NULL );
+      if ( rx_bytes < 0 )
+        break;
+#endif
+
+      _ring.commit( rx_bytes );
+    }
+#endif
+  }
+
+  /* let work() return instead of waiting forever after a socket error */
+  _ring.cancel();
+}
+
+void rfspace_source_c::stop_udp_read_task()
+{
+  if ( ! _run_udp_read_task )
+    return;
+
+  _run_udp_read_task = false;
+  _ring.cancel();
+
+  _thread.join();
+}
+
 bool rfspace_source_c::start()
 {
   _sequence = 0;
   _running = true;
   _keep_running = false;
 
+  if ( RFSPACE_SDR_IQ != _radio )
+  {
+    _ring.reset();
+    _ring_offset = 0;
+
+    _run_udp_read_task = true;
+    _thread = gr::thread::thread( boost::bind(&rfspace_source_c::udp_read_task, this) );
+  }
+
   /* SDR-IP 4.2.1 Receiver State */
   /* NETSDR 4.2.1 Receiver State */
   unsigned char start[] = { 0x08, 0x00, 0x18, 0x00, 0x80, 0x02, 0x00, 0x00 };
@@ -745,7 +953,7 @@ bool rfspace_source_c::start()
 
   unsigned char mode = 0; /* 0 = 16 bit Contiguous Mode */
 
-  if ( 0 ) /* TODO: 24 bit Contiguous mode */
+  if ( _24bit ) /* 24 bit Contiguous mode */
     mode |= 0x80;
 
   if ( 0 ) /* TODO: Hardware Triggered Pulse mode */
@@ -773,16 +981,18 @@ bool rfspace_source_c::stop()
   if ( RFSPACE_SDR_IQ == _radio )
     stop[sizeof(stop)-4] = 0x81;
 
-  return transaction( stop, sizeof(stop) );
+  bool ok = transaction( stop, sizeof(stop) );
+
+  stop_udp_read_task();
+
+  return ok;
 }
 
-/* Main work function, pull samples from the socket */
+/* Main work function, pull samples from the fifo or the datagram ring */
 int rfspace_source_c::work( int noutput_items,
                            gr_vector_const_void_star &input_items,
                            gr_vector_void_star &output_items )
 {
-  unsigned char data[1024*2];
-
   if ( ! _running )
     return WORK_DONE;
 
@@ -792,22 +1002,26 @@ int rfspace_source_c::work( int noutput_items,
     {
       gr_complex *out = (gr_complex *)output_items[0];
 
-      boost::unique_lock<boost::mutex> lock(_fifo_lock);
+      /* deliver what is there as soon as there is a chunk, rather than
+       * stalling the low rates until noutput_items arrived */
+      const size_t chunk = _min_chunk ? _min_chunk : size_t( _sample_rate / 1000 ) + 1;
 
-      /* Wait until we have the requested number of samples */
-      int n_samples_avail = _fifo->size();
+      if ( ! _fifo->wait( std::min( size_t(noutput_items), chunk ),
+                          boost::posix_time::milliseconds( WAIT_TIMEOUT ) ) )
+        return 0; /* look at _running again */
 
-      while ( n_samples_avail < noutput_items )
-      {
-        _samp_avail.wait(lock);
-        n_samples_avail = _fifo->size();
-      }
+      const size_t queued = _fifo->size();
+      _stats.fill( queued, _fifo->capacity() );
+      _stats.latency( queued, _sample_rate );
 
-      for ( int i = 0; i < noutput_items; ++i )
-      {
-        out[i] = _fifo->at(0);
-        _fifo->pop_front();
-      }
+      /* the fifo keeps no stamps, the oldest sample arrived queued samples ago */
+      TRACE_OUTPUT( this, "sdr-iq", nitems_written( 0 ),
+                    gr::high_res_timer_now() - gr::high_res_timer_type( queued / _sample_rate * gr::high_res_timer_tps() ) );
+
+      noutput_items = _fifo->read( out, std::min( size_t(noutput_items), queued ) );
+
+      if ( _stats.publish_due() )
+        message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
 
 //      std::cerr << "-" << std::flush;
     }
@@ -815,81 +1029,137 @@ int rfspace_source_c::work( int noutput_items,
     return noutput_items;
   }
 
-#ifdef USE_ASIO
-  udp::endpoint ep;
-  size_t rx_bytes = _u.receive_from( boost::asio::buffer(data, sizeof(data)), ep );
-#else
-  struct sockaddr_in sa_in;           /* remote address */
-  socklen_t addrlen = sizeof(sa_in);  /* length of addresses */
-  ssize_t rx_bytes = recvfrom(_udp, data, sizeof(data), 0, (struct sockaddr *)&sa_in, &addrlen);
-  if ( rx_bytes <= 0 )
-  {
-    std::cerr << "recvfrom returned " << rx_bytes << std::endl;
+  /* let the thread fill up at least one datagram */
+  if ( ! _ring.wait( 1 ) )
     return WORK_DONE;
-  }
-#endif
 
-  #define HEADER_SIZE 2
-  #define SEQNUM_SIZE 2
+  const size_t sample_size = (_24bit ? 3 : 2) * 2 * _nchan;
+  const unsigned char *data;
+  size_t rx_bytes;
+  int produced = 0;
 
-//  bool is_24_bit = false;   // TODO: implement 24 bit sample format
+  _stats.fill( _ring.used(), _ring.num() );
+  _stats.latency( _ring.used() * _pkt_samples, _sample_rate );
 
-  /* check header */
-  if ( (0x04 == data[0] && (0x84 == data[1] || 0x82 == data[1])) )
+  /* drain as many datagrams as fit, the last one may be consumed partially */
+  while ( produced < noutput_items && (data = _ring.front( &rx_bytes )) )
   {
-//    is_24_bit = false;
-  }
-  else if ( (0xA4 == data[0] && 0x85 == data[1]) ||
-            (0x84 == data[0] && 0x81 == data[1]) )
-  {
-//    is_24_bit = true;
-    return 0;
-  }
-  else
-    return 0;
+    if ( 0 == _ring_offset )
+    {
+      /* check header, large or small packets of the format requested */
+      bool is_16_bit = (0x04 == data[0] && (0x84 == data[1] || 0x82 == data[1]));
+      bool is_24_bit = ((0xA4 == data[0] && 0x85 == data[1]) ||
+                        (0x84 == data[0] && 0x81 == data[1]));
 
-  uint16_t sequence = *((uint16_t *)(data + HEADER_SIZE));
+      if ( rx_bytes < HEADER_SIZE + SEQNUM_SIZE ||
+           ! (_24bit ? is_24_bit : is_16_bit) )
+      {
+        _ring.pop();
+        continue;
+      }
 
-  uint16_t diff = sequence - _sequence;
+      uint16_t sequence = *((uint16_t *)(data + HEADER_SIZE));
 
-  if ( diff > 1 )
-  {
-    std::cerr << "Lost " << diff << " packets from "
-#ifdef USE_ASIO
-              << ep
-#else
-              << inet_ntoa(sa_in.sin_addr) << ":" << ntohs(sa_in.sin_port)
-#endif
-              << std::endl;
-  }
+      uint16_t diff = sequence - _sequence;
+
+      if ( diff > 1 )
+      {
+        /* every packet carries the same number of samples */
+        _stats.overflow( (diff - 1) * ((rx_bytes - HEADER_SIZE - SEQNUM_SIZE) /
+                                       sample_size) );
+
+        std::cerr << "Lost " << diff << " packets" << std::endl;
 
-  _sequence = (0xffff == sequence) ? 0 : sequence;
+        /* mark the discontinuity like the usrp_source after an overflow */
+        for ( size_t chan = 0; chan < _nchan; chan++ )
+        {
+          const uint64_t offset = nitems_written(chan) + produced;
+
+          add_item_tag( chan, offset, RX_RATE_KEY, pmt::from_double( _sample_rate ), alias_pmt() );
+          add_item_tag( chan, offset, RX_FREQ_KEY, pmt::from_double( _freq[chan] ), alias_pmt() );
+        }
+      }
+
+      _sequence = (0xffff == sequence) ? 0 : sequence;
+
+      _pkt_samples = (rx_bytes - HEADER_SIZE - SEQNUM_SIZE) / sample_size;
+      _ring_offset = HEADER_SIZE + SEQNUM_SIZE;
+    }
+
+    size_t nsamples = std::min( (rx_bytes - _ring_offset) / sample_size,
+                                size_t(noutput_items - produced) );
+
+    convert( data + _ring_offset, output_items, produced, nsamples );
+
+    produced += nsamples;
+    _ring_offset += nsamples * sample_size;
 
-  /* get pointer to samples */
-  int16_t *sample = (int16_t *)(data + HEADER_SIZE + SEQNUM_SIZE);
+    if ( rx_bytes - _ring_offset < sample_size )
+    {
+      _ring.pop();
+      _ring_offset = 0;
+    }
+  }
 
-  size_t rx_samples = (rx_bytes - HEADER_SIZE - SEQNUM_SIZE) / (sizeof(int16_t) * 2);
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
+  return produced;
+}
 
-  #define SCALE_16  (1.0f/32768.0f)
+/* convert \p nsamples native samples into the outputs, starting at \p offset */
+void rfspace_source_c::convert( const unsigned char *data, gr_vector_void_star &output_items,
+                                size_t offset, size_t nsamples )
+{
+  const int16_t *sample = (const int16_t *)data;
 
-  if ( 1 == _nchan )
+  if ( _24bit )
   {
-    gr_complex *out = (gr_complex *)output_items[0];
-    for ( size_t i = 0; i < rx_samples; i++ )
+    gr_complex *out1 = (gr_complex *)output_items[0] + offset;
+
+    if ( 1 == _nchan )
     {
-      out[i] = gr_complex( *(sample+0) * SCALE_16,
-                           *(sample+1) * SCALE_16 );
+      _convert_24( data, out1, nsamples );
+      return;
+    }
 
-      sample += 2;
+    /* convert both channels at once, then split them */
+    _convert_buf.resize( nsamples * 2 );
+    _convert_24( data, &_convert_buf[0], nsamples * 2 );
+
+    gr_complex *out2 = (gr_complex *)output_items[1] + offset;
+    for ( size_t i = 0; i < nsamples; i++ )
+    {
+      out1[i] = _convert_buf[2*i+0];
+      out2[i] = _convert_buf[2*i+1];
     }
   }
+  else if ( _sc16 )
+  {
+    if ( 2 == _nchan )
+    {
+      /* each I/Q pair of int16 is copied as one 32 bit word */
+      const uint32_t *in = (const uint32_t *)sample;
+      uint32_t *out1 = (uint32_t *)output_items[0] + offset;
+      uint32_t *out2 = (uint32_t *)output_items[1] + offset;
+      for ( size_t i = 0; i < nsamples; i++ )
+      {
+        out1[i] = in[2*i+0];
+        out2[i] = in[2*i+1];
+      }
+    }
+    else
+      memcpy( (uint32_t *)output_items[0] + offset, sample, nsamples * sizeof(int16_t) * 2 );
+  }
+  else if ( 1 == _nchan )
+  {
+    _convert_16( sample, (gr_complex *)output_items[0] + offset, nsamples );
+  }
   else if ( 2 == _nchan )
   {
-    rx_samples /= 2;
-
-    gr_complex *out1 = (gr_complex *)output_items[0];
-    gr_complex *out2 = (gr_complex *)output_items[1];
-    for ( size_t i = 0; i < rx_samples; i++ )
+    gr_complex *out1 = (gr_complex *)output_items[0] + offset;
+    gr_complex *out2 = (gr_complex *)output_items[1] + offset;
+    for ( size_t i = 0; i < nsamples; i++ )
     {
       out1[i] = gr_complex( *(sample+0) * SCALE_16,
                             *(sample+1) * SCALE_16 );
@@ -900,12 +1170,6 @@ int rfspace_source_c::work( int noutput_items,
       sample += 4;
     }
   }
-
-  #undef SCALE_16
-
-  noutput_items = rx_samples;
-
-  return noutput_items;
 }
 
 /* discovery protocol internals taken from CuteSDR project */
@@ -1504,7 +1768,11 @@ double rfspace_source_c::set_center_freq( double freq, size_t chan )
 
   transaction( tune, sizeof(tune) );
 
-  return get_center_freq( chan );
+  double actual = get_center_freq( chan );
+
+  _freq[chan] = actual; /* apply_channel() only accepts 0 and 1 */
+
+  return actual;
 }
 
 double rfspace_source_c::get_center_freq( size_t chan )
@@ -1709,3 +1977,8 @@ osmosdr::freq_range_t rfspace_source_c::get_bandwidth_range( size_t chan )
 
   return bandwidths;
 }
+
+osmosdr::stream_stats_t rfspace_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
@@ -29,12 +29,16 @@
 #include <gnuradio/block.h>
 #include <gnuradio/sync_block.h>
 
-#include <boost/circular_buffer.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
 
 #include "osmosdr/ranges.h"
 #include "source_iface.h"
+#include "sample_fifo.h"
+#include "transfer_ring.h"
+#include "sample_convert.h"
+#include "stream_stats.h"
+#include "rx_thread.h"
 #ifdef USE_ASIO
 using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
@@ -120,6 +124,8 @@ public:
   double get_bandwidth( size_t chan = 0 );
   osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private: /* functions */
   void apply_channel( unsigned char *cmd, size_t chan = 0 );
 
@@ -129,6 +135,11 @@ private: /* functions */
                     std::vector< unsigned char > &response );
 
   void usb_read_task();
+  void udp_read_task();
+  void stop_udp_read_task();
+
+  void convert( const unsigned char *data, gr_vector_void_star &output_items,
+                size_t offset, size_t nsamples );
 
 private: /* members */
   enum radio_type
@@ -157,15 +168,29 @@ private: /* members */
   uint16_t _sequence;
 
   size_t _nchan;
+  bool _sc16; /* deliver native 16 bit samples, see cpu_format */
+  bool _24bit; /* network radios in 24 bit contiguous mode */
   double _sample_rate;
   double _bandwidth;
+  double _freq[2]; /* last tuned, for the tags after lost packets */
 
   gr::thread::thread _thread;
+  rx_thread_params _rx_thread;
   bool _run_usb_read_task;
 
-  boost::circular_buffer<gr_complex> *_fifo;
-  boost::mutex _fifo_lock;
-  boost::condition_variable _samp_avail;
+  sample_fifo<gr_complex> *_fifo;
+  size_t _min_chunk; /* samples work() waits for, 0 for a millisecond worth */
+
+  /* datagrams of the network radios, filled by udp_read_task */
+  transfer_ring _ring;
+  size_t _ring_offset; /* bytes of the front datagram already consumed */
+  size_t _pkt_samples; /* samples per datagram, for the latency estimate */
+  bool _run_udp_read_task;
+
+  convert_16bit _convert_16;
+  convert_24bit _convert_24;
+  std::vector< gr_complex > _convert_buf; /* dual channel 24 bit samples */
+  stream_stats _stats;
 
   std::vector< unsigned char > _resp;
   boost::mutex _resp_lock;
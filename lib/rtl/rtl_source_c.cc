@@ -28,12 +28,13 @@
 #endif
 
 #include "rtl_source_c.h"
+#include "backend_registry.h"
 #include <gnuradio/io_signature.h>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
-#include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
 
 #include <stdexcept>
 #include <iostream>
@@ -42,12 +43,15 @@
 #include <rtl-sdr.h>
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
+#include "trace.h"
 
 using namespace boost::assign;
 
 #define BUF_LEN  (16 * 32 * 512) /* must be multiple of 512 */
 #define BUF_NUM   15
 #define BUF_SKIP  1 // buffers to skip due to initial garbage
+#define PREFILL   3 // buffers queued before work() produces
 
 #define BYTES_PER_SAMPLE  2 // rtl device delivers 8 bit unsigned IQ data
 
@@ -61,6 +65,12 @@ make_rtl_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new rtl_source_c (args));
 }
 
+static source_registrar rtl_registrar(
+  "rtl",
+  &make_backend< source_iface, rtl_source_c_sptr, &make_rtl_source_c >,
+  &ignore_fake< &rtl_source_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_RETUNE_TAGS, 30 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -81,14 +91,20 @@ static const int MAX_OUT = 1;	// maximum number of output streams
 rtl_source_c::rtl_source_c (const std::string &args)
   : gr::sync_block ("rtl_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
-        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+        gr::io_signature::make(MIN_OUT, MAX_OUT, args_to_item_size(args, "sc8"))),
+    _sc8(args_to_item_size(args, "sc8") != sizeof (gr_complex)),
+    _real_rail(-1),
+    _quarter(0),
     _dev(NULL),
-    _buf(NULL),
+    _latency(params_to_dict(args)),
+    _pool(params_to_dict(args)),
+    _buf_fixed(false),
+    _prefill(_latency.prefill(PREFILL)),
     _running(false),
     _no_tuner(false),
     _auto_gain(false),
     _if_gain(0),
-    _skipped(0)
+    _stream(_stats, "rtl", 127.4f, 1.0f/128.0f)
 {
   int ret;
   int index;
@@ -100,6 +116,8 @@ rtl_source_c::rtl_source_c (const std::string &args)
 
   dict_t dict = params_to_dict(args);
 
+  _rx_thread = rx_thread_params( dict );
+
   if (dict.count("rtl")) {
     std::string value = dict["rtl"];
 
@@ -150,7 +168,38 @@ rtl_source_c::rtl_source_c (const std::string &args)
   if (dict.count("offset_tune"))
     offset_tune = boost::lexical_cast< unsigned int >( dict["offset_tune"] );
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  if (dict.count("decim")) {
+    unsigned int decim = boost::lexical_cast< unsigned int >( dict["decim"] );
+
+    if ( decim > 1 && _sc8 )
+      throw std::runtime_error("Decimation requires cpu_format=fc32.");
+
+    if ( decim > 1 )
+      std::cerr << "Decimating by " << decim << "." << std::endl;
+
+    _decim = fir_decimator( decim );
+  }
+
+  if (dict.count("direct_real") && "true" == dict["direct_real"]) {
+    if ( direct_samp != 1 && direct_samp != 2 )
+      throw std::runtime_error("direct_real requires direct_samp=1 or 2.");
+
+    if ( _sc8 )
+      throw std::runtime_error("direct_real requires cpu_format=fc32.");
+
+    if ( _decim.enabled() )
+      throw std::runtime_error("direct_real can't be combined with decim.");
+
+    /* with the IF at 0 Hz the other rail carries nothing but noise, the
+     * real samples are shifted by fs/4 and decimated into complex ones */
+    _real_rail = direct_samp - 1;
+    _decim = fir_decimator( 2 );
+
+    std::cerr << "Using the real samples of the "
+              << (_real_rail ? "Q" : "I") << " branch." << std::endl;
+  }
+
+  _buf_num = _buf_len = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -158,6 +207,8 @@ rtl_source_c::rtl_source_c (const std::string &args)
   if (dict.count("buflen"))
     _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
 
+  _buf_fixed = (_buf_num || _buf_len);
+
   if (0 == _buf_num)
     _buf_num = BUF_NUM;
 
@@ -169,19 +220,6 @@ rtl_source_c::rtl_source_c (const std::string &args)
               << std::endl;
   }
 
-  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
-
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i <= 0xffff; i++) {
-#ifdef BOOST_LITTLE_ENDIAN
-    _lut.push_back( gr_complex( (float(i & 0xff) - 127.4f) * (1.0f/128.0f),
-                                (float(i >> 8) - 127.4f) * (1.0f/128.0f) ) );
-#else // BOOST_BIG_ENDIAN
-    _lut.push_back( gr_complex( (float(i >> 8) - 127.4f) * (1.0f/128.0f),
-                                (float(i & 0xff) - 127.4f) * (1.0f/128.0f) ) );
-#endif
-  }
-
   _dev = NULL;
   ret = rtlsdr_open( &_dev, dev_index );
   if (ret < 0)
@@ -216,6 +254,9 @@ rtl_source_c::rtl_source_c (const std::string &args)
     if (ret < 0)
       throw std::runtime_error("Failed to enable direct sampling.");
     _no_tuner = true;
+
+    if ( _real_rail >= 0 )
+      rtlsdr_set_center_freq( _dev, 0 ); /* keep the IF at 0 Hz */
   }
 
   if (offset_tune) {
@@ -230,12 +271,16 @@ rtl_source_c::rtl_source_c (const std::string &args)
 
   set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
+  /* the ranges differ by tuner and with direct sampling */
+  if ( strlen(serial) )
+    _device_id = std::string("rtl-") + serial + "-" +
+      boost::lexical_cast< std::string >( int(rtlsdr_get_tuner_type(_dev)) ) + "-" +
+      boost::lexical_cast< std::string >( direct_samp );
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(_buf_len);
-  }
+  _stream.alloc( _buf_num, _buf_len, _pool );
+  _stream.skip( BUF_SKIP );
+
+  message_port_register_out( STREAM_STATS_PORT );
 }
 
 /*
@@ -254,22 +299,32 @@ rtl_source_c::~rtl_source_c ()
     rtlsdr_close( _dev );
     _dev = NULL;
   }
-
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-  }
 }
 
 bool rtl_source_c::start()
 {
+  if ( ! _buf_fixed && latency_profile::THROUGHPUT != _latency.mode() ) {
+    /* the usb transfers take about the same time to fill at any rate */
+    const double rate = rtlsdr_get_sample_rate( _dev );
+    const unsigned int len = _latency.buf_len( rate, BYTES_PER_SAMPLE, 512, BUF_LEN );
+    const unsigned int num = _latency.buf_num( len, rate, BYTES_PER_SAMPLE, BUF_NUM );
+
+    if ( len != _buf_len || num != _buf_num ) {
+      _buf_len = len;
+      _buf_num = num;
+      _stream.alloc( _buf_num, _buf_len, _pool );
+
+      std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
+                << std::endl;
+    }
+  }
+
+  _stream.reset();
   _running = true;
   _thread = gr::thread::thread(_rtlsdr_wait, this);
 
+  _pause.started();
+
   return true;
 }
 
@@ -291,26 +346,7 @@ void rtl_source_c::_rtlsdr_callback(unsigned char *buf, uint32_t len, void *ctx)
 
 void rtl_source_c::rtlsdr_callback(unsigned char *buf, uint32_t len)
 {
-  if (_skipped < BUF_SKIP) {
-    _skipped++;
-    return;
-  }
-
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
-
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
-  }
-
-  _buf_cond.notify_one();
+  _stream.push( buf, len );
 }
 
 void rtl_source_c::_rtlsdr_wait(rtl_source_c *obj)
@@ -320,6 +356,8 @@ void rtl_source_c::_rtlsdr_wait(rtl_source_c *obj)
 
 void rtl_source_c::rtlsdr_wait()
 {
+  _rx_thread.apply(); /* the callbacks run on this thread */
+
   int ret = rtlsdr_read_async( _dev, _rtlsdr_callback, (void *)this, _buf_num, _buf_len );
 
   _running = false;
@@ -327,50 +365,120 @@ void rtl_source_c::rtlsdr_wait()
   if ( ret != 0 )
     std::cerr << "rtlsdr_read_async returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  _stream.cancel();
+}
+
+/* Convert the active rail and shift it down by fs/4, so 0 to fs/2 of the
+ * real signal becomes -fs/4 to fs/4, ready to be decimated by 2. */
+void rtl_source_c::convert_real( const unsigned char *buf, gr_complex *out, int nsamples )
+{
+  float *real = (float *)out + nsamples; /* upper half, expanded in place */
+
+  _stream.convert().rail( buf, real, nsamples, _real_rail );
+
+  for (int i = 0; i < nsamples; i++) {
+    const float x = real[i]; /* read before out[i] may overwrite it */
+
+    switch ( _quarter ) {
+    case 0: out[i] = gr_complex(  x,  0 ); break;
+    case 1: out[i] = gr_complex(  0, -x ); break;
+    case 2: out[i] = gr_complex( -x,  0 ); break;
+    case 3: out[i] = gr_complex(  0,  x ); break;
+    }
+
+    _quarter = (_quarter + 1) & 3;
+  }
+}
+
+/* The conversions the generic rx_stream::read() doesn't do, the real
+ * samples of direct sampling or the native 8 bit ones. */
+int rtl_source_c::read_native( void *out, int noutput_items )
+{
+  int produced = 0;
+  const unsigned char *buf;
+  size_t avail;
+
+  while ( produced < noutput_items &&
+          (avail = _stream.front( buf, this, nitems_written( 0 ) + produced,
+                                  _decim.decimation() )) ) {
+    int nin = std::min( noutput_items - produced, int( avail ) );
+    int nout = nin;
+
+    if ( _decim.enabled() ) {
+      size_t space;
+      gr_complex *in = _decim.input( space );
+
+      nin = int( std::min( avail,
+                           std::min( space, _decim.max_input( noutput_items - produced ) ) ) );
+      if ( ! nin )
+        break;
+
+      convert_real( buf, in, nin );
+      nout = _decim.filter( nin, (gr_complex *)out + produced );
+    } else {
+      offset_binary_to_sc8( buf, (int8_t *)out + produced * 2, nout * 2 );
+    }
+
+    _stream.consume( nin );
+    produced += nout;
+  }
+
+  return produced;
 }
 
 int rtl_source_c::work( int noutput_items,
                         gr_vector_const_void_star &input_items,
                         gr_vector_void_star &output_items )
 {
-  gr_complex *out = (gr_complex *)output_items[0];
-
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
+  int produced = 0;
+
+  /* stopping and restarting the transfers here can't race with us */
+  switch ( _pause.poll() ) {
+  case stream_pause::PAUSE:
+    stop();
+    break;
+  case stream_pause::RESUME:
+    start();
+    _resume_time = osmosdr::time_spec_t::get_system_time();
+    break;
+  default:
+    break;
+  }
 
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
+  if ( _pause.paused() ) {
+    _pause.wait();
+    return 0;
   }
 
-  if (!_running)
+  if ( ! _stream.wait( _prefill ) )
     return WORK_DONE;
 
-  while (noutput_items && _buf_used) {
-    const int nout = std::min(noutput_items, _samp_avail);
-    const unsigned short *buf = _buf[_buf_head] + _buf_offset;
+  gr_complex *out = (gr_complex *)output_items[0];
 
-    for (int i = 0; i < nout; ++i)
-      *out++ = _lut[ *(buf + i) ];
+  if ( _real_rail >= 0 || _sc8 )
+    produced = read_native( output_items[0], noutput_items );
+  else if ( _decim.enabled() ) /* the full rate never hits our output */
+    produced = _stream.read( _decim, out, noutput_items, this, nitems_written( 0 ) );
+  else
+    produced = _stream.read( out, noutput_items, this, nitems_written( 0 ) );
+
+  if ( produced && _pause.resumed() ) {
+    BOOST_FOREACH( const gr::tag_t &tag,
+                   make_rx_tags( nitems_written(0), _resume_time,
+                                 get_sample_rate(), get_center_freq(), alias() ) )
+      add_item_tag( 0, tag );
+  }
 
-    noutput_items -= nout;
-    _samp_avail -= nout;
+  uint64_t tag_offset;
+  double tag_freq;
 
-    if (!_samp_avail) {
-      {
-        boost::mutex::scoped_lock lock( _buf_mutex );
+  if ( _stream.retune_tag( nitems_written( 0 ) + produced, tag_offset, tag_freq ) )
+    add_item_tag( 0, tag_offset, RX_FREQ_KEY, pmt::from_double( tag_freq ), alias_pmt() );
 
-        _buf_head = (_buf_head + 1) % _buf_num;
-        _buf_used--;
-      }
-      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
-      _buf_offset = 0;
-    } else {
-      _buf_offset += nout;
-    }
-  }
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
 
-  return (out - ((gr_complex *)output_items[0]));
+  return produced;
 }
 
 std::vector<std::string> rtl_source_c::get_devices()
@@ -414,6 +522,11 @@ size_t rtl_source_c::get_num_channels()
   return 1;
 }
 
+std::string rtl_source_c::get_device_id()
+{
+  return _device_id;
+}
+
 osmosdr::meta_range_t rtl_source_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
@@ -432,13 +545,13 @@ osmosdr::meta_range_t rtl_source_c::get_sample_rates()
 //  range += osmosdr::range_t( 3000000 ); // may work
 //  range += osmosdr::range_t( 3200000 ); // max rate
 
-  return range;
+  return _decim.rates( range );
 }
 
 double rtl_source_c::set_sample_rate(double rate)
 {
   if (_dev) {
-    rtlsdr_set_sample_rate( _dev, (uint32_t)rate );
+    rtlsdr_set_sample_rate( _dev, (uint32_t)(rate * _decim.decimation()) );
   }
 
   return get_sample_rate();
@@ -447,7 +560,7 @@ double rtl_source_c::set_sample_rate(double rate)
 double rtl_source_c::get_sample_rate()
 {
   if (_dev)
-    return (double)rtlsdr_get_sample_rate( _dev );
+    return (double)rtlsdr_get_sample_rate( _dev ) / _decim.decimation();
 
   return 0;
 }
@@ -488,14 +601,24 @@ osmosdr::freq_range_t rtl_source_c::get_freq_range( size_t chan )
 
 double rtl_source_c::set_center_freq( double freq, size_t chan )
 {
-  if (_dev)
+  if (_dev && _real_rail < 0)
     rtlsdr_set_center_freq( _dev, (uint32_t)freq );
 
   return get_center_freq( chan );
 }
 
+void rtl_source_c::tag_retune( double freq, uint64_t settle, size_t chan )
+{
+  /* counted at the full rate the transfers arrive with */
+  _stream.retuned( freq, settle * _decim.decimation() );
+}
+
 double rtl_source_c::get_center_freq( size_t chan )
 {
+  /* the real samples cover 0 to fs/2, which ends up centered after the shift */
+  if (_dev && _real_rail >= 0)
+    return get_sample_rate() / 2;
+
   if (_dev)
     return (double)rtlsdr_get_center_freq( _dev );
 
@@ -704,3 +827,15 @@ std::string rtl_source_c::get_antenna( size_t chan )
 {
   return "RX";
 }
+
+osmosdr::stream_stats_t rtl_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
+
+bool rtl_source_c::set_streaming( bool streaming )
+{
+  _pause.request( streaming ); /* carried out by work() */
+
+  return true;
+}
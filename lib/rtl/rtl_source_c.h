@@ -25,10 +25,15 @@
 #include <gnuradio/sync_block.h>
 
 #include <gnuradio/thread/thread.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
 
 #include "source_iface.h"
+#include "rx_stream.h"
+#include "stream_stats.h"
+#include "sample_convert.h"
+#include "fir_decimator.h"
+#include "latency_profile.h"
+#include "rx_thread.h"
+#include "stream_pause.h"
 
 class rtl_source_c;
 typedef struct rtlsdr_dev rtlsdr_dev_t;
@@ -85,6 +90,7 @@ public:
   static std::vector< std::string > get_devices();
 
   size_t get_num_channels( void );
+  std::string get_device_id( void );
 
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
@@ -92,6 +98,7 @@ public:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  void tag_retune( double freq, uint64_t settle, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -112,6 +119,9 @@ public:
   std::string set_antenna( const std::string & antenna, size_t chan = 0 );
   std::string get_antenna( size_t chan = 0 );
 
+  osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+  bool set_streaming( bool streaming );
+
 protected:
   bool start();
   bool stop();
@@ -121,27 +131,34 @@ private:
   void rtlsdr_callback(unsigned char *buf, uint32_t len);
   static void _rtlsdr_wait(rtl_source_c *obj);
   void rtlsdr_wait();
+  void convert_real(const unsigned char *buf, gr_complex *out, int nsamples);
+  int read_native(void *out, int noutput_items);
 
-  std::vector<gr_complex> _lut;
+  bool _sc8; /* deliver native 8 bit samples, see cpu_format */
+  fir_decimator _decim;
+  int _real_rail; /* direct_real, the rail carrying the ADC samples or -1 */
+  unsigned int _quarter; /* phase of the fs/4 shift of the real samples */
 
   rtlsdr_dev_t *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
+  rx_thread_params _rx_thread;
+  stream_stats _stats;
   unsigned int _buf_num;
   unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
+  latency_profile _latency;
+  buffer_pool_params _pool; /* placement of the ring buffers */
+  bool _buf_fixed; /* buffers or buflen given, don't size them by rate */
+  unsigned int _prefill; /* buffers queued before work() produces */
   bool _running;
-
-  unsigned int _buf_offset;
-  int _samp_avail;
+  stream_pause _pause;
+  osmosdr::time_spec_t _resume_time; /* of the first sample after resuming */
 
   bool _no_tuner;
   bool _auto_gain;
   double _if_gain;
-  unsigned int _skipped;
+  std::string _device_id; /* serial, tuner and direct sampling mode */
+
+  rx_stream< format_u8 > _stream;
 };
 
 #endif /* INCLUDED_RTLSDR_SOURCE_C_H */
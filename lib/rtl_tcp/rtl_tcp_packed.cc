@@ -0,0 +1,213 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cstring>
+#include <algorithm>
+
+#include "rtl_tcp_packed.h"
+
+static const unsigned char FRAME_MAGIC[4] = { 'P', 'K', 'I', 'Q' };
+
+static void put_be32( unsigned char *p, uint32_t v )
+{
+  p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static uint32_t get_be32( const unsigned char *p )
+{
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+/* covers the header fields following the magic, but the checksum itself */
+static uint16_t header_check( const unsigned char *hdr )
+{
+  uint16_t sum = 0x5a5a;
+
+  for (int i = 4; i < PACKED_FRAME_HEADER; i += 2)
+    if ( i != 6 )
+      sum = uint16_t( (sum << 1 | sum >> 15) ^ (hdr[i] << 8 | hdr[i + 1]) );
+
+  return sum;
+}
+
+static size_t payload_size( size_t count, int bits )
+{
+  return (count * bits + 7) / 8;
+}
+
+/*
+ * The largest gain (as a shift) the values leave room for, without going
+ * below the original 8 bit step when they are unpacked again.
+ */
+static int frame_gain( const unsigned char *src, size_t count, int bits )
+{
+  int peak = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    const int d = src[i] - 128;
+    peak = std::max( peak, d < 0 ? -d - 1 : d ); /* -128 fits like 127 */
+  }
+
+  int gain = 0;
+
+  while ( gain < 7 - bits && (peak << (gain + 1)) < 128 )
+    gain++;
+
+  return gain;
+}
+
+/*
+ * header: magic[4], bits, gain, check (be16), seq (be32), count (be32)
+ * payload: the values MSB first, each amplified by 2^gain around 128 and
+ * reduced to its top bits
+ */
+void pack_iq_frame( const unsigned char *src, size_t count, int bits,
+                    uint32_t seq, std::vector< unsigned char > &out )
+{
+  const size_t start = out.size();
+  const int gain = frame_gain( src, count, bits );
+
+  out.resize( start + PACKED_FRAME_HEADER + payload_size( count, bits ) );
+
+  unsigned char *hdr = &out[start];
+  memcpy( hdr, FRAME_MAGIC, 4 );
+  hdr[4] = bits;
+  hdr[5] = gain;
+  put_be32( hdr + 8, seq );
+  put_be32( hdr + 12, count );
+
+  const uint16_t check = header_check( hdr );
+  hdr[6] = check >> 8;
+  hdr[7] = check;
+
+  unsigned char *dst = hdr + PACKED_FRAME_HEADER;
+  const int shift = 8 - bits;
+  uint32_t acc = 0;
+  int nacc = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    const int value = (src[i] - 128) * (1 << gain) + 128;
+
+    acc = acc << bits | (value >> shift);
+    nacc += bits;
+
+    if ( nacc >= 8 ) {
+      nacc -= 8;
+      *dst++ = acc >> nacc;
+    }
+  }
+
+  if ( nacc )
+    *dst = acc << (8 - nacc);
+}
+
+static void unpack( const unsigned char *src, size_t count, int bits, int gain,
+                    std::vector< unsigned char > &out )
+{
+  const size_t start = out.size();
+  out.resize( start + count );
+
+  unsigned char *dst = &out[start];
+  const int shift = 8 - bits;
+  const unsigned char mask = (1 << bits) - 1;
+  const int half = (1 << shift) >> 1; /* middle of the step */
+  const int scale = 1 << gain;        /* divides the middle evenly */
+  uint32_t acc = 0;
+  int nacc = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    if ( nacc < bits ) {
+      acc = acc << 8 | *src++;
+      nacc += 8;
+    }
+
+    nacc -= bits;
+    const int value = int( (((acc >> nacc) & mask) << shift) | half ) - 128;
+    dst[i] = value / scale + 128;
+  }
+}
+
+packed_iq_decoder::packed_iq_decoder() :
+  _pos(0),
+  _synced(false),
+  _next_seq(0),
+  _gaps(0),
+  _resyncs(0)
+{
+}
+
+static bool valid_header( const unsigned char *hdr )
+{
+  return memcmp( hdr, FRAME_MAGIC, 4 ) == 0 &&
+         hdr[4] >= 1 && hdr[4] <= 8 && hdr[5] <= std::max( 7 - hdr[4], 0 ) &&
+         header_check( hdr ) == (hdr[6] << 8 | hdr[7]) &&
+         get_be32( hdr + 12 ) <= PACKED_FRAME_VALUES &&
+         get_be32( hdr + 12 ) % 2 == 0;
+}
+
+void packed_iq_decoder::feed( const unsigned char *data, size_t len,
+                              std::vector< unsigned char > &out )
+{
+  _buf.insert( _buf.end(), data, data + len );
+
+  while ( _buf.size() - _pos >= PACKED_FRAME_HEADER ) {
+    const unsigned char *hdr = &_buf[_pos];
+
+    if ( ! valid_header( hdr ) ) {
+      /* skip to the next candidate magic */
+      const unsigned char *next = (const unsigned char *)
+        memchr( hdr + 1, FRAME_MAGIC[0], _buf.size() - _pos - 1 );
+
+      _pos = next ? next - &_buf[0] : _buf.size();
+
+      if ( _synced )
+        _resyncs++;
+      _synced = false;
+      continue;
+    }
+
+    const int bits = hdr[4];
+    const int gain = hdr[5];
+    const uint32_t seq = get_be32( hdr + 8 );
+    const size_t count = get_be32( hdr + 12 );
+    const size_t size = PACKED_FRAME_HEADER + payload_size( count, bits );
+
+    if ( _buf.size() - _pos < size )
+      break; /* wait for the rest of the frame */
+
+    if ( _synced && seq != _next_seq )
+      _gaps++;
+
+    unpack( hdr + PACKED_FRAME_HEADER, count, bits, gain, out );
+
+    _synced = true;
+    _next_seq = seq + 1;
+    _pos += size;
+  }
+
+  /* keep the partial frame only */
+  _buf.erase( _buf.begin(), _buf.begin() + _pos );
+  _pos = 0;
+}
@@ -0,0 +1,93 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef RTL_TCP_PACKED_H
+#define RTL_TCP_PACKED_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+/*
+ * Extension of the rtl_tcp protocol carrying the I/Q values requantized
+ * to fewer bits, e.g. 4 bits halve the bandwidth needed.
+ *
+ * The client asks for it by sending RTL_TCP_CMD_PACKED with the number of
+ * bits per value right after connecting, before reading the dongle info.
+ * A server supporting it answers with the magic "RTLP" instead of "RTL0"
+ * and frames the samples as below. Plain rtl_tcp servers ignore unknown
+ * commands and send 8 bit samples as usual, plain clients never ask.
+ *
+ * Each frame starts with a header carrying a magic and a checksum, and
+ * holds whole I/Q pairs, so a receiver can find the next frame after
+ * garbage and stays aligned to I and Q. The sequence number increases by
+ * one per frame, and by one more wherever the server dropped samples.
+ *
+ * Before they are requantized, the values of a frame are amplified by the
+ * largest power of two their peak leaves room for, which the header
+ * carries for the receiver to undo. A weak signal thus keeps up to 7 bits
+ * of resolution instead of vanishing in the lowest steps. What is still
+ * lost is everything below the step at the gain of the frame: the quieter
+ * samples of a frame with a strong peak are rounded down to its coarse
+ * steps, and the gain stops at steps of two 8 bit values.
+ */
+
+#define RTL_TCP_CMD_PACKED 0x60 /* param: bits per I or Q value, 1 to 7 */
+
+#define PACKED_FRAME_HEADER 16
+#define PACKED_FRAME_VALUES (64 * 1024) /* I and Q values per frame, at most */
+
+/*!
+ * Pack the 8 bit offset binary values \p src into a frame appended to
+ * \p out, keeping the \p bits most significant bits of each after the
+ * gain of the frame.
+ * \param count the number of values, even
+ */
+void pack_iq_frame( const unsigned char *src, size_t count, int bits,
+                    uint32_t seq, std::vector< unsigned char > &out );
+
+/*!
+ * \brief Turns a stream of frames back into 8 bit offset binary values.
+ */
+class packed_iq_decoder
+{
+public:
+  packed_iq_decoder();
+
+  /*! Decode the frames completed by \p data, appending the values to \p out. */
+  void feed( const unsigned char *data, size_t len,
+             std::vector< unsigned char > &out );
+
+  /*! \return the discontinuities seen, dropped samples or lost frames */
+  uint64_t gaps() const { return _gaps; }
+
+  /*! \return the number of times garbage had to be skipped */
+  uint64_t resyncs() const { return _resyncs; }
+
+private:
+  std::vector< unsigned char > _buf; /* received, not decoded yet */
+  size_t _pos;
+  bool _synced;
+  uint32_t _next_seq;
+  uint64_t _gaps;
+  uint64_t _resyncs;
+};
+
+#endif // RTL_TCP_PACKED_H
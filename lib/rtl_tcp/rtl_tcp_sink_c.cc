@@ -0,0 +1,793 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "rtl_tcp_sink_c.h"
+#include "rtl_tcp_source_f.h" /* the protocol */
+#include "rtl_tcp_packed.h"
+#include "backend_registry.h"
+#include "arg_helpers.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 /* SO_NOSIGPIPE is set instead */
+#endif
+
+#define DEFAULT_PORT "1234"
+#define RING_SIZE    (16 * 1024 * 1024) /* about 3.5 seconds at 2.4 Msps */
+#define POLL_TIMEOUT 100                /* ms, to notice stop() */
+#define HELLO_WAIT   50                 /* ms a new client may take to ask for packing */
+#define HELLO_POLL   10                 /* ms, poll timeout while a client may still ask */
+
+rtl_tcp_sink_c_sptr make_rtl_tcp_sink_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr( new rtl_tcp_sink_c( args ) );
+}
+
+static sink_registrar rtl_tcp_registrar(
+  "tcp_server",
+  &make_backend< sink_iface, rtl_tcp_sink_c_sptr, &make_rtl_tcp_sink_c >,
+  &rtl_tcp_sink_c::get_devices,
+  BACKEND_NETWORK, BACKEND_ORDER_SOFTWARE + 30 );
+
+/* tuner type names and their number of gain steps the clients expect */
+static bool lookup_tuner( const std::string &name, uint32_t &type, uint32_t &gains )
+{
+  static const struct { const char *name; uint32_t type, gains; } tuners[] = {
+    { "e4000",  RTLSDR_TUNER_E4000,  14 },
+    { "fc0012", RTLSDR_TUNER_FC0012,  5 },
+    { "fc0013", RTLSDR_TUNER_FC0013, 23 },
+    { "fc2580", RTLSDR_TUNER_FC2580,  0 },
+    { "r820t",  RTLSDR_TUNER_R820T,  29 },
+    { "r828d",  RTLSDR_TUNER_R828D,  29 },
+  };
+
+  for (size_t i = 0; i < sizeof(tuners) / sizeof(tuners[0]); i++) {
+    if ( name == tuners[i].name ) {
+      type = tuners[i].type;
+      gains = tuners[i].gains;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static int make_listen_socket( const std::string &addr )
+{
+  std::string host, port = addr;
+
+  size_t colon = addr.rfind( ':' );
+  if ( colon != std::string::npos ) {
+    host = addr.substr( 0, colon );
+    port = addr.substr( colon + 1 );
+  }
+
+  if ( port.empty() )
+    port = DEFAULT_PORT;
+
+  struct addrinfo hints, *res = NULL;
+  memset( &hints, 0, sizeof(hints) );
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+  hints.ai_flags = AI_PASSIVE;
+
+  int ret = getaddrinfo( host.empty() ? NULL : host.c_str(), port.c_str(), &hints, &res );
+  if ( ret != 0 )
+    throw std::runtime_error( "rtl_tcp_sink_c: can't resolve " + addr + ": " +
+                              gai_strerror( ret ) );
+
+  int fd = socket( res->ai_family, res->ai_socktype, res->ai_protocol );
+
+  int opt_val = 1;
+  if ( fd >= 0 )
+    setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, (optval_t)&opt_val, sizeof(opt_val) );
+
+  if ( fd < 0 || bind( fd, res->ai_addr, res->ai_addrlen ) != 0 || listen( fd, 8 ) != 0 ) {
+    std::string err = strerror( errno );
+    if ( fd >= 0 )
+      ::close( fd );
+    freeaddrinfo( res );
+    throw std::runtime_error( "rtl_tcp_sink_c: can't listen on " + addr + ": " + err );
+  }
+
+  freeaddrinfo( res );
+
+  return fd;
+}
+
+rtl_tcp_sink_c::rtl_tcp_sink_c( const std::string &args ) :
+  gr::sync_block( "rtl_tcp_sink_c",
+                  gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+                  gr::io_signature::make( 0, 0, 0 ) ),
+  _listen_fd(-1),
+  _ring(NULL),
+  _ring_size(RING_SIZE),
+  _convert(128.0f),
+  _head(0),
+  _reserved(0),
+  _busy(false),
+  _busy_from(0),
+  _control(false),
+  _master_fd(-1),
+  _tuner_type(RTLSDR_TUNER_R820T),
+  _gain_count(29),
+  _freq(0),
+  _rate(0),
+  _corr(0),
+  _gain(0),
+  _gain_auto(true),
+  _running(false)
+{
+  dict_t dict = params_to_dict( args );
+
+  if ( dict.count( "ring_size" ) )
+    _ring_size = boost::lexical_cast< size_t >( dict["ring_size"] );
+
+  if ( dict.count( "control" ) )
+    _control = ("true" == dict["control"] ? true : false);
+
+  if ( dict.count( "tuner" ) && ! lookup_tuner( dict["tuner"], _tuner_type, _gain_count ) )
+    throw std::runtime_error( "rtl_tcp_sink_c: unknown tuner " + dict["tuner"] );
+
+  if ( dict.count( "freq" ) )
+    _freq = boost::lexical_cast< double >( dict["freq"] );
+
+  if ( dict.count( "rate" ) )
+    _rate = boost::lexical_cast< double >( dict["rate"] );
+
+  /* whole I/Q pairs */
+  _ring_size = std::max( _ring_size, size_t(64 * 1024) ) & ~size_t(1);
+
+  /* an eighth of the ring per work() at most, slow clients are skipped
+   * once they get within a quarter ring of being overwritten */
+  set_max_noutput_items( _ring_size / 16 );
+
+  message_port_register_out( SINK_COMMAND_PORT );
+
+  _listen_fd = make_listen_socket( dict["tcp_server"] );
+
+  if ( pipe( _wake ) != 0 ) {
+    ::close( _listen_fd );
+    throw std::runtime_error( "rtl_tcp_sink_c: can't create the wakeup pipe" );
+  }
+
+  fcntl( _wake[0], F_SETFL, O_NONBLOCK );
+  fcntl( _wake[1], F_SETFL, O_NONBLOCK );
+
+  _ring = new unsigned char[ _ring_size ];
+}
+
+rtl_tcp_sink_c::~rtl_tcp_sink_c()
+{
+  stop();
+
+  ::close( _listen_fd );
+  ::close( _wake[0] );
+  ::close( _wake[1] );
+
+  delete[] _ring;
+}
+
+bool rtl_tcp_sink_c::start()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( _running )
+    return true;
+
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &rtl_tcp_sink_c::server_task, this ) );
+
+  return true;
+}
+
+bool rtl_tcp_sink_c::stop()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( ! _running )
+      return true;
+
+    _running = false;
+    _cond.notify_all();
+  }
+
+  _thread.join();
+
+  return true;
+}
+
+int rtl_tcp_sink_c::work( int noutput_items,
+                          gr_vector_const_void_star &input_items,
+                          gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  const size_t nbytes = noutput_items * 2;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    _reserved = _head + nbytes;
+
+    /* a send still reading the part we're about to overwrite takes a
+     * single non-blocking syscall, the client is skipped afterwards */
+    while ( _busy && _reserved > _busy_from + _ring_size )
+      _cond.wait( lock );
+  }
+
+  /* only work() moves the head, it's safe to read without the lock */
+  size_t done = 0;
+
+  while ( done < nbytes ) {
+    const size_t offset = (_head + done) % _ring_size;
+    const size_t n = std::min( nbytes - done, _ring_size - offset );
+
+    /* two's complement to offset binary is the same bit flip */
+    _convert( in + done / 2, (int8_t *) _ring + offset, n / 2 );
+    offset_binary_to_sc8( _ring + offset, _ring + offset, n );
+
+    done += n;
+  }
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    _head += nbytes;
+  }
+
+  char c = 0;
+  if ( write( _wake[1], &c, 1 ) < 0 ) {
+    /* the pipe is full, the server thread is awake anyway */
+  }
+
+  return noutput_items;
+}
+
+void rtl_tcp_sink_c::server_task()
+{
+  std::vector< struct pollfd > fds;
+
+  while ( true ) {
+    uint64_t head;
+    {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      if ( ! _running )
+        break;
+
+      head = _head;
+    }
+
+    fds.resize( 2 + _clients.size() );
+    int timeout = POLL_TIMEOUT;
+
+    fds[0].fd = _listen_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = _wake[0];
+    fds[1].events = POLLIN;
+
+    for (size_t i = 0; i < _clients.size(); i++) {
+      const client_t &c = _clients[i];
+      const bool pending = c.pos < head || c.frame_sent < c.frame.size();
+
+      fds[2 + i].fd = c.fd;
+      fds[2 + i].events = POLLIN | (c.greeted && pending ? POLLOUT : 0);
+
+      if ( ! c.greeted )
+        timeout = HELLO_POLL;
+    }
+
+    int ret = poll( &fds[0], fds.size(), timeout );
+    if ( ret < 0 ) {
+      if ( EINTR == errno )
+        continue;
+      perror( "rtl_tcp_sink_c: poll" );
+      break;
+    }
+
+    if ( fds[1].revents & POLLIN ) {
+      char buf[256];
+      while ( read( _wake[0], buf, sizeof(buf) ) > 0 ) {}
+    }
+
+    const gr::high_res_timer_type now = gr::high_res_timer_now();
+
+    /* backwards, so erasing leaves the indices into fds to come intact */
+    for (size_t i = _clients.size(); i-- > 0; ) {
+      client_t &c = _clients[i];
+      const short revents = fds[2 + i].revents;
+      bool ok = true;
+
+      if ( revents & (POLLERR | POLLHUP | POLLNVAL) )
+        ok = read_commands( c ); /* picks up the reason, if any */
+      else if ( revents & POLLIN )
+        ok = read_commands( c );
+
+      /* a plain rtl_tcp client waits for the dongle info silently */
+      if ( ok && ! c.greeted && now >= c.hello_deadline )
+        ok = greet_client( c, 8 );
+
+      if ( ok && (revents & POLLOUT) )
+        ok = (c.bits < 8) ? send_packed( c ) : send_client( c );
+
+      if ( ok )
+        continue;
+
+      std::cerr << "rtl_tcp_sink_c: " << c.peer << " disconnected";
+      if ( c.dropped )
+        std::cerr << ", " << c.dropped << " bytes dropped in total";
+      std::cerr << std::endl;
+
+      if ( c.fd == _master_fd )
+        _master_fd = -1;
+
+      ::close( c.fd );
+      _clients.erase( _clients.begin() + i );
+    }
+
+    /* the longest connected client takes over control */
+    if ( _control && _master_fd < 0 && ! _clients.empty() ) {
+      _master_fd = _clients.front().fd;
+      std::cerr << "rtl_tcp_sink_c: " << _clients.front().peer
+                << " is in control now" << std::endl;
+    }
+
+    if ( fds[0].revents & POLLIN )
+      accept_client();
+  }
+
+  close_clients();
+}
+
+void rtl_tcp_sink_c::accept_client()
+{
+  struct sockaddr_storage addr;
+  socklen_t addrlen = sizeof(addr);
+
+  int fd = accept( _listen_fd, (struct sockaddr *) &addr, &addrlen );
+  if ( fd < 0 )
+    return;
+
+  char host[NI_MAXHOST], port[NI_MAXSERV];
+  if ( getnameinfo( (struct sockaddr *) &addr, addrlen, host, sizeof(host),
+                    port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV ) != 0 )
+    strcpy( host, "?" ), strcpy( port, "?" );
+
+#ifdef SO_NOSIGPIPE
+  int opt_val = 1;
+  setsockopt( fd, SOL_SOCKET, SO_NOSIGPIPE, (optval_t)&opt_val, sizeof(opt_val) );
+#endif
+
+  /* the dongle info follows once it's clear whether to pack */
+  client_t c;
+  c.fd = fd;
+  c.peer = std::string( host ) + ":" + port;
+  c.pos = 0;
+  c.dropped = 0;
+  c.cmd_len = 0;
+  c.greeted = false;
+  c.hello_deadline = gr::high_res_timer_now() +
+                     HELLO_WAIT * gr::high_res_timer_tps() / 1000;
+  c.bits = 8;
+  c.seq = 0;
+  c.frame_sent = 0;
+
+  if ( _control && _master_fd < 0 )
+    _master_fd = fd;
+
+  std::cerr << "rtl_tcp_sink_c: " << c.peer << " connected"
+            << (fd == _master_fd ? ", in control" : "") << std::endl;
+
+  _clients.push_back( c );
+}
+
+bool rtl_tcp_sink_c::greet_client( client_t &c, int bits )
+{
+  dongle_info_t info;
+  memcpy( info.magic, bits < 8 ? "RTLP" : "RTL0", 4 );
+  info.tuner_type = htonl( _tuner_type );
+  info.tuner_gain_count = htonl( _gain_count );
+
+  if ( send( c.fd, (const char *) &info, sizeof(info), MSG_NOSIGNAL ) != sizeof(info) )
+    return false;
+
+  c.greeted = true;
+  c.bits = bits;
+
+  if ( bits < 8 )
+    std::cerr << "rtl_tcp_sink_c: sending " << bits << " bit samples to "
+              << c.peer << std::endl;
+
+  boost::mutex::scoped_lock lock( _mutex );
+  c.pos = _head; /* starts with the latest samples */
+
+  return true;
+}
+
+/* to be called with _mutex held */
+void rtl_tcp_sink_c::catch_up( client_t &c )
+{
+  /* skip ahead before work() gets within a quarter ring of the client */
+  if ( c.pos + _ring_size < _reserved + _ring_size / 4 ) {
+    if ( ! c.dropped )
+      std::cerr << "rtl_tcp_sink_c: " << c.peer
+                << " is too slow, dropping samples" << std::endl;
+    c.dropped += _head - c.pos;
+    c.pos = _head;
+    c.seq++; /* lets a packing client notice the gap */
+  }
+}
+
+bool rtl_tcp_sink_c::send_client( client_t &c )
+{
+  uint64_t head;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    catch_up( c );
+    head = _head;
+
+    if ( c.pos >= head )
+      return true;
+
+    _busy = true;
+    _busy_from = c.pos;
+  }
+
+  /* send the ring in place, in two parts around the wrap point */
+  const size_t offset = c.pos % _ring_size;
+  const size_t len = head - c.pos;
+
+  struct iovec iov[2];
+  iov[0].iov_base = _ring + offset;
+  iov[0].iov_len = std::min( len, _ring_size - offset );
+  iov[1].iov_base = _ring;
+  iov[1].iov_len = len - iov[0].iov_len;
+
+  struct msghdr msg;
+  memset( &msg, 0, sizeof(msg) );
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iov[1].iov_len ? 2 : 1;
+
+  ssize_t sent = sendmsg( c.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL );
+  int err = errno;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    _busy = false;
+    _cond.notify_all();
+  }
+
+  if ( sent < 0 )
+    return EAGAIN == err || EWOULDBLOCK == err || EINTR == err;
+
+  c.pos += sent;
+
+  return true;
+}
+
+bool rtl_tcp_sink_c::send_packed( client_t &c )
+{
+  while ( true ) {
+    if ( c.frame_sent == c.frame.size() ) {
+      uint64_t head;
+
+      {
+        boost::mutex::scoped_lock lock( _mutex );
+
+        catch_up( c );
+        head = _head;
+
+        if ( c.pos >= head )
+          return true;
+
+        _busy = true;
+        _busy_from = c.pos;
+      }
+
+      /* a frame never spans the wrap point, both are whole I/Q pairs */
+      const size_t offset = c.pos % _ring_size;
+      const size_t len = std::min( size_t(head - c.pos),
+                                   std::min( _ring_size - offset,
+                                             size_t(PACKED_FRAME_VALUES) ) );
+
+      c.frame.clear();
+      pack_iq_frame( _ring + offset, len, c.bits, c.seq++, c.frame );
+      c.frame_sent = 0;
+
+      {
+        boost::mutex::scoped_lock lock( _mutex );
+
+        _busy = false;
+        _cond.notify_all();
+      }
+
+      c.pos += len;
+    }
+
+    ssize_t sent = send( c.fd, (const char *) &c.frame[c.frame_sent],
+                         c.frame.size() - c.frame_sent, MSG_DONTWAIT | MSG_NOSIGNAL );
+
+    if ( sent < 0 )
+      return EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno;
+
+    c.frame_sent += sent;
+
+    if ( c.frame_sent < c.frame.size() )
+      return true; /* the socket buffer is full */
+  }
+}
+
+bool rtl_tcp_sink_c::read_commands( client_t &c )
+{
+  unsigned char buf[256];
+
+  ssize_t received = recv( c.fd, (char *) buf, sizeof(buf), MSG_DONTWAIT );
+
+  if ( received == 0 )
+    return false;
+
+  if ( received < 0 )
+    return EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno;
+
+  for (ssize_t i = 0; i < received; i++) {
+    c.cmd[c.cmd_len++] = buf[i];
+
+    if ( c.cmd_len < sizeof(c.cmd) )
+      continue;
+
+    c.cmd_len = 0;
+
+    uint32_t param;
+    memcpy( &param, c.cmd + 1, sizeof(param) );
+    param = ntohl( param );
+
+    /* the first command of a new client may ask for packed samples */
+    if ( ! c.greeted ) {
+      const bool packed = (RTL_TCP_CMD_PACKED == c.cmd[0] && param >= 1 && param < 8);
+
+      if ( ! greet_client( c, packed ? param : 8 ) )
+        return false;
+
+      if ( packed )
+        continue;
+    }
+
+    /* only the client in control is listened to */
+    if ( c.fd == _master_fd )
+      handle_command( c.cmd[0], param );
+  }
+
+  return true;
+}
+
+void rtl_tcp_sink_c::handle_command( unsigned char cmd, uint32_t param )
+{
+  const char *key = NULL;
+  double value = 0;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    switch ( cmd ) {
+    case 0x01: /* set_freq */
+      key = "freq";
+      value = _freq = param;
+      break;
+    case 0x02: /* set_sample_rate */
+      key = "rate";
+      value = _rate = param;
+      break;
+    case 0x03: /* set_gain_mode, 1 is manual */
+      key = "gain_mode";
+      _gain_auto = (param == 0);
+      value = _gain_auto ? 1 : 0;
+      break;
+    case 0x04: /* set_gain, in tenths of a dB */
+      key = "gain";
+      value = _gain = int32_t( param ) / 10.0;
+      break;
+    case 0x05: /* set_freq_correction */
+      key = "ppm";
+      value = _corr = int32_t( param );
+      break;
+    default:   /* meaningless without a tuner */
+      return;
+    }
+  }
+
+  pmt::pmt_t command = pmt::make_dict();
+  command = pmt::dict_add( command, pmt::string_to_symbol( key ),
+                           pmt::from_double( value ) );
+
+  message_port_pub( SINK_COMMAND_PORT, command );
+}
+
+void rtl_tcp_sink_c::close_clients()
+{
+  for (size_t i = 0; i < _clients.size(); i++)
+    ::close( _clients[i].fd );
+
+  _clients.clear();
+  _master_fd = -1;
+}
+
+std::vector< std::string > rtl_tcp_sink_c::get_devices( bool fake )
+{
+  std::vector< std::string > devices;
+
+  if ( fake )
+    devices.push_back( "tcp_server=0.0.0.0:1234,control=false,label='rtl_tcp Server'" );
+
+  return devices;
+}
+
+size_t rtl_tcp_sink_c::get_num_channels( void )
+{
+  return 1;
+}
+
+osmosdr::meta_range_t rtl_tcp_sink_c::get_sample_rates( void )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* whatever the flowgraph delivers */
+  return osmosdr::meta_range_t( _rate, _rate );
+}
+
+double rtl_tcp_sink_c::set_sample_rate( double rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _rate = rate;
+}
+
+double rtl_tcp_sink_c::get_sample_rate( void )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _rate;
+}
+
+osmosdr::freq_range_t rtl_tcp_sink_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( 0, 0xffffffffu );
+}
+
+double rtl_tcp_sink_c::set_center_freq( double freq, size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _freq = freq;
+}
+
+double rtl_tcp_sink_c::get_center_freq( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _freq;
+}
+
+double rtl_tcp_sink_c::set_freq_corr( double ppm, size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _corr = ppm;
+}
+
+double rtl_tcp_sink_c::get_freq_corr( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _corr;
+}
+
+std::vector<std::string> rtl_tcp_sink_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >( 1, "LNA" );
+}
+
+osmosdr::gain_range_t rtl_tcp_sink_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t( 0, 50, 0.1 );
+}
+
+osmosdr::gain_range_t rtl_tcp_sink_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+bool rtl_tcp_sink_c::set_gain_mode( bool automatic, size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _gain_auto = automatic;
+}
+
+bool rtl_tcp_sink_c::get_gain_mode( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _gain_auto;
+}
+
+double rtl_tcp_sink_c::set_gain( double gain, size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _gain = gain;
+}
+
+double rtl_tcp_sink_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double rtl_tcp_sink_c::get_gain( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _gain;
+}
+
+double rtl_tcp_sink_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > rtl_tcp_sink_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, get_antenna( chan ) );
+}
+
+std::string rtl_tcp_sink_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string rtl_tcp_sink_c::get_antenna( size_t chan )
+{
+  return "TCP";
+}
@@ -0,0 +1,162 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef RTL_TCP_SINK_C_H
+#define RTL_TCP_SINK_C_H
+
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/thread/thread.h>
+
+#include "sink_iface.h"
+#include "sample_convert.h"
+
+class rtl_tcp_sink_c;
+
+typedef boost::shared_ptr< rtl_tcp_sink_c > rtl_tcp_sink_c_sptr;
+
+rtl_tcp_sink_c_sptr make_rtl_tcp_sink_c( const std::string &args = "" );
+
+/*!
+ * \brief Serves the samples to any number of rtl_tcp clients.
+ *
+ * The samples are quantized to the 8 bit offset binary I/Q pairs of an
+ * rtl-sdr once, into a ring shared by all clients, and each client is
+ * sent its part of the ring straight from there. A client falling so far
+ * behind that its data is about to be overwritten skips ahead to the
+ * latest samples, so a slow client never stalls the flowgraph or the
+ * other clients.
+ *
+ * With control=true the commands of the first client still connected
+ * are accepted, applied to the settings of the sink and published on
+ * the command message port, the commands of the other clients are
+ * ignored.
+ *
+ * Clients asking for packed samples (see rtl_tcp_packed.h) are sent
+ * frames with fewer bits per value instead, packed from the ring as they
+ * are sent.
+ */
+class rtl_tcp_sink_c :
+    public gr::sync_block,
+    public sink_iface
+{
+private:
+  friend rtl_tcp_sink_c_sptr make_rtl_tcp_sink_c( const std::string &args );
+
+  rtl_tcp_sink_c( const std::string &args );
+
+public:
+  ~rtl_tcp_sink_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  bool set_gain_mode( bool automatic, size_t chan = 0 );
+  bool get_gain_mode( size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+private:
+  struct client_t
+  {
+    int fd;
+    std::string peer;
+    uint64_t pos;         /* ring position of the next byte to send */
+    uint64_t dropped;     /* bytes skipped as the client was too slow */
+    unsigned char cmd[5]; /* partially received command */
+    size_t cmd_len;
+    bool greeted;         /* the dongle info has been sent */
+    gr::high_res_timer_type hello_deadline;
+    int bits;             /* per I or Q value, 8 unless packed */
+    uint32_t seq;         /* of the next packed frame */
+    std::vector< unsigned char > frame; /* packed, partially sent */
+    size_t frame_sent;
+  };
+
+  void server_task();
+  void accept_client();
+  bool greet_client( client_t &c, int bits );
+  void catch_up( client_t &c );
+  bool send_client( client_t &c );
+  bool send_packed( client_t &c );
+  bool read_commands( client_t &c );
+  void handle_command( unsigned char cmd, uint32_t param );
+  void close_clients();
+
+  int _listen_fd;
+  int _wake[2];           /* pipe waking the server thread up for new data */
+
+  unsigned char *_ring;
+  size_t _ring_size;
+  convert_to_8bit _convert;
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  uint64_t _head;         /* bytes written to the ring so far */
+  uint64_t _reserved;     /* end of the bytes being written */
+  bool _busy;             /* a send from the ring is in progress */
+  uint64_t _busy_from;    /* ring position it started from */
+
+  std::vector< client_t > _clients; /* of the server thread only */
+  bool _control;
+  int _master_fd;
+
+  uint32_t _tuner_type;
+  uint32_t _gain_count;
+
+  double _freq, _rate, _corr, _gain;
+  bool _gain_auto;
+
+  bool _running;
+  gr::thread::thread _thread;
+};
+
+#endif // RTL_TCP_SINK_C_H
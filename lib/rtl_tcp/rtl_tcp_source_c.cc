@@ -26,10 +26,9 @@
 #include <boost/algorithm/string.hpp>
 
 #include <gnuradio/io_signature.h>
-#include <gnuradio/blocks/deinterleave.h>
-#include <gnuradio/blocks/float_to_complex.h>
 
 #include "rtl_tcp_source_c.h"
+#include "backend_registry.h"
 
 #include "arg_helpers.h"
 
@@ -58,6 +57,12 @@ rtl_tcp_source_c_sptr make_rtl_tcp_source_c(const std::string &args)
   return gnuradio::get_initial_sptr(new rtl_tcp_source_c(args));
 }
 
+static source_registrar rtl_tcp_registrar(
+  "rtl_tcp",
+  &make_backend< source_iface, rtl_tcp_source_c_sptr, &make_rtl_tcp_source_c >,
+  &rtl_tcp_source_c::get_devices,
+  BACKEND_NETWORK, BACKEND_ORDER_SOFTWARE );
+
 rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   gr::hier_block2("rtl_tcp_source_c",
                  gr::io_signature::make(0, 0, 0),
@@ -69,6 +74,9 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   std::string host = "127.0.0.1";
   unsigned short port = 1234;
   int payload_size = 16384;
+  size_t prebuffer = 0;
+  int bits = 8;
+  bool reconnect = false;
   unsigned int direct_samp = 0, offset_tune = 0;
 
   _freq = 0;
@@ -92,6 +100,18 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   if (dict.count("psize"))
     payload_size = boost::lexical_cast< int >( dict["psize"] );
 
+  /* number of samples to buffer before starting or after running dry */
+  if (dict.count("prebuffer"))
+    prebuffer = boost::lexical_cast< size_t >( dict["prebuffer"] );
+
+  /* fewer bits per I or Q value, if the server supports packing them */
+  if (dict.count("bits"))
+    bits = boost::lexical_cast< int >( dict["bits"] );
+
+  /* reopen a lost connection instead of ending the stream */
+  if (dict.count("reconnect"))
+    reconnect = ("true" == dict["reconnect"] ? true : false);
+
   if (dict.count("direct_samp"))
     direct_samp = boost::lexical_cast< unsigned int >( dict["direct_samp"] );
 
@@ -107,7 +127,9 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   if (payload_size <= 0)
     payload_size = 16384;
 
-  _src = make_rtl_tcp_source_f(sizeof(float), host.c_str(), port, payload_size);
+  _src = make_rtl_tcp_source_f(sizeof(gr_complex), host.c_str(), port, payload_size,
+                               false, false, prebuffer * 2 /* bytes per sample */,
+                               bits, reconnect);
 
   if ( _src->get_tuner_type() != RTLSDR_TUNER_UNKNOWN )
   {
@@ -128,18 +150,8 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
 
   _src->set_offset_tuning(offset_tune);
 
-  /* rtl tcp source provides a stream of interleaved IQ floats */
-  gr::blocks::deinterleave::sptr deinterleave = \
-      gr::blocks::deinterleave::make( sizeof(float) );
-
-  /* block to convert deinterleaved floats to a complex stream */
-  gr::blocks::float_to_complex::sptr f2c = \
-      gr::blocks::float_to_complex::make( 1 );
-
-  connect(_src, 0, deinterleave, 0);
-  connect(deinterleave, 0, f2c, 0); /* I */
-  connect(deinterleave, 1, f2c, 1); /* Q */
-  connect(f2c, 0, self(), 0);
+  /* rtl tcp source converts the IQ pairs straight into complex samples */
+  connect(_src, 0, self(), 0);
 }
 
 rtl_tcp_source_c::~rtl_tcp_source_c()
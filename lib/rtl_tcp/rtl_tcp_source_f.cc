@@ -28,24 +28,36 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+#include "stream_tags.h"
+
 #ifndef _WIN32
 #include <netinet/in.h>
 #else
 #include <WinSock2.h>
 #endif
 
-/* copied from rtl sdr code */
-typedef struct { /* structure size must be multiple of 2 bytes */
-  char magic[4];
-  uint32_t tuner_type;
-  uint32_t tuner_gain_count;
-} dongle_info_t;
-
 #define USE_SELECT    1  // non-blocking receive on all platforms
 #define USE_RCV_TIMEO 0  // non-blocking receive on all but Cygwin
 #define SRC_VERBOSE 0
 #define SNK_VERBOSE 0
 
+#define READ_SIZE (64 * 1024)        // minimum bytes requested per recv() call
+#define FIFO_SIZE (16 * 1024 * 1024) // about 3.5 seconds at 2.4 Msps
+
+#define RECONNECT_MIN_MS 100  // first retry, doubled up to RECONNECT_MAX_MS
+#define RECONNECT_MAX_MS 1000
+
+// a lost connection must not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
 static int is_error( int perr )
 {
   // Compare error to posix error code; return nonzero if match.
@@ -87,18 +99,31 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
                                    unsigned short port,
                                    int payload_size,
                                    bool eof,
-                                   bool wait)
+                                   bool wait,
+                                   size_t prebuffer,
+                                   int bits,
+                                   bool reconnect)
   : gr::sync_block ("rtl_tcp_source_f",
                    gr::io_signature::make(0, 0, 0),
-                   gr::io_signature::make(1, 1, sizeof(float))),
+                   gr::io_signature::make(1, 1, itemsize)),
     d_itemsize(itemsize),
     d_payload_size(payload_size),
     d_eof(eof),
     d_wait(wait),
     d_socket(-1),
-    d_temp_offset(0)
+    d_read_size(std::max(size_t(READ_SIZE), size_t(payload_size))),
+    d_prebuffer(prebuffer),
+    d_prebuffering(false),
+    d_fifo(NULL),
+    d_convert(false, 127.4f, 1.0f/128.0f),
+    d_bits(std::min(std::max(bits, 1), 8)),
+    d_packed(false),
+    d_host(host),
+    d_port(port),
+    d_reconnect(reconnect),
+    d_written(0),
+    d_read(0)
 {
-  int ret = 0;
 #if defined(USING_WINSOCK) // for Windows (with MinGW)
   // initialize winsock DLL
   WSADATA wsaData;
@@ -108,6 +133,25 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
   }
 #endif
 
+  connect_server(d_socket, true);
+
+  if ( d_itemsize != sizeof(float) && d_itemsize != sizeof(gr_complex) )
+    throw std::runtime_error("rtl_tcp_source_f: unsupported item size");
+
+  // leave room for the reader thread while buffering the requested amount,
+  // the even size keeps I/Q pairs from being split at the wrap point
+  size_t fifo_size = std::max(size_t(FIFO_SIZE), d_prebuffer + 2 * d_read_size);
+  d_fifo = new sample_fifo<unsigned char>( fifo_size & ~size_t(1) );
+}
+
+/*
+ * Open a connection to the server into sock and read the dongle info. The
+ * constructor waits until the server accepts it, a reconnect tries once.
+ */
+bool rtl_tcp_source_f::connect_server(int &sock, bool wait)
+{
+  int ret = 0;
+
   // Set up the address stucture for the source address and port numbers
   // Get the source IP address from the host name
   struct addrinfo *ip_src;      // store the source IP address to use
@@ -118,30 +162,24 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
   hints.ai_protocol = IPPROTO_TCP;
   hints.ai_flags = AI_PASSIVE;
   char port_str[12];
-  sprintf( port_str, "%d", port );
+  sprintf( port_str, "%d", d_port );
 
   // FIXME leaks if report_error throws below
-  ret = getaddrinfo( host, port_str, &hints, &ip_src );
+  ret = getaddrinfo( d_host.c_str(), port_str, &hints, &ip_src );
   if( ret != 0 )
     report_error("rtl_tcp_source_f/getaddrinfo",
                  "can't initialize source socket" );
 
-  // FIXME leaks if report_error throws below
-  d_temp_buff = new unsigned char[d_payload_size];   // allow it to hold up to payload_size bytes
-  d_LUT= new float[0xff+1];
-  for(int i=0; i <=(0xff);++i){
-    d_LUT[i] = (((float)(i&0xff))-127.4f)*(1.0f/128.0f);
-  }
   // create socket
-  d_socket = socket(ip_src->ai_family, ip_src->ai_socktype,
-                    ip_src->ai_protocol);
-  if(d_socket == -1) {
+  sock = socket(ip_src->ai_family, ip_src->ai_socktype,
+                ip_src->ai_protocol);
+  if(sock == -1) {
     report_error("socket open","can't open socket");
   }
 
   // Turn on reuse address
   int opt_val = 1;
-  if(setsockopt(d_socket, SOL_SOCKET, SO_REUSEADDR, (optval_t)&opt_val, sizeof(int)) == -1) {
+  if(setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (optval_t)&opt_val, sizeof(int)) == -1) {
     report_error("SO_REUSEADDR","can't set socket option SO_REUSEADDR");
   }
 
@@ -149,7 +187,7 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
   linger lngr;
   lngr.l_onoff  = 1;
   lngr.l_linger = 0;
-  if(setsockopt(d_socket, SOL_SOCKET, SO_LINGER, (optval_t)&lngr, sizeof(linger)) == -1) {
+  if(setsockopt(sock, SOL_SOCKET, SO_LINGER, (optval_t)&lngr, sizeof(linger)) == -1) {
     if( !is_error(ENOPROTOOPT) ) {  // no SO_LINGER for SOCK_DGRAM on Windows
       report_error("SO_LINGER","can't set socket option SO_LINGER");
     }
@@ -166,33 +204,74 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
   timeout.tv_sec = 1;
   timeout.tv_usec = 0;
 #endif
-  if(setsockopt(d_socket, SOL_SOCKET, SO_RCVTIMEO, (optval_t)&timeout, sizeof(timeout)) == -1) {
+  if(setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (optval_t)&timeout, sizeof(timeout)) == -1) {
     report_error("SO_RCVTIMEO","can't set socket option SO_RCVTIMEO");
   }
 #endif // USE_RCV_TIMEO
 
-  while(connect(d_socket, ip_src->ai_addr, ip_src->ai_addrlen) != 0);
+  int conn;
+  while((conn = connect(sock, ip_src->ai_addr, ip_src->ai_addrlen)) != 0 && wait);
   freeaddrinfo(ip_src);
 
+  if (conn != 0) {
+    close_socket(sock);
+    sock = -1;
+    return false;
+  }
+
   int flag = 1;
-  setsockopt(d_socket, IPPROTO_TCP, TCP_NODELAY, (char *)&flag,sizeof(flag));
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&flag,sizeof(flag));
+
+  // ask before the dongle info, plain servers ignore unknown commands
+  if ( d_bits < 8 ) {
+    struct command cmd = { RTL_TCP_CMD_PACKED, htonl(d_bits) };
+    send(sock, (const char*)&cmd, sizeof(cmd), SEND_FLAGS);
+  }
 
   dongle_info_t dongle_info;
-  ret = recv(d_socket, (char*)&dongle_info, sizeof(dongle_info), 0);
-  if (sizeof(dongle_info) != ret)
+  ret = recv(sock, (char*)&dongle_info, sizeof(dongle_info), 0);
+  if (sizeof(dongle_info) != ret) {
     fprintf(stderr,"failed to read dongle info\n");
+    memset(&dongle_info, 0, sizeof(dongle_info));
+  }
 
   d_tuner_type = RTLSDR_TUNER_UNKNOWN;
   d_tuner_gain_count = 0;
   d_tuner_if_gain_count = 0;
 
-  if (memcmp(dongle_info.magic, "RTL0", 4) == 0)
+  d_packed = (memcmp(dongle_info.magic, "RTLP", 4) == 0);
+
+  if ( d_bits < 8 && !d_packed )
+    fprintf(stderr, "rtl_tcp_source_f: the server doesn't pack samples, "
+                    "receiving 8 bits\n");
+
+  if (memcmp(dongle_info.magic, "RTL0", 4) == 0 || d_packed)
   {
     d_tuner_type = ntohl(dongle_info.tuner_type);
     d_tuner_gain_count = ntohl(dongle_info.tuner_gain_count);
     if ( RTLSDR_TUNER_E4000 == d_tuner_type )
       d_tuner_if_gain_count = 53;
   }
+
+  // decoding a read must not take more than d_read_size from the fifo,
+  // plus the frame left over from the previous read
+  if ( d_packed )
+    d_recv_buf.resize( std::max(d_read_size * d_bits / 8, size_t(1)) );
+
+  return true;
+}
+
+void rtl_tcp_source_f::close_socket(int sock)
+{
+  if (sock == -1)
+    return;
+
+  shutdown(sock, SHUT_RDWR);
+#if defined(USING_WINSOCK)
+  closesocket(sock);
+#else
+  ::close(sock);
+#endif
 }
 
 rtl_tcp_source_f_sptr make_rtl_tcp_source_f (size_t itemsize,
@@ -200,7 +279,10 @@ rtl_tcp_source_f_sptr make_rtl_tcp_source_f (size_t itemsize,
                                              unsigned short port,
                                              int payload_size,
                                              bool eof,
-                                             bool wait)
+                                             bool wait,
+                                             size_t prebuffer,
+                                             int bits,
+                                             bool reconnect)
 {
   return gnuradio::get_initial_sptr(new rtl_tcp_source_f (
                                       itemsize,
@@ -208,22 +290,20 @@ rtl_tcp_source_f_sptr make_rtl_tcp_source_f (size_t itemsize,
                                       port,
                                       payload_size,
                                       eof,
-                                      wait));
+                                      wait,
+                                      prebuffer,
+                                      bits,
+                                      reconnect));
 }
 
 rtl_tcp_source_f::~rtl_tcp_source_f ()
 {
-  delete [] d_temp_buff;
+  stop();
 
-  if (d_socket != -1){
-    shutdown(d_socket, SHUT_RDWR);
-#if defined(USING_WINSOCK)
-    closesocket(d_socket);
-#else
-    ::close(d_socket);
-#endif
-    d_socket = -1;
-  }
+  delete d_fifo;
+
+  close_socket(d_socket);
+  d_socket = -1;
 
 #if defined(USING_WINSOCK) // for Windows (with MinGW)
   // free winsock resources
@@ -231,97 +311,328 @@ rtl_tcp_source_f::~rtl_tcp_source_f ()
 #endif
 }
 
+bool rtl_tcp_source_f::start()
+{
+  d_fifo->resume();
+  d_prebuffering = (d_prebuffer > 0);
+
+  d_written = d_read = 0;
+  d_gaps.clear();
+
+  d_thread = gr::thread::thread( boost::bind(&rtl_tcp_source_f::reader_task, this) );
+
+  return true;
+}
+
+bool rtl_tcp_source_f::stop()
+{
+  d_fifo->cancel();
+
+  d_thread.interrupt();
+  d_thread.join();
+
+  return true;
+}
+
+/*
+ * Receive the stream in large chunks straight into the fifo, so network
+ * jitter is absorbed by the fifo instead of stalling the flowgraph.
+ * A full fifo is not dropped but stops the reading, which pushes back on
+ * the server through tcp flow control and keeps the I/Q byte order intact.
+ */
+void rtl_tcp_source_f::reader_task()
+{
+  while ( d_fifo->wait_free( d_read_size ) ) {
+    boost::this_thread::interruption_point();
+
+#if USE_SELECT
+    // wait for data with a timeout, so the thread can be stopped
+    fd_set readfds;
+    timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 100000;
+    FD_ZERO(&readfds);
+    FD_SET(d_socket, &readfds);
+    int ret = select(d_socket + 1, &readfds, NULL, NULL, &timeout);
+    if ( ret < 0 ) {
+      if ( is_error(EINTR) )
+        continue;
+      report_error("rtl_tcp_source_f/select", NULL);
+      if ( d_reconnect && reconnect() )
+        continue;
+      break;
+    }
+    if ( ret == 0 ) // timeout
+      continue;
+#endif // USE_SELECT
+
+    // packed frames go through a buffer of their own to be decoded
+    size_t avail;
+    unsigned char *dst = d_packed ? &d_recv_buf[0] : d_fifo->write_ptr( avail );
+    size_t len = d_packed ? d_recv_buf.size() : std::min(avail, d_read_size);
+
+    ssize_t received = recv(d_socket, (char*)dst, len, 0);
+
+    if ( received == 0 ) {
+      fprintf(stderr, "rtl_tcp_source_f: server closed the connection\n");
+      if ( d_reconnect && reconnect() )
+        continue;
+      break;
+    }
+
+    if ( received < 0 ) {
+      if ( is_error(EAGAIN) || is_error(EINTR) )
+        continue;
+      report_error("rtl_tcp_source_f/recv", NULL);
+      if ( d_reconnect && reconnect() )
+        continue;
+      break;
+    }
+
+    if ( !d_packed ) {
+      d_fifo->write_commit( received );
+      d_written += received;
+    } else if ( !unpack( dst, received ) )
+      break;
+  }
+
+  d_fifo->cancel(); // let work() drain the fifo and finish
+}
+
+/*
+ * Frames hold whole I/Q pairs, so the byte order survives both samples
+ * dropped by the server and garbage skipped while resyncing.
+ */
+bool rtl_tcp_source_f::unpack(const unsigned char *data, size_t len)
+{
+  const uint64_t gaps = d_decoder.gaps();
+  const uint64_t resyncs = d_decoder.resyncs();
+
+  d_unpacked.clear();
+  d_decoder.feed( data, len, d_unpacked );
+
+  if ( d_decoder.gaps() > gaps )
+    fprintf(stderr, "rtl_tcp_source_f: samples lost, %llu gaps so far\n",
+            (unsigned long long) d_decoder.gaps());
+
+  if ( d_decoder.resyncs() > resyncs )
+    fprintf(stderr, "rtl_tcp_source_f: corrupt frame skipped\n");
+
+  if ( d_unpacked.empty() )
+    return true;
+
+  if ( !d_fifo->wait_free( d_unpacked.size() ) )
+    return false;
+
+  d_fifo->write( &d_unpacked[0], d_unpacked.size() );
+  d_written += d_unpacked.size();
+
+  return true;
+}
+
+/*
+ * Reconnect until the server is back, replaying the commands sent before.
+ * The first attempt is made right away, as a restarting server usually
+ * refuses connections for a moment only. Whatever the server sent in the
+ * meantime is lost, the first byte afterwards is tagged by work().
+ */
+bool rtl_tcp_source_f::reconnect()
+{
+  fprintf(stderr, "rtl_tcp_source_f: connection lost, reconnecting\n");
+
+  // complete a split I/Q pair, so the byte order survives
+  if ( d_written % 2 ) {
+    const unsigned char zero = 127;
+    if ( !d_fifo->wait_free( 1 ) )
+      return false;
+    d_fifo->write( &zero, 1 );
+    d_written++;
+  }
+
+  int delay = RECONNECT_MIN_MS;
+
+  while ( true ) {
+    boost::this_thread::interruption_point();
+
+    int sock = -1;
+    bool connected = false;
+
+    try {
+      connected = connect_server(sock, false);
+    } catch ( std::runtime_error & ) {
+      connected = false; // e.g. name resolution failing meanwhile
+    }
+
+    if ( connected ) {
+      boost::mutex::scoped_lock lock( d_socket_mutex );
+
+      close_socket(d_socket);
+      d_socket = sock;
+
+      for (size_t i = 0; i < d_commands.size(); i++)
+        send(d_socket, (const char*)&d_commands[i], sizeof(struct command), SEND_FLAGS);
+
+      break;
+    }
+
+    boost::this_thread::sleep( boost::posix_time::milliseconds( delay ) );
+    delay = std::min(2 * delay, RECONNECT_MAX_MS);
+  }
+
+  fprintf(stderr, "rtl_tcp_source_f: reconnected\n");
+
+  d_decoder = packed_iq_decoder();
+
+  boost::mutex::scoped_lock lock( d_gap_mutex );
+  d_gaps.push_back( d_written );
+
+  return true;
+}
+
 int rtl_tcp_source_f::work (int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items)
 {
-  float *out = (float *) output_items[0];
-  ssize_t r = 0;
-
-  int bytesleft = noutput_items;
-  int index = 0;
-  int receivedbytes = 0;
-  while(bytesleft > 0) {
-    receivedbytes = recv(d_socket, (char*)&d_temp_buff[index], bytesleft, 0);
-
-    if(receivedbytes == -1 && !is_error(EAGAIN)){
-      fprintf(stderr, "socket error\n");
-      return -1;
+  // gr_complex items take one I/Q byte pair, float items a single byte
+  const size_t bytes_per_item = d_itemsize / sizeof(float);
+  const size_t nbytes = noutput_items * bytes_per_item;
+
+  if ( d_prebuffer > 0 && d_fifo->size() == 0 )
+    d_prebuffering = true; // ran dry, refill before continuing
+
+  if ( d_prebuffering ) {
+    d_fifo->wait( d_prebuffer );
+    d_prebuffering = false;
+  }
+
+  d_fifo->wait( std::min(nbytes, d_read_size) );
+
+  size_t done = 0;
+
+  // drain what is available, in up to two segments around the wrap point
+  for (int seg = 0; seg < 2 && done < nbytes; seg++) {
+    size_t avail;
+    const unsigned char *src = d_fifo->read_ptr( avail );
+
+    size_t n = std::min( avail, nbytes - done );
+    n -= n % bytes_per_item; // whole items only
+    if ( n == 0 )
+      break;
+
+    if ( sizeof(gr_complex) == d_itemsize )
+      d_convert(src, (gr_complex *) output_items[0] + done / 2, n / 2);
+    else
+      d_convert(src, (float *) output_items[0] + done, n);
+
+    d_fifo->read_commit( n );
+
+    done += n;
+  }
+
+  if ( d_reconnect ) {
+    boost::mutex::scoped_lock lock( d_gap_mutex );
+
+    while ( !d_gaps.empty() && d_gaps.front() < d_read + done ) {
+      const uint64_t offset = nitems_written(0) +
+                              (d_gaps.front() - d_read) / bytes_per_item;
+
+      add_item_tag(0, offset, RX_RATE_KEY,
+                   pmt::from_double(last_param(0x02)), alias_pmt());
+      add_item_tag(0, offset, RX_FREQ_KEY,
+                   pmt::from_double(last_param(0x01)), alias_pmt());
+
+      d_gaps.pop_front();
     }
-    bytesleft -= receivedbytes;
-    index += receivedbytes;
   }
-  r = noutput_items;
 
-  for(int i=0; i<r; ++i)
-    out[i]=d_LUT[*(d_temp_buff+d_temp_offset+i)];
+  d_read += done;
 
-  return r;
+  if ( done == 0 && d_fifo->cancelled() )
+    return WORK_DONE;
+
+  return done / bytes_per_item;
 }
 
-#ifdef _WIN32
-#define __attribute__(x)
-#pragma pack(push, 1)
-#endif
-struct command{
-  unsigned char cmd;
-  unsigned int param;
-}__attribute__((packed));
-#ifdef _WIN32
-#pragma pack(pop)
-#endif
+/*
+ * Send a command, keeping the last one of each kind (and tuner stage) to be
+ * replayed after reconnecting.
+ */
+void rtl_tcp_source_f::send_command(unsigned char cmd, unsigned int param)
+{
+  boost::mutex::scoped_lock lock( d_socket_mutex );
+
+  struct command c = { cmd, htonl(param) };
+
+  size_t i = 0;
+  for (; i < d_commands.size(); i++) {
+    if ( d_commands[i].cmd != cmd )
+      continue;
+    if ( 0x06 == cmd && (ntohl(d_commands[i].param) >> 16) != (param >> 16) )
+      continue;
+    break;
+  }
+
+  if ( i < d_commands.size() )
+    d_commands[i] = c;
+  else
+    d_commands.push_back( c );
+
+  send(d_socket, (const char*)&c, sizeof(c), SEND_FLAGS);
+}
+
+unsigned int rtl_tcp_source_f::last_param(unsigned char cmd)
+{
+  boost::mutex::scoped_lock lock( d_socket_mutex );
+
+  for (size_t i = 0; i < d_commands.size(); i++)
+    if ( d_commands[i].cmd == cmd )
+      return ntohl(d_commands[i].param);
+
+  return 0;
+}
 
 void rtl_tcp_source_f::set_freq(int freq)
 {
-  struct command cmd = { 0x01, htonl(freq) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x01, freq);
 }
 
 void rtl_tcp_source_f::set_sample_rate(int sample_rate)
 {
-  struct command cmd = { 0x02, htonl(sample_rate) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x02, sample_rate);
 }
 
 void rtl_tcp_source_f::set_gain_mode(int manual)
 {
-  struct command cmd = { 0x03, htonl(manual) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x03, manual);
 }
 
 void rtl_tcp_source_f::set_gain(int gain)
 {
-  struct command cmd = { 0x04, htonl(gain) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x04, gain);
 }
 
 void rtl_tcp_source_f::set_freq_corr(int ppm)
 {
-  struct command cmd = { 0x05, htonl(ppm) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x05, ppm);
 }
 
 void rtl_tcp_source_f::set_if_gain(int stage, int gain)
 {
   uint32_t params = stage << 16 | (gain & 0xffff);
-  struct command cmd = { 0x06, htonl(params) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x06, params);
 }
 
 void rtl_tcp_source_f::set_agc_mode(int on)
 {
-  struct command cmd = { 0x08, htonl(on) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x08, on);
 }
 
 void rtl_tcp_source_f::set_direct_sampling(int on)
 {
-  struct command cmd = { 0x09, htonl(on) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x09, on);
 }
 
 void rtl_tcp_source_f::set_offset_tuning(int on)
 {
-  struct command cmd = { 0x0a, htonl(on) };
-  send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  send_command(0x0a, on);
 }
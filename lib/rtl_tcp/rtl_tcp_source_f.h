@@ -21,9 +21,18 @@
 #ifndef RTL_TCP_SOURCE_F_H
 #define RTL_TCP_SOURCE_F_H
 
+#include <deque>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
 #include <gnuradio/sync_block.h>
 #include <gnuradio/thread/thread.h>
 
+#include "sample_convert.h"
+#include "sample_fifo.h"
+#include "rtl_tcp_packed.h"
+
 #if defined(_WIN32)
 // if not posix, assume winsock
 #pragma comment(lib, "ws2_32.lib")
@@ -58,6 +67,26 @@ enum rtlsdr_tuner {
   RTLSDR_TUNER_R828D
 };
 
+/* copied from rtl sdr code */
+typedef struct { /* structure size must be multiple of 2 bytes */
+  char magic[4];
+  uint32_t tuner_type;
+  uint32_t tuner_gain_count;
+} dongle_info_t;
+
+/* the commands sent to the server, with the parameter in network byte order */
+#ifdef _WIN32
+#define __attribute__(x)
+#pragma pack(push, 1)
+#endif
+struct command{
+  unsigned char cmd;
+  unsigned int param;
+}__attribute__((packed));
+#ifdef _WIN32
+#pragma pack(pop)
+#endif
+
 class rtl_tcp_source_f;
 typedef boost::shared_ptr<rtl_tcp_source_f> rtl_tcp_source_f_sptr;
 
@@ -67,8 +96,24 @@ rtl_tcp_source_f_sptr make_rtl_tcp_source_f (
     unsigned short port,
     int payload_size,
     bool eof = false,
-    bool wait = false);
-
+    bool wait = false,
+    size_t prebuffer = 0,
+    int bits = 8,
+    bool reconnect = false);
+
+/*!
+ * Receives the 8 bit I/Q stream of a rtl_tcp server. Depending on
+ * \p itemsize it produces either interleaved I/Q floats (sizeof(float))
+ * or complex samples (sizeof(gr_complex)).
+ *
+ * With \p bits below 8 the server is asked for packed samples, see
+ * rtl_tcp_packed.h, servers not supporting them send 8 bits anyway.
+ *
+ * With \p reconnect a lost connection is reopened in the background,
+ * replaying the last tuning and gain commands, instead of ending the
+ * stream. The first sample received afterwards is tagged with rx_rate and
+ * rx_freq.
+ */
 class rtl_tcp_source_f : public gr::sync_block
 {
 private:
@@ -77,17 +122,45 @@ private:
   bool          d_eof;           // zero-length packet is EOF
   bool          d_wait;          // wait if data if not immediately available
   int           d_socket;        // handle to socket
-  unsigned char *d_temp_buff;    // hold buffer between calls
-  size_t        d_temp_offset;   // point to temp buffer location offset
-  float         *d_LUT;
+  size_t        d_read_size;     // bytes requested with each recv() call
+  size_t        d_prebuffer;     // bytes to buffer before producing output
+  bool          d_prebuffering;  // waiting for d_prebuffer bytes
+  sample_fifo<unsigned char> *d_fifo; // filled by the reader thread
+  gr::thread::thread d_thread;   // reader thread
+  convert_8bit  d_convert;
+  int           d_bits;          // requested bits per I or Q value
+  bool          d_packed;        // the server agreed to pack them
+  packed_iq_decoder d_decoder;
+  std::vector<unsigned char> d_recv_buf;  // packed frames as received
+  std::vector<unsigned char> d_unpacked;
 
   unsigned int d_tuner_type;
   unsigned int d_tuner_gain_count;
   unsigned int d_tuner_if_gain_count;
 
+  std::string   d_host;
+  unsigned short d_port;
+  bool          d_reconnect;     // reopen a lost connection
+  boost::mutex  d_socket_mutex;  // guards d_socket and d_commands
+  std::vector<struct command> d_commands; // last of each kind, to replay
+  uint64_t      d_written;       // bytes queued by the reader thread
+  uint64_t      d_read;          // bytes consumed by work()
+  boost::mutex  d_gap_mutex;
+  std::deque<uint64_t> d_gaps;   // first byte after each reconnect
+
 private:
   rtl_tcp_source_f(size_t itemsize, const char *host,
-                   unsigned short port, int payload_size, bool eof, bool wait);
+                   unsigned short port, int payload_size, bool eof, bool wait,
+                   size_t prebuffer, int bits, bool reconnect);
+
+  bool connect_server(int &sock, bool wait);
+  void close_socket(int sock);
+  bool reconnect();
+  void send_command(unsigned char cmd, unsigned int param);
+  unsigned int last_param(unsigned char cmd);
+
+  void reader_task();
+  bool unpack(const unsigned char *data, size_t len);
 
   // The friend declaration allows make_source_c to
   // access the private constructor.
@@ -97,11 +170,17 @@ private:
       unsigned short port,
       int payload_size,
       bool eof,
-      bool wait);
+      bool wait,
+      size_t prebuffer,
+      int bits,
+      bool reconnect);
 
 public:
   ~rtl_tcp_source_f();
 
+  bool start();
+  bool stop();
+
   enum rtlsdr_tuner get_tuner_type() { return (enum rtlsdr_tuner) d_tuner_type; }
   unsigned int get_tuner_gain_count() { return d_tuner_gain_count; }
   unsigned int get_tuner_if_gain_count() { return d_tuner_if_gain_count; }
@@ -0,0 +1,416 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_RX_STREAM_H
+#define OSMOSDR_RX_STREAM_H
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/block.h>
+
+#include "transfer_ring.h"
+#include "stream_stats.h"
+#include "sample_convert.h"
+#include "fir_decimator.h"
+#include "trace.h"
+
+/*
+ * Sample format policies of rx_stream, for the interleaved I/Q transfers
+ * of the usb sources. Each names the type of one I or Q value and the
+ * converter used for it, the kernel of which is picked for the running
+ * cpu when it is constructed.
+ */
+
+/* unsigned 8 bit, offset binary (rtl-sdr) */
+struct format_u8
+{
+  typedef unsigned char value_t;
+  typedef convert_8bit convert_t;
+
+  static convert_t converter( float offset, float scale )
+  {
+    return convert_8bit( false, offset, scale );
+  }
+};
+
+/* signed 8 bit (HackRF) */
+struct format_s8
+{
+  typedef unsigned char value_t;
+  typedef convert_8bit convert_t;
+
+  static convert_t converter( float offset, float scale )
+  {
+    return convert_8bit( true, offset, scale );
+  }
+};
+
+/* signed 16 bit little endian (OsmoSDR, Mirics), in host order */
+struct format_s16le
+{
+  typedef int16_t value_t;
+  typedef convert_16bit convert_t;
+
+  static convert_t converter( float offset, float scale )
+  {
+    return convert_16bit( scale );
+  }
+};
+
+/*!
+ * \brief The receive side shared by the usb sources with a callback API.
+ *
+ * push() is called with each transfer from the callback thread of the
+ * vendor library, counting one dropped on a full ring as an overflow.
+ * work() waits for the prefill with wait() and then either converts the
+ * queued samples with read(), across as many transfers as needed, or walks
+ * them itself with front() and consume() for special conversions. The
+ * fill level and the latency of each transfer are accounted for in the
+ * stream_stats of the block.
+ *
+ * Retunes are counted against the samples pushed, so the rx_freq tag of
+ * retuned() lands on the first sample the device delivered afterwards,
+ * however many transfers were still queued at the old frequency. The
+ * retune is handed to the consumer through a sequence counted slot, so
+ * neither push() nor consume() take a lock.
+ */
+template < typename format >
+class rx_stream : boost::noncopyable
+{
+public:
+  typedef typename format::value_t value_t;
+  typedef typename format::convert_t convert_t;
+
+  enum { BYTES_PER_SAMPLE = 2 * sizeof(value_t) };
+
+  /*!
+   * \param backend name used for tracing, a string literal
+   * \param offset, scale of the conversion, out = (in - offset) * scale
+   */
+  rx_stream( stream_stats &stats, const char *backend, float offset, float scale )
+    : _stats(stats), _backend(backend),
+      _convert(format::converter( offset, scale )),
+      _offset(0), _front_samples(0), _skip(0),
+      _front_out(0), _front_pos(0), _front_decim(1), _popped(0),
+      _retune_seen(0), _retune_pending(false), _pending_at(0), _pending_freq(0),
+      _tag_ready(false), _tag_offset(0), _tag_freq(0),
+      _pushed(0), _retune_seq(0), _retune_at(0), _retune_freq(0)
+  {
+  }
+
+  /*! Allocate \p num transfers of \p len bytes, see transfer_ring. */
+  void alloc( size_t num, size_t len,
+              const buffer_pool_params &params = buffer_pool_params() )
+  {
+    _ring.alloc( num, len, params );
+    reset_counters();
+  }
+
+  /*! Drop everything queued, before the transfers are started again. */
+  void reset()
+  {
+    _ring.reset();
+    reset_counters();
+  }
+
+  /*! Make wait() return false, once the transfers have ended. */
+  void cancel() { _ring.cancel(); }
+
+  /*! Drop the next \p transfers pushed, e.g. holding initial garbage. */
+  void skip( unsigned int transfers ) { _skip = transfers; }
+
+  const convert_t &convert() const { return _convert; }
+
+  size_t num() const { return _ring.num(); }
+  size_t len() const { return _ring.len(); }
+
+  /* producer side */
+
+  void push( const void *buf, size_t len )
+  {
+    if ( _skip ) {
+      _skip--;
+      return;
+    }
+
+    TRACE_ARRIVAL( _backend, len );
+
+    if ( _ring.push( buf, len ) ) {
+      _pushed.fetch_add( len / BYTES_PER_SAMPLE, boost::memory_order_relaxed );
+    } else {
+      _stats.overflow( len / BYTES_PER_SAMPLE );
+      std::cerr << "O" << std::flush;
+    }
+  }
+
+  /*!
+   * The device has been retuned to \p freq, tag the sample it delivers
+   * \p settle samples after the next transfer pushed.
+   */
+  void retuned( double freq, uint64_t settle )
+  {
+    boost::mutex::scoped_lock lock( _retune_mutex );
+
+    const uint32_t seq = _retune_seq.load( boost::memory_order_relaxed );
+
+    _retune_seq.store( seq + 1, boost::memory_order_relaxed );
+    boost::atomic_thread_fence( boost::memory_order_release );
+
+    _retune_at = _pushed.load( boost::memory_order_relaxed ) + settle;
+    _retune_freq = freq;
+
+    _retune_seq.store( seq + 2, boost::memory_order_release );
+  }
+
+  /* consumer side */
+
+  /*!
+   * Block until \p prefill transfers are queued.
+   * \return false if the transfers have ended
+   */
+  bool wait( size_t prefill )
+  {
+    if ( ! _ring.wait( prefill ) )
+      return false;
+
+    _stats.fill( _ring.used() * _ring.len() / BYTES_PER_SAMPLE,
+                 _ring.num() * _ring.len() / BYTES_PER_SAMPLE );
+
+    return true;
+  }
+
+  /*!
+   * The samples of the oldest transfer not consumed yet. Its latency is
+   * accounted for (and traced at output item \p offset of \p block) when
+   * the first of them is looked at.
+   * \param decim samples per output item from here on, for retune tags
+   * \return the number of samples at \p in, 0 if nothing is queued
+   */
+  size_t front( const value_t *&in, gr::block *block, uint64_t offset,
+                unsigned int decim = 1 )
+  {
+    size_t len;
+    const unsigned char *buf;
+
+    /* transfers too short to hold a sample are dropped */
+    while ( (buf = _ring.front( &len )) && len / BYTES_PER_SAMPLE <= _offset ) {
+      _ring.pop();
+      _popped += len / BYTES_PER_SAMPLE;
+      _offset = 0;
+    }
+
+    if ( ! buf )
+      return 0;
+
+    if ( 0 == _offset ) {
+      _stats.latency( _ring.front_stamp() );
+      TRACE_OUTPUT( block, _backend, offset, _ring.front_stamp() );
+    }
+
+    _front_samples = len / BYTES_PER_SAMPLE;
+
+    _front_out = offset;
+    _front_pos = _popped + _offset;
+    _front_decim = decim;
+
+    in = (const value_t *)buf + 2 * _offset;
+
+    return _front_samples - _offset;
+  }
+
+  /*! The samples of the front transfer consumed so far. */
+  size_t offset() const { return _offset; }
+
+  /*! Mark the first \p nsamples returned by front() as consumed. */
+  void consume( size_t nsamples )
+  {
+    note_retune( nsamples );
+
+    _offset += nsamples;
+
+    if ( _offset >= _front_samples ) {
+      _ring.pop();
+      _popped += _front_samples;
+      _offset = 0;
+    }
+  }
+
+  /*!
+   * The rx_freq tag of a retune whose first sample has been consumed, if
+   * it falls on an output item before \p end.
+   */
+  bool retune_tag( uint64_t end, uint64_t &offset, double &freq )
+  {
+    if ( ! _tag_ready || _tag_offset >= end )
+      return false;
+
+    offset = _tag_offset;
+    freq = _tag_freq;
+    _tag_ready = false;
+
+    return true;
+  }
+
+  /*!
+   * Convert up to \p nsamples queued samples into \p out, which becomes
+   * output item \p offset of \p block.
+   * \return the number of samples converted
+   */
+  int read( gr_complex *out, int nsamples, gr::block *block, uint64_t offset )
+  {
+    int produced = 0;
+    const value_t *in;
+    size_t avail;
+
+    while ( produced < nsamples &&
+            (avail = front( in, block, offset + produced )) ) {
+      const size_t n = std::min( avail, size_t(nsamples - produced) );
+
+      _convert( in, out + produced, n );
+      consume( n );
+
+      produced += n;
+    }
+
+    return produced;
+  }
+
+  /*!
+   * Convert the queued samples straight into \p decim, the full rate never
+   * hitting the output, until \p nsamples decimated samples are in \p out.
+   * \return the number of decimated samples
+   */
+  int read( fir_decimator &decim, gr_complex *out, int nsamples,
+            gr::block *block, uint64_t offset )
+  {
+    int produced = 0;
+    const value_t *in;
+    size_t avail;
+
+    while ( produced < nsamples &&
+            (avail = front( in, block, offset + produced, decim.decimation() )) ) {
+      size_t space;
+      gr_complex *dst = decim.input( space );
+      const size_t n = std::min( avail,
+                                 std::min( space, decim.max_input( nsamples - produced ) ) );
+
+      if ( ! n )
+        break;
+
+      _convert( in, dst, n );
+      consume( n );
+
+      produced += decim.filter( n, out + produced );
+    }
+
+    return produced;
+  }
+
+private:
+  void reset_counters()
+  {
+    boost::mutex::scoped_lock lock( _retune_mutex );
+
+    _offset = 0;
+    _popped = 0;
+    _pushed.store( 0, boost::memory_order_relaxed );
+    _retune_seen = _retune_seq.load( boost::memory_order_acquire );
+    _retune_pending = false;
+    _tag_ready = false;
+  }
+
+  /* pick up the last retune published by retuned(), if it is new */
+  void poll_retune()
+  {
+    const uint32_t seq = _retune_seq.load( boost::memory_order_acquire );
+
+    if ( seq == _retune_seen || (seq & 1) )
+      return;
+
+    const uint64_t at = _retune_at;
+    const double freq = _retune_freq;
+
+    /* a retune racing with us is picked up with the next samples consumed */
+    boost::atomic_thread_fence( boost::memory_order_acquire );
+    if ( _retune_seq.load( boost::memory_order_relaxed ) != seq )
+      return;
+
+    _retune_seen = seq;
+    _retune_pending = true;
+    _pending_at = at;
+    _pending_freq = freq;
+  }
+
+  /* the retune awaited takes effect within the next \p nsamples consumed */
+  void note_retune( size_t nsamples )
+  {
+    poll_retune();
+
+    const uint64_t pos = _popped + _offset;
+
+    if ( ! _retune_pending || _pending_at >= pos + nsamples )
+      return;
+
+    /* or before, if its sample was dropped */
+    const uint64_t at = std::max( _pending_at, pos );
+
+    _tag_offset = _front_out + (at - _front_pos) / _front_decim;
+    _tag_freq = _pending_freq;
+    _tag_ready = true;
+    _retune_pending = false;
+  }
+
+  stream_stats &_stats;
+  const char *_backend;
+  convert_t _convert;
+  transfer_ring _ring;
+
+  size_t _offset;        /* samples of the front transfer consumed */
+  size_t _front_samples; /* in the front transfer */
+  unsigned int _skip;
+
+  /* consumer side positions, in samples since alloc() or reset() */
+  uint64_t _front_out;      /* output item of the front() sample */
+  uint64_t _front_pos;      /* the front() sample */
+  unsigned int _front_decim;
+  uint64_t _popped;         /* samples of the transfers popped */
+
+  /* the retune awaited and the tag it became, consumer side */
+  uint32_t _retune_seen;    /* _retune_seq of the last retune picked up */
+  bool _retune_pending;
+  uint64_t _pending_at;
+  double _pending_freq;
+  bool _tag_ready;
+  uint64_t _tag_offset;
+  double _tag_freq;
+
+  /* producer side, _retune_mutex only serializes the callers of retuned() */
+  boost::mutex _retune_mutex;
+  boost::atomic< uint64_t > _pushed;   /* samples queued */
+  boost::atomic< uint32_t > _retune_seq; /* odd while the slot is written */
+  uint64_t _retune_at;      /* the first sample at the new frequency */
+  double _retune_freq;
+};
+
+#endif // OSMOSDR_RX_STREAM_H
@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <gnuradio/thread/thread.h>
+
+#include "rx_thread.h"
+
+rx_thread_params::rx_thread_params( const dict_t &dict )
+  : _prio(0), _applied(false)
+{
+  dict_t::const_iterator it;
+
+  if ( (it = dict.find( "rx_thread_cpu" )) != dict.end() ) {
+    BOOST_FOREACH( const std::string &cpu, split_args( it->second, ';' ) )
+      _cpus.push_back( boost::lexical_cast< int >( cpu ) );
+  }
+
+  if ( (it = dict.find( "rx_thread_prio" )) != dict.end() )
+    _prio = boost::lexical_cast< int >( it->second );
+
+  if ( _prio < 0 || _prio > 99 )
+    throw std::runtime_error( "rx_thread_prio has to be in the range 1..99." );
+}
+
+void rx_thread_params::apply() const
+{
+  if ( _cpus.size() )
+    gr::thread::thread_bind_to_processor( gr::thread::get_current_thread_id(), _cpus );
+
+  if ( ! _prio )
+    return;
+
+#ifndef _WIN32
+  struct sched_param param;
+
+  memset( &param, 0, sizeof(param) );
+  param.sched_priority = _prio;
+
+  int ret = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+  if ( ret )
+    std::cerr << "Failed to run the rx thread SCHED_FIFO at priority " << _prio
+              << ": " << strerror( ret ) << std::endl;
+#else
+  std::cerr << "rx_thread_prio is not supported on this platform." << std::endl;
+#endif
+}
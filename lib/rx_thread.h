@@ -0,0 +1,71 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_RX_THREAD_H
+#define OSMOSDR_RX_THREAD_H
+
+#include <vector>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+
+/*!
+ * \brief Scheduling of the thread reading from a device, given by the
+ * device arguments:
+ *
+ *   rx_thread_cpu=N[;M...]  pin the thread to these cpus
+ *   rx_thread_prio=1..99    run it SCHED_FIFO at this priority, which
+ *                           needs CAP_SYS_NICE or an RLIMIT_RTPRIO
+ *
+ * Backends with a reader thread of their own call apply() from it. The
+ * threads of vendor libraries delivering usb callbacks aren't reachable
+ * from outside, apply_once() is called from each callback instead.
+ */
+class OSMOSDR_API rx_thread_params
+{
+public:
+  rx_thread_params() : _prio(0), _applied(false) {}
+
+  explicit rx_thread_params( const dict_t &dict );
+
+  bool enabled() const { return _cpus.size() || _prio; }
+
+  /*! Set the affinity and priority of the calling thread. */
+  void apply() const;
+
+  /*! apply() unless done since rearm(), cheap enough for every callback. */
+  void apply_once()
+  {
+    if ( ! _applied ) {
+      _applied = true;
+      apply();
+    }
+  }
+
+  /*! Let apply_once() take effect again, on (re)starting the stream. */
+  void rearm() { _applied = false; }
+
+private:
+  std::vector< int > _cpus;
+  int _prio;
+  bool _applied;
+};
+
+#endif // OSMOSDR_RX_THREAD_H
@@ -0,0 +1,1247 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "sample_convert.h"
+
+#define CONVERT_ALIGNMENT 64
+
+/*
+ * Kernels for x86 are always built using function level target attributes,
+ * independent of the USE_SIMD setting, and are selected at runtime based on
+ * the features reported by the cpu. This allows a distribution package built
+ * for a generic x86 target to make use of AVX2 or AVX-512 where available.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONVERT_X86_DISPATCH
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CONVERT_NEON
+#include <arm_neon.h>
+#if defined(__aarch64__)
+#define CONVERT_NEON_ROUND /* vcvtnq_s32_f32() requires ARMv8 */
+#endif
+#endif
+
+/*
+ * OSMOSDR_SIMD=generic|sse2|ssse3|avx2|avx512 caps the kernels selected,
+ * to compare them on one machine or to rule them out when debugging. neon
+ * counts as sse2. Read at each construction, so benchmarks may change it.
+ */
+enum simd_level_t { SIMD_GENERIC, SIMD_SSE2, SIMD_SSSE3, SIMD_AVX2, SIMD_AVX512 };
+
+static int simd_limit()
+{
+  static const char *names[] = { "generic", "sse2", "ssse3", "avx2", "avx512" };
+
+  const char *env = getenv( "OSMOSDR_SIMD" );
+
+  for (int level = SIMD_GENERIC; env && level <= SIMD_AVX512; level++)
+    if ( strcmp( env, names[level] ) == 0 || (SIMD_SSE2 == level && strcmp( env, "neon" ) == 0) )
+      return level;
+
+  return SIMD_AVX512;
+}
+
+#ifdef CONVERT_X86_DISPATCH
+static bool cpu_has_sse2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2") && simd_limit() >= SIMD_SSE2;
+}
+
+static bool cpu_has_ssse3()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3") && simd_limit() >= SIMD_SSSE3;
+}
+
+static bool cpu_has_avx2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && simd_limit() >= SIMD_AVX2;
+}
+
+static bool cpu_has_avx512()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") && simd_limit() >= SIMD_AVX512;
+}
+#endif
+
+#ifdef CONVERT_NEON
+/* round to nearest, ties away from zero on ARMv7 lacking vcvtnq_s32_f32() */
+static inline int32x4_t neon_round( float32x4_t f )
+{
+#ifdef CONVERT_NEON_ROUND
+  return vcvtnq_s32_f32( f );
+#else
+  const uint32x4_t sign = vandq_u32( vreinterpretq_u32_f32( f ), vdupq_n_u32( 0x80000000 ) );
+  const float32x4_t half = vreinterpretq_f32_u32( vorrq_u32( vreinterpretq_u32_f32( vdupq_n_f32( 0.5f ) ), sign ) );
+
+  return vcvtq_s32_f32( vaddq_f32( f, half ) );
+#endif
+}
+#endif
+
+struct convert_8bit_kernels
+{
+#ifdef CONVERT_X86_DISPATCH
+  TARGET_SSE2
+  static void sse2( const unsigned char *in, float *out, size_t count,
+                    const convert_8bit *self )
+  {
+    const __m128i flip = _mm_set1_epi8( (char)self->_flip );
+    const __m128 scale = _mm_set1_ps( self->_scale );
+    const __m128 add = _mm_set1_ps( self->_add );
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      __m128i v = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)(in + i) ), flip );
+
+      /* sign extend 8 -> 16 -> 32 bit by unpacking into the upper half */
+      __m128i lo16 = _mm_srai_epi16( _mm_unpacklo_epi8( v, v ), 8 );
+      __m128i hi16 = _mm_srai_epi16( _mm_unpackhi_epi8( v, v ), 8 );
+
+      __m128i i0 = _mm_srai_epi32( _mm_unpacklo_epi16( lo16, lo16 ), 16 );
+      __m128i i1 = _mm_srai_epi32( _mm_unpackhi_epi16( lo16, lo16 ), 16 );
+      __m128i i2 = _mm_srai_epi32( _mm_unpacklo_epi16( hi16, hi16 ), 16 );
+      __m128i i3 = _mm_srai_epi32( _mm_unpackhi_epi16( hi16, hi16 ), 16 );
+
+      _mm_storeu_ps( out + i +  0, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( i0 ), scale ), add ) );
+      _mm_storeu_ps( out + i +  4, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( i1 ), scale ), add ) );
+      _mm_storeu_ps( out + i +  8, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( i2 ), scale ), add ) );
+      _mm_storeu_ps( out + i + 12, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( i3 ), scale ), add ) );
+    }
+
+    convert_8bit::generic( in + i, out + i, count - i, self );
+  }
+
+  TARGET_SSE2
+  static void sse2_rail( const unsigned char *in, float *out, size_t count,
+                         const convert_8bit *self )
+  {
+    const __m128i flip = _mm_set1_epi8( (char)self->_flip );
+    const __m128 scale = _mm_set1_ps( self->_scale );
+    const __m128 add = _mm_set1_ps( self->_add );
+
+    /* each load spans 8 pairs starting at the wanted rail, the last byte
+     * belongs to the following pair, so the final block is left to the
+     * generic loop to stay within the buffer */
+    size_t i = 0;
+    for (; i + 8 < count; i += 8) {
+      __m128i v = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)(in + 2 * i) ), flip );
+
+      /* sign extend the low byte of every 16 bit word, dropping the other rail */
+      __m128i v16 = _mm_srai_epi16( _mm_slli_epi16( v, 8 ), 8 );
+
+      __m128i i0 = _mm_srai_epi32( _mm_unpacklo_epi16( v16, v16 ), 16 );
+      __m128i i1 = _mm_srai_epi32( _mm_unpackhi_epi16( v16, v16 ), 16 );
+
+      _mm_storeu_ps( out + i + 0, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( i0 ), scale ), add ) );
+      _mm_storeu_ps( out + i + 4, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( i1 ), scale ), add ) );
+    }
+
+    convert_8bit::generic_rail( in + 2 * i, out + i, count - i, self );
+  }
+
+  TARGET_AVX2
+  static void avx2( const unsigned char *in, float *out, size_t count,
+                    const convert_8bit *self )
+  {
+    const __m128i flip = _mm_set1_epi8( (char)self->_flip );
+    const __m256 scale = _mm256_set1_ps( self->_scale );
+    const __m256 add = _mm256_set1_ps( self->_add );
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      __m128i v = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)(in + i) ), flip );
+
+      __m256i i0 = _mm256_cvtepi8_epi32( v );
+      __m256i i1 = _mm256_cvtepi8_epi32( _mm_srli_si128( v, 8 ) );
+
+      _mm256_storeu_ps( out + i + 0, _mm256_add_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( i0 ), scale ), add ) );
+      _mm256_storeu_ps( out + i + 8, _mm256_add_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( i1 ), scale ), add ) );
+    }
+
+    convert_8bit::generic( in + i, out + i, count - i, self );
+  }
+#endif
+
+#ifdef CONVERT_NEON
+  static void neon( const unsigned char *in, float *out, size_t count,
+                    const convert_8bit *self )
+  {
+    const uint8x16_t flip = vdupq_n_u8( self->_flip );
+    const float32x4_t add = vdupq_n_f32( self->_add );
+    const float scale = self->_scale;
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      int8x16_t v = vreinterpretq_s8_u8( veorq_u8( vld1q_u8( in + i ), flip ) );
+
+      int16x8_t lo16 = vmovl_s8( vget_low_s8( v ) );
+      int16x8_t hi16 = vmovl_s8( vget_high_s8( v ) );
+
+      vst1q_f32( out + i +  0, vmlaq_n_f32( add, vcvtq_f32_s32( vmovl_s16( vget_low_s16( lo16 ) ) ), scale ) );
+      vst1q_f32( out + i +  4, vmlaq_n_f32( add, vcvtq_f32_s32( vmovl_s16( vget_high_s16( lo16 ) ) ), scale ) );
+      vst1q_f32( out + i +  8, vmlaq_n_f32( add, vcvtq_f32_s32( vmovl_s16( vget_low_s16( hi16 ) ) ), scale ) );
+      vst1q_f32( out + i + 12, vmlaq_n_f32( add, vcvtq_f32_s32( vmovl_s16( vget_high_s16( hi16 ) ) ), scale ) );
+    }
+
+    convert_8bit::generic( in + i, out + i, count - i, self );
+  }
+
+  static void neon_rail( const unsigned char *in, float *out, size_t count,
+                         const convert_8bit *self )
+  {
+    const uint8x8_t flip = vdup_n_u8( self->_flip );
+    const float32x4_t add = vdupq_n_f32( self->_add );
+    const float scale = self->_scale;
+
+    /* as with sse2_rail the final block is left to the generic loop */
+    size_t i = 0;
+    for (; i + 8 < count; i += 8) {
+      /* the de-interleaving load puts the wanted rail into val[0] */
+      uint8x8x2_t pairs = vld2_u8( in + 2 * i );
+
+      int16x8_t v16 = vmovl_s8( vreinterpret_s8_u8( veor_u8( pairs.val[0], flip ) ) );
+
+      vst1q_f32( out + i + 0, vmlaq_n_f32( add, vcvtq_f32_s32( vmovl_s16( vget_low_s16( v16 ) ) ), scale ) );
+      vst1q_f32( out + i + 4, vmlaq_n_f32( add, vcvtq_f32_s32( vmovl_s16( vget_high_s16( v16 ) ) ), scale ) );
+    }
+
+    convert_8bit::generic_rail( in + 2 * i, out + i, count - i, self );
+  }
+#endif
+};
+
+convert_8bit::convert_8bit( bool is_signed, float offset, float scale )
+  : _kernel( generic ),
+    _rail_kernel( generic_rail ),
+    _name( "generic" ),
+    _flip( is_signed ? 0x00 : 0x80 ),
+    _scale( scale ),
+    _add( ((is_signed ? 0.0f : 128.0f) - offset) * scale )
+{
+  for (unsigned int i = 0; i <= 0xff; i++) {
+    float value = is_signed ? float(int8_t(i)) : float(i);
+    _lut[i] = (value - offset) * scale;
+  }
+
+#ifdef CONVERT_X86_DISPATCH
+  if ( cpu_has_avx2() ) {
+    _kernel = convert_8bit_kernels::avx2;
+    _name = "avx2";
+  } else if ( cpu_has_sse2() ) {
+    _kernel = convert_8bit_kernels::sse2;
+    _name = "sse2";
+  }
+
+  if ( cpu_has_sse2() ) /* avx2 wouldn't gain much on the strided input */
+    _rail_kernel = convert_8bit_kernels::sse2_rail;
+#elif defined(CONVERT_NEON)
+  if ( simd_limit() >= SIMD_SSE2 ) {
+    _kernel = convert_8bit_kernels::neon;
+    _rail_kernel = convert_8bit_kernels::neon_rail;
+    _name = "neon";
+  }
+#endif
+}
+
+void convert_8bit::generic( const unsigned char *in, float *out, size_t count,
+                            const convert_8bit *self )
+{
+  const float *lut = self->_lut;
+
+  for (size_t i = 0; i < count; i++)
+    out[i] = lut[ in[i] ];
+}
+
+void convert_8bit::generic_rail( const unsigned char *in, float *out, size_t count,
+                                 const convert_8bit *self )
+{
+  const float *lut = self->_lut;
+
+  for (size_t i = 0; i < count; i++)
+    out[i] = lut[ in[2 * i] ];
+}
+
+struct convert_16bit_kernels
+{
+#ifdef CONVERT_X86_DISPATCH
+  TARGET_SSE2
+  static void sse2( const int16_t *in, float *out, size_t count,
+                    const convert_16bit *self )
+  {
+    const __m128 scale = _mm_set1_ps( self->_scale );
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      __m128i v = _mm_loadu_si128( (const __m128i *)(in + i) );
+
+      /* sign extend 16 -> 32 bit by unpacking into the upper half */
+      __m128i lo = _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 );
+      __m128i hi = _mm_srai_epi32( _mm_unpackhi_epi16( v, v ), 16 );
+
+      _mm_storeu_ps( out + i + 0, _mm_mul_ps( _mm_cvtepi32_ps( lo ), scale ) );
+      _mm_storeu_ps( out + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( hi ), scale ) );
+    }
+
+    convert_16bit::generic( in + i, out + i, count - i, self );
+  }
+
+  TARGET_AVX2
+  static void avx2( const int16_t *in, float *out, size_t count,
+                    const convert_16bit *self )
+  {
+    const __m256 scale = _mm256_set1_ps( self->_scale );
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      __m256i i0 = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i *)(in + i + 0) ) );
+      __m256i i1 = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i *)(in + i + 8) ) );
+
+      _mm256_storeu_ps( out + i + 0, _mm256_mul_ps( _mm256_cvtepi32_ps( i0 ), scale ) );
+      _mm256_storeu_ps( out + i + 8, _mm256_mul_ps( _mm256_cvtepi32_ps( i1 ), scale ) );
+    }
+
+    convert_16bit::generic( in + i, out + i, count - i, self );
+  }
+
+  TARGET_SSE2
+  static void sse2( const float *in, int16_t *out, size_t count,
+                    const convert_to_16bit *self )
+  {
+    const __m128 scale = _mm_set1_ps( self->_scale );
+    const __m128 max = _mm_set1_ps( self->_limit );
+    const __m128 min = _mm_set1_ps( -self->_limit );
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      __m128 f0 = _mm_mul_ps( _mm_loadu_ps( in + i + 0 ), scale );
+      __m128 f1 = _mm_mul_ps( _mm_loadu_ps( in + i + 4 ), scale );
+
+      __m128i i0 = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( f0, min ), max ) );
+      __m128i i1 = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( f1, min ), max ) );
+
+      _mm_storeu_si128( (__m128i *)(out + i), _mm_packs_epi32( i0, i1 ) );
+    }
+
+    convert_to_16bit::generic( in + i, out + i, count - i, self );
+  }
+
+  TARGET_AVX2
+  static void avx2( const float *in, int16_t *out, size_t count,
+                    const convert_to_16bit *self )
+  {
+    const __m256 scale = _mm256_set1_ps( self->_scale );
+    const __m256 max = _mm256_set1_ps( self->_limit );
+    const __m256 min = _mm256_set1_ps( -self->_limit );
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      __m256 f0 = _mm256_mul_ps( _mm256_loadu_ps( in + i + 0 ), scale );
+      __m256 f1 = _mm256_mul_ps( _mm256_loadu_ps( in + i + 8 ), scale );
+
+      __m256i i0 = _mm256_cvtps_epi32( _mm256_min_ps( _mm256_max_ps( f0, min ), max ) );
+      __m256i i1 = _mm256_cvtps_epi32( _mm256_min_ps( _mm256_max_ps( f1, min ), max ) );
+
+      /* packs works within 128 bit lanes, restore the sample order */
+      __m256i v = _mm256_permute4x64_epi64( _mm256_packs_epi32( i0, i1 ), 0xd8 );
+
+      _mm256_storeu_si256( (__m256i *)(out + i), v );
+    }
+
+    convert_to_16bit::generic( in + i, out + i, count - i, self );
+  }
+
+  TARGET_AVX512
+  static void avx512( const float *in, int16_t *out, size_t count,
+                      const convert_to_16bit *self )
+  {
+    const __m512 scale = _mm512_set1_ps( self->_scale );
+    const __m512 max = _mm512_set1_ps( self->_limit );
+    const __m512 min = _mm512_set1_ps( -self->_limit );
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+      __m512 f0 = _mm512_mul_ps( _mm512_loadu_ps( in + i +  0 ), scale );
+      __m512 f1 = _mm512_mul_ps( _mm512_loadu_ps( in + i + 16 ), scale );
+
+      __m512i i0 = _mm512_cvtps_epi32( _mm512_min_ps( _mm512_max_ps( f0, min ), max ) );
+      __m512i i1 = _mm512_cvtps_epi32( _mm512_min_ps( _mm512_max_ps( f1, min ), max ) );
+
+      /* the saturating narrowing keeps the sample order, unlike packs */
+      _mm256_storeu_si256( (__m256i *)(out + i +  0), _mm512_cvtsepi32_epi16( i0 ) );
+      _mm256_storeu_si256( (__m256i *)(out + i + 16), _mm512_cvtsepi32_epi16( i1 ) );
+    }
+
+    convert_to_16bit::generic( in + i, out + i, count - i, self );
+  }
+#endif
+
+#ifdef CONVERT_NEON
+  static void neon( const int16_t *in, float *out, size_t count,
+                    const convert_16bit *self )
+  {
+    const float scale = self->_scale;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      int16x8_t v = vld1q_s16( in + i );
+
+      vst1q_f32( out + i + 0, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_low_s16( v ) ) ), scale ) );
+      vst1q_f32( out + i + 4, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_high_s16( v ) ) ), scale ) );
+    }
+
+    convert_16bit::generic( in + i, out + i, count - i, self );
+  }
+#endif
+
+#ifdef CONVERT_NEON
+  static void neon( const float *in, int16_t *out, size_t count,
+                    const convert_to_16bit *self )
+  {
+    const float scale = self->_scale;
+    const float32x4_t max = vdupq_n_f32( self->_limit );
+    const float32x4_t min = vdupq_n_f32( -self->_limit );
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      float32x4_t f0 = vmulq_n_f32( vld1q_f32( in + i + 0 ), scale );
+      float32x4_t f1 = vmulq_n_f32( vld1q_f32( in + i + 4 ), scale );
+
+      int32x4_t i0 = neon_round( vminq_f32( vmaxq_f32( f0, min ), max ) );
+      int32x4_t i1 = neon_round( vminq_f32( vmaxq_f32( f1, min ), max ) );
+
+      vst1q_s16( out + i, vcombine_s16( vqmovn_s32( i0 ), vqmovn_s32( i1 ) ) );
+    }
+
+    convert_to_16bit::generic( in + i, out + i, count - i, self );
+  }
+#endif
+};
+
+convert_16bit::convert_16bit( float scale )
+  : _kernel( generic ),
+    _name( "generic" ),
+    _scale( scale )
+{
+#ifdef CONVERT_X86_DISPATCH
+  if ( cpu_has_avx2() ) {
+    _kernel = convert_16bit_kernels::avx2;
+    _name = "avx2";
+  } else if ( cpu_has_sse2() ) {
+    _kernel = convert_16bit_kernels::sse2;
+    _name = "sse2";
+  }
+#elif defined(CONVERT_NEON)
+  if ( simd_limit() >= SIMD_SSE2 ) {
+    _kernel = convert_16bit_kernels::neon;
+    _name = "neon";
+  }
+#endif
+}
+
+void convert_16bit::generic( const int16_t *in, float *out, size_t count,
+                             const convert_16bit *self )
+{
+  const float scale = self->_scale;
+
+  for (size_t i = 0; i < count; i++)
+    out[i] = in[i] * scale;
+}
+
+/* the vector kernels interleave 16 bit I and Q first and widen afterwards */
+struct convert_16bit_planar_kernels
+{
+#ifdef CONVERT_X86_DISPATCH
+  TARGET_SSE2
+  static void sse2( const int16_t *in_i, const int16_t *in_q, float *out,
+                    size_t nsamples, const convert_16bit_planar *self )
+  {
+    const __m128 scale = _mm_set1_ps( self->_scale );
+
+    size_t i = 0;
+    for (; i + 8 <= nsamples; i += 8) {
+      __m128i vi = _mm_loadu_si128( (const __m128i *)(in_i + i) );
+      __m128i vq = _mm_loadu_si128( (const __m128i *)(in_q + i) );
+
+      __m128i lo = _mm_unpacklo_epi16( vi, vq );
+      __m128i hi = _mm_unpackhi_epi16( vi, vq );
+
+      /* sign extend 16 -> 32 bit by unpacking into the upper half */
+      __m128i i0 = _mm_srai_epi32( _mm_unpacklo_epi16( lo, lo ), 16 );
+      __m128i i1 = _mm_srai_epi32( _mm_unpackhi_epi16( lo, lo ), 16 );
+      __m128i i2 = _mm_srai_epi32( _mm_unpacklo_epi16( hi, hi ), 16 );
+      __m128i i3 = _mm_srai_epi32( _mm_unpackhi_epi16( hi, hi ), 16 );
+
+      _mm_storeu_ps( out + 2 * i +  0, _mm_mul_ps( _mm_cvtepi32_ps( i0 ), scale ) );
+      _mm_storeu_ps( out + 2 * i +  4, _mm_mul_ps( _mm_cvtepi32_ps( i1 ), scale ) );
+      _mm_storeu_ps( out + 2 * i +  8, _mm_mul_ps( _mm_cvtepi32_ps( i2 ), scale ) );
+      _mm_storeu_ps( out + 2 * i + 12, _mm_mul_ps( _mm_cvtepi32_ps( i3 ), scale ) );
+    }
+
+    convert_16bit_planar::generic( in_i + i, in_q + i, out + 2 * i, nsamples - i, self );
+  }
+
+  TARGET_AVX2
+  static void avx2( const int16_t *in_i, const int16_t *in_q, float *out,
+                    size_t nsamples, const convert_16bit_planar *self )
+  {
+    const __m256 scale = _mm256_set1_ps( self->_scale );
+
+    size_t i = 0;
+    for (; i + 8 <= nsamples; i += 8) {
+      __m128i vi = _mm_loadu_si128( (const __m128i *)(in_i + i) );
+      __m128i vq = _mm_loadu_si128( (const __m128i *)(in_q + i) );
+
+      __m256i i0 = _mm256_cvtepi16_epi32( _mm_unpacklo_epi16( vi, vq ) );
+      __m256i i1 = _mm256_cvtepi16_epi32( _mm_unpackhi_epi16( vi, vq ) );
+
+      _mm256_storeu_ps( out + 2 * i + 0, _mm256_mul_ps( _mm256_cvtepi32_ps( i0 ), scale ) );
+      _mm256_storeu_ps( out + 2 * i + 8, _mm256_mul_ps( _mm256_cvtepi32_ps( i1 ), scale ) );
+    }
+
+    convert_16bit_planar::generic( in_i + i, in_q + i, out + 2 * i, nsamples - i, self );
+  }
+#endif
+
+#ifdef CONVERT_NEON
+  static void neon( const int16_t *in_i, const int16_t *in_q, float *out,
+                    size_t nsamples, const convert_16bit_planar *self )
+  {
+    const float scale = self->_scale;
+
+    size_t i = 0;
+    for (; i + 8 <= nsamples; i += 8) {
+      int16x8x2_t v = vzipq_s16( vld1q_s16( in_i + i ), vld1q_s16( in_q + i ) );
+
+      vst1q_f32( out + 2 * i +  0, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_low_s16( v.val[0] ) ) ), scale ) );
+      vst1q_f32( out + 2 * i +  4, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_high_s16( v.val[0] ) ) ), scale ) );
+      vst1q_f32( out + 2 * i +  8, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_low_s16( v.val[1] ) ) ), scale ) );
+      vst1q_f32( out + 2 * i + 12, vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( vget_high_s16( v.val[1] ) ) ), scale ) );
+    }
+
+    convert_16bit_planar::generic( in_i + i, in_q + i, out + 2 * i, nsamples - i, self );
+  }
+#endif
+};
+
+convert_16bit_planar::convert_16bit_planar( float scale )
+  : _kernel( generic ),
+    _name( "generic" ),
+    _scale( scale )
+{
+#ifdef CONVERT_X86_DISPATCH
+  if ( cpu_has_avx2() ) {
+    _kernel = convert_16bit_planar_kernels::avx2;
+    _name = "avx2";
+  } else if ( cpu_has_sse2() ) {
+    _kernel = convert_16bit_planar_kernels::sse2;
+    _name = "sse2";
+  }
+#elif defined(CONVERT_NEON)
+  if ( simd_limit() >= SIMD_SSE2 ) {
+    _kernel = convert_16bit_planar_kernels::neon;
+    _name = "neon";
+  }
+#endif
+}
+
+void convert_16bit_planar::generic( const int16_t *in_i, const int16_t *in_q, float *out,
+                                    size_t nsamples, const convert_16bit_planar *self )
+{
+  const float scale = self->_scale;
+
+  for (size_t i = 0; i < nsamples; i++) {
+    out[2 * i + 0] = in_i[i] * scale;
+    out[2 * i + 1] = in_q[i] * scale;
+  }
+}
+
+/*
+ * The vector kernels move the 3 bytes of each value into the upper bytes
+ * of a 32 bit lane and shift it back arithmetically, which sign extends.
+ */
+struct convert_24bit_kernels
+{
+#ifdef CONVERT_X86_DISPATCH
+  TARGET_SSSE3
+  static void ssse3( const unsigned char *in, float *out, size_t count,
+                     const convert_24bit *self )
+  {
+    const __m128 scale = _mm_set1_ps( self->_scale );
+
+    /* values 0..3 from bytes 0..11 of the first load, 4..7 from bytes
+     * 4..15 of the second one at offset 8, so nothing is read beyond the
+     * 24 bytes of the 8 values */
+    const __m128i lo = _mm_setr_epi8( -1, 0, 1, 2, -1, 3, 4, 5,
+                                      -1, 6, 7, 8, -1, 9, 10, 11 );
+    const __m128i hi = _mm_setr_epi8( -1, 4, 5, 6, -1, 7, 8, 9,
+                                      -1, 10, 11, 12, -1, 13, 14, 15 );
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const unsigned char *src = in + 3 * i;
+
+      __m128i i0 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(src + 0) ), lo );
+      __m128i i1 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(src + 8) ), hi );
+
+      _mm_storeu_ps( out + i + 0, _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( i0, 8 ) ), scale ) );
+      _mm_storeu_ps( out + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( i1, 8 ) ), scale ) );
+    }
+
+    convert_24bit::generic( in + 3 * i, out + i, count - i, self );
+  }
+
+  TARGET_AVX2
+  static void avx2( const unsigned char *in, float *out, size_t count,
+                    const convert_24bit *self )
+  {
+    const __m256 scale = _mm256_set1_ps( self->_scale );
+
+    /* vpshufb works within 128 bit lanes, the lanes are loaded like the
+     * two halves of the ssse3 kernel */
+    const __m256i shuffle = _mm256_setr_epi8( -1, 0, 1, 2, -1, 3, 4, 5,
+                                              -1, 6, 7, 8, -1, 9, 10, 11,
+                                              -1, 4, 5, 6, -1, 7, 8, 9,
+                                              -1, 10, 11, 12, -1, 13, 14, 15 );
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      const unsigned char *src = in + 3 * i;
+
+      __m256i v0 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+                     _mm_loadu_si128( (const __m128i *)(src + 0) ) ),
+                     _mm_loadu_si128( (const __m128i *)(src + 8) ), 1 );
+      __m256i v1 = _mm256_inserti128_si256( _mm256_castsi128_si256(
+                     _mm_loadu_si128( (const __m128i *)(src + 24) ) ),
+                     _mm_loadu_si128( (const __m128i *)(src + 32) ), 1 );
+
+      __m256i i0 = _mm256_srai_epi32( _mm256_shuffle_epi8( v0, shuffle ), 8 );
+      __m256i i1 = _mm256_srai_epi32( _mm256_shuffle_epi8( v1, shuffle ), 8 );
+
+      _mm256_storeu_ps( out + i + 0, _mm256_mul_ps( _mm256_cvtepi32_ps( i0 ), scale ) );
+      _mm256_storeu_ps( out + i + 8, _mm256_mul_ps( _mm256_cvtepi32_ps( i1 ), scale ) );
+    }
+
+    convert_24bit::generic( in + 3 * i, out + i, count - i, self );
+  }
+#endif
+
+#ifdef CONVERT_NEON
+  static void neon( const unsigned char *in, float *out, size_t count,
+                    const convert_24bit *self )
+  {
+    const float scale = self->_scale;
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      /* deinterleave into the low, middle and high bytes of 16 values */
+      uint8x16x3_t b = vld3q_u8( in + 3 * i );
+
+      /* middle and high byte make up the signed upper 16 bits */
+      uint8x16x2_t mh = vzipq_u8( b.val[1], b.val[2] );
+      int16x8_t hi0 = vreinterpretq_s16_u8( mh.val[0] );
+      int16x8_t hi1 = vreinterpretq_s16_u8( mh.val[1] );
+
+      uint16x8_t lo0 = vmovl_u8( vget_low_u8( b.val[0] ) );
+      uint16x8_t lo1 = vmovl_u8( vget_high_u8( b.val[0] ) );
+
+      int32x4_t i0 = vorrq_s32( vshll_n_s16( vget_low_s16( hi0 ), 8 ),
+                                vreinterpretq_s32_u32( vmovl_u16( vget_low_u16( lo0 ) ) ) );
+      int32x4_t i1 = vorrq_s32( vshll_n_s16( vget_high_s16( hi0 ), 8 ),
+                                vreinterpretq_s32_u32( vmovl_u16( vget_high_u16( lo0 ) ) ) );
+      int32x4_t i2 = vorrq_s32( vshll_n_s16( vget_low_s16( hi1 ), 8 ),
+                                vreinterpretq_s32_u32( vmovl_u16( vget_low_u16( lo1 ) ) ) );
+      int32x4_t i3 = vorrq_s32( vshll_n_s16( vget_high_s16( hi1 ), 8 ),
+                                vreinterpretq_s32_u32( vmovl_u16( vget_high_u16( lo1 ) ) ) );
+
+      vst1q_f32( out + i +  0, vmulq_n_f32( vcvtq_f32_s32( i0 ), scale ) );
+      vst1q_f32( out + i +  4, vmulq_n_f32( vcvtq_f32_s32( i1 ), scale ) );
+      vst1q_f32( out + i +  8, vmulq_n_f32( vcvtq_f32_s32( i2 ), scale ) );
+      vst1q_f32( out + i + 12, vmulq_n_f32( vcvtq_f32_s32( i3 ), scale ) );
+    }
+
+    convert_24bit::generic( in + 3 * i, out + i, count - i, self );
+  }
+#endif
+};
+
+convert_24bit::convert_24bit( float scale )
+  : _kernel( generic ),
+    _name( "generic" ),
+    _scale( scale )
+{
+#ifdef CONVERT_X86_DISPATCH
+  if ( cpu_has_avx2() ) {
+    _kernel = convert_24bit_kernels::avx2;
+    _name = "avx2";
+  } else if ( cpu_has_ssse3() ) {
+    _kernel = convert_24bit_kernels::ssse3;
+    _name = "ssse3";
+  }
+#elif defined(CONVERT_NEON)
+  if ( simd_limit() >= SIMD_SSE2 ) {
+    _kernel = convert_24bit_kernels::neon;
+    _name = "neon";
+  }
+#endif
+}
+
+void convert_24bit::generic( const unsigned char *in, float *out, size_t count,
+                             const convert_24bit *self )
+{
+  const float scale = self->_scale;
+
+  for (size_t i = 0; i < count; i++, in += 3) {
+    int32_t value = int32_t( uint32_t(in[0]) << 8 |
+                             uint32_t(in[1]) << 16 |
+                             uint32_t(in[2]) << 24 ) >> 8;
+    out[i] = value * scale;
+  }
+}
+
+convert_to_16bit::convert_to_16bit( float scale, float limit )
+  : _kernel( generic ),
+    _name( "generic" ),
+    _scale( scale ),
+    _limit( std::min( limit, 32767.0f ) )
+{
+#ifdef CONVERT_X86_DISPATCH
+  if ( cpu_has_avx512() ) {
+    _kernel = convert_16bit_kernels::avx512;
+    _name = "avx512";
+  } else if ( cpu_has_avx2() ) {
+    _kernel = convert_16bit_kernels::avx2;
+    _name = "avx2";
+  } else if ( cpu_has_sse2() ) {
+    _kernel = convert_16bit_kernels::sse2;
+    _name = "sse2";
+  }
+#elif defined(CONVERT_NEON)
+  if ( simd_limit() >= SIMD_SSE2 ) {
+    _kernel = convert_16bit_kernels::neon;
+    _name = "neon";
+  }
+#endif
+}
+
+void convert_to_16bit::generic( const float *in, int16_t *out, size_t count,
+                                const convert_to_16bit *self )
+{
+  const float scale = self->_scale;
+  const float limit = self->_limit;
+
+  for (size_t i = 0; i < count; i++) {
+    float value = in[i] * scale;
+
+    if (value > limit)
+      value = limit;
+    else if (value < -limit)
+      value = -limit;
+
+    out[i] = (int16_t) lrintf( value );
+  }
+}
+
+struct convert_to_8bit_kernels
+{
+#ifdef CONVERT_X86_DISPATCH
+  TARGET_SSE2
+  static void sse2( const float *in, int8_t *out, size_t count,
+                    const convert_to_8bit *self )
+  {
+    const __m128 scale = _mm_set1_ps( self->_scale );
+    const __m128 max = _mm_set1_ps( self->_limit );
+    const __m128 min = _mm_set1_ps( -self->_limit );
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      __m128i v[4];
+
+      for (int j = 0; j < 4; j++) {
+        __m128 f = _mm_mul_ps( _mm_loadu_ps( in + i + j * 4 ), scale );
+        v[j] = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( f, min ), max ) );
+      }
+
+      __m128i s0 = _mm_packs_epi32( v[0], v[1] );
+      __m128i s1 = _mm_packs_epi32( v[2], v[3] );
+
+      _mm_storeu_si128( (__m128i *)(out + i), _mm_packs_epi16( s0, s1 ) );
+    }
+
+    convert_to_8bit::generic( in + i, out + i, count - i, self );
+  }
+
+  TARGET_AVX2
+  static void avx2( const float *in, int8_t *out, size_t count,
+                    const convert_to_8bit *self )
+  {
+    const __m256 scale = _mm256_set1_ps( self->_scale );
+    const __m256 max = _mm256_set1_ps( self->_limit );
+    const __m256 min = _mm256_set1_ps( -self->_limit );
+    const __m256i order = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+      __m256i v[4];
+
+      for (int j = 0; j < 4; j++) {
+        __m256 f = _mm256_mul_ps( _mm256_loadu_ps( in + i + j * 8 ), scale );
+        v[j] = _mm256_cvtps_epi32( _mm256_min_ps( _mm256_max_ps( f, min ), max ) );
+      }
+
+      __m256i s0 = _mm256_packs_epi32( v[0], v[1] );
+      __m256i s1 = _mm256_packs_epi32( v[2], v[3] );
+
+      /* packs works within 128 bit lanes, restore the sample order */
+      __m256i b = _mm256_permutevar8x32_epi32( _mm256_packs_epi16( s0, s1 ), order );
+
+      _mm256_storeu_si256( (__m256i *)(out + i), b );
+    }
+
+    convert_to_8bit::generic( in + i, out + i, count - i, self );
+  }
+
+  TARGET_AVX512
+  static void avx512( const float *in, int8_t *out, size_t count,
+                      const convert_to_8bit *self )
+  {
+    const __m512 scale = _mm512_set1_ps( self->_scale );
+    const __m512 max = _mm512_set1_ps( self->_limit );
+    const __m512 min = _mm512_set1_ps( -self->_limit );
+
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+      for (int j = 0; j < 4; j++) {
+        __m512 f = _mm512_mul_ps( _mm512_loadu_ps( in + i + j * 16 ), scale );
+        __m512i v = _mm512_cvtps_epi32( _mm512_min_ps( _mm512_max_ps( f, min ), max ) );
+
+        _mm_storeu_si128( (__m128i *)(out + i + j * 16), _mm512_cvtsepi32_epi8( v ) );
+      }
+    }
+
+    convert_to_8bit::generic( in + i, out + i, count - i, self );
+  }
+#endif
+
+#ifdef CONVERT_NEON
+  static void neon( const float *in, int8_t *out, size_t count,
+                    const convert_to_8bit *self )
+  {
+    const float scale = self->_scale;
+    const float32x4_t max = vdupq_n_f32( self->_limit );
+    const float32x4_t min = vdupq_n_f32( -self->_limit );
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+      int16x4_t s[4];
+
+      for (int j = 0; j < 4; j++) {
+        float32x4_t f = vmulq_n_f32( vld1q_f32( in + i + j * 4 ), scale );
+        s[j] = vqmovn_s32( neon_round( vminq_f32( vmaxq_f32( f, min ), max ) ) );
+      }
+
+      int8x8_t lo = vqmovn_s16( vcombine_s16( s[0], s[1] ) );
+      int8x8_t hi = vqmovn_s16( vcombine_s16( s[2], s[3] ) );
+
+      vst1q_s8( out + i, vcombine_s8( lo, hi ) );
+    }
+
+    convert_to_8bit::generic( in + i, out + i, count - i, self );
+  }
+#endif
+};
+
+convert_to_8bit::convert_to_8bit( float scale, float limit )
+  : _kernel( generic ),
+    _name( "generic" ),
+    _scale( scale ),
+    _limit( std::min( limit, 127.0f ) )
+{
+#ifdef CONVERT_X86_DISPATCH
+  if ( cpu_has_avx512() ) {
+    _kernel = convert_to_8bit_kernels::avx512;
+    _name = "avx512";
+  } else if ( cpu_has_avx2() ) {
+    _kernel = convert_to_8bit_kernels::avx2;
+    _name = "avx2";
+  } else if ( cpu_has_sse2() ) {
+    _kernel = convert_to_8bit_kernels::sse2;
+    _name = "sse2";
+  }
+#elif defined(CONVERT_NEON)
+  if ( simd_limit() >= SIMD_SSE2 ) {
+    _kernel = convert_to_8bit_kernels::neon;
+    _name = "neon";
+  }
+#endif
+}
+
+void convert_to_8bit::generic( const float *in, int8_t *out, size_t count,
+                               const convert_to_8bit *self )
+{
+  const float scale = self->_scale;
+  const float limit = self->_limit;
+
+  for (size_t i = 0; i < count; i++) {
+    float value = in[i] * scale;
+
+    if (value > limit)
+      value = limit;
+    else if (value < -limit)
+      value = -limit;
+
+    out[i] = (int8_t) lrintf( value );
+  }
+}
+
+/* without the range checks of operator*(), which gcc calls __mulsc3 for */
+static inline gr_complex mul_complex( const gr_complex &a, const gr_complex &b )
+{
+  return gr_complex( a.real() * b.real() - a.imag() * b.imag(),
+                     a.real() * b.imag() + a.imag() * b.real() );
+}
+
+struct correct_iq_kernels
+{
+#ifdef CONVERT_X86_DISPATCH
+  /* interleaved complex a * b, b_swap holding b with re and im swapped */
+  TARGET_SSE2
+  static inline __m128 mul_sse2( __m128 a, __m128 b, __m128 b_swap )
+  {
+    const __m128 sign = _mm_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f );
+    const __m128 a_re = _mm_shuffle_ps( a, a, _MM_SHUFFLE(2, 2, 0, 0) );
+    const __m128 a_im = _mm_shuffle_ps( a, a, _MM_SHUFFLE(3, 3, 1, 1) );
+
+    return _mm_add_ps( _mm_mul_ps( a_re, b ),
+                       _mm_mul_ps( _mm_mul_ps( a_im, b_swap ), sign ) );
+  }
+
+  TARGET_SSE2
+  static void sse2_mix( const float *in, float *out, size_t nsamples,
+                        const correct_iq *self, gr_complex phasor, gr_complex step )
+  {
+    const __m128 dc = _mm_setr_ps( self->_dc_re, self->_dc_im, self->_dc_re, self->_dc_im );
+    const __m128 from_re = _mm_setr_ps( 1.0f, self->_a, 1.0f, self->_a );
+    const __m128 from_im = _mm_setr_ps( 0.0f, self->_b, 0.0f, self->_b );
+
+    /* the phasors of two samples, advanced by two steps at a time */
+    const gr_complex p1 = mul_complex( phasor, step );
+    const gr_complex s2 = mul_complex( step, step );
+
+    __m128 p = _mm_setr_ps( phasor.real(), phasor.imag(), p1.real(), p1.imag() );
+    const __m128 s = _mm_setr_ps( s2.real(), s2.imag(), s2.real(), s2.imag() );
+    const __m128 s_swap = _mm_setr_ps( s2.imag(), s2.real(), s2.imag(), s2.real() );
+
+    size_t i = 0;
+    for (; i + 2 <= nsamples; i += 2) {
+      __m128 y = _mm_sub_ps( _mm_loadu_ps( in + i * 2 ), dc );
+
+      __m128 re = _mm_shuffle_ps( y, y, _MM_SHUFFLE(2, 2, 0, 0) );
+      __m128 im = _mm_shuffle_ps( y, y, _MM_SHUFFLE(3, 3, 1, 1) );
+      __m128 c = _mm_add_ps( _mm_mul_ps( re, from_re ), _mm_mul_ps( im, from_im ) );
+
+      _mm_storeu_ps( out + i * 2,
+                     mul_sse2( c, p, _mm_shuffle_ps( p, p, _MM_SHUFFLE(2, 3, 0, 1) ) ) );
+
+      p = mul_sse2( p, s, s_swap );
+    }
+
+    float next[4];
+    _mm_storeu_ps( next, p );
+
+    correct_iq::generic_mix( in + i * 2, out + i * 2, nsamples - i, self,
+                             gr_complex( next[0], next[1] ), step );
+  }
+
+  TARGET_AVX2
+  static inline __m256 mul_avx2( __m256 a, __m256 b, __m256 b_swap )
+  {
+    const __m256 sign = _mm256_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f,
+                                        -1.0f, 1.0f, -1.0f, 1.0f );
+    const __m256 a_re = _mm256_shuffle_ps( a, a, _MM_SHUFFLE(2, 2, 0, 0) );
+    const __m256 a_im = _mm256_shuffle_ps( a, a, _MM_SHUFFLE(3, 3, 1, 1) );
+
+    return _mm256_add_ps( _mm256_mul_ps( a_re, b ),
+                          _mm256_mul_ps( _mm256_mul_ps( a_im, b_swap ), sign ) );
+  }
+
+  TARGET_AVX2
+  static void avx2_mix( const float *in, float *out, size_t nsamples,
+                        const correct_iq *self, gr_complex phasor, gr_complex step )
+  {
+    const __m256 dc = _mm256_setr_ps( self->_dc_re, self->_dc_im, self->_dc_re, self->_dc_im,
+                                      self->_dc_re, self->_dc_im, self->_dc_re, self->_dc_im );
+    const __m256 from_re = _mm256_setr_ps( 1.0f, self->_a, 1.0f, self->_a,
+                                           1.0f, self->_a, 1.0f, self->_a );
+    const __m256 from_im = _mm256_setr_ps( 0.0f, self->_b, 0.0f, self->_b,
+                                           0.0f, self->_b, 0.0f, self->_b );
+
+    /* the phasors of four samples, advanced by four steps at a time */
+    const gr_complex p1 = mul_complex( phasor, step );
+    const gr_complex p2 = mul_complex( p1, step );
+    const gr_complex p3 = mul_complex( p2, step );
+    const gr_complex s2 = mul_complex( step, step );
+    const gr_complex s4 = mul_complex( s2, s2 );
+
+    __m256 p = _mm256_setr_ps( phasor.real(), phasor.imag(), p1.real(), p1.imag(),
+                               p2.real(), p2.imag(), p3.real(), p3.imag() );
+    const __m256 s = _mm256_setr_ps( s4.real(), s4.imag(), s4.real(), s4.imag(),
+                                     s4.real(), s4.imag(), s4.real(), s4.imag() );
+    const __m256 s_swap = _mm256_setr_ps( s4.imag(), s4.real(), s4.imag(), s4.real(),
+                                          s4.imag(), s4.real(), s4.imag(), s4.real() );
+
+    size_t i = 0;
+    for (; i + 4 <= nsamples; i += 4) {
+      __m256 y = _mm256_sub_ps( _mm256_loadu_ps( in + i * 2 ), dc );
+
+      __m256 re = _mm256_shuffle_ps( y, y, _MM_SHUFFLE(2, 2, 0, 0) );
+      __m256 im = _mm256_shuffle_ps( y, y, _MM_SHUFFLE(3, 3, 1, 1) );
+      __m256 c = _mm256_add_ps( _mm256_mul_ps( re, from_re ), _mm256_mul_ps( im, from_im ) );
+
+      _mm256_storeu_ps( out + i * 2,
+                        mul_avx2( c, p, _mm256_shuffle_ps( p, p, _MM_SHUFFLE(2, 3, 0, 1) ) ) );
+
+      p = mul_avx2( p, s, s_swap );
+    }
+
+    float next[8];
+    _mm256_storeu_ps( next, p );
+
+    correct_iq::generic_mix( in + i * 2, out + i * 2, nsamples - i, self,
+                             gr_complex( next[0], next[1] ), step );
+  }
+
+  TARGET_SSE2
+  static void sse2( const float *in, float *out, size_t nsamples,
+                    const correct_iq *self )
+  {
+    const __m128 dc = _mm_setr_ps( self->_dc_re, self->_dc_im, self->_dc_re, self->_dc_im );
+    const __m128 from_re = _mm_setr_ps( 1.0f, self->_a, 1.0f, self->_a );
+    const __m128 from_im = _mm_setr_ps( 0.0f, self->_b, 0.0f, self->_b );
+
+    size_t i = 0;
+    for (; i + 2 <= nsamples; i += 2) {
+      __m128 y = _mm_sub_ps( _mm_loadu_ps( in + i * 2 ), dc );
+
+      __m128 re = _mm_shuffle_ps( y, y, _MM_SHUFFLE(2, 2, 0, 0) );
+      __m128 im = _mm_shuffle_ps( y, y, _MM_SHUFFLE(3, 3, 1, 1) );
+
+      _mm_storeu_ps( out + i * 2, _mm_add_ps( _mm_mul_ps( re, from_re ),
+                                              _mm_mul_ps( im, from_im ) ) );
+    }
+
+    correct_iq::generic( in + i * 2, out + i * 2, nsamples - i, self );
+  }
+
+  TARGET_AVX2
+  static void avx2( const float *in, float *out, size_t nsamples,
+                    const correct_iq *self )
+  {
+    const __m256 dc = _mm256_setr_ps( self->_dc_re, self->_dc_im, self->_dc_re, self->_dc_im,
+                                      self->_dc_re, self->_dc_im, self->_dc_re, self->_dc_im );
+    const __m256 from_re = _mm256_setr_ps( 1.0f, self->_a, 1.0f, self->_a,
+                                           1.0f, self->_a, 1.0f, self->_a );
+    const __m256 from_im = _mm256_setr_ps( 0.0f, self->_b, 0.0f, self->_b,
+                                           0.0f, self->_b, 0.0f, self->_b );
+
+    size_t i = 0;
+    for (; i + 4 <= nsamples; i += 4) {
+      __m256 y = _mm256_sub_ps( _mm256_loadu_ps( in + i * 2 ), dc );
+
+      __m256 re = _mm256_shuffle_ps( y, y, _MM_SHUFFLE(2, 2, 0, 0) );
+      __m256 im = _mm256_shuffle_ps( y, y, _MM_SHUFFLE(3, 3, 1, 1) );
+
+      _mm256_storeu_ps( out + i * 2, _mm256_add_ps( _mm256_mul_ps( re, from_re ),
+                                                    _mm256_mul_ps( im, from_im ) ) );
+    }
+
+    correct_iq::generic( in + i * 2, out + i * 2, nsamples - i, self );
+  }
+#endif
+
+#ifdef CONVERT_NEON
+  static void neon( const float *in, float *out, size_t nsamples,
+                    const correct_iq *self )
+  {
+    const float32x4_t dc_re = vdupq_n_f32( self->_dc_re );
+    const float32x4_t dc_im = vdupq_n_f32( self->_dc_im );
+
+    size_t i = 0;
+    for (; i + 4 <= nsamples; i += 4) {
+      float32x4x2_t v = vld2q_f32( in + i * 2 ); /* deinterleaves I and Q */
+
+      float32x4_t re = vsubq_f32( v.val[0], dc_re );
+      float32x4_t im = vsubq_f32( v.val[1], dc_im );
+
+      v.val[0] = re;
+      v.val[1] = vaddq_f32( vmulq_n_f32( re, self->_a ), vmulq_n_f32( im, self->_b ) );
+
+      vst2q_f32( out + i * 2, v );
+    }
+
+    correct_iq::generic( in + i * 2, out + i * 2, nsamples - i, self );
+  }
+
+  static void neon_mix( const float *in, float *out, size_t nsamples,
+                        const correct_iq *self, gr_complex phasor, gr_complex step )
+  {
+    const float32x4_t dc_re = vdupq_n_f32( self->_dc_re );
+    const float32x4_t dc_im = vdupq_n_f32( self->_dc_im );
+
+    /* the phasors of four samples, advanced by four steps at a time */
+    float p_re[4], p_im[4];
+    gr_complex p = phasor;
+
+    for (int k = 0; k < 4; k++) {
+      p_re[k] = p.real();
+      p_im[k] = p.imag();
+      p = mul_complex( p, step );
+    }
+
+    const gr_complex s4 = mul_complex( mul_complex( step, step ), mul_complex( step, step ) );
+
+    float32x4_t pr = vld1q_f32( p_re );
+    float32x4_t pi = vld1q_f32( p_im );
+
+    size_t i = 0;
+    for (; i + 4 <= nsamples; i += 4) {
+      float32x4x2_t v = vld2q_f32( in + i * 2 ); /* deinterleaves I and Q */
+
+      float32x4_t re = vsubq_f32( v.val[0], dc_re );
+      float32x4_t im = vsubq_f32( v.val[1], dc_im );
+
+      im = vaddq_f32( vmulq_n_f32( re, self->_a ), vmulq_n_f32( im, self->_b ) );
+
+      v.val[0] = vmlsq_f32( vmulq_f32( re, pr ), im, pi );
+      v.val[1] = vmlaq_f32( vmulq_f32( re, pi ), im, pr );
+
+      vst2q_f32( out + i * 2, v );
+
+      float32x4_t next = vmlsq_f32( vmulq_n_f32( pr, s4.real() ), pi, vdupq_n_f32( s4.imag() ) );
+      pi = vmlaq_f32( vmulq_n_f32( pr, s4.imag() ), pi, vdupq_n_f32( s4.real() ) );
+      pr = next;
+    }
+
+    correct_iq::generic_mix( in + i * 2, out + i * 2, nsamples - i, self,
+                             gr_complex( vgetq_lane_f32( pr, 0 ), vgetq_lane_f32( pi, 0 ) ),
+                             step );
+  }
+#endif
+};
+
+correct_iq::correct_iq()
+  : _kernel( generic ),
+    _mix_kernel( generic_mix ),
+    _name( "generic" ),
+    _dc_re( 0.0f ),
+    _dc_im( 0.0f ),
+    _a( 0.0f ),
+    _b( 1.0f )
+{
+#ifdef CONVERT_X86_DISPATCH
+  if ( cpu_has_avx2() ) {
+    _kernel = correct_iq_kernels::avx2;
+    _mix_kernel = correct_iq_kernels::avx2_mix;
+    _name = "avx2";
+  } else if ( cpu_has_sse2() ) {
+    _kernel = correct_iq_kernels::sse2;
+    _mix_kernel = correct_iq_kernels::sse2_mix;
+    _name = "sse2";
+  }
+#elif defined(CONVERT_NEON)
+  if ( simd_limit() >= SIMD_SSE2 ) {
+    _kernel = correct_iq_kernels::neon;
+    _mix_kernel = correct_iq_kernels::neon_mix;
+    _name = "neon";
+  }
+#endif
+}
+
+void correct_iq::generic( const float *in, float *out, size_t nsamples,
+                          const correct_iq *self )
+{
+  for (size_t i = 0; i < nsamples; i++) {
+    const float re = in[i * 2 + 0] - self->_dc_re;
+    const float im = in[i * 2 + 1] - self->_dc_im;
+
+    out[i * 2 + 0] = re;
+    out[i * 2 + 1] = self->_a * re + self->_b * im;
+  }
+}
+
+void correct_iq::generic_mix( const float *in, float *out, size_t nsamples,
+                              const correct_iq *self,
+                              gr_complex phasor, gr_complex step )
+{
+  for (size_t i = 0; i < nsamples; i++) {
+    const float re = in[i * 2 + 0] - self->_dc_re;
+    const float im = self->_a * re + self->_b * (in[i * 2 + 1] - self->_dc_im);
+
+    out[i * 2 + 0] = re * phasor.real() - im * phasor.imag();
+    out[i * 2 + 1] = re * phasor.imag() + im * phasor.real();
+
+    phasor = mul_complex( phasor, step );
+  }
+}
+
+void *convert_malloc( size_t size )
+{
+#ifdef _WIN32
+  return _aligned_malloc( size, CONVERT_ALIGNMENT );
+#else
+  void *ptr = NULL;
+
+  if ( posix_memalign( &ptr, CONVERT_ALIGNMENT, size ) != 0 )
+    return NULL;
+
+  return ptr;
+#endif
+}
+
+void convert_free( void *ptr )
+{
+#ifdef _WIN32
+  _aligned_free( ptr );
+#else
+  free( ptr );
+#endif
+}
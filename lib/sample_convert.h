@@ -0,0 +1,409 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_SAMPLE_CONVERT_H
+#define OSMOSDR_SAMPLE_CONVERT_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <stdint.h>
+
+#include <gnuradio/gr_complex.h>
+
+#include <osmosdr/api.h>
+
+/*!
+ * \brief Converts interleaved 8 bit IQ samples to floats.
+ *
+ * The fastest kernel supported by the running cpu (AVX2, SSE2 or NEON) is
+ * selected once at construction time. A 256 entry lookup table is used as
+ * a fallback when no vector unit is available.
+ *
+ * The conversion performed is out = (in - offset) * scale, where in is
+ * interpreted as unsigned (offset binary) or signed (two's complement)
+ * depending on the constructor argument.
+ */
+class OSMOSDR_API convert_8bit
+{
+public:
+  convert_8bit( bool is_signed, float offset, float scale );
+
+  /*!
+   * Convert \p count 8 bit values into \p count floats.
+   */
+  void operator()( const void *in, float *out, size_t count ) const
+  {
+    _kernel( (const unsigned char *)in, out, count, this );
+  }
+
+  /*!
+   * Convert \p nsamples IQ pairs into \p nsamples complex samples.
+   */
+  void operator()( const void *in, gr_complex *out, size_t nsamples ) const
+  {
+    _kernel( (const unsigned char *)in, (float *)out, nsamples * 2, this );
+  }
+
+  /*!
+   * Convert only one rail of \p nsamples IQ pairs into \p nsamples floats,
+   * the I values for \p rail 0 or the Q values for \p rail 1.
+   */
+  void rail( const void *in, float *out, size_t nsamples, unsigned int rail ) const
+  {
+    _rail_kernel( (const unsigned char *)in + (rail & 1), out, nsamples, this );
+  }
+
+  /*! \return the name of the selected kernel, for informational purposes */
+  const char *name() const { return _name; }
+
+  typedef void (*kernel_t)( const unsigned char *in, float *out, size_t count,
+                            const convert_8bit *self );
+
+private:
+  static void generic( const unsigned char *in, float *out, size_t count,
+                       const convert_8bit *self );
+
+  /* converts every other value of in, count is the number of outputs */
+  static void generic_rail( const unsigned char *in, float *out, size_t count,
+                            const convert_8bit *self );
+
+  friend struct convert_8bit_kernels;
+
+  kernel_t _kernel;
+  kernel_t _rail_kernel;
+  const char *_name;
+
+  unsigned char _flip; /* turns offset binary into two's complement */
+  float _scale;
+  float _add;
+  float _lut[256];
+};
+
+/*!
+ * \brief Converts interleaved 16 bit IQ samples to floats.
+ *
+ * The conversion performed is out = in * scale. Kernels are selected the
+ * same way as for convert_8bit.
+ */
+class OSMOSDR_API convert_16bit
+{
+public:
+  explicit convert_16bit( float scale );
+
+  /*!
+   * Convert \p count 16 bit values into \p count floats.
+   */
+  void operator()( const int16_t *in, float *out, size_t count ) const
+  {
+    _kernel( in, out, count, this );
+  }
+
+  /*!
+   * Convert \p nsamples IQ pairs into \p nsamples complex samples.
+   */
+  void operator()( const int16_t *in, gr_complex *out, size_t nsamples ) const
+  {
+    _kernel( in, (float *)out, nsamples * 2, this );
+  }
+
+  /*! \return the name of the selected kernel, for informational purposes */
+  const char *name() const { return _name; }
+
+  typedef void (*kernel_t)( const int16_t *in, float *out, size_t count,
+                            const convert_16bit *self );
+
+private:
+  static void generic( const int16_t *in, float *out, size_t count,
+                       const convert_16bit *self );
+
+  friend struct convert_16bit_kernels;
+
+  kernel_t _kernel;
+  const char *_name;
+
+  float _scale;
+};
+
+/*!
+ * \brief Converts separate 16 bit I and Q arrays to complex samples.
+ *
+ * For hardware delivering planar samples, like the SDRplay API. The
+ * conversion performed is out = (i + j q) * scale, interleaving and
+ * scaling in one pass. Kernels are selected the same way as for
+ * convert_8bit.
+ */
+class OSMOSDR_API convert_16bit_planar
+{
+public:
+  explicit convert_16bit_planar( float scale );
+
+  /*!
+   * Convert \p nsamples values of \p i and \p q into \p nsamples complex samples.
+   */
+  void operator()( const int16_t *i, const int16_t *q, gr_complex *out,
+                   size_t nsamples ) const
+  {
+    _kernel( i, q, (float *)out, nsamples, this );
+  }
+
+  /*! \return the name of the selected kernel, for informational purposes */
+  const char *name() const { return _name; }
+
+  typedef void (*kernel_t)( const int16_t *i, const int16_t *q, float *out,
+                            size_t nsamples, const convert_16bit_planar *self );
+
+private:
+  static void generic( const int16_t *i, const int16_t *q, float *out,
+                       size_t nsamples, const convert_16bit_planar *self );
+
+  friend struct convert_16bit_planar_kernels;
+
+  kernel_t _kernel;
+  const char *_name;
+
+  float _scale;
+};
+
+/*!
+ * \brief Converts packed little endian 24 bit IQ samples to floats.
+ *
+ * Each value takes 3 bytes, as delivered by the RFSPACE radios in 24 bit
+ * mode. The conversion performed is out = in * scale. Kernels (AVX2, SSSE3
+ * or NEON) are selected the same way as for convert_8bit.
+ */
+class OSMOSDR_API convert_24bit
+{
+public:
+  explicit convert_24bit( float scale );
+
+  /*!
+   * Convert \p count 24 bit values (3 * \p count bytes) into \p count floats.
+   */
+  void operator()( const void *in, float *out, size_t count ) const
+  {
+    _kernel( (const unsigned char *)in, out, count, this );
+  }
+
+  /*!
+   * Convert \p nsamples IQ pairs into \p nsamples complex samples.
+   */
+  void operator()( const void *in, gr_complex *out, size_t nsamples ) const
+  {
+    _kernel( (const unsigned char *)in, (float *)out, nsamples * 2, this );
+  }
+
+  /*! \return the name of the selected kernel, for informational purposes */
+  const char *name() const { return _name; }
+
+  typedef void (*kernel_t)( const unsigned char *in, float *out, size_t count,
+                            const convert_24bit *self );
+
+private:
+  static void generic( const unsigned char *in, float *out, size_t count,
+                       const convert_24bit *self );
+
+  friend struct convert_24bit_kernels;
+
+  kernel_t _kernel;
+  const char *_name;
+
+  float _scale;
+};
+
+/*!
+ * \brief Quantizes floats to interleaved 16 bit IQ samples.
+ *
+ * The conversion performed is out = round(clip(in * scale, -limit, limit)),
+ * which saturates instead of wrapping around for out of range input.
+ */
+class OSMOSDR_API convert_to_16bit
+{
+public:
+  convert_to_16bit( float scale, float limit = 32767.0f );
+
+  /*!
+   * Convert \p count floats into \p count 16 bit values.
+   */
+  void operator()( const float *in, int16_t *out, size_t count ) const
+  {
+    _kernel( in, out, count, this );
+  }
+
+  /*!
+   * Convert \p nsamples complex samples into \p nsamples IQ pairs.
+   */
+  void operator()( const gr_complex *in, int16_t *out, size_t nsamples ) const
+  {
+    _kernel( (const float *)in, out, nsamples * 2, this );
+  }
+
+  /*! \return the name of the selected kernel, for informational purposes */
+  const char *name() const { return _name; }
+
+  typedef void (*kernel_t)( const float *in, int16_t *out, size_t count,
+                            const convert_to_16bit *self );
+
+private:
+  static void generic( const float *in, int16_t *out, size_t count,
+                       const convert_to_16bit *self );
+
+  friend struct convert_16bit_kernels;
+
+  kernel_t _kernel;
+  const char *_name;
+
+  float _scale;
+  float _limit;
+};
+
+/*!
+ * \brief Quantizes floats to interleaved 8 bit IQ samples.
+ *
+ * Same as convert_to_16bit, but producing signed 8 bit (sc8) values.
+ */
+class OSMOSDR_API convert_to_8bit
+{
+public:
+  convert_to_8bit( float scale, float limit = 127.0f );
+
+  /*!
+   * Convert \p count floats into \p count 8 bit values.
+   */
+  void operator()( const float *in, int8_t *out, size_t count ) const
+  {
+    _kernel( in, out, count, this );
+  }
+
+  /*!
+   * Convert \p nsamples complex samples into \p nsamples IQ pairs.
+   */
+  void operator()( const gr_complex *in, int8_t *out, size_t nsamples ) const
+  {
+    _kernel( (const float *)in, out, nsamples * 2, this );
+  }
+
+  /*! \return the name of the selected kernel, for informational purposes */
+  const char *name() const { return _name; }
+
+  typedef void (*kernel_t)( const float *in, int8_t *out, size_t count,
+                            const convert_to_8bit *self );
+
+private:
+  static void generic( const float *in, int8_t *out, size_t count,
+                       const convert_to_8bit *self );
+
+  friend struct convert_to_8bit_kernels;
+
+  kernel_t _kernel;
+  const char *_name;
+
+  float _scale;
+  float _limit;
+};
+
+/*!
+ * \brief Removes a DC offset and corrects the IQ imbalance of complex samples.
+ *
+ * The correction performed is y = in - dc, out = y.re + j (a * y.re + b * y.im),
+ * which rotates and scales Q to be orthogonal to and as strong as I.
+ */
+class OSMOSDR_API correct_iq
+{
+public:
+  correct_iq();
+
+  void set( const gr_complex &dc, float a, float b )
+  {
+    _dc_re = dc.real();
+    _dc_im = dc.imag();
+    _a = a;
+    _b = b;
+  }
+
+  /*!
+   * Correct \p nsamples complex samples, \p in and \p out may be the same.
+   */
+  void operator()( const gr_complex *in, gr_complex *out, size_t nsamples ) const
+  {
+    _kernel( (const float *)in, (float *)out, nsamples, this );
+  }
+
+  /*!
+   * Correct \p nsamples complex samples and mix them with \p phasor, which
+   * is multiplied by \p step after each sample, in the same pass.
+   * \p in and \p out may be the same.
+   */
+  void operator()( const gr_complex *in, gr_complex *out, size_t nsamples,
+                   const gr_complex &phasor, const gr_complex &step ) const
+  {
+    _mix_kernel( (const float *)in, (float *)out, nsamples, this, phasor, step );
+  }
+
+  /*! \return the name of the selected kernel, for informational purposes */
+  const char *name() const { return _name; }
+
+  typedef void (*kernel_t)( const float *in, float *out, size_t nsamples,
+                            const correct_iq *self );
+  typedef void (*mix_kernel_t)( const float *in, float *out, size_t nsamples,
+                                const correct_iq *self,
+                                gr_complex phasor, gr_complex step );
+
+private:
+  static void generic( const float *in, float *out, size_t nsamples,
+                       const correct_iq *self );
+  static void generic_mix( const float *in, float *out, size_t nsamples,
+                           const correct_iq *self,
+                           gr_complex phasor, gr_complex step );
+
+  friend struct correct_iq_kernels;
+
+  kernel_t _kernel;
+  mix_kernel_t _mix_kernel;
+  const char *_name;
+
+  float _dc_re;
+  float _dc_im;
+  float _a;
+  float _b;
+};
+
+/*!
+ * \brief Allocates a buffer aligned for the vector kernels above.
+ *
+ * Buffers have to be released with convert_free().
+ */
+OSMOSDR_API void *convert_malloc( size_t size );
+OSMOSDR_API void convert_free( void *ptr );
+
+/*!
+ * \brief Turns \p count offset binary 8 bit values into two's complement.
+ *
+ * Used by 8 bit sources delivering native sc8 samples to the host.
+ */
+inline void offset_binary_to_sc8( const void *in, void *out, size_t count )
+{
+  const unsigned char *src = (const unsigned char *)in;
+  unsigned char *dst = (unsigned char *)out;
+
+  for (size_t i = 0; i < count; i++)
+    dst[i] = src[i] ^ 0x80;
+}
+
+#endif // OSMOSDR_SAMPLE_CONVERT_H
@@ -0,0 +1,281 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_SAMPLE_FIFO_H
+#define OSMOSDR_SAMPLE_FIFO_H
+
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread_time.hpp>
+
+/*!
+ * \brief Lock-free single producer / single consumer fifo of samples.
+ *
+ * Samples are kept in one contiguous array. Reads and writes are done in
+ * bulk with at most two memcpy calls, one for each side of the wrap point.
+ * The producer may also fill the fifo in place through write_ptr() and
+ * write_commit() to avoid an intermediate buffer when converting samples.
+ *
+ * Like transfer_ring, the mutex is only taken to park a starving consumer,
+ * or a producer waiting for free space in wait_free().
+ */
+template <typename T>
+class sample_fifo : boost::noncopyable
+{
+public:
+  explicit sample_fifo( size_t capacity )
+    : _buf( capacity ), _head(0), _tail(0),
+      _parked(false), _writer_parked(false), _cancelled(false)
+  {
+  }
+
+  size_t capacity() const { return _buf.size(); }
+
+  /*! Number of samples available to the consumer. */
+  size_t size() const
+  {
+    return _tail.load(boost::memory_order_acquire) -
+           _head.load(boost::memory_order_acquire);
+  }
+
+  /* producer side */
+
+  /*!
+   * Block until at least \p count samples may be written.
+   * \return false if the fifo has been cancelled while waiting
+   */
+  bool wait_free( size_t count )
+  {
+    while (capacity() - size() < count && !_cancelled.load()) {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      _writer_parked.store(true, boost::memory_order_seq_cst);
+
+      if (capacity() - size() < count && !_cancelled.load())
+        _cond.wait( lock );
+
+      _writer_parked.store(false, boost::memory_order_relaxed);
+    }
+
+    return !_cancelled.load();
+  }
+
+  /*!
+   * Get the contiguous free space available for writing.
+   * \param avail receives the number of samples that can be written
+   * \return pointer where the producer may write up to \p avail samples
+   */
+  T *write_ptr( size_t &avail )
+  {
+    const size_t tail = _tail.load(boost::memory_order_relaxed);
+    const size_t free = capacity() - (tail - _head.load(boost::memory_order_acquire));
+    const size_t pos = tail % capacity();
+
+    avail = std::min( free, capacity() - pos );
+
+    return &_buf[pos];
+  }
+
+  /*! Publish \p count samples written through write_ptr(). */
+  void write_commit( size_t count )
+  {
+    _tail.store(_tail.load(boost::memory_order_relaxed) + count,
+                boost::memory_order_seq_cst);
+
+    if (_parked.load(boost::memory_order_seq_cst))
+      notify();
+  }
+
+  /*!
+   * Copy up to \p count samples into the fifo.
+   * \return the number of samples written, less than count on overflow
+   */
+  size_t write( const T *src, size_t count )
+  {
+    size_t written = 0;
+
+    for (int seg = 0; seg < 2 && written < count; seg++) {
+      size_t avail;
+      T *dst = write_ptr( avail );
+
+      size_t n = std::min( avail, count - written );
+      if (n == 0)
+        break;
+
+      memcpy( dst, src + written, n * sizeof(T) );
+      written += n;
+
+      /* publish the first segment before computing the second one */
+      _tail.store(_tail.load(boost::memory_order_relaxed) + n,
+                  boost::memory_order_release);
+    }
+
+    write_commit( 0 );
+
+    return written;
+  }
+
+  /* consumer side */
+
+  /*!
+   * Get the contiguous range of samples available for reading.
+   * \param avail receives the number of samples that can be read
+   */
+  const T *read_ptr( size_t &avail ) const
+  {
+    const size_t head = _head.load(boost::memory_order_relaxed);
+    const size_t used = _tail.load(boost::memory_order_acquire) - head;
+    const size_t pos = head % capacity();
+
+    avail = std::min( used, capacity() - pos );
+
+    return &_buf[pos];
+  }
+
+  /*! Release \p count samples obtained through read_ptr(). */
+  void read_commit( size_t count )
+  {
+    _head.store(_head.load(boost::memory_order_relaxed) + count,
+                boost::memory_order_seq_cst);
+
+    if (_writer_parked.load(boost::memory_order_seq_cst))
+      notify();
+  }
+
+  /*!
+   * Copy up to \p count samples out of the fifo.
+   * \return the number of samples read
+   */
+  size_t read( T *dst, size_t count )
+  {
+    size_t done = 0;
+
+    for (int seg = 0; seg < 2 && done < count; seg++) {
+      size_t avail;
+      const T *src = read_ptr( avail );
+
+      size_t n = std::min( avail, count - done );
+      if (n == 0)
+        break;
+
+      memcpy( dst + done, src, n * sizeof(T) );
+      done += n;
+
+      read_commit( n );
+    }
+
+    return done;
+  }
+
+  /*!
+   * Block until at least \p count samples are available.
+   * \return false if the fifo has been cancelled while waiting
+   */
+  bool wait( size_t count )
+  {
+    while (size() < count && !_cancelled.load()) {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      _parked.store(true, boost::memory_order_seq_cst);
+
+      if (size() < count && !_cancelled.load())
+        _cond.wait( lock );
+
+      _parked.store(false, boost::memory_order_relaxed);
+    }
+
+    return !_cancelled.load();
+  }
+
+  /*!
+   * Block until at least \p count samples are available, at most for
+   * \p timeout, so the consumer gets to check whether it should stop.
+   * \return false if the fifo has been cancelled or the timeout expired
+   */
+  bool wait( size_t count, const boost::posix_time::time_duration &timeout )
+  {
+    const boost::system_time deadline = boost::get_system_time() + timeout;
+
+    while (size() < count && !_cancelled.load()) {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      _parked.store(true, boost::memory_order_seq_cst);
+
+      bool expired = false;
+      if (size() < count && !_cancelled.load())
+        expired = !_cond.timed_wait( lock, deadline );
+
+      _parked.store(false, boost::memory_order_relaxed);
+
+      if (expired)
+        break;
+    }
+
+    return size() >= count && !_cancelled.load();
+  }
+
+  /*! Drop all samples, must be called from the consumer side. */
+  void clear()
+  {
+    _head.store(_tail.load(boost::memory_order_acquire),
+                boost::memory_order_release);
+  }
+
+  /*! Wake up both sides and make any further wait() return false. */
+  void cancel()
+  {
+    _cancelled.store(true);
+    notify();
+  }
+
+  /*! Clear the cancelled state, keeping the queued samples. */
+  void resume()
+  {
+    _cancelled.store(false);
+  }
+
+  bool cancelled() const { return _cancelled.load(); }
+
+private:
+  void notify()
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _cond.notify_all();
+  }
+
+  std::vector<T> _buf;
+
+  boost::atomic<size_t> _head;
+  boost::atomic<size_t> _tail;
+  boost::atomic<bool> _parked;
+  boost::atomic<bool> _writer_parked;
+  boost::atomic<bool> _cancelled;
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+};
+
+#endif // OSMOSDR_SAMPLE_FIFO_H
@@ -30,15 +30,19 @@
 #endif
 
 #include "sdrplay_source_c.h"
+#include "backend_registry.h"
 #include <gnuradio/io_signature.h>
 #include "osmosdr/source.h"
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 #include <mirsdrapi-rsp.h>
@@ -79,6 +83,17 @@ using namespace boost::assign;
 
 #define SDRPLAY_MAX_BUF_SIZE 504
 
+#define SDRPLAY_RING_SAMPLES 4096 /* per buffer, 2 ms at the lowest rate */
+#define SDRPLAY_RING_BUFFERS 256  /* 100 ms at 10 Msps */
+
+#define SCALE_12 (1.0f/2048.0f)
+
+#ifdef LIBSDRPLAY_HAVE_API_V2
+#define SDRPLAY_SET_GR_MODE mir_sdr_USE_SET_GR
+#else
+#define SDRPLAY_SET_GR_MODE 0 /* useGrAltMode */
+#endif
+
 /*
  * Create a new instance of sdrplay_source_c and return
  * a boost shared_ptr.  This is effectively the public constructor.
@@ -89,6 +104,12 @@ make_sdrplay_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new sdrplay_source_c (args));
 }
 
+static source_registrar sdrplay_registrar(
+  "sdrplay",
+  &make_backend< source_iface, sdrplay_source_c_sptr, &make_sdrplay_source_c >,
+  &ignore_fake< &sdrplay_source_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_HW_DC_OFFSET, 60 );
+
 /*
  * Specify constraints on number of input and output streams.
  * This info is used to construct the input and output signatures
@@ -110,10 +131,24 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
   : gr::sync_block ("sdrplay_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _ring_fill(0),
+    _ring_offset(0),
+    _convert(SCALE_12),
     _running(false),
     _uninit(false),
     _auto_gain(false)
 {
+   dict_t dict = params_to_dict(args);
+
+   size_t num_buffers = SDRPLAY_RING_BUFFERS;
+   if (dict.count("buffers"))
+      num_buffers = boost::lexical_cast< size_t >( dict["buffers"] );
+
+   if (num_buffers < 2)
+      num_buffers = 2;
+
+   _ring.alloc(num_buffers, SDRPLAY_RING_SAMPLES * 2 * sizeof(short));
+
    _dev = (sdrplay_dev_t *)malloc(sizeof(sdrplay_dev_t));
    if (_dev == NULL)
    {
@@ -129,8 +164,8 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
    set_gain_limits(_dev->rfHz);
    _dev->gain_dB = _dev->maxGain - _dev->gRdB;
    
-   _bufi.reserve(SDRPLAY_MAX_BUF_SIZE);
-   _bufq.reserve(SDRPLAY_MAX_BUF_SIZE);   
+   _bufi.resize(SDRPLAY_MAX_BUF_SIZE);
+   _bufq.resize(SDRPLAY_MAX_BUF_SIZE);
 
    _buf_mutex.lock();
    _buf_offset = 0;
@@ -142,6 +177,8 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
  */
 sdrplay_source_c::~sdrplay_source_c ()
 {
+   stop(); /* the stream callback must not run anymore */
+
    free(_dev);
    _dev = NULL;
    _buf_mutex.lock();
@@ -158,6 +195,19 @@ void sdrplay_source_c::reinit_device()
    std::cerr << "reinit_device started" << std::endl;
    _buf_mutex.lock();
    std::cerr << "after mutex.lock" << std::endl;
+#ifdef LIBSDRPLAY_HAVE_STREAM_API
+   if (_running)
+   {
+      std::cerr << "mir_sdr_StreamUninit started" << std::endl;
+      mir_sdr_StreamUninit();
+   }
+
+   std::cerr << "mir_sdr_StreamInit started" << std::endl;
+   int gRdBsystem = 0;
+   mir_sdr_StreamInit(&_dev->gRdB, _dev->fsHz / 1e6, _dev->rfHz / 1e6, _dev->bwType, _dev->ifType,
+                      0, &gRdBsystem, SDRPLAY_SET_GR_MODE, &_dev->samplesPerPacket,
+                      &sdrplay_source_c::stream_callback, &sdrplay_source_c::gain_callback, this);
+#else
    if (_running)
    {
       std::cerr << "mir_sdr_Uninit started" << std::endl;
@@ -166,6 +216,7 @@ void sdrplay_source_c::reinit_device()
 
    std::cerr << "mir_sdr_Init started" << std::endl;
    mir_sdr_Init(_dev->gRdB, _dev->fsHz / 1e6, _dev->rfHz / 1e6, _dev->bwType, _dev->ifType, &_dev->samplesPerPacket);
+#endif
 
    if (_dev->dcMode)
    {
@@ -207,16 +258,82 @@ void sdrplay_source_c::set_gain_limits(double freq)
    }
 }
 
+#ifdef LIBSDRPLAY_HAVE_STREAM_API
+void sdrplay_source_c::stream_callback(short *xi, short *xq, unsigned int firstSampleNum,
+                                       int grChanged, int rfChanged, int fsChanged,
+                                       unsigned int numSamples, unsigned int reset,
+#ifdef LIBSDRPLAY_HAVE_API_V2
+                                       unsigned int hwRemoved,
+#endif
+                                       void *cbContext)
+{
+   ((sdrplay_source_c *)cbContext)->stream_samples(xi, xq, numSamples);
+}
+
+void sdrplay_source_c::gain_callback(unsigned int gRdB, unsigned int lnaGRdB, void *cbContext)
+{
+}
+
+/* Called from the API thread, collects the packets into ring buffers. */
+void sdrplay_source_c::stream_samples(const short *xi, const short *xq, unsigned int num)
+{
+   const size_t cap = _ring.len() / (2 * sizeof(short));
+
+   while (num)
+   {
+      /* a partially filled buffer is never lost, it hasn't been committed */
+      unsigned char *buf = _ring.acquire();
+      if (buf == NULL)
+      {
+         std::cerr << "O" << std::flush;
+         return;
+      }
+
+      short *bufi = (short *)buf;
+      short *bufq = bufi + cap;
+
+      size_t n = std::min(size_t(num), cap - _ring_fill);
+
+      memcpy(bufi + _ring_fill, xi, n * sizeof(short));
+      memcpy(bufq + _ring_fill, xq, n * sizeof(short));
+
+      _ring_fill += n;
+      xi += n;
+      xq += n;
+      num -= n;
+
+      if (_ring_fill == cap)
+      {
+         _ring.commit(_ring.len());
+         _ring_fill = 0;
+      }
+   }
+}
+#endif
+
+bool sdrplay_source_c::stop()
+{
+   _buf_mutex.lock();
+   if (_running)
+   {
+#ifdef LIBSDRPLAY_HAVE_STREAM_API
+      mir_sdr_StreamUninit();
+#else
+      mir_sdr_Uninit();
+#endif
+      _running = false;
+   }
+   _buf_mutex.unlock();
+
+   return true;
+}
+
 int sdrplay_source_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
    gr_complex *out = (gr_complex *)output_items[0];
-   int cnt = noutput_items;
-   unsigned int sampNum;
-   int grChanged;
-   int rfChanged;
-   int fsChanged;
+   int produced = 0;
 
    if (_uninit)
    {
@@ -229,40 +346,65 @@ int sdrplay_source_c::work( int noutput_items,
       _running = true;
    }
 
-   _buf_mutex.lock();
+#ifdef LIBSDRPLAY_HAVE_STREAM_API
+   if (!_ring.wait(1))
+   {
+      return WORK_DONE;
+   }
 
-   if (_buf_offset)
+   const size_t cap = _ring.len() / (2 * sizeof(short));
+   const unsigned char *buf;
+
+   while (produced < noutput_items && (buf = _ring.front()) != NULL)
    {
-      for (int i = _buf_offset; i < _dev->samplesPerPacket; i++)
+      const short *bufi = (const short *)buf;
+      const short *bufq = bufi + cap;
+
+      size_t n = std::min(cap - _ring_offset, size_t(noutput_items - produced));
+
+      _convert(bufi + _ring_offset, bufq + _ring_offset, out + produced, n);
+
+      produced += n;
+      _ring_offset += n;
+
+      if (_ring_offset == cap)
       {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
+         _ring.pop();
+         _ring_offset = 0;
       }
-      cnt -= (_dev->samplesPerPacket - _buf_offset);
    }
+#else
+   unsigned int sampNum;
+   int grChanged;
+   int rfChanged;
+   int fsChanged;
 
-   while ((cnt - _dev->samplesPerPacket) >= 0)
+   _buf_mutex.lock();
+
+   while (produced < noutput_items && _dev->samplesPerPacket > 0)
    {
-      mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum, &grChanged, &rfChanged, &fsChanged);
-      for (int i = 0; i < _dev->samplesPerPacket; i++)
+      if (_buf_offset == 0)
       {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
+         mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum, &grChanged, &rfChanged, &fsChanged);
       }
-      cnt -= _dev->samplesPerPacket;
-   }
 
-   _buf_offset = 0;
-   if (cnt)
-   {
-      mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum, &grChanged, &rfChanged, &fsChanged);
-      for (int i = 0; i < cnt; i++)
+      int n = std::min(_dev->samplesPerPacket - _buf_offset, noutput_items - produced);
+
+      _convert(&_bufi[_buf_offset], &_bufq[_buf_offset], out + produced, n);
+
+      produced += n;
+      _buf_offset += n;
+
+      if (_buf_offset >= _dev->samplesPerPacket)
       {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
+         _buf_offset = 0;
       }
-      _buf_offset = cnt;
    }
+
    _buf_mutex.unlock();
+#endif
 
-   return noutput_items;
+   return produced;
 }
 
 std::vector<std::string> sdrplay_source_c::get_devices()
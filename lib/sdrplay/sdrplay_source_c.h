@@ -30,6 +30,8 @@
 #include "osmosdr/ranges.h"
 
 #include "source_iface.h"
+#include "transfer_ring.h"
+#include "sample_convert.h"
 
 class sdrplay_source_c;
 typedef struct sdrplay_dev sdrplay_dev_t;
@@ -78,6 +80,8 @@ private:
 public:
    ~sdrplay_source_c ();	// public destructor
 
+   bool stop();
+
    int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -121,6 +125,19 @@ private:
    void reinit_device(void);
    void set_gain_limits(double freq);
 
+#ifdef LIBSDRPLAY_HAVE_STREAM_API
+   static void stream_callback(short *xi, short *xq, unsigned int firstSampleNum,
+                               int grChanged, int rfChanged, int fsChanged,
+                               unsigned int numSamples, unsigned int reset,
+#ifdef LIBSDRPLAY_HAVE_API_V2
+                               unsigned int hwRemoved,
+#endif
+                               void *cbContext);
+   static void gain_callback(unsigned int gRdB, unsigned int lnaGRdB, void *cbContext);
+
+   void stream_samples(const short *xi, const short *xq, unsigned int num);
+#endif
+
    sdrplay_dev_t *_dev;
 
    std::vector< short > _bufi;
@@ -128,6 +145,14 @@ private:
    int _buf_offset;
    boost::mutex _buf_mutex;
 
+   /* planar I/Q blocks from the stream callback, I in the first half of
+    * each buffer and Q in the second one */
+   transfer_ring _ring;
+   size_t _ring_fill;   /* samples in the buffer being filled by the callback */
+   size_t _ring_offset; /* samples of the front buffer consumed by work() */
+
+   convert_16bit_planar _convert;
+
    bool _running;
    bool _uninit;
    bool _auto_gain;
@@ -0,0 +1,369 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm_ring.h"
+
+#define OBJECT_PREFIX "osmosdr-"
+#define CONTROL_SUFFIX ".ctl"
+
+static std::string object_name( const std::string &name, bool control )
+{
+  if ( name.empty() || name.find( '/' ) != std::string::npos )
+    throw std::runtime_error( "shm: invalid name '" + name + "'" );
+
+  return "/" OBJECT_PREFIX + name + (control ? CONTROL_SUFFIX : "");
+}
+
+static void *map_object( const std::string &path, size_t size, int flags, mode_t mode,
+                         bool write, struct stat *info = NULL )
+{
+  int fd = shm_open( path.c_str(), flags, mode );
+  if ( fd < 0 )
+    return NULL;
+
+  /* the size requested by the creator, not reduced by the umask */
+  if ( (flags & O_CREAT) && (fchmod( fd, mode ) != 0 || ftruncate( fd, size ) != 0) ) {
+    ::close( fd );
+    return NULL;
+  }
+
+  struct stat st;
+  if ( fstat( fd, &st ) != 0 || size_t( st.st_size ) < size ) {
+    ::close( fd );
+    errno = EINVAL;
+    return NULL;
+  }
+
+  void *base = mmap( NULL, size, PROT_READ | (write ? PROT_WRITE : 0), MAP_SHARED, fd, 0 );
+  ::close( fd );
+
+  if ( info )
+    *info = st;
+
+  return MAP_FAILED == base ? NULL : base;
+}
+
+/*
+ * Whether the existing segment at \p path may be replaced, because it went
+ * away meanwhile, was closed or its publisher died. Otherwise \p owner
+ * tells who is holding it.
+ */
+static bool left_behind( const std::string &path, std::string &owner )
+{
+  void *base = map_object( path, SHM_DATA_OFFSET, O_RDONLY, 0, false );
+  if ( ! base ) {
+    owner = "a publisher starting up";
+    return ENOENT == errno;
+  }
+
+  const shm_header *header = (const shm_header *) base;
+
+  bool valid = (SHM_MAGIC == header->magic);
+  boost::atomic_thread_fence( boost::memory_order_acquire );
+  valid = valid && SHM_VERSION == header->version;
+
+  bool stale = false;
+
+  if ( ! valid )
+    owner = "a publisher starting up or of another version";
+  else if ( SHM_CLOSED == header->state )
+    stale = true;
+  else if ( kill( header->pid, 0 ) != 0 && ESRCH == errno )
+    stale = true;
+  else
+    owner = "process " + boost::lexical_cast< std::string >( header->pid );
+
+  munmap( base, SHM_DATA_OFFSET );
+
+  return stale;
+}
+
+shm_ring::shm_ring( const std::string &name, size_t ring_size, bool control ) :
+  _name( name ),
+  _owner( true ),
+  _base( NULL ),
+  _size( SHM_DATA_OFFSET + ring_size * sizeof(gr_complex) ),
+  _header( NULL ),
+  _data( NULL ),
+  _control( NULL ),
+  _dev( 0 ),
+  _ino( 0 )
+{
+  const std::string path = object_name( name, false );
+  const std::string ctl_path = object_name( name, true );
+  struct stat st;
+
+  /* anybody may listen, only the owner may tune */
+  const int flags = O_RDWR | O_CREAT | O_EXCL;
+  const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+
+  _base = map_object( path, _size, flags, mode, true, &st );
+
+  if ( ! _base && EEXIST == errno ) {
+    std::string owner;
+
+    if ( ! left_behind( path, owner ) )
+      throw std::runtime_error( "shm: " + path + " is in use by " + owner );
+
+    shm_unlink( path.c_str() );
+    _base = map_object( path, _size, flags, mode, true, &st );
+  }
+
+  if ( ! _base )
+    throw std::runtime_error( "shm: can't create " + path + ": " + strerror( errno ) );
+
+  _dev = st.st_dev;
+  _ino = st.st_ino;
+
+  if ( control ) {
+    /* the name is ours now, so is a control segment left behind */
+    shm_unlink( ctl_path.c_str() );
+
+    void *ctl = map_object( ctl_path, sizeof(shm_control), O_RDWR | O_CREAT | O_EXCL,
+                            S_IRUSR | S_IWUSR, true );
+    if ( ! ctl ) {
+      std::string err = strerror( errno );
+      munmap( _base, _size );
+      shm_unlink( path.c_str() );
+      throw std::runtime_error( "shm: can't create " + ctl_path + ": " + err );
+    }
+
+    _control = new (ctl) shm_control;
+    for (size_t i = 0; i < SHM_REQ_COUNT; i++) {
+      _control->req[i].value = 0;
+      _control->req[i].gen = 0;
+    }
+    _control->magic = SHM_MAGIC;
+  }
+
+  _header = new (_base) shm_header;
+  _header->version = SHM_VERSION;
+  _header->ring_size = ring_size;
+  _header->item_size = sizeof(gr_complex);
+  _header->pid = getpid();
+  _header->state = SHM_STOPPED;
+  _header->reserved = 0;
+  _header->head = 0;
+  _header->seq = 0;
+  memset( &_header->meta, 0, sizeof(_header->meta) );
+
+  _data = (gr_complex *)( (char *) _base + SHM_DATA_OFFSET );
+
+  /* subscribers opening the segment check the magic last */
+  boost::atomic_thread_fence( boost::memory_order_release );
+  _header->magic = SHM_MAGIC;
+}
+
+shm_ring::shm_ring( const std::string &name ) :
+  _name( name ),
+  _owner( false ),
+  _base( NULL ),
+  _size( SHM_DATA_OFFSET ),
+  _header( NULL ),
+  _data( NULL ),
+  _control( NULL ),
+  _dev( 0 ),
+  _ino( 0 )
+{
+  const std::string path = object_name( name, false );
+  struct stat st;
+
+  /* the header tells how large the ring is */
+  void *base = map_object( path, SHM_DATA_OFFSET, O_RDONLY, 0, false );
+  if ( ! base )
+    throw std::runtime_error( "shm: no publisher " + path + ": " + strerror( errno ) );
+
+  const shm_header *header = (const shm_header *) base;
+
+  bool valid = (SHM_MAGIC == header->magic);
+  boost::atomic_thread_fence( boost::memory_order_acquire );
+  valid = valid && SHM_VERSION == header->version &&
+          sizeof(gr_complex) == header->item_size;
+
+  const size_t ring_size = header->ring_size;
+  munmap( base, SHM_DATA_OFFSET );
+
+  if ( ! valid )
+    throw std::runtime_error( "shm: " + path + " isn't a compatible publisher" );
+
+  _size = SHM_DATA_OFFSET + ring_size * sizeof(gr_complex);
+  _base = map_object( path, _size, O_RDONLY, 0, false, &st );
+  if ( ! _base )
+    throw std::runtime_error( "shm: can't map " + path + ": " + strerror( errno ) );
+
+  _header = (shm_header *) _base;
+  _data = (gr_complex *)( (char *) _base + SHM_DATA_OFFSET );
+  _dev = st.st_dev;
+  _ino = st.st_ino;
+
+  /* a missing control segment just means the publisher can't be tuned */
+  void *ctl = map_object( object_name( name, true ), sizeof(shm_control), O_RDWR, 0, true );
+  if ( ctl ) {
+    _control = (shm_control *) ctl;
+    if ( SHM_MAGIC != _control->magic ) {
+      munmap( ctl, sizeof(shm_control) );
+      _control = NULL;
+    }
+  }
+}
+
+shm_ring::~shm_ring()
+{
+  /* unless a new publisher replaced the segment after it was closed */
+  if ( _owner ) {
+    _header->state = SHM_CLOSED;
+
+    if ( ! stale() ) {
+      shm_unlink( object_name( _name, false ).c_str() );
+      if ( _control )
+        shm_unlink( object_name( _name, true ).c_str() );
+    }
+  }
+
+  if ( _control )
+    munmap( _control, sizeof(shm_control) );
+
+  munmap( _base, _size );
+}
+
+void shm_ring::write_meta( const shm_meta &meta )
+{
+  const uint32_t seq = _header->seq.load( boost::memory_order_relaxed );
+
+  _header->seq.store( seq + 1, boost::memory_order_relaxed );
+  boost::atomic_thread_fence( boost::memory_order_release );
+
+  _header->meta = meta;
+
+  _header->seq.store( seq + 2, boost::memory_order_release );
+}
+
+shm_meta shm_ring::read_meta( uint32_t *seq ) const
+{
+  shm_meta meta;
+  uint32_t before, after;
+
+  do {
+    before = _header->seq.load( boost::memory_order_acquire );
+
+    meta = _header->meta;
+
+    boost::atomic_thread_fence( boost::memory_order_acquire );
+    after = _header->seq.load( boost::memory_order_relaxed );
+  } while ( (before & 1) || before != after );
+
+  if ( seq )
+    *seq = before;
+
+  return meta;
+}
+
+bool shm_ring::request( shm_request_t what, double value )
+{
+  if ( ! _control )
+    return false;
+
+  uint64_t bits;
+  memcpy( &bits, &value, sizeof(bits) );
+
+  _control->req[what].value.store( bits, boost::memory_order_relaxed );
+  _control->req[what].gen.fetch_add( 1, boost::memory_order_release );
+
+  return true;
+}
+
+bool shm_ring::poll_request( shm_request_t what, uint32_t &gen, double &value ) const
+{
+  if ( ! _control )
+    return false;
+
+  const uint32_t current = _control->req[what].gen.load( boost::memory_order_acquire );
+  if ( current == gen )
+    return false;
+
+  /* a request racing with us bumps gen again and is picked up next time */
+  const uint64_t bits = _control->req[what].value.load( boost::memory_order_relaxed );
+  memcpy( &value, &bits, sizeof(value) );
+  gen = current;
+
+  return true;
+}
+
+bool shm_ring::stale() const
+{
+  int fd = shm_open( object_name( _name, false ).c_str(), O_RDONLY, 0 );
+  if ( fd < 0 )
+    return true;
+
+  struct stat st;
+  bool same = (fstat( fd, &st ) == 0 && st.st_dev == _dev && st.st_ino == _ino);
+  ::close( fd );
+
+  return ! same;
+}
+
+std::vector< std::string > shm_ring::list()
+{
+  std::vector< std::string > names;
+
+#ifdef __linux__
+  /* where glibc keeps the POSIX shared memory objects */
+  DIR *d = opendir( "/dev/shm" );
+  if ( ! d )
+    return names;
+
+  const std::string prefix = OBJECT_PREFIX, suffix = CONTROL_SUFFIX;
+
+  struct dirent *entry;
+  while ( (entry = readdir( d )) != NULL ) {
+    std::string name = entry->d_name;
+
+    if ( name.compare( 0, prefix.size(), prefix ) != 0 )
+      continue;
+    if ( name.size() > suffix.size() &&
+         0 == name.compare( name.size() - suffix.size(), suffix.size(), suffix ) )
+      continue;
+
+    names.push_back( name.substr( prefix.size() ) );
+  }
+
+  closedir( d );
+#endif
+
+  return names;
+}
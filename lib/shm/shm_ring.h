@@ -0,0 +1,178 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SHM_RING_H
+#define INCLUDED_SHM_RING_H
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <gnuradio/gr_complex.h>
+
+/*
+ * The shared memory segment of a shm= publisher, named /osmosdr-<name>.
+ *
+ * It starts with a page holding shm_header, followed by a ring of
+ * ring_size samples. The publisher is the only writer, subscribers map
+ * the segment read-only, so the ring positions and the seqlock are read
+ * with plain 64 bit loads and never locked.
+ *
+ * The publisher announces the end of its next write in reserved before
+ * writing into the ring, and moves head once it is done. A subscriber
+ * copying from position pos knows its copy is intact if reserved hasn't
+ * got further than ring_size past pos by the time the copy finished.
+ *
+ * With control=true the publisher also creates /osmosdr-<name>.ctl,
+ * writable by the subscribers, through which they ask for new settings.
+ *
+ * A new publisher only replaces a segment of the same name once it is
+ * closed, or the process in pid has gone away without closing it.
+ */
+
+#define SHM_MAGIC       0x4d485352 /* "RSHM" */
+#define SHM_VERSION     2
+#define SHM_DATA_OFFSET 4096       /* the ring starts at the second page */
+
+enum shm_state_t
+{
+  SHM_STOPPED = 0,  /* the publisher's flowgraph isn't running */
+  SHM_RUNNING,
+  SHM_CLOSED        /* the publisher is gone, the segment unlinked */
+};
+
+/* the stream settings from sample offset on, kept under the seqlock */
+struct shm_meta
+{
+  uint64_t offset;     /* ring position they took effect at */
+  int64_t time_secs;   /* rx_time of that sample */
+  double time_frac;
+  double rate;
+  double freq;
+  double gain;
+};
+
+struct shm_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t ring_size;                  /* in samples */
+  uint32_t item_size;
+  int32_t pid;                         /* of the publisher */
+
+  boost::atomic< uint32_t > state;     /* shm_state_t */
+  boost::atomic< uint64_t > reserved;  /* end of the samples being written */
+  boost::atomic< uint64_t > head;      /* samples written so far */
+
+  boost::atomic< uint32_t > seq;       /* odd while meta is written */
+  shm_meta meta;
+};
+
+enum shm_request_t
+{
+  SHM_REQ_FREQ = 0,
+  SHM_REQ_RATE,
+  SHM_REQ_GAIN,
+  SHM_REQ_PPM,
+  SHM_REQ_COUNT
+};
+
+/* the last value asked for wins, gen tells the publisher it changed */
+struct shm_request
+{
+  boost::atomic< uint64_t > value;     /* bits of a double */
+  boost::atomic< uint32_t > gen;
+};
+
+struct shm_control
+{
+  uint32_t magic;
+  shm_request req[SHM_REQ_COUNT];
+};
+
+class shm_ring : boost::noncopyable
+{
+public:
+  /*!
+   * Create the segment of a publisher, replacing a stale one left behind
+   * by a publisher which didn't exit cleanly.
+   * \throws std::runtime_error if another publisher is using the name
+   */
+  shm_ring( const std::string &name, size_t ring_size, bool control );
+
+  /*!
+   * Map the segment of a running publisher read-only, and its control
+   * segment for writing if there is one and we're allowed to.
+   */
+  explicit shm_ring( const std::string &name );
+
+  /*! Unmaps the segment, the publisher marks it closed and unlinks it. */
+  ~shm_ring();
+
+  shm_header *header() const { return _header; }
+  gr_complex *data() const { return _data; }
+  size_t ring_size() const { return _header->ring_size; }
+  bool has_control() const { return _control != NULL; }
+
+  /*! Publisher side, update the settings under the seqlock. */
+  void write_meta( const shm_meta &meta );
+
+  /*! Read a consistent copy of the settings, \p seq changes with them. */
+  shm_meta read_meta( uint32_t *seq = NULL ) const;
+
+  /*!
+   * Subscriber side, ask the publisher for a new setting.
+   * \return false without a control segment
+   */
+  bool request( shm_request_t what, double value );
+
+  /*!
+   * Publisher side, pick up a setting asked for since \p gen.
+   * \return true if \p value is new
+   */
+  bool poll_request( shm_request_t what, uint32_t &gen, double &value ) const;
+
+  /*!
+   * Subscriber side, the segment has been unlinked or replaced by a new
+   * publisher, which a crashed publisher doesn't tell by closing it.
+   */
+  bool stale() const;
+
+  /*! The names of the publishers on this machine. */
+  static std::vector< std::string > list();
+
+private:
+  std::string _name;
+  bool _owner;
+
+  void *_base;
+  size_t _size;
+  shm_header *_header;
+  gr_complex *_data;
+  shm_control *_control;
+
+  dev_t _dev;  /* identify the object mapped */
+  ino_t _ino;
+};
+
+#endif /* INCLUDED_SHM_RING_H */
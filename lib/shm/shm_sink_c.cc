@@ -0,0 +1,383 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/high_res_timer.h>
+
+#include "shm_sink_c.h"
+#include "backend_registry.h"
+#include "stream_tags.h"
+#include "arg_helpers.h"
+
+#define DEFAULT_NAME "osmosdr"
+#define RING_SIZE    (4 * 1024 * 1024) /* samples, 32 MiB */
+
+shm_sink_c_sptr make_shm_sink_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr( new shm_sink_c( args ) );
+}
+
+static sink_registrar shm_registrar(
+  "shm",
+  &make_backend< sink_iface, shm_sink_c_sptr, &make_shm_sink_c >,
+  &shm_sink_c::get_devices,
+  0, BACKEND_ORDER_SOFTWARE + 50 );
+
+/* for publishers fed by sources without rx_time tags */
+static ::osmosdr::time_spec_t host_time()
+{
+  const gr::high_res_timer_type now = gr::high_res_timer_now();
+  const gr::high_res_timer_type tps = gr::high_res_timer_tps();
+
+  return ::osmosdr::time_spec_t( time_t( now / tps ), double( now % tps ) / tps );
+}
+
+shm_sink_c::shm_sink_c( const std::string &args ) :
+  gr::sync_block( "shm_sink_c",
+                  gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+                  gr::io_signature::make( 0, 0, 0 ) ),
+  _head( 0 ),
+  _corr( 0 ),
+  _timed( false )
+{
+  dict_t dict = params_to_dict( args );
+
+  std::string name = dict["shm"];
+  if ( name.empty() )
+    name = DEFAULT_NAME;
+
+  size_t ring_size = RING_SIZE;
+  if ( dict.count( "ring_size" ) )
+    ring_size = boost::lexical_cast< size_t >( dict["ring_size"] );
+
+  bool control = false;
+  if ( dict.count( "control" ) )
+    control = ("true" == dict["control"] ? true : false);
+
+  memset( &_meta, 0, sizeof(_meta) );
+
+  if ( dict.count( "rate" ) )
+    _meta.rate = boost::lexical_cast< double >( dict["rate"] );
+
+  if ( dict.count( "freq" ) )
+    _meta.freq = boost::lexical_cast< double >( dict["freq"] );
+
+  for (size_t i = 0; i < SHM_REQ_COUNT; i++)
+    _gen[i] = 0;
+
+  ring_size = std::max( ring_size, size_t(64 * 1024) );
+
+  /* an eighth of the ring per work() at most, subscribers are skipped
+   * ahead once they get within that of being overwritten */
+  set_max_noutput_items( ring_size / 8 );
+
+  if ( control )
+    message_port_register_out( SINK_COMMAND_PORT );
+
+  _ring.reset( new shm_ring( name, ring_size, control ) );
+  _ring->write_meta( _meta );
+
+  std::cerr << "Publishing to shared memory " << name << " with a ring of "
+            << ring_size << " samples" << (control ? ", tunable" : "") << "."
+            << std::endl;
+}
+
+shm_sink_c::~shm_sink_c()
+{
+  stop();
+}
+
+bool shm_sink_c::start()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* the subscribers extrapolate the host time from here on */
+  if ( ! _timed ) {
+    ::osmosdr::time_spec_t now = host_time();
+    update_meta( _head, &now );
+    _ring->write_meta( _meta );
+  }
+
+  _ring->header()->state = SHM_RUNNING;
+
+  return true;
+}
+
+bool shm_sink_c::stop()
+{
+  _ring->header()->state = SHM_STOPPED;
+
+  return true;
+}
+
+/*
+ * Move the settings to \p offset, before changing them there. Without a
+ * \p time it is extrapolated from the previous one.
+ */
+void shm_sink_c::update_meta( uint64_t offset, const ::osmosdr::time_spec_t *time )
+{
+  ::osmosdr::time_spec_t t;
+
+  if ( time )
+    t = *time;
+  else if ( _meta.rate > 0 )
+    t = ::osmosdr::time_spec_t( time_t( _meta.time_secs ), _meta.time_frac ) +
+        ::osmosdr::time_spec_t( double( int64_t( offset - _meta.offset ) ) / _meta.rate );
+  else
+    t = ::osmosdr::time_spec_t( time_t( _meta.time_secs ), _meta.time_frac );
+
+  _meta.offset = offset;
+  _meta.time_secs = t.get_full_secs();
+  _meta.time_frac = t.get_frac_secs();
+}
+
+void shm_sink_c::handle_tags( int noutput_items )
+{
+  std::vector< gr::tag_t > tags;
+
+  get_tags_in_range( tags, 0, nitems_read(0), nitems_read(0) + noutput_items );
+  if ( tags.empty() )
+    return;
+
+  std::sort( tags.begin(), tags.end(), gr::tag_t::offset_compare );
+
+  boost::mutex::scoped_lock lock( _mutex );
+  bool changed = false;
+
+  BOOST_FOREACH( const gr::tag_t &tag, tags ) {
+    const uint64_t pos = _head + (tag.offset - nitems_read(0));
+
+    if ( pmt::eqv( tag.key, RX_TIME_KEY ) ) {
+      ::osmosdr::time_spec_t time = tag_to_time( tag.value );
+      update_meta( pos, &time );
+      _timed = true;
+    } else if ( pmt::eqv( tag.key, RX_RATE_KEY ) ) {
+      update_meta( pos, NULL );
+      _meta.rate = pmt::to_double( tag.value );
+    } else if ( pmt::eqv( tag.key, RX_FREQ_KEY ) ) {
+      update_meta( pos, NULL );
+      _meta.freq = pmt::to_double( tag.value );
+    } else {
+      continue;
+    }
+
+    changed = true;
+  }
+
+  /* the subscribers get the latest only, which is what they tag */
+  if ( changed )
+    _ring->write_meta( _meta );
+}
+
+void shm_sink_c::poll_requests()
+{
+  static const char *keys[SHM_REQ_COUNT] = { "freq", "rate", "gain", "ppm" };
+
+  for (size_t i = 0; i < SHM_REQ_COUNT; i++) {
+    double value;
+
+    if ( ! _ring->poll_request( shm_request_t( i ), _gen[i], value ) )
+      continue;
+
+    pmt::pmt_t command = pmt::make_dict();
+    command = pmt::dict_add( command, pmt::string_to_symbol( keys[i] ),
+                             pmt::from_double( value ) );
+
+    message_port_pub( SINK_COMMAND_PORT, command );
+  }
+}
+
+int shm_sink_c::work( int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  shm_header *header = _ring->header();
+  const size_t ring_size = _ring->ring_size();
+
+  /* announced before the first sample is overwritten */
+  header->reserved.store( _head + noutput_items, boost::memory_order_relaxed );
+  boost::atomic_thread_fence( boost::memory_order_seq_cst );
+
+  for (size_t done = 0; done < size_t(noutput_items); ) {
+    const size_t offset = (_head + done) % ring_size;
+    const size_t n = std::min( noutput_items - done, ring_size - offset );
+
+    memcpy( _ring->data() + offset, in + done, n * sizeof(gr_complex) );
+    done += n;
+  }
+
+  handle_tags( noutput_items );
+
+  _head += noutput_items;
+  header->head.store( _head, boost::memory_order_release );
+
+  if ( _ring->has_control() )
+    poll_requests();
+
+  return noutput_items;
+}
+
+std::vector< std::string > shm_sink_c::get_devices( bool fake )
+{
+  std::vector< std::string > devices;
+
+  if ( fake )
+    devices.push_back( "shm=" DEFAULT_NAME ",control=false,label='Shared Memory Publisher'" );
+
+  return devices;
+}
+
+size_t shm_sink_c::get_num_channels( void )
+{
+  return 1;
+}
+
+osmosdr::meta_range_t shm_sink_c::get_sample_rates( void )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* whatever the flowgraph delivers */
+  return osmosdr::meta_range_t( _meta.rate, _meta.rate );
+}
+
+double shm_sink_c::set_sample_rate( double rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  update_meta( _ring->header()->head, NULL );
+  _meta.rate = rate;
+  _ring->write_meta( _meta );
+
+  return _meta.rate;
+}
+
+double shm_sink_c::get_sample_rate( void )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _meta.rate;
+}
+
+osmosdr::freq_range_t shm_sink_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( 0, 100e9 );
+}
+
+double shm_sink_c::set_center_freq( double freq, size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  update_meta( _ring->header()->head, NULL );
+  _meta.freq = freq;
+  _ring->write_meta( _meta );
+
+  return _meta.freq;
+}
+
+double shm_sink_c::get_center_freq( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _meta.freq;
+}
+
+double shm_sink_c::set_freq_corr( double ppm, size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _corr = ppm;
+}
+
+double shm_sink_c::get_freq_corr( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _corr;
+}
+
+std::vector<std::string> shm_sink_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >( 1, "LNA" );
+}
+
+osmosdr::gain_range_t shm_sink_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t( -100, 100, 0.1 );
+}
+
+osmosdr::gain_range_t shm_sink_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double shm_sink_c::set_gain( double gain, size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  update_meta( _ring->header()->head, NULL );
+  _meta.gain = gain;
+  _ring->write_meta( _meta );
+
+  return _meta.gain;
+}
+
+double shm_sink_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double shm_sink_c::get_gain( size_t chan )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _meta.gain;
+}
+
+double shm_sink_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > shm_sink_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, get_antenna( chan ) );
+}
+
+std::string shm_sink_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string shm_sink_c::get_antenna( size_t chan )
+{
+  return "SHM";
+}
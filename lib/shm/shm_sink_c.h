@@ -0,0 +1,113 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SHM_SINK_C_H
+#define INCLUDED_SHM_SINK_C_H
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/sync_block.h>
+
+#include "sink_iface.h"
+#include "shm_ring.h"
+
+class shm_sink_c;
+
+typedef boost::shared_ptr< shm_sink_c > shm_sink_c_sptr;
+
+shm_sink_c_sptr make_shm_sink_c( const std::string &args = "" );
+
+/*!
+ * \brief Publishes the samples in shared memory, for shm= sources in
+ * other processes on the same machine.
+ *
+ * The samples are written once into the ring of the segment (see
+ * shm_ring.h), from which every subscriber copies them straight into its
+ * output buffer. The publisher never waits for its subscribers, one
+ * falling behind by more than the ring skips ahead to the latest samples.
+ *
+ * The rate, frequency and gain set on the sink, or given by the rx_rate,
+ * rx_freq and rx_time tags of the stream, are published along with the
+ * samples. With control=true the settings asked for by the subscribers
+ * are published on the command message port, ready to be connected to
+ * the command port of the receiver.
+ */
+class shm_sink_c :
+    public gr::sync_block,
+    public sink_iface
+{
+private:
+  friend shm_sink_c_sptr make_shm_sink_c( const std::string &args );
+
+  shm_sink_c( const std::string &args );
+
+public:
+  ~shm_sink_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+private:
+  void update_meta( uint64_t offset, const ::osmosdr::time_spec_t *time );
+  void handle_tags( int noutput_items );
+  void poll_requests();
+
+  boost::scoped_ptr< shm_ring > _ring;
+  uint64_t _head;        /* of work() only */
+
+  boost::mutex _mutex;   /* settings and meta */
+  shm_meta _meta;
+  double _corr;
+  bool _timed;           /* seen an rx_time tag, else stamped with host time */
+
+  uint32_t _gen[SHM_REQ_COUNT]; /* of the requests handled */
+};
+
+#endif /* INCLUDED_SHM_SINK_C_H */
@@ -0,0 +1,356 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "shm_source_c.h"
+#include "backend_registry.h"
+#include "stream_tags.h"
+#include "arg_helpers.h"
+
+#define DEFAULT_NAME  "osmosdr"
+#define POLL_INTERVAL 500 /* us between looks at an idle ring */
+#define STALE_CHECK   1   /* seconds idle before checking for a new publisher */
+
+shm_source_c_sptr make_shm_source_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr( new shm_source_c( args ) );
+}
+
+static source_registrar shm_registrar(
+  "shm",
+  &make_backend< source_iface, shm_source_c_sptr, &make_shm_source_c >,
+  &shm_source_c::get_devices,
+  0, BACKEND_ORDER_SOFTWARE + 50 );
+
+/* The time of the sample at ring position \p pos. */
+static ::osmosdr::time_spec_t time_at( const shm_meta &meta, uint64_t pos )
+{
+  ::osmosdr::time_spec_t time( time_t( meta.time_secs ), meta.time_frac );
+
+  if ( meta.rate > 0 )
+    time += ::osmosdr::time_spec_t( double( int64_t( pos - meta.offset ) ) / meta.rate );
+
+  return time;
+}
+
+shm_source_c::shm_source_c( const std::string &args ) :
+  gr::sync_block( "shm_source_c",
+                  gr::io_signature::make( 0, 0, 0 ),
+                  gr::io_signature::make( 1, 1, sizeof(gr_complex) ) ),
+  _pos( 0 ),
+  _seq( 0 ),
+  _retag( true ),
+  _idle_since( 0 ),
+  _warned( false ),
+  _corr( 0 )
+{
+  dict_t dict = params_to_dict( args );
+
+  _name = dict["shm"];
+  if ( _name.empty() )
+    _name = DEFAULT_NAME;
+
+  _ring.reset( new shm_ring( _name ) );
+
+  std::cerr << "Subscribed to shared memory " << _name << " with a ring of "
+            << _ring->ring_size() << " samples"
+            << (_ring->has_control() ? ", tunable" : "") << "." << std::endl;
+
+  message_port_register_out( STREAM_STATS_PORT );
+}
+
+shm_source_c::~shm_source_c()
+{
+}
+
+bool shm_source_c::start()
+{
+  /* join live, the rest of the ring is history */
+  _pos = _ring->header()->head.load( boost::memory_order_acquire );
+  _retag = true;
+  _idle_since = 0;
+
+  return true;
+}
+
+bool shm_source_c::stop()
+{
+  return true;
+}
+
+/*
+ * Wait a moment for the publisher to write more.
+ * \return false once the publisher is gone
+ */
+bool shm_source_c::wait_for_data()
+{
+  if ( SHM_CLOSED == _ring->header()->state ) {
+    std::cerr << "The shm publisher " << _name << " has been closed." << std::endl;
+    return false;
+  }
+
+  const gr::high_res_timer_type now = gr::high_res_timer_now();
+
+  if ( ! _idle_since ) {
+    _idle_since = now;
+  } else if ( now - _idle_since > STALE_CHECK * gr::high_res_timer_tps() ) {
+    if ( _ring->stale() ) {
+      std::cerr << "The shm publisher " << _name << " has gone away." << std::endl;
+      return false;
+    }
+
+    _idle_since = now;
+  }
+
+  boost::this_thread::sleep( boost::posix_time::microseconds( POLL_INTERVAL ) );
+
+  return true;
+}
+
+void shm_source_c::skip_to( uint64_t pos )
+{
+  _stats.overflow( pos - _pos );
+  _pos = pos;
+  _retag = true;
+}
+
+void shm_source_c::tag_at( uint64_t pos, const shm_meta &meta )
+{
+  std::vector< gr::tag_t > tags = make_rx_tags( nitems_written( 0 ) + (pos - _pos),
+                                                time_at( meta, pos ),
+                                                meta.rate, meta.freq, alias() );
+
+  BOOST_FOREACH( const gr::tag_t &tag, tags )
+    add_item_tag( 0, tag );
+}
+
+int shm_source_c::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *) output_items[0];
+  const shm_header *header = _ring->header();
+  const size_t ring_size = _ring->ring_size();
+
+  const uint64_t head = header->head.load( boost::memory_order_acquire );
+
+  if ( head == _pos )
+    return wait_for_data() ? 0 : WORK_DONE;
+
+  _idle_since = 0;
+
+  /* the publisher writes up to an eighth of the ring at once, what is
+   * that close to being overwritten is given up, along with some more */
+  if ( head - _pos > ring_size - ring_size / 8 )
+    skip_to( head - ring_size / 2 );
+
+  _stats.fill( head - _pos, ring_size );
+
+  const size_t n = std::min( size_t(noutput_items), size_t(head - _pos) );
+
+  for (size_t done = 0; done < n; ) {
+    const size_t offset = (_pos + done) % ring_size;
+    const size_t len = std::min( n - done, ring_size - offset );
+
+    memcpy( out + done, _ring->data() + offset, len * sizeof(gr_complex) );
+    done += len;
+  }
+
+  /* torn by a write which got around the ring while we copied */
+  boost::atomic_thread_fence( boost::memory_order_acquire );
+  const uint64_t reserved = header->reserved.load( boost::memory_order_relaxed );
+
+  if ( reserved > _pos + ring_size ) {
+    skip_to( std::max( head, reserved - ring_size / 2 ) );
+    return 0;
+  }
+
+  uint32_t seq;
+  const shm_meta meta = _ring->read_meta( &seq );
+
+  /* settings changed within this chunk apply from where they changed,
+   * those of samples we haven't got to yet are tagged when we do */
+  if ( seq != _seq && meta.offset < _pos + n ) {
+    tag_at( std::max( meta.offset, _pos ), meta );
+    _seq = seq;
+    _retag = false;
+  } else if ( _retag ) {
+    tag_at( _pos, meta );
+    _retag = false;
+  }
+
+  _pos += n;
+
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
+  return n;
+}
+
+std::vector< std::string > shm_source_c::get_devices( bool fake )
+{
+  std::vector< std::string > devices;
+
+  BOOST_FOREACH( const std::string &name, shm_ring::list() )
+    devices.push_back( "shm=" + name + ",label='Shared Memory " + name + "'" );
+
+  return devices;
+}
+
+size_t shm_source_c::get_num_channels()
+{
+  return 1;
+}
+
+/*
+ * Ask the publisher for a new setting, unless it has it already.
+ * \return the setting asked for, or the current one if nothing was asked
+ */
+double shm_source_c::request( shm_request_t what, double value, double current )
+{
+  if ( value == current )
+    return current;
+
+  if ( _ring->request( what, value ) )
+    return value;
+
+  if ( ! _warned ) {
+    std::cerr << "The shm publisher " << _name << " can't be tuned, "
+              << "create it with control=true." << std::endl;
+    _warned = true;
+  }
+
+  return current;
+}
+
+osmosdr::meta_range_t shm_source_c::get_sample_rates()
+{
+  const double rate = get_sample_rate();
+
+  return osmosdr::meta_range_t( rate, rate );
+}
+
+double shm_source_c::set_sample_rate( double rate )
+{
+  return request( SHM_REQ_RATE, rate, get_sample_rate() );
+}
+
+double shm_source_c::get_sample_rate()
+{
+  return _ring->read_meta().rate;
+}
+
+osmosdr::freq_range_t shm_source_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( 0, 100e9 );
+}
+
+double shm_source_c::set_center_freq( double freq, size_t chan )
+{
+  return request( SHM_REQ_FREQ, freq, get_center_freq( chan ) );
+}
+
+double shm_source_c::get_center_freq( size_t chan )
+{
+  return _ring->read_meta().freq;
+}
+
+double shm_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return _corr = request( SHM_REQ_PPM, ppm, _corr );
+}
+
+double shm_source_c::get_freq_corr( size_t chan )
+{
+  return _corr;
+}
+
+std::vector< std::string > shm_source_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >( 1, "LNA" );
+}
+
+osmosdr::gain_range_t shm_source_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t( -100, 100, 0.1 );
+}
+
+osmosdr::gain_range_t shm_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double shm_source_c::set_gain( double gain, size_t chan )
+{
+  return request( SHM_REQ_GAIN, gain, get_gain( chan ) );
+}
+
+double shm_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double shm_source_c::get_gain( size_t chan )
+{
+  return _ring->read_meta().gain;
+}
+
+double shm_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > shm_source_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >( 1, get_antenna( chan ) );
+}
+
+std::string shm_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string shm_source_c::get_antenna( size_t chan )
+{
+  return "SHM";
+}
+
+/* the publisher's time base, at the latest sample published */
+::osmosdr::time_spec_t shm_source_c::get_time_now( size_t mboard )
+{
+  return time_at( _ring->read_meta(), _ring->header()->head.load( boost::memory_order_acquire ) );
+}
+
+osmosdr::stream_stats_t shm_source_c::get_stream_stats( size_t chan )
+{
+  return _stats.get();
+}
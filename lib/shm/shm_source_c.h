@@ -0,0 +1,120 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_SHM_SOURCE_C_H
+#define INCLUDED_SHM_SOURCE_C_H
+
+#include <boost/scoped_ptr.hpp>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/high_res_timer.h>
+
+#include "source_iface.h"
+#include "stream_stats.h"
+#include "shm_ring.h"
+
+class shm_source_c;
+
+typedef boost::shared_ptr< shm_source_c > shm_source_c_sptr;
+
+shm_source_c_sptr make_shm_source_c( const std::string & args = "" );
+
+/*!
+ * \brief Subscribes to the samples of a shm= sink in another process.
+ *
+ * The segment of the publisher is mapped read-only and the samples are
+ * copied from its ring straight into the output buffer. Subscribing
+ * starts at the latest samples, a subscriber falling behind by more than
+ * the ring skips ahead, counting the skipped samples as overflows.
+ *
+ * The samples are tagged with rx_time, rx_rate and rx_freq at start,
+ * after each skip and where the publisher's settings change. Setting the
+ * frequency, rate, gain or correction asks the publisher for it if it has
+ * been created with control=true, the new settings show once the
+ * publisher applies them.
+ */
+class shm_source_c :
+    public gr::sync_block,
+    public source_iface
+{
+private:
+  friend shm_source_c_sptr make_shm_source_c( const std::string & args );
+
+  shm_source_c( const std::string & args );
+
+public:
+  ~shm_source_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+  ::osmosdr::time_spec_t get_time_now( size_t mboard = 0 );
+  ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
+private:
+  bool wait_for_data();
+  void skip_to( uint64_t pos );
+  void tag_at( uint64_t pos, const shm_meta &meta );
+  double request( shm_request_t what, double value, double current );
+
+  boost::scoped_ptr< shm_ring > _ring;
+  std::string _name;
+
+  uint64_t _pos;         /* ring position of the next sample to output */
+  uint32_t _seq;         /* of the settings tagged last */
+  bool _retag;           /* tag the next sample, e.g. after a skip */
+  gr::high_res_timer_type _idle_since;
+  bool _warned;          /* about the publisher not being tunable */
+
+  double _corr;
+
+  stream_stats _stats;
+};
+
+#endif /* INCLUDED_SHM_SOURCE_C_H */
@@ -23,7 +23,13 @@
 
 #include <osmosdr/ranges.h>
 #include <osmosdr/time_spec.h>
+#include <osmosdr/stream_stats.h>
 #include <gnuradio/basic_block.h>
+#include <pmt/pmt.h>
+
+/* name of the message port on which backends serving remote clients
+ * publish the settings requested by them, as gr-uhd style command dicts */
+static const pmt::pmt_t SINK_COMMAND_PORT = pmt::string_to_symbol("command");
 
 /*!
  * TODO: document
@@ -74,6 +80,17 @@ public:
    */
   virtual double set_center_freq( double freq, size_t chan = 0 ) = 0;
 
+  /*!
+   * Hop over \p freqs in a loop, staying \p dwell seconds on each, with
+   * the retunes sequenced by the device itself. An empty plan stops hopping.
+   * \param freqs the frequencies in Hz
+   * \param dwell seconds per hop
+   * \param chan the channel index 0 to N-1
+   * \return false if the device can't hop by itself
+   */
+  virtual bool set_hop_plan( const std::vector< double > &freqs, double dwell,
+                             size_t chan = 0 ) { return false; }
+
   /*!
    * Get the center frequency the underlying radio hardware is tuned to.
    * This is the actual frequency and may differ from the frequency set.
@@ -363,6 +380,19 @@ public:
    * \param time_spec the new time
    */
   virtual void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec) { }
+
+  /*!
+   * Get the streaming statistics (dropped samples, underflow events, buffer fill
+   * high-water mark and latency histogram) collected by the device driver.
+   * The same statistics are published on the "stats" message port whenever
+   * new underflows have been seen, at most once per second.
+   * \param chan the channel index 0 to N-1
+   * \return the statistics, all zero if not supported by the device
+   */
+  virtual ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 )
+  {
+    return ::osmosdr::stream_stats_t();
+  }
 };
 
 #endif // OSMOSDR_SINK_IFACE_H
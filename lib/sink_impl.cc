@@ -32,26 +32,10 @@
 #include <gnuradio/blocks/throttle.h>
 #include <gnuradio/blocks/null_sink.h>
 
-#ifdef ENABLE_UHD
-#include "uhd_sink_c.h"
-#endif
-#ifdef ENABLE_HACKRF
-#include "hackrf_sink_c.h"
-#endif
-#ifdef ENABLE_BLADERF
-#include "bladerf_sink_c.h"
-#endif
-#ifdef ENABLE_SOAPY
-#include "soapy_sink_c.h"
-#endif
-#ifdef ENABLE_REDPITAYA
-#include "redpitaya_sink_c.h"
-#endif
-#ifdef ENABLE_FILE
-#include "file_sink_c.h"
-#endif
-
 #include "arg_helpers.h"
+#include "backend_registry.h"
+#include "device_probe.h"
+#include "stream_stats.h"
 #include "sink_impl.h"
 
 /* This avoids throws in ctor of gr::hier_block2, as gnuradio is unable to deal
@@ -80,89 +64,62 @@ sink_impl::sink_impl( const std::string &args )
   size_t channel = 0;
   bool device_specified = false;
 
-  std::vector< std::string > arg_list = args_to_vector(args);
+  /* each argument is parsed only once */
+  device_specs_t specs = args_to_specs(args);
 
-  std::vector< std::string > dev_types;
+  BOOST_FOREACH(const device_spec &spec, specs) {
+    if ( spec.has("param_cache") ) {
+      bool enabled = ("true" == spec.get("param_cache") ? true : false);
+      _params.set_enabled( enabled );
+      _antennas.set_enabled( enabled );
+      _ranges.set_enabled( enabled );
+    }
+  }
 
-#ifdef ENABLE_UHD
-  dev_types.push_back("uhd");
-#endif
-#ifdef ENABLE_HACKRF
-  dev_types.push_back("hackrf");
-#endif
-#ifdef ENABLE_BLADERF
-  dev_types.push_back("bladerf");
-#endif
-#ifdef ENABLE_SOAPY
-  dev_types.push_back("soapy");
-#endif
-#ifdef ENABLE_REDPITAYA
-  dev_types.push_back("redpitaya");
-#endif
-#ifdef ENABLE_FILE
-  dev_types.push_back("file");
-#endif
+  sink_registry &registry = sink_registry::instance();
+
+  /* looking the backends up loads their modules, list them afterwards */
+  BOOST_FOREACH(const device_spec &spec, specs) {
+    sink_registry::backend backend;
+    if ( ! spec.global && registry.find( spec.dict, backend ) ) {
+      device_specified = true;
+      break;
+    }
+  }
 
   std::cerr << "gr-osmosdr "
             << GR_OSMOSDR_VERSION << " (" << GR_OSMOSDR_LIBVER << ") "
             << "gnuradio " << gr::version() << std::endl;
   std::cerr << "built-in sink types: ";
-  BOOST_FOREACH(std::string dev_type, dev_types)
-    std::cerr << dev_type << " ";
+  BOOST_FOREACH(const sink_registry::backend &backend, registry.backends())
+    std::cerr << backend.name << " ";
   std::cerr << std::endl << std::flush;
 
-  BOOST_FOREACH(std::string arg, arg_list) {
-    dict_t dict = params_to_dict(arg);
-    BOOST_FOREACH(std::string dev_type, dev_types) {
-      if ( dict.count( dev_type ) ) {
-        device_specified = true;
-        break;
-      }
-    }
-  }
+  message_port_register_hier_out( STREAM_STATS_PORT );
+  message_port_register_hier_out( SINK_COMMAND_PORT );
 #ifdef WORKAROUND_GR_HIER_BLOCK2_BUG
   try {
 #endif
   if ( ! device_specified ) {
-    std::vector< std::string > dev_list;
-#ifdef ENABLE_UHD
-    BOOST_FOREACH( std::string dev, uhd_sink_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_BLADERF
-    BOOST_FOREACH( std::string dev, bladerf_sink_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_HACKRF
-    BOOST_FOREACH( std::string dev, hackrf_sink_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_SOAPY
-    BOOST_FOREACH( std::string dev, soapy_sink_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_REDPITAYA
-    BOOST_FOREACH( std::string dev, redpitaya_sink_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_FILE
-    BOOST_FOREACH( std::string dev, file_sink_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
+    std::vector< std::string > dev_list = find_sink_devices();
 
 //    std::cerr << std::endl;
 //    BOOST_FOREACH( std::string dev, dev_list )
 //      std::cerr << "'" << dev << "'" << std::endl;
 
     if ( dev_list.size() )
-      arg_list.push_back( dev_list.front() );
+      specs.push_back( device_spec( dev_list.front() ) );
     else
       throw std::runtime_error("No supported devices found to pick from.");
   }
 
-  BOOST_FOREACH(std::string arg, arg_list) {
+  BOOST_FOREACH(const device_spec &spec, specs) {
+
+    if ( spec.global )
+      continue;
 
-    dict_t dict = params_to_dict(arg);
+    const std::string &arg = spec.arg;
+    const dict_t &dict = spec.dict;
 
 //    std::cerr << std::endl;
 //    BOOST_FOREACH( dict_t::value_type &entry, dict )
@@ -171,46 +128,24 @@ sink_impl::sink_impl( const std::string &args )
     sink_iface *iface = NULL;
     gr::basic_block_sptr block;
 
-#ifdef ENABLE_UHD
-    if ( dict.count("uhd") ) {
-      uhd_sink_c_sptr sink = make_uhd_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_HACKRF
-    if ( dict.count("hackrf") ) {
-      hackrf_sink_c_sptr sink = make_hackrf_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_BLADERF
-    if ( dict.count("bladerf") ) {
-      bladerf_sink_c_sptr sink = make_bladerf_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_SOAPY
-    if ( dict.count("soapy") ) {
-      soapy_sink_c_sptr sink = make_soapy_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_REDPITAYA
-    if ( dict.count("redpitaya") ) {
-      redpitaya_sink_c_sptr sink = make_redpitaya_sink_c( arg );
-      block = sink; iface = sink.get();
-    }
-#endif
-#ifdef ENABLE_FILE
-    if ( dict.count("file") ) {
-      file_sink_c_sptr sink = make_file_sink_c( arg );
-      block = sink; iface = sink.get();
+    sink_registry::backend backend;
+
+    if ( registry.find( dict, backend ) ) {
+      sink_registry::backend::instance_t sink = backend.make( arg );
+      block = sink.first; iface = sink.second;
     }
-#endif
 
     if ( iface != NULL && long(block.get()) != 0 ) {
       _devs.push_back( iface );
 
+      for (size_t i = 0; i < iface->get_num_channels(); i++)
+        _chans.push_back( chan_t( _devs.size() - 1, i ) );
+
+      if ( block->has_msg_port( STREAM_STATS_PORT ) )
+        msg_connect(block, STREAM_STATS_PORT, self(), STREAM_STATS_PORT);
+      if ( block->has_msg_port( SINK_COMMAND_PORT ) )
+        msg_connect(block, SINK_COMMAND_PORT, self(), SINK_COMMAND_PORT);
+
       for (size_t i = 0; i < iface->get_num_channels(); i++) {
         connect(self(), channel++, block, i);
       }
@@ -254,20 +189,35 @@ sink_impl::sink_impl( const std::string &args )
 
 size_t sink_impl::get_num_channels()
 {
-  size_t channels = 0;
+  return _chans.size();
+}
 
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    channels += dev->get_num_channels();
+/* the device serving channel \p chan and its channel there, NULL if none */
+sink_iface *sink_impl::device( size_t chan, size_t &dev_chan )
+{
+  if ( chan >= _chans.size() )
+    return NULL;
 
-  return channels;
+  dev_chan = _chans[chan].dev_chan;
+
+  return _devs[ _chans[chan].dev ];
 }
 
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
 
 osmosdr::meta_range_t sink_impl::get_sample_rates()
 {
-  if ( ! _devs.empty() )
-    return _devs[0]->get_sample_rates(); // assume same devices used in the group
+  if ( ! _devs.empty() ) {
+    osmosdr::meta_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( 0, "rate", range, stamp ) ) {
+      range = _devs[0]->get_sample_rates(); // assume same devices used in the group
+      _ranges.fill( 0, "rate", range, stamp );
+    }
+
+    return range;
+  }
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
@@ -288,6 +238,13 @@ double sink_impl::set_sample_rate(double rate)
       sample_rate = dev->set_sample_rate(rate);
 
     _sample_rate = sample_rate;
+
+    /* the bandwidth may follow the sample rate */
+    _params.store( 0, "rate", sample_rate );
+    for (size_t chan = 0; chan < _chans.size(); chan++) {
+      _params.invalidate( chan, "bandwidth" );
+      _ranges.invalidate( chan, "bandwidth" );
+    }
   }
 
   return sample_rate;
@@ -296,9 +253,15 @@ double sink_impl::set_sample_rate(double rate)
 double sink_impl::get_sample_rate()
 {
   double sample_rate = 0;
+  unsigned long long stamp;
+
+  if ( _params.lookup( 0, "rate", sample_rate, stamp ) )
+    return sample_rate;
 
-  if (!_devs.empty())
+  if (!_devs.empty()) {
     sample_rate = _devs[0]->get_sample_rate(); // assume same devices used in the group
+    _params.fill( 0, "rate", sample_rate, stamp );
+  }
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
@@ -308,295 +271,380 @@ double sink_impl::get_sample_rate()
 
 osmosdr::freq_range_t sink_impl::get_freq_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_range( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::freq_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "freq", range, stamp ) ) {
+      range = dev->get_freq_range( dev_chan );
+      _ranges.fill( chan, "freq", range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::freq_range_t();
 }
 
 double sink_impl::set_center_freq( double freq, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _center_freq[ chan ] != freq ) {
-          _center_freq[ chan ] = freq;
-          return dev->set_center_freq( freq, dev_chan );
-        } else { return _center_freq[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _center_freq[ chan ] != freq ) {
+      _center_freq[ chan ] = freq;
+      double actual = dev->set_center_freq( freq, dev_chan );
+      _params.set_uncached( chan, "freq", false ); /* no longer hopping */
+      _params.store( chan, "freq", actual );
+      return actual;
+    } else { return _center_freq[ chan ]; }
+  }
 
   return 0;
 }
 
+bool sink_impl::set_hop_plan( const std::vector< double > &freqs, double dwell, size_t chan )
+{
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( ! dev->set_hop_plan( freqs, dwell, dev_chan ) )
+      return false;
+
+    /* the device retunes on its own, don't skip the next set_center_freq()
+     * and read the frequency from the device until it has been retuned */
+    _center_freq[ chan ] = 0;
+    _params.set_uncached( chan, "freq", ! freqs.empty() );
+    return ! freqs.empty();
+  }
+
+  return false;
+}
+
 double sink_impl::get_center_freq( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_center_freq( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( _params.lookup( chan, "freq", value, stamp ) )
+      return value;
+
+    value = dev->get_center_freq( dev_chan );
+    _params.fill( chan, "freq", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 double sink_impl::set_freq_corr( double ppm, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _freq_corr[ chan ] != ppm ) {
-          _freq_corr[ chan ] = ppm;
-          return dev->set_freq_corr( ppm, dev_chan );
-        } else { return _freq_corr[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _freq_corr[ chan ] != ppm ) {
+      _freq_corr[ chan ] = ppm;
+      _params.invalidate( chan, "freq" ); /* both, with the corrected frequency */
+      double actual = dev->set_freq_corr( ppm, dev_chan );
+      _params.store( chan, "freq_corr", actual );
+      return actual;
+    } else { return _freq_corr[ chan ]; }
+  }
 
   return 0;
 }
 
 double sink_impl::get_freq_corr( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_corr( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( _params.lookup( chan, "freq_corr", value, stamp ) )
+      return value;
+
+    value = dev->get_freq_corr( dev_chan );
+    _params.fill( chan, "freq_corr", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 std::vector<std::string> sink_impl::get_gain_names( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_names( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) )
+    return dev->get_gain_names( dev_chan );
 
   return std::vector< std::string >();
 }
 
 osmosdr::gain_range_t sink_impl::get_gain_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::gain_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "gain", range, stamp ) ) {
+      range = dev->get_gain_range( dev_chan );
+      _ranges.fill( chan, "gain", range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::gain_range_t();
 }
 
 osmosdr::gain_range_t sink_impl::get_gain_range( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( name, dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::gain_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "gain/" + name, range, stamp ) ) {
+      range = dev->get_gain_range( name, dev_chan );
+      _ranges.fill( chan, "gain/" + name, range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::gain_range_t();
 }
 
 bool sink_impl::set_gain_mode( bool automatic, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain_mode[ chan ] != automatic ) {
-          _gain_mode[ chan ] = automatic;
-          bool mode = dev->set_gain_mode( automatic, dev_chan );
-          if (!automatic) // reapply gain value when switched to manual mode
-            dev->set_gain( _gain[ chan ], dev_chan );
-          return mode;
-        } else { return _gain_mode[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _gain_mode[ chan ] != automatic ) {
+      _gain_mode[ chan ] = automatic;
+      _params.invalidate( chan, "gain" );
+      bool mode = dev->set_gain_mode( automatic, dev_chan );
+      if (!automatic) // reapply gain value when switched to manual mode
+        dev->set_gain( _gain[ chan ], dev_chan );
+      return mode;
+    } else { return _gain_mode[ chan ]; }
+  }
 
   return false;
 }
 
 bool sink_impl::get_gain_mode( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_mode( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) )
+    return dev->get_gain_mode( dev_chan );
 
   return false;
 }
 
 double sink_impl::set_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain[ chan ] != gain ) {
-          _gain[ chan ] = gain;
-          return dev->set_gain( gain, dev_chan );
-        } else { return _gain[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _gain[ chan ] != gain ) {
+      _gain[ chan ] = gain;
+      _params.invalidate( chan, "gain" ); /* the stages as well */
+      double actual = dev->set_gain( gain, dev_chan );
+      _params.store( chan, "gain", actual );
+      return actual;
+    } else { return _gain[ chan ]; }
+  }
 
   return 0;
 }
 
 double sink_impl::set_gain( double gain, const std::string & name, size_t chan)
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_gain( gain, name, dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    _params.invalidate( chan, "gain" ); /* the overall gain as well */
+    double actual = dev->set_gain( gain, name, dev_chan );
+    _params.store( chan, "gain/" + name, actual );
+    return actual;
+  }
 
   return 0;
 }
 
 double sink_impl::get_gain( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( ! _gain_mode[ chan ] && _params.lookup( chan, "gain", value, stamp ) )
+      return value;
+
+    value = dev->get_gain( dev_chan );
+    _params.fill( chan, "gain", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 double sink_impl::get_gain( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( name, dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( ! _gain_mode[ chan ] && _params.lookup( chan, "gain/" + name, value, stamp ) )
+      return value;
+
+    value = dev->get_gain( name, dev_chan );
+    _params.fill( chan, "gain/" + name, value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 double sink_impl::set_if_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _if_gain[ chan ] != gain ) {
-          _if_gain[ chan ] = gain;
-          return dev->set_if_gain( gain, dev_chan );
-        } else { return _if_gain[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _if_gain[ chan ] != gain ) {
+      _if_gain[ chan ] = gain;
+      _params.invalidate( chan, "gain" );
+      return dev->set_if_gain( gain, dev_chan );
+    } else { return _if_gain[ chan ]; }
+  }
 
   return 0;
 }
 
 double sink_impl::set_bb_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bb_gain[ chan ] != gain ) {
-          _bb_gain[ chan ] = gain;
-          return dev->set_bb_gain( gain, dev_chan );
-        } else { return _bb_gain[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _bb_gain[ chan ] != gain ) {
+      _bb_gain[ chan ] = gain;
+      _params.invalidate( chan, "gain" );
+      return dev->set_bb_gain( gain, dev_chan );
+    } else { return _bb_gain[ chan ]; }
+  }
 
   return 0;
 }
 
 std::vector< std::string > sink_impl::get_antennas( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antennas( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) )
+    return dev->get_antennas( dev_chan );
 
   return std::vector< std::string >();
 }
 
 std::string sink_impl::set_antenna( const std::string & antenna, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _antenna[ chan ] != antenna ) {
-          _antenna[ chan ] = antenna;
-          return dev->set_antenna( antenna, dev_chan );
-        } else { return _antenna[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _antenna[ chan ] != antenna ) {
+      _antenna[ chan ] = antenna;
+      std::string actual = dev->set_antenna( antenna, dev_chan );
+      _antennas.store( chan, "antenna", actual );
+      return actual;
+    } else { return _antenna[ chan ]; }
+  }
 
   return "";
 }
 
 std::string sink_impl::get_antenna( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antenna( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    std::string value;
+    unsigned long long stamp;
+
+    if ( _antennas.lookup( chan, "antenna", value, stamp ) )
+      return value;
+
+    value = dev->get_antenna( dev_chan );
+    _antennas.fill( chan, "antenna", value, stamp );
+
+    return value;
+  }
 
   return "";
 }
 
 void sink_impl::set_dc_offset( const std::complex<double> &offset, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_dc_offset( offset, dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) )
+    dev->set_dc_offset( offset, dev_chan );
 }
 
 void sink_impl::set_iq_balance( const std::complex<double> &balance, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_iq_balance( balance, dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) )
+    dev->set_iq_balance( balance, dev_chan );
 }
 
 double sink_impl::set_bandwidth( double bandwidth, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
-          _bandwidth[ chan ] = bandwidth;
-          return dev->set_bandwidth( bandwidth, dev_chan );
-        } else { return _bandwidth[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
+      _bandwidth[ chan ] = bandwidth;
+      double actual = dev->set_bandwidth( bandwidth, dev_chan );
+      _params.store( chan, "bandwidth", actual );
+      return actual;
+    } else { return _bandwidth[ chan ]; }
+  }
 
   return 0;
 }
 
 double sink_impl::get_bandwidth( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( _params.lookup( chan, "bandwidth", value, stamp ) )
+      return value;
+
+    value = dev->get_bandwidth( dev_chan );
+    _params.fill( chan, "bandwidth", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 osmosdr::freq_range_t sink_impl::get_bandwidth_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( sink_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth_range( dev_chan );
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::freq_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "bandwidth", range, stamp ) ) {
+      range = dev->get_bandwidth_range( dev_chan );
+      _ranges.fill( chan, "bandwidth", range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::freq_range_t();
 }
@@ -699,3 +747,35 @@ void sink_impl::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
     dev->set_time_unknown_pps( time_spec );
   }
 }
+
+osmosdr::stream_stats_t sink_impl::get_stream_stats( size_t chan )
+{
+  size_t dev_chan;
+  if ( sink_iface *dev = device( chan, dev_chan ) )
+    return dev->get_stream_stats( dev_chan );
+
+  return osmosdr::stream_stats_t();
+}
+
+osmosdr::channel_state_t sink_impl::get_channel_state( size_t chan )
+{
+  osmosdr::channel_state_t state;
+
+  size_t dev_chan;
+  if ( ! device( chan, dev_chan ) )
+    return state;
+
+  state.sample_rate = get_sample_rate();
+  state.center_freq = get_center_freq( chan );
+  state.freq_corr = get_freq_corr( chan );
+  state.gain_mode = get_gain_mode( chan );
+  state.gain = get_gain( chan );
+
+  BOOST_FOREACH( const std::string &name, get_gain_names( chan ) )
+    state.gains[name] = get_gain( name, chan );
+
+  state.antenna = get_antenna( chan );
+  state.bandwidth = get_bandwidth( chan );
+
+  return state;
+}
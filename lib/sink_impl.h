@@ -23,6 +23,7 @@
 #include "osmosdr/sink.h"
 
 #include "sink_iface.h"
+#include "param_cache.h"
 
 #include <map>
 
@@ -39,6 +40,7 @@ public:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  bool set_hop_plan( const std::vector< double > &freqs, double dwell, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -81,10 +83,25 @@ public:
   void set_time_now(const ::osmosdr::time_spec_t &time_spec, size_t mboard = 0);
   void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
+  ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+  ::osmosdr::channel_state_t get_channel_state( size_t chan = 0 );
 
 private:
+  sink_iface *device( size_t chan, size_t &dev_chan );
+
   std::vector< sink_iface * > _devs;
 
+  /* the device and device channel of each channel, by channel index */
+  struct chan_t
+  {
+    chan_t( size_t dev, size_t dev_chan ) : dev(dev), dev_chan(dev_chan) {}
+
+    size_t dev;
+    size_t dev_chan;
+  };
+
+  std::vector< chan_t > _chans;
+
   /* cache to prevent multiple device calls with the same value coming from grc */
   double _sample_rate;
   std::map< size_t, double > _center_freq;
@@ -95,6 +112,11 @@ private:
   std::map< size_t, double > _bb_gain;
   std::map< size_t, std::string > _antenna;
   std::map< size_t, double > _bandwidth;
+
+  /* what the devices report, saves the getters the device calls */
+  param_cache< double > _params;
+  param_cache< std::string > _antennas;
+  param_cache< osmosdr::meta_range_t > _ranges; /* the device ranges, rebuilt by most backends */
 };
 
 #endif /* INCLUDED_OSMOSDR_SINK_IMPL_H */
@@ -20,6 +20,13 @@
 
 #include "soapy_common.h"
 #include <SoapySDR/Version.hpp>
+#include <SoapySDR/Errors.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <iostream>
+
+#define BACKOFF_MIN_US 1000
+#define BACKOFF_MAX_US 100000
 
 osmosdr::gain_range_t soapy_range_to_gain_range(const SoapySDR::Range &r)
 {
@@ -41,3 +48,15 @@ boost::mutex &get_soapy_maker_mutex(void)
     static boost::mutex m;
     return m;
 }
+
+void soapy_stream_backoff(int ret, long &backoff_us)
+{
+    if (backoff_us == 0)
+    {
+        std::cerr << "SoapySDR stream error: " << SoapySDR::errToStr(ret) << std::endl;
+        backoff_us = BACKOFF_MIN_US;
+    }
+    else backoff_us = std::min(2 * backoff_us, long(BACKOFF_MAX_US));
+
+    boost::this_thread::sleep(boost::posix_time::microseconds(backoff_us));
+}
@@ -37,4 +37,12 @@ osmosdr::gain_range_t soapy_range_to_gain_range(const SoapySDR::Range &r);
  */
 boost::mutex &get_soapy_maker_mutex(void);
 
+/*!
+ * Sleep after a failed stream call, doubling the delay up to 100 ms
+ * on consecutive failures so a broken stream doesn't spin the scheduler.
+ * Only the first failure in a row is reported.
+ * \param backoff_us delay state, reset it to 0 after a successful call
+ */
+void soapy_stream_backoff(int ret, long &backoff_us);
+
 #endif /* INCLUDED_SOAPY_COMMON_H */
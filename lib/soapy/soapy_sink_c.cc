@@ -29,15 +29,19 @@
 #endif
 
 #include <iostream>
+#include <algorithm>
 
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <gnuradio/io_signature.h>
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
 #include "soapy_sink_c.h"
+#include "backend_registry.h"
 #include "soapy_common.h"
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Version.hpp>
@@ -53,14 +57,24 @@ soapy_sink_c_sptr make_soapy_sink_c (const std::string &args)
   return gnuradio::get_initial_sptr(new soapy_sink_c (args));
 }
 
+static sink_registrar soapy_registrar(
+    "soapy",
+    &make_backend< sink_iface, soapy_sink_c_sptr, &make_soapy_sink_c >,
+    &ignore_fake< &soapy_sink_c::get_devices >,
+    BACKEND_HARDWARE | BACKEND_NETWORK, 110 );
+
 /*
  * The private constructor
  */
 soapy_sink_c::soapy_sink_c (const std::string &args)
   : gr::sync_block ("soapy_sink_c",
                     args_to_io_signature(args),
-                    gr::io_signature::make (0, 0, 0))
+                    gr::io_signature::make (0, 0, 0)),
+    _backoff_us(0),
+    _keepalive(_stats)
 {
+    _underrun = tx_underrun_params(params_to_dict(args));
+
     {
         boost::mutex::scoped_lock l(get_soapy_maker_mutex());
         _device = SoapySDR::Device::make(params_to_dict(args));
@@ -69,6 +83,8 @@ soapy_sink_c::soapy_sink_c (const std::string &args)
     std::vector<size_t> channels;
     for (size_t i = 0; i < _nchan; i++) channels.push_back(i);
     _stream = _device->setupStream(SOAPY_SDR_TX, "CF32", channels);
+
+    message_port_register_out(STREAM_STATS_PORT);
 }
 
 soapy_sink_c::~soapy_sink_c(void)
@@ -80,25 +96,106 @@ soapy_sink_c::~soapy_sink_c(void)
 
 bool soapy_sink_c::start()
 {
-    return _device->activateStream(_stream) == 0;
+    if (_device->activateStream(_stream) != 0) return false;
+
+    const double rate = _device->getSampleRate(SOAPY_SDR_TX, 0);
+    if (rate <= 0) return true;
+
+    //the depth of the driver buffers isn't known in general, assume a few MTUs
+    const size_t mtu = std::max<size_t>(1, _device->getStreamMTU(_stream));
+    size_t depth = _device->getNumDirectAccessBuffers(_stream) * mtu;
+    if (depth == 0) depth = 8 * mtu;
+
+    _keepalive.start(_underrun,
+        boost::bind(&soapy_sink_c::write_stream, this, _1, _2, 0, 0LL),
+        _nchan, sizeof(gr_complex), mtu, rate, depth / rate);
+
+    return true;
 }
 
 bool soapy_sink_c::stop()
 {
+    _keepalive.stop();
+
     return _device->deactivateStream(_stream) == 0;
 }
 
+int soapy_sink_c::write_stream(const void * const *buffs, size_t count, int flags, long long timeNs)
+{
+    return _device->writeStream(_stream, buffs, count, flags, timeNs);
+}
+
 int soapy_sink_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
     int flags = 0;
     long long timeNs = 0;
-    int ret = _device->writeStream(
-        _stream, &input_items[0],
-        noutput_items, flags, timeNs);
+    int nitems = noutput_items;
+
+    //a burst starts with a write of its own and ends with END_BURST
+    std::vector<gr::tag_t> tags;
+    get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + noutput_items);
+    std::sort(tags.begin(), tags.end(), gr::tag_t::offset_compare);
+
+    BOOST_FOREACH(const gr::tag_t &tag, tags)
+    {
+        const int rel = int(tag.offset - nitems_read(0));
+        if (rel >= nitems) break;
+
+        if (pmt::eq(tag.key, TX_TIME_KEY) || pmt::eq(tag.key, TX_SOB_KEY))
+        {
+            if (rel > 0)
+            {
+                nitems = rel;
+                break;
+            }
+
+            if (pmt::eq(tag.key, TX_TIME_KEY))
+            {
+                flags |= SOAPY_SDR_HAS_TIME;
+                timeNs = ::osmosdr::time_spec_t(
+                    pmt::to_uint64(pmt::tuple_ref(tag.value, 0)),
+                    pmt::to_double(pmt::tuple_ref(tag.value, 1))).to_ticks(1e9);
+            }
+        }
+        else if (pmt::eq(tag.key, TX_EOB_KEY))
+        {
+            nitems = rel + 1;
+            flags |= SOAPY_SDR_END_BURST;
+            break;
+        }
+    }
+
+    //plain samples may be held back for pre-rolling, bursts go out as they are
+    int ret;
+    if (flags == 0) ret = _keepalive.write(&input_items[0], nitems);
+    else ret = _keepalive.write(&input_items[0], nitems,
+        boost::bind(&soapy_sink_c::write_stream, this, _1, _2, flags, timeNs));
+
+    //the device is meant to run dry between bursts
+    if ((flags & SOAPY_SDR_END_BURST) && ret == nitems) _keepalive.set_idle(true);
+
+    //drivers reporting underflows have no samples to account them to
+    size_t chanMask = 0;
+    int statusFlags = 0;
+    long long statusTimeNs = 0;
+    if (_device->readStreamStatus(_stream, chanMask, statusFlags, statusTimeNs, 0) == SOAPY_SDR_UNDERFLOW)
+        _stats.overflow(0);
+
+    if (_stats.publish_due())
+        message_port_pub(STREAM_STATS_PORT, _stats.to_pmt());
+
+    if (ret == SOAPY_SDR_TIMEOUT) return 0; //call again
+
+    if (ret < 0)
+    {
+        soapy_stream_backoff(ret, _backoff_us);
+        return 0;
+    }
+
+    _backoff_us = 0;
 
-    if (ret < 0) return 0; //call again
     return ret;
 }
 
@@ -365,3 +462,8 @@ void soapy_sink_c::set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec)
     _device->setHardwareTime(time_spec.to_ticks(1e9), "UNKNOWN_PPS");
 }
 
+::osmosdr::stream_stats_t soapy_sink_c::get_stream_stats(size_t)
+{
+    return _stats.get();
+}
+
@@ -26,6 +26,8 @@
 
 #include "osmosdr/ranges.h"
 #include "sink_iface.h"
+#include "stream_stats.h"
+#include "tx_underrun.h"
 
 class soapy_sink_c;
 
@@ -128,11 +130,19 @@ void set_time_now(const ::osmosdr::time_spec_t &time_spec,
                             size_t mboard);
 void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
 void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
+::osmosdr::stream_stats_t get_stream_stats(size_t chan);
 
 private:
+    /* writeStream() as a tx_keepalive::write_t */
+    int write_stream(const void * const *buffs, size_t count, int flags, long long timeNs);
+
     SoapySDR::Device *_device;
     SoapySDR::Stream *_stream;
     size_t _nchan;
+    long _backoff_us; /* see soapy_stream_backoff() */
+    stream_stats _stats;
+    tx_underrun_params _underrun;
+    tx_keepalive _keepalive; /* fills in while the flowgraph is late */
 };
 
 #endif /* INCLUDED_SOAPY_SINK_C_H */
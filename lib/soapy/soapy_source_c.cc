@@ -29,6 +29,9 @@
 #endif
 
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
@@ -37,7 +40,9 @@
 #include <gnuradio/io_signature.h>
 
 #include "arg_helpers.h"
+#include "stream_tags.h"
 #include "soapy_source_c.h"
+#include "backend_registry.h"
 #include "soapy_common.h"
 #include "osmosdr/source.h"
 #include <SoapySDR/Device.hpp>
@@ -54,22 +59,75 @@ soapy_source_c_sptr make_soapy_source_c (const std::string &args)
   return gnuradio::get_initial_sptr(new soapy_source_c (args));
 }
 
+static source_registrar soapy_registrar(
+    "soapy",
+    &make_backend< source_iface, soapy_source_c_sptr, &make_soapy_source_c >,
+    &ignore_fake< &soapy_source_c::get_devices >,
+    BACKEND_HARDWARE | BACKEND_NETWORK | BACKEND_HW_DC_OFFSET, 110 );
+
 /*
  * The private constructor
  */
 soapy_source_c::soapy_source_c (const std::string &args)
   : gr::sync_block ("soapy_source_c",
                     gr::io_signature::make (0, 0, 0),
-                    args_to_io_signature(args))
-{
+                    args_to_io_signature(args)),
+    _tag_now(true),
+    _next_time_ns(0),
+    _rate(0),
+    _backoff_us(0),
+    _dma(false),
+    _dma_size(0),
+    _dma_held(false),
+    _dma_handle(0),
+    _dma_avail(0),
+    _dma_offset(0),
+    _convert_cs16(1.0f/32768.0f),
+    _convert_cs8(true, 0.0f, 1.0f/128.0f),
+    _converters(params_to_dict(args))
+{
+    dict_t dict = params_to_dict(args);
     {
         boost::mutex::scoped_lock l(get_soapy_maker_mutex());
-        _device = SoapySDR::Device::make(params_to_dict(args));
+        _device = SoapySDR::Device::make(dict);
     }
     _nchan = std::max(1, args_to_io_signature(args)->max_streams());
+    _rate = _device->getSampleRate(SOAPY_SDR_RX, 0);
     std::vector<size_t> channels;
     for (size_t i = 0; i < _nchan; i++) channels.push_back(i);
-    _stream = _device->setupStream(SOAPY_SDR_RX, "CF32", channels);
+
+    const std::string dma = dict.count("dma") ? dict["dma"] : "";
+    if ("true" == dma || "1" == dma || "yes" == dma)
+    {
+        //the driver buffers hold the native format, convert from there
+        double fullScale = 0;
+        _dma_format = _device->getNativeStreamFormat(SOAPY_SDR_RX, 0, fullScale);
+        if (fullScale <= 0) fullScale = 1;
+
+        if (_dma_format == "CS16") _dma_size = 2 * sizeof(int16_t);
+        else if (_dma_format == "CS8") _dma_size = 2 * sizeof(int8_t);
+        else if (_dma_format == "CF32") _dma_size = sizeof(gr_complex);
+
+        if (_dma_size)
+        {
+            _stream = _device->setupStream(SOAPY_SDR_RX, _dma_format, channels);
+            _dma = _device->getNumDirectAccessBuffers(_stream) > 0;
+            if (!_dma) _device->closeStream(_stream);
+        }
+
+        if (_dma)
+        {
+            _convert_cs16 = convert_16bit(float(1.0 / fullScale));
+            _convert_cs8 = convert_8bit(true, 0.0f, float(1.0 / fullScale));
+            _dma_buffs.resize(_nchan);
+        }
+        else std::cerr << "SoapySDR: no direct buffer access to " << _dma_format
+                       << " samples, dma=true ignored." << std::endl;
+    }
+
+    if (!_dma) _stream = _device->setupStream(SOAPY_SDR_RX, "CF32", channels);
+    _mtu = std::max<size_t>(1, _device->getStreamMTU(_stream));
+    _buffs.resize(_nchan);
 }
 
 soapy_source_c::~soapy_source_c(void)
@@ -81,11 +139,18 @@ soapy_source_c::~soapy_source_c(void)
 
 bool soapy_source_c::start()
 {
+    _tag_now = true;
     return _device->activateStream(_stream) == 0;
 }
 
 bool soapy_source_c::stop()
 {
+    if (_dma_held)
+    {
+        _device->releaseReadBuffer(_stream, _dma_handle);
+        _dma_held = false;
+    }
+
     return _device->deactivateStream(_stream) == 0;
 }
 
@@ -93,14 +158,136 @@ int soapy_source_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
-    int flags = 0;
-    long long timeNs = 0;
-    int ret = _device->readStream(
-        _stream, &output_items[0],
-        noutput_items, flags, timeNs);
+    if (_dma) return work_dma(noutput_items, output_items);
+
+    int produced = 0;
+
+    //keep reading while another MTU fits, without waiting after the first
+    while (noutput_items - produced >= (produced ? int(_mtu) : 1))
+    {
+        for (size_t i = 0; i < _nchan; i++)
+            _buffs[i] = (gr_complex *)output_items[i] + produced;
+
+        int flags = 0;
+        long long timeNs = 0;
+        int ret = _device->readStream(
+            _stream, &_buffs[0],
+            noutput_items - produced, flags, timeNs,
+            produced ? 0 : 100000);
+
+        if (ret == SOAPY_SDR_TIMEOUT) break;
+
+        if (ret == SOAPY_SDR_OVERFLOW)
+        {
+            //samples were lost, the next ones get a fresh timestamp
+            _tag_now = true;
+            std::cerr << "O" << std::flush;
+            continue;
+        }
+
+        if (ret < 0)
+        {
+            if (produced) break; //deliver what we have first
+            soapy_stream_backoff(ret, _backoff_us);
+            return 0;
+        }
+
+        _backoff_us = 0;
+
+        tag_time(produced, flags, timeNs, ret);
+
+        produced += ret;
+    }
+
+    return produced;
+}
+
+int soapy_source_c::work_dma( int noutput_items, gr_vector_void_star &output_items )
+{
+    int produced = 0;
+
+    while (produced < noutput_items)
+    {
+        if (!_dma_held)
+        {
+            int flags = 0;
+            long long timeNs = 0;
+            int ret = _device->acquireReadBuffer(
+                _stream, _dma_handle, &_dma_buffs[0], flags, timeNs,
+                produced ? 0 : 100000);
+
+            if (ret == SOAPY_SDR_TIMEOUT) break;
+
+            if (ret == SOAPY_SDR_OVERFLOW)
+            {
+                _tag_now = true;
+                std::cerr << "O" << std::flush;
+                continue;
+            }
+
+            if (ret < 0)
+            {
+                if (produced) break;
+                soapy_stream_backoff(ret, _backoff_us);
+                return 0;
+            }
+
+            _backoff_us = 0;
+            _dma_held = true;
+            _dma_avail = ret;
+            _dma_offset = 0;
+
+            tag_time(produced, flags, timeNs, ret);
+        }
+
+        const size_t n = std::min(size_t(noutput_items - produced), _dma_avail - _dma_offset);
+
+        for (size_t i = 0; i < _nchan; i++)
+        {
+            const char *in = (const char *)_dma_buffs[i] + _dma_offset * _dma_size;
+            gr_complex *out = (gr_complex *)output_items[i] + produced;
+
+            if (_dma_format == "CS16") _converters.convert(_convert_cs16, (const int16_t *)in, out, n);
+            else if (_dma_format == "CS8") _converters.convert(_convert_cs8, (const unsigned char *)in, out, n);
+            else memcpy(out, in, n * sizeof(gr_complex));
+        }
+
+        produced += n;
+        _dma_offset += n;
+
+        if (_dma_offset == _dma_avail)
+        {
+            _device->releaseReadBuffer(_stream, _dma_handle);
+            _dma_held = false;
+        }
+    }
+
+    return produced;
+}
+
+void soapy_source_c::tag_time( int offset, int flags, long long timeNs, int nsamples )
+{
+    if (!(flags & SOAPY_SDR_HAS_TIME)) return;
+
+    const double rate = _rate;
+    if (rate <= 0) return;
+
+    //tag a gap in the hardware time larger than half a sample
+    if (std::abs(timeNs - _next_time_ns) > 0.5e9 / rate) _tag_now = true;
+
+    if (_tag_now)
+    {
+        BOOST_FOREACH(const gr::tag_t &tag, make_rx_tags(
+            nitems_written(0) + offset,
+            ::osmosdr::tick_spec_t::from_ticks(timeNs, 1000000000LL),
+            rate, this->get_center_freq(0), alias()))
+        {
+            for (size_t i = 0; i < _nchan; i++) add_item_tag(i, tag);
+        }
+        _tag_now = false;
+    }
 
-    if (ret < 0) return 0; //call again
-    return ret;
+    _next_time_ns = timeNs + (long long)(nsamples * 1e9 / rate);
 }
 
 std::vector<std::string> soapy_source_c::get_devices()
@@ -133,7 +320,9 @@ osmosdr::meta_range_t soapy_source_c::get_sample_rates( void )
 double soapy_source_c::set_sample_rate( double rate )
 {
     _device->setSampleRate(SOAPY_SDR_RX, 0, rate);
-    return this->get_sample_rate();
+    _rate = this->get_sample_rate();
+    _tag_now = true;
+    return _rate;
 }
 
 double soapy_source_c::get_sample_rate( void )
@@ -154,6 +343,7 @@ osmosdr::freq_range_t soapy_source_c::get_freq_range( size_t chan )
 double soapy_source_c::set_center_freq( double freq, size_t chan )
 {
     _device->setFrequency(SOAPY_SDR_RX, chan, freq);
+    _tag_now = true;
     return this->get_center_freq(chan);
 }
 
@@ -361,16 +551,18 @@ double soapy_source_c::get_clock_rate(size_t)
 void soapy_source_c::set_clock_rate(double rate, size_t)
 {
     _device->setMasterClockRate(rate);
+    _rate = this->get_sample_rate(); /* may follow the master clock */
+    _tag_now = true;
 }
 
 ::osmosdr::time_spec_t soapy_source_c::get_time_now(size_t)
 {
-    return ::osmosdr::time_spec_t::from_ticks(_device->getHardwareTime(), 1e6);
+    return ::osmosdr::time_spec_t::from_ticks(_device->getHardwareTime(), 1e9);
 }
 
 ::osmosdr::time_spec_t soapy_source_c::get_time_last_pps(size_t)
 {
-    return ::osmosdr::time_spec_t::from_ticks(_device->getHardwareTime("PPS"), 1e6);
+    return ::osmosdr::time_spec_t::from_ticks(_device->getHardwareTime("PPS"), 1e9);
 }
 
 void soapy_source_c::set_time_now(const ::osmosdr::time_spec_t &time_spec,
@@ -26,6 +26,8 @@
 
 #include "osmosdr/ranges.h"
 #include "source_iface.h"
+#include "sample_convert.h"
+#include "convert_pool.h"
 
 class soapy_source_c;
 
@@ -78,6 +80,12 @@ public:
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
 
+private:
+  int work_dma( int noutput_items, gr_vector_void_star &output_items );
+  void tag_time( int offset, int flags, long long timeNs, int nsamples );
+
+public:
+
   static std::vector< std::string > get_devices();
 
 size_t get_num_channels( void );
@@ -136,6 +144,28 @@ private:
     SoapySDR::Device *_device;
     SoapySDR::Stream *_stream;
     size_t _nchan;
+    size_t _mtu;
+    std::vector<void *> _buffs; /* per channel write position, see work() */
+
+    /* rx_time tagging state, see work() */
+    bool _tag_now;
+    long long _next_time_ns;
+    double _rate; /* as last set, no driver call from work() */
+
+    long _backoff_us; /* see soapy_stream_backoff() */
+
+    /* dma=true, samples taken from the driver buffers, see work_dma() */
+    bool _dma;
+    std::string _dma_format;
+    size_t _dma_size;   /* bytes per sample */
+    bool _dma_held;
+    size_t _dma_handle;
+    size_t _dma_avail;  /* samples in the held buffer */
+    size_t _dma_offset; /* samples consumed from it */
+    std::vector<const void *> _dma_buffs;
+    convert_16bit _convert_cs16;
+    convert_8bit _convert_cs8;
+    convert_pool _converters; /* convert_threads= */
 };
 
 #endif /* INCLUDED_SOAPY_SOURCE_C_H */
@@ -23,6 +23,7 @@
 
 #include <osmosdr/ranges.h>
 #include <osmosdr/time_spec.h>
+#include <osmosdr/stream_stats.h>
 #include <gnuradio/basic_block.h>
 
 /*!
@@ -38,6 +39,14 @@ public:
    */
   virtual size_t get_num_channels( void ) = 0;
 
+  /*!
+   * Identify the device and the firmware it runs, e.g. by the serial
+   * number and firmware version, naming its entries in a cache_dir= cache.
+   * Two devices with the same id have to report the same ranges.
+   * \return the id, empty if the device can't be told apart from others
+   */
+  virtual std::string get_device_id( void ) { return ""; }
+
   /*!
    * \brief seek file to \p seek_point relative to \p whence
    *
@@ -83,6 +92,27 @@ public:
    */
   virtual double set_center_freq( double freq, size_t chan = 0 ) = 0;
 
+  /*!
+   * Called after each set_center_freq() by backends registered with
+   * BACKEND_RETUNE_TAGS, which tag rx_freq on the sample the device delivers
+   * \p settle output samples after the retune, counted at the device.
+   * \param freq the actual frequency in Hz
+   * \param settle output samples to pass before tagging
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void tag_retune( double freq, uint64_t settle, size_t chan = 0 ) { }
+
+  /*!
+   * Hop over \p freqs in a loop, staying \p dwell seconds on each, with
+   * the retunes sequenced by the device itself. An empty plan stops hopping.
+   * \param freqs the frequencies in Hz
+   * \param dwell seconds per hop
+   * \param chan the channel index 0 to N-1
+   * \return false if the device can't hop by itself
+   */
+  virtual bool set_hop_plan( const std::vector< double > &freqs, double dwell,
+                             size_t chan = 0 ) { return false; }
+
   /*!
    * Get the center frequency the underlying radio hardware is tuned to.
    * This is the actual frequency and may differ from the frequency set.
@@ -411,6 +441,28 @@ public:
    * \param chan the channel index 0 to N-1
    */
   virtual void set_notch_AMFM_filter( bool enable, size_t chan = 0 ) { }
+
+  /*!
+   * Get the streaming statistics (dropped samples, overflow events, buffer fill
+   * high-water mark and latency histogram) collected by the device driver.
+   * The same statistics are published on the "stats" message port whenever
+   * new overflows have been seen, at most once per second.
+   * \param chan the channel index 0 to N-1
+   * \return the statistics, all zero if not supported by the device
+   */
+  virtual ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 )
+  {
+    return ::osmosdr::stream_stats_t();
+  }
+
+  /*!
+   * Pause or resume streaming without stopping the flowgraph. The device
+   * stops transferring samples while paused and work() produces nothing,
+   * the first sample after resuming is tagged as a discontinuity.
+   * \param streaming false to pause, true to resume
+   * \return false if the device can't be paused
+   */
+  virtual bool set_streaming( bool streaming ) { return false; }
 };
 
 #endif // OSMOSDR_SOURCE_IFACE_H
@@ -27,70 +27,35 @@
 #include "config.h"
 #endif
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <gnuradio/io_signature.h>
 #include <gnuradio/blocks/null_source.h>
 #include <gnuradio/blocks/throttle.h>
+#include <gnuradio/blocks/float_to_short.h>
+#include <gnuradio/blocks/float_to_char.h>
 #include <gnuradio/constants.h>
-
-#ifdef ENABLE_OSMOSDR
-#include <osmosdr_src_c.h>
-#endif
-
-#ifdef ENABLE_FCD
-#include <fcd_source_c.h>
-#endif
-
-#ifdef ENABLE_FILE
-#include <file_source_c.h>
-#endif
-
-#ifdef ENABLE_RTL
-#include <rtl_source_c.h>
-#endif
-
-#ifdef ENABLE_RTL_TCP
-#include <rtl_tcp_source_c.h>
-#endif
-
-#ifdef ENABLE_UHD
-#include <uhd_source_c.h>
-#endif
-
-#ifdef ENABLE_MIRI
-#include <miri_source_c.h>
-#endif
-
-#ifdef ENABLE_SDRPLAY
-#include <sdrplay_source_c.h>
-#endif
-
-#ifdef ENABLE_HACKRF
-#include <hackrf_source_c.h>
-#endif
-
-#ifdef ENABLE_BLADERF
-#include <bladerf_source_c.h>
-#endif
-
-#ifdef ENABLE_RFSPACE
-#include <rfspace_source_c.h>
-#endif
-
-#ifdef ENABLE_AIRSPY
-#include <airspy_source_c.h>
-#endif
-
-#ifdef ENABLE_SOAPY
-#include <soapy_source_c.h>
-#endif
-
-#ifdef ENABLE_REDPITAYA
-#include <redpitaya_source_c.h>
-#endif
+#include <gnuradio/thread/thread_group.h>
 
 #include "arg_helpers.h"
+#include "backend_registry.h"
+#include "device_probe.h"
+#include "stream_stats.h"
+#include "time_align.h"
+#include "ddc_bank.h"
+#include "spectrum_probe.h"
+#include "coherent_align.h"
+#include "iq_correct_cc.h"
+#include "burst_gate.h"
+#include "power_gate.h"
+#include "device_cache.h"
+#include "retune_queue.h"
 #include "source_impl.h"
 
+/* share of the sample rate the NCO covers by default on either side */
+#define FINE_TUNE_SHARE 0.1
+
 /* This avoids throws in ctor of gr::hier_block2, as gnuradio is unable to deal
  with this behavior in a clean way. The GR maintainer Rondeau has been informed. */
 #define WORKAROUND_GR_HIER_BLOCK2_BUG
@@ -111,278 +76,383 @@ osmosdr::source::make( const std::string &args )
 source_impl::source_impl( const std::string &args )
   : gr::hier_block2 ("source_impl",
         gr::io_signature::make(0, 0, 0),
-        args_to_io_signature(args)),
-    _sample_rate(NAN)
+        args_to_io_signature(args, args_to_cpu_format(args))),
+    _parallel_ctrl(false),
+    _sample_rate(NAN),
+    _ddc(NULL),
+    _spectrum(NULL),
+    _coherent(NULL),
+    _fine_tune(false),
+    _fine_window(0),
+    _gate(false),
+    _gate_threshold(0),
+    _gate_hold(4096),
+    _gate_pre(1024)
 {
   size_t channel = 0;
   bool device_specified = false;
 
-  std::vector< std::string > arg_list = args_to_vector(args);
+  const std::string cpu_format = args_to_cpu_format(args);
+  const size_t item_size = cpu_format_item_size(cpu_format);
 
-  std::vector< std::string > dev_types;
+  /* each argument is parsed only once */
+  device_specs_t specs = args_to_specs(args);
 
-#ifdef ENABLE_FILE
-  dev_types.push_back("file");
-#endif
-#ifdef ENABLE_OSMOSDR
-  dev_types.push_back("osmosdr");
-#endif
-#ifdef ENABLE_FCD
-  dev_types.push_back("fcd");
-#endif
-#ifdef ENABLE_RTL
-  dev_types.push_back("rtl");
-#endif
-#ifdef ENABLE_RTL_TCP
-  dev_types.push_back("rtl_tcp");
-#endif
-#ifdef ENABLE_UHD
-  dev_types.push_back("uhd");
-#endif
-#ifdef ENABLE_MIRI
-  dev_types.push_back("miri");
-#endif
-#ifdef ENABLE_SDRPLAY
-  dev_types.push_back("sdrplay");
-#endif
-#ifdef ENABLE_HACKRF
-  dev_types.push_back("hackrf");
-#endif
-#ifdef ENABLE_BLADERF
-  dev_types.push_back("bladerf");
-#endif
-#ifdef ENABLE_RFSPACE
-  dev_types.push_back("rfspace");
-#endif
-#ifdef ENABLE_AIRSPY
-  dev_types.push_back("airspy");
-#endif
-#ifdef ENABLE_SOAPY
-  dev_types.push_back("soapy");
-#endif
-#ifdef ENABLE_REDPITAYA
-  dev_types.push_back("redpitaya");
+  /* sync=pps|external aligns the channels of all devices in time */
+  std::string sync = "none";
+
+  /* seconds the rx_freq tag is delayed after a retune */
+  double retune_settle = 0;
+
+  /* retune_tags=true tags retunes downstream of devices which can't */
+  bool retune_tags = false;
+
+  /* latency=low|balanced|throughput for all devices */
+  std::string latency;
+
+  /* fft_size=N publishes spectra of the first channel, like osmocom_fft */
+  size_t fft_size = 0;
+  double fft_rate = 30;
+  double fft_alpha = 0.1;
+  bool stitch = false;
+
+  /* cache_dir=path remembers what is slow to learn about the devices */
+  std::string cache_dir;
+
+  /* coherent=true for receivers sharing a clock, aligned by calibration */
+  bool coherent = false;
+  size_t coherent_cal = 65536;
+  double coherent_interval = 0;
+
+#ifdef HAVE_IQBALANCE
+  /* share of the samples the iq balance optimizers get to see */
+  _iq_duty = 0.1;
+#endif
+
+  BOOST_FOREACH(const device_spec &spec, specs) {
+    if ( spec.has("sync") )
+      sync = spec.get("sync");
+    retune_settle = spec.get( "retune_settle", retune_settle );
+    if ( spec.has("retune_tags") )
+      retune_tags = ("true" == spec.get("retune_tags") ? true : false);
+    if ( spec.has("latency") && spec.global )
+      latency = spec.get("latency");
+    if ( spec.global ) {
+      fft_size = spec.get( "fft_size", fft_size );
+      fft_rate = spec.get( "fft_rate", fft_rate );
+      fft_alpha = spec.get( "fft_alpha", fft_alpha );
+      stitch = ("true" == spec.get("stitch") ? true : false);
+      coherent = ("true" == spec.get("coherent") ? true : false);
+      coherent_cal = spec.get( "coherent_cal", coherent_cal );
+      coherent_interval = spec.get( "coherent_interval", coherent_interval );
+      _fine_tune = ("true" == spec.get("fine_tune") ? true : false);
+      _fine_window = spec.get( "fine_tune_window", _fine_window );
+      if ( spec.has("gate_threshold") ) {
+        _gate = true;
+        _gate_threshold = spec.get( "gate_threshold", _gate_threshold );
+      }
+      _gate_hold = spec.get( "gate_hold", _gate_hold );
+      _gate_pre = spec.get( "gate_pre", _gate_pre );
+      if ( spec.has("cache_dir") )
+        cache_dir = spec.get("cache_dir");
+    }
+    if ( spec.has("parallel_ctrl") )
+      _parallel_ctrl = ("true" == spec.get("parallel_ctrl") ? true : false);
+    if ( spec.has("param_cache") ) {
+      bool enabled = ("true" == spec.get("param_cache") ? true : false);
+      _params.set_enabled( enabled );
+      _antennas.set_enabled( enabled );
+      _ranges.set_enabled( enabled );
+    }
+#ifdef HAVE_IQBALANCE
+    if ( spec.has("iq_estimator_duty") )
+      _iq_duty = std::max( 0.001, std::min( 1.0, spec.get( "iq_estimator_duty", 0.1 ) ) );
 #endif
+  }
+
+  source_registry &registry = source_registry::instance();
+
+  /* looking the backends up loads their modules, list them afterwards */
+  BOOST_FOREACH(const device_spec &spec, specs) {
+    source_registry::backend backend;
+    if ( ! spec.global && registry.find( spec.dict, backend ) ) {
+      device_specified = true;
+      break;
+    }
+  }
+
   std::cerr << "gr-osmosdr "
             << GR_OSMOSDR_VERSION << " (" << GR_OSMOSDR_LIBVER << ") "
             << "gnuradio " << gr::version() << std::endl;
   std::cerr << "built-in source types: ";
-  BOOST_FOREACH(std::string dev_type, dev_types)
-    std::cerr << dev_type << " ";
+  BOOST_FOREACH(const source_registry::backend &backend, registry.backends())
+    std::cerr << backend.name << " ";
   std::cerr << std::endl << std::flush;
 
-#ifdef ENABLE_RFSPACE
-  dev_types.push_back("sdr-iq"); /* additional aliases for rfspace backend */
-  dev_types.push_back("sdr-ip");
-  dev_types.push_back("netsdr");
-  dev_types.push_back("cloudiq");
-#endif
-
-  BOOST_FOREACH(std::string arg, arg_list) {
-    dict_t dict = params_to_dict(arg);
-    BOOST_FOREACH(std::string dev_type, dev_types) {
-      if ( dict.count( dev_type ) ) {
-        device_specified = true;
-        break;
-      }
-    }
-  }
+  message_port_register_hier_out( STREAM_STATS_PORT );
+  message_port_register_hier_out( SPECTRUM_PROBE_PORT );
 #ifdef WORKAROUND_GR_HIER_BLOCK2_BUG
   try {
 #endif
   if ( ! device_specified ) {
-    std::vector< std::string > dev_list;
-#ifdef ENABLE_OSMOSDR
-    BOOST_FOREACH( std::string dev, osmosdr_src_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_FCD
-    BOOST_FOREACH( std::string dev, fcd_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_RTL
-    BOOST_FOREACH( std::string dev, rtl_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_UHD
-    BOOST_FOREACH( std::string dev, uhd_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_MIRI
-    BOOST_FOREACH( std::string dev, miri_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_SDRPLAY
-    BOOST_FOREACH( std::string dev, sdrplay_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_BLADERF
-    BOOST_FOREACH( std::string dev, bladerf_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_RFSPACE
-    BOOST_FOREACH( std::string dev, rfspace_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_HACKRF
-    BOOST_FOREACH( std::string dev, hackrf_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_AIRSPY
-    BOOST_FOREACH( std::string dev, airspy_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_SOAPY
-    BOOST_FOREACH( std::string dev, soapy_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
-#ifdef ENABLE_REDPITAYA
-    BOOST_FOREACH( std::string dev, redpitaya_source_c::get_devices() )
-      dev_list.push_back( dev );
-#endif
+    std::vector< std::string > dev_list = find_source_devices();
 
 //    std::cerr << std::endl;
 //    BOOST_FOREACH( std::string dev, dev_list )
 //      std::cerr << "'" << dev << "'" << std::endl;
 
     if ( dev_list.size() )
-      arg_list.push_back( dev_list.front() );
+      specs.push_back( device_spec( dev_list.front() ) );
     else
       throw std::runtime_error("No supported devices found to pick from.");
   }
 
-  BOOST_FOREACH(std::string arg, arg_list) {
+  if ( "none" != sync && "pps" != sync && "external" != sync )
+    throw std::runtime_error("Unsupported sync mode '" + sync + "', "
+                             "use one of none, pps or external.");
 
-    dict_t dict = params_to_dict(arg);
+  time_align_group::sptr align_group;
+  if ( "none" != sync )
+    align_group.reset( new time_align_group );
 
-//    std::cerr << std::endl;
-//    BOOST_FOREACH( dict_t::value_type &entry, dict )
-//      std::cerr << "'" << entry.first << "' = '" << entry.second << "'" << std::endl;
+  std::vector< ddc_channel_t > ddc_channels;
+  const std::string channels = args_to_channels(args);
+  if ( channels.size() ) {
+    if ( "fc32" != cpu_format )
+      throw std::runtime_error("Extracting channels requires cpu_format=fc32.");
 
-    source_iface *iface = NULL;
-    gr::basic_block_sptr block;
+    ddc_channels = parse_ddc_channels( channels );
+  }
 
-#ifdef ENABLE_OSMOSDR
-    if ( dict.count("osmosdr") ) {
-      osmosdr_src_c_sptr src = osmosdr_make_src_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  if ( fft_size ) {
+    if ( "fc32" != cpu_format )
+      throw std::runtime_error("Publishing spectra requires cpu_format=fc32.");
 
-#ifdef ENABLE_FCD
-    if ( dict.count("fcd") ) {
-      fcd_source_c_sptr src = make_fcd_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    if ( fft_rate <= 0 )
+      throw std::runtime_error("The fft_rate has to be positive.");
+  }
 
-#ifdef ENABLE_FILE
-    if ( dict.count("file") ) {
-      file_source_c_sptr src = make_file_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  if ( stitch && ! fft_size )
+    throw std::runtime_error("Stitching spectra requires fft_size=N.");
 
-#ifdef ENABLE_RTL
-    if ( dict.count("rtl") ) {
-      rtl_source_c_sptr src = make_rtl_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  if ( coherent && "fc32" != cpu_format )
+    throw std::runtime_error("Aligning coherent receivers requires cpu_format=fc32.");
 
-#ifdef ENABLE_RTL_TCP
-    if ( dict.count("rtl_tcp") ) {
-      rtl_tcp_source_c_sptr src = make_rtl_tcp_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  if ( _fine_tune && "fc32" != cpu_format )
+    throw std::runtime_error("Fine tuning requires cpu_format=fc32.");
 
-#ifdef ENABLE_UHD
-    if ( dict.count("uhd") ) {
-      uhd_source_c_sptr src = make_uhd_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  if ( _gate && "fc32" != cpu_format )
+    throw std::runtime_error("Gating the outputs requires cpu_format=fc32.");
 
-#ifdef ENABLE_MIRI
-    if ( dict.count("miri") ) {
-      miri_source_c_sptr src = make_miri_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  coherent_align_sptr aligner;
+  spectrum_probe_sptr probe;
 
-#ifdef ENABLE_SDRPLAY
-    if ( dict.count("sdrplay") ) {
-      sdrplay_source_c_sptr src = make_sdrplay_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  ddc_bank_sptr ddc;
 
-#ifdef ENABLE_HACKRF
-    if ( dict.count("hackrf") ) {
-      hackrf_source_c_sptr src = make_hackrf_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+  BOOST_FOREACH(const device_spec &spec, specs) {
 
-#ifdef ENABLE_BLADERF
-    if ( dict.count("bladerf") ) {
-      bladerf_source_c_sptr src = make_bladerf_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    if ( spec.global )
+      continue;
 
-#ifdef ENABLE_RFSPACE
-    if ( dict.count("rfspace") ||
-         dict.count("sdr-iq") ||
-         dict.count("sdr-ip") ||
-         dict.count("netsdr") ||
-         dict.count("cloudiq") ) {
-      rfspace_source_c_sptr src = make_rfspace_source_c( arg );
-      block = src; iface = src.get();
-    }
-#endif
+    std::string arg = spec.arg;
+    dict_t dict = spec.dict;
 
-#ifdef ENABLE_AIRSPY
-    if ( dict.count("airspy") ) {
-      airspy_source_c_sptr src = make_airspy_source_c( arg );
-      block = src; iface = src.get();
+    /* pass a globally given cpu_format down to the device */
+    if ( "fc32" != cpu_format && ! dict.count("cpu_format") ) {
+      arg += ",cpu_format=" + cpu_format;
+      dict["cpu_format"] = cpu_format;
     }
-#endif
 
-#ifdef ENABLE_SOAPY
-    if ( dict.count("soapy") ) {
-      soapy_source_c_sptr src = make_soapy_source_c( arg );
-      block = src; iface = src.get();
+    if ( latency.size() && ! dict.count("latency") ) {
+      arg += ",latency=" + latency;
+      dict["latency"] = latency;
     }
-#endif
 
-#ifdef ENABLE_REDPITAYA
-    if ( dict.count("redpitaya") ) {
-      redpitaya_source_c_sptr src = make_redpitaya_source_c( arg );
-      block = src; iface = src.get();
+//    std::cerr << std::endl;
+//    BOOST_FOREACH( dict_t::value_type &entry, dict )
+//      std::cerr << "'" << entry.first << "' = '" << entry.second << "'" << std::endl;
+
+    source_iface *iface = NULL;
+    gr::basic_block_sptr block;
+
+    source_registry::backend backend;
+
+    if ( registry.find( dict, backend ) ) {
+      source_registry::backend::instance_t src = backend.make( arg );
+      block = src.first; iface = src.second;
     }
-#endif
 
     if ( iface != NULL && long(block.get()) != 0 ) {
       _devs.push_back( iface );
 
+      const std::string id = iface->get_device_id();
+
+      if ( cache_dir.size() && id.size() )
+        _caches.push_back( boost::shared_ptr< device_cache >( new device_cache( cache_dir, id ) ) );
+      else
+        _caches.push_back( boost::shared_ptr< device_cache >() );
+
+      const size_t first_chan = _chans.size();
+
+      for (size_t i = 0; i < iface->get_num_channels(); i++)
+        _chans.push_back( chan_t( _devs.size() - 1, i ) );
+
+      retune_queue_sptr retune( new retune_queue( iface, retune_settle ) );
+      retune->set_retuned_callback( boost::bind( &source_impl::retuned, this,
+                                                 first_chan, _1, _2 ) );
+      _retune.push_back( retune );
+
+      if ( block->has_msg_port( STREAM_STATS_PORT ) )
+        msg_connect(block, STREAM_STATS_PORT, self(), STREAM_STATS_PORT);
+
+      /* spectra measured by the device itself, e.g. hackrf sweep_fft= */
+      if ( block->has_msg_port( SPECTRUM_PROBE_PORT ) )
+        msg_connect(block, SPECTRUM_PROBE_PORT, self(), SPECTRUM_PROBE_PORT);
+
       for (size_t i = 0; i < iface->get_num_channels(); i++) {
+        const int native_size = block->output_signature()->sizeof_stream_item(i);
+
+        gr::basic_block_sptr src = block;
+        int port = i;
+
+        if ( align_group ) {
+          std::string name = spec.dict.begin()->first +
+                             " channel " + boost::lexical_cast< std::string >(i);
+
+          time_align_sptr align = make_time_align( native_size, align_group, name );
+
+          connect(block, i, align, 0);
+          src = align;
+          port = 0;
+        }
+
+        /* marks the samples following a retune, if the device doesn't */
+        if ( retune_tags && ! (backend.caps & BACKEND_RETUNE_TAGS) ) {
+          retune_tagger_sptr tagger = make_retune_tagger( native_size );
+
+          connect(src, port, tagger, 0);
+          src = tagger;
+          port = 0;
+
+          retune->add_tagger( tagger.get() );
+        }
+
+        if ( "fc32" != cpu_format ) {
+          if ( native_size == int(item_size) ) {
+            /* the device delivers the requested format natively */
+            connect(src, port, self(), channel++);
+            continue;
+          }
+
+          /* convert from gr_complex, treating I/Q as a vector of 2 floats */
+          gr::basic_block_sptr conv;
+
+          if ( "sc16" == cpu_format )
+            conv = gr::blocks::float_to_short::make( 2, 32767.0f );
+          else
+            conv = gr::blocks::float_to_char::make( 2, 127.0f );
+
+          connect(src, port, conv, 0);
+          connect(conv, 0, self(), channel++);
+          continue;
+        }
+
+        /* correct in software what the hardware can't, and fine tune */
+        iq_correct_cc *correct = NULL;
+        correction_slot slot;
+
+        slot.src = src;
+        slot.port = port;
+        slot.pinned = false;
+        slot.inserted = false;
+
+        if ( _fine_tune ||
+             (backend.caps & BACKEND_HW_CORRECTION) != BACKEND_HW_CORRECTION ) {
+          iq_correct_cc_sptr iq_correct = make_iq_correct_cc();
+          iq_correct->set_sample_rate( iface->get_sample_rate() );
+
+          slot.correct = iq_correct;
+          slot.dev = boost::dynamic_pointer_cast< gr::block >( block );
+
+          /* without a block of its own the device can't tell if it's running */
+          slot.pinned = _fine_tune || ! slot.dev;
+
+          if ( slot.pinned ) {
+            connect(src, port, iq_correct, 0);
+            src = iq_correct;
+            port = 0;
+            slot.inserted = true;
+          }
+
+          correct = iq_correct.get();
+        }
+
+        _slots.push_back( slot );
+        _iq_correct.push_back( correct );
+        _hw_correction.push_back( backend.caps & BACKEND_HW_CORRECTION );
 #ifdef HAVE_IQBALANCE
-        gr::iqbalance::optimize_c::sptr iq_opt = gr::iqbalance::optimize_c::make( 0 );
-        gr::iqbalance::fix_cc::sptr     iq_fix = gr::iqbalance::fix_cc::make();
+        if ( backend.caps & BACKEND_HW_IQ_BALANCE ) {
+          gr::iqbalance::optimize_c::sptr iq_opt = gr::iqbalance::optimize_c::make( 0 );
+          gr::iqbalance::fix_cc::sptr     iq_fix = gr::iqbalance::fix_cc::make();
 
-        connect(block, i, iq_fix, 0);
-        connect(iq_fix, 0, self(), channel++);
+          link(src, port, iq_fix, 0);
+          msg_connect(iq_opt, "iqbal_corr", iq_fix, "iqbal_corr");
 
-        connect(block, i, iq_opt, 0);
-        msg_connect(iq_opt, "iqbal_corr", iq_fix, "iqbal_corr");
+          if ( _iq_duty < 1.0 ) {
+            /* the estimate converges just as well from a few bursts */
+            burst_gate_sptr gate = make_burst_gate( sizeof(gr_complex), _iq_duty );
 
-        _iq_opt.push_back( iq_opt.get() );
-        _iq_fix.push_back( iq_fix.get() );
-#else
-        connect(block, i, self(), channel++);
+            link(src, port, gate, 0);
+            connect(gate, 0, iq_opt, 0);
+          } else {
+            link(src, port, iq_opt, 0);
+          }
+
+          _iq_opt.push_back( iq_opt.get() );
+          _iq_fix.push_back( iq_fix.get() );
+
+          src = iq_fix;
+          port = 0;
+        } else {
+          _iq_opt.push_back( NULL );
+          _iq_fix.push_back( NULL );
+        }
 #endif
+        restore_calibration( _iq_correct.size() - 1 );
+
+        if ( coherent ) {
+          if ( ! aligner ) {
+            aligner = make_coherent_align( coherent_cal, coherent_interval,
+                                           iface->get_sample_rate() );
+            _coherent = aligner.get();
+          }
+
+          link(src, port, aligner, channel);
+          src = aligner;
+          port = channel;
+        }
+
+        if ( ddc_channels.size() && 0 == channel ) {
+          /* the channels are extracted from the first device channel */
+          ddc = make_ddc_bank( ddc_channels, iface->get_sample_rate() );
+          _ddc = ddc.get();
+
+          link(src, port, ddc, 0);
+        }
+
+        if ( fft_size && 0 == channel ) {
+          probe = make_spectrum_probe( fft_size, fft_rate, fft_alpha,
+                                       iface->get_sample_rate() );
+          _spectrum = probe.get();
+
+          msg_connect(probe, SPECTRUM_PROBE_PORT, self(), SPECTRUM_PROBE_PORT);
+        }
+
+        /* stitch=true spectra span all channels, otherwise only the first */
+        if ( probe && (0 == channel || stitch) )
+          link(src, port, probe, channel);
+
+        connect_output(src, port, channel++, iface->get_sample_rate());
       }
     } else if ( (iface != NULL) || (long(block.get()) != 0) )
       throw std::runtime_error("Either iface or block are NULL.");
@@ -391,6 +461,26 @@ source_impl::source_impl( const std::string &args )
 
   if (!_devs.size())
     throw std::runtime_error("No devices specified via device arguments.");
+
+  if ( aligner && channel < 2 )
+    throw std::runtime_error("Aligning coherent receivers requires at least two channels.");
+
+  for (size_t i = 0; ddc && i < ddc_channels.size(); i++) {
+    std::cerr << "Extracting channel " << channel << " at "
+              << ddc_channels[i].offset << " Hz offset, "
+              << ddc->get_channel_rate( i ) << " Sps" << std::endl;
+
+    connect_output(ddc, i, channel++, ddc->get_channel_rate( i ));
+  }
+
+  if ( "none" != sync ) {
+    /* reset the device clocks to 0 on one common PPS edge */
+    if ( "external" == sync )
+      set_clock_source( "external", osmosdr::ALL_MBOARDS );
+
+    set_time_source( "external", osmosdr::ALL_MBOARDS );
+    set_time_unknown_pps( osmosdr::time_spec_t() );
+  }
 #ifdef WORKAROUND_GR_HIER_BLOCK2_BUG
   } catch ( std::exception &ex ) {
     std::cerr << std::endl << "FATAL: " << ex.what() << std::endl << std::endl;
@@ -399,10 +489,10 @@ source_impl::source_impl( const std::string &args )
      * the missing hardware (channels) with null sourc(e) */
 
     gr::blocks::null_source::sptr null_source = \
-        gr::blocks::null_source::make( sizeof(gr_complex) );
+        gr::blocks::null_source::make( item_size );
 
     gr::blocks::throttle::sptr throttle = \
-        gr::blocks::throttle::make( sizeof(gr_complex), 1e5 );
+        gr::blocks::throttle::make( item_size, 1e5 );
 
     connect(null_source, 0, throttle, 0);
 
@@ -422,82 +512,380 @@ source_impl::source_impl( const std::string &args )
 #endif
 }
 
+/* keep the calibrations learned in this run for the next one */
+source_impl::~source_impl()
+{
+  for ( size_t chan = 0; chan < _chans.size(); chan++ ) {
+    size_t dev_chan;
+    device_cache *cache = warm_cache( chan, dev_chan );
+    if ( ! cache )
+      continue;
+
+    try {
+      if ( chan < _iq_correct.size() && _iq_correct[chan] ) {
+        std::vector< double > estimate = _iq_correct[chan]->get_estimate();
+
+        if ( estimate.size() )
+          cache->put( dev_chan, "iq_estimate", estimate );
+      }
+#ifdef HAVE_IQBALANCE
+      if ( chan < _iq_fix.size() && _iq_fix[chan] ) {
+        std::vector< double > fix;
+        fix.push_back( _iq_fix[chan]->mag() );
+        fix.push_back( _iq_fix[chan]->phase() );
+
+        cache->put( dev_chan, "iq_fix", fix );
+      }
+#endif
+    } catch ( std::exception &ex ) {
+      std::cerr << "Failed to save the calibration: " << ex.what() << std::endl;
+    }
+  }
+}
+
 size_t source_impl::get_num_channels()
 {
-  size_t channels = 0;
+  return _chans.size();
+}
 
-  BOOST_FOREACH( source_iface *dev, _devs )
-    channels += dev->get_num_channels();
+/* the device serving channel \p chan and its channel there, NULL if none */
+source_iface *source_impl::device( size_t chan, size_t &dev_chan )
+{
+  if ( chan >= _chans.size() )
+    return NULL;
 
-  return channels;
+  dev_chan = _chans[chan].dev_chan;
+
+  return _devs[ _chans[chan].dev ];
 }
 
 bool source_impl::seek( long seek_point, int whence, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->seek( seek_point, whence, dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) )
+    return dev->seek( seek_point, whence, dev_chan );
 
   return false;
 }
 
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
 
-osmosdr::meta_range_t source_impl::get_sample_rates()
-{
-  if ( ! _devs.empty() )
-    return _devs[0]->get_sample_rates(); // assume same devices used in the group
-#if 0
-  else
-    throw std::runtime_error(NO_DEVICES_MSG);
-#endif
-  return osmosdr::meta_range_t();;
+osmosdr::meta_range_t source_impl::get_sample_rates()
+{
+  if ( ! _devs.empty() ) {
+    osmosdr::meta_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( 0, "rate", range, stamp ) ) {
+      if ( ! cached_range( 0, "rate", range ) ) {
+        range = _devs[0]->get_sample_rates(); // assume same devices used in the group
+        cache_range( 0, "rate", range );
+      }
+      _ranges.fill( 0, "rate", range, stamp );
+    }
+
+    return range;
+  }
+#if 0
+  else
+    throw std::runtime_error(NO_DEVICES_MSG);
+#endif
+  return osmosdr::meta_range_t();;
+}
+
+double source_impl::set_sample_rate(double rate)
+{
+  double sample_rate = 0;
+
+  if (_sample_rate != rate) {
+#if 0
+    if (_devs.empty())
+      throw std::runtime_error(NO_DEVICES_MSG);
+#endif
+    std::vector< ctrl_requests > requests( _devs.size(),
+                                           ctrl_requests( 1, ctrl_request( "rate", 0, rate ) ) );
+    apply( requests );
+
+    if ( ! requests.empty() )
+      sample_rate = requests.back()[0].actual;
+
+    sample_rate_changed( sample_rate );
+  }
+
+  return sample_rate;
+}
+
+/* Called by the retune queues, for synchronous retunes as well. */
+void source_impl::retuned( size_t first_chan, size_t dev_chan, double freq )
+{
+  const size_t chan = first_chan + dev_chan;
+
+  if ( iq_correct_cc *nco = fine_tuner( chan ) ) {
+    boost::mutex::scoped_lock lock( _fine_mutex );
+
+    /* the NCO makes up for what the synthesizer missed of the target */
+    _hw_freq[ chan ] = freq;
+    freq = fine_freq( chan, freq );
+    nco->set_freq_shift( freq - _hw_freq[ chan ], freq );
+  }
+
+  /* which also ended a hop plan */
+  _params.set_uncached( chan, "freq", false );
+  _params.store( chan, "freq", freq );
+}
+
+iq_correct_cc *source_impl::fine_tuner( size_t chan )
+{
+  if ( _fine_tune && chan < _iq_correct.size() )
+    return _iq_correct[chan];
+
+  return NULL;
+}
+
+/* Connect \p src to output \p channel, through a power gate with
+ * gate_threshold= so only the bursts get to the decoders downstream. */
+void source_impl::connect_output( gr::basic_block_sptr src, int port,
+                                  size_t channel, double rate )
+{
+  if ( ! _gate ) {
+    link(src, port, self(), channel);
+    return;
+  }
+
+  power_gate_sptr gate = make_power_gate( _gate_threshold, _gate_hold,
+                                          _gate_pre, rate );
+
+  link(src, port, gate, 0);
+  connect(gate, 0, self(), channel);
+
+  _gates.push_back( gate.get() );
+}
+
+/* Connect like connect(), remembering the sinks of the point where the
+ * correction of the channel set up last goes. */
+void source_impl::link( gr::basic_block_sptr src, int port,
+                        gr::basic_block_sptr dst, int dst_port )
+{
+  connect(src, port, dst, dst_port);
+
+  if ( _slots.empty() || ! _slots.back().correct )
+    return;
+
+  correction_slot &slot = _slots.back();
+
+  if ( slot.inserted ? (src == slot.correct && 0 == port) :
+                       (src == slot.src && slot.port == port) )
+    slot.sinks.push_back( std::make_pair( dst, dst_port ) );
+}
+
+/* Insert the correction of channel \p chan while it has anything to do and
+ * take it out again when it hasn't, so the stream isn't copied for nothing. */
+void source_impl::update_correction( size_t chan )
+{
+  if ( chan >= _slots.size() || ! _slots[chan].correct )
+    return;
+
+  correction_slot &slot = _slots[chan];
+  iq_correct_cc *correct = _iq_correct[chan];
+
+  const bool wanted = slot.pinned || correct->active();
+  if ( wanted == slot.inserted )
+    return;
+
+  /* a flowgraph is only to be locked once this block is part of one */
+  const bool running = slot.dev->detail() != NULL;
+
+  if ( running )
+    lock();
+
+  gr::basic_block_sptr from = slot.inserted ? slot.correct : slot.src;
+  gr::basic_block_sptr to = wanted ? slot.correct : slot.src;
+  const int from_port = slot.inserted ? 0 : slot.port;
+  const int to_port = wanted ? 0 : slot.port;
+
+  for ( size_t i = 0; i < slot.sinks.size(); i++ ) {
+    disconnect(from, from_port, slot.sinks[i].first, slot.sinks[i].second);
+    connect(to, to_port, slot.sinks[i].first, slot.sinks[i].second);
+  }
+
+  if ( wanted )
+    connect(slot.src, slot.port, slot.correct, 0);
+  else
+    disconnect(slot.src, slot.port, slot.correct, 0);
+
+  slot.inserted = wanted;
+
+  if ( running )
+    unlock();
+}
+
+/* the cache of the device serving channel \p chan, NULL without cache_dir= */
+device_cache *source_impl::warm_cache( size_t chan, size_t &dev_chan )
+{
+  if ( chan >= _chans.size() || _chans[chan].dev >= _caches.size() )
+    return NULL;
+
+  dev_chan = _chans[chan].dev_chan;
+
+  return _caches[ _chans[chan].dev ].get();
+}
+
+bool source_impl::cached_range( size_t chan, const std::string &name,
+                                osmosdr::meta_range_t &range )
+{
+  size_t dev_chan;
+  device_cache *cache = warm_cache( chan, dev_chan );
+
+  return cache && cache->get( dev_chan, name, range );
+}
+
+void source_impl::cache_range( size_t chan, const std::string &name,
+                               const osmosdr::meta_range_t &range )
+{
+  size_t dev_chan;
+  device_cache *cache = warm_cache( chan, dev_chan );
+
+  /* an empty range is most likely a device not ready yet */
+  if ( cache && ! range.empty() )
+    cache->put( dev_chan, name, range );
+}
+
+/* Start the corrections of channel \p chan from the estimates of the last
+ * run, the automatic modes refine them from there. */
+void source_impl::restore_calibration( size_t chan )
+{
+  size_t dev_chan;
+  device_cache *cache = warm_cache( chan, dev_chan );
+  if ( ! cache )
+    return;
+
+  std::vector< double > values;
+
+  if ( chan < _iq_correct.size() && _iq_correct[chan] &&
+       cache->get( dev_chan, "iq_estimate", values ) )
+    _iq_correct[chan]->set_estimate( values );
+#ifdef HAVE_IQBALANCE
+  if ( chan < _iq_fix.size() && _iq_fix[chan] &&
+       cache->get( dev_chan, "iq_fix", values ) && values.size() == 2 ) {
+    _iq_fix[chan]->set_mag( values[0] );
+    _iq_fix[chan]->set_phase( values[1] );
+    _vals[ chan ] = std::pair< float, float >( values[0], values[1] );
+  }
+#endif
+}
+
+/* The frequency the NCO reaches from \p hw_freq, the target if in the window.
+ * Called with _fine_mutex held. */
+double source_impl::fine_freq( size_t chan, double hw_freq )
+{
+  const double window = _fine_window > 0 ? _fine_window :
+                                           FINE_TUNE_SHARE * get_sample_rate();
+
+  std::map< size_t, double >::const_iterator it = _fine_freq.find( chan );
+
+  if ( it != _fine_freq.end() && fabs( it->second - hw_freq ) <= window )
+    return it->second;
+
+  return hw_freq;
+}
+
+/* Shift to \p freq by the NCO alone if the hardware is tuned close enough,
+ * otherwise \p freq stays the target of the retune to follow. */
+bool source_impl::fine_tune( size_t chan, double freq )
+{
+  iq_correct_cc *nco = fine_tuner( chan );
+  if ( ! nco )
+    return false;
+
+  boost::mutex::scoped_lock lock( _fine_mutex );
+
+  _fine_freq[ chan ] = freq;
+
+  std::map< size_t, double >::const_iterator hw = _hw_freq.find( chan );
+
+  if ( hw == _hw_freq.end() || fine_freq( chan, hw->second ) != freq )
+    return false;
+
+  nco->set_freq_shift( freq - hw->second, freq );
+  _params.store( chan, "freq", freq );
+
+  return true;
+}
+
+/* Tune channel \p chan by the NCO alone if the hardware is close enough,
+ * otherwise retune it and let the NCO make up for what it missed.
+ * \return the actual frequency */
+double source_impl::tune( size_t chan, double freq )
+{
+  if ( fine_tune( chan, freq ) )
+    return freq;
+
+  const chan_t &c = _chans[chan];
+  double actual = _retune[c.dev]->retune( c.dev_chan, freq );
+
+  if ( fine_tuner( chan ) ) {
+    boost::mutex::scoped_lock lock( _fine_mutex );
+    actual = fine_freq( chan, actual );
+  }
+
+  return actual;
 }
 
-double source_impl::set_sample_rate(double rate)
+void source_impl::sample_rate_changed( double sample_rate )
 {
-  double sample_rate = 0;
+  if ( _ddc )
+    _ddc->set_sample_rate( sample_rate );
 
-  if (_sample_rate != rate) {
-#if 0
-    if (_devs.empty())
-      throw std::runtime_error(NO_DEVICES_MSG);
-#endif
-    BOOST_FOREACH( source_iface *dev, _devs )
-      sample_rate = dev->set_sample_rate(rate);
+  if ( _spectrum )
+    _spectrum->set_sample_rate( sample_rate );
+
+  if ( _coherent )
+    _coherent->set_sample_rate( sample_rate );
+
+  for (size_t chan = 0; chan < _chans.size() && chan < _iq_correct.size(); chan++)
+    if ( _iq_correct[chan] )
+      _iq_correct[chan]->set_sample_rate( _devs[ _chans[chan].dev ]->get_sample_rate() );
+
+  for (size_t chan = 0; chan < _gates.size(); chan++) {
+    if ( chan < _chans.size() )
+      _gates[chan]->set_sample_rate( _devs[ _chans[chan].dev ]->get_sample_rate() );
+    else if ( _ddc )
+      _gates[chan]->set_sample_rate( _ddc->get_channel_rate( chan - _chans.size() ) );
+  }
 
 #ifdef HAVE_IQBALANCE
-    size_t channel = 0;
-    BOOST_FOREACH( source_iface *dev, _devs ) {
-      for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-        if ( channel < _iq_opt.size() ) {
-          gr::iqbalance::optimize_c *opt = _iq_opt[channel];
-
-          if ( opt->period() > 0 ) { /* optimize is enabled */
-            opt->set_period( dev->get_sample_rate() / 5 );
-            opt->reset();
-          }
-        }
+  for (size_t chan = 0; chan < _chans.size() && chan < _iq_opt.size(); chan++) {
+    gr::iqbalance::optimize_c *opt = _iq_opt[chan];
 
-        channel++;
-      }
+    if ( opt && opt->period() > 0 ) { /* optimize is enabled */
+      opt->set_period( _devs[ _chans[chan].dev ]->get_sample_rate() * _iq_duty / 5 );
+      opt->reset();
     }
+  }
 #endif
 
-    _sample_rate = sample_rate;
-  }
+  _sample_rate = sample_rate;
 
-  return sample_rate;
+  /* the bandwidth may follow the sample rate */
+  _params.store( 0, "rate", sample_rate );
+  for (size_t chan = 0; chan < _chans.size(); chan++) {
+    _params.invalidate( chan, "bandwidth" );
+    _ranges.invalidate( chan, "bandwidth" );
+  }
 }
 
 double source_impl::get_sample_rate()
 {
   double sample_rate = 0;
+  unsigned long long stamp;
 
-  if (!_devs.empty())
+  if ( _params.lookup( 0, "rate", sample_rate, stamp ) )
+    return sample_rate;
+
+  if (!_devs.empty()) {
     sample_rate = _devs[0]->get_sample_rate(); // assume same devices used in the group
+    _params.fill( 0, "rate", sample_rate, stamp );
+  }
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
@@ -507,363 +895,507 @@ double source_impl::get_sample_rate()
 
 osmosdr::freq_range_t source_impl::get_freq_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_range( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::freq_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "freq", range, stamp ) ) {
+      if ( ! cached_range( chan, "freq", range ) ) {
+        range = dev->get_freq_range( dev_chan );
+        cache_range( chan, "freq", range );
+      }
+      _ranges.fill( chan, "freq", range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::freq_range_t();
 }
 
 double source_impl::set_center_freq( double freq, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _center_freq[ chan ] != freq ) {
-          _center_freq[ chan ] = freq;
-          return dev->set_center_freq( freq, dev_chan );
-        } else { return _center_freq[ chan ]; }
-      }
+  if ( chan < _chans.size() ) {
+    if ( _center_freq[ chan ] != freq ) {
+      _center_freq[ chan ] = freq;
+
+      return tune( chan, freq );
+    } else { return _center_freq[ chan ]; }
+  }
 
   return 0;
 }
 
+void source_impl::set_center_freq_async( double freq, size_t chan )
+{
+  if ( chan < _chans.size() ) {
+    const chan_t &c = _chans[chan];
+
+    if ( _center_freq[ chan ] != freq ) {
+      if ( ! fine_tune( chan, freq ) ) {
+        _params.invalidate( chan, "freq" ); /* until retuned() */
+        _retune[c.dev]->post( c.dev_chan, freq );
+      }
+
+      /* only once queued, so a failed post() is retried by the next call */
+      _center_freq[ chan ] = freq;
+    }
+  }
+}
+
+bool source_impl::set_hop_plan( const std::vector< double > &freqs, double dwell, size_t chan )
+{
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( ! dev->set_hop_plan( freqs, dwell, dev_chan ) )
+      return false;
+
+    /* the device retunes on its own, don't skip the next set_center_freq()
+     * and read the frequency from the device until it has been retuned */
+    _center_freq[ chan ] = 0;
+    _params.set_uncached( chan, "freq", ! freqs.empty() );
+
+    if ( iq_correct_cc *nco = fine_tuner( chan ) ) {
+      boost::mutex::scoped_lock lock( _fine_mutex );
+
+      _hw_freq.erase( chan );
+      _fine_freq.erase( chan );
+      nco->set_freq_shift( 0, freqs.empty() ? 0 : freqs[0] );
+    }
+    return ! freqs.empty();
+  }
+
+  return false;
+}
+
 double source_impl::get_center_freq( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_center_freq( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( _params.lookup( chan, "freq", value, stamp ) )
+      return value;
+
+    value = dev->get_center_freq( dev_chan );
+
+    if ( fine_tuner( chan ) ) {
+      boost::mutex::scoped_lock lock( _fine_mutex );
+
+      if ( _hw_freq.count( chan ) )
+        value += fine_freq( chan, _hw_freq[ chan ] ) - _hw_freq[ chan ];
+    }
+
+    _params.fill( chan, "freq", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 double source_impl::set_freq_corr( double ppm, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _freq_corr[ chan ] != ppm ) {
-          _freq_corr[ chan ] = ppm;
-          return dev->set_freq_corr( ppm, dev_chan );
-        } else { return _freq_corr[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( _freq_corr[ chan ] != ppm ) {
+      _freq_corr[ chan ] = ppm;
+      _params.invalidate( chan, "freq" ); /* both, with the corrected frequency */
+      double actual = dev->set_freq_corr( ppm, dev_chan );
+      _params.store( chan, "freq_corr", actual );
+      return actual;
+    } else { return _freq_corr[ chan ]; }
+  }
 
   return 0;
 }
 
 double source_impl::get_freq_corr( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_freq_corr( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( _params.lookup( chan, "freq_corr", value, stamp ) )
+      return value;
+
+    value = dev->get_freq_corr( dev_chan );
+    _params.fill( chan, "freq_corr", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 std::vector<std::string> source_impl::get_gain_names( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_names( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) )
+    return dev->get_gain_names( dev_chan );
 
   return std::vector< std::string >();
 }
 
 osmosdr::gain_range_t source_impl::get_gain_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::gain_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "gain", range, stamp ) ) {
+      if ( ! cached_range( chan, "gain", range ) ) {
+        range = dev->get_gain_range( dev_chan );
+        cache_range( chan, "gain", range );
+      }
+      _ranges.fill( chan, "gain", range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::gain_range_t();
 }
 
 osmosdr::gain_range_t source_impl::get_gain_range( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_range( name, dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::gain_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "gain/" + name, range, stamp ) ) {
+      if ( ! cached_range( chan, "gain/" + name, range ) ) {
+        range = dev->get_gain_range( name, dev_chan );
+        cache_range( chan, "gain/" + name, range );
+      }
+      _ranges.fill( chan, "gain/" + name, range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::gain_range_t();
 }
 
 bool source_impl::set_gain_mode( bool automatic, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain_mode[ chan ] != automatic ) {
-          _gain_mode[ chan ] = automatic;
-          bool mode = dev->set_gain_mode( automatic, dev_chan );
-          if (!automatic) // reapply gain value when switched to manual mode
-            dev->set_gain( _gain[ chan ], dev_chan );
-          return mode;
-        } else { return _gain_mode[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( _gain_mode[ chan ] != automatic ) {
+      _gain_mode[ chan ] = automatic;
+      _params.invalidate( chan, "gain" );
+      bool mode = dev->set_gain_mode( automatic, dev_chan );
+      if (!automatic) // reapply gain value when switched to manual mode
+        dev->set_gain( _gain[ chan ], dev_chan );
+      return mode;
+    } else { return _gain_mode[ chan ]; }
+  }
 
   return false;
 }
 
 bool source_impl::get_gain_mode( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain_mode( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) )
+    return dev->get_gain_mode( dev_chan );
 
   return false;
 }
 
 double source_impl::set_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _gain[ chan ] != gain ) {
-          _gain[ chan ] = gain;
-          return dev->set_gain( gain, dev_chan );
-        } else { return _gain[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( _gain[ chan ] != gain ) {
+      _gain[ chan ] = gain;
+      _params.invalidate( chan, "gain" ); /* the stages as well */
+      double actual = dev->set_gain( gain, dev_chan );
+      _params.store( chan, "gain", actual );
+      return actual;
+    } else { return _gain[ chan ]; }
+  }
 
   return 0;
 }
 
 double source_impl::set_gain( double gain, const std::string & name, size_t chan)
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_gain( gain, name, dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    _params.invalidate( chan, "gain" ); /* the overall gain as well */
+    double actual = dev->set_gain( gain, name, dev_chan );
+    _params.store( chan, "gain/" + name, actual );
+    return actual;
+  }
 
   return 0;
 }
 
 double source_impl::get_gain( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( ! _gain_mode[ chan ] && _params.lookup( chan, "gain", value, stamp ) )
+      return value;
+
+    value = dev->get_gain( dev_chan );
+    _params.fill( chan, "gain", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 double source_impl::get_gain( const std::string & name, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_gain( name, dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( ! _gain_mode[ chan ] && _params.lookup( chan, "gain/" + name, value, stamp ) )
+      return value;
+
+    value = dev->get_gain( name, dev_chan );
+    _params.fill( chan, "gain/" + name, value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 double source_impl::set_if_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _if_gain[ chan ] != gain ) {
-          _if_gain[ chan ] = gain;
-          return dev->set_if_gain( gain, dev_chan );
-        } else { return _if_gain[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( _if_gain[ chan ] != gain ) {
+      _if_gain[ chan ] = gain;
+      _params.invalidate( chan, "gain" );
+      return dev->set_if_gain( gain, dev_chan );
+    } else { return _if_gain[ chan ]; }
+  }
 
   return 0;
 }
 
 double source_impl::set_bb_gain( double gain, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bb_gain[ chan ] != gain ) {
-          _bb_gain[ chan ] = gain;
-          return dev->set_bb_gain( gain, dev_chan );
-        } else { return _bb_gain[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( _bb_gain[ chan ] != gain ) {
+      _bb_gain[ chan ] = gain;
+      _params.invalidate( chan, "gain" );
+      return dev->set_bb_gain( gain, dev_chan );
+    } else { return _bb_gain[ chan ]; }
+  }
 
   return 0;
 }
 
 std::vector< std::string > source_impl::get_antennas( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antennas( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) )
+    return dev->get_antennas( dev_chan );
 
   return std::vector< std::string >();
 }
 
 std::string source_impl::set_antenna( const std::string & antenna, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _antenna[ chan ] != antenna ) {
-          _antenna[ chan ] = antenna;
-          return dev->set_antenna( antenna, dev_chan );
-        } else { return _antenna[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( _antenna[ chan ] != antenna ) {
+      _antenna[ chan ] = antenna;
+      std::string actual = dev->set_antenna( antenna, dev_chan );
+      _antennas.store( chan, "antenna", actual );
+      return actual;
+    } else { return _antenna[ chan ]; }
+  }
 
   return "";
 }
 
 std::string source_impl::get_antenna( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_antenna( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    std::string value;
+    unsigned long long stamp;
+
+    if ( _antennas.lookup( chan, "antenna", value, stamp ) )
+      return value;
+
+    value = dev->get_antenna( dev_chan );
+    _antennas.fill( chan, "antenna", value, stamp );
+
+    return value;
+  }
 
   return "";
 }
 
+/* the software correction of channel \p chan, if it lacks hardware support for \p cap */
+iq_correct_cc *source_impl::sw_correction( size_t chan, unsigned int cap )
+{
+  if ( chan < _iq_correct.size() && ! (_hw_correction[chan] & cap) )
+    return _iq_correct[chan];
+
+  return NULL;
+}
+
 void source_impl::set_dc_offset_mode( int mode, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_dc_offset_mode( mode, dev_chan );
+  if ( iq_correct_cc *correct = sw_correction( chan, BACKEND_HW_DC_OFFSET ) ) {
+    correct->set_dc_offset_mode( mode );
+    return update_correction( chan );
+  }
+
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) )
+    dev->set_dc_offset_mode( mode, dev_chan );
 }
 
 void source_impl::set_dc_offset( const std::complex<double> &offset, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_dc_offset( offset, dev_chan );
+  if ( iq_correct_cc *correct = sw_correction( chan, BACKEND_HW_DC_OFFSET ) )
+    return correct->set_dc_offset( offset );
+
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) )
+    dev->set_dc_offset( offset, dev_chan );
 }
 
 void source_impl::set_iq_balance_mode( int mode, size_t chan )
 {
-  size_t channel = 0;
+  if ( iq_correct_cc *correct = sw_correction( chan, BACKEND_HW_IQ_BALANCE ) ) {
+    correct->set_iq_balance_mode( mode );
+    return update_correction( chan );
+  }
+
+  size_t dev_chan;
+  source_iface *dev = device( chan, dev_chan );
+  if ( ! dev )
+    return;
 #ifdef HAVE_IQBALANCE
-  BOOST_FOREACH( source_iface *dev, _devs ) {
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
-          gr::iqbalance::optimize_c *opt = _iq_opt[chan];
-          gr::iqbalance::fix_cc *fix = _iq_fix[chan];
-
-          if ( IQBalanceOff == mode  ) {
-            opt->set_period( 0 );
-            /* store current values in order to be able to restore them later */
-            _vals[ chan ] = std::pair< float, float >( fix->mag(), fix->phase() );
-            fix->set_mag( 0.0f );
-            fix->set_phase( 0.0f );
-          } else if ( IQBalanceManual == mode ) {
-            if ( opt->period() == 0 ) { /* transition from Off to Manual */
-              /* restore previous values */
-              std::pair< float, float > val = _vals[ chan ];
-              fix->set_mag( val.first );
-              fix->set_phase( val.second );
-            }
-            opt->set_period( 0 );
-          } else if ( IQBalanceAutomatic == mode ) {
-            opt->set_period( dev->get_sample_rate() / 5 );
-            opt->reset();
-          }
-        }
+  if ( chan < _iq_opt.size() && chan < _iq_fix.size() && _iq_opt[chan] ) {
+    gr::iqbalance::optimize_c *opt = _iq_opt[chan];
+    gr::iqbalance::fix_cc *fix = _iq_fix[chan];
+
+    if ( IQBalanceOff == mode  ) {
+      opt->set_period( 0 );
+      /* store current values in order to be able to restore them later */
+      _vals[ chan ] = std::pair< float, float >( fix->mag(), fix->phase() );
+      fix->set_mag( 0.0f );
+      fix->set_phase( 0.0f );
+    } else if ( IQBalanceManual == mode ) {
+      if ( opt->period() == 0 ) { /* transition from Off to Manual */
+        /* restore previous values */
+        std::pair< float, float > val = _vals[ chan ];
+        fix->set_mag( val.first );
+        fix->set_phase( val.second );
       }
+      opt->set_period( 0 );
+    } else if ( IQBalanceAutomatic == mode ) {
+      opt->set_period( dev->get_sample_rate() * _iq_duty / 5 );
+      opt->reset();
     }
   }
 #else
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_iq_balance_mode( mode, dev_chan );
+  return dev->set_iq_balance_mode( mode, dev_chan );
 #endif
 }
 
 void source_impl::set_iq_balance( const std::complex<double> &balance, size_t chan )
 {
-  size_t channel = 0;
+  if ( iq_correct_cc *correct = sw_correction( chan, BACKEND_HW_IQ_BALANCE ) )
+    return correct->set_iq_balance( balance );
+
+  size_t dev_chan;
+  source_iface *dev = device( chan, dev_chan );
+  if ( ! dev )
+    return;
 #ifdef HAVE_IQBALANCE
-  BOOST_FOREACH( source_iface *dev, _devs ) {
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-      if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
-          gr::iqbalance::optimize_c *opt = _iq_opt[chan];
-          gr::iqbalance::fix_cc *fix = _iq_fix[chan];
-
-          if ( opt->period() == 0 ) { /* automatic optimization desabled */
-            fix->set_mag( balance.real() );
-            fix->set_phase( balance.imag() );
-          }
-        }
-      }
+  if ( chan < _iq_opt.size() && chan < _iq_fix.size() && _iq_opt[chan] ) {
+    gr::iqbalance::optimize_c *opt = _iq_opt[chan];
+    gr::iqbalance::fix_cc *fix = _iq_fix[chan];
+
+    if ( opt->period() == 0 ) { /* automatic optimization desabled */
+      fix->set_mag( balance.real() );
+      fix->set_phase( balance.imag() );
     }
   }
 #else
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->set_iq_balance( balance, dev_chan );
+  return dev->set_iq_balance( balance, dev_chan );
 #endif
 }
 
 double source_impl::set_bandwidth( double bandwidth, size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ ) {
-        if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
-          _bandwidth[ chan ] = bandwidth;
-          return dev->set_bandwidth( bandwidth, dev_chan );
-        } else { return _bandwidth[ chan ]; }
-      }
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    if ( _bandwidth[ chan ] != bandwidth || 0.0f == bandwidth ) {
+      _bandwidth[ chan ] = bandwidth;
+      double actual = dev->set_bandwidth( bandwidth, dev_chan );
+      _params.store( chan, "bandwidth", actual );
+      return actual;
+    } else { return _bandwidth[ chan ]; }
+  }
 
   return 0;
 }
 
 double source_impl::get_bandwidth( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    double value;
+    unsigned long long stamp;
+
+    if ( _params.lookup( chan, "bandwidth", value, stamp ) )
+      return value;
+
+    value = dev->get_bandwidth( dev_chan );
+    _params.fill( chan, "bandwidth", value, stamp );
+
+    return value;
+  }
 
   return 0;
 }
 
 osmosdr::freq_range_t source_impl::get_bandwidth_range( size_t chan )
 {
-  size_t channel = 0;
-  BOOST_FOREACH( source_iface *dev, _devs )
-    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        return dev->get_bandwidth_range( dev_chan );
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) ) {
+    osmosdr::freq_range_t range;
+    unsigned long long stamp;
+
+    if ( ! _ranges.lookup( chan, "bandwidth", range, stamp ) ) {
+      /* the filters offered may depend on the rate */
+      const std::string name = "bandwidth@" +
+        boost::lexical_cast< std::string >( dev->get_sample_rate() );
+
+      if ( ! cached_range( chan, name, range ) ) {
+        range = dev->get_bandwidth_range( dev_chan );
+        cache_range( chan, name, range );
+      }
+      _ranges.fill( chan, "bandwidth", range, stamp );
+    }
+
+    return range;
+  }
 
   return osmosdr::freq_range_t();
 }
@@ -959,28 +1491,260 @@ void source_impl::set_time_next_pps(const osmosdr::time_spec_t &time_spec)
   }
 }
 
+#define PPS_POLL_MS 10
+
 void source_impl::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
 {
+  if ( _devs.size() < 2 ) {
+    BOOST_FOREACH( source_iface *dev, _devs )
+      dev->set_time_unknown_pps( time_spec );
+
+    return;
+  }
+
+  /* Waiting for an edge on each device in turn would latch them on different
+   * edges, seconds apart. Wait for one edge on the first device instead and
+   * arm all of them within the second following it. */
+  const osmosdr::time_spec_t last = _devs[0]->get_time_last_pps();
+  const boost::system_time deadline = boost::get_system_time() +
+                                      boost::posix_time::milliseconds( 1100 );
+
+  while ( _devs[0]->get_time_last_pps() == last ) {
+    if ( boost::get_system_time() > deadline )
+      throw std::runtime_error( "No PPS edge detected within one second." );
+
+    boost::this_thread::sleep( boost::posix_time::milliseconds( PPS_POLL_MS ) );
+  }
+
   BOOST_FOREACH( source_iface *dev, _devs )
-  {
-    dev->set_time_unknown_pps( time_spec );
+    dev->set_time_next_pps( time_spec );
+
+  /* let the next edge pass, then all clocks must have latched on it */
+  boost::this_thread::sleep( boost::posix_time::milliseconds( 1100 ) );
+
+  const osmosdr::time_spec_t pps = _devs[0]->get_time_last_pps();
+
+  for ( size_t i = 1; i < _devs.size(); i++ ) {
+    if ( ! (_devs[i]->get_time_last_pps() == pps) )
+      std::cerr << "Device " << i << " missed the PPS edge of device 0, "
+                << "its stream won't be aligned with the others."
+                << std::endl;
   }
 }
 
 void source_impl::set_biast(bool enable, size_t chan)
 {
-    size_t channel = 0;
-    BOOST_FOREACH( source_iface *dev, _devs )
-      for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-        if ( chan == channel++ )
-          dev->set_biast(enable, dev_chan );
+    size_t dev_chan;
+    if ( source_iface *dev = device( chan, dev_chan ) )
+      dev->set_biast(enable, dev_chan );
 }
 
 void source_impl::set_notch_AMFM_filter(bool enable, size_t chan)
 {
-    size_t channel = 0;
-    BOOST_FOREACH( source_iface *dev, _devs )
-      for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-        if ( chan == channel++ )
-          dev->set_notch_AMFM_filter(enable, dev_chan );
+    size_t dev_chan;
+    if ( source_iface *dev = device( chan, dev_chan ) )
+      dev->set_notch_AMFM_filter(enable, dev_chan );
+}
+
+void source_impl::apply_requests( size_t dev, std::vector< ctrl_requests > *requests,
+                                  std::string *error )
+{
+  /* channel index of the first channel of the device */
+  size_t first_chan = 0;
+  while ( first_chan < _chans.size() && _chans[first_chan].dev != dev )
+    first_chan++;
+
+  try {
+    BOOST_FOREACH( ctrl_request &req, (*requests)[dev] ) {
+      source_iface *iface = _devs[dev];
+      const size_t chan = first_chan + req.chan;
+
+      if ( "rate" == req.name )
+        req.actual = iface->set_sample_rate( req.value );
+      else if ( "freq" == req.name )
+        req.actual = tune( chan, req.value ); /* the NCO target moves along */
+      else if ( "gain" == req.name ) {
+        _params.invalidate( chan, "gain" );
+        req.actual = iface->set_gain( req.value, req.chan );
+        _params.store( chan, "gain", req.actual );
+      } else if ( "if_gain" == req.name ) {
+        _params.invalidate( chan, "gain" );
+        req.actual = iface->set_if_gain( req.value, req.chan );
+      } else if ( "bb_gain" == req.name ) {
+        _params.invalidate( chan, "gain" );
+        req.actual = iface->set_bb_gain( req.value, req.chan );
+      } else if ( "bandwidth" == req.name ) {
+        req.actual = iface->set_bandwidth( req.value, req.chan );
+        _params.store( chan, "bandwidth", req.actual );
+      } else if ( "antenna" == req.name )
+        _antennas.store( chan, "antenna", iface->set_antenna( req.str, req.chan ) );
+    }
+  } catch ( std::exception &ex ) {
+    if ( ! error )
+      throw;
+
+    *error = ex.what();
+  }
+}
+
+/* Apply the requests of each device, from a thread per device with parallel_ctrl. */
+void source_impl::apply( std::vector< ctrl_requests > &requests )
+{
+  size_t busy = 0;
+  BOOST_FOREACH( const ctrl_requests &reqs, requests )
+    busy += reqs.empty() ? 0 : 1;
+
+  if ( ! _parallel_ctrl || busy < 2 ) {
+    for (size_t dev = 0; dev < requests.size(); dev++)
+      apply_requests( dev, &requests, NULL );
+
+    return;
+  }
+
+  /* the settling times of the devices overlap instead of adding up */
+  std::vector< std::string > errors( requests.size() );
+  gr::thread::thread_group threads;
+
+  for (size_t dev = 0; dev < requests.size(); dev++)
+    if ( ! requests[dev].empty() )
+      threads.create_thread( boost::bind( &source_impl::apply_requests, this,
+                                          dev, &requests, &errors[dev] ) );
+
+  threads.join_all();
+
+  BOOST_FOREACH( const std::string &error, errors )
+    if ( ! error.empty() )
+      throw std::runtime_error( error );
+}
+
+void source_impl::set_params( const std::string &params )
+{
+  static const char *names[] = { "freq", "gain", "if_gain", "bb_gain", "bandwidth", "antenna" };
+  static const size_t num_names = sizeof(names) / sizeof(names[0]);
+
+  dict_t dict = params_to_dict( params );
+  const size_t nchan = _chans.size();
+
+  /* check all keys first, so nothing is applied if one is wrong */
+  BOOST_FOREACH( const dict_t::value_type &entry, dict ) {
+    const std::string &key = entry.first;
+    std::string name = boost::algorithm::trim_right_copy_if( key, boost::algorithm::is_digit() );
+
+    bool known = ( "rate" == key );
+    for (size_t i = 0; i < num_names; i++)
+      known |= ( names[i] == name );
+
+    if ( known && name != key &&
+         boost::lexical_cast< size_t >( key.substr( name.size() ) ) >= nchan )
+      known = false;
+
+    if ( ! known )
+      throw std::runtime_error( "Unsupported parameter '" + key + "'." );
+  }
+
+  std::vector< ctrl_requests > requests( _devs.size() );
+
+  /* the sample rate goes first, it may limit the bandwidth */
+  bool rate_changed = false;
+
+  if ( dict.count( "rate" ) ) {
+    double rate = boost::lexical_cast< double >( dict["rate"] );
+
+    if ( _sample_rate != rate ) {
+      for (size_t dev = 0; dev < _devs.size(); dev++)
+        requests[dev].push_back( ctrl_request( "rate", 0, rate ) );
+
+      rate_changed = true;
+    }
+  }
+
+  for (size_t chan = 0; chan < _chans.size(); chan++) {
+    const size_t dev = _chans[chan].dev;
+    const size_t dev_chan = _chans[chan].dev_chan;
+
+    for (size_t i = 0; i < num_names; i++) {
+      std::string key = names[i] + boost::lexical_cast< std::string >( chan );
+
+      if ( ! dict.count( key ) )
+        key = names[i];
+
+      if ( ! dict.count( key ) )
+        continue;
+
+      const std::string name = names[i];
+
+      if ( "antenna" == name ) {
+        if ( _antenna[ chan ] != dict[key] ) {
+          _antenna[ chan ] = dict[key];
+          requests[dev].push_back( ctrl_request( name, dev_chan, 0, dict[key] ) );
+        }
+        continue;
+      }
+
+      double value = boost::lexical_cast< double >( dict[key] );
+
+      /* the same caching as done by the individual setters */
+      std::map< size_t, double > *cache = &_center_freq;
+      if ( "gain" == name )
+        cache = &_gain;
+      else if ( "if_gain" == name )
+        cache = &_if_gain;
+      else if ( "bb_gain" == name )
+        cache = &_bb_gain;
+      else if ( "bandwidth" == name )
+        cache = &_bandwidth;
+
+      if ( (*cache)[ chan ] != value || ( "bandwidth" == name && 0.0f == value ) ) {
+        (*cache)[ chan ] = value;
+        requests[dev].push_back( ctrl_request( name, dev_chan, value ) );
+      }
+    }
+  }
+
+  apply( requests );
+
+  if ( rate_changed && ! requests.empty() )
+    sample_rate_changed( requests.back()[0].actual );
+}
+
+osmosdr::stream_stats_t source_impl::get_stream_stats( size_t chan )
+{
+  size_t dev_chan;
+  if ( source_iface *dev = device( chan, dev_chan ) )
+    return dev->get_stream_stats( dev_chan );
+
+  return osmosdr::stream_stats_t();
+}
+
+osmosdr::channel_state_t source_impl::get_channel_state( size_t chan )
+{
+  osmosdr::channel_state_t state;
+
+  size_t dev_chan;
+  if ( ! device( chan, dev_chan ) )
+    return state;
+
+  state.sample_rate = get_sample_rate();
+  state.center_freq = get_center_freq( chan );
+  state.freq_corr = get_freq_corr( chan );
+  state.gain_mode = get_gain_mode( chan );
+  state.gain = get_gain( chan );
+
+  BOOST_FOREACH( const std::string &name, get_gain_names( chan ) )
+    state.gains[name] = get_gain( name, chan );
+
+  state.antenna = get_antenna( chan );
+  state.bandwidth = get_bandwidth( chan );
+
+  return state;
+}
+
+bool source_impl::set_streaming( bool streaming )
+{
+  bool supported = true;
+
+  BOOST_FOREACH( source_iface *dev, _devs )
+    supported &= dev->set_streaming( streaming );
+
+  return supported;
 }
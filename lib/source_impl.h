@@ -27,14 +27,29 @@
 #include <gnuradio/iqbalance/fix_cc.h>
 #endif
 
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/block.h>
+
 #include <source_iface.h>
 
+#include "retune_queue.h"
+#include "param_cache.h"
+
+class ddc_bank;
+class spectrum_probe;
+class coherent_align;
+class iq_correct_cc;
+class power_gate;
+class device_cache;
+
 #include <map>
 
 class source_impl : public osmosdr::source
 {
 public:
   source_impl( const std::string & args );
+  ~source_impl();
 
   size_t get_num_channels( void );
 
@@ -46,6 +61,8 @@ public:
 
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
+  void set_center_freq_async( double freq, size_t chan = 0 );
+  bool set_hop_plan( const std::vector< double > &freqs, double dwell, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
@@ -92,9 +109,65 @@ public:
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
   void set_biast( bool enable, size_t chan = 0 );
   void set_notch_AMFM_filter( bool enable, size_t chan = 0 );
+  ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+  ::osmosdr::channel_state_t get_channel_state( size_t chan = 0 );
+  bool set_streaming( bool streaming );
+
+  void set_params( const std::string &params );
 
 private:
+  iq_correct_cc *sw_correction( size_t chan, unsigned int cap );
+  source_iface *device( size_t chan, size_t &dev_chan );
+  iq_correct_cc *fine_tuner( size_t chan );
+  bool fine_tune( size_t chan, double freq );
+  double tune( size_t chan, double freq );
+  double fine_freq( size_t chan, double hw_freq );
+  void connect_output( gr::basic_block_sptr src, int port, size_t channel,
+                       double rate );
+  void link( gr::basic_block_sptr src, int port,
+             gr::basic_block_sptr dst, int dst_port );
+  void update_correction( size_t chan );
+  device_cache *warm_cache( size_t chan, size_t &dev_chan );
+  bool cached_range( size_t chan, const std::string &name, osmosdr::meta_range_t &range );
+  void cache_range( size_t chan, const std::string &name, const osmosdr::meta_range_t &range );
+  void restore_calibration( size_t chan );
+
+  /* one setting made by set_params(), addressed to a device channel */
+  struct ctrl_request
+  {
+    ctrl_request( const std::string &name, size_t chan, double value,
+                  const std::string &str = "" ) :
+      name(name), chan(chan), value(value), str(str), actual(0) {}
+
+    std::string name;
+    size_t chan;
+    double value;
+    std::string str;  /* the antenna */
+    double actual;    /* as returned by the device */
+  };
+
+  typedef std::vector< ctrl_request > ctrl_requests;
+
+  void apply( std::vector< ctrl_requests > &requests );
+  void apply_requests( size_t dev, std::vector< ctrl_requests > *requests,
+                       std::string *error );
+  void sample_rate_changed( double sample_rate );
+  void retuned( size_t first_chan, size_t dev_chan, double freq );
+
   std::vector< source_iface * > _devs;
+  std::vector< retune_queue_sptr > _retune; /* per device */
+
+  /* the device and device channel of each channel, by channel index */
+  struct chan_t
+  {
+    chan_t( size_t dev, size_t dev_chan ) : dev(dev), dev_chan(dev_chan) {}
+
+    size_t dev;
+    size_t dev_chan;
+  };
+
+  std::vector< chan_t > _chans;
+  bool _parallel_ctrl; /* configure the devices concurrently */
 
   /* cache to prevent multiple device calls with the same value coming from grc */
   double _sample_rate;
@@ -109,8 +182,53 @@ private:
   std::vector< gr::iqbalance::fix_cc * > _iq_fix;
   std::vector< gr::iqbalance::optimize_c * > _iq_opt;
   std::map< size_t, std::pair<float, float> > _vals;
+  double _iq_duty; /* share of the samples passed to _iq_opt */
 #endif
   std::map< size_t, double > _bandwidth;
+
+  /* what the devices report, saves the getters the device calls */
+  param_cache< double > _params;
+  param_cache< std::string > _antennas;
+  param_cache< osmosdr::meta_range_t > _ranges; /* the device ranges, rebuilt by most backends */
+
+  ddc_bank *_ddc; /* extracts the channels= outputs, if any */
+  spectrum_probe *_spectrum; /* publishes the fft_size= spectra, if enabled */
+  coherent_align *_coherent; /* aligns the channels with coherent=true */
+
+  /* per channel, for backends lacking hardware DC or IQ correction */
+  std::vector< iq_correct_cc * > _iq_correct;
+  std::vector< unsigned int > _hw_correction; /* BACKEND_HW_* flags */
+
+  /* where the correction of a channel goes, see update_correction() */
+  struct correction_slot
+  {
+    gr::basic_block_sptr src;  /* the device side */
+    int port;
+    gr::basic_block_sptr correct;
+    gr::block_sptr dev;        /* flattened once running, NULL if hier */
+    std::vector< std::pair< gr::basic_block_sptr, int > > sinks;
+    bool pinned;               /* always inserted */
+    bool inserted;
+  };
+
+  std::vector< correction_slot > _slots; /* per channel, like _iq_correct */
+
+  /* fine_tune=true shifts by the NCO of _iq_correct within the window */
+  bool _fine_tune;
+  double _fine_window; /* Hz off the hardware frequency, 0 for a share of the rate */
+  boost::mutex _fine_mutex; /* the retune queues call retuned() */
+  std::map< size_t, double > _hw_freq;   /* where the hardware is tuned */
+  std::map< size_t, double > _fine_freq; /* where the channel is to be tuned */
+
+  /* gate_threshold= passes only the bursts of each output */
+  bool _gate;
+  double _gate_threshold; /* dB relative to full scale */
+  size_t _gate_hold;      /* samples below the threshold closing the gate */
+  size_t _gate_pre;       /* samples passed from before the gate opened */
+  std::vector< power_gate * > _gates; /* per output */
+
+  /* cache_dir= keeps ranges and calibrations across runs, per device */
+  std::vector< boost::shared_ptr< device_cache > > _caches;
 };
 
 #endif /* INCLUDED_OSMOSDR_SOURCE_IMPL_H */
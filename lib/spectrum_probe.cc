@@ -0,0 +1,257 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/fft/window.h>
+
+#include "spectrum_probe.h"
+#include "stream_tags.h"
+
+#define MAX_STITCHED_BINS (1 << 20)
+
+spectrum_probe_sptr make_spectrum_probe( size_t fft_size, double fft_rate,
+                                         double alpha, double sample_rate )
+{
+  return gnuradio::get_initial_sptr(
+    new spectrum_probe( fft_size, fft_rate, alpha, sample_rate ) );
+}
+
+spectrum_probe::spectrum_probe( size_t fft_size, double fft_rate, double alpha,
+                                double sample_rate ) :
+  gr::sync_block( "spectrum_probe",
+                  gr::io_signature::make( 1, -1, sizeof(gr_complex) ),
+                  gr::io_signature::make( 0, 0, 0 ) ),
+  _fft_size( fft_size ),
+  _fft_rate( fft_rate ),
+  _alpha( float( std::max( 0.0, std::min( 1.0, alpha ) ) ) ),
+  _rate( sample_rate ),
+  _skip( 0 ),
+  _filled( 0 ),
+  _restart( true ),
+  _fft( fft_size, true ),
+  _window( gr::fft::window::blackman_harris( fft_size ) ),
+  _db( fft_size, 0.0f ),
+  _too_wide( false )
+{
+  double sum = 0;
+  for ( size_t i = 0; i < _window.size(); i++ )
+    sum += _window[i];
+
+  _norm = float( sum * sum );
+
+  message_port_register_out( SPECTRUM_PROBE_PORT );
+}
+
+void spectrum_probe::set_sample_rate( double sample_rate )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _rate = sample_rate;
+}
+
+bool spectrum_probe::check_topology( int ninputs, int noutputs )
+{
+  _freqs.assign( ninputs, 0.0 );
+  _frames.assign( ninputs, std::vector< gr_complex >( _fft_size ) );
+  _avg.assign( ninputs, std::vector< float >( _fft_size, 0.0f ) );
+
+  return true;
+}
+
+/* The offset of the last retune of any input in [from, to), if any. */
+bool spectrum_probe::last_retune( uint64_t from, uint64_t to, uint64_t &offset )
+{
+  bool found = false;
+
+  for ( size_t c = 0; c < _freqs.size(); c++ ) {
+    std::vector< gr::tag_t > tags;
+
+    get_tags_in_range( tags, c, from, to, RX_FREQ_KEY );
+
+    if ( tags.empty() )
+      continue;
+
+    std::sort( tags.begin(), tags.end(), gr::tag_t::offset_compare );
+
+    _freqs[c] = pmt::to_double( tags.back().value );
+
+    if ( ! found || tags.back().offset > offset )
+      offset = tags.back().offset;
+
+    found = true;
+  }
+
+  return found;
+}
+
+/* Each bin of the span from the input tuned closest to it. */
+void spectrum_probe::stitch( double rate )
+{
+  const double lowest = *std::min_element( _freqs.begin(), _freqs.end() );
+  const double highest = *std::max_element( _freqs.begin(), _freqs.end() );
+
+  const double width = rate / _fft_size;
+  const double start = lowest - rate / 2;
+  const size_t bins = size_t( (highest - lowest + rate) / width + 0.5 );
+
+  if ( bins > MAX_STITCHED_BINS ) {
+    if ( ! _too_wide )
+      std::cerr << "The receivers span too wide a band to stitch their spectra."
+                << std::endl;
+
+    _too_wide = true;
+    return;
+  }
+
+  _db.resize( bins );
+
+  for ( size_t b = 0; b < bins; b++ ) {
+    const double freq = start + (b + 0.5) * width;
+
+    size_t nearest = 0;
+    for ( size_t c = 1; c < _freqs.size(); c++ )
+      if ( std::abs( freq - _freqs[c] ) < std::abs( freq - _freqs[nearest] ) )
+        nearest = c;
+
+    const long bin = long( floor( (freq - _freqs[nearest]) / width + 0.5 ) ) + long(_fft_size / 2);
+
+    if ( bin < 0 || bin >= long(_fft_size) )
+      _db[b] = -200.0f; /* a gap between the receivers */
+    else
+      _db[b] = 10.0f * log10f( _avg[nearest][bin] + 1e-20f );
+  }
+
+  pmt::pmt_t meta = pmt::make_dict();
+  meta = pmt::dict_add( meta, pmt::mp( "freq" ), pmt::from_double( start + bins * width / 2 ) );
+  meta = pmt::dict_add( meta, pmt::mp( "rate" ), pmt::from_double( bins * width ) );
+
+  message_port_pub( SPECTRUM_PROBE_PORT,
+                    pmt::cons( meta, pmt::init_f32vector( bins, &_db[0] ) ) );
+}
+
+void spectrum_probe::process()
+{
+  const size_t half = _fft_size / 2;
+  const float alpha = _restart ? 1.0f : _alpha;
+  const float scale = 1.0f / _norm;
+
+  for ( size_t c = 0; c < _frames.size(); c++ ) {
+    std::copy( _frames[c].begin(), _frames[c].end(), _fft.get_inbuf() );
+    _fft.execute();
+
+    const gr_complex *bins = _fft.get_outbuf();
+
+    /* DC in the middle */
+    for ( size_t i = 0; i < _fft_size; i++ ) {
+      float &avg = _avg[c][(i + half) % _fft_size];
+      avg += alpha * (std::norm( bins[i] ) * scale - avg);
+    }
+  }
+
+  _restart = false;
+
+  double rate;
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    rate = _rate;
+  }
+
+  if ( _frames.size() > 1 && rate > 0 ) {
+    stitch( rate );
+  } else {
+    _db.resize( _fft_size );
+
+    for ( size_t i = 0; i < _fft_size; i++ )
+      _db[i] = 10.0f * log10f( _avg[0][i] + 1e-20f );
+
+    pmt::pmt_t meta = pmt::make_dict();
+    meta = pmt::dict_add( meta, pmt::mp( "freq" ), pmt::from_double( _freqs[0] ) );
+    meta = pmt::dict_add( meta, pmt::mp( "rate" ), pmt::from_double( rate ) );
+
+    message_port_pub( SPECTRUM_PROBE_PORT,
+                      pmt::cons( meta, pmt::init_f32vector( _fft_size, &_db[0] ) ) );
+  }
+
+  /* the next frame starts 1 / fft_rate after this one did, at 1% duty
+   * as long as the rate isn't known */
+  const uint64_t period = rate > 0 ? uint64_t( rate / _fft_rate ) : _fft_size * 100;
+  _skip = period > _fft_size ? period - _fft_size : 0;
+}
+
+int spectrum_probe::work( int noutput_items,
+                          gr_vector_const_void_star &input_items,
+                          gr_vector_void_star &output_items )
+{
+  const uint64_t first = nitems_read( 0 );
+  size_t pos = 0;
+
+  while ( pos < size_t(noutput_items) ) {
+    if ( _skip ) {
+      const size_t n = std::min( uint64_t(noutput_items - pos), _skip );
+
+      uint64_t retune;
+      if ( last_retune( first + pos, first + pos + n, retune ) )
+        _restart = true;
+
+      pos += n;
+      _skip -= n;
+      continue;
+    }
+
+    const size_t n = std::min( size_t(noutput_items) - pos, _fft_size - _filled );
+
+    /* a frame spanning a retune would smear both spectra, start over */
+    uint64_t retune;
+    if ( last_retune( first + pos, first + pos + n, retune ) &&
+         (retune > first + pos || _filled) ) {
+      pos = retune - first;
+      _filled = 0;
+      _restart = true;
+      continue;
+    }
+
+    for ( size_t c = 0; c < _frames.size(); c++ ) {
+      const gr_complex *in = (const gr_complex *) input_items[c] + pos;
+      gr_complex *frame = &_frames[c][_filled];
+
+      for ( size_t i = 0; i < n; i++ )
+        frame[i] = in[i] * _window[_filled + i];
+    }
+
+    pos += n;
+    _filled += n;
+
+    if ( _filled < _fft_size )
+      continue;
+
+    _filled = 0;
+    process();
+  }
+
+  return noutput_items;
+}
@@ -0,0 +1,103 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_SPECTRUM_PROBE_H
+#define OSMOSDR_SPECTRUM_PROBE_H
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/fft/fft.h>
+#include <pmt/pmt.h>
+
+/* the message port of source_impl publishing the spectra, if enabled */
+static const pmt::pmt_t SPECTRUM_PROBE_PORT = pmt::string_to_symbol("spectrum");
+
+class spectrum_probe;
+
+typedef boost::shared_ptr< spectrum_probe > spectrum_probe_sptr;
+
+spectrum_probe_sptr make_spectrum_probe( size_t fft_size, double fft_rate,
+                                         double alpha, double sample_rate );
+
+/*!
+ * \brief Publishes averaged power spectra of a few frames of the stream.
+ *
+ * Only one frame of \p fft_size samples every 1 / \p fft_rate seconds is
+ * windowed and transformed, the samples in between are consumed without
+ * being read, so monitoring costs a small fraction of a full rate FFT.
+ * The power of each bin is averaged exponentially with weight \p alpha
+ * for the new frame, the average starting over after each rx_freq tag.
+ *
+ * Each spectrum is published on SPECTRUM_PROBE_PORT as a pair of a dict
+ * with the freq and rate it was taken at and a f32vector of the bin
+ * powers in dB, DC in the middle, like the spectra of the sweeper.
+ *
+ * With several inputs, receivers tuned to adjacent frequencies at the same
+ * rate, their spectra are stitched into one spanning all of them. Each bin
+ * is taken from the input tuned closest to it, dropping the band edges
+ * where they overlap, and freq and rate describe the whole span.
+ */
+class spectrum_probe : public gr::sync_block
+{
+private:
+  friend spectrum_probe_sptr make_spectrum_probe( size_t fft_size, double fft_rate,
+                                                  double alpha, double sample_rate );
+
+  spectrum_probe( size_t fft_size, double fft_rate, double alpha, double sample_rate );
+
+public:
+  void set_sample_rate( double sample_rate );
+
+  bool check_topology( int ninputs, int noutputs );
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+private:
+  bool last_retune( uint64_t from, uint64_t to, uint64_t &offset );
+  void process();
+  void stitch( double rate );
+
+  size_t _fft_size;
+  double _fft_rate;
+  float _alpha;
+
+  boost::mutex _mutex; /* the sample rate, set from the control thread */
+  double _rate;
+
+  std::vector< double > _freqs; /* per input, from the rx_freq tags */
+  uint64_t _skip;      /* samples left until the next frame */
+  size_t _filled;      /* of the frame being collected */
+  bool _restart;       /* begin a new average with the next frame */
+
+  gr::fft::fft_complex _fft;
+  std::vector< float > _window;
+  float _norm;         /* the power gain of the window */
+  std::vector< std::vector< gr_complex > > _frames;
+  std::vector< std::vector< float > > _avg;
+  std::vector< float > _db;
+  bool _too_wide;      /* warned about a span too wide to stitch */
+};
+
+#endif // OSMOSDR_SPECTRUM_PROBE_H
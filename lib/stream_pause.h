@@ -0,0 +1,102 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_STREAM_PAUSE_H
+#define OSMOSDR_STREAM_PAUSE_H
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#define PAUSE_POLL_MS 100 /* longest a paused work() blocks */
+
+/*!
+ * \brief Pauses and resumes the stream of a source on behalf of
+ * set_streaming().
+ *
+ * The stop() and start() of the drivers must not race with work(), so
+ * request() only records what the user wants. work() calls poll() first
+ * and carries out the pause or resume returned, then, while paused, calls
+ * wait() and produces nothing. wait() blocks until a resume is requested,
+ * but no longer than PAUSE_POLL_MS, so the scheduler may stop the block.
+ * A resumed stream has lost samples, resumed() is true once afterwards for
+ * the samples to be tagged. Only request() and wait() lock, what work()
+ * checks for every call are atomics.
+ */
+class stream_pause
+{
+public:
+  enum action_t { NONE, PAUSE, RESUME };
+
+  stream_pause() : _wanted(true), _streaming(true), _resumed(false) {}
+
+  void request( bool streaming )
+  {
+    boost::mutex::scoped_lock lock( _mutex ); /* so wait() can't miss it */
+
+    _wanted.store( streaming );
+    _cond.notify_all();
+  }
+
+  /*! To be called by start(), the device streams again. */
+  void started()
+  {
+    _streaming.store( true );
+  }
+
+  action_t poll()
+  {
+    const bool wanted = _wanted.load();
+
+    if ( wanted == _streaming.load() )
+      return NONE;
+
+    _streaming.store( wanted );
+    _resumed.store( wanted );
+
+    return wanted ? RESUME : PAUSE;
+  }
+
+  bool paused()
+  {
+    return ! _streaming.load();
+  }
+
+  void wait()
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( ! _wanted.load() )
+      _cond.timed_wait( lock, boost::posix_time::milliseconds( PAUSE_POLL_MS ) );
+  }
+
+  bool resumed()
+  {
+    return _resumed.exchange( false );
+  }
+
+private:
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  boost::atomic< bool > _wanted;    /* by the user */
+  boost::atomic< bool > _streaming; /* the device, as carried out by work() */
+  boost::atomic< bool > _resumed;
+};
+
+#endif // OSMOSDR_STREAM_PAUSE_H
@@ -0,0 +1,179 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_STREAM_STATS_COUNTERS_H
+#define OSMOSDR_STREAM_STATS_COUNTERS_H
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <gnuradio/high_res_timer.h>
+#include <pmt/pmt.h>
+
+#include "osmosdr/stream_stats.h"
+
+/* name of the message port the statistics are published on */
+static const pmt::pmt_t STREAM_STATS_PORT = pmt::string_to_symbol("stats");
+
+/*!
+ * \brief Collects the statistics reported by get_stream_stats().
+ *
+ * overflow() is meant to be called from the driver callback thread, the
+ * other updates from work(). All counters are atomic, so the statistics
+ * may be read from any thread at any time.
+ */
+class stream_stats : boost::noncopyable
+{
+public:
+  enum { LATENCY_BINS = 24 };
+
+  stream_stats()
+    : _dropped(0), _overflows(0), _high_water(0), _capacity(0),
+      _published(0), _last_publish(0)
+  {
+    for (int i = 0; i < LATENCY_BINS; i++)
+      _latency[i].store(0);
+  }
+
+  /*! Count an overflow (or underflow) event lasting \p samples samples. */
+  void overflow( uint64_t samples )
+  {
+    _dropped.fetch_add( samples, boost::memory_order_relaxed );
+    _overflows.fetch_add( 1, boost::memory_order_relaxed );
+  }
+
+  /*! Account for \p samples more samples lost by the last overflow. */
+  void extend( uint64_t samples )
+  {
+    _dropped.fetch_add( samples, boost::memory_order_relaxed );
+  }
+
+  /*! Track the fill level of a buffer holding up to \p capacity samples. */
+  void fill( uint64_t samples, uint64_t capacity )
+  {
+    _capacity.store( capacity, boost::memory_order_relaxed );
+
+    if ( samples > _high_water.load( boost::memory_order_relaxed ) )
+      _high_water.store( samples, boost::memory_order_relaxed );
+  }
+
+  /*! The size of a buffer whose fill level isn't known. */
+  void capacity( uint64_t capacity )
+  {
+    _capacity.store( capacity, boost::memory_order_relaxed );
+  }
+
+  /*! Account for a buffer queued at \p stamp (gr::high_res_timer_now()). */
+  void latency( gr::high_res_timer_type stamp )
+  {
+    gr::high_res_timer_type ticks = gr::high_res_timer_now() - stamp;
+
+    add_latency( ticks * 1000000 / gr::high_res_timer_tps() );
+  }
+
+  /*!
+   * Account for the oldest of \p samples samples queued in a fifo, for
+   * drivers which don't keep track of the time each sample arrived at.
+   */
+  void latency( uint64_t samples, double rate )
+  {
+    if ( rate > 0 )
+      add_latency( uint64_t(samples * 1e6 / rate) );
+  }
+
+  osmosdr::stream_stats_t get() const
+  {
+    osmosdr::stream_stats_t stats;
+
+    stats.dropped_samples = _dropped.load();
+    stats.overflows = _overflows.load();
+    stats.fill_high_water = _high_water.load();
+    stats.fill_capacity = _capacity.load();
+
+    for (int i = 0; i < LATENCY_BINS; i++)
+      stats.latency_histogram.push_back( _latency[i].load() );
+
+    return stats;
+  }
+
+  /*!
+   * Check whether new overflows happened since the last message has been
+   * published. Limits the message rate to one per second.
+   */
+  bool publish_due()
+  {
+    const uint64_t overflows = _overflows.load( boost::memory_order_relaxed );
+
+    if ( overflows == _published )
+      return false;
+
+    gr::high_res_timer_type now = gr::high_res_timer_now();
+    if ( now - _last_publish < gr::high_res_timer_tps() )
+      return false;
+
+    _published = overflows;
+    _last_publish = now;
+
+    return true;
+  }
+
+  /*! The statistics of channel \p chan as a message. */
+  pmt::pmt_t to_pmt( size_t chan = 0 ) const
+  {
+    osmosdr::stream_stats_t stats = get();
+
+    pmt::pmt_t msg = pmt::make_dict();
+
+    msg = pmt::dict_add( msg, pmt::mp("chan"), pmt::from_uint64( chan ) );
+    msg = pmt::dict_add( msg, pmt::mp("dropped_samples"), pmt::from_uint64( stats.dropped_samples ) );
+    msg = pmt::dict_add( msg, pmt::mp("overflows"), pmt::from_uint64( stats.overflows ) );
+    msg = pmt::dict_add( msg, pmt::mp("fill_high_water"), pmt::from_uint64( stats.fill_high_water ) );
+    msg = pmt::dict_add( msg, pmt::mp("fill_capacity"), pmt::from_uint64( stats.fill_capacity ) );
+    msg = pmt::dict_add( msg, pmt::mp("latency_histogram"),
+                         pmt::init_u64vector( stats.latency_histogram.size(),
+                                              &stats.latency_histogram[0] ) );
+
+    return msg;
+  }
+
+private:
+  void add_latency( uint64_t usecs )
+  {
+    int bin = 0;
+    while ( usecs && bin < LATENCY_BINS - 1 ) {
+      usecs >>= 1;
+      bin++;
+    }
+
+    _latency[bin].fetch_add( 1, boost::memory_order_relaxed );
+  }
+
+  boost::atomic<uint64_t> _dropped;
+  boost::atomic<uint64_t> _overflows;
+  boost::atomic<uint64_t> _high_water;
+  boost::atomic<uint64_t> _capacity;
+  boost::atomic<uint64_t> _latency[LATENCY_BINS];
+
+  /* only used by work() */
+  uint64_t _published;
+  gr::high_res_timer_type _last_publish;
+};
+
+#endif // OSMOSDR_STREAM_STATS_COUNTERS_H
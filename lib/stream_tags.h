@@ -0,0 +1,109 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_STREAM_TAGS_H
+#define OSMOSDR_STREAM_TAGS_H
+
+#include <string>
+#include <vector>
+
+#include <gnuradio/tags.h>
+#include <pmt/pmt.h>
+
+#include "osmosdr/time_spec.h"
+
+/*
+ * Stream tags following the convention of the gr-uhd usrp_source, so
+ * downstream blocks written for it (e.g. tag_debug, burst taggers) work
+ * unmodified with the osmosdr hardware supporting timestamps.
+ */
+
+static const pmt::pmt_t RX_TIME_KEY = pmt::string_to_symbol("rx_time");
+static const pmt::pmt_t RX_RATE_KEY = pmt::string_to_symbol("rx_rate");
+static const pmt::pmt_t RX_FREQ_KEY = pmt::string_to_symbol("rx_freq");
+
+/* the index into the frequency plan of a hop, tagged along with rx_freq */
+static const pmt::pmt_t SWEEP_HOP_KEY = pmt::string_to_symbol("sweep_hop");
+
+/* the first and last sample of a burst passed by gate_threshold= */
+static const pmt::pmt_t BURST_START_KEY = pmt::string_to_symbol("burst_start");
+static const pmt::pmt_t BURST_END_KEY = pmt::string_to_symbol("burst_end");
+
+/* tags understood by the bursting sinks, see gr-uhd usrp_sink */
+static const pmt::pmt_t TX_TIME_KEY = pmt::string_to_symbol("tx_time");
+static const pmt::pmt_t TX_SOB_KEY = pmt::string_to_symbol("tx_sob");
+static const pmt::pmt_t TX_EOB_KEY = pmt::string_to_symbol("tx_eob");
+
+/*!
+ * Make the rx_time, rx_rate and rx_freq tags for the item at \p offset.
+ * The caller adds them to each of its output ports from within work() at
+ * stream start, after each retune and after each detected discontinuity.
+ *
+ * \param time hardware time of the tagged sample, on the same time base
+ *        as get_time_now() of the device
+ * \param rate the current sample rate
+ * \param freq the current center frequency
+ * \param srcid the alias of the tagging block
+ */
+inline std::vector< gr::tag_t > make_rx_tags( uint64_t offset,
+                                              const osmosdr::time_spec_t &time,
+                                              double rate, double freq,
+                                              const std::string &srcid )
+{
+  std::vector< gr::tag_t > tags( 3 );
+
+  for (size_t i = 0; i < tags.size(); i++) {
+    tags[i].offset = offset;
+    tags[i].srcid = pmt::string_to_symbol( srcid );
+  }
+
+  tags[0].key = RX_TIME_KEY;
+  tags[0].value = pmt::make_tuple( pmt::from_uint64( time.get_full_secs() ),
+                                   pmt::from_double( time.get_frac_secs() ) );
+  tags[1].key = RX_RATE_KEY;
+  tags[1].value = pmt::from_double( rate );
+  tags[2].key = RX_FREQ_KEY;
+  tags[2].value = pmt::from_double( freq );
+
+  return tags;
+}
+
+/*!
+ * As above, for hardware counting samples at an integer rate, with the
+ * timestamp kept exact up to its conversion into the rx_time tuple.
+ */
+inline std::vector< gr::tag_t > make_rx_tags( uint64_t offset,
+                                              const osmosdr::tick_spec_t &time,
+                                              double rate, double freq,
+                                              const std::string &srcid )
+{
+  return make_rx_tags( offset, time.to_time_spec(), rate, freq, srcid );
+}
+
+/*!
+ * The time carried by the value of an rx_time or tx_time tag.
+ */
+inline osmosdr::time_spec_t tag_to_time( const pmt::pmt_t &value )
+{
+  return osmosdr::time_spec_t( time_t( pmt::to_uint64( pmt::tuple_ref( value, 0 ) ) ),
+                               pmt::to_double( pmt::tuple_ref( value, 1 ) ) );
+}
+
+#endif // OSMOSDR_STREAM_TAGS_H
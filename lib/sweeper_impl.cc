@@ -0,0 +1,303 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/fft/window.h>
+
+#include "sweeper_impl.h"
+#include "stream_tags.h"
+
+#define RETUNE_TIMEOUT 1.0 /* seconds to wait for a rx_freq tag */
+
+static const pmt::pmt_t SPECTRUM_PORT = pmt::string_to_symbol( "spectrum" );
+
+osmosdr::sweeper::sptr
+osmosdr::sweeper::make( osmosdr::source::sptr src, const std::vector< double > &freqs,
+                        size_t fft_size, size_t averages, double settle, size_t chan )
+{
+  return gnuradio::get_initial_sptr(
+    new sweeper_impl( src, freqs, fft_size, averages, settle, chan ) );
+}
+
+std::vector< double > osmosdr::sweeper::linear_plan( double start, double stop, double step )
+{
+  std::vector< double > freqs;
+
+  if ( step <= 0 )
+    throw std::invalid_argument( "The step of a sweep has to be positive." );
+
+  for ( size_t i = 0; start + i * step <= stop; i++ )
+    freqs.push_back( start + i * step );
+
+  return freqs;
+}
+
+sweeper_impl::sweeper_impl( osmosdr::source::sptr src, const std::vector< double > &freqs,
+                            size_t fft_size, size_t averages, double settle, size_t chan )
+  : gr::block( "sweeper",
+               gr::io_signature::make( 1, 1, sizeof(gr_complex) ),
+               gr::io_signature::make( 1, 1, sizeof(float) * fft_size ) ),
+    _src( src ),
+    _chan( chan ),
+    _fft_size( fft_size ),
+    _averages( std::max( averages, size_t(1) ) ),
+    _settle( settle ),
+    _freqs( freqs ),
+    _plan_changed( false ),
+    _hop_rate( 0 ),
+    _sweeps( 0 ),
+    _fft( fft_size, true ),
+    _window( gr::fft::window::blackman_harris( fft_size ) ),
+    _acc( fft_size, 0.0f ),
+    _state( RETUNING ),
+    _hop( 0 ),
+    _requested( -1 ),
+    _actual( 0 ),
+    _rate( 0 ),
+    _skip( 0 ),
+    _count( 0 ),
+    _sweep_start( 0 )
+{
+  if ( freqs.empty() )
+    throw std::invalid_argument( "The sweep plan is empty." );
+
+  double sum = 0;
+  for ( size_t i = 0; i < _window.size(); i++ )
+    sum += _window[i];
+
+  _norm = float( sum * sum );
+
+  /* the frames are tagged here, the sample tags don't map onto them */
+  set_tag_propagation_policy( TPP_DONT );
+
+  message_port_register_out( SPECTRUM_PORT );
+}
+
+sweeper_impl::~sweeper_impl()
+{
+}
+
+bool sweeper_impl::start()
+{
+  _rate = _src->get_sample_rate();
+  _requested = -1;
+  _sweep_start = gr::high_res_timer_now();
+
+  tune( 0 );
+
+  return gr::block::start();
+}
+
+void sweeper_impl::forecast( int noutput_items, gr_vector_int &ninput_items_required )
+{
+  ninput_items_required[0] = _fft_size;
+}
+
+void sweeper_impl::tune( size_t hop )
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( _plan_changed ) {
+      _freqs.swap( _next_freqs );
+      _plan_changed = false;
+      hop = 0;
+    }
+  }
+
+  _hop = hop;
+  _count = 0;
+  std::fill( _acc.begin(), _acc.end(), 0.0f );
+
+  const double freq = _freqs[_hop];
+
+  if ( freq == _requested ) { /* no retune, no tag */
+    _state = COLLECTING;
+    return;
+  }
+
+  _requested = freq;
+  _skip = uint64_t( RETUNE_TIMEOUT * _rate ); /* in case the tag never comes */
+  _state = RETUNING;
+
+  _src->set_center_freq_async( freq, _chan );
+}
+
+void sweeper_impl::accumulate( const gr_complex *in )
+{
+  gr_complex *buf = _fft.get_inbuf();
+
+  for ( size_t i = 0; i < _fft_size; i++ )
+    buf[i] = in[i] * _window[i];
+
+  _fft.execute();
+
+  const gr_complex *bins = _fft.get_outbuf();
+  const size_t half = _fft_size / 2;
+
+  /* DC in the middle */
+  for ( size_t i = 0; i < _fft_size; i++ )
+    _acc[(i + half) % _fft_size] += std::norm( bins[i] );
+
+  _count++;
+}
+
+void sweeper_impl::emit( float *out )
+{
+  const float scale = 1.0f / (_count * _norm);
+
+  for ( size_t i = 0; i < _fft_size; i++ )
+    out[i] = 10.0f * log10f( _acc[i] * scale + 1e-20f );
+
+  const uint64_t offset = nitems_written( 0 );
+
+  add_item_tag( 0, offset, RX_FREQ_KEY, pmt::from_double( _actual ), alias_pmt() );
+  add_item_tag( 0, offset, SWEEP_HOP_KEY, pmt::from_uint64( _hop ), alias_pmt() );
+
+  pmt::pmt_t meta = pmt::make_dict();
+  meta = pmt::dict_add( meta, pmt::mp( "freq" ), pmt::from_double( _actual ) );
+  meta = pmt::dict_add( meta, pmt::mp( "hop" ), pmt::from_uint64( _hop ) );
+  meta = pmt::dict_add( meta, pmt::mp( "sweep" ), pmt::from_uint64( sweeps() ) );
+
+  message_port_pub( SPECTRUM_PORT,
+                    pmt::cons( meta, pmt::init_f32vector( _fft_size, out ) ) );
+}
+
+int sweeper_impl::general_work( int noutput_items,
+                                gr_vector_int &ninput_items,
+                                gr_vector_const_void_star &input_items,
+                                gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  float *out = (float *) output_items[0];
+
+  const size_t nin = ninput_items[0];
+  const uint64_t first = nitems_read( 0 );
+  size_t consumed = 0;
+  int produced = 0;
+
+  while ( consumed < nin && produced < noutput_items ) {
+    if ( RETUNING == _state ) {
+      std::vector< gr::tag_t > tags;
+      get_tags_in_range( tags, 0, first + consumed, first + nin, RX_FREQ_KEY );
+
+      /* a tag of an earlier retune may still be on its way */
+      size_t i;
+      for ( i = 0; i < tags.size(); i++ )
+        if ( std::abs( pmt::to_double( tags[i].value ) - _requested ) < _rate / 4 )
+          break;
+
+      if ( i < tags.size() ) {
+        consumed = tags[i].offset - first;
+        _actual = pmt::to_double( tags[i].value );
+        _skip = uint64_t( _settle * _rate );
+        _state = SETTLING;
+      } else if ( _skip <= nin - consumed ) {
+        /* the source didn't retune, it was there already */
+        consumed += _skip;
+        _actual = _src->get_center_freq( _chan );
+        _skip = uint64_t( _settle * _rate );
+        _state = SETTLING;
+      } else {
+        _skip -= nin - consumed;
+        consumed = nin;
+      }
+    } else if ( SETTLING == _state ) {
+      const size_t n = std::min( uint64_t(nin - consumed), _skip );
+
+      consumed += n;
+      _skip -= n;
+
+      if ( ! _skip )
+        _state = COLLECTING;
+    } else {
+      if ( nin - consumed < _fft_size )
+        break;
+
+      accumulate( in + consumed );
+      consumed += _fft_size;
+
+      if ( _count < _averages )
+        continue;
+
+      emit( out + produced * _fft_size );
+      produced++;
+
+      size_t next = _hop + 1;
+
+      if ( next >= _freqs.size() ) {
+        const gr::high_res_timer_type now = gr::high_res_timer_now();
+        boost::mutex::scoped_lock lock( _mutex );
+
+        _hop_rate = _freqs.size() * double( gr::high_res_timer_tps() ) / (now - _sweep_start);
+        _sweep_start = now;
+        _sweeps++;
+        next = 0;
+      }
+
+      tune( next );
+    }
+  }
+
+  consume_each( consumed );
+
+  return produced;
+}
+
+void sweeper_impl::set_plan( const std::vector< double > &freqs )
+{
+  if ( freqs.empty() )
+    throw std::invalid_argument( "The sweep plan is empty." );
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _next_freqs = freqs;
+  _plan_changed = true;
+}
+
+std::vector< double > sweeper_impl::plan()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _plan_changed ? _next_freqs : _freqs;
+}
+
+double sweeper_impl::hop_rate()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _hop_rate;
+}
+
+uint64_t sweeper_impl::sweeps()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  return _sweeps;
+}
@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_SWEEPER_IMPL_H
+#define OSMOSDR_SWEEPER_IMPL_H
+
+#include <osmosdr/sweeper.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/fft/fft.h>
+#include <gnuradio/high_res_timer.h>
+
+class sweeper_impl : public osmosdr::sweeper
+{
+public:
+  sweeper_impl( osmosdr::source::sptr src, const std::vector< double > &freqs,
+                size_t fft_size, size_t averages, double settle, size_t chan );
+  ~sweeper_impl();
+
+  bool start();
+
+  void forecast( int noutput_items, gr_vector_int &ninput_items_required );
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+  void set_plan( const std::vector< double > &freqs );
+  std::vector< double > plan();
+
+  double hop_rate();
+  uint64_t sweeps();
+
+private:
+  enum state_t
+  {
+    RETUNING,  /* dropping samples until the rx_freq tag of the retune */
+    SETTLING,  /* dropping the settling time after it */
+    COLLECTING /* averaging FFTs */
+  };
+
+  void tune( size_t hop );
+  void accumulate( const gr_complex *in );
+  void emit( float *out );
+
+  osmosdr::source::sptr _src;
+  size_t _chan;
+  size_t _fft_size;
+  size_t _averages;
+  double _settle;
+
+  boost::mutex _mutex; /* guards the plan and the statistics */
+  std::vector< double > _freqs;
+  std::vector< double > _next_freqs; /* set_plan() waiting for the next hop */
+  bool _plan_changed;
+  double _hop_rate;
+  uint64_t _sweeps;
+
+  gr::fft::fft_complex _fft;
+  std::vector< float > _window;
+  float _norm; /* the power gain of the window */
+  std::vector< float > _acc;
+
+  state_t _state;
+  size_t _hop;
+  double _requested; /* last frequency posted to the source */
+  double _actual;    /* the one it reported in the rx_freq tag */
+  double _rate;
+  uint64_t _skip;    /* samples left to drop */
+  size_t _count;     /* FFTs accumulated */
+  gr::high_res_timer_type _sweep_start;
+};
+
+#endif // OSMOSDR_SWEEPER_IMPL_H
@@ -0,0 +1,257 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "stream_tags.h"
+#include "time_align.h"
+
+#define START_LEAD 1.0 /* seconds between the first timestamp and the start */
+
+void time_align_group::join()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _members++;
+}
+
+void time_align_group::leave()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  /* pick a new start time once the whole group gets restarted */
+  if ( _members && --_members == 0 )
+    _valid = false;
+}
+
+osmosdr::time_spec_t time_align_group::start_time( const osmosdr::time_spec_t &first )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( ! _valid ) {
+    _start = osmosdr::time_spec_t( time_t( ceil( first.get_real_secs() + START_LEAD ) ) );
+    _valid = true;
+  }
+
+  return _start;
+}
+
+/* Samples from \p time to \p start, exact for the integer rates of most devices. */
+static uint64_t samples_until( const osmosdr::time_spec_t &start,
+                               const osmosdr::time_spec_t &time, double rate )
+{
+  const long long tick_rate = (long long)( rate + 0.5 );
+  long long ahead;
+
+  if ( double( tick_rate ) == rate )
+    ahead = osmosdr::tick_spec_t( start, tick_rate ).ticks_since(
+              osmosdr::tick_spec_t( time, tick_rate ) );
+  else
+    ahead = (long long)( floor( (start - time).get_real_secs() * rate + 0.5 ) );
+
+  return uint64_t( std::max( 0LL, ahead ) );
+}
+
+static bool by_offset( const gr::tag_t &a, const gr::tag_t &b )
+{
+  return a.offset < b.offset;
+}
+
+time_align_sptr make_time_align( size_t itemsize,
+                                 const time_align_group::sptr &group,
+                                 const std::string &name )
+{
+  return gnuradio::get_initial_sptr( new time_align( itemsize, group, name ) );
+}
+
+time_align::time_align( size_t itemsize,
+                        const time_align_group::sptr &group,
+                        const std::string &name ) :
+  gr::block("time_align",
+            gr::io_signature::make(1, 1, itemsize),
+            gr::io_signature::make(1, 1, itemsize)),
+  _itemsize(itemsize),
+  _group(group),
+  _name(name),
+  _state(WAITING),
+  _first(0),
+  _dropped(0),
+  _rate(0),
+  _freq(0)
+{
+  /* tags of dropped samples are discarded, the others moved by hand */
+  set_tag_propagation_policy( TPP_DONT );
+}
+
+bool time_align::start()
+{
+  _group->join();
+
+  _state = WAITING;
+  _first = 0;
+  _dropped = 0;
+
+  return true;
+}
+
+bool time_align::stop()
+{
+  _group->leave();
+
+  return true;
+}
+
+/* Look for the timestamp of the first sample at \p offset. */
+void time_align::begin( uint64_t offset )
+{
+  std::vector< gr::tag_t > tags;
+  bool have_time = false;
+  osmosdr::time_spec_t time;
+
+  get_tags_in_range( tags, 0, offset, offset + 1 );
+
+  BOOST_FOREACH( const gr::tag_t &tag, tags ) {
+    if ( pmt::eqv( tag.key, RX_TIME_KEY ) ) {
+      time = tag_to_time( tag.value );
+      have_time = true;
+    } else if ( pmt::eqv( tag.key, RX_RATE_KEY ) ) {
+      _rate = pmt::to_double( tag.value );
+    } else if ( pmt::eqv( tag.key, RX_FREQ_KEY ) ) {
+      _freq = pmt::to_double( tag.value );
+    }
+  }
+
+  if ( ! have_time || _rate <= 0 ) {
+    std::cerr << _name << " doesn't timestamp its samples, "
+              << "channel not aligned." << std::endl;
+    _state = PASSING;
+    return;
+  }
+
+  _start = _group->start_time( time );
+
+  if ( _start < time ) {
+    std::cerr << _name << " started "
+              << (time - _start).get_real_secs() << " s late, "
+              << "channel not aligned." << std::endl;
+    _state = PASSING;
+    return;
+  }
+
+  _first = uint64_t(-1); /* set from the timestamp by general_work() */
+  _state = DROPPING;
+}
+
+int time_align::general_work( int noutput_items,
+                              gr_vector_int &ninput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  const char *in = (const char *) input_items[0];
+  char *out = (char *) output_items[0];
+
+  const uint64_t nread = nitems_read(0);
+  const int ninput = ninput_items[0];
+
+  if ( WAITING == _state )
+    begin( nread );
+
+  std::vector< gr::tag_t > tags;
+  get_tags_in_range( tags, 0, nread, nread + ninput );
+  std::sort( tags.begin(), tags.end(), by_offset );
+
+  int skip = 0;
+
+  if ( DROPPING == _state ) {
+    /* every timestamp up to the start, discontinuities included, moves it */
+    osmosdr::time_spec_t time;
+    bool have_time = false;
+
+    for (size_t i = 0; i < tags.size() && tags[i].offset < _first; i++) {
+      const gr::tag_t &tag = tags[i];
+
+      if ( pmt::eqv( tag.key, RX_TIME_KEY ) ) {
+        time = tag_to_time( tag.value );
+        have_time = true;
+      } else if ( pmt::eqv( tag.key, RX_RATE_KEY ) ) {
+        _rate = pmt::to_double( tag.value );
+      } else if ( pmt::eqv( tag.key, RX_FREQ_KEY ) ) {
+        _freq = pmt::to_double( tag.value );
+      }
+
+      /* apply the timestamp once all tags of its sample are known */
+      if ( have_time && (i + 1 == tags.size() || tags[i + 1].offset != tag.offset) ) {
+        _first = tag.offset + samples_until( _start, time, _rate );
+        have_time = false;
+      }
+    }
+
+    skip = int( std::min( _first - nread, uint64_t( ninput ) ) );
+    _dropped += skip;
+
+    if ( nread + skip < _first ) {
+      consume_each( skip );
+      return 0;
+    }
+
+    /* our own tags replace the ones of the first kept sample */
+    std::vector< gr::tag_t > kept;
+    BOOST_FOREACH( const gr::tag_t &tag, tags )
+      if ( tag.offset != _first || ! ( pmt::eqv( tag.key, RX_TIME_KEY ) ||
+                                       pmt::eqv( tag.key, RX_RATE_KEY ) ||
+                                       pmt::eqv( tag.key, RX_FREQ_KEY ) ) )
+        kept.push_back( tag );
+    tags.swap( kept );
+
+    BOOST_FOREACH( const gr::tag_t &tag,
+                   make_rx_tags( _first - _dropped, _start, _rate, _freq, _name ) )
+      add_item_tag( 0, tag );
+
+    _state = PASSING;
+  }
+
+  const int n = std::min( ninput - skip, noutput_items );
+
+  memcpy( out, in + skip * _itemsize, n * _itemsize );
+
+  BOOST_FOREACH( gr::tag_t tag, tags ) {
+    if ( tag.offset < nread + skip || tag.offset >= nread + skip + n )
+      continue;
+
+    tag.offset -= _dropped;
+    add_item_tag( 0, tag );
+  }
+
+  consume_each( skip + n );
+
+  return n;
+}
@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_TIME_ALIGN_H
+#define OSMOSDR_TIME_ALIGN_H
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <gnuradio/block.h>
+
+#include "osmosdr/time_spec.h"
+
+/*!
+ * \brief Agrees on the start time of a group of time_align blocks.
+ *
+ * The first channel to see its first timestamp picks the start as the
+ * next full second at least START_LEAD seconds ahead, so the slower
+ * devices of the group have time to start streaming as well.
+ */
+class time_align_group
+{
+public:
+  typedef boost::shared_ptr< time_align_group > sptr;
+
+  time_align_group() : _members(0), _valid(false) {}
+
+  void join();
+  void leave();
+
+  /*! \return the common start time for a channel first seeing \p first */
+  osmosdr::time_spec_t start_time( const osmosdr::time_spec_t &first );
+
+private:
+  boost::mutex _mutex;
+  size_t _members;
+  bool _valid;
+  osmosdr::time_spec_t _start;
+};
+
+class time_align;
+
+typedef boost::shared_ptr< time_align > time_align_sptr;
+
+time_align_sptr make_time_align( size_t itemsize,
+                                 const time_align_group::sptr &group,
+                                 const std::string &name );
+
+/*!
+ * \brief Drops the samples of one channel preceding the common start time.
+ *
+ * Expects rx_time and rx_rate tags on the first sample as produced by the
+ * timestamping backends, channels without them are passed through as is.
+ * The first kept sample is tagged again with its rx_time, other tags are
+ * moved along with their samples.
+ */
+class time_align : public gr::block
+{
+private:
+  friend time_align_sptr make_time_align( size_t itemsize,
+                                          const time_align_group::sptr &group,
+                                          const std::string &name );
+
+  time_align( size_t itemsize,
+              const time_align_group::sptr &group,
+              const std::string &name );
+
+public:
+  bool start();
+  bool stop();
+
+  int general_work( int noutput_items,
+                    gr_vector_int &ninput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items );
+
+private:
+  enum state_t { WAITING, DROPPING, PASSING };
+
+  void begin( uint64_t offset );
+
+  size_t _itemsize;
+  time_align_group::sptr _group;
+  std::string _name;
+
+  state_t _state;
+  uint64_t _first;    /* offset of the first sample to keep */
+  uint64_t _dropped;  /* samples dropped so far */
+  osmosdr::time_spec_t _start;
+  double _rate;
+  double _freq;
+};
+
+#endif // OSMOSDR_TIME_ALIGN_H
@@ -17,6 +17,7 @@
 
 #include <osmosdr/time_spec.h>
 #include <ciso646>
+#include <stdexcept>
 
 using namespace osmosdr;
 
@@ -162,3 +163,79 @@ bool osmosdr::operator<(const time_spec_t &lhs, const time_spec_t &rhs){
         (lhs.get_frac_secs() < rhs.get_frac_secs())
     ));
 }
+
+/***********************************************************************
+ * Tick spec implementation code
+ **********************************************************************/
+#define tick_spec_init(full, ticks, rate) { \
+    if (rate < 1) throw std::invalid_argument("tick rate must be at least 1"); \
+    _tick_rate = rate; \
+    _full_secs = time_t(full) + time_t((ticks) / rate); \
+    _ticks = (ticks) % rate; \
+    if (_ticks < 0) { \
+        _full_secs -= 1; \
+        _ticks += rate; \
+    } \
+}
+
+tick_spec_t::tick_spec_t(time_t full_secs, long long ticks, long long tick_rate){
+    tick_spec_init(full_secs, ticks, tick_rate);
+}
+
+tick_spec_t::tick_spec_t(const time_spec_t &time, long long tick_rate){
+    //the fractional seconds are non-negative, so is the rounded tick count
+    tick_spec_init(time.get_full_secs(),
+                   fast_llround(time.get_frac_secs()*double(tick_rate)), tick_rate);
+}
+
+tick_spec_t tick_spec_t::from_ticks(long long ticks, long long tick_rate){
+    return tick_spec_t(0, ticks, tick_rate);
+}
+
+long long tick_spec_t::to_ticks(void) const{
+    return this->_full_secs*this->_tick_rate + this->_ticks;
+}
+
+double tick_spec_t::get_frac_secs(void) const{
+    return double(this->_ticks)/double(this->_tick_rate);
+}
+
+time_spec_t tick_spec_t::to_time_spec(void) const{
+    return time_spec_t(this->_full_secs, this->get_frac_secs());
+}
+
+tick_spec_t &tick_spec_t::operator+=(long long ticks){
+    tick_spec_init(this->_full_secs, this->_ticks + ticks, this->_tick_rate);
+    return *this;
+}
+
+tick_spec_t &tick_spec_t::operator-=(long long ticks){
+    tick_spec_init(this->_full_secs, this->_ticks - ticks, this->_tick_rate);
+    return *this;
+}
+
+/* ticks of t at rate, rounded, without overflowing for rates up to ~3 GHz */
+static long long ticks_at_rate(const tick_spec_t &t, long long rate){
+    if (t.get_tick_rate() == rate) return t.get_ticks();
+    return (t.get_ticks()*rate + t.get_tick_rate()/2)/t.get_tick_rate();
+}
+
+long long tick_spec_t::ticks_since(const tick_spec_t &rhs) const{
+    const long long secs = this->_full_secs - rhs.get_full_secs();
+    return secs*this->_tick_rate + this->_ticks - ticks_at_rate(rhs, this->_tick_rate);
+}
+
+bool osmosdr::operator==(const tick_spec_t &lhs, const tick_spec_t &rhs){
+    return
+        lhs.get_full_secs() == rhs.get_full_secs() and
+        lhs.get_ticks()*rhs.get_tick_rate() == rhs.get_ticks()*lhs.get_tick_rate()
+    ;
+}
+
+bool osmosdr::operator<(const tick_spec_t &lhs, const tick_spec_t &rhs){
+    return (
+        (lhs.get_full_secs() < rhs.get_full_secs()) or (
+        (lhs.get_full_secs() == rhs.get_full_secs()) and
+        (lhs.get_ticks()*rhs.get_tick_rate() < rhs.get_ticks()*lhs.get_tick_rate())
+    ));
+}
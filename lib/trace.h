@@ -0,0 +1,89 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_TRACE_H
+#define OSMOSDR_TRACE_H
+
+/*
+ * Per transfer latency tracing, compiled in with -DENABLE_TRACING=ON and
+ * compiled out entirely otherwise, the macro arguments aren't evaluated.
+ *
+ * TRACE_ARRIVAL( backend, len ) marks a transfer of len bytes handed over
+ * by the driver, in the usb callback or read thread.
+ *
+ * TRACE_OUTPUT( block, backend, offset, arrival ) marks the first sample of
+ * the transfer which arrived at high_res_timer time arrival leaving work()
+ * at output item offset. The sample is tagged with "latency", a tuple of
+ * the arrival and output times in seconds on high_res_timer, so the time
+ * spent in the GR buffers can be measured downstream, and srcid backend.
+ *
+ * Where <sys/sdt.h> is available both are USDT probes as well, provider
+ * osmosdr, probes arrival( backend, now, len ) and output( backend,
+ * arrival, now ) in high_res_timer ticks, for perf, bpftrace or lttng:
+ *
+ *   bpftrace -e 'usdt:libgnuradio-osmosdr.so:osmosdr:output
+ *                { @us = hist((arg2 - arg1) / 1000); }'
+ */
+
+#define LATENCY_TAG_KEY "latency"
+
+#ifdef ENABLE_TRACING
+
+#include <stdint.h>
+
+#include <gnuradio/block.h>
+#include <gnuradio/high_res_timer.h>
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define TRACE_PROBE( name, a, b, c ) DTRACE_PROBE3( osmosdr, name, a, b, c )
+#else
+#define TRACE_PROBE( name, a, b, c ) do {} while (0)
+#endif
+
+#define TRACE_ARRIVAL( backend, len ) \
+  TRACE_PROBE( arrival, backend, (long long) gr::high_res_timer_now(), (long) (len) )
+
+#define TRACE_OUTPUT( block, backend, offset, arrival ) \
+  trace_output( block, backend, offset, arrival )
+
+static inline void trace_output( gr::block *block, const char *backend,
+                                 uint64_t offset, gr::high_res_timer_type arrival )
+{
+  static const pmt::pmt_t key = pmt::intern( LATENCY_TAG_KEY );
+
+  const gr::high_res_timer_type now = gr::high_res_timer_now();
+  const double tps = gr::high_res_timer_tps();
+
+  TRACE_PROBE( output, backend, (long long) arrival, (long long) now );
+
+  block->add_item_tag( 0, offset, key,
+                       pmt::make_tuple( pmt::from_double( arrival / tps ),
+                                        pmt::from_double( now / tps ) ),
+                       pmt::intern( backend ) );
+}
+
+#else
+
+#define TRACE_ARRIVAL( backend, len ) do {} while (0)
+#define TRACE_OUTPUT( block, backend, offset, arrival ) do {} while (0)
+
+#endif /* ENABLE_TRACING */
+
+#endif /* OSMOSDR_TRACE_H */
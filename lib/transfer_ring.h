@@ -0,0 +1,304 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef OSMOSDR_TRANSFER_RING_H
+#define OSMOSDR_TRANSFER_RING_H
+
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <gnuradio/high_res_timer.h>
+
+#include "buffer_pool.h"
+
+/*!
+ * \brief Lock-free single producer / single consumer queue of transfer
+ * sized buffers.
+ *
+ * For sources the producer side is meant to be called from the usb callback
+ * thread of the vendor library and the consumer side from the block's work()
+ * function, sinks use it the other way round. Each side only modifies its
+ * own index, so no lock is taken on the hot path.
+ *
+ * The mutex and condition variable are only used to park a starving consumer
+ * in wait() or a producer facing a full ring in wait_free(). The other side
+ * takes the mutex only if the waiting one announced that it is about to
+ * sleep. boost::condition_variable::wait() is an interruption
+ * point, so the gnuradio scheduler is still able to stop a consumer waiting
+ * for samples.
+ *
+ * Each buffer is stamped with gr::high_res_timer_now() when it is committed,
+ * so the consumer can account for the time it spent waiting in the ring.
+ *
+ * The buffers are carved from a single buffer_pool region, placed as given
+ * by the buffer_pool_params of the device arguments.
+ */
+class transfer_ring : boost::noncopyable
+{
+public:
+  transfer_ring()
+    : _buf(NULL), _lens(NULL), _stamps(NULL), _num(0), _len(0),
+      _head(0), _tail(0), _parked(false), _writer_parked(false),
+      _cancelled(false)
+  {
+  }
+
+  ~transfer_ring()
+  {
+    release();
+  }
+
+  /*!
+   * Allocate \p num buffers of \p len bytes each.
+   * Must not be called while a producer or consumer is active.
+   */
+  void alloc( size_t num, size_t len,
+              const buffer_pool_params &params = buffer_pool_params() )
+  {
+    release();
+
+    /* keep the buffers on separate cache lines */
+    const size_t stride = (len + 63) & ~size_t(63);
+
+    _buf = (unsigned char **) malloc(num * sizeof(unsigned char *));
+    _lens = (size_t *) malloc(num * sizeof(size_t));
+    _stamps = (gr::high_res_timer_type *) malloc(num * sizeof(gr::high_res_timer_type));
+
+    unsigned char *region = (unsigned char *) _pool.alloc(num * stride, params);
+
+    if (_buf && _lens && _stamps && region) {
+      for (size_t i = 0; i < num; ++i) {
+        _buf[i] = region + i * stride;
+        _lens[i] = 0;
+        _stamps[i] = 0;
+      }
+
+      _num = num;
+      _len = len;
+    }
+
+    reset();
+  }
+
+  /*!
+   * Drop all queued buffers and clear the cancelled state.
+   * Must not be called while a producer or consumer is active.
+   */
+  void reset()
+  {
+    _head.store(0);
+    _tail.store(0);
+    _parked.store(false);
+    _writer_parked.store(false);
+    _cancelled.store(false);
+  }
+
+  size_t num() const { return _num; }
+  size_t len() const { return _len; }
+
+  /*! Number of filled buffers waiting for the consumer. */
+  size_t used() const
+  {
+    return _tail.load(boost::memory_order_acquire) -
+           _head.load(boost::memory_order_acquire);
+  }
+
+  /* producer side */
+
+  /*!
+   * Get the next free buffer to be filled by the producer.
+   * \param ahead skip this many free buffers, to fill several of them
+   *        before committing them in order
+   * \return pointer to the buffer or NULL if the ring is full
+   */
+  unsigned char *acquire( size_t ahead = 0 )
+  {
+    const size_t tail = _tail.load(boost::memory_order_relaxed) + ahead;
+
+    if (tail - _head.load(boost::memory_order_acquire) >= _num)
+      return NULL;
+
+    return _buf[tail % _num];
+  }
+
+  /*!
+   * Block until at least \p count buffers are free.
+   * \return false if the ring has been cancelled while waiting
+   */
+  bool wait_free( size_t count )
+  {
+    while (_num - used() < count && !_cancelled.load()) {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      _writer_parked.store(true, boost::memory_order_seq_cst);
+
+      if (_num - used() < count && !_cancelled.load())
+        _cond.wait( lock );
+
+      _writer_parked.store(false, boost::memory_order_relaxed);
+    }
+
+    return !_cancelled.load();
+  }
+
+  /*! Publish the buffer returned by acquire() holding \p len bytes. */
+  void commit( size_t len )
+  {
+    const size_t tail = _tail.load(boost::memory_order_relaxed);
+
+    _lens[tail % _num] = len;
+    _stamps[tail % _num] = gr::high_res_timer_now();
+    _tail.store(tail + 1, boost::memory_order_seq_cst);
+
+    if (_parked.load(boost::memory_order_seq_cst))
+      notify();
+  }
+
+  /*!
+   * Copy \p len bytes into the next free buffer and publish it.
+   * \return false if the ring is full and the data has been dropped
+   */
+  bool push( const void *data, size_t len )
+  {
+    unsigned char *dst = acquire();
+
+    if (dst == NULL)
+      return false;
+
+    if (len > _len)
+      len = _len;
+
+    memcpy(dst, data, len);
+    commit(len);
+
+    return true;
+  }
+
+  /* consumer side */
+
+  /*!
+   * Get the oldest filled buffer.
+   * \param len if not NULL, receives the number of valid bytes
+   * \return pointer to the buffer or NULL if the ring is empty
+   */
+  const unsigned char *front( size_t *len = NULL ) const
+  {
+    const size_t head = _head.load(boost::memory_order_relaxed);
+
+    if (_tail.load(boost::memory_order_acquire) == head)
+      return NULL;
+
+    if (len)
+      *len = _lens[head % _num];
+
+    return _buf[head % _num];
+  }
+
+  /*! Time the buffer returned by front() has been committed at. */
+  gr::high_res_timer_type front_stamp() const
+  {
+    return _stamps[_head.load(boost::memory_order_relaxed) % _num];
+  }
+
+  /*! Hand the buffer returned by front() back to the producer. */
+  void pop()
+  {
+    _head.store(_head.load(boost::memory_order_relaxed) + 1,
+                boost::memory_order_seq_cst);
+
+    if (_writer_parked.load(boost::memory_order_seq_cst))
+      notify();
+  }
+
+  /*!
+   * Block until at least \p count buffers are available.
+   * \return false if the ring has been cancelled while waiting
+   */
+  bool wait( size_t count )
+  {
+    while (used() < count && !_cancelled.load()) {
+      boost::mutex::scoped_lock lock( _mutex );
+
+      _parked.store(true, boost::memory_order_seq_cst);
+
+      if (used() < count && !_cancelled.load())
+        _cond.wait( lock );
+
+      _parked.store(false, boost::memory_order_relaxed);
+    }
+
+    return !_cancelled.load();
+  }
+
+  /*! Wake up both sides and make any further wait() return false. */
+  void cancel()
+  {
+    _cancelled.store(true);
+    notify();
+  }
+
+  bool cancelled() const { return _cancelled.load(); }
+
+private:
+  void notify()
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _cond.notify_all();
+  }
+
+  void release()
+  {
+    free(_buf);
+    _buf = NULL;
+
+    _pool.release();
+
+    free(_lens);
+    _lens = NULL;
+
+    free(_stamps);
+    _stamps = NULL;
+
+    _num = _len = 0;
+  }
+
+  buffer_pool _pool;
+  unsigned char **_buf;
+  size_t *_lens;
+  gr::high_res_timer_type *_stamps;
+  size_t _num;
+  size_t _len;
+
+  boost::atomic<size_t> _head;
+  boost::atomic<size_t> _tail;
+  boost::atomic<bool> _parked;
+  boost::atomic<bool> _writer_parked;
+  boost::atomic<bool> _cancelled;
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+};
+
+#endif // OSMOSDR_TRANSFER_RING_H
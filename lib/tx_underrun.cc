@@ -0,0 +1,322 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "tx_underrun.h"
+
+tx_underrun_params::tx_underrun_params( const dict_t &dict )
+  : policy(ZERO), preroll(0)
+{
+  dict_t::const_iterator it;
+
+  if ( (it = dict.find( "underrun" )) != dict.end() ) {
+    if ( "zero" == it->second )
+      policy = ZERO;
+    else if ( "repeat" == it->second )
+      policy = REPEAT;
+    else if ( "stall" == it->second )
+      policy = STALL;
+    else
+      throw std::runtime_error( "Unknown underrun policy " + it->second +
+                                ", use zero, repeat or stall." );
+  }
+
+  if ( (it = dict.find( "preroll" )) != dict.end() )
+    preroll = boost::lexical_cast< size_t >( it->second );
+}
+
+tx_keepalive::tx_keepalive( stream_stats &stats )
+  : _stats(stats),
+    _nchan(0),
+    _sample_size(0),
+    _block(0),
+    _rate(0),
+    _drain(0),
+    _running(false),
+    _writing(false),
+    _starving(false),
+    _priming(false),
+    _idle(false),
+    _last_write(0)
+{
+}
+
+tx_keepalive::~tx_keepalive()
+{
+  stop();
+}
+
+void tx_keepalive::start( const tx_underrun_params &params, const write_t &write,
+                          size_t nchan, size_t sample_size, size_t block,
+                          double rate, double drain )
+{
+  stop();
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _params = params;
+  _write = write;
+  _nchan = nchan;
+  _sample_size = sample_size;
+  _block = block;
+  _rate = rate;
+  _drain = gr::high_res_timer_type( drain * gr::high_res_timer_tps() );
+
+  _zeros.assign( block * sample_size, 0 );
+  _last.assign( params.policy == tx_underrun_params::REPEAT ? nchan : 0,
+                std::vector< char >() );
+  _pending.assign( nchan, std::vector< char >() );
+
+  _writing = false;
+  _starving = false;
+  _priming = (params.preroll > 0);
+  _idle = false;
+  _last_write = 0;
+
+  _running = true;
+  _thread = gr::thread::thread( boost::bind( &tx_keepalive::fill_task, this ) );
+}
+
+void tx_keepalive::stop()
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    if ( ! _running )
+      return;
+
+    _running = false;
+    _cond.notify_all();
+  }
+
+  _thread.join();
+
+  /* a transmission shorter than the pre-roll is still sent */
+  if ( _pending.size() && _pending[0].size() ) {
+    const size_t pending = _pending[0].size() / _sample_size;
+    size_t done = 0;
+
+    while ( done < pending ) {
+      std::vector< const void * > ptrs( _nchan );
+      for (size_t i = 0; i < _nchan; i++)
+        ptrs[i] = &_pending[i][done * _sample_size];
+
+      int ret = _write( &ptrs[0], pending - done );
+      if ( ret <= 0 )
+        break;
+
+      done += ret;
+    }
+
+    for (size_t i = 0; i < _nchan; i++)
+      _pending[i].clear();
+  }
+}
+
+void tx_keepalive::set_idle( bool idle )
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  _idle = idle;
+}
+
+int tx_keepalive::write( const void * const *buffs, size_t count )
+{
+  if ( ! _running )
+    return _write ? _write( buffs, count ) : -1;
+
+  bool priming;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    _idle = false;
+    priming = _priming;
+  }
+
+  if ( ! priming )
+    return device_write( buffs, count, _write, false );
+
+  /* only work() touches the pending samples */
+  for (size_t i = 0; i < _nchan; i++) {
+    const char *src = (const char *) buffs[i];
+    _pending[i].insert( _pending[i].end(), src, src + count * _sample_size );
+  }
+
+  const size_t pending = _pending[0].size() / _sample_size;
+  if ( pending < _params.preroll )
+    return count;
+
+  std::vector< const void * > ptrs( _nchan );
+  for (size_t i = 0; i < _nchan; i++)
+    ptrs[i] = &_pending[i][0];
+
+  /* write all of it, the caller only knows about the last call */
+  size_t done = 0;
+  int ret = 0;
+
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+    _priming = false;
+  }
+
+  while ( done < pending ) {
+    ret = device_write( &ptrs[0], pending - done, _write, false );
+    if ( ret <= 0 )
+      break;
+
+    done += ret;
+    for (size_t i = 0; i < _nchan; i++)
+      ptrs[i] = &_pending[i][done * _sample_size];
+  }
+
+  for (size_t i = 0; i < _nchan; i++)
+    _pending[i].clear();
+
+  return ret < 0 ? ret : int(count);
+}
+
+int tx_keepalive::write( const void * const *buffs, size_t count, const write_t &write )
+{
+  if ( ! _running )
+    return write( buffs, count );
+
+  return device_write( buffs, count, write, false );
+}
+
+int tx_keepalive::device_write( const void * const *buffs, size_t count,
+                                const write_t &write, bool fill )
+{
+  {
+    boost::mutex::scoped_lock lock( _mutex );
+
+    const gr::high_res_timer_type now = gr::high_res_timer_now();
+
+    /* nothing filled the gap, the device ran dry for the rest of it */
+    if ( ! fill && ! _starving && _last_write && now - _last_write > _drain &&
+         _params.policy == tx_underrun_params::STALL ) {
+      const double gap = double(now - _last_write - _drain) / gr::high_res_timer_tps();
+      _stats.overflow( uint64_t(gap * _rate) );
+    }
+
+    if ( ! fill )
+      _starving = false;
+
+    _writing = true;
+  }
+
+  int ret;
+
+  {
+    boost::mutex::scoped_lock lock( _write_mutex );
+
+    std::vector< const void * > ptrs;
+
+    /* the last block written by work(), if any, or zeros */
+    if ( fill ) {
+      const bool repeat = _last.size() && _last[0].size();
+
+      count = repeat ? _last[0].size() / _sample_size : _block;
+
+      for (size_t i = 0; i < _nchan; i++)
+        ptrs.push_back( repeat ? &_last[i][0] : &_zeros[0] );
+
+      buffs = &ptrs[0];
+    }
+
+    ret = write( buffs, count );
+
+    /* the tail of what work() wrote is the block to repeat */
+    if ( ! fill && ret > 0 && _last.size() ) {
+      const size_t n = std::min( size_t(ret), _block );
+
+      for (size_t i = 0; i < _nchan; i++) {
+        const char *src = (const char *) buffs[i] + (ret - n) * _sample_size;
+        _last[i].assign( src, src + n * _sample_size );
+      }
+    }
+  }
+
+  boost::mutex::scoped_lock lock( _mutex );
+
+  if ( fill && ret > 0 )
+    _stats.extend( ret );
+
+  _writing = false;
+  _last_write = gr::high_res_timer_now();
+  _cond.notify_all();
+
+  return ret;
+}
+
+void tx_keepalive::fill_task()
+{
+  boost::mutex::scoped_lock lock( _mutex );
+
+  const boost::posix_time::microseconds poll(
+        std::max( gr::high_res_timer_type(1000),
+                  _drain * 1000000 / gr::high_res_timer_tps() / 4 ) );
+
+  while ( _running ) {
+    if ( ! _starving )
+      _cond.timed_wait( lock, poll );
+
+    if ( ! _running )
+      break;
+
+    const gr::high_res_timer_type now = gr::high_res_timer_now();
+
+    if ( _idle || _writing || ! _last_write ||
+         _params.policy == tx_underrun_params::STALL ||
+         (! _starving && now - _last_write < _drain / 2) ) {
+      _starving = false;
+      continue;
+    }
+
+    /* keep writing back to back until work() catches up */
+    if ( ! _starving ) {
+      _starving = true;
+      _priming = (_params.preroll > 0);
+      _stats.overflow( 0 ); /* the samples are added as they are written */
+    }
+
+    lock.unlock();
+    int ret = device_write( NULL, 0, _write, true );
+    lock.lock();
+
+    if ( ret < 0 ) {
+      std::cerr << "tx_keepalive: filling in the underrun failed ("
+                << ret << ")" << std::endl;
+      _starving = false;
+      _last_write = gr::high_res_timer_now();
+    }
+  }
+}
@@ -0,0 +1,140 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_TX_UNDERRUN_H
+#define OSMOSDR_TX_UNDERRUN_H
+
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/thread/thread.h>
+
+#include <osmosdr/api.h>
+
+#include "arg_helpers.h"
+#include "stream_stats.h"
+
+/*!
+ * What a sink transmits while the flowgraph doesn't deliver samples in
+ * time, given by the device arguments:
+ *
+ *   underrun=zero|repeat|stall  zeros (default), the last buffer again,
+ *                               or nothing, letting the device run dry
+ *   preroll=N                   samples to queue before transmitting
+ *                               (again after each underrun), so a slow
+ *                               start doesn't underrun right away
+ */
+struct OSMOSDR_API tx_underrun_params
+{
+  enum policy_t { ZERO, REPEAT, STALL };
+
+  tx_underrun_params() : policy(ZERO), preroll(0) {}
+
+  explicit tx_underrun_params( const dict_t &dict );
+
+  policy_t policy;
+  size_t preroll;
+};
+
+/*!
+ * \brief Keeps a device written to by blocking calls transmitting while
+ * the flowgraph is late.
+ *
+ * A write returning means the driver buffers are at most full, so once
+ * no write happened for half the time they last, the device is about to
+ * run dry. A thread then writes zeros or repeats the last block, back to
+ * back, until work() writes again. Both write through the same function,
+ * serialized here.
+ *
+ * Underruns are counted in the stream_stats of the sink, also with the
+ * stall policy, where they are detected once work() writes again.
+ */
+class OSMOSDR_API tx_keepalive : boost::noncopyable
+{
+public:
+  /*!
+   * Write \p count samples of each channel to the device.
+   * \return the number of samples written or a negative error code
+   */
+  typedef boost::function< int ( const void * const *buffs, size_t count ) > write_t;
+
+  explicit tx_keepalive( stream_stats &stats );
+  ~tx_keepalive();
+
+  /*!
+   * \param sample_size bytes per sample in the format written
+   * \param block samples per write of the thread
+   * \param drain seconds the driver buffers last once full
+   */
+  void start( const tx_underrun_params &params, const write_t &write,
+              size_t nchan, size_t sample_size, size_t block,
+              double rate, double drain );
+  void stop();
+
+  /*!
+   * Write from work(), held back while pre-rolling. Before start() this is
+   * the write function itself.
+   * \return \p count while pre-rolling, else as write_t
+   */
+  int write( const void * const *buffs, size_t count );
+
+  /*! As above, through \p write, e.g. for a burst with flags of its own */
+  int write( const void * const *buffs, size_t count, const write_t &write );
+
+  /*! Between bursts the device is meant to run dry, nothing is filled in. */
+  void set_idle( bool idle );
+
+private:
+  int device_write( const void * const *buffs, size_t count,
+                    const write_t &write, bool fill );
+  void fill_task();
+
+  stream_stats &_stats;
+
+  tx_underrun_params _params;
+  write_t _write;
+  size_t _nchan;
+  size_t _sample_size;
+  size_t _block;
+  double _rate;
+  gr::high_res_timer_type _drain;   /* in high_res_timer ticks */
+
+  std::vector< std::vector< char > > _last;    /* per channel, REPEAT only */
+  std::vector< std::vector< char > > _pending; /* per channel, pre-rolling */
+  std::vector< char > _zeros;
+
+  boost::mutex _write_mutex;        /* held while writing to the device */
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  bool _running;
+  bool _writing;                    /* a write is in progress */
+  bool _starving;                   /* the thread is filling in */
+  bool _priming;                    /* work() writes are held back */
+  bool _idle;
+  gr::high_res_timer_type _last_write; /* 0 until the first write */
+  gr::thread::thread _thread;
+};
+
+#endif // OSMOSDR_TX_UNDERRUN_H
@@ -27,6 +27,8 @@
 #include "arg_helpers.h"
 
 #include "uhd_sink_c.h"
+#include "backend_registry.h"
+#include "stream_stats.h"
 
 using namespace boost::assign;
 
@@ -35,6 +37,12 @@ uhd_sink_c_sptr make_uhd_sink_c(const std::string &args)
   return gnuradio::get_initial_sptr(new uhd_sink_c(args));
 }
 
+static sink_registrar uhd_registrar(
+  "uhd",
+  &make_backend< sink_iface, uhd_sink_c_sptr, &make_uhd_sink_c >,
+  &ignore_fake< &uhd_sink_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_NETWORK, 40 );
+
 static size_t parse_nchan(const std::string &args)
 {
   size_t nchan = 1;
@@ -70,6 +78,15 @@ uhd_sink_c::uhd_sink_c(const std::string &args) :
   if (dict.count("lo_offset"))
     _lo_offset = boost::lexical_cast< double >( dict["lo_offset"] );
 
+  /* streamer=native sends without the gr-uhd usrp_sink in between */
+  std::string streamer = "gr-uhd";
+  if (dict.count("streamer"))
+    streamer = dict["streamer"];
+
+  if ( "gr-uhd" != streamer && "native" != streamer )
+    throw std::runtime_error("Unsupported streamer '" + streamer + "', "
+                             "use one of gr-uhd or native.");
+
   std::string arguments; // rebuild argument string without internal arguments
   BOOST_FOREACH( dict_t::value_type &entry, dict )
   {
@@ -80,6 +97,8 @@ uhd_sink_c::uhd_sink_c(const std::string &args) :
          "nchan" == entry.first ||
          "subdev" == entry.first ||
          "lo_offset" == entry.first ||
+         "streamer" == entry.first ||
+         "spp" == entry.first ||
          "uhd" == entry.first )
       continue;
 
@@ -104,18 +123,34 @@ uhd_sink_c::uhd_sink_c(const std::string &args) :
   if (dict.count("fullscale") )
     stream_args.args["fullscale"] = dict["fullscale"];
 
-  _snk = gr::uhd::usrp_sink::make( arguments, stream_args );
+  if (dict.count("spp") )
+    stream_args.args["spp"] = dict["spp"];
+
+  gr::basic_block_sptr block;
+
+  if ( "native" == streamer ) {
+    _dev = ::uhd::usrp::multi_usrp::make( arguments );
+    _tx = make_uhd_tx_streamer( _dev, stream_args );
+    block = _tx;
+
+    message_port_register_hier_out( STREAM_STATS_PORT );
+    msg_connect( _tx, STREAM_STATS_PORT, self(), STREAM_STATS_PORT );
+  } else {
+    _snk = gr::uhd::usrp_sink::make( arguments, stream_args );
+    _dev = _snk->get_device();
+    block = _snk;
+  }
 
   if (dict.count("subdev"))
-    _snk->set_subdev_spec( dict["subdev"] );
+    _dev->set_tx_subdev_spec( dict["subdev"], 0 );
 
-  std::cerr << "-- Using subdev spec '" << _snk->get_subdev_spec() << "'."
-            << std::endl;
+  std::cerr << "-- Using subdev spec '" << _dev->get_tx_subdev_spec( 0 ).to_string()
+            << "'." << std::endl;
 
   if (0.0 != _lo_offset)
     std::cerr << "-- Using LO offset of " << _lo_offset << " Hz." << std::endl;
 #if 0
-  std::vector<int> sizes = _snk->input_signature()->sizeof_stream_items();
+  std::vector<int> sizes = block->input_signature()->sizeof_stream_items();
 
   while ( sizes.size() > nchan )
     sizes.erase( sizes.end() );
@@ -123,7 +158,7 @@ uhd_sink_c::uhd_sink_c(const std::string &args) :
   set_input_signature( gr::io_signature::makev( nchan, nchan, sizes ) );
 #endif
   for ( size_t i = 0; i < nchan; i++ )
-    connect( self(), i, _snk, i );
+    connect( self(), i, block, i );
 }
 
 uhd_sink_c::~uhd_sink_c()
@@ -169,9 +204,9 @@ std::vector< std::string > uhd_sink_c::get_devices()
 
 std::string uhd_sink_c::name()
 {
-//  uhd::property_tree::sptr prop_tree = _snk->get_device()->get_device()->get_tree();
+//  uhd::property_tree::sptr prop_tree = _dev->get_device()->get_tree();
 //  std::string dev_name = prop_tree->access<std::string>("/name").get();
-  std::string mboard_name = _snk->get_device()->get_mboard_name();
+  std::string mboard_name = _dev->get_mboard_name();
 
 //  std::cerr << "'" << dev_name << "' '" << mboard_name << "'" << std::endl;
 //  'USRP1 Device' 'USRP1 (Classic)'
@@ -182,7 +217,7 @@ std::string uhd_sink_c::name()
 
 size_t uhd_sink_c::get_num_channels()
 {
-//  return _snk->get_device()->get_rx_num_channels();
+//  return _dev->get_tx_num_channels();
   return input_signature()->max_streams();
 }
 
@@ -190,7 +225,7 @@ osmosdr::meta_range_t uhd_sink_c::get_sample_rates( void )
 {
   osmosdr::meta_range_t rates;
 
-  BOOST_FOREACH( uhd::range_t rate, _snk->get_samp_rates() )
+  BOOST_FOREACH( uhd::range_t rate, _dev->get_tx_rates() )
       rates += osmosdr::range_t( rate.start(), rate.stop(), rate.step() );
 
   return rates;
@@ -198,20 +233,20 @@ osmosdr::meta_range_t uhd_sink_c::get_sample_rates( void )
 
 double uhd_sink_c::set_sample_rate( double rate )
 {
-  _snk->set_samp_rate( rate );
+  _dev->set_tx_rate( rate );
   return get_sample_rate();
 }
 
 double uhd_sink_c::get_sample_rate( void )
 {
-  return _snk->get_samp_rate();
+  return _dev->get_tx_rate();
 }
 
 osmosdr::freq_range_t uhd_sink_c::get_freq_range( size_t chan )
 {
   osmosdr::freq_range_t range;
 
-  BOOST_FOREACH( uhd::range_t freq, _snk->get_freq_range(chan) )
+  BOOST_FOREACH( uhd::range_t freq, _dev->get_tx_freq_range(chan) )
       range += osmosdr::range_t( freq.start(), freq.stop(), freq.step() );
 
   return range;
@@ -225,7 +260,7 @@ double uhd_sink_c::set_center_freq( double freq, size_t chan )
 
   // advanced tuning with tune_request_t
   uhd::tune_request_t tune_req(corr_freq, _lo_offset);
-  _snk->set_center_freq(tune_req, chan);
+  _dev->set_tx_freq(tune_req, chan);
 
   _center_freq = freq;
 
@@ -234,7 +269,7 @@ double uhd_sink_c::set_center_freq( double freq, size_t chan )
 
 double uhd_sink_c::get_center_freq( size_t chan )
 {
-  return _snk->get_center_freq(chan);
+  return _dev->get_tx_freq(chan);
 }
 
 double uhd_sink_c::set_freq_corr( double ppm, size_t chan )
@@ -253,14 +288,14 @@ double uhd_sink_c::get_freq_corr( size_t chan )
 
 std::vector<std::string> uhd_sink_c::get_gain_names( size_t chan )
 {
-  return _snk->get_gain_names( chan );
+  return _dev->get_tx_gain_names( chan );
 }
 
 osmosdr::gain_range_t uhd_sink_c::get_gain_range( size_t chan )
 {
   osmosdr::gain_range_t range;
 
-  BOOST_FOREACH( uhd::range_t gain, _snk->get_gain_range(chan) )
+  BOOST_FOREACH( uhd::range_t gain, _dev->get_tx_gain_range(chan) )
       range += osmosdr::range_t( gain.start(), gain.stop(), gain.step() );
 
   return range;
@@ -270,7 +305,7 @@ osmosdr::gain_range_t uhd_sink_c::get_gain_range( const std::string & name, size
 {
   osmosdr::gain_range_t range;
 
-  BOOST_FOREACH( uhd::range_t gain, _snk->get_gain_range(name, chan) )
+  BOOST_FOREACH( uhd::range_t gain, _dev->get_tx_gain_range(name, chan) )
       range += osmosdr::range_t( gain.start(), gain.stop(), gain.step() );
 
   return range;
@@ -278,49 +313,49 @@ osmosdr::gain_range_t uhd_sink_c::get_gain_range( const std::string & name, size
 
 double uhd_sink_c::set_gain( double gain, size_t chan )
 {
-  _snk->set_gain(gain, chan);
+  _dev->set_tx_gain(gain, chan);
 
   return get_gain(chan);
 }
 
 double uhd_sink_c::set_gain( double gain, const std::string & name, size_t chan )
 {
-  _snk->set_gain(gain, name, chan);
+  _dev->set_tx_gain(gain, name, chan);
 
   return get_gain(name, chan);
 }
 
 double uhd_sink_c::get_gain( size_t chan )
 {
-  return _snk->get_gain(chan);
+  return _dev->get_tx_gain(chan);
 }
 
 double uhd_sink_c::get_gain( const std::string & name, size_t chan )
 {
-  return _snk->get_gain(name, chan);
+  return _dev->get_tx_gain(name, chan);
 }
 
 std::vector< std::string > uhd_sink_c::get_antennas( size_t chan )
 {
-  return _snk->get_antennas(chan);
+  return _dev->get_tx_antennas(chan);
 }
 
 std::string uhd_sink_c::set_antenna( const std::string & antenna, size_t chan )
 {
-  _snk->set_antenna(antenna, chan);
+  _dev->set_tx_antenna(antenna, chan);
 
-  return _snk->get_antenna(chan);
+  return _dev->get_tx_antenna(chan);
 }
 
 std::string uhd_sink_c::get_antenna( size_t chan )
 {
-  return _snk->get_antenna(chan);
+  return _dev->get_tx_antenna(chan);
 }
 
 void uhd_sink_c::set_dc_offset( const std::complex<double> &offset, size_t chan )
 {
   try {
-    _snk->set_dc_offset( offset, chan );
+    _dev->set_tx_dc_offset( offset, chan );
   } catch ( const std::exception &ex ) {
     std::cerr << __FUNCTION__ << ": " << ex.what() << std::endl;
   }
@@ -329,7 +364,7 @@ void uhd_sink_c::set_dc_offset( const std::complex<double> &offset, size_t chan
 void uhd_sink_c::set_iq_balance( const std::complex<double> &balance, size_t chan )
 {
   try {
-    _snk->set_iq_balance( balance, chan );
+    _dev->set_tx_iq_balance( balance, chan );
   } catch ( const std::exception &ex ) {
     std::cerr << __FUNCTION__ << ": " << ex.what() << std::endl;
   }
@@ -337,21 +372,21 @@ void uhd_sink_c::set_iq_balance( const std::complex<double> &balance, size_t cha
 
 double uhd_sink_c::set_bandwidth( double bandwidth, size_t chan )
 {
-  _snk->set_bandwidth(bandwidth, chan);
+  _dev->set_tx_bandwidth(bandwidth, chan);
 
-  return _snk->get_bandwidth(chan);
+  return _dev->get_tx_bandwidth(chan);
 }
 
 double uhd_sink_c::get_bandwidth( size_t chan )
 {
-  return _snk->get_bandwidth(chan);
+  return _dev->get_tx_bandwidth(chan);
 }
 
 osmosdr::freq_range_t uhd_sink_c::get_bandwidth_range( size_t chan )
 {
   osmosdr::freq_range_t bandwidths;
 
-  BOOST_FOREACH( uhd::range_t bw, _snk->get_bandwidth_range(chan) )
+  BOOST_FOREACH( uhd::range_t bw, _dev->get_tx_bandwidth_range(chan) )
       bandwidths += osmosdr::range_t( bw.start(), bw.stop(), bw.step() );
 
   return bandwidths;
@@ -359,67 +394,75 @@ osmosdr::freq_range_t uhd_sink_c::get_bandwidth_range( size_t chan )
 
 void uhd_sink_c::set_time_source(const std::string &source, const size_t mboard)
 {
-  _snk->set_time_source( source, mboard );
+  _dev->set_time_source( source, mboard );
 }
 
 std::string uhd_sink_c::get_time_source(const size_t mboard)
 {
-  return _snk->get_time_source( mboard );
+  return _dev->get_time_source( mboard );
 }
 
 std::vector<std::string> uhd_sink_c::get_time_sources(const size_t mboard)
 {
-  return _snk->get_time_sources( mboard );
+  return _dev->get_time_sources( mboard );
 }
 
 void uhd_sink_c::set_clock_source(const std::string &source, const size_t mboard)
 {
-  _snk->set_clock_source( source,  mboard );
+  _dev->set_clock_source( source,  mboard );
 }
 
 std::string uhd_sink_c::get_clock_source(const size_t mboard)
 {
-  return _snk->get_clock_source( mboard );
+  return _dev->get_clock_source( mboard );
 }
 
 std::vector<std::string> uhd_sink_c::get_clock_sources(const size_t mboard)
 {
-  return _snk->get_clock_sources( mboard );
+  return _dev->get_clock_sources( mboard );
 }
 
 double uhd_sink_c::get_clock_rate(size_t mboard)
 {
-  return _snk->get_clock_rate( mboard );
+  return _dev->get_master_clock_rate( mboard );
 }
 
 void uhd_sink_c::set_clock_rate(double rate, size_t mboard)
 {
-  _snk->set_clock_rate( rate, mboard );
+  _dev->set_master_clock_rate( rate, mboard );
 }
 
 osmosdr::time_spec_t uhd_sink_c::get_time_now(size_t mboard)
 {
-  uhd::time_spec_t ts = _snk->get_time_now( mboard );
+  uhd::time_spec_t ts = _dev->get_time_now( mboard );
   return osmosdr::time_spec_t( ts.get_full_secs(), ts.get_frac_secs() );
 }
 
 osmosdr::time_spec_t uhd_sink_c::get_time_last_pps(size_t mboard)
 {
-  uhd::time_spec_t ts = _snk->get_time_last_pps( mboard );
+  uhd::time_spec_t ts = _dev->get_time_last_pps( mboard );
   return osmosdr::time_spec_t( ts.get_full_secs(), ts.get_frac_secs() );
 }
 
 void uhd_sink_c::set_time_now(const osmosdr::time_spec_t &time_spec, size_t mboard)
 {
-  _snk->set_time_now( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ), mboard );
+  _dev->set_time_now( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ), mboard );
 }
 
 void uhd_sink_c::set_time_next_pps(const osmosdr::time_spec_t &time_spec)
 {
-  _snk->set_time_next_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
+  _dev->set_time_next_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
 }
 
 void uhd_sink_c::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
 {
-  _snk->set_time_unknown_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
+  _dev->set_time_unknown_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
+}
+
+osmosdr::stream_stats_t uhd_sink_c::get_stream_stats( size_t chan )
+{
+  if ( _tx )
+    return _tx->get_stream_stats();
+
+  return osmosdr::stream_stats_t();
 }
@@ -24,6 +24,7 @@
 #include <gnuradio/uhd/usrp_sink.h>
 
 #include "sink_iface.h"
+#include "uhd_streamer.h"
 
 class uhd_sink_c;
 
@@ -93,11 +94,15 @@ public:
   void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
 
+  ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   double _center_freq;
   double _freq_corr;
   double _lo_offset;
-  gr::uhd::usrp_sink::sptr _snk;
+  ::uhd::usrp::multi_usrp::sptr _dev;
+  gr::uhd::usrp_sink::sptr _snk; /* NULL with streamer=native */
+  uhd_tx_streamer_sptr _tx;
 };
 
 #endif // UHD_SINK_C_H
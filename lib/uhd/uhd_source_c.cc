@@ -27,6 +27,8 @@
 #include "arg_helpers.h"
 
 #include "uhd_source_c.h"
+#include "backend_registry.h"
+#include "stream_stats.h"
 #include "osmosdr/source.h"
 
 using namespace boost::assign;
@@ -36,6 +38,12 @@ uhd_source_c_sptr make_uhd_source_c(const std::string &args)
   return gnuradio::get_initial_sptr(new uhd_source_c(args));
 }
 
+static source_registrar uhd_registrar(
+  "uhd",
+  &make_backend< source_iface, uhd_source_c_sptr, &make_uhd_source_c >,
+  &ignore_fake< &uhd_source_c::get_devices >,
+  BACKEND_HARDWARE | BACKEND_NETWORK | BACKEND_HW_CORRECTION, 40 );
+
 static size_t parse_nchan(const std::string &args)
 {
   size_t nchan = 1;
@@ -48,12 +56,22 @@ static size_t parse_nchan(const std::string &args)
   return nchan;
 }
 
+static size_t parse_item_size(const std::string &args)
+{
+  dict_t dict = params_to_dict(args);
+
+  if (dict.count("cpu_format"))
+    return cpu_format_item_size( dict["cpu_format"] );
+
+  return sizeof(gr_complex);
+}
+
 uhd_source_c::uhd_source_c(const std::string &args) :
     gr::hier_block2("uhd_source_c",
                    gr::io_signature::make(0, 0, 0),
                    gr::io_signature::make(parse_nchan(args),
                                           parse_nchan(args),
-                                          sizeof(gr_complex))),
+                                          parse_item_size(args))),
     _center_freq(0.0f),
     _freq_corr(0.0f),
     _lo_offset(0.0f)
@@ -71,6 +89,15 @@ uhd_source_c::uhd_source_c(const std::string &args) :
   if (dict.count("lo_offset"))
     _lo_offset = boost::lexical_cast< double >( dict["lo_offset"] );
 
+  /* streamer=native receives without the gr-uhd usrp_source in between */
+  std::string streamer = "gr-uhd";
+  if (dict.count("streamer"))
+    streamer = dict["streamer"];
+
+  if ( "gr-uhd" != streamer && "native" != streamer )
+    throw std::runtime_error("Unsupported streamer '" + streamer + "', "
+                             "use one of gr-uhd or native.");
+
   std::string arguments; // rebuild argument string without internal arguments
   BOOST_FOREACH( dict_t::value_type &entry, dict )
   {
@@ -81,6 +108,8 @@ uhd_source_c::uhd_source_c(const std::string &args) :
          "nchan" == entry.first ||
          "subdev" == entry.first ||
          "lo_offset" == entry.first ||
+         "streamer" == entry.first ||
+         "spp" == entry.first ||
          "uhd" == entry.first )
       continue;
 
@@ -105,18 +134,34 @@ uhd_source_c::uhd_source_c(const std::string &args) :
   if (dict.count("fullscale") )
     stream_args.args["fullscale"] = dict["fullscale"];
 
-  _src = gr::uhd::usrp_source::make( arguments, stream_args );
+  if (dict.count("spp") )
+    stream_args.args["spp"] = dict["spp"];
+
+  gr::basic_block_sptr block;
+
+  if ( "native" == streamer ) {
+    _dev = ::uhd::usrp::multi_usrp::make( arguments );
+    _rx = make_uhd_rx_streamer( _dev, stream_args );
+    block = _rx;
+
+    message_port_register_hier_out( STREAM_STATS_PORT );
+    msg_connect( _rx, STREAM_STATS_PORT, self(), STREAM_STATS_PORT );
+  } else {
+    _src = gr::uhd::usrp_source::make( arguments, stream_args );
+    _dev = _src->get_device();
+    block = _src;
+  }
 
   if (dict.count("subdev"))
-    _src->set_subdev_spec( dict["subdev"] );
+    _dev->set_rx_subdev_spec( dict["subdev"], 0 );
 
-  std::cerr << "-- Using subdev spec '" << _src->get_subdev_spec() << "'."
-            << std::endl;
+  std::cerr << "-- Using subdev spec '" << _dev->get_rx_subdev_spec( 0 ).to_string()
+            << "'." << std::endl;
 
   if (0.0 != _lo_offset)
     std::cerr << "-- Using LO offset of " << _lo_offset << " Hz." << std::endl;
 #if 0
-  std::vector<int> sizes = _src->output_signature()->sizeof_stream_items();
+  std::vector<int> sizes = block->output_signature()->sizeof_stream_items();
 
   while ( sizes.size() > nchan )
     sizes.erase( sizes.end() );
@@ -124,7 +169,7 @@ uhd_source_c::uhd_source_c(const std::string &args) :
   set_output_signature( gr::io_signature::makev( nchan, nchan, sizes ) );
 #endif
   for ( size_t i = 0; i < nchan; i++ )
-    connect( _src, i, self(), i );
+    connect( block, i, self(), i );
 }
 
 uhd_source_c::~uhd_source_c()
@@ -170,9 +215,9 @@ std::vector< std::string > uhd_source_c::get_devices()
 
 std::string uhd_source_c::name()
 {
-//  uhd::property_tree::sptr prop_tree = _src->get_device()->get_device()->get_tree();
+//  uhd::property_tree::sptr prop_tree = _dev->get_device()->get_tree();
 //  std::string dev_name = prop_tree->access<std::string>("/name").get();
-  std::string mboard_name = _src->get_device()->get_mboard_name();
+  std::string mboard_name = _dev->get_mboard_name();
 
 //  std::cerr << "'" << dev_name << "' '" << mboard_name << "'" << std::endl;
 //  'USRP1 Device' 'USRP1 (Classic)'
@@ -183,7 +228,7 @@ std::string uhd_source_c::name()
 
 size_t uhd_source_c::get_num_channels()
 {
-//  return _src->get_device()->get_rx_num_channels();
+//  return _dev->get_rx_num_channels();
   return output_signature()->max_streams();
 }
 
@@ -191,7 +236,7 @@ osmosdr::meta_range_t uhd_source_c::get_sample_rates( void )
 {
   osmosdr::meta_range_t rates;
 
-  BOOST_FOREACH( uhd::range_t rate, _src->get_samp_rates() )
+  BOOST_FOREACH( uhd::range_t rate, _dev->get_rx_rates() )
       rates += osmosdr::range_t( rate.start(), rate.stop(), rate.step() );
 
   return rates;
@@ -199,20 +244,26 @@ osmosdr::meta_range_t uhd_source_c::get_sample_rates( void )
 
 double uhd_source_c::set_sample_rate( double rate )
 {
-  _src->set_samp_rate( rate );
+  if ( _src ) {
+    _src->set_samp_rate( rate );
+  } else {
+    _dev->set_rx_rate( rate );
+    _rx->tag_next();
+  }
+
   return get_sample_rate();
 }
 
 double uhd_source_c::get_sample_rate( void )
 {
-  return _src->get_samp_rate();
+  return _dev->get_rx_rate();
 }
 
 osmosdr::freq_range_t uhd_source_c::get_freq_range( size_t chan )
 {
   osmosdr::freq_range_t range;
 
-  BOOST_FOREACH( uhd::range_t freq, _src->get_freq_range(chan) )
+  BOOST_FOREACH( uhd::range_t freq, _dev->get_rx_freq_range(chan) )
       range += osmosdr::range_t( freq.start(), freq.stop(), freq.step() );
 
   return range;
@@ -226,7 +277,12 @@ double uhd_source_c::set_center_freq( double freq, size_t chan )
 
   // advanced tuning with tune_request_t
   uhd::tune_request_t tune_req(corr_freq, _lo_offset);
-  _src->set_center_freq(tune_req, chan);
+  if ( _src ) {
+    _src->set_center_freq(tune_req, chan);
+  } else {
+    _dev->set_rx_freq(tune_req, chan);
+    _rx->tag_next();
+  }
 
   _center_freq = freq;
 
@@ -235,7 +291,7 @@ double uhd_source_c::set_center_freq( double freq, size_t chan )
 
 double uhd_source_c::get_center_freq( size_t chan )
 {
-  return _src->get_center_freq(chan);
+  return _dev->get_rx_freq(chan);
 }
 
 double uhd_source_c::set_freq_corr( double ppm, size_t chan )
@@ -254,14 +310,14 @@ double uhd_source_c::get_freq_corr( size_t chan )
 
 std::vector<std::string> uhd_source_c::get_gain_names( size_t chan )
 {
-  return _src->get_gain_names( chan );
+  return _dev->get_rx_gain_names( chan );
 }
 
 osmosdr::gain_range_t uhd_source_c::get_gain_range( size_t chan )
 {
   osmosdr::gain_range_t range;
 
-  BOOST_FOREACH( uhd::range_t gain, _src->get_gain_range(chan) )
+  BOOST_FOREACH( uhd::range_t gain, _dev->get_rx_gain_range(chan) )
       range += osmosdr::range_t( gain.start(), gain.stop(), gain.step() );
 
   return range;
@@ -271,7 +327,7 @@ osmosdr::gain_range_t uhd_source_c::get_gain_range( const std::string & name, si
 {
   osmosdr::gain_range_t range;
 
-  BOOST_FOREACH( uhd::range_t gain, _src->get_gain_range(name, chan) )
+  BOOST_FOREACH( uhd::range_t gain, _dev->get_rx_gain_range(name, chan) )
       range += osmosdr::range_t( gain.start(), gain.stop(), gain.step() );
 
   return range;
@@ -279,55 +335,55 @@ osmosdr::gain_range_t uhd_source_c::get_gain_range( const std::string & name, si
 
 double uhd_source_c::set_gain( double gain, size_t chan )
 {
-  _src->set_gain(gain, chan);
+  _dev->set_rx_gain(gain, chan);
 
   return get_gain(chan);
 }
 
 double uhd_source_c::set_gain( double gain, const std::string & name, size_t chan )
 {
-  _src->set_gain(gain, name, chan);
+  _dev->set_rx_gain(gain, name, chan);
 
   return get_gain(name, chan);
 }
 
 double uhd_source_c::get_gain( size_t chan )
 {
-  return _src->get_gain(chan);
+  return _dev->get_rx_gain(chan);
 }
 
 double uhd_source_c::get_gain( const std::string & name, size_t chan )
 {
-  return _src->get_gain(name, chan);
+  return _dev->get_rx_gain(name, chan);
 }
 
 std::vector< std::string > uhd_source_c::get_antennas( size_t chan )
 {
-  return _src->get_antennas(chan);
+  return _dev->get_rx_antennas(chan);
 }
 
 std::string uhd_source_c::set_antenna( const std::string & antenna, size_t chan )
 {
-  _src->set_antenna(antenna, chan);
+  _dev->set_rx_antenna(antenna, chan);
 
-  return _src->get_antenna(chan);
+  return _dev->get_rx_antenna(chan);
 }
 
 std::string uhd_source_c::get_antenna( size_t chan )
 {
-  return _src->get_antenna(chan);
+  return _dev->get_rx_antenna(chan);
 }
 
 void uhd_source_c::set_dc_offset_mode( int mode, size_t chan )
 {
   try {
     if ( osmosdr::source::DCOffsetOff == mode ) {
-      _src->set_auto_dc_offset( false, chan );
-      _src->set_dc_offset( std::complex<double>(0.0, 0.0), chan ); /* uhd default */
+      _dev->set_rx_dc_offset( false, chan );
+      _dev->set_rx_dc_offset( std::complex<double>(0.0, 0.0), chan ); /* uhd default */
     } else if ( osmosdr::source::DCOffsetManual == mode ) {
-      _src->set_auto_dc_offset( false, chan );
+      _dev->set_rx_dc_offset( false, chan );
     } else if ( osmosdr::source::DCOffsetAutomatic == mode ) {
-      _src->set_auto_dc_offset( true, chan );
+      _dev->set_rx_dc_offset( true, chan );
     }
   } catch ( const std::exception &ex ) {
     std::cerr << __FUNCTION__ << ": " << ex.what() << std::endl;
@@ -337,7 +393,7 @@ void uhd_source_c::set_dc_offset_mode( int mode, size_t chan )
 void uhd_source_c::set_dc_offset( const std::complex<double> &offset, size_t chan )
 {
   try {
-    _src->set_dc_offset( offset, chan );
+    _dev->set_rx_dc_offset( offset, chan );
   } catch ( const std::exception &ex ) {
     std::cerr << __FUNCTION__ << ": " << ex.what() << std::endl;
   }
@@ -347,7 +403,7 @@ void uhd_source_c::set_iq_balance_mode( int mode, size_t chan )
 {
   try {
     if ( osmosdr::source::IQBalanceOff == mode ) {
-      _src->set_iq_balance( std::complex<double>(0.0, 0.0), chan ); /* uhd default */
+      _dev->set_rx_iq_balance( std::complex<double>(0.0, 0.0), chan ); /* uhd default */
     } else if ( osmosdr::source::IQBalanceManual == mode ) {
       /* nothing to do */
     } else if ( osmosdr::source::IQBalanceAutomatic == mode ) {
@@ -361,7 +417,7 @@ void uhd_source_c::set_iq_balance_mode( int mode, size_t chan )
 void uhd_source_c::set_iq_balance( const std::complex<double> &balance, size_t chan )
 {
   try {
-    _src->set_iq_balance( balance, chan );
+    _dev->set_rx_iq_balance( balance, chan );
   } catch ( const std::exception &ex ) {
     std::cerr << __FUNCTION__ << ": " << ex.what() << std::endl;
   }
@@ -369,21 +425,21 @@ void uhd_source_c::set_iq_balance( const std::complex<double> &balance, size_t c
 
 double uhd_source_c::set_bandwidth( double bandwidth, size_t chan )
 {
-  _src->set_bandwidth(bandwidth, chan);
+  _dev->set_rx_bandwidth(bandwidth, chan);
 
-  return _src->get_bandwidth(chan);
+  return _dev->get_rx_bandwidth(chan);
 }
 
 double uhd_source_c::get_bandwidth( size_t chan )
 {
-  return _src->get_bandwidth(chan);
+  return _dev->get_rx_bandwidth(chan);
 }
 
 osmosdr::freq_range_t uhd_source_c::get_bandwidth_range( size_t chan )
 {
   osmosdr::freq_range_t bandwidths;
 
-  BOOST_FOREACH( uhd::range_t bw, _src->get_bandwidth_range(chan) )
+  BOOST_FOREACH( uhd::range_t bw, _dev->get_rx_bandwidth_range(chan) )
       bandwidths += osmosdr::range_t( bw.start(), bw.stop(), bw.step() );
 
   return bandwidths;
@@ -391,67 +447,75 @@ osmosdr::freq_range_t uhd_source_c::get_bandwidth_range( size_t chan )
 
 void uhd_source_c::set_time_source(const std::string &source, const size_t mboard)
 {
-  _src->set_time_source( source, mboard );
+  _dev->set_time_source( source, mboard );
 }
 
 std::string uhd_source_c::get_time_source(const size_t mboard)
 {
-  return _src->get_time_source( mboard );
+  return _dev->get_time_source( mboard );
 }
 
 std::vector<std::string> uhd_source_c::get_time_sources(const size_t mboard)
 {
-  return _src->get_time_sources( mboard );
+  return _dev->get_time_sources( mboard );
 }
 
 void uhd_source_c::set_clock_source(const std::string &source, const size_t mboard)
 {
-  _src->set_clock_source( source,  mboard );
+  _dev->set_clock_source( source,  mboard );
 }
 
 std::string uhd_source_c::get_clock_source(const size_t mboard)
 {
-  return _src->get_clock_source( mboard );
+  return _dev->get_clock_source( mboard );
 }
 
 std::vector<std::string> uhd_source_c::get_clock_sources(const size_t mboard)
 {
-  return _src->get_clock_sources( mboard );
+  return _dev->get_clock_sources( mboard );
 }
 
 double uhd_source_c::get_clock_rate(size_t mboard)
 {
-  return _src->get_clock_rate( mboard );
+  return _dev->get_master_clock_rate( mboard );
 }
 
 void uhd_source_c::set_clock_rate(double rate, size_t mboard)
 {
-  _src->set_clock_rate( rate, mboard );
+  _dev->set_master_clock_rate( rate, mboard );
 }
 
 osmosdr::time_spec_t uhd_source_c::get_time_now(size_t mboard)
 {
-  uhd::time_spec_t ts = _src->get_time_now( mboard );
+  uhd::time_spec_t ts = _dev->get_time_now( mboard );
   return osmosdr::time_spec_t( ts.get_full_secs(), ts.get_frac_secs() );
 }
 
 osmosdr::time_spec_t uhd_source_c::get_time_last_pps(size_t mboard)
 {
-  uhd::time_spec_t ts = _src->get_time_last_pps( mboard );
+  uhd::time_spec_t ts = _dev->get_time_last_pps( mboard );
   return osmosdr::time_spec_t( ts.get_full_secs(), ts.get_frac_secs() );
 }
 
 void uhd_source_c::set_time_now(const osmosdr::time_spec_t &time_spec, size_t mboard)
 {
-  _src->set_time_now( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ), mboard );
+  _dev->set_time_now( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ), mboard );
 }
 
 void uhd_source_c::set_time_next_pps(const osmosdr::time_spec_t &time_spec)
 {
-  _src->set_time_next_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
+  _dev->set_time_next_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
 }
 
 void uhd_source_c::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
 {
-  _src->set_time_unknown_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
+  _dev->set_time_unknown_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
+}
+
+osmosdr::stream_stats_t uhd_source_c::get_stream_stats( size_t chan )
+{
+  if ( _rx )
+    return _rx->get_stream_stats();
+
+  return osmosdr::stream_stats_t();
 }
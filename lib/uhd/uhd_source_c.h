@@ -24,6 +24,7 @@
 #include <gnuradio/uhd/usrp_source.h>
 
 #include "source_iface.h"
+#include "uhd_streamer.h"
 
 class uhd_source_c;
 
@@ -95,11 +96,15 @@ public:
   void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
 
+  ::osmosdr::stream_stats_t get_stream_stats( size_t chan = 0 );
+
 private:
   double _center_freq;
   double _freq_corr;
   double _lo_offset;
-  gr::uhd::usrp_source::sptr _src;
+  ::uhd::usrp::multi_usrp::sptr _dev;
+  gr::uhd::usrp_source::sptr _src; /* NULL with streamer=native */
+  uhd_rx_streamer_sptr _rx;
 };
 
 #endif // UHD_SOURCE_C_H
@@ -0,0 +1,315 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <boost/foreach.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "uhd_streamer.h"
+
+#include "arg_helpers.h"
+#include "stream_tags.h"
+
+#define RECV_TIMEOUT  0.1  /* seconds, returns to the scheduler in between */
+#define FLUSH_TIMEOUT 0.01
+#define SEND_TIMEOUT  1.0
+#define START_DELAY   0.05 /* seconds until a time aligned stream start */
+
+uhd_rx_streamer_sptr make_uhd_rx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                           const ::uhd::stream_args_t &stream_args )
+{
+  return gnuradio::get_initial_sptr(new uhd_rx_streamer( dev, stream_args ));
+}
+
+uhd_tx_streamer_sptr make_uhd_tx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                           const ::uhd::stream_args_t &stream_args )
+{
+  return gnuradio::get_initial_sptr(new uhd_tx_streamer( dev, stream_args ));
+}
+
+uhd_rx_streamer::uhd_rx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                  const ::uhd::stream_args_t &stream_args ) :
+  gr::sync_block( "uhd_rx_streamer",
+                  gr::io_signature::make( 0, 0, 0 ),
+                  gr::io_signature::make( stream_args.channels.size(),
+                                          stream_args.channels.size(),
+                                          cpu_format_item_size( stream_args.cpu_format ) ) ),
+  _dev(dev),
+  _stream_args(stream_args),
+  _tag_now(false),
+  _rate(0),
+  _overflow(false),
+  _have_next(false)
+{
+  message_port_register_out( STREAM_STATS_PORT );
+}
+
+void uhd_rx_streamer::issue_stream_cmd( const ::uhd::stream_cmd_t &cmd )
+{
+  BOOST_FOREACH( size_t chan, _stream_args.channels )
+    _dev->issue_stream_cmd( cmd, chan );
+}
+
+bool uhd_rx_streamer::start()
+{
+  _stream = _dev->get_rx_stream( _stream_args );
+
+  _rate = _dev->get_rx_rate( _stream_args.channels[0] );
+  _tag_now = true;
+  _overflow = false;
+  _have_next = false;
+
+  ::uhd::stream_cmd_t cmd( ::uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS );
+
+  /* the channels have to start at the same time to be aligned */
+  cmd.stream_now = ( _stream_args.channels.size() == 1 );
+  if ( ! cmd.stream_now )
+    cmd.time_spec = _dev->get_time_now() + ::uhd::time_spec_t( START_DELAY );
+
+  issue_stream_cmd( cmd );
+
+  return true;
+}
+
+bool uhd_rx_streamer::stop()
+{
+  if ( ! _stream )
+    return true;
+
+  issue_stream_cmd( ::uhd::stream_cmd_t( ::uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS ) );
+
+  flush();
+
+  _stream.reset();
+
+  return true;
+}
+
+/* Drop the samples still in flight, they would overflow the next start. */
+void uhd_rx_streamer::flush()
+{
+  const size_t nchan = _stream_args.channels.size();
+  const size_t len = _stream->get_max_num_samps();
+  const size_t item_size = cpu_format_item_size( _stream_args.cpu_format );
+
+  std::vector< std::vector< char > > bufs( nchan, std::vector< char >( len * item_size ) );
+  std::vector< void * > ptrs;
+
+  for ( size_t i = 0; i < nchan; i++ )
+    ptrs.push_back( &bufs[i][0] );
+
+  ::uhd::rx_metadata_t metadata;
+
+  do {
+    _stream->recv( ptrs, len, metadata, FLUSH_TIMEOUT );
+  } while ( ::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT != metadata.error_code );
+}
+
+int uhd_rx_streamer::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  size_t num;
+
+  while ( true ) {
+    num = _stream->recv( output_items, noutput_items, _metadata, RECV_TIMEOUT, true );
+
+    if ( ::uhd::rx_metadata_t::ERROR_CODE_NONE == _metadata.error_code )
+      break;
+
+    if ( ::uhd::rx_metadata_t::ERROR_CODE_TIMEOUT == _metadata.error_code )
+      return 0; /* e.g. waiting for a time aligned start */
+
+    if ( ::uhd::rx_metadata_t::ERROR_CODE_OVERFLOW == _metadata.error_code ) {
+      /* the gap is accounted for with the next samples received */
+      _overflow = true;
+      _tag_now = true;
+      continue;
+    }
+
+    std::cerr << "uhd_rx_streamer: " << _metadata.strerror() << std::endl;
+    return 0;
+  }
+
+  const bool tag = _tag_now.exchange( false );
+
+  if ( tag ) /* the rate may have been changed in the meantime */
+    _rate = _dev->get_rx_rate( _stream_args.channels[0] );
+
+  if ( _overflow ) {
+    long long gap = 0;
+
+    if ( _metadata.has_time_spec && _have_next )
+      gap = std::max( 0LL, (_metadata.time_spec - _next_time).to_ticks( _rate ) );
+
+    _stats.overflow( gap );
+    _overflow = false;
+  }
+
+  if ( _metadata.has_time_spec ) {
+    _next_time = _metadata.time_spec + ::uhd::time_spec_t( 0, long(num), _rate );
+    _have_next = true;
+  }
+
+  if ( tag ) {
+    osmosdr::time_spec_t time( _metadata.time_spec.get_full_secs(),
+                               _metadata.time_spec.get_frac_secs() );
+
+    for ( size_t i = 0; i < output_items.size(); i++ ) {
+      double freq = _dev->get_rx_freq( _stream_args.channels[i] );
+
+      /* rx_time only if the samples are timestamped, the others regardless */
+      BOOST_FOREACH( const gr::tag_t &t,
+                     make_rx_tags( nitems_written(0), time, _rate, freq, alias() ) )
+        if ( _metadata.has_time_spec || ! pmt::eq( t.key, RX_TIME_KEY ) )
+          add_item_tag( i, t );
+    }
+  }
+
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
+  return num;
+}
+
+uhd_tx_streamer::uhd_tx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                  const ::uhd::stream_args_t &stream_args ) :
+  gr::sync_block( "uhd_tx_streamer",
+                  gr::io_signature::make( stream_args.channels.size(),
+                                          stream_args.channels.size(),
+                                          cpu_format_item_size( stream_args.cpu_format ) ),
+                  gr::io_signature::make( 0, 0, 0 ) ),
+  _dev(dev),
+  _stream_args(stream_args),
+  _in_burst(false)
+{
+  message_port_register_out( STREAM_STATS_PORT );
+}
+
+bool uhd_tx_streamer::start()
+{
+  _stream = _dev->get_tx_stream( _stream_args );
+  _in_burst = false;
+
+  return true;
+}
+
+bool uhd_tx_streamer::stop()
+{
+  if ( ! _stream )
+    return true;
+
+  if ( _in_burst ) {
+    /* end the burst, the device would report an underflow otherwise */
+    ::uhd::tx_metadata_t metadata;
+    metadata.end_of_burst = true;
+
+    _stream->send( gr_vector_const_void_star( _stream_args.channels.size() ),
+                   0, metadata, SEND_TIMEOUT );
+    _in_burst = false;
+  }
+
+  _stream.reset();
+
+  return true;
+}
+
+/* Count the underflows and sequence errors the device reported. */
+void uhd_tx_streamer::poll_async_msgs()
+{
+  ::uhd::async_metadata_t metadata;
+
+  while ( _stream->recv_async_msg( metadata, 0.0 ) ) {
+    switch ( metadata.event_code ) {
+    case ::uhd::async_metadata_t::EVENT_CODE_UNDERFLOW:
+    case ::uhd::async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET:
+    case ::uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR:
+    case ::uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST:
+      _stats.overflow( 0 ); /* the number of samples lost is not reported */
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+int uhd_tx_streamer::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  int nitems = noutput_items;
+
+  _metadata.start_of_burst = ! _in_burst;
+  _metadata.end_of_burst = false;
+  _metadata.has_time_spec = false;
+
+  /* a burst starts with a send of its own and ends with end_of_burst */
+  std::vector< gr::tag_t > tags;
+  get_tags_in_range( tags, 0, nitems_read(0), nitems_read(0) + noutput_items );
+  std::sort( tags.begin(), tags.end(), gr::tag_t::offset_compare );
+
+  BOOST_FOREACH( const gr::tag_t &tag, tags ) {
+    const int rel = int( tag.offset - nitems_read(0) );
+    if ( rel >= nitems )
+      break;
+
+    if ( pmt::eq( tag.key, TX_TIME_KEY ) || pmt::eq( tag.key, TX_SOB_KEY ) ) {
+      if ( rel > 0 ) {
+        nitems = rel;
+        break;
+      }
+
+      if ( pmt::eq( tag.key, TX_TIME_KEY ) ) {
+        _metadata.has_time_spec = true;
+        _metadata.time_spec = ::uhd::time_spec_t(
+              time_t( pmt::to_uint64( pmt::tuple_ref( tag.value, 0 ) ) ),
+              pmt::to_double( pmt::tuple_ref( tag.value, 1 ) ) );
+      } else {
+        _metadata.start_of_burst = true;
+      }
+    } else if ( pmt::eq( tag.key, TX_EOB_KEY ) ) {
+      nitems = rel + 1;
+      _metadata.end_of_burst = true;
+      break;
+    }
+  }
+
+  poll_async_msgs();
+
+  size_t sent = _stream->send( input_items, nitems, _metadata, SEND_TIMEOUT );
+
+  /* a partial send leaves the tx_eob tag for the next call */
+  if ( sent )
+    _in_burst = ! ( _metadata.end_of_burst && sent == size_t(nitems) );
+
+  if ( _stats.publish_due() )
+    message_port_pub( STREAM_STATS_PORT, _stats.to_pmt() );
+
+  return sent;
+}
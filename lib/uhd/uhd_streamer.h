@@ -0,0 +1,134 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_UHD_STREAMER_H
+#define OSMOSDR_UHD_STREAMER_H
+
+#include <boost/atomic.hpp>
+
+#include <gnuradio/sync_block.h>
+
+#include <uhd/usrp/multi_usrp.hpp>
+
+#include "stream_stats.h"
+
+/*
+ * Blocks calling the UHD rx_streamer / tx_streamer directly, used with
+ * streamer=native instead of the gr-uhd usrp_source / usrp_sink. They stream
+ * in the cpu and otw formats of the stream args as they are, the transport
+ * is tuned by the recv_frame_size / num_recv_frames (send_frame_size /
+ * num_send_frames) device arguments, as with gr-uhd.
+ */
+
+class uhd_rx_streamer;
+class uhd_tx_streamer;
+
+typedef boost::shared_ptr< uhd_rx_streamer > uhd_rx_streamer_sptr;
+typedef boost::shared_ptr< uhd_tx_streamer > uhd_tx_streamer_sptr;
+
+uhd_rx_streamer_sptr make_uhd_rx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                           const ::uhd::stream_args_t &stream_args );
+
+uhd_tx_streamer_sptr make_uhd_tx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                           const ::uhd::stream_args_t &stream_args );
+
+/*!
+ * Receives from the channels of the stream args into one output port each,
+ * tagging rx_time, rx_rate and rx_freq like the gr-uhd usrp_source at stream
+ * start, after each overflow and after each call of tag_next(). rx_time is
+ * left out while the samples come without a time spec.
+ */
+class uhd_rx_streamer : public gr::sync_block
+{
+private:
+  friend uhd_rx_streamer_sptr make_uhd_rx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                                    const ::uhd::stream_args_t &stream_args );
+
+  uhd_rx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                   const ::uhd::stream_args_t &stream_args );
+
+public:
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  /*! Tag the next samples received, to be called after a retune. */
+  void tag_next() { _tag_now = true; }
+
+  osmosdr::stream_stats_t get_stream_stats() const { return _stats.get(); }
+
+private:
+  void issue_stream_cmd( const ::uhd::stream_cmd_t &cmd );
+  void flush();
+
+  ::uhd::usrp::multi_usrp::sptr _dev;
+  ::uhd::stream_args_t _stream_args;
+  ::uhd::rx_streamer::sptr _stream;
+  ::uhd::rx_metadata_t _metadata;
+
+  boost::atomic<bool> _tag_now;
+  double _rate;
+  bool _overflow;
+  bool _have_next;
+  ::uhd::time_spec_t _next_time; /* expected time of the next sample */
+
+  stream_stats _stats;
+};
+
+/*!
+ * Sends the samples of one input port per channel of the stream args,
+ * starting and ending bursts on the tx_sob, tx_eob and tx_time tags like
+ * the gr-uhd usrp_sink. Untagged samples are sent as one continuous burst.
+ */
+class uhd_tx_streamer : public gr::sync_block
+{
+private:
+  friend uhd_tx_streamer_sptr make_uhd_tx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                                                    const ::uhd::stream_args_t &stream_args );
+
+  uhd_tx_streamer( ::uhd::usrp::multi_usrp::sptr dev,
+                   const ::uhd::stream_args_t &stream_args );
+
+public:
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  osmosdr::stream_stats_t get_stream_stats() const { return _stats.get(); }
+
+private:
+  void poll_async_msgs();
+
+  ::uhd::usrp::multi_usrp::sptr _dev;
+  ::uhd::stream_args_t _stream_args;
+  ::uhd::tx_streamer::sptr _stream;
+  ::uhd::tx_metadata_t _metadata;
+
+  bool _in_burst;
+
+  stream_stats _stats;
+};
+
+#endif // OSMOSDR_UHD_STREAMER_H
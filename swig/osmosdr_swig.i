@@ -1,5 +1,9 @@
 /* -*- c++ -*- */
 
+// only the calls marked with %thread below release the GIL
+%module(threads="1") osmosdr_swig
+%nothread;
+
 #define OSMOSDR_API
 
 // suppress Warning 319: No access specifier given for base class 'boost::noncopyable' (ignored).
@@ -12,8 +16,10 @@
 
 %{
 #include "osmosdr/device.h"
+#include "osmosdr/channel_state.h"
 #include "osmosdr/source.h"
 #include "osmosdr/sink.h"
+#include "osmosdr/sweeper.h"
 %}
 
 // Workaround for a SWIG 2.0.4 bug with templates. Probably needs to be looked in to.
@@ -33,6 +39,11 @@
 
 %ignore osmosdr::device_t::operator[]; //ignore warnings about %extend
 
+// enumerating devices and anything reaching the hardware (usb transfers,
+// network transactions, UHD discovery) may take seconds, let other Python
+// threads run meanwhile
+%thread osmosdr::device::find;
+
 %template(string_string_dict_t) std::map<std::string, std::string>; //define before device
 %template(devices_t) std::vector<osmosdr::device_t>;
 %include <osmosdr/device.h>
@@ -47,6 +58,12 @@
 
 %include <osmosdr/time_spec.h>
 
+%template(uint64_vector_t) std::vector<uint64_t>; //define before stream_stats
+%include <osmosdr/stream_stats.h>
+
+%template(string_double_dict_t) std::map<std::string, double>; //define before channel_state
+%include <osmosdr/channel_state.h>
+
 %extend osmosdr::time_spec_t{
     osmosdr::time_spec_t __add__(const osmosdr::time_spec_t &what)
     {
@@ -62,6 +79,21 @@
     }
 };
 
+%extend osmosdr::tick_spec_t{
+    osmosdr::tick_spec_t __add__(long long ticks)
+    {
+        osmosdr::tick_spec_t temp = *self;
+        temp += ticks;
+        return temp;
+    }
+    osmosdr::tick_spec_t __sub__(long long ticks)
+    {
+        osmosdr::tick_spec_t temp = *self;
+        temp -= ticks;
+        return temp;
+    }
+};
+
 %define OSMOSDR_SWIG_BLOCK_MAGIC2(PKG, BASE_NAME)
 %template(BASE_NAME ## _sptr) boost::shared_ptr<PKG ## :: ## BASE_NAME>;
 %pythoncode %{
@@ -70,12 +102,72 @@ BASE_NAME = BASE_NAME.make;
 %}
 %enddef
 
+%define OSMOSDR_SWIG_THREAD_ALLOW(CLASS)
+%thread osmosdr::CLASS::make;
+%thread osmosdr::CLASS::get_num_channels;
+%thread osmosdr::CLASS::get_sample_rates;
+%thread osmosdr::CLASS::set_sample_rate;
+%thread osmosdr::CLASS::get_sample_rate;
+%thread osmosdr::CLASS::get_freq_range;
+%thread osmosdr::CLASS::set_center_freq;
+%thread osmosdr::CLASS::get_center_freq;
+%thread osmosdr::CLASS::set_hop_plan;
+%thread osmosdr::CLASS::set_freq_corr;
+%thread osmosdr::CLASS::get_freq_corr;
+%thread osmosdr::CLASS::get_gain_names;
+%thread osmosdr::CLASS::get_gain_range;
+%thread osmosdr::CLASS::set_gain_mode;
+%thread osmosdr::CLASS::get_gain_mode;
+%thread osmosdr::CLASS::set_gain;
+%thread osmosdr::CLASS::get_gain;
+%thread osmosdr::CLASS::set_if_gain;
+%thread osmosdr::CLASS::set_bb_gain;
+%thread osmosdr::CLASS::get_antennas;
+%thread osmosdr::CLASS::set_antenna;
+%thread osmosdr::CLASS::get_antenna;
+%thread osmosdr::CLASS::set_dc_offset;
+%thread osmosdr::CLASS::set_iq_balance;
+%thread osmosdr::CLASS::set_bandwidth;
+%thread osmosdr::CLASS::get_bandwidth;
+%thread osmosdr::CLASS::get_bandwidth_range;
+%thread osmosdr::CLASS::set_time_source;
+%thread osmosdr::CLASS::get_time_source;
+%thread osmosdr::CLASS::get_time_sources;
+%thread osmosdr::CLASS::set_clock_source;
+%thread osmosdr::CLASS::get_clock_source;
+%thread osmosdr::CLASS::get_clock_sources;
+%thread osmosdr::CLASS::get_clock_rate;
+%thread osmosdr::CLASS::set_clock_rate;
+%thread osmosdr::CLASS::get_time_now;
+%thread osmosdr::CLASS::get_time_last_pps;
+%thread osmosdr::CLASS::set_time_now;
+%thread osmosdr::CLASS::set_time_next_pps;
+%thread osmosdr::CLASS::set_time_unknown_pps;
+%thread osmosdr::CLASS::get_stream_stats;
+%thread osmosdr::CLASS::get_channel_state;
+%enddef
+
+OSMOSDR_SWIG_THREAD_ALLOW(source)
+OSMOSDR_SWIG_THREAD_ALLOW(sink)
+%thread osmosdr::source::seek;
+%thread osmosdr::source::set_center_freq_async;
+%thread osmosdr::source::set_dc_offset_mode;
+%thread osmosdr::source::set_iq_balance_mode;
+%thread osmosdr::source::set_biast;
+%thread osmosdr::source::set_notch_AMFM_filter;
+%thread osmosdr::source::set_params;
+%thread osmosdr::source::set_streaming;
+%thread osmosdr::sweeper::make;
+
 %include "osmosdr/source.h"
 %include "osmosdr/sink.h"
 
 OSMOSDR_SWIG_BLOCK_MAGIC2(osmosdr,source);
 OSMOSDR_SWIG_BLOCK_MAGIC2(osmosdr,sink);
 
+%include "osmosdr/sweeper.h"
+OSMOSDR_SWIG_BLOCK_MAGIC2(osmosdr,sweeper);
+
 %{
 static const size_t ALL_MBOARDS = osmosdr::ALL_MBOARDS;
 %}